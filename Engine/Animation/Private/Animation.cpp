@@ -3,13 +3,24 @@
 #include "Skeleton.hpp"
 #include "Clip.hpp"
 
+#include "Core/Core.hpp"
 #include "Core/Exception.hpp"
 #include "Core/Logging/Log.hpp"
 #include "Core/Utility/Time.hpp"
 
+#include <algorithm>
+
 namespace Recluse {
 
-const size_t                        Animation::kMaxAnimationThreadCount   = 2;
+const U32                           Animation::kJobBatchSize              = 8;
+
+// Full rate up close, down to every eighth frame for instances a few pixels tall.
+static const AnimLodPolicy kDefaultLodPolicies[] = {
+  { 0.25f,  1, 0, false },
+  { 0.1f,   2, 0, false },
+  { 0.04f,  4, 1, true  },
+  { 0.0f,   8, 2, true  }
+};
 
 Animation& gAnimation()
 {
@@ -17,6 +28,14 @@ Animation& gAnimation()
 }
 
 
+Animation::Animation()
+  : m_lodCount(0)
+{
+  m_frameStats = { };
+  setLodPolicies(kDefaultLodPolicies, sizeof(kDefaultLodPolicies) / sizeof(AnimLodPolicy));
+}
+
+
 void Animation::onStartUp()
 {
 }
@@ -32,19 +51,41 @@ void Animation::onShutDown()
 
 void Animation::updateState(R64 dt)
 {
-  R32 globalTime = static_cast<R32>(Time::currentTime());
-  size_t H = (m_sampleJobs.size() >> 1);
-  
-  // animate jobs.
-  for (auto& job : m_sampleJobs) {
-    doSampleJob(job, static_cast<R32>(dt));
-  }
+  R32 gt = static_cast<R32>(dt);
+  ThreadPool& pool = gCore().ThrPool();
+
+  // Blend jobs sample their own clips, so both kinds run side by side.
+  U32 sampleCount = static_cast<U32>(m_sampleJobs.size());
+  U32 jobCount = sampleCount + static_cast<U32>(m_blendJobs.size());
+  AnimFrameStats frameStats = { };
+  JobCounter counter;
+  pool.ParallelFor(jobCount, kJobBatchSize, [&] (U32 start, U32 end) -> void {
+    AnimFrameStats stats = { };
+    for (U32 i = start; i < end; ++i) {
+      doJob((i < sampleCount) ? m_sampleJobs[i] : m_blendJobs[i - sampleCount], gt, &stats);
+    }
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    frameStats._sampled += stats._sampled;
+    frameStats._interpolated += stats._interpolated;
+    frameStats._culled += stats._culled;
+  }, &counter);
+  pool.WaitForCounter(&counter);
+  m_frameStats = frameStats;
+
+  // Jobs reference frame memory, and must not outlive the frame.
+  m_sampleJobs.clear();
+  m_blendJobs.clear();
+}
 
-  for (auto& job : m_blendJobs) {
-    doBlendJob(job, static_cast<R32>(dt));
-  }
 
-  m_sampleJobs.clear();
+void Animation::swapBuffers()
+{
+  for (auto& it : m_animObjects) {
+    AnimHandle* pHandle = it.second;
+    if (!pHandle->_backReady) continue;
+    pHandle->_front ^= 1;
+    pHandle->_backReady = false;
+  }
 }
 
 
@@ -72,191 +113,389 @@ void Animation::freeAnimHandle(AnimHandle* pObj)
 }
 
 
+// Game code may point a clip at another skeleton, rebind its tracks before sampling.
+static void BindClip(AnimClip* pClip)
+{
+  if (pClip && pClip->_boundSkeletonId != pClip->_skeletonId) {
+    pClip->bindSkeleton(Skeleton::getSkeleton(pClip->_skeletonId));
+  }
+}
+
+
+void Animation::setLodPolicies(const AnimLodPolicy* pPolicies, U32 count)
+{
+  R_ASSERT(count > 0 && count <= kMaxLodCount, "Animation takes between 1 and kMaxLodCount levels of detail.\n");
+  m_lodCount = (count < kMaxLodCount) ? count : kMaxLodCount;
+  for (U32 i = 0; i < m_lodCount; ++i) {
+    m_lodPolicies[i] = pPolicies[i];
+    m_lodPolicies[i]._updateInterval = std::max(m_lodPolicies[i]._updateInterval, 1u);
+  }
+  if (m_lodCount == 0) {
+    m_lodPolicies[0] = kDefaultLodPolicies[0];
+    m_lodCount = 1;
+  }
+}
+
+
 void Animation::submitJob(const AnimJobSubmitInfo& info)
 {
   switch (info._type) {
     case ANIM_JOB_TYPE_SAMPLE:
     {
+      std::lock_guard<std::mutex> lock(m_sampleJobMutex);
+      BindClip(info._pBaseClip);
       m_sampleJobs.push_back(info);
     } break;
     case ANIM_JOB_TYPE_BLEND:
-    {
-      
-    } break;
     case ANIM_JOB_TYPE_LAYERED_BLEND:
     {
-      
+      // Clips are shared between instances, so binding is kept under the same lock as samples.
+      std::lock_guard<std::mutex> sampleLock(m_sampleJobMutex);
+      std::lock_guard<std::mutex> lock(m_blendJobMutex);
+      BindClip(info._pBaseClip);
+      for (const AnimBlendLayer& layer : info._layers) BindClip(layer._pClip);
+      for (const AnimBlendLayer& layer : info._additiveLayers) BindClip(layer._pClip);
+      m_blendJobs.push_back(info);
     } break;
     default: break;  
   }
 }
 
 
-Matrix4 Animation::linearInterpolate(JointPose* currPose, JointPose* nextPose, R32 currTime, R32 nextTime, R32 t)
+void AnimPose::reset(U32 count)
 {
-  Matrix4 resultTransform = Matrix4::identity();
-  
-  R32 dt = (t - currTime) /  (nextTime - currTime);
-  if (isinf(dt)) return resultTransform;
+  _jointCount = count;
+  for (U32 i = 0; i <= count; ++i) {
+    _rotations[i] = Quaternion();
+    _translations[i] = Vector3();
+    _scales[i] = Vector3(1.0f, 1.0f, 1.0f);
+  }
+}
 
-  Vector3 translate = Vector3::lerp(currPose->_trans, nextPose->_trans, dt);
-  Vector3 scale = Vector3::lerp(currPose->_scale, nextPose->_scale, dt);
-  Quaternion rot = Quaternion::slerp(currPose->_rot, nextPose->_rot, dt);
 
-  Matrix4 mT = Matrix4::translate(Matrix4(), translate);
-  Matrix4 mS = Matrix4::scale(Matrix4(), scale);
-  Matrix4 mR = rot.toMatrix4();
-  resultTransform = mS * mR * mT;
+// Local transform of a posed slot.
+static Matrix4 PoseToMatrix(const AnimPose& pose, U32 slot)
+{
+  Matrix4 mT = Matrix4::translate(Matrix4(), pose._translations[slot]);
+  Matrix4 mS = Matrix4::scale(Matrix4(), pose._scales[slot]);
+  Matrix4 mR = pose._rotations[slot].toMatrix4();
+  return mS * mR * mT;
+}
+
 
-  return resultTransform;
+// Joints a clip poses. Skeletons pose all of their joints, while clips without one only pose 
+// up to the last node they animate. Clips without tracks pose nothing.
+static U32 PoseJointCount(const AnimClip* pClip, const Skeleton* pSkeleton, U32 paletteSz)
+{
+  if (!pClip || pClip->_tracks.empty()) return 0;
+  if (pSkeleton) return std::min(static_cast<U32>(pSkeleton->_joints.size()), paletteSz);
+  U32 count = 0;
+  for (const AnimTrack& track : pClip->_tracks) {
+    if (track._joint < paletteSz) count = std::max(count, track._joint + 1);
+  }
+  return count;
 }
 
 
-void Animation::getCurrentAndNextPoseIdx(U32* outCurr, U32* outNext, AnimClip* pClip, R32 lt)
+// Advance a clip's clock by gt, wrapping around its duration. Returns the new local time.
+static R32 AdvanceClock(AnimClipState* pState, const AnimClip* pClip, R32 gt)
 {
-  for (size_t i = 0; i < pClip->_aAnimPoseSamples.size(); ++i) {
-    AnimPose& pose = pClip->_aAnimPoseSamples[i];
-    if (pose._time > lt) {
-      *outCurr = static_cast<U32>(i) - 1u;
-      *outNext = static_cast<U32>(i);
-      *outCurr = *outCurr > pClip->_aAnimPoseSamples.size() ?
-        static_cast<U32>(pClip->_aAnimPoseSamples.size()) - 1u : *outCurr;
-      break;
+  R32 lt = pState->_fCurrLocalTime + gt * pState->_fPlaybackRate;
+  if (lt > pClip->_fDuration) {
+    lt -= pClip->_fDuration;
+    pState->_tau = gt;
+  }
+  if (lt < 0.0f) {
+    lt = pClip->_fDuration + lt;
+    if (lt < 0.0f) {
+      lt += pClip->_fDuration;
+      pState->_tau = gt;
     }
   }
+  pState->_fCurrLocalTime = lt;
+  return lt;
 }
 
 
-B32 Animation::emptyPoseSamples(AnimClip* pClip, I32 currPoseIdx, I32 nextPoseIdx)
+// Weight of a layer on each slot of a pose. The root follows the first joint.
+static void LayerWeights(const AnimBlendLayer& layer, U32 jointCount, R32* pWeights)
 {
-  if (pClip->_aAnimPoseSamples[currPoseIdx]._aLocalPoses.empty()
-    || pClip->_aAnimPoseSamples[nextPoseIdx]._aLocalPoses.empty()) {
-    return true;
+  pWeights[AnimPose::kRootSlot] = layer._weight * layer._jointWeights[0];
+  for (U32 i = 0; i < jointCount; ++i) {
+    pWeights[i + 1] = layer._weight * layer._jointWeights[i];
   }
-  return false;
 }
 
 
-void Animation::applyMorphTargets(AnimHandle* pOutput, AnimClip* pClip, I32 currPoseIdx, I32 nextPoseIdx, R32 lt)
+// Pull a pose toward a layer, by a weight per slot within [0, 1].
+static void BlendPose(AnimPose* pPose, const AnimPose& layer, const R32* pWeights)
 {
-  if (!pClip->_aAnimPoseSamples[currPoseIdx]._morphs.empty() &&
-    !pClip->_aAnimPoseSamples[nextPoseIdx]._morphs.empty()) {
-    auto& currMorphs = pClip->_aAnimPoseSamples[currPoseIdx]._morphs;
-    auto& nextMorphs = pClip->_aAnimPoseSamples[nextPoseIdx]._morphs;
-    pOutput->_finalMorphs.resize(currMorphs.size());
-    for (size_t i = 0; i < currMorphs.size(); ++i) {
-      pOutput->_finalMorphs[i] = Lerpf(currMorphs[i], nextMorphs[i], lt);
-    }
+  U32 count = pPose->_jointCount + 1;
+  Quaternion::nlerpBatch(pPose->_rotations, pPose->_rotations, layer._rotations, pWeights, count);
+  for (U32 i = 0; i < count; ++i) {
+    pPose->_translations[i] = Vector3::lerp(pPose->_translations[i], layer._translations[i], pWeights[i]);
+    pPose->_scales[i] = Vector3::lerp(pPose->_scales[i], layer._scales[i], pWeights[i]);
   }
 }
 
 
-void Animation::doSampleJob(AnimJobSubmitInfo& job, R32 gt)
+// Apply the differences held by an additive layer, by a weight per slot.
+static void AddPose(AnimPose* pPose, const AnimPose& layer, const R32* pWeights)
 {
-  if (!job._output->_currState._bEnabled) { return; }
-  R32 tau = job._output->_currState._tau;
-  R32 rate = job._output->_currState._fPlaybackRate;
-  R32 lt = job._output->_currState._fCurrLocalTime + gt * rate;
-  if (lt > job._pBaseClip->_fDuration) {
-    lt -= job._pBaseClip->_fDuration;
-    job._output->_currState._tau = gt;
+  U32 count = pPose->_jointCount + 1;
+  Quaternion rotations[AnimPose::kSlotCount];
+  Quaternion::nlerpBatch(rotations, rotations, layer._rotations, pWeights, count);
+  for (U32 i = 0; i < count; ++i) {
+    pPose->_rotations[i] = pPose->_rotations[i] * rotations[i];
+    pPose->_translations[i] += layer._translations[i] * pWeights[i];
+    pPose->_scales[i] *= Vector3::lerp(Vector3(1.0f, 1.0f, 1.0f), layer._scales[i], pWeights[i]);
   }
-  if (lt < 0.0f) {
-    lt = job._pBaseClip->_fDuration + lt;
-    if (lt < 0.0f) {
-      lt += job._pBaseClip->_fDuration;
-      job._output->_currState._tau = gt;
-    }
+}
+
+
+// Clip whose skeleton a job poses, the base clip, or else the first layer.
+static AnimClip* JobClip(const AnimJobSubmitInfo& job)
+{
+  if (job._pBaseClip) return job._pBaseClip;
+  for (const AnimBlendLayer& layer : job._layers) {
+    if (layer._pClip) return layer._pClip;
   }
-  job._output->_currState._fCurrLocalTime = lt;
-  Skeleton* pSkeleton = Skeleton::getSkeleton(job._pBaseClip->_skeletonId);
-  Matrix4* palette = job._output->_finalPalette;
-  U32 paletteSz = job._output->_paletteSz;
+  return nullptr;
+}
+
 
-  U32 currPoseIdx = 0;
-  U32 nextPoseIdx = 0;
+// Move every clock of a job on, without sampling.
+static void AdvanceJob(AnimJobSubmitInfo& job, R32 gt)
+{
+  AnimClipState* pState = &job._output->_currState;
+  if (job._pBaseClip && pState->_bEnabled) AdvanceClock(pState, job._pBaseClip, gt);
+  for (AnimBlendLayer& layer : job._layers) {
+    if (layer._pClip && layer._pState && layer._pState->_bEnabled) AdvanceClock(layer._pState, layer._pClip, gt);
+  }
+  for (AnimBlendLayer& layer : job._additiveLayers) {
+    if (layer._pClip && layer._pState && layer._pState->_bEnabled) AdvanceClock(layer._pState, layer._pClip, gt);
+  }
+}
 
-  getCurrentAndNextPoseIdx(&currPoseIdx, &nextPoseIdx, job._pBaseClip, lt);
 
-  applyMorphTargets(job._output, job._pBaseClip, currPoseIdx, nextPoseIdx, lt);
+// Mark the joints within levels of the tips of a skeleton. Parents come before their children, 
+// so heights are found in one pass from the back. Roots are always kept.
+static B32 DropJoints(const Skeleton* pSkeleton, U32 jointCount, U32 levels, B8* pDropped)
+{
+  if (!pSkeleton || levels == 0) return false;
+  U32 heights[AnimPose::kMaxJoints];
+  for (U32 i = 0; i < jointCount; ++i) heights[i] = 0;
+  for (U32 i = jointCount; i-- > 0; ) {
+    U8 parent = pSkeleton->_joints[i]._iParent;
+    if (parent != Joint::kNoParentId && parent < i) {
+      heights[parent] = std::max(heights[parent], heights[i] + 1);
+    }
+  }
+  for (U32 i = 0; i < jointCount; ++i) {
+    U8 parent = pSkeleton->_joints[i]._iParent;
+    pDropped[i] = (parent != Joint::kNoParentId && parent < i && heights[i] < levels);
+  }
+  return true;
+}
 
-  if (emptyPoseSamples(job._pBaseClip, currPoseIdx, nextPoseIdx)) return;
 
-  if (pSkeleton) {
-    doSkeletalAnimation(job, pSkeleton, lt,currPoseIdx, nextPoseIdx);
-  } else {
-    doMechanicalAnimation(job, lt, currPoseIdx, nextPoseIdx);
+// Pose between two others, a at 0 and b at 1.
+static void LerpPose(AnimPose* pOut, const AnimPose& a, const AnimPose& b, R32 t)
+{
+  *pOut = a;
+  if (a._jointCount != b._jointCount) {
+    *pOut = b;
+    return;
   }
+  R32 weights[AnimPose::kSlotCount];
+  for (U32 i = 0; i <= a._jointCount; ++i) weights[i] = t;
+  BlendPose(pOut, b, weights);
 }
 
 
-void Animation::doMechanicalAnimation(AnimJobSubmitInfo& job,
-                                      R32 lt,
-                                      U32 currPoseIdx,
-                                      U32 nextPoseIdx)
+// Morph weights between two sets, a at 0 and b at 1.
+static void LerpMorphs(std::vector<R32>& out, const std::vector<R32>& a, const std::vector<R32>& b, R32 t)
 {
-  AnimPose* currAnimPose = &job._pBaseClip->_aAnimPoseSamples[currPoseIdx];
-  AnimPose* nextAnimPose = &job._pBaseClip->_aAnimPoseSamples[nextPoseIdx];
-  for (size_t i = 0; i < job._pBaseClip->_aAnimPoseSamples[currPoseIdx]._aLocalPoses.size() &&
-                      i < job._pBaseClip->_aAnimPoseSamples[nextPoseIdx]._aLocalPoses.size(); ++i) {
-    JointPose* currJoint = &currAnimPose->_aLocalPoses[i];
-    JointPose* nextJoint = &nextAnimPose->_aLocalPoses[i];
-    Matrix4 localTransform = linearInterpolate(currJoint, nextJoint, currAnimPose->_time, nextAnimPose->_time, lt);
-    Matrix4 parentTransform = job._output->_finalPalette[currJoint->_id];
-    job._output->_finalPalette[currJoint->_id] = localTransform;
+  if (a.size() != b.size()) {
+    out = b;
+    return;
   }
+  out.resize(a.size());
+  for (size_t i = 0; i < a.size(); ++i) out[i] = Lerpf(a[i], b[i], t);
+}
+
+
+// Sample the morph weights of a clip, at the time its pose was last sampled.
+static U32 SampleMorphs(FrameVector<R32>& morphs, AnimClip* pClip, AnimClipState* pState)
+{
+  morphs.resize(pClip->_morphTargetCount);
+  if (morphs.empty()) return 0;
+  pClip->sampleMorphs(morphs.data(), pState->_fCurrLocalTime, &pState->_cursor);
+  return pClip->_morphTargetCount;
 }
 
 
-void Animation::doSkeletalAnimation(AnimJobSubmitInfo& job, 
-                                    Skeleton* pSkeleton, 
-                                    R32 lt,
-                                    U32 currPoseIdx, 
-                                    U32 nextPoseIdx)
+B32 Animation::samplePose(AnimPose* pOut, AnimClip* pClip, AnimClipState* pState, Skeleton* pSkeleton,
+                          U32 jointCount, const B8* pDropped, R32 gt)
 {
-  Matrix4 globalTransform;
-  B32 rootInJoints = pSkeleton ? pSkeleton->_rootInJoints : false;
-  {
-    Matrix4 localTransform = linearInterpolate(
-      &job._pBaseClip->_aAnimPoseSamples[currPoseIdx]._aLocalPoses[0],
-      &job._pBaseClip->_aAnimPoseSamples[nextPoseIdx]._aLocalPoses[0],
-      job._pBaseClip->_aAnimPoseSamples[currPoseIdx]._time,
-      job._pBaseClip->_aAnimPoseSamples[nextPoseIdx]._time,
-      lt);
-    if (rootInJoints) {
-      job._output->_finalPalette[0] = localTransform;
+  if (!pState->_bEnabled) return false;
+  R32 lt = AdvanceClock(pState, pClip, gt);
+
+  // Keys are found from where the last sample of this instance left off.
+  pClip->attachCursor(&pState->_cursor);
+  pOut->reset(jointCount);
+
+  // Joints without a track stay at rest. Tracks were bound to their joints when the clip was 
+  // submitted.
+  U32 trackCount = static_cast<U32>(pClip->_tracks.size());
+  U32 firstTrack = 0;
+  if (pSkeleton && trackCount > 0) {
+    // The first track drives the root.
+    JointPose root = pClip->sampleTrack(0, lt, &pState->_cursor);
+    pOut->_rotations[AnimPose::kRootSlot] = root._rot;
+    pOut->_translations[AnimPose::kRootSlot] = root._trans;
+    pOut->_scales[AnimPose::kRootSlot] = root._scale;
+    if (pSkeleton->_rootInJoints && jointCount > 0) {
+      pOut->_rotations[1] = root._rot;
+      pOut->_translations[1] = root._trans;
+      pOut->_scales[1] = root._scale;
     }
-    globalTransform = localTransform;
-  }
-
-  AnimPose* currAnimPose = &job._pBaseClip->_aAnimPoseSamples[currPoseIdx];
-  AnimPose* nextAnimPose = &job._pBaseClip->_aAnimPoseSamples[nextPoseIdx];
-  // TODO(): Need to figure out how to map nodes to certain indices, as gltf does not 
-  // sort animation samples by joint hierarchy.
-  for (size_t i = 1; i < job._pBaseClip->_aAnimPoseSamples[currPoseIdx]._aLocalPoses.size(); ++i) {
-    size_t idx = (rootInJoints ? i : i - 1);
-    JointPose* currJoint = &currAnimPose->_aLocalPoses[i];
-    JointPose* nextJoint = &nextAnimPose->_aLocalPoses[i];
-    Matrix4 localTransform = linearInterpolate(currJoint, nextJoint, currAnimPose->_time, nextAnimPose->_time, lt);
-
-    // For now, we are checking marked node ids of the gltf hierarchy.
-    for (size_t j = 0; j < pSkeleton->_joints.size(); ++j) {
-      if (pSkeleton->_joints[j]._id == currJoint->_id) {
-        job._output->_finalPalette[j] = localTransform;
-        break;
-      }
+    firstTrack = 1;
+  }
+
+  for (U32 i = firstTrack; i < trackCount; ++i) {
+    U32 joint = pClip->_tracks[i]._joint;
+    if (joint >= jointCount || (pDropped && pDropped[joint])) continue;
+    JointPose pose = pClip->sampleTrack(i, lt, &pState->_cursor);
+    pOut->_rotations[joint + 1] = pose._rot;
+    pOut->_translations[joint + 1] = pose._trans;
+    pOut->_scales[joint + 1] = pose._scale;
+  }
+  return true;
+}
+
+
+void Animation::writePalette(AnimHandle* pOutput, const AnimPose& pose, Skeleton* pSkeleton, const B8* pDropped)
+{
+  if (pose._jointCount == 0) return;
+  Matrix4* pPalette = pOutput->getBackPalette();
+  for (U32 i = 0; i < pose._jointCount; ++i) {
+    pPalette[i] = PoseToMatrix(pose, i + 1);
+  }
+  if (pSkeleton) {
+    applySkeletonPose(pPalette, PoseToMatrix(pose, AnimPose::kRootSlot), pSkeleton, pDropped);
+  }
+}
+
+
+void Animation::doJob(AnimJobSubmitInfo& job, R32 gt, AnimFrameStats* pStats)
+{
+  AnimHandle* pOutput = job._output;
+  AnimClip* pClip = JobClip(job);
+  if (!pClip) return;
+
+  // Out of sight, the pose shown stays as it was, and only time moves on.
+  if (!pOutput->_visible) {
+    AdvanceJob(job, gt);
+    pOutput->_lodPoses.clear();
+    pStats->_culled += 1;
+    return;
+  }
+
+  U32 level = m_lodCount - 1;
+  for (U32 i = 0; i < m_lodCount; ++i) {
+    if (pOutput->_screenSize >= m_lodPolicies[i]._minScreenSize) {
+      level = i;
+      break;
     }
   }
+  const AnimLodPolicy& lod = m_lodPolicies[level];
+  B32 levelChanged = (level != pOutput->_lod);
+  pOutput->_lod = level;
 
-  applySkeletonPose(job._output->_finalPalette, globalTransform, pSkeleton);
+  Skeleton* pSkeleton = Skeleton::getSkeleton(pClip->_skeletonId);
+  B8 dropped[AnimPose::kMaxJoints];
+  const B8* pDropped = nullptr;
+  if (pSkeleton) {
+    U32 jointCount = std::min(static_cast<U32>(pSkeleton->_joints.size()), pOutput->_paletteSz);
+    if (DropJoints(pSkeleton, jointCount, lod._droppedJointLevels, dropped)) pDropped = dropped;
+  }
+
+  // Between samples, the last two are interpolated, along with their morph weights.
+  B32 throttled = (lod._updateInterval > 1);
+  if (throttled && !levelChanged && pOutput->_lodPoses.size() == 2 
+    && pOutput->_lodFrame + 1 < lod._updateInterval) {
+    AdvanceJob(job, gt);
+    pOutput->_lodFrame += 1;
+    AnimPose pose;
+    R32 t = static_cast<R32>(pOutput->_lodFrame) / static_cast<R32>(lod._updateInterval);
+    LerpPose(&pose, pOutput->_lodPoses[0], pOutput->_lodPoses[1], t);
+    LerpMorphs(pOutput->getBackMorphs(), pOutput->_lodMorphs[0], pOutput->_lodMorphs[1], t);
+    pOutput->_backReady = true;
+    writePalette(pOutput, pose, pSkeleton, pDropped);
+    pStats->_interpolated += 1;
+    return;
+  }
+
+  AnimPose pose;
+  B32 posed = (job._type == ANIM_JOB_TYPE_SAMPLE) ? doSampleJob(job, gt, lod, pDropped, &pose)
+                                                  : doBlendJob(job, gt, lod, pDropped, &pose);
+  if (!posed) return;
+  if (lod._skipMorphs) pOutput->getBackMorphs() = pOutput->getMorphs();
+  pOutput->_backReady = true;
+  pStats->_sampled += 1;
+
+  if (!throttled) {
+    pOutput->_lodPoses.clear();
+    writePalette(pOutput, pose, pSkeleton, pDropped);
+    return;
+  }
+
+  // The pose shown runs a sample behind, moving toward the new one until the next sample. 
+  // Morph weights shown are those sampled with it.
+  std::vector<R32>& morphs = pOutput->getBackMorphs();
+  if (levelChanged || pOutput->_lodPoses.size() != 2) {
+    pOutput->_lodPoses.assign(2, pose);
+    pOutput->_lodMorphs[0] = morphs;
+    pOutput->_lodMorphs[1] = morphs;
+  } else {
+    pOutput->_lodPoses[0] = pOutput->_lodPoses[1];
+    pOutput->_lodPoses[1] = pose;
+    pOutput->_lodMorphs[0].swap(pOutput->_lodMorphs[1]);
+    pOutput->_lodMorphs[1] = morphs;
+    // Held weights stay as they are shown.
+    if (lod._skipMorphs) pOutput->_lodMorphs[0] = morphs;
+    morphs = pOutput->_lodMorphs[0];
+  }
+  pOutput->_lodFrame = 0;
+  writePalette(pOutput, pOutput->_lodPoses[0], pSkeleton, pDropped);
 }
 
 
-void Animation::applySkeletonPose(Matrix4* pOutput, Matrix4 globalMatrix, Skeleton* pSkeleton)
+B32 Animation::doSampleJob(AnimJobSubmitInfo& job, R32 gt, const AnimLodPolicy& lod, const B8* pDropped, AnimPose* pPose)
+{
+  AnimHandle* pOutput = job._output;
+  AnimClip* pClip = job._pBaseClip;
+  Skeleton* pSkeleton = Skeleton::getSkeleton(pClip->_skeletonId);
+
+  U32 jointCount = PoseJointCount(pClip, pSkeleton, pOutput->_paletteSz);
+  if (!samplePose(pPose, pClip, &pOutput->_currState, pSkeleton, jointCount, pDropped, gt)) return false;
+
+  if (!lod._skipMorphs && pClip->_morphTargetCount > 0) {
+    std::vector<R32>& morphs = pOutput->getBackMorphs();
+    morphs.resize(pClip->_morphTargetCount);
+    pClip->sampleMorphs(morphs.data(), pOutput->_currState._fCurrLocalTime, &pOutput->_currState._cursor);
+  }
+  return true;
+}
+
+
+void Animation::applySkeletonPose(Matrix4* pOutput, Matrix4 globalMatrix, Skeleton* pSkeleton, const B8* pDropped)
 {
   if (!pSkeleton) return;
 
-  for (size_t i = 0; i < pSkeleton->_joints.size(); ++i) {
+  size_t jointCount = std::min(pSkeleton->_joints.size(), static_cast<size_t>(AnimHandle::kMaxPaletteSize));
+  for (size_t i = 0; i < jointCount; ++i) {
     Matrix4 parentTransform;
     U8 parentId = pSkeleton->_joints[i]._iParent;
     if (parentId == Joint::kNoParentId) {
@@ -267,18 +506,99 @@ void Animation::applySkeletonPose(Matrix4* pOutput, Matrix4 globalMatrix, Skelet
     pOutput[i] = pOutput[i] * parentTransform;
   }
 
-  for (size_t i = 0; i < pSkeleton->_joints.size(); ++i) {
-    pOutput[i] =  pSkeleton->_joints[i]._invBindPose * 
-                  pOutput[i] * 
-                  pSkeleton->_rootInvTransform;
+  for (size_t i = 0; i < jointCount; ++i) {
+    pOutput[i] =  pSkeleton->_joints[i]._invBindPose * pOutput[i];
+  }
+
+  // Held at their bind offset, dropped joints skin just as their parents do.
+  if (pDropped) {
+    for (size_t i = 0; i < jointCount; ++i) {
+      if (pDropped[i]) pOutput[i] = pOutput[pSkeleton->_joints[i]._iParent];
+    }
   }
+  Matrix4::multiplyBatch(pOutput, pOutput, pSkeleton->_rootInvTransform, jointCount);
 }
 
 
-void Animation::doBlendJob(AnimJobSubmitInfo& job, R32 gt)
+B32 Animation::doBlendJob(AnimJobSubmitInfo& job, R32 gt, const AnimLodPolicy& lod, const B8* pDropped, AnimPose* pPose)
 {
-  for (auto& layer : job._layers) {
-    
+  AnimHandle* pOutput = job._output;
+
+  // Every clip blended animates the same skeleton, and poses the most joints any of them does.
+  AnimClip* pFirstClip = JobClip(job);
+  if (!pFirstClip) return false;
+  Skeleton* pSkeleton = Skeleton::getSkeleton(pFirstClip->_skeletonId);
+  U32 jointCount = PoseJointCount(job._pBaseClip, pSkeleton, pOutput->_paletteSz);
+  for (const AnimBlendLayer& layer : job._layers) {
+    jointCount = std::max(jointCount, PoseJointCount(layer._pClip, pSkeleton, pOutput->_paletteSz));
+  }
+
+  AnimPose& pose = *pPose;
+  AnimPose layerPose;
+  R32 weights[AnimPose::kSlotCount];
+  // Weight blended into each slot so far, by a plain blend.
+  R32 totals[AnimPose::kSlotCount];
+  R32 morphTotal = 0.0f;
+  FrameVector<R32> morphs;
+  FrameVector<R32> layerMorphs;
+  B32 posed = false;
+
+  pose.reset(jointCount);
+  R32 baseWeight = (job._type == ANIM_JOB_TYPE_BLEND) ? pOutput->_currState._fWeight : 1.0f;
+  for (U32 i = 0; i < AnimPose::kSlotCount; ++i) totals[i] = 0.0f;
+  if (job._pBaseClip && samplePose(&pose, job._pBaseClip, &pOutput->_currState, pSkeleton, jointCount, pDropped, gt)) {
+    for (U32 i = 0; i < AnimPose::kSlotCount; ++i) totals[i] = baseWeight;
+    if (!lod._skipMorphs && SampleMorphs(morphs, job._pBaseClip, &pOutput->_currState)) morphTotal = baseWeight;
+    posed = true;
+  }
+
+  for (const AnimBlendLayer& layer : job._layers) {
+    if (!layer._pClip || !layer._pState) continue;
+    if (!samplePose(&layerPose, layer._pClip, layer._pState, pSkeleton, jointCount, pDropped, gt)) continue;
+    posed = true;
+
+    LayerWeights(layer, jointCount, weights);
+    R32 morphWeight = layer._weight;
+    if (job._type == ANIM_JOB_TYPE_BLEND) {
+      // Each layer pulls the pose by its share of the weight so far, which averages them all.
+      for (U32 i = 0; i <= jointCount; ++i) {
+        totals[i] += weights[i];
+        weights[i] = (totals[i] > 0.0f) ? (weights[i] / totals[i]) : 0.0f;
+      }
+      morphTotal += morphWeight;
+      morphWeight = (morphTotal > 0.0f) ? (morphWeight / morphTotal) : 0.0f;
+    } else {
+      for (U32 i = 0; i <= jointCount; ++i) weights[i] = std::min(std::max(weights[i], 0.0f), 1.0f);
+      morphWeight = std::min(std::max(morphWeight, 0.0f), 1.0f);
+    }
+    BlendPose(&pose, layerPose, weights);
+
+    U32 morphCount = lod._skipMorphs ? 0 : SampleMorphs(layerMorphs, layer._pClip, layer._pState);
+    if (morphCount == 0) continue;
+    if (morphs.size() != morphCount) morphs.assign(morphCount, 0.0f);
+    for (U32 i = 0; i < morphCount; ++i) {
+      morphs[i] += (layerMorphs[i] - morphs[i]) * morphWeight;
+    }
+  }
+
+  for (const AnimBlendLayer& layer : job._additiveLayers) {
+    if (!layer._pClip || !layer._pState) continue;
+    if (!samplePose(&layerPose, layer._pClip, layer._pState, pSkeleton, jointCount, pDropped, gt)) continue;
+    LayerWeights(layer, jointCount, weights);
+    AddPose(&pose, layerPose, weights);
+
+    if (lod._skipMorphs) continue;
+    U32 morphCount = SampleMorphs(layerMorphs, layer._pClip, layer._pState);
+    if (morphCount != morphs.size()) continue;
+    for (U32 i = 0; i < morphCount; ++i) {
+      morphs[i] += layerMorphs[i] * layer._weight;
+    }
+  }
+
+  if (!posed) return false;
+  if (!morphs.empty()) {
+    pOutput->getBackMorphs().assign(morphs.begin(), morphs.end());
   }
+  return true;
 }
 } // Recluse
\ No newline at end of file
@@ -5,10 +5,236 @@
 #include "Core/Exception.hpp"
 #include "Core/Math/Common.hpp"
 
-#include "UI/UI.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
 
-#include <assert.h>
 namespace Recluse {
 
 
-} // Recluse
\ No newline at end of file
+// Keys a cursor steps over before giving up, and searching instead.
+static const U32 kCursorScan = 4;
+
+// The three smallest components of a unit quaternion lie within +-sqrt(1/2).
+static const R32 kRotationRange = 0.70710678f;
+static const R32 kRotationSteps = 32767.0f;
+static const U16 kRotationMask = 0x7fff;
+static const R32 kRangeSteps = 65535.0f;
+
+
+void quantizeRotation(const Quaternion& q, U16* pKey)
+{
+  R32 c[4] = { q.x, q.y, q.z, q.w };
+  U32 largest = 0;
+  R32 norm = 0.0f;
+  for (U32 i = 0; i < 4; ++i) {
+    norm += c[i] * c[i];
+    if (std::fabs(c[i]) > std::fabs(c[largest])) largest = i;
+  }
+  // q and -q are the same rotation, so the largest is kept positive, and its sign dropped.
+  norm = std::sqrt(norm);
+  R32 scale = (norm > 0.0f) ? ((c[largest] < 0.0f) ? -1.0f : 1.0f) / norm : 0.0f;
+
+  U32 k = 0;
+  for (U32 i = 0; i < 4; ++i) {
+    if (i == largest) continue;
+    R32 unit = std::min(std::max((c[i] * scale / kRotationRange) * 0.5f + 0.5f, 0.0f), 1.0f);
+    pKey[k++] = static_cast<U16>(unit * kRotationSteps + 0.5f);
+  }
+  pKey[0] |= static_cast<U16>((largest & 1) << 15);
+  pKey[1] |= static_cast<U16>((largest >> 1) << 15);
+}
+
+
+Quaternion dequantizeRotation(const U16* pKey)
+{
+  U32 largest = (pKey[0] >> 15) | ((pKey[1] >> 15) << 1);
+  R32 c[4];
+  R32 sum = 0.0f;
+  U32 k = 0;
+  for (U32 i = 0; i < 4; ++i) {
+    if (i == largest) continue;
+    c[i] = ((pKey[k++] & kRotationMask) / kRotationSteps * 2.0f - 1.0f) * kRotationRange;
+    sum += c[i] * c[i];
+  }
+  c[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+  return Quaternion(c);
+}
+
+
+void quantizeRotation(const Quaternion& q, const AnimChannel& channel, U16* pKey)
+{
+  if (channel._keyWidth != kAnimFullRotationWidth) {
+    quantizeRotation(q, pKey);
+    return;
+  }
+  const R32 c[4] = { q.x, q.y, q.z, q.w };
+  memcpy(pKey, c, sizeof(c));
+}
+
+
+Quaternion dequantizeRotation(const U16* pKey, const AnimChannel& channel)
+{
+  if (channel._keyWidth != kAnimFullRotationWidth) return dequantizeRotation(pKey);
+  R32 c[4];
+  memcpy(c, pKey, sizeof(c));
+  return Quaternion(c);
+}
+
+
+void quantizeRange(const Vector3& v, const AnimChannel& channel, U16* pKey)
+{
+  const R32 c[3] = { v.x, v.y, v.z };
+  if (channel._keyWidth == kAnimFullRangeWidth) {
+    memcpy(pKey, c, sizeof(c));
+    return;
+  }
+  for (U32 i = 0; i < 3; ++i) {
+    R32 extent = channel._rangeExtent[i];
+    R32 unit = (extent > 0.0f) ? (c[i] - channel._rangeMin[i]) / extent : 0.0f;
+    unit = std::min(std::max(unit, 0.0f), 1.0f);
+    pKey[i] = static_cast<U16>(unit * kRangeSteps + 0.5f);
+  }
+}
+
+
+Vector3 dequantizeRange(const U16* pKey, const AnimChannel& channel)
+{
+  if (channel._keyWidth == kAnimFullRangeWidth) {
+    R32 c[3];
+    memcpy(c, pKey, sizeof(c));
+    return Vector3(c[0], c[1], c[2]);
+  }
+  return Vector3(channel._rangeMin[0] + channel._rangeExtent[0] * (pKey[0] / kRangeSteps),
+                 channel._rangeMin[1] + channel._rangeExtent[1] * (pKey[1] / kRangeSteps),
+                 channel._rangeMin[2] + channel._rangeExtent[2] * (pKey[2] / kRangeSteps));
+}
+
+
+// Last key at or before t, or the first key if t comes before it. Playing forward, the key is
+// at, or a step or two past, the cursor. Seeking back, or far ahead, searches the keys.
+static U32 FindKey(const R32* times, U32 count, R32 t, U32 cursor)
+{
+  if (cursor < count && times[cursor] <= t) {
+    for (U32 step = 0; step < kCursorScan; ++step) {
+      if (cursor + 1 >= count || times[cursor + 1] > t) return cursor;
+      ++cursor;
+    }
+  }
+  const R32* it = std::upper_bound(times, times + count, t);
+  return (it == times) ? 0 : static_cast<U32>(it - times) - 1;
+}
+
+
+// Blend factor from key to the key after it, at time t.
+static R32 KeyAlpha(const R32* times, U32 count, U32 key, R32 t)
+{
+  if (key + 1 >= count) return 0.0f;
+  R32 span = times[key + 1] - times[key];
+  if (span <= 0.0f) return 0.0f;
+  return std::min(std::max((t - times[key]) / span, 0.0f), 1.0f);
+}
+
+
+void AnimClip::bindSkeleton(const Skeleton* pSkeleton)
+{
+  // Joints keep the node id they were made from in a byte.
+  std::unordered_map<U8, U32> joints;
+  if (pSkeleton) {
+    for (size_t j = 0; j < pSkeleton->_joints.size(); ++j) {
+      joints.emplace(pSkeleton->_joints[j]._id, static_cast<U32>(j));
+    }
+  }
+
+  for (AnimTrack& track : _tracks) {
+    if (!pSkeleton) {
+      track._joint = track._nodeId;
+      continue;
+    }
+    auto it = joints.find(static_cast<U8>(track._nodeId));
+    track._joint = (it != joints.end()) ? it->second : AnimTrack::kUnboundJoint;
+  }
+
+  _skeletonId = pSkeleton ? pSkeleton->_uuid : Skeleton::kNoSkeletonId;
+  _boundSkeletonId = _skeletonId;
+}
+
+
+void AnimClip::attachCursor(AnimCursor* pCursor) const
+{
+  if (pCursor->_pClip == this) return;
+  pCursor->_pClip = this;
+  pCursor->_keys.assign(_tracks.size() * ANIM_CHANNEL_COUNT + 1, 0);
+}
+
+
+JointPose AnimClip::sampleTrack(U32 trackIdx, R32 t, AnimCursor* pCursor) const
+{
+  const AnimTrack& track = _tracks[trackIdx];
+  U32* keys = &pCursor->_keys[trackIdx * ANIM_CHANNEL_COUNT];
+  JointPose pose;
+  pose._id = static_cast<U8>(track._nodeId);
+
+  for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+    const AnimChannel& channel = track._channels[c];
+    if (channel._keyCount == 0) continue;
+
+    const R32* times = &_keyTimes[c][channel._firstKey];
+    U32 key = FindKey(times, channel._keyCount, t, keys[c]);
+    R32 alpha = KeyAlpha(times, channel._keyCount, key, t);
+    keys[c] = key;
+
+    const U16* k0 = &_keys[c][channel._firstValue + key * channel._keyWidth];
+    const U16* k1 = (key + 1 < channel._keyCount) ? k0 + channel._keyWidth : k0;
+    switch (c) {
+      case ANIM_CHANNEL_TRANSLATION:
+        pose._trans = Vector3::lerp(dequantizeRange(k0, channel), dequantizeRange(k1, channel), alpha);
+        break;
+      case ANIM_CHANNEL_ROTATION:
+      {
+        // Neighbouring keys may rebuild on opposite hemispheres, when their largest component
+        // differs.
+        Quaternion q0 = dequantizeRotation(k0, channel);
+        Quaternion q1 = dequantizeRotation(k1, channel);
+        if (q0.x * q1.x + q0.y * q1.y + q0.z * q1.z + q0.w * q1.w < 0.0f) q1 = -q1;
+        pose._rot = Quaternion::slerp(q0, q1, alpha);
+      } break;
+      case ANIM_CHANNEL_SCALE:
+        pose._scale = Vector3::lerp(dequantizeRange(k0, channel), dequantizeRange(k1, channel), alpha);
+        break;
+      default: break;
+    }
+  }
+  return pose;
+}
+
+
+B32 AnimClip::sampleMorphs(R32* pOut, R32 t, AnimCursor* pCursor) const
+{
+  if (_morphTimes.empty() || _morphTargetCount == 0) return false;
+
+  U32 count = static_cast<U32>(_morphTimes.size());
+  U32& cursor = pCursor->_keys.back();
+  U32 key = FindKey(_morphTimes.data(), count, t, cursor);
+  R32 alpha = KeyAlpha(_morphTimes.data(), count, key, t);
+  cursor = key;
+
+  const R32* w0 = &_morphWeights[key * _morphTargetCount];
+  const R32* w1 = (key + 1 < count) ? w0 + _morphTargetCount : w0;
+  for (U32 i = 0; i < _morphTargetCount; ++i) {
+    pOut[i] = Lerpf(w0[i], w1[i], alpha);
+  }
+  return true;
+}
+
+
+U64 AnimClip::getKeyByteSize() const
+{
+  U64 bytes = (_morphTimes.size() + _morphWeights.size()) * sizeof(R32);
+  for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+    bytes += _keyTimes[c].size() * sizeof(R32) + _keys[c].size() * sizeof(U16);
+  }
+  return bytes;
+}
+} // Recluse
@@ -0,0 +1,394 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "ClipCompressor.hpp"
+
+#include "Core/Exception.hpp"
+#include "Core/Logging/Log.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace Recluse {
+namespace ClipCompressor {
+
+
+// Error builds up down the hierarchy. Each attempt that misses the bounds halves the tolerance
+// of every joint, and past the last attempt, every key is kept.
+static const U32 kMaxAttempts = 6;
+
+// Channels keep full precision keys once quantizing would take up more than kQuantizedShare of
+// the tolerance. Ranges are quantized in 65535 steps, and quantized rotations rebuild within a
+// chord of about 4e-5.
+static const R32 kQuantizedShare = 0.5f;
+static const R32 kRangeSteps = 65535.0f;
+static const R32 kRotationChordError = 4.0e-5f;
+
+
+static Vector3 Interpolate(const Vector3& a, const Vector3& b, R32 t)
+{
+  return Vector3::lerp(a, b, t);
+}
+
+
+static Quaternion Interpolate(const Quaternion& a, const Quaternion& b, R32 t)
+{
+  // Same as AnimClip::sampleTrack does, so that error is measured against what plays back.
+  Quaternion q1 = b;
+  if (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f) q1 = -b;
+  return Quaternion::slerp(a, q1, t);
+}
+
+
+// Distance a point moves, with the value off by this much. Translations move the point by
+// their own difference, scales by the difference times the point's distance from the joint.
+static R32 KeyError(const Vector3& a, const Vector3& b, R32 distance)
+{
+  return (a - b).length() * distance;
+}
+
+
+// Rotating by an angle moves a point at a distance by 2 distance sin(angle / 2). Two unit
+// quaternions that far apart lie a chord of 2 sin(angle / 4) apart, which, unlike their dot
+// product, stays precise for nearly equal rotations.
+static R32 KeyError(const Quaternion& a, const Quaternion& b, R32 distance)
+{
+  R32 sign = (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f) ? -1.0f : 1.0f;
+  R32 dx = a.x - b.x * sign;
+  R32 dy = a.y - b.y * sign;
+  R32 dz = a.z - b.z * sign;
+  R32 dw = a.w - b.w * sign;
+  R32 chord = std::min(std::sqrt(dx * dx + dy * dy + dz * dz + dw * dw), 2.0f);
+  return 2.0f * distance * chord * std::sqrt(1.0f - chord * chord * 0.25f);
+}
+
+
+static void SetRange(AnimChannel* pChannel, const std::vector<Vector3>& values, const std::vector<U32>& kept)
+{
+  if (kept.empty()) return;
+  Vector3 min = values[kept[0]];
+  Vector3 max = min;
+  for (U32 k : kept) {
+    min = Vector3::minimum(min, values[k]);
+    max = Vector3::maximum(max, values[k]);
+  }
+  for (U32 i = 0; i < 3; ++i) {
+    pChannel->_rangeMin[i] = min[i];
+    pChannel->_rangeExtent[i] = max[i] - min[i];
+  }
+}
+
+
+// Half a step off along every component moves a point by sqrt(3) half steps, or, for scales, 
+// that much times its distance.
+static U32 RangeKeyWidth(const AnimChannel& channel, R32 distance, R32 tolerance)
+{
+  R32 extent = std::max(channel._rangeExtent[0], std::max(channel._rangeExtent[1], channel._rangeExtent[2]));
+  R32 error = 0.5f * 1.7320508f * distance * extent / kRangeSteps;
+  return (error > tolerance * kQuantizedShare) ? kAnimFullRangeWidth : kAnimKeyWidth;
+}
+
+
+// A chord of c moves a point by up to 2 c times its distance, see KeyError.
+static U32 RotationKeyWidth(R32 distance, R32 tolerance)
+{
+  R32 error = 2.0f * distance * kRotationChordError;
+  return (error > tolerance * kQuantizedShare) ? kAnimFullRotationWidth : kAnimKeyWidth;
+}
+
+
+static void QuantizeKey(const Vector3& value, const AnimChannel& channel, U16* pKey)
+{
+  quantizeRange(value, channel, pKey);
+}
+
+
+static void QuantizeKey(const Quaternion& value, const AnimChannel& channel, U16* pKey)
+{
+  quantizeRotation(value, channel, pKey);
+}
+
+
+// Keys to keep, in order. Spans grow from the last kept key for as long as interpolating across
+// them stays within tolerance of every key skipped.
+template<typename T>
+static void ReduceKeys(const R32* times, const T* values, U32 count, R32 distance, R32 tolerance,
+                       std::vector<U32>& kept)
+{
+  kept.clear();
+  kept.push_back(0);
+  U32 start = 0;
+  for (U32 end = start + 2; end < count; ++end) {
+    R32 span = times[end] - times[start];
+    for (U32 k = start + 1; k < end; ++k) {
+      R32 alpha = (span > 0.0f) ? (times[k] - times[start]) / span : 0.0f;
+      if (KeyError(Interpolate(values[start], values[end], alpha), values[k], distance) > tolerance) {
+        start = end - 1;
+        kept.push_back(start);
+        break;
+      }
+    }
+  }
+  if (count > 1) kept.push_back(count - 1);
+}
+
+
+// Keys the channel keeps, none if it stays at rest. Returns false if the channel has no keys.
+template<typename T>
+static B32 SelectKeys(const std::vector<R32>& times, const std::vector<T>& values, const T& rest,
+                      R32 distance, R32 tolerance, B32 reduce, std::vector<U32>& kept, Stats* pStats)
+{
+  kept.clear();
+  U32 count = static_cast<U32>(std::min(times.size(), values.size()));
+  if (count == 0) return false;
+  pStats->_rawKeys += count;
+
+  B32 resting = true;
+  B32 constant = true;
+  for (U32 k = 0; k < count; ++k) {
+    if (KeyError(values[k], rest, distance) > tolerance) resting = false;
+    if (KeyError(values[k], values[0], distance) > tolerance) constant = false;
+  }
+
+  if (resting) {
+    pStats->_defaultChannels += 1;
+  } else if (constant) {
+    pStats->_constantChannels += 1;
+    kept.push_back(0);
+  } else if (reduce) {
+    ReduceKeys(times.data(), values.data(), count, distance, tolerance, kept);
+  } else {
+    for (U32 k = 0; k < count; ++k) kept.push_back(k);
+  }
+  return true;
+}
+
+
+// Appends the kept keys to the clip. The channel's range must already be set.
+template<typename T>
+static void WriteKeys(const std::vector<R32>& times, const std::vector<T>& values, const std::vector<U32>& kept,
+                      U32 keyWidth, AnimChannelType type, AnimClip* pOut, AnimChannel* pChannel, Stats* pStats)
+{
+  std::vector<R32>& outTimes = pOut->_keyTimes[type];
+  std::vector<U16>& outKeys = pOut->_keys[type];
+  pChannel->_firstKey = static_cast<U32>(outTimes.size());
+  pChannel->_firstValue = static_cast<U32>(outKeys.size());
+  pChannel->_keyWidth = keyWidth;
+  pChannel->_keyCount = static_cast<U32>(kept.size());
+  pStats->_keptKeys += pChannel->_keyCount;
+
+  for (U32 k : kept) {
+    outTimes.push_back(times[k]);
+    size_t first = outKeys.size();
+    outKeys.resize(first + keyWidth);
+    QuantizeKey(values[k], *pChannel, &outKeys[first]);
+  }
+}
+
+
+static void CompressRanges(const std::vector<R32>& times, const std::vector<Vector3>& values, const Vector3& rest,
+                           AnimChannelType type, R32 distance, R32 tolerance, B32 reduce,
+                           AnimClip* pOut, AnimTrack* pTrack, Stats* pStats)
+{
+  AnimChannel* pChannel = &pTrack->_channels[type];
+  *pChannel = AnimChannel{ };
+  std::vector<U32> kept;
+  U32 keyWidth = kAnimKeyWidth;
+  if (SelectKeys(times, values, rest, distance, tolerance, reduce, kept, pStats)) {
+    SetRange(pChannel, values, kept);
+    keyWidth = RangeKeyWidth(*pChannel, distance, tolerance);
+  }
+  WriteKeys(times, values, kept, keyWidth, type, pOut, pChannel, pStats);
+}
+
+
+static void CompressRotations(const std::vector<R32>& times, const std::vector<Quaternion>& values,
+                              R32 distance, R32 tolerance, B32 reduce,
+                              AnimClip* pOut, AnimTrack* pTrack, Stats* pStats)
+{
+  AnimChannel* pChannel = &pTrack->_channels[ANIM_CHANNEL_ROTATION];
+  *pChannel = AnimChannel{ };
+  std::vector<U32> kept;
+  U32 keyWidth = kAnimKeyWidth;
+  if (SelectKeys(times, values, Quaternion(), distance, tolerance, reduce, kept, pStats)) {
+    keyWidth = RotationKeyWidth(distance, tolerance);
+  }
+  WriteKeys(times, values, kept, keyWidth, ANIM_CHANNEL_ROTATION, pOut, pChannel, pStats);
+}
+
+
+static void Build(const RawClip& raw, AnimClip* pOut, R32 tolerance, B32 reduce, R32 shellDistance, Stats* pStats)
+{
+  pOut->_tracks.clear();
+  for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+    pOut->_keyTimes[c].clear();
+    pOut->_keys[c].clear();
+  }
+  pStats->_rawKeys = 0;
+  pStats->_keptKeys = 0;
+  pStats->_defaultChannels = 0;
+  pStats->_constantChannels = 0;
+
+  pOut->_tracks.resize(raw._tracks.size());
+  for (size_t i = 0; i < raw._tracks.size(); ++i) {
+    const RawTrack& source = raw._tracks[i];
+    AnimTrack& track = pOut->_tracks[i];
+    track._nodeId = source._nodeId;
+    track._joint = source._nodeId;
+    CompressRanges(source._times[ANIM_CHANNEL_TRANSLATION], source._translations, Vector3(0.0f, 0.0f, 0.0f),
+                   ANIM_CHANNEL_TRANSLATION, 1.0f, tolerance, reduce, pOut, &track, pStats);
+    CompressRotations(source._times[ANIM_CHANNEL_ROTATION], source._rotations,
+                      shellDistance, tolerance, reduce, pOut, &track, pStats);
+    CompressRanges(source._times[ANIM_CHANNEL_SCALE], source._scales, Vector3(1.0f, 1.0f, 1.0f),
+                   ANIM_CHANNEL_SCALE, shellDistance, tolerance, reduce, pOut, &track, pStats);
+  }
+}
+
+
+template<typename T>
+static T SampleRawChannel(const std::vector<R32>& times, const std::vector<T>& values, R32 t, const T& rest)
+{
+  U32 count = static_cast<U32>(std::min(times.size(), values.size()));
+  if (count == 0) return rest;
+  const R32* it = std::upper_bound(times.data(), times.data() + count, t);
+  U32 key = (it == times.data()) ? 0 : static_cast<U32>(it - times.data()) - 1;
+  if (key + 1 >= count) return values[key];
+  R32 span = times[key + 1] - times[key];
+  R32 alpha = (span > 0.0f) ? std::min(std::max((t - times[key]) / span, 0.0f), 1.0f) : 0.0f;
+  return Interpolate(values[key], values[key + 1], alpha);
+}
+
+
+static JointPose SampleRawTrack(const RawTrack& track, R32 t)
+{
+  JointPose pose;
+  pose._trans = SampleRawChannel(track._times[ANIM_CHANNEL_TRANSLATION], track._translations, t, pose._trans);
+  pose._rot = SampleRawChannel(track._times[ANIM_CHANNEL_ROTATION], track._rotations, t, pose._rot);
+  pose._scale = SampleRawChannel(track._times[ANIM_CHANNEL_SCALE], track._scales, t, pose._scale);
+  return pose;
+}
+
+
+static Vector3 ApplyPose(const JointPose& pose, const Vector3& p)
+{
+  return pose._rot * (p * pose._scale) + pose._trans;
+}
+
+
+void measureError(const RawClip& raw, const AnimClip& clip, R32 shellDistance, R32* pBoneError, R32* pObjectError)
+{
+  *pBoneError = 0.0f;
+  *pObjectError = 0.0f;
+  U32 trackCount = static_cast<U32>(std::min(raw._tracks.size(), clip._tracks.size()));
+  if (trackCount == 0) return;
+
+  std::vector<R32> times;
+  for (U32 i = 0; i < trackCount; ++i) {
+    for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+      times.insert(times.end(), raw._tracks[i]._times[c].begin(), raw._tracks[i]._times[c].end());
+    }
+  }
+  std::sort(times.begin(), times.end());
+  times.erase(std::unique(times.begin(), times.end()), times.end());
+
+  const Vector3 shell[3] = {
+    Vector3(shellDistance, 0.0f, 0.0f),
+    Vector3(0.0f, shellDistance, 0.0f),
+    Vector3(0.0f, 0.0f, shellDistance)
+  };
+
+  AnimCursor cursor;
+  clip.attachCursor(&cursor);
+  std::vector<JointPose> rawPoses(trackCount);
+  std::vector<JointPose> poses(trackCount);
+  for (R32 t : times) {
+    for (U32 i = 0; i < trackCount; ++i) {
+      rawPoses[i] = SampleRawTrack(raw._tracks[i], t);
+      poses[i] = clip.sampleTrack(i, t, &cursor);
+    }
+
+    for (U32 i = 0; i < trackCount; ++i) {
+      for (const Vector3& point : shell) {
+        Vector3 a = ApplyPose(rawPoses[i], point);
+        Vector3 b = ApplyPose(poses[i], point);
+        *pBoneError = std::max(*pBoneError, (a - b).length());
+
+        // Carried up through every animated ancestor, in both versions of the clip.
+        U32 parent = raw._tracks[i]._parent;
+        for (U32 depth = 0; parent < trackCount && depth < trackCount; ++depth) {
+          a = ApplyPose(rawPoses[parent], a);
+          b = ApplyPose(poses[parent], b);
+          parent = raw._tracks[parent]._parent;
+        }
+        *pObjectError = std::max(*pObjectError, (a - b).length());
+      }
+    }
+  }
+}
+
+
+Stats compress(const RawClip& raw, AnimClip* pOut, const Settings& settings)
+{
+  pOut->_name = raw._name;
+  pOut->_fDuration = raw._duration;
+  pOut->_fFps = raw._fps;
+  pOut->_bLooping = raw._looping;
+  pOut->_morphTargetCount = raw._morphTargetCount;
+  pOut->_morphTimes = raw._morphTimes;
+  pOut->_morphWeights = raw._morphWeights;
+
+  Stats stats = { };
+  R32 tolerance = settings._maxBoneError;
+  B32 reduce = settings._reduceKeys;
+  for (U32 attempt = 1; ; ++attempt) {
+    Build(raw, pOut, tolerance, reduce, settings._shellDistance, &stats);
+    measureError(raw, *pOut, settings._shellDistance, &stats._maxBoneError, &stats._maxObjectError);
+    if (!reduce) break;
+    if (stats._maxBoneError <= settings._maxBoneError && stats._maxObjectError <= settings._maxObjectError) break;
+    tolerance *= 0.5f;
+    if (attempt >= kMaxAttempts) reduce = false;
+  }
+
+  stats._rawBytes = (raw._morphTimes.size() + raw._morphWeights.size()) * sizeof(R32);
+  for (const RawTrack& track : raw._tracks) {
+    for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+      stats._rawBytes += track._times[c].size() * sizeof(R32);
+    }
+    stats._rawBytes += track._translations.size() * sizeof(Vector3)
+                     + track._rotations.size() * sizeof(Quaternion)
+                     + track._scales.size() * sizeof(Vector3);
+  }
+  stats._compressedBytes = pOut->getKeyByteSize();
+  stats._ratio = (stats._compressedBytes > 0) ? static_cast<R32>(stats._rawBytes) / stats._compressedBytes : 1.0f;
+
+  if (stats._maxObjectError > settings._maxObjectError) {
+    R_DEBUG(rWarning, "Clip " + raw._name + " stays off its source by " + std::to_string(stats._maxObjectError)
+      + ", even with every key kept.\n");
+  }
+  return stats;
+}
+
+
+void makeAdditive(RawClip* pClip, const RawClip& reference)
+{
+  for (RawTrack& track : pClip->_tracks) {
+    JointPose rest;
+    for (const RawTrack& refTrack : reference._tracks) {
+      if (refTrack._nodeId == track._nodeId) {
+        rest = SampleRawTrack(refTrack, 0.0f);
+        break;
+      }
+    }
+
+    // Differences are applied as base * delta, so undo the reference the same way round.
+    Quaternion inverseRot = rest._rot.inverse();
+    for (Vector3& t : track._translations) t = t - rest._trans;
+    for (Quaternion& q : track._rotations) q = (inverseRot * q).normalize();
+    for (Vector3& scale : track._scales) {
+      scale.x = (rest._scale.x != 0.0f) ? scale.x / rest._scale.x : 1.0f;
+      scale.y = (rest._scale.y != 0.0f) ? scale.y / rest._scale.y : 1.0f;
+      scale.z = (rest._scale.z != 0.0f) ? scale.z / rest._scale.z : 1.0f;
+    }
+  }
+}
+} // ClipCompressor
+} // Recluse
@@ -4,7 +4,10 @@
 #include "Core/Types.hpp"
 #include "Core/Utility/Module.hpp"
 #include "Core/Math/Matrix4.hpp"
+#include "Core/Math/Quaternion.hpp"
+#include "Core/Math/Vector3.hpp"
 #include "Core/Thread/Threading.hpp"
+#include "Core/Memory/StlAllocator.hpp"
 #include "Clip.hpp"
 
 #include <vector>
@@ -19,27 +22,75 @@ struct AnimClip;
 struct AnimClipState;
 
 
+// Local pose of an instance, per palette slot, before the hierarchy is applied. Kept in 
+// structure of arrays form, so that poses blend in batches. Slot kRootSlot holds the track 
+// placing the whole skeleton, joints follow from slot 1.
+struct AnimPose {
+  static const U32 kMaxJoints = 64;
+  static const U32 kRootSlot = 0;
+  static const U32 kSlotCount = kMaxJoints + 1;
+
+  // Reset count joints to rest.
+  void                      reset(U32 count);
+
+  Quaternion                _rotations[kSlotCount];
+  Vector3                   _translations[kSlotCount];
+  Vector3                   _scales[kSlotCount];
+  U32                       _jointCount;          // joints sampled, root not included.
+};
+
+
 // AnimHandle holds information about the sampler responsible for generating the matrix palette,
 // any blend jobs that may need to be incorporated to the animation poses, and handle to the game
-// object that is associated with it.
+// object that is associated with it. Palettes, and morph weights, are double buffered. Jobs build
+// the back buffers while the renderer reads the front, finished the frame before.
 struct AnimHandle {
+  static const U32 kMaxPaletteSize = AnimPose::kMaxJoints;
+
   AnimHandle(UUID64 uuid)
     : _uuid(uuid)
-    , _paletteSz(64)
-    , _isPerMesh(false) { 
+    , _paletteSz(kMaxPaletteSize)
+    , _isPerMesh(false)
+    , _front(0)
+    , _backReady(false)
+    , _visible(true)
+    , _screenSize(1.0f)
+    , _lod(0)
+    , _lodFrame(0) { 
     _currState._bEnabled = true;
     _currState._bLooping = true;
     _currState._fCurrLocalTime = 0;
     _currState._fPlaybackRate = 1.0f;
+    _currState._fWeight = 1.0f;
     _currState._tau = 0;
   }
 
-  Matrix4           _finalPalette[64];
-  std::vector<R32>  _finalMorphs;
+  // Palette, and morph weights, published at the start of the frame.
+  const Matrix4*            getPalette() const { return _palettes[_front]; }
+  const std::vector<R32>&   getMorphs() const { return _morphs[_front]; }
+
+  // Buffers written by this frame's jobs, published by Animation::swapBuffers().
+  Matrix4*                  getBackPalette() { return _palettes[_front ^ 1]; }
+  std::vector<R32>&         getBackMorphs() { return _morphs[_front ^ 1]; }
+
+  Matrix4           _palettes[2][kMaxPaletteSize];
+  std::vector<R32>  _morphs[2];
   U32               _paletteSz;
   U32               _isPerMesh;
+  U32               _front;
+  B32               _backReady;   // back buffers were written, and wait to be published.
   UUID64            _uuid;
   AnimClipState     _currState;
+
+  // Level of detail inputs, set by game code before the frame's jobs run. Left alone, instances
+  // are seen full screen, and animate in full.
+  B32               _visible;
+  R32               _screenSize;  // fraction of the screen height covered.
+  U32               _lod;         // level of detail picked by the last job.
+  U32               _lodFrame;    // frames since the last sample, at a reduced rate.
+  // Last two poses sampled at a reduced rate, the frames in between are interpolated.
+  std::vector<AnimPose> _lodPoses;
+  std::vector<R32>  _lodMorphs[2];  // morph weights sampled with each of them.
 };
 
 
@@ -50,31 +101,73 @@ enum AnimJobType {
 };
 
 
+// Clip sampled, and blended, by a blend job. Layers are sampled straight into local joint
+// space, where they are blended, so each one costs a sample rather than a palette of its own.
 struct AnimBlendLayer {
-  // Local transforms that are outputted by the AnimSample job.
-  Matrix4     _transforms[64];
-  // Individual joint weight for per joint blending.
-  R32         _jointWeights[64];
-  R32         _weight;
+  AnimBlendLayer()
+    : _pClip(nullptr)
+    , _pState(nullptr)
+    , _weight(1.0f) {
+    for (U32 i = 0; i < AnimHandle::kMaxPaletteSize; ++i) _jointWeights[i] = 1.0f;
+  }
+
+  AnimClip*       _pClip;
+  // Clock, and cursor, of the clip on this instance. Kept by the caller, and advanced by the job.
+  AnimClipState*  _pState;
+  // Individual joint weight for per joint blending, by palette slot, scaling _weight. Masking
+  // joints out to 0 leaves them to the layers below.
+  R32             _jointWeights[AnimHandle::kMaxPaletteSize];
+  R32             _weight;
 };
 
 
+// ANIM_JOB_TYPE_BLEND averages the base clip with every layer, by weight. The base clip plays on
+// the handle's own state, weighted by its _fWeight.
+// ANIM_JOB_TYPE_LAYERED_BLEND plays the base clip at full weight, and each layer, in order, 
+// over the pose so far, such as an upper body overlaid on a run.
+// Additive layers then apply on top, in either case. Their clips hold differences from a 
+// reference pose, see ClipCompressor::makeAdditive.
 struct AnimJobSubmitInfo {
   AnimJobType                 _type;
   AnimHandle*                 _output;            // uuid belonging to this anim submittal.
-  AnimClip*                   _pBaseClip;       // base clip to use during sampling.
-  std::vector<AnimBlendLayer> _layers;
-  std::vector<AnimBlendLayer> _additiveLayers;
+  AnimClip*                   _pBaseClip;       // base clip to use during sampling. Optional for blends.
+  // Layers are only valid for the frame the job is submitted in.
+  FrameVector<AnimBlendLayer> _layers;
+  FrameVector<AnimBlendLayer> _additiveLayers;
 };
 
 
-// Animation sampling jobs are done by this engine module.
-// 
+// How instances are animated at a level of detail. Levels are ordered from the largest on 
+// screen to the smallest, and each instance takes the first one it is large enough for.
+struct AnimLodPolicy {
+  R32               _minScreenSize;       // smallest fraction of the screen height covered.
+  // Frames per sample. Frames in between interpolate the last two samples, a sample behind.
+  U32               _updateInterval;
+  // Joints this many levels from the tips of the skeleton are not sampled, and follow their 
+  // parents as they were bound, such as fingers and toes.
+  U32               _droppedJointLevels;
+  B32               _skipMorphs;          // morph weights hold where they were.
+};
+
+
+// Instances animated last update. Culled instances only advanced their clocks.
+struct AnimFrameStats {
+  U32               _sampled;
+  U32               _interpolated;
+  U32               _culled;
+};
+
+
+// Animation sampling jobs are done by this engine module. Jobs run in batches on the core
+// thread pool, each one writing only to its own handle, so a handle may take at most one job a
+// frame.
 class Animation : public EngineModule<Animation> {
-  static const size_t kMaxAnimationThreadCount;
+  // Jobs per batch handed to the pool.
+  static const U32 kJobBatchSize;
 public:
-  Animation() 
-    : m_workers(kMaxAnimationThreadCount) { }
+  static const U32 kMaxLodCount = 4;
+
+  Animation();
 
   // On startup event.
   void onStartUp() override;
@@ -82,9 +175,13 @@ public:
   // On Shutdown event.
   void onShutDown() override;
 
-  // Update event.
+  // Update event. Runs this frame's jobs, and waits for them.
   void updateState(R64 dt);
 
+  // Publish the buffers jobs wrote last frame, to be read this frame. Must not overlap with
+  // anything reading handles, or running jobs.
+  void swapBuffers();
+
   // Create an animation object with specified gameobject id.
   AnimHandle* createAnimHandle(UUID64 id);
 
@@ -92,46 +189,53 @@ public:
   void freeAnimHandle(AnimHandle* pObj);
   void submitJob(const AnimJobSubmitInfo& info);
 
+  // Replace the levels of detail, up to kMaxLodCount of them. Instances too small for every 
+  // level take the last one.
+  void setLodPolicies(const AnimLodPolicy* pPolicies, U32 count);
+  const AnimLodPolicy* getLodPolicies() const { return m_lodPolicies; }
+  U32  getLodCount() const { return m_lodCount; }
+
+  // Counts of the last update, read once it is done.
+  const AnimFrameStats& getFrameStats() const { return m_frameStats; }
+
 protected:
   
-  void doSampleJob(AnimJobSubmitInfo& job, R32 gt);
-  void doBlendJob(AnimJobSubmitInfo& job, R32 gt);
-  void doSkeletalAnimation( AnimJobSubmitInfo& job, 
-                            Skeleton* pSkeleton, 
-                            R32 lt,
-                            U32 currPoseIdx, 
-                            U32 nextPoseIdx);
-  void doMechanicalAnimation( AnimJobSubmitInfo& job,
-                              R32 lt,
-                              U32 currPoseIdx,
-                              U32 nextPoseIdx);
-  
-
-  void applySkeletonPose(Matrix4* pOutput, Matrix4 globalMatrix, Skeleton* pSkeleton);
-  void getCurrentAndNextPoseIdx(U32* outCurr, U32* outNext, AnimClip* pClip, R32 lt);
-  B32  emptyPoseSamples(AnimClip* pClip, I32 currPoseIdx, I32 nextPoseIdx);
-  void applyMorphTargets(AnimHandle* pOutput, AnimClip* pClip, I32 currPoseIdx, I32 nextPoseIdx, R32 lt);
+  // Pick the level of detail of a job, and sample, interpolate, or only advance it to match.
+  void doJob(AnimJobSubmitInfo& job, R32 gt, AnimFrameStats* pStats);
+  // Pose a job into local space, writing morph weights unless skipped. Returns false if nothing
+  // was sampled.
+  B32  doSampleJob(AnimJobSubmitInfo& job, R32 gt, const AnimLodPolicy& lod, const B8* pDropped, AnimPose* pPose);
+  B32  doBlendJob(AnimJobSubmitInfo& job, R32 gt, const AnimLodPolicy& lod, const B8* pDropped, AnimPose* pPose);
+
+  // Advance a clip's clock, and sample jointCount joints of it into local space, leaving out 
+  // dropped joints. Returns false if the clip is disabled, leaving the pose alone.
+  B32  samplePose(AnimPose* pOut, AnimClip* pClip, AnimClipState* pState, Skeleton* pSkeleton,
+                  U32 jointCount, const B8* pDropped, R32 gt);
+  // Build the back palette of a handle from its local pose, in a single pass down the hierarchy.
+  void writePalette(AnimHandle* pOutput, const AnimPose& pose, Skeleton* pSkeleton, const B8* pDropped);
+
+  void applySkeletonPose(Matrix4* pOutput, Matrix4 globalMatrix, Skeleton* pSkeleton, const B8* pDropped = nullptr);
 
 private:
 
-  Matrix4 linearInterpolate(JointPose* currPose, JointPose* nextPose, R32 currTime, R32 nextTime, R32 t);
-
   // Handler to the animation objects generated currently in use.
   std::unordered_map<UUID64, AnimHandle*> m_animObjects;
 
   std::mutex m_sampleJobMutex;
   std::mutex m_blendJobMutex;
-  std::mutex m_layeredJobMutex;
 
   // Sample jobs currently in place.
   std::vector<AnimJobSubmitInfo> m_sampleJobs;
   //U32                                           m_currSampleJobCount;
 
-  // Number of blend jobs to be executed after animation stepping.
+  // Blend, and layered blend, jobs. These sample their own clips.
   std::vector<AnimJobSubmitInfo> m_blendJobs;
 
-  // Thread workers for this animation submodule.
-  std::vector<std::thread> m_workers;
+  AnimLodPolicy                  m_lodPolicies[kMaxLodCount];
+  U32                            m_lodCount;
+
+  std::mutex                     m_statsMutex;
+  AnimFrameStats                 m_frameStats;
 };
 
 
@@ -40,32 +40,116 @@ struct JointPose {
 };
 
 
-// A Sample of an animation at some certain key frame. This corresponds to 
-// the AnimClip states.
-struct AnimPose {
-  std::vector<JointPose>  _aLocalPoses;       // local pose matrices at time t.
-  std::vector<Matrix4>    _aGlobalPoses;      // global pose matrices at time t.
-  std::vector<R32>        _morphs;            // Morph weights at key time t.
-  R32                     _time;              // key frame time within the animation.
+struct AnimClip;
+
+
+enum AnimChannelType {
+  ANIM_CHANNEL_TRANSLATION,
+  ANIM_CHANNEL_ROTATION,
+  ANIM_CHANNEL_SCALE,
+  ANIM_CHANNEL_COUNT
+};
+
+
+// Every key value is quantized into kAnimKeyWidth U16s. Channels that need more precision than
+// that keep their keys as R32s instead, 3 for translations and scales, 4 for rotations.
+const U32 kAnimKeyWidth = 3;
+const U32 kAnimFullRangeWidth = 6;
+const U32 kAnimFullRotationWidth = 8;
+
+
+// Range of a channel's keys, within the clip's key arrays of that channel type. Translation and
+// scale keys are quantized into the channel's own range, min to min + extent, per component.
+struct AnimChannel {
+  U32                     _firstKey;          // into the key times.
+  U32                     _keyCount;
+  U32                     _firstValue;        // into the key values, in U16s.
+  U32                     _keyWidth;          // U16s per key value.
+  R32                     _rangeMin[3];
+  R32                     _rangeExtent[3];
+};
+
+
+// Rotations keep the three smallest components of the unit quaternion, 15 bits each, and the
+// index of the largest in the top bits of the first two. The largest is rebuilt from the rest.
+void                      quantizeRotation(const Quaternion& q, U16* pKey);
+Quaternion                dequantizeRotation(const U16* pKey);
+
+// Writes, and reads, the channel's _keyWidth U16s.
+void                      quantizeRange(const Vector3& v, const AnimChannel& channel, U16* pKey);
+Vector3                   dequantizeRange(const U16* pKey, const AnimChannel& channel);
+void                      quantizeRotation(const Quaternion& q, const AnimChannel& channel, U16* pKey);
+Quaternion                dequantizeRotation(const U16* pKey, const AnimChannel& channel);
+
+
+// Keys of a single joint. Each channel keeps its own key times, so channels that barely move
+// cost a single key. A channel without keys stays at its rest value.
+struct AnimTrack {
+  static const U32 kUnboundJoint = 0xffffffff;
+
+  U32                     _nodeId;            // node animated, as numbered in the source model.
+  U32                     _joint;             // palette slot written, see AnimClip::bindSkeleton.
+  AnimChannel             _channels[ANIM_CHANNEL_COUNT];
+};
+
+
+// Where sampling last found the keys of each channel, for one instance playing a clip. Playing
+// forward picks up from these keys, instead of searching from the start of the clip.
+struct AnimCursor {
+  AnimCursor()
+    : _pClip(nullptr) { }
+
+  void                    reset() { _pClip = nullptr; _keys.clear(); }
+
+  const AnimClip*         _pClip;
+  // ANIM_CHANNEL_COUNT keys per track, then the key of the morph weights.
+  std::vector<U32>        _keys;
 };
 
 
 // Single instance of an animation clip. This may represent a "walk," "run,", "shoot," etc...
+// Keys are stored per channel type, in structure of arrays form, with times apart from values.
+// Clips are built by the ClipCompressor, which quantizes, and thins out, the source keys.
 struct AnimClip {
   AnimClip()
     : _fDuration(0.0f)
     , _fFps(0.0f)
     , _uFrameCount(0)
     , _skeletonId(Skeleton::kNoSkeletonId)
+    , _boundSkeletonId(Skeleton::kNoSkeletonId)
+    , _morphTargetCount(0)
     , _bLooping(false)
     , _name() { }
 
+  // Point every track at the palette slot of the joint its node maps to, so sampling never
+  // searches the skeleton. Without a skeleton, tracks write to the slot of their node id.
+  void                          bindSkeleton(const Skeleton* pSkeleton);
+
+  // Ready the cursor for this clip. Cursors of another clip start over from the first keys.
+  void                          attachCursor(AnimCursor* pCursor) const;
+
+  // Local pose of a track at time t, clamped to the track's first and last keys. The cursor
+  // must be attached to this clip.
+  JointPose                     sampleTrack(U32 track, R32 t, AnimCursor* pCursor) const;
+
+  // Morph weights at time t, _morphTargetCount of them. Returns false if the clip has none.
+  B32                           sampleMorphs(R32* pOut, R32 t, AnimCursor* pCursor) const;
+
+  // Bytes of key times and values, as held in memory.
+  U64                           getKeyByteSize() const;
+
   // Duration of this animation clip.
   R32                           _fDuration;           // Duration of clip T.
   R32                           _fFps;                // frames per second time.
   U32                           _uFrameCount;         // Number of frames this clip occupies.
   skeleton_uuid_t               _skeletonId;          // id of skeleton that this clip works with.
-  std::vector<AnimPose>         _aAnimPoseSamples;    //
+  skeleton_uuid_t               _boundSkeletonId;     // skeleton the tracks were last bound to.
+  std::vector<AnimTrack>        _tracks;              // one per animated joint.
+  std::vector<R32>              _keyTimes[ANIM_CHANNEL_COUNT];
+  std::vector<U16>              _keys[ANIM_CHANNEL_COUNT];  // _keyWidth of the channel per key.
+  std::vector<R32>              _morphTimes;          // morph weight key times.
+  std::vector<R32>              _morphWeights;        // _morphTargetCount weights per key.
+  U32                           _morphTargetCount;
   B32                           _bLooping;            //
   std::string                   _name;                // name of this clip.
 };
@@ -79,7 +163,7 @@ struct AnimClipState {
   R32                         _fPlaybackRate;   // rate at which to play back animation.
   B32                         _bEnabled;        // allow enabling this animation clip.
   B32                         _bLooping;        // loop this state.
-  I32                         _next;            // Next pose idx within the clip.
+  AnimCursor                  _cursor;          // keys found by the last sample of the clip.
   R32                         _tau;             // global start time of this state.
 };
 } // Recluse
\ No newline at end of file
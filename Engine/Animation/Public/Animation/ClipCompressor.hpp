@@ -0,0 +1,93 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Math/Vector3.hpp"
+#include "Core/Math/Quaternion.hpp"
+
+#include "Clip.hpp"
+
+#include <string>
+#include <vector>
+
+
+namespace Recluse {
+namespace ClipCompressor {
+
+
+const U32 kNoParentTrack = 0xffffffff;
+
+
+// Keys of one animated node at full precision, as read from a source model.
+struct RawTrack {
+  U32                     _nodeId;
+  // Track of the nearest animated ancestor, or kNoParentTrack. Object space error is measured
+  // down the chain of these, leaving out any unanimated node in between.
+  U32                     _parent;
+  std::vector<R32>        _times[ANIM_CHANNEL_COUNT];
+  std::vector<Vector3>    _translations;
+  std::vector<Quaternion> _rotations;
+  std::vector<Vector3>    _scales;
+};
+
+
+struct RawClip {
+  std::string             _name;
+  R32                     _duration;
+  R32                     _fps;
+  B32                     _looping;
+  std::vector<RawTrack>   _tracks;
+  U32                     _morphTargetCount;
+  std::vector<R32>        _morphTimes;
+  std::vector<R32>        _morphWeights;   // _morphTargetCount weights per key.
+};
+
+
+// Error is the distance a point moves, from where the source keys put it. Points sit at the
+// shell distance from each joint, along each of its axes, about where the skin around a bone
+// would be. Bone space error moves the point by the joint's own keys only, object space error
+// by the keys of every joint above it too.
+struct Settings {
+  R32                     _shellDistance;
+  R32                     _maxBoneError;
+  R32                     _maxObjectError;
+  // Remove keys that interpolating their neighbours reproduces. Channels that stay constant,
+  // or at rest, are collapsed either way.
+  B32                     _reduceKeys;
+};
+
+// Sized for models in meters.
+const Settings kDefaultSettings = { 0.05f, 0.0001f, 0.0005f, true };
+
+
+struct Stats {
+  // Bytes of key times and values, at full precision, and as compressed.
+  U64                     _rawBytes;
+  U64                     _compressedBytes;
+  R32                     _ratio;
+  R32                     _maxBoneError;
+  R32                     _maxObjectError;
+  U32                     _rawKeys;
+  U32                     _keptKeys;
+  // Channels left at rest without keys, and channels held by a single key.
+  U32                     _defaultChannels;
+  U32                     _constantChannels;
+};
+
+
+// Quantize a clip, collapse its constant and resting channels, and remove the keys that
+// interpolation can rebuild, for as long as the error stays within the settings. Tracks are
+// kept in order, even when left without keys. Returns what was saved, and the error measured.
+Stats                     compress(const RawClip& raw, AnimClip* pOut, const Settings& settings = kDefaultSettings);
+
+// Largest bone, and object, space error of a compressed clip against its source, at every
+// source key time.
+void                      measureError(const RawClip& raw, const AnimClip& clip, R32 shellDistance,
+                                       R32* pBoneError, R32* pObjectError);
+
+// Turn a clip into differences from the first pose of a reference clip, for additive layers to
+// play over other clips. Nodes the reference leaves out are taken relative to rest. Done before
+// compressing, where joints matching the reference collapse to rest, and cost nothing.
+void                      makeAdditive(RawClip* pClip, const RawClip& reference);
+} // ClipCompressor
+} // Recluse
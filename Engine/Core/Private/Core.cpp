@@ -2,6 +2,8 @@
 #include "Core.hpp"
 #include "Exception.hpp"
 
+#include <cstdlib>
+
 
 namespace Recluse {
 
@@ -12,15 +14,28 @@ Core& gCore()
 }
 
 
+FrameAllocator& gFrameAllocator()
+{
+  return gCore().FrameAlloc();
+}
+
+
 void Core::onStartUp()
 {
   Window::initializeAPI();
+
+  m_pFrameMemory = malloc(kFrameAllocatorSize * kFrameAllocatorBufferCount);
+  m_FrameAllocator.Initialize(kFrameAllocatorSize, kFrameAllocatorBufferCount, m_pFrameMemory);
 }
 
 
 void Core::onShutDown()
 {
   Time::instance().shutDown();
+
+  m_FrameAllocator.CleanUp();
+  free(m_pFrameMemory);
+  m_pFrameMemory = nullptr;
 }
 
 
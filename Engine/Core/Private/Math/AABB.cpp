@@ -2,6 +2,8 @@
 #include "Math/AABB.hpp"
 #include "Logging/Log.hpp"
 
+#include <cmath>
+
 namespace Recluse {
 
 
@@ -34,12 +36,34 @@ B32 AABB::overlaps(const AABB& other) const
 
 B32 AABB::contains(const AABB& other) const
 {
-  return false;
+  return (min.x <= other.min.x) && (min.y <= other.min.y) && (min.z <= other.min.z)
+      && (max.x >= other.max.x) && (max.y >= other.max.y) && (max.z >= other.max.z);
 }
 
 
 B32 AABB::inside(const Vector3& p) const
 {
-  return false;
+  return (p.x >= min.x) && (p.x <= max.x)
+      && (p.y >= min.y) && (p.y <= max.y)
+      && (p.z >= min.z) && (p.z <= max.z);
+}
+
+
+AABB AABB::transform(const Matrix4& mat) const
+{
+  // Transform the center, and project the half extents onto each world axis.
+  Vector3 center = (min + max) * 0.5f;
+  Vector3 extent = (max - min) * 0.5f;
+  Vector3 c, e;
+  for (U32 j = 0; j < 3; ++j) {
+    c[j] = center.x * mat.Data[0][j] + center.y * mat.Data[1][j] + center.z * mat.Data[2][j] + mat.Data[3][j];
+    e[j] = extent.x * fabsf(mat.Data[0][j]) + extent.y * fabsf(mat.Data[1][j]) + extent.z * fabsf(mat.Data[2][j]);
+  }
+  AABB aabb;
+  aabb.min = c - e;
+  aabb.max = c + e;
+  aabb.centroid = c;
+  aabb.sA = 0.0f;
+  return aabb;
 }
 } // Recluse
\ No newline at end of file
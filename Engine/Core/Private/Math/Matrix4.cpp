@@ -7,9 +7,9 @@
 #include <fstream>
 #include <cmath>
 
-#if defined _M_X64 && __USE_INTEL_INTRINSICS__
+#if __USE_INTEL_INTRINSICS__
 #define FAST_INTRINSICS 
-#include <xmmintrin.h>
+#include <smmintrin.h>
 #endif 
 
 // This define is supposed to give some leaway when comparing matrices
@@ -87,25 +87,19 @@ Matrix4 Matrix4::operator*(const Matrix4& other) const
   // With 64 multiplications and 48 additions, we can reduce this down to 
   // 16 multiplications and 12 additions using intrinsics. This is useful
   // as we are updating matrices every frame, for any matrix that may need 
-  // to be updated.
+  // to be updated. Sums are accumulated in the same order as above, so both 
+  // paths give the same results.
   Matrix4 ans;
-  __m128 row1 = _mm_load_ps(&(*other.getData)[0]);
-  __m128 row2 = _mm_load_ps(&(*other.getData)[4]);
-  __m128 row3 = _mm_load_ps(&(*other.getData)[8]);
-  __m128 row4 = _mm_load_ps(&(*other.getData)[12]);
+  __m128 row0 = _mm_loadu_ps(other.Data[0]);
+  __m128 row1 = _mm_loadu_ps(other.Data[1]);
+  __m128 row2 = _mm_loadu_ps(other.Data[2]);
+  __m128 row3 = _mm_loadu_ps(other.Data[3]);
   for (I32 i = 0; i < 4; ++i) {
-    __m128 brod1 = _mm_set1_ps((*getData)[4 * i + 0]);
-    __m128 brod2 = _mm_set1_ps((*getData)[4 * i + 1]);
-    __m128 brod3 = _mm_set1_ps((*getData)[4 * i + 2]);
-    __m128 brod4 = _mm_set1_ps((*getData)[4 * i + 3]);
-    __m128 row = _mm_add_ps(
-                  _mm_add_ps(
-                    _mm_mul_ps(brod1, row1),
-                    _mm_mul_ps(brod2, row2)),
-                  _mm_add_ps(
-                    _mm_mul_ps(brod3, row3),
-                    _mm_mul_ps(brod4, row4)));
-    _mm_store_ps(&(*ans.getData)[4 * i], row);
+    __m128 row = _mm_mul_ps(_mm_set1_ps(Data[i][0]), row0);
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(Data[i][1]), row1));
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(Data[i][2]), row2));
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(Data[i][3]), row3));
+    _mm_storeu_ps(ans.Data[i], row);
   }
   return ans;
 #endif
@@ -147,26 +141,7 @@ Matrix4 Matrix4::operator*(const R32 scaler) const
 
 void Matrix4::operator*=(const Matrix4& other)
 {
-  Matrix4 ori = *this;
-  Data[0][0] = ori[0][0] * other.Data[0][0] + ori[0][1] * other.Data[1][0] + ori[0][2] * other.Data[2][0] + ori[0][3] * other.Data[3][0];
-  Data[0][1] = ori[0][0] * other.Data[0][1] + ori[0][1] * other.Data[1][1] + ori[0][2] * other.Data[2][1] + ori[0][3] * other.Data[3][1];
-  Data[0][2] = ori[0][0] * other.Data[0][2] + ori[0][1] * other.Data[1][2] + ori[0][2] * other.Data[2][2] + ori[0][3] * other.Data[3][2];
-  Data[0][3] = ori[0][0] * other.Data[0][3] + ori[0][1] * other.Data[1][3] + ori[0][2] * other.Data[2][3] + ori[0][3] * other.Data[3][3];
-
-  Data[1][0] = ori[1][0] * other.Data[0][0] + ori[1][1] * other.Data[1][0] + ori[1][2] * other.Data[2][0] + ori[1][3] * other.Data[3][0];
-  Data[1][1] = ori[1][0] * other.Data[0][1] + ori[1][1] * other.Data[1][1] + ori[1][2] * other.Data[2][1] + ori[1][3] * other.Data[3][1];
-  Data[1][2] = ori[1][0] * other.Data[0][2] + ori[1][1] * other.Data[1][2] + ori[1][2] * other.Data[2][2] + ori[1][3] * other.Data[3][2];
-  Data[1][3] = ori[1][0] * other.Data[0][3] + ori[1][1] * other.Data[1][3] + ori[1][2] * other.Data[2][3] + ori[1][3] * other.Data[3][3];
-
-  Data[2][0] = ori[2][0] * other.Data[0][0] + ori[2][1] * other.Data[1][0] + ori[2][2] * other.Data[2][0] + ori[2][3] * other.Data[3][0];
-  Data[2][1] = ori[2][0] * other.Data[0][1] + ori[2][1] * other.Data[1][1] + ori[2][2] * other.Data[2][1] + ori[2][3] * other.Data[3][1];
-  Data[2][2] = ori[2][0] * other.Data[0][2] + ori[2][1] * other.Data[1][2] + ori[2][2] * other.Data[2][2] + ori[2][3] * other.Data[3][2];
-  Data[2][3] = ori[2][0] * other.Data[0][3] + ori[2][1] * other.Data[1][3] + ori[2][2] * other.Data[2][3] + ori[2][3] * other.Data[3][3];
-
-  Data[3][0] = ori[3][0] * other.Data[0][0] + ori[3][1] * other.Data[1][0] + ori[3][2] * other.Data[2][0] + ori[3][3] * other.Data[3][0];
-  Data[3][1] = ori[3][0] * other.Data[0][1] + ori[3][1] * other.Data[1][1] + ori[3][2] * other.Data[2][1] + ori[3][3] * other.Data[3][1];
-  Data[3][2] = ori[3][0] * other.Data[0][2] + ori[3][1] * other.Data[1][2] + ori[3][2] * other.Data[2][2] + ori[3][3] * other.Data[3][2];
-  Data[3][3] = ori[3][0] * other.Data[0][3] + ori[3][1] * other.Data[1][3] + ori[3][2] * other.Data[2][3] + ori[3][3] * other.Data[3][3];
+  *this = (*this) * other;
 }
 
 
@@ -274,14 +249,98 @@ Matrix4 Matrix4::transpose() const
 }
 
 
+#if defined FAST_INTRINSICS
+#define R_SHUFFLE_MASK(x, y, z, w)      ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define R_SWIZZLE(v, x, y, z, w)        _mm_shuffle_ps(v, v, R_SHUFFLE_MASK(x, y, z, w))
+#define R_SHUFFLE(a, b, x, y, z, w)     _mm_shuffle_ps(a, b, R_SHUFFLE_MASK(x, y, z, w))
+
+// 2x2 matrix helpers, with matrices stored as (m00, m01, m10, m11).
+// A * B
+static inline __m128 Mat2Mul(__m128 a, __m128 b)
+{
+  return _mm_add_ps(_mm_mul_ps(a, R_SWIZZLE(b, 0, 3, 0, 3)),
+                    _mm_mul_ps(R_SWIZZLE(a, 1, 0, 3, 2), R_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// adj(A) * B
+static inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+{
+  return _mm_sub_ps(_mm_mul_ps(R_SWIZZLE(a, 3, 3, 0, 0), b),
+                    _mm_mul_ps(R_SWIZZLE(a, 1, 1, 2, 2), R_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// A * adj(B)
+static inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+{
+  return _mm_sub_ps(_mm_mul_ps(a, R_SWIZZLE(b, 3, 0, 3, 0)),
+                    _mm_mul_ps(R_SWIZZLE(a, 1, 0, 3, 2), R_SWIZZLE(b, 2, 1, 2, 1)));
+}
+#endif
+
+
 Matrix4 Matrix4::inverse() const
 {
+#if !defined FAST_INTRINSICS
   R32 detA = determinant();
   if (detA == 0.0f) {
     return Matrix4::identity();
   }
   Matrix4 inverse = adjugate() * (1.0f / detA);
   return inverse;
+#else
+  // Blockwise inversion, splitting the matrix into 2x2 sub matrices
+  //  | A B |
+  //  | C D |
+  // which replaces the 16 3x3 minors of the adjugate with a handful of 2x2 products.
+  __m128 r0 = _mm_loadu_ps(Data[0]);
+  __m128 r1 = _mm_loadu_ps(Data[1]);
+  __m128 r2 = _mm_loadu_ps(Data[2]);
+  __m128 r3 = _mm_loadu_ps(Data[3]);
+  __m128 A = _mm_movelh_ps(r0, r1);
+  __m128 B = _mm_movehl_ps(r1, r0);
+  __m128 C = _mm_movelh_ps(r2, r3);
+  __m128 D = _mm_movehl_ps(r3, r2);
+
+  // Determinants of the sub matrices, as (|A|, |B|, |C|, |D|).
+  __m128 detSub = _mm_sub_ps(
+    _mm_mul_ps(R_SHUFFLE(r0, r2, 0, 2, 0, 2), R_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+    _mm_mul_ps(R_SHUFFLE(r0, r2, 1, 3, 1, 3), R_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+  __m128 detA = R_SWIZZLE(detSub, 0, 0, 0, 0);
+  __m128 detB = R_SWIZZLE(detSub, 1, 1, 1, 1);
+  __m128 detC = R_SWIZZLE(detSub, 2, 2, 2, 2);
+  __m128 detD = R_SWIZZLE(detSub, 3, 3, 3, 3);
+
+  __m128 D_C = Mat2AdjMul(D, C);
+  __m128 A_B = Mat2AdjMul(A, B);
+  __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+  __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+  __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+  __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+  // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+  __m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+  __m128 tr = _mm_mul_ps(A_B, R_SWIZZLE(D_C, 0, 2, 1, 3));
+  tr = _mm_hadd_ps(tr, tr);
+  tr = _mm_hadd_ps(tr, tr);
+  detM = _mm_sub_ps(detM, tr);
+  if (_mm_cvtss_f32(detM) == 0.0f) {
+    return Matrix4::identity();
+  }
+
+  __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+  X = _mm_mul_ps(X, rDetM);
+  Y = _mm_mul_ps(Y, rDetM);
+  Z = _mm_mul_ps(Z, rDetM);
+  W = _mm_mul_ps(W, rDetM);
+
+  // Adjugate of each block, shuffled back into rows.
+  Matrix4 inverse;
+  _mm_storeu_ps(inverse.Data[0], R_SHUFFLE(X, Y, 3, 1, 3, 1));
+  _mm_storeu_ps(inverse.Data[1], R_SHUFFLE(X, Y, 2, 0, 2, 0));
+  _mm_storeu_ps(inverse.Data[2], R_SHUFFLE(Z, W, 3, 1, 3, 1));
+  _mm_storeu_ps(inverse.Data[3], R_SHUFFLE(Z, W, 2, 0, 2, 0));
+  return inverse;
+#endif
 }
 
 
@@ -292,6 +292,14 @@ Quaternion Quaternion::slerp(const Quaternion& q0, const Quaternion& q1, const R
 }
 
 
+Quaternion Quaternion::nlerp(const Quaternion& q0, const Quaternion& q1, const R32 t)
+{
+  R32 dot = q0.x * q1.x + q0.y * q1.y + q0.z * q1.z + q0.w * q1.w;
+  Quaternion v1 = (dot < 0.0f) ? -q1 : q1;
+  return (q0 * (1.0f - t) + v1 * t).normalize();
+}
+
+
 B8 Quaternion::operator==(const Quaternion& other) const
 {
   if (x == other.x && y == other.y && z == other.z && w == other.w)
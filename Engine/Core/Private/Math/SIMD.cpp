@@ -0,0 +1,363 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Math/SIMD.hpp"
+#include "Math/Matrix4.hpp"
+#include "Math/Quaternion.hpp"
+#include "Math/Vector3.hpp"
+#include "Math/ViewFrustum.hpp"
+#include "Logging/Log.hpp"
+#include "Exception.hpp"
+
+#include "Utility/Cpu.hpp"
+
+#include <cmath>
+
+#if __USE_INTEL_INTRINSICS__
+#define FAST_INTRINSICS
+#include <smmintrin.h>
+#endif
+
+
+namespace Recluse {
+
+
+// Slerp coefficients, from "A Fast and Accurate Algorithm for Computing SLERP" by David Eberly.
+// Valid for t within [0, 1], with max error on the order of 1e-7.
+static const R32 kSlerpMu = 1.85298109240830f;
+static const R32 kSlerpU[8] = { 
+  1.0f / (1.0f * 3.0f), 1.0f / (2.0f * 5.0f), 1.0f / (3.0f * 7.0f), 1.0f / (4.0f * 9.0f),
+  1.0f / (5.0f * 11.0f), 1.0f / (6.0f * 13.0f), 1.0f / (7.0f * 15.0f), kSlerpMu / (8.0f * 17.0f) 
+};
+static const R32 kSlerpV[8] = { 
+  1.0f / 3.0f, 2.0f / 5.0f, 3.0f / 7.0f, 4.0f / 9.0f, 
+  5.0f / 11.0f, 6.0f / 13.0f, 7.0f / 15.0f, kSlerpMu * 8.0f / 17.0f 
+};
+
+
+// Per call terms (u * t^2 - v) of the slerp coefficient series, for both t and 1 - t.
+void SlerpSeriesTerms(R32 t, R32* outT, R32* outD)
+{
+  R32 d = 1.0f - t;
+  for (U32 i = 0; i < 8; ++i) {
+    outT[i] = kSlerpU[i] * t * t - kSlerpV[i];
+    outD[i] = kSlerpU[i] * d * d - kSlerpV[i];
+  }
+}
+
+
+#if defined FAST_INTRINSICS
+// Implemented in SIMDAVX2.cpp, which is built with AVX2 code generation.
+void MultiplyBatchAVX2(Matrix4* out, const Matrix4* lhs, const Matrix4* rhs, size_t count);
+void MultiplyBatchAVX2(Matrix4* out, const Matrix4* lhs, const Matrix4& rhs, size_t count);
+void TransformPointsAVX2(Vector3* out, const Vector3* points, const Matrix4& mat, size_t count);
+size_t SlerpBatchAVX2(Quaternion* out, const Quaternion* q0, const Quaternion* q1, R32 t, size_t count);
+size_t CullBatchAVX2(const R32* planes, U32 frustumCount, const R32* cx, const R32* cy, const R32* cz,
+                     const R32* ex, const R32* ey, const R32* ez, U32* outMasks, size_t count);
+
+
+static SIMDInstructionSet DetectSIMDInstructionSet()
+{
+  if (Cpu::HasAVX2()) return SIMD_AVX2;
+  if (Cpu::HasSSE41()) return SIMD_SSE4_1;
+  return SIMD_SCALAR;
+}
+#else
+static SIMDInstructionSet DetectSIMDInstructionSet()
+{
+  return SIMD_SCALAR;
+}
+#endif
+
+
+static SIMDInstructionSet& CurrentSIMDInstructionSet()
+{
+  static SIMDInstructionSet current = getSupportedSIMDInstructionSet();
+  return current;
+}
+
+
+SIMDInstructionSet getSupportedSIMDInstructionSet()
+{
+  static const SIMDInstructionSet supported = DetectSIMDInstructionSet();
+  return supported;
+}
+
+
+SIMDInstructionSet getSIMDInstructionSet()
+{
+  return CurrentSIMDInstructionSet();
+}
+
+
+SIMDInstructionSet setSIMDInstructionSet(SIMDInstructionSet set)
+{
+  SIMDInstructionSet supported = getSupportedSIMDInstructionSet();
+  CurrentSIMDInstructionSet() = (set > supported) ? supported : set;
+  return CurrentSIMDInstructionSet();
+}
+
+
+const TChar* getSIMDInstructionSetName(SIMDInstructionSet set)
+{
+  switch (set) {
+    case SIMD_SSE4_1: return "SSE4.1";
+    case SIMD_AVX2: return "AVX2";
+    default: return "Scalar";
+  }
+}
+
+
+void Matrix4::multiplyBatch(Matrix4* out, const Matrix4* lhs, const Matrix4* rhs, size_t count)
+{
+#if defined FAST_INTRINSICS
+  if (getSIMDInstructionSet() == SIMD_AVX2) {
+    MultiplyBatchAVX2(out, lhs, rhs, count);
+    return;
+  }
+#endif
+  // Single multiplies already use SSE, when available.
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = lhs[i] * rhs[i];
+  }
+}
+
+
+void Matrix4::multiplyBatch(Matrix4* out, const Matrix4* lhs, const Matrix4& rhs, size_t count)
+{
+  // Copy, in case rhs is part of the output.
+  Matrix4 r = rhs;
+#if defined FAST_INTRINSICS
+  if (getSIMDInstructionSet() == SIMD_AVX2) {
+    MultiplyBatchAVX2(out, lhs, r, count);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = lhs[i] * r;
+  }
+}
+
+
+void Matrix4::transformPoints(Vector3* out, const Vector3* points, const Matrix4& mat, size_t count)
+{
+#if defined FAST_INTRINSICS
+  switch (getSIMDInstructionSet()) {
+    case SIMD_AVX2:
+    {
+      TransformPointsAVX2(out, points, mat, count);
+    } return;
+    case SIMD_SSE4_1:
+    {
+      __m128 row0 = _mm_loadu_ps(mat.Data[0]);
+      __m128 row1 = _mm_loadu_ps(mat.Data[1]);
+      __m128 row2 = _mm_loadu_ps(mat.Data[2]);
+      __m128 row3 = _mm_loadu_ps(mat.Data[3]);
+      for (size_t i = 0; i < count; ++i) {
+        __m128 p = _mm_mul_ps(_mm_set1_ps(points[i].x), row0);
+        p = _mm_add_ps(p, _mm_mul_ps(_mm_set1_ps(points[i].y), row1));
+        p = _mm_add_ps(p, _mm_mul_ps(_mm_set1_ps(points[i].z), row2));
+        p = _mm_add_ps(p, row3);
+        _mm_storel_pi(reinterpret_cast<__m64*>(&out[i].x), p);
+        _mm_store_ss(&out[i].z, _mm_movehl_ps(p, p));
+      }
+    } return;
+    default: break;
+  }
+#endif
+  Matrix4 m = mat;
+  for (size_t i = 0; i < count; ++i) {
+    Vector4 p = Vector4(points[i], 1.0f) * m;
+    out[i] = Vector3(p.x, p.y, p.z);
+  }
+}
+
+
+void Quaternion::slerpBatch(Quaternion* out, const Quaternion* q0, const Quaternion* q1, const R32 t, size_t count)
+{
+  R_ASSERT(t >= 0.0f && t <= 1.0f, "Batch slerp requires t within [0, 1].\n");
+  size_t i = 0;
+#if defined FAST_INTRINSICS
+  SIMDInstructionSet set = getSIMDInstructionSet();
+  if (t >= 0.0f && t <= 1.0f && set != SIMD_SCALAR) {
+    if (set == SIMD_AVX2) {
+      i = SlerpBatchAVX2(out, q0, q1, t, count);
+    } else {
+      R32 termsT[8], termsD[8];
+      SlerpSeriesTerms(t, termsT, termsD);
+      const __m128 one = _mm_set1_ps(1.0f);
+      const __m128 signMask = _mm_set1_ps(-0.0f);
+      const __m128 vt = _mm_set1_ps(t);
+      const __m128 vd = _mm_set1_ps(1.0f - t);
+      for (; i + 4 <= count; i += 4) {
+        // Transpose four quaternions into component vectors.
+        __m128 ax = _mm_loadu_ps(&q0[i + 0].x);
+        __m128 ay = _mm_loadu_ps(&q0[i + 1].x);
+        __m128 az = _mm_loadu_ps(&q0[i + 2].x);
+        __m128 aw = _mm_loadu_ps(&q0[i + 3].x);
+        _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+        __m128 bx = _mm_loadu_ps(&q1[i + 0].x);
+        __m128 by = _mm_loadu_ps(&q1[i + 1].x);
+        __m128 bz = _mm_loadu_ps(&q1[i + 2].x);
+        __m128 bw = _mm_loadu_ps(&q1[i + 3].x);
+        _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                                _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+        // Take the shortest path, flipping q1 where the dot is negative.
+        __m128 sign = _mm_and_ps(dot, signMask);
+        bx = _mm_xor_ps(bx, sign);
+        by = _mm_xor_ps(by, sign);
+        bz = _mm_xor_ps(bz, sign);
+        bw = _mm_xor_ps(bw, sign);
+        __m128 xm1 = _mm_sub_ps(_mm_xor_ps(dot, sign), one);
+
+        __m128 cT = one;
+        __m128 cD = one;
+        for (I32 k = 7; k >= 0; --k) {
+          cT = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(termsT[k]), xm1), cT));
+          cD = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(termsD[k]), xm1), cD));
+        }
+        cT = _mm_mul_ps(cT, vt);
+        cD = _mm_mul_ps(cD, vd);
+
+        __m128 rx = _mm_add_ps(_mm_mul_ps(ax, cD), _mm_mul_ps(bx, cT));
+        __m128 ry = _mm_add_ps(_mm_mul_ps(ay, cD), _mm_mul_ps(by, cT));
+        __m128 rz = _mm_add_ps(_mm_mul_ps(az, cD), _mm_mul_ps(bz, cT));
+        __m128 rw = _mm_add_ps(_mm_mul_ps(aw, cD), _mm_mul_ps(bw, cT));
+        _MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+        _mm_storeu_ps(&out[i + 0].x, rx);
+        _mm_storeu_ps(&out[i + 1].x, ry);
+        _mm_storeu_ps(&out[i + 2].x, rz);
+        _mm_storeu_ps(&out[i + 3].x, rw);
+      }
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = Quaternion::slerp(q0[i], q1[i], t);
+  }
+}
+
+
+void Quaternion::nlerpBatch(Quaternion* out, const Quaternion* q0, const Quaternion* q1, const R32* t, size_t count)
+{
+  size_t i = 0;
+#if defined FAST_INTRINSICS
+  // A handful of multiplies per pair, AVX2 gains little over SSE here.
+  if (getSIMDInstructionSet() != SIMD_SCALAR) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= count; i += 4) {
+      __m128 ax = _mm_loadu_ps(&q0[i + 0].x);
+      __m128 ay = _mm_loadu_ps(&q0[i + 1].x);
+      __m128 az = _mm_loadu_ps(&q0[i + 2].x);
+      __m128 aw = _mm_loadu_ps(&q0[i + 3].x);
+      _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+      __m128 bx = _mm_loadu_ps(&q1[i + 0].x);
+      __m128 by = _mm_loadu_ps(&q1[i + 1].x);
+      __m128 bz = _mm_loadu_ps(&q1[i + 2].x);
+      __m128 bw = _mm_loadu_ps(&q1[i + 3].x);
+      _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+      __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                              _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+      // Flipping the sign of t, rather than of q1, takes the shortest path.
+      __m128 vt = _mm_loadu_ps(t + i);
+      __m128 vd = _mm_sub_ps(one, vt);
+      vt = _mm_xor_ps(vt, _mm_and_ps(dot, signMask));
+
+      __m128 rx = _mm_add_ps(_mm_mul_ps(ax, vd), _mm_mul_ps(bx, vt));
+      __m128 ry = _mm_add_ps(_mm_mul_ps(ay, vd), _mm_mul_ps(by, vt));
+      __m128 rz = _mm_add_ps(_mm_mul_ps(az, vd), _mm_mul_ps(bz, vt));
+      __m128 rw = _mm_add_ps(_mm_mul_ps(aw, vd), _mm_mul_ps(bw, vt));
+      __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)),
+                                          _mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw))));
+      rx = _mm_div_ps(rx, len);
+      ry = _mm_div_ps(ry, len);
+      rz = _mm_div_ps(rz, len);
+      rw = _mm_div_ps(rw, len);
+      _MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+      _mm_storeu_ps(&out[i + 0].x, rx);
+      _mm_storeu_ps(&out[i + 1].x, ry);
+      _mm_storeu_ps(&out[i + 2].x, rz);
+      _mm_storeu_ps(&out[i + 3].x, rw);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = Quaternion::nlerp(q0[i], q1[i], t[i]);
+  }
+}
+
+
+// Plane terms used by the batch cull, per plane: normal, distance, and absolute normal.
+static const U32 kCullPlaneStride = 8;
+
+
+void ViewFrustum::cullBatch(const ViewFrustum* const* frustums, U32 frustumCount,
+                            const R32* cx, const R32* cy, const R32* cz,
+                            const R32* ex, const R32* ey, const R32* ez,
+                            U32* outMasks, size_t count)
+{
+  R_ASSERT(frustumCount <= 32, "Batch cull supports at most 32 frustums.\n");
+  if (frustumCount > 32) frustumCount = 32;
+
+  R32 planes[32 * 6 * kCullPlaneStride];
+  for (U32 f = 0; f < frustumCount; ++f) {
+    for (U32 p = 0; p < 6; ++p) {
+      const Plane& plane = frustums[f]->_planes[p];
+      R32* terms = &planes[(f * 6 + p) * kCullPlaneStride];
+      terms[0] = plane.x; terms[1] = plane.y; terms[2] = plane.z; terms[3] = plane.w;
+      terms[4] = fabsf(plane.x); terms[5] = fabsf(plane.y); terms[6] = fabsf(plane.z); terms[7] = 0.0f;
+    }
+  }
+
+  size_t i = 0;
+#if defined FAST_INTRINSICS
+  SIMDInstructionSet set = getSIMDInstructionSet();
+  if (set == SIMD_AVX2) {
+    i = CullBatchAVX2(planes, frustumCount, cx, cy, cz, ex, ey, ez, outMasks, count);
+  } else if (set == SIMD_SSE4_1) {
+    for (; i + 4 <= count; i += 4) {
+      __m128 x = _mm_loadu_ps(cx + i);
+      __m128 y = _mm_loadu_ps(cy + i);
+      __m128 z = _mm_loadu_ps(cz + i);
+      __m128 w = _mm_loadu_ps(ex + i);
+      __m128 h = _mm_loadu_ps(ey + i);
+      __m128 d = _mm_loadu_ps(ez + i);
+      __m128i mask = _mm_setzero_si128();
+      for (U32 f = 0; f < frustumCount; ++f) {
+        // Boxes are outside when fully in front of any plane.
+        __m128 outside = _mm_setzero_ps();
+        for (U32 p = 0; p < 6; ++p) {
+          const R32* terms = &planes[(f * 6 + p) * kCullPlaneStride];
+          __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_set1_ps(terms[0]), x), _mm_mul_ps(_mm_set1_ps(terms[1]), y)),
+            _mm_mul_ps(_mm_set1_ps(terms[2]), z)), _mm_set1_ps(terms[3]));
+          __m128 radius = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_set1_ps(terms[4]), w), _mm_mul_ps(_mm_set1_ps(terms[5]), h)),
+            _mm_mul_ps(_mm_set1_ps(terms[6]), d));
+          outside = _mm_or_ps(outside, _mm_cmpgt_ps(dist, radius));
+          if (_mm_movemask_ps(outside) == 0xF) break;
+        }
+        mask = _mm_or_si128(mask, _mm_andnot_si128(_mm_castps_si128(outside), _mm_set1_epi32(static_cast<I32>(1u << f))));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(outMasks + i), mask);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    U32 mask = 0;
+    for (U32 f = 0; f < frustumCount; ++f) {
+      B32 outside = false;
+      for (U32 p = 0; p < 6 && !outside; ++p) {
+        const R32* terms = &planes[(f * 6 + p) * kCullPlaneStride];
+        R32 dist = terms[0] * cx[i] + terms[1] * cy[i] + terms[2] * cz[i] + terms[3];
+        R32 radius = terms[4] * ex[i] + terms[5] * ey[i] + terms[6] * ez[i];
+        outside = dist > radius;
+      }
+      if (!outside) mask |= (1u << f);
+    }
+    outMasks[i] = mask;
+  }
+}
+} // Recluse
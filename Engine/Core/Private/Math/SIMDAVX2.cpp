@@ -0,0 +1,202 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+// AVX2 batch math routines. This file is built with AVX2 and FMA code generation, and 
+// is only called into after checking cpu support at runtime, see SIMD.cpp.
+#include "Math/SIMD.hpp"
+#include "Math/Matrix4.hpp"
+#include "Math/Quaternion.hpp"
+#include "Math/Vector3.hpp"
+
+#if __USE_INTEL_INTRINSICS__
+#define FAST_INTRINSICS
+#include <immintrin.h>
+#endif
+
+
+namespace Recluse {
+
+#if defined FAST_INTRINSICS
+
+void SlerpSeriesTerms(R32 t, R32* outT, R32* outD);
+
+
+// Two rows of lhs times rhs, with each 128 bit lane holding one row.
+static inline __m256 MultiplyRows(__m256 rows, __m256 r0, __m256 r1, __m256 r2, __m256 r3)
+{
+  __m256 res = _mm256_mul_ps(_mm256_permute_ps(rows, 0x00), r0);
+  res = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0x55), r1, res);
+  res = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0xAA), r2, res);
+  res = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0xFF), r3, res);
+  return res;
+}
+
+
+void MultiplyBatchAVX2(Matrix4* out, const Matrix4* lhs, const Matrix4* rhs, size_t count)
+{
+  for (size_t i = 0; i < count; ++i) {
+    __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs[i].Data[0]));
+    __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs[i].Data[1]));
+    __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs[i].Data[2]));
+    __m256 r3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs[i].Data[3]));
+    __m256 rows01 = _mm256_loadu_ps(lhs[i].Data[0]);
+    __m256 rows23 = _mm256_loadu_ps(lhs[i].Data[2]);
+    _mm256_storeu_ps(out[i].Data[0], MultiplyRows(rows01, r0, r1, r2, r3));
+    _mm256_storeu_ps(out[i].Data[2], MultiplyRows(rows23, r0, r1, r2, r3));
+  }
+}
+
+
+void MultiplyBatchAVX2(Matrix4* out, const Matrix4* lhs, const Matrix4& rhs, size_t count)
+{
+  __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.Data[0]));
+  __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.Data[1]));
+  __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.Data[2]));
+  __m256 r3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.Data[3]));
+  for (size_t i = 0; i < count; ++i) {
+    __m256 rows01 = _mm256_loadu_ps(lhs[i].Data[0]);
+    __m256 rows23 = _mm256_loadu_ps(lhs[i].Data[2]);
+    _mm256_storeu_ps(out[i].Data[0], MultiplyRows(rows01, r0, r1, r2, r3));
+    _mm256_storeu_ps(out[i].Data[2], MultiplyRows(rows23, r0, r1, r2, r3));
+  }
+}
+
+
+void TransformPointsAVX2(Vector3* out, const Vector3* points, const Matrix4& mat, size_t count)
+{
+  __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(mat.Data[0]));
+  __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(mat.Data[1]));
+  __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(mat.Data[2]));
+  __m256 r3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(mat.Data[3]));
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    // One point per 128 bit lane.
+    __m256 x = _mm256_setr_m128(_mm_set1_ps(points[i].x), _mm_set1_ps(points[i + 1].x));
+    __m256 y = _mm256_setr_m128(_mm_set1_ps(points[i].y), _mm_set1_ps(points[i + 1].y));
+    __m256 z = _mm256_setr_m128(_mm_set1_ps(points[i].z), _mm_set1_ps(points[i + 1].z));
+    __m256 p = _mm256_fmadd_ps(z, r2, r3);
+    p = _mm256_fmadd_ps(y, r1, p);
+    p = _mm256_fmadd_ps(x, r0, p);
+    __m128 lo = _mm256_castps256_ps128(p);
+    __m128 hi = _mm256_extractf128_ps(p, 1);
+    _mm_storel_pi(reinterpret_cast<__m64*>(&out[i].x), lo);
+    _mm_store_ss(&out[i].z, _mm_movehl_ps(lo, lo));
+    _mm_storel_pi(reinterpret_cast<__m64*>(&out[i + 1].x), hi);
+    _mm_store_ss(&out[i + 1].z, _mm_movehl_ps(hi, hi));
+  }
+  for (; i < count; ++i) {
+    __m128 p = _mm_fmadd_ps(_mm_set1_ps(points[i].z), _mm256_castps256_ps128(r2), _mm256_castps256_ps128(r3));
+    p = _mm_fmadd_ps(_mm_set1_ps(points[i].y), _mm256_castps256_ps128(r1), p);
+    p = _mm_fmadd_ps(_mm_set1_ps(points[i].x), _mm256_castps256_ps128(r0), p);
+    _mm_storel_pi(reinterpret_cast<__m64*>(&out[i].x), p);
+    _mm_store_ss(&out[i].z, _mm_movehl_ps(p, p));
+  }
+}
+
+
+// In lane transpose of four vectors, each lane holding one quaternion.
+static inline void Transpose4x2(__m256& a, __m256& b, __m256& c, __m256& d)
+{
+  __m256 t0 = _mm256_unpacklo_ps(a, b);
+  __m256 t1 = _mm256_unpacklo_ps(c, d);
+  __m256 t2 = _mm256_unpackhi_ps(a, b);
+  __m256 t3 = _mm256_unpackhi_ps(c, d);
+  a = _mm256_shuffle_ps(t0, t1, 0x44);
+  b = _mm256_shuffle_ps(t0, t1, 0xEE);
+  c = _mm256_shuffle_ps(t2, t3, 0x44);
+  d = _mm256_shuffle_ps(t2, t3, 0xEE);
+}
+
+
+// Returns the number of quaternions processed, the caller handles the remainder.
+size_t SlerpBatchAVX2(Quaternion* out, const Quaternion* q0, const Quaternion* q1, R32 t, size_t count)
+{
+  R32 termsT[8], termsD[8];
+  SlerpSeriesTerms(t, termsT, termsD);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 signMask = _mm256_set1_ps(-0.0f);
+  const __m256 vt = _mm256_set1_ps(t);
+  const __m256 vd = _mm256_set1_ps(1.0f - t);
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    // Lanes are ordered (0, 2, 4, 6 | 1, 3, 5, 7) after the transpose, which the inverse 
+    // transpose undoes.
+    __m256 ax = _mm256_loadu_ps(&q0[i + 0].x);
+    __m256 ay = _mm256_loadu_ps(&q0[i + 2].x);
+    __m256 az = _mm256_loadu_ps(&q0[i + 4].x);
+    __m256 aw = _mm256_loadu_ps(&q0[i + 6].x);
+    Transpose4x2(ax, ay, az, aw);
+    __m256 bx = _mm256_loadu_ps(&q1[i + 0].x);
+    __m256 by = _mm256_loadu_ps(&q1[i + 2].x);
+    __m256 bz = _mm256_loadu_ps(&q1[i + 4].x);
+    __m256 bw = _mm256_loadu_ps(&q1[i + 6].x);
+    Transpose4x2(bx, by, bz, bw);
+
+    __m256 dot = _mm256_mul_ps(ax, bx);
+    dot = _mm256_fmadd_ps(ay, by, dot);
+    dot = _mm256_fmadd_ps(az, bz, dot);
+    dot = _mm256_fmadd_ps(aw, bw, dot);
+    __m256 sign = _mm256_and_ps(dot, signMask);
+    bx = _mm256_xor_ps(bx, sign);
+    by = _mm256_xor_ps(by, sign);
+    bz = _mm256_xor_ps(bz, sign);
+    bw = _mm256_xor_ps(bw, sign);
+    __m256 xm1 = _mm256_sub_ps(_mm256_xor_ps(dot, sign), one);
+
+    __m256 cT = one;
+    __m256 cD = one;
+    for (I32 k = 7; k >= 0; --k) {
+      cT = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_set1_ps(termsT[k]), xm1), cT, one);
+      cD = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_set1_ps(termsD[k]), xm1), cD, one);
+    }
+    cT = _mm256_mul_ps(cT, vt);
+    cD = _mm256_mul_ps(cD, vd);
+
+    __m256 rx = _mm256_fmadd_ps(bx, cT, _mm256_mul_ps(ax, cD));
+    __m256 ry = _mm256_fmadd_ps(by, cT, _mm256_mul_ps(ay, cD));
+    __m256 rz = _mm256_fmadd_ps(bz, cT, _mm256_mul_ps(az, cD));
+    __m256 rw = _mm256_fmadd_ps(bw, cT, _mm256_mul_ps(aw, cD));
+    Transpose4x2(rx, ry, rz, rw);
+    _mm256_storeu_ps(&out[i + 0].x, rx);
+    _mm256_storeu_ps(&out[i + 2].x, ry);
+    _mm256_storeu_ps(&out[i + 4].x, rz);
+    _mm256_storeu_ps(&out[i + 6].x, rw);
+  }
+  return i;
+}
+
+
+// Batch cull, 8 boxes at a time. Plain multiplies and adds, rather than fma, so results
+// match the scalar and SSE paths exactly. Returns number of boxes processed.
+size_t CullBatchAVX2(const R32* planes, U32 frustumCount, const R32* cx, const R32* cy, const R32* cz,
+                     const R32* ex, const R32* ey, const R32* ez, U32* outMasks, size_t count)
+{
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 x = _mm256_loadu_ps(cx + i);
+    __m256 y = _mm256_loadu_ps(cy + i);
+    __m256 z = _mm256_loadu_ps(cz + i);
+    __m256 w = _mm256_loadu_ps(ex + i);
+    __m256 h = _mm256_loadu_ps(ey + i);
+    __m256 d = _mm256_loadu_ps(ez + i);
+    __m256i mask = _mm256_setzero_si256();
+    for (U32 f = 0; f < frustumCount; ++f) {
+      __m256 outside = _mm256_setzero_ps();
+      for (U32 p = 0; p < 6; ++p) {
+        const R32* terms = &planes[(f * 6 + p) * 8];
+        __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+          _mm256_mul_ps(_mm256_broadcast_ss(&terms[0]), x), _mm256_mul_ps(_mm256_broadcast_ss(&terms[1]), y)),
+          _mm256_mul_ps(_mm256_broadcast_ss(&terms[2]), z)), _mm256_broadcast_ss(&terms[3]));
+        __m256 radius = _mm256_add_ps(_mm256_add_ps(
+          _mm256_mul_ps(_mm256_broadcast_ss(&terms[4]), w), _mm256_mul_ps(_mm256_broadcast_ss(&terms[5]), h)),
+          _mm256_mul_ps(_mm256_broadcast_ss(&terms[6]), d));
+        outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, radius, _CMP_GT_OQ));
+        if (_mm256_movemask_ps(outside) == 0xFF) break;
+      }
+      mask = _mm256_or_si256(mask, _mm256_andnot_si256(_mm256_castps_si256(outside), _mm256_set1_epi32(static_cast<I32>(1u << f))));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(outMasks + i), mask);
+  }
+  return i;
+}
+#endif
+} // Recluse
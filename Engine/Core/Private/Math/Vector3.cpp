@@ -7,11 +7,6 @@
 #include "Logging/Log.hpp"
 #include <cmath>
 
-#if defined _M_X64 && __USE_INTEL_INTRINSICS__
-#define FAST_INTRINSICS 1
-#include <xmmintrin.h>
-#endif
-
 namespace Recluse {
 
 
@@ -33,7 +28,7 @@ Vector3 Vector3::lerp(const Vector3& a, const Vector3& b, const R32 t)
 
 Vector3 Vector3::minimum(const Vector3& a, const Vector3& b)
 {
-  return Vector3( b.x < a.x ? b.x : a.y,
+  return Vector3( b.x < a.x ? b.x : a.x,
                   b.y < a.y ? b.y : a.y,
                   b.z < a.z ? b.z : a.z); 
 }
@@ -87,43 +82,21 @@ R32 Vector3::lengthSqr() const
 
 Vector3 Vector3::operator+(const Vector3& other) const
 {
-#if FAST_INTRINSICS
-  R32 v0[4];
-  v0[0] = x; v0[1] = y; v0[2] = z; v0[3] = 0.0f;
-  __m128 a0 = _mm_load_ps(v0);
-  v0[0] = other.x; v0[1] = other.y; v0[2] = other.z;
-  __m128 b0 = _mm_load_ps(v0);
-  __m128 ans = _mm_add_ps(a0, b0);
-  _mm_store_ps(v0, ans);
-  return Vector3(v0[0], v0[1], v0[2]);
-#else
   return Vector3(
     x + other.x,
     y + other.y,
     z + other.z
   );
-#endif
 }
 
 
 Vector3 Vector3::operator-(const Vector3& other) const
 {
-#if FAST_INTRINSICS
-  R32 v0[4];
-  v0[0] = x; v0[1] = y; v0[2] = z; v0[3] = 0.0f;
-  __m128 a0 = _mm_load_ps(v0);
-  v0[0] = other.x; v0[1] = other.y; v0[2] = other.z;
-  __m128 b0 = _mm_load_ps(&other.x);
-  __m128 ans = _mm_sub_ps(a0, b0);
-  _mm_store_ps(v0, ans);
-  return Vector3(v0[0], v0[1], v0[2]);
-#else
   return Vector3(
     x - other.x,
     y - other.y,
     z - other.z
   );
-#endif
 }
 
 
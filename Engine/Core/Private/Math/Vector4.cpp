@@ -4,7 +4,7 @@
 #include "Logging/Log.hpp"
 #include <math.h>
 
-#if defined _M_X64 && __USE_INTEL_INTRINSICS__
+#if __USE_INTEL_INTRINSICS__
 #define FAST_INTRINSICS 1
 #include <xmmintrin.h>
 #endif
@@ -21,7 +21,7 @@ Vector4 Vector4::lerp(const Vector4& A, const Vector4& B, const R32 T)
 Vector4 Vector4::minimum(const Vector4& a, const Vector4& b)
 {
   return Vector4(
-    b.x < a.x ? b.x : a.y,
+    b.x < a.x ? b.x : a.x,
     b.y < a.y ? b.y : a.y,
     b.z < a.z ? b.z : a.z,
     b.w < a.w ? b.w : a.w
@@ -43,14 +43,14 @@ Vector4 Vector4::maximum(const Vector4& a, const Vector4& b)
 Vector4 Vector4::operator+(const Vector4& other) const
 {
 #if FAST_INTRINSICS
-  __m128 a0 = _mm_load_ps(&x);
-  __m128 b0 = _mm_load_ps(&other.x);
+  __m128 a0 = _mm_loadu_ps(&x);
+  __m128 b0 = _mm_loadu_ps(&other.x);
   __m128 ans = _mm_add_ps(a0, b0);
-  Vector4 v1; _mm_store_ps(&v1.x, ans);
+  Vector4 v1; _mm_storeu_ps(&v1.x, ans);
   return v1;
 #else
   return Vector4(
-    x + other.x, y + other.y, z + other.z, w + other.z
+    x + other.x, y + other.y, z + other.z, w + other.w
   );
 #endif
 }
@@ -59,10 +59,10 @@ Vector4 Vector4::operator+(const Vector4& other) const
 Vector4 Vector4::operator-(const Vector4& other) const
 {
 #if FAST_INTRINSICS
-  __m128 a0 = _mm_load_ps(&x);
-  __m128 b0 = _mm_load_ps(&other.x);
+  __m128 a0 = _mm_loadu_ps(&x);
+  __m128 b0 = _mm_loadu_ps(&other.x);
   __m128 ans = _mm_sub_ps(a0, b0);
-  Vector4 v1; _mm_store_ps(&v1.x, ans);
+  Vector4 v1; _mm_storeu_ps(&v1.x, ans);
   return v1;
 #else
   return Vector4(
@@ -100,10 +100,10 @@ Vector4 Vector4::operator/(const R32 scaler) const
 void Vector4::operator+=(const Vector4& other)
 {
 #if FAST_INTRINSICS
-  __m128 v0 = _mm_load_ps(&x);
-  __m128 v1 = _mm_load_ps(&other.x);
+  __m128 v0 = _mm_loadu_ps(&x);
+  __m128 v1 = _mm_loadu_ps(&other.x);
   __m128 ans = _mm_add_ps(v0, v1);
-  _mm_store_ps(&x, ans);
+  _mm_storeu_ps(&x, ans);
 #else
   x += other.x;
   y += other.y;
@@ -116,10 +116,10 @@ void Vector4::operator+=(const Vector4& other)
 void Vector4::operator-=(const Vector4& other)
 {
 #if FAST_INTRINSICS
-  __m128 v0 = _mm_load_ps(&x);
-  __m128 v1 = _mm_load_ps(&other.x);
+  __m128 v0 = _mm_loadu_ps(&x);
+  __m128 v1 = _mm_loadu_ps(&other.x);
   __m128 ans = _mm_sub_ps(v0, v1);
-  _mm_store_ps(&x, ans);
+  _mm_storeu_ps(&x, ans);
 #else
   x -= other.x;
   y -= other.y;
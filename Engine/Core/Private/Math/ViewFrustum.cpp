@@ -3,6 +3,8 @@
 #include "Core/Exception.hpp"
 #include "Core/Logging/Log.hpp"
 
+#include <cmath>
+
 namespace Recluse {
 
 
@@ -50,47 +52,22 @@ void ViewFrustum::update(Matrix4& vp)
 
 ViewFrustum::Result ViewFrustum::intersect(const AABB& aabb) const
 {
-  // TODO(): Needs fixing as it is not properly culling.
-
+  // Planes face out of the frustum. Test the box center against each plane, pushed out by the
+  // box half extents projected onto the plane normal.
+  Vector3 center = (aabb.min + aabb.max) * 0.5f;
+  Vector3 extent = (aabb.max - aabb.min) * 0.5f;
   ViewFrustum::Result result = Result_Inside;
-  Vector3 vmin, vmax;
   for (U32 i = 0; i < 6; ++i) {
-    Vector3 normal = Vector3(_planes[i].x, _planes[i].y, _planes[i].z);
-    // x axis.
-    if (_planes[i].x > 0) {
-      vmin.x = aabb.min.x;
-      vmax.x = aabb.max.x;  
-    } else {
-      vmin.x = aabb.max.x;
-      vmax.x = aabb.min.x;
-    }
-
-    // y axis.
-    if (_planes[i].y > 0) {
-      vmin.y = aabb.min.y;
-      vmax.y = aabb.max.y;
-    } else {
-      vmin.y = aabb.max.y;
-      vmax.y = aabb.min.y;
-    }
-
-    // z axis.
-    if (_planes[i].z > 0) {
-      vmin.z = aabb.min.z;
-      vmax.z = aabb.max.z;
-    } else {
-      vmin.z = aabb.max.z;
-      vmax.z = aabb.min.z;
-    }
-    if (normal.dot(vmin) + _planes[i].w > 0.0f) {
-      result = Result_Outside; 
-      break;
+    const Plane& plane = _planes[i];
+    R32 d = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+    R32 r = fabsf(plane.x) * extent.x + fabsf(plane.y) * extent.y + fabsf(plane.z) * extent.z;
+    if (d > r) {
+      return Result_Outside;
     }
-    if (normal.dot(vmax) + _planes[i].w >= 0.0f) {
+    if (d + r >= 0.0f) {
       result = Result_Intersect;
-      break;
     }
   }
   return result;
 }
-} // Recluse
\ No newline at end of file
+} // Recluse
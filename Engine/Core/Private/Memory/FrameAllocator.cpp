@@ -0,0 +1,115 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Memory/FrameAllocator.hpp"
+#include "Thread/Threading.hpp"
+#include "Logging/Log.hpp"
+#include "Exception.hpp"
+
+
+namespace Recluse {
+
+
+FrameAllocator::FrameAllocator()
+  : Allocator(0, nullptr)
+  , m_BufferCount(0)
+  , m_CurrentBuffer(0)
+  , m_FrameCount(1)
+{
+  for (U32 i = 0; i < kMaxThreadArenas; ++i) {
+    m_Arenas[i]._frame = 0;
+  }
+}
+
+
+void FrameAllocator::Initialize(size_t sizePerFrame, U32 bufferCount, void* mem)
+{
+  R_ASSERT(bufferCount > 0 && bufferCount <= kMaxFrameBuffers, "Invalid frame buffer count.\n");
+  if (bufferCount == 0) bufferCount = 1;
+  if (bufferCount > kMaxFrameBuffers) bufferCount = kMaxFrameBuffers;
+
+  m_Memory = mem;
+  m_Size = sizePerFrame * bufferCount;
+  m_BufferCount = bufferCount;
+  m_CurrentBuffer = 0;
+  m_FrameCount += 1;
+  for (U32 i = 0; i < bufferCount; ++i) {
+    m_Stacks[i].Initialize(sizePerFrame, static_cast<U8*>(mem) + sizePerFrame * i);
+  }
+}
+
+
+void FrameAllocator::CleanUp()
+{
+  for (U32 i = 0; i < m_BufferCount; ++i) {
+    m_Stacks[i].Initialize(0, nullptr);
+  }
+  m_Memory = nullptr;
+  m_Size = 0;
+  m_BufferCount = 0;
+  m_FrameCount += 1;
+}
+
+
+void* FrameAllocator::allocateShared(size_t sz, size_t align)
+{
+  std::lock_guard<std::mutex> lck(m_Mutex);
+  return m_Stacks[m_CurrentBuffer].allocate(sz, align);
+}
+
+
+void* FrameAllocator::allocate(size_t sz, size_t align)
+{
+  if (!m_BufferCount) return nullptr;
+
+  I32 threadIdx = ThreadPool::GetCurrentThreadIndex();
+  if (threadIdx < 0 || threadIdx >= static_cast<I32>(kMaxThreadArenas)
+    || (sz + align) > (kThreadArenaChunkSize >> 2)) {
+    return allocateShared(sz, align);
+  }
+
+  ThreadArena& arena = m_Arenas[threadIdx];
+  void* ptr = nullptr;
+  if (arena._frame == m_FrameCount) {
+    ptr = arena._stack.allocate(sz, align);
+  }
+
+  if (!ptr) {
+    // Carve out a new chunk for this thread from the frame stack.
+    void* chunk = allocateShared(kThreadArenaChunkSize, 64);
+    if (!chunk) return nullptr;
+    arena._stack.Initialize(kThreadArenaChunkSize, chunk);
+    arena._frame = m_FrameCount;
+    ptr = arena._stack.allocate(sz, align);
+  }
+  return ptr;
+}
+
+
+void FrameAllocator::swap()
+{
+  if (!m_BufferCount) return;
+  m_CurrentBuffer = (m_CurrentBuffer + 1) % m_BufferCount;
+  m_Stacks[m_CurrentBuffer].Reset();
+  // Invalidates all thread arenas.
+  m_FrameCount += 1;
+}
+
+
+StackAllocator::Marker FrameAllocator::GetMarker()
+{
+  std::lock_guard<std::mutex> lck(m_Mutex);
+  return m_Stacks[m_CurrentBuffer].GetMarker();
+}
+
+
+void FrameAllocator::FreeToMarker(StackAllocator::Marker marker)
+{
+  std::lock_guard<std::mutex> lck(m_Mutex);
+  m_Stacks[m_CurrentBuffer].FreeToMarker(marker);
+}
+
+
+B32 FrameAllocator::Owns(const void* ptr) const
+{
+  return m_Memory && (ptr >= m_Memory) && (ptr < (static_cast<const U8*>(m_Memory) + m_Size));
+}
+} // Recluse
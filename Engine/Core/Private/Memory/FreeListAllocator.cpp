@@ -33,11 +33,15 @@ size_t AlignHeaderAdjust(const void* Addr, size_t Align, size_t HeaderSz)
 
 FreeListAllocator::FreeListAllocator(size_t Sz, void* Mem)
   : Allocator(Sz, Mem)
-  , m_MemBlocks((struct MemBlock*)Mem)
+  , m_MemBlocks(nullptr)
 {
-  R_ASSERT(Sz > sizeof(MemBlock), "Allocator: Heap memory must be larger than avg Memory Block!\n");
+  // Free blocks must be aligned to hold their own block header.
+  size_t Adjustment = AlignAdjust(Mem, alignof(MemBlock));
+  R_ASSERT(Sz > sizeof(MemBlock) + Adjustment, "Allocator: Heap memory must be larger than avg Memory Block!\n");
+  m_MemBlocks = (MemBlock* )((U8* )Mem + Adjustment);
   m_MemBlocks->Next = nullptr;
-  m_MemBlocks->Sz = Sz;
+  m_MemBlocks->Sz = (Sz - Adjustment) & ~(alignof(MemBlock) - 1);
+  m_Size = m_MemBlocks->Sz;
 }
 
 
@@ -54,22 +58,25 @@ void* FreeListAllocator::allocate(size_t Sz, size_t Align)
   MemBlock* TraverseBlock = m_MemBlocks;
   while (TraverseBlock) {
     size_t Adjustment = AlignHeaderAdjust(TraverseBlock, Align, sizeof(AllocHeader));
-    size_t TotalSz = Sz + Adjustment;
+    // Keep the block size a multiple of the header alignment, so the remainder can 
+    // be split off as its own free block.
+    size_t TotalSz = (Sz + Adjustment + alignof(MemBlock) - 1) & ~(alignof(MemBlock) - 1);
     if (TraverseBlock->Sz < TotalSz) {
       PrevBlock = TraverseBlock;
       TraverseBlock = TraverseBlock->Next;
       continue;
     }
 
-    if (TraverseBlock->Sz - TotalSz <= sizeof(AllocHeader)) {
+    if (TraverseBlock->Sz - TotalSz < sizeof(MemBlock)) {
+      // Remainder is too small to be tracked, hand out the whole block.
       TotalSz = TraverseBlock->Sz;
       if (PrevBlock) {
-        PrevBlock = TraverseBlock->Next;
+        PrevBlock->Next = TraverseBlock->Next;
       } else {
         m_MemBlocks = TraverseBlock->Next;
       }
     } else {
-      MemBlock* NextBlock = (MemBlock*)((U8*)(TraverseBlock + 1) + TotalSz);
+      MemBlock* NextBlock = (MemBlock* )((U8* )TraverseBlock + TotalSz);
       NextBlock->Sz = TraverseBlock->Sz - TotalSz;
       NextBlock->Next = TraverseBlock->Next;
       if (PrevBlock) {
@@ -79,12 +86,11 @@ void* FreeListAllocator::allocate(size_t Sz, size_t Align)
       }
     }
     
-    size_t AlignedAddr = (uintptr_t )TraverseBlock + Adjustment;
+    uintptr_t AlignedAddr = (uintptr_t )TraverseBlock + Adjustment;
     AllocHeader* Header = (AllocHeader* )(AlignedAddr - sizeof(AllocHeader));
     Header->Sz = TotalSz;
     Header->Adjust = Adjustment;
-    m_Used += TotalSz;
-    m_NumAllocations += 1;
+    TrackAllocation(TotalSz);
     return (void* )AlignedAddr;
   }
 
@@ -95,10 +101,63 @@ void* FreeListAllocator::allocate(size_t Sz, size_t Align)
 void FreeListAllocator::Deallocate(void* Ptr)
 {
   R_ASSERT(Ptr, "Pointer is null, can not deallocate!!\n");
+  if (!Ptr) return;
+
   AllocHeader* Header = (AllocHeader* )((uintptr_t )Ptr - sizeof(AllocHeader));
   uintptr_t BlockStart = reinterpret_cast<uintptr_t>(Ptr) - Header->Adjust;
   size_t BlockSz = Header->Sz;
   uintptr_t BlockEnd = BlockStart + BlockSz;
-  
+
+  // Find the free blocks surrounding this block, list is kept in address order.
+  MemBlock* PrevBlock = nullptr;
+  MemBlock* NextBlock = m_MemBlocks;
+  while (NextBlock && (uintptr_t )NextBlock < BlockEnd) {
+    PrevBlock = NextBlock;
+    NextBlock = NextBlock->Next;
+  }
+
+  TrackDeallocation(BlockSz);
+
+  MemBlock* Block = nullptr;
+  if (PrevBlock && ((uintptr_t )PrevBlock + PrevBlock->Sz) == BlockStart) {
+    // Coalesce into previous.
+    Block = PrevBlock;
+    Block->Sz += BlockSz;
+  } else {
+    Block = (MemBlock* )BlockStart;
+    Block->Sz = BlockSz;
+    Block->Next = NextBlock;
+    if (PrevBlock) {
+      PrevBlock->Next = Block;
+    } else {
+      m_MemBlocks = Block;
+    }
+  }
+
+  if (NextBlock && ((uintptr_t )Block + Block->Sz) == (uintptr_t )NextBlock) {
+    // Coalesce next into this block.
+    Block->Sz += NextBlock->Sz;
+    Block->Next = NextBlock->Next;
+  }
+}
+
+
+size_t FreeListAllocator::LargestFreeBlock() const
+{
+  size_t Largest = 0;
+  for (MemBlock* Block = m_MemBlocks; Block; Block = Block->Next) {
+    if (Block->Sz > Largest) Largest = Block->Sz;
+  }
+  return Largest;
+}
+
+
+size_t FreeListAllocator::FreeBlockCount() const
+{
+  size_t Count = 0;
+  for (MemBlock* Block = m_MemBlocks; Block; Block = Block->Next) {
+    ++Count;
+  }
+  return Count;
 }
-} // Recluse
\ No newline at end of file
+} // Recluse
@@ -0,0 +1,72 @@
+// Copyright (c) 2017 Recluse Project. All rights reserved.
+#include "Memory/PoolAllocator.hpp"
+#include "Logging/Log.hpp"
+#include "Exception.hpp"
+
+
+namespace Recluse {
+
+
+PoolAllocator::PoolAllocator(size_t blockSz, size_t blockAlign, size_t sz, void* mem)
+  : Allocator(sz, mem)
+  , m_pBlocks(nullptr)
+  , m_pFreeList(nullptr)
+  , m_BlockSize(0)
+  , m_BlockAlign(blockAlign)
+  , m_BlockCount(0)
+  , m_FreeBlockCount(0)
+{
+  R_ASSERT(blockAlign != 0 && (blockAlign & (blockAlign - 1)) == 0, "Alignment must be a power of two!\n");
+  if (blockAlign < alignof(FreeBlock)) m_BlockAlign = alignof(FreeBlock);
+  if (blockSz < sizeof(FreeBlock)) blockSz = sizeof(FreeBlock);
+
+  // Every block must start aligned, so round the stride up as well.
+  m_BlockSize = (blockSz + (m_BlockAlign - 1)) & ~(m_BlockAlign - 1);
+  uintptr_t base = reinterpret_cast<uintptr_t>(mem);
+  uintptr_t start = (base + (m_BlockAlign - 1)) & ~(uintptr_t(m_BlockAlign) - 1);
+  size_t adjustment = start - base;
+  m_pBlocks = reinterpret_cast<U8*>(start);
+  m_BlockCount = (sz > adjustment) ? (sz - adjustment) / m_BlockSize : 0;
+  R_ASSERT(m_BlockCount > 0, "Pool memory is too small for a single block!\n");
+
+  // Link free blocks in address order, so that a fresh pool fills up front to back.
+  FreeBlock** ppNext = &m_pFreeList;
+  for (size_t i = 0; i < m_BlockCount; ++i) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(m_pBlocks + i * m_BlockSize);
+    *ppNext = block;
+    ppNext = &block->Next;
+  }
+  *ppNext = nullptr;
+  m_FreeBlockCount = m_BlockCount;
+}
+
+
+void* PoolAllocator::allocate(size_t sz, size_t align)
+{
+  R_ASSERT(sz <= m_BlockSize, "Allocation is larger than the pool block size!\n");
+  R_ASSERT(align <= m_BlockAlign, "Allocation alignment is larger than the pool block alignment!\n");
+  if (!m_pFreeList || sz > m_BlockSize || align > m_BlockAlign) {
+    return nullptr;
+  }
+
+  FreeBlock* block = m_pFreeList;
+  m_pFreeList = block->Next;
+  m_FreeBlockCount -= 1;
+  TrackAllocation(m_BlockSize);
+  return block;
+}
+
+
+void PoolAllocator::Deallocate(void* ptr)
+{
+  R_ASSERT(ptr, "Pointer is null, can not deallocate!!\n");
+  R_ASSERT(Owns(ptr), "Pointer does not belong to this pool!\n");
+  if (!ptr) return;
+
+  FreeBlock* block = static_cast<FreeBlock*>(ptr);
+  block->Next = m_pFreeList;
+  m_pFreeList = block;
+  m_FreeBlockCount += 1;
+  TrackDeallocation(m_BlockSize);
+}
+} // Recluse
@@ -0,0 +1,47 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Memory/StackAllocator.hpp"
+#include "Logging/Log.hpp"
+#include "Exception.hpp"
+
+
+namespace Recluse {
+
+
+void StackAllocator::Initialize(size_t sz, void* rawMemBlock)
+{
+  m_Memory = rawMemBlock;
+  m_Size = sz;
+  m_Top = 0;
+  m_Used = 0;
+  m_PeakUsed = 0;
+  m_NumAllocations = 0;
+}
+
+
+void* StackAllocator::allocate(size_t sz, size_t align)
+{
+  R_ASSERT(align != 0 && (align & (align - 1)) == 0, "Alignment must be a power of two!\n");
+  uintptr_t base = reinterpret_cast<uintptr_t>(m_Memory);
+  uintptr_t addr = (base + m_Top + (align - 1)) & ~(uintptr_t(align) - 1);
+  size_t newTop = (addr - base) + sz;
+  if (newTop > m_Size) {
+    return nullptr;
+  }
+
+  // Used memory includes padding for alignment, so that rewinding stays in sync.
+  TrackAllocation(newTop - m_Top);
+  m_Top = newTop;
+  return reinterpret_cast<void*>(addr);
+}
+
+
+void StackAllocator::FreeToMarker(Marker marker)
+{
+  R_ASSERT(marker <= m_Top, "Marker is above the top of the stack!\n");
+  if (marker > m_Top) return;
+  m_Top = marker;
+  m_Used = marker;
+  // Allocation count can only be restored on a full reset.
+  if (marker == 0) m_NumAllocations = 0;
+}
+} // Recluse
@@ -0,0 +1,282 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Memory/TLSFAllocator.hpp"
+#include "Logging/Log.hpp"
+#include "Exception.hpp"
+
+#if defined(_MSC_VER)
+ #include <intrin.h>
+#endif
+
+
+namespace Recluse {
+
+
+// Index of the lowest set bit. Value must not be 0.
+static U32 TLSFFfs(U32 Value)
+{
+#if defined(_MSC_VER)
+  unsigned long Idx;
+  _BitScanForward(&Idx, Value);
+  return static_cast<U32>(Idx);
+#else
+  return static_cast<U32>(__builtin_ctz(Value));
+#endif
+}
+
+
+// Index of the highest set bit. Value must not be 0.
+static U32 TLSFFls(U64 Value)
+{
+#if defined(_MSC_VER)
+  unsigned long Idx;
+  _BitScanReverse64(&Idx, Value);
+  return static_cast<U32>(Idx);
+#else
+  return static_cast<U32>(63 - __builtin_clzll(Value));
+#endif
+}
+
+
+static size_t TLSFAlignUp(size_t Value, size_t Align)
+{
+  return (Value + (Align - 1)) & ~(Align - 1);
+}
+
+
+TLSFAllocator::TLSFAllocator(size_t Sz, void* Mem)
+  : Allocator(Sz, Mem)
+  , m_FlBitmap(0)
+  , m_FreeMem(0)
+  , m_FreeBlockCount(0)
+{
+  for (size_t i = 0; i < kFlIndexCount; ++i) {
+    m_SlBitmap[i] = 0;
+    for (size_t j = 0; j < kSlIndexCount; ++j) {
+      m_Blocks[i][j] = nullptr;
+    }
+  }
+
+  uintptr_t Start = TLSFAlignUp(reinterpret_cast<uintptr_t>(Mem), kAlignSize);
+  size_t Usable = (Sz - (Start - reinterpret_cast<uintptr_t>(Mem))) & ~(kAlignSize - 1);
+  // Sizes past the first level index range can not be binned.
+  size_t MaxUsable = (size_t(1) << kFlIndexMax) - kAlignSize;
+  R_ASSERT(Usable <= MaxUsable, "TLSF: Heap memory must be no larger than 4 GB!\n");
+  if (Usable > MaxUsable) Usable = MaxUsable;
+  R_ASSERT(Usable >= (2 * kBlockOverhead + kBlockSizeMin), "TLSF: Heap memory is too small!\n");
+
+  // One free block spanning the heap, capped with a zero sized used block, so that
+  // merging never walks off the end of the heap.
+  BlockHeader* Block = reinterpret_cast<BlockHeader*>(Start);
+  Block->PrevPhys = nullptr;
+  Block->Sz = (Usable - 2 * kBlockOverhead) | 1;
+  BlockHeader* Sentinel = NextPhys(Block);
+  Sentinel->PrevPhys = Block;
+  Sentinel->Sz = 0;
+
+  InsertFreeBlock(Block);
+  m_Size = Usable;
+}
+
+
+TLSFAllocator::~TLSFAllocator()
+{
+  m_FlBitmap = 0;
+}
+
+
+void TLSFAllocator::MappingInsert(size_t Sz, U32* Fl, U32* Sl) const
+{
+  if (Sz < kSmallBlockSize) {
+    *Fl = 0;
+    *Sl = static_cast<U32>(Sz / (kSmallBlockSize / kSlIndexCount));
+  } else {
+    U32 F = TLSFFls(Sz);
+    *Sl = static_cast<U32>(Sz >> (F - kSlIndexCountLog2)) ^ (1u << kSlIndexCountLog2);
+    *Fl = F - static_cast<U32>(kFlIndexShift - 1);
+  }
+}
+
+
+void TLSFAllocator::MappingSearch(size_t Sz, U32* Fl, U32* Sl) const
+{
+  // Round up to the next bin, so that any block found is guaranteed to fit.
+  if (Sz >= kSmallBlockSize) {
+    Sz += (size_t(1) << (TLSFFls(Sz) - kSlIndexCountLog2)) - 1;
+  }
+  MappingInsert(Sz, Fl, Sl);
+}
+
+
+TLSFAllocator::BlockHeader* TLSFAllocator::SearchSuitableBlock(U32* Fl, U32* Sl)
+{
+  if (*Fl >= kFlIndexCount) return nullptr;
+
+  U32 SlMap = m_SlBitmap[*Fl] & (~0u << *Sl);
+  if (!SlMap) {
+    // Nothing in this first level, move on to the next non empty one.
+    U32 FlMap = (*Fl + 1 < 32) ? (m_FlBitmap & (~0u << (*Fl + 1))) : 0;
+    if (!FlMap) return nullptr;
+    *Fl = TLSFFfs(FlMap);
+    SlMap = m_SlBitmap[*Fl];
+  }
+
+  *Sl = TLSFFfs(SlMap);
+  return m_Blocks[*Fl][*Sl];
+}
+
+
+void TLSFAllocator::InsertFreeBlock(BlockHeader* Block)
+{
+  U32 Fl, Sl;
+  MappingInsert(BlockSize(Block), &Fl, &Sl);
+  BlockHeader* Head = m_Blocks[Fl][Sl];
+  Block->NextFree = Head;
+  Block->PrevFree = nullptr;
+  if (Head) Head->PrevFree = Block;
+  m_Blocks[Fl][Sl] = Block;
+  m_FlBitmap |= (1u << Fl);
+  m_SlBitmap[Fl] |= (1u << Sl);
+  m_FreeMem += BlockSize(Block);
+  m_FreeBlockCount += 1;
+}
+
+
+void TLSFAllocator::RemoveFreeBlock(BlockHeader* Block)
+{
+  U32 Fl, Sl;
+  MappingInsert(BlockSize(Block), &Fl, &Sl);
+  BlockHeader* Prev = Block->PrevFree;
+  BlockHeader* Next = Block->NextFree;
+  if (Next) Next->PrevFree = Prev;
+  if (Prev) Prev->NextFree = Next;
+
+  if (m_Blocks[Fl][Sl] == Block) {
+    m_Blocks[Fl][Sl] = Next;
+    if (!Next) {
+      m_SlBitmap[Fl] &= ~(1u << Sl);
+      if (!m_SlBitmap[Fl]) {
+        m_FlBitmap &= ~(1u << Fl);
+      }
+    }
+  }
+  m_FreeMem -= BlockSize(Block);
+  m_FreeBlockCount -= 1;
+}
+
+
+void TLSFAllocator::SetSize(BlockHeader* Block, size_t Sz, B32 Free)
+{
+  Block->Sz = Sz | (Free ? 1 : 0);
+  NextPhys(Block)->PrevPhys = Block;
+}
+
+
+TLSFAllocator::BlockHeader* TLSFAllocator::Split(BlockHeader* Block, size_t Sz)
+{
+  BlockHeader* Remaining = reinterpret_cast<BlockHeader*>((U8* )ToPtr(Block) + Sz);
+  size_t RemainingSz = BlockSize(Block) - (Sz + kBlockOverhead);
+  Remaining->PrevPhys = Block;
+  SetSize(Remaining, RemainingSz, true);
+  Block->Sz = Sz | (Block->Sz & 1);
+  return Remaining;
+}
+
+
+TLSFAllocator::BlockHeader* TLSFAllocator::MergePrev(BlockHeader* Block)
+{
+  BlockHeader* Prev = Block->PrevPhys;
+  if (!Prev || !IsFree(Prev)) return Block;
+  RemoveFreeBlock(Prev);
+  SetSize(Prev, BlockSize(Prev) + BlockSize(Block) + kBlockOverhead, true);
+  return Prev;
+}
+
+
+TLSFAllocator::BlockHeader* TLSFAllocator::MergeNext(BlockHeader* Block)
+{
+  BlockHeader* Next = NextPhys(Block);
+  if (!IsFree(Next)) return Block;
+  RemoveFreeBlock(Next);
+  SetSize(Block, BlockSize(Block) + BlockSize(Next) + kBlockOverhead, true);
+  return Block;
+}
+
+
+void* TLSFAllocator::allocate(size_t Sz, size_t Align)
+{
+  R_ASSERT(Sz != 0 && Align != 0, "Size, or align, parameter passed as 0 !\n");
+  if (Sz == 0) return nullptr;
+
+  size_t Adjust = TLSFAlignUp(Sz, kAlignSize);
+  if (Adjust < kBlockSizeMin) Adjust = kBlockSizeMin;
+
+  // Larger alignments need room to split a free block off the front.
+  const size_t GapMin = sizeof(BlockHeader);
+  size_t SearchSz = Adjust;
+  if (Align > kAlignSize) {
+    SearchSz += Align + GapMin;
+  }
+  if (SearchSz >= (size_t(1) << kFlIndexMax)) return nullptr;
+
+  U32 Fl, Sl;
+  MappingSearch(SearchSz, &Fl, &Sl);
+  BlockHeader* Block = SearchSuitableBlock(&Fl, &Sl);
+  if (!Block) return nullptr;
+  RemoveFreeBlock(Block);
+
+  if (Align > kAlignSize) {
+    uintptr_t Ptr = reinterpret_cast<uintptr_t>(ToPtr(Block));
+    uintptr_t Aligned = TLSFAlignUp(Ptr, Align);
+    size_t Gap = Aligned - Ptr;
+    if (Gap && Gap < GapMin) {
+      Gap += Align;
+    }
+    if (Gap) {
+      // Return the front of the block as its own free block. The block before it
+      // is never free, as neighboring free blocks are always merged.
+      BlockHeader* Remaining = Split(Block, Gap - kBlockOverhead);
+      InsertFreeBlock(Block);
+      Block = Remaining;
+    }
+  }
+
+  if (BlockSize(Block) >= Adjust + sizeof(BlockHeader)) {
+    // Trim off the back.
+    BlockHeader* Remaining = Split(Block, Adjust);
+    InsertFreeBlock(Remaining);
+  }
+
+  SetSize(Block, BlockSize(Block), false);
+  TrackAllocation(BlockSize(Block) + kBlockOverhead);
+  return ToPtr(Block);
+}
+
+
+void TLSFAllocator::Deallocate(void* Ptr)
+{
+  R_ASSERT(Ptr, "Pointer is null, can not deallocate!!\n");
+  if (!Ptr) return;
+
+  BlockHeader* Block = FromPtr(Ptr);
+  R_ASSERT(!IsFree(Block), "TLSF: Double free detected!\n");
+  TrackDeallocation(BlockSize(Block) + kBlockOverhead);
+
+  Block->Sz |= 1;
+  Block = MergePrev(Block);
+  Block = MergeNext(Block);
+  InsertFreeBlock(Block);
+}
+
+
+size_t TLSFAllocator::LargestFreeBlock() const
+{
+  if (!m_FlBitmap) return 0;
+  U32 Fl = TLSFFls(m_FlBitmap);
+  U32 Sl = TLSFFls(m_SlBitmap[Fl]);
+  size_t Largest = 0;
+  for (BlockHeader* Block = m_Blocks[Fl][Sl]; Block; Block = Block->NextFree) {
+    if (BlockSize(Block) > Largest) Largest = BlockSize(Block);
+  }
+  return Largest;
+}
+} // Recluse
@@ -0,0 +1,124 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Thread/TaskGraph.hpp"
+#include "Utility/Time.hpp"
+#include "Utility/Profile.hpp"
+
+#include "Logging/Log.hpp"
+#include "Exception.hpp"
+
+
+namespace Recluse {
+
+
+task_stage_id_t TaskGraph::addStage(const std::string& name,
+                                    thr_work_func_t work,
+                                    const std::vector<task_stage_id_t>& dependencies,
+                                    TaskStageFlags flags)
+{
+  task_stage_id_t id = static_cast<task_stage_id_t>(m_stages.size());
+  for (task_stage_id_t dependency : dependencies) {
+    R_ASSERT(dependency < id, "Stage dependencies must be declared before the stage depending on them.");
+    if (dependency >= id) return kInvalidStage;
+  }
+
+  Stage stage;
+  stage._name = name;
+  stage._work = work;
+  stage._dependencies = dependencies;
+  stage._flags = flags;
+  stage._enable = true;
+  stage._profileTag = Profiler::InternTag(name);
+  m_stages.push_back(stage);
+
+  TaskStageTiming timing = { name, 0.0, 0.0, 0.0, -1 };
+  m_timings.push_back(timing);
+
+  // Counters can not be moved while in use, so rebuild them on graph changes.
+  m_counters.reset(new JobCounter[m_stages.size()]);
+  return id;
+}
+
+
+void TaskGraph::setStageEnable(task_stage_id_t id, B32 enable)
+{
+  if (id >= m_stages.size()) return;
+  m_stages[id]._enable = enable;
+}
+
+
+task_stage_id_t TaskGraph::findStage(const std::string& name) const
+{
+  for (size_t i = 0; i < m_stages.size(); ++i) {
+    if (m_stages[i]._name == name) return static_cast<task_stage_id_t>(i);
+  }
+  return kInvalidStage;
+}
+
+
+void TaskGraph::clear()
+{
+  m_stages.clear();
+  m_timings.clear();
+  m_counters.reset();
+}
+
+
+void TaskGraph::runStage(task_stage_id_t id, R64 frameStart)
+{
+  Stage& stage = m_stages[id];
+  TaskStageTiming& timing = m_timings[id];
+  R64 start = Time::currentTime();
+  {
+    ProfileObject scope(PROFILE_TYPES_ENGINE, stage._profileTag);
+    if (stage._work) stage._work();
+  }
+  R64 end = Time::currentTime();
+  timing._startMs = (start - frameStart) * 1000.0;
+  timing._endMs = (end - frameStart) * 1000.0;
+  timing._totalMs = timing._endMs - timing._startMs;
+  timing._threadIdx = ThreadPool::GetCurrentThreadIndex();
+}
+
+
+void TaskGraph::execute(ThreadPool& pool)
+{
+  R64 frameStart = Time::currentTime();
+  std::vector<JobCounter*> dependencies;
+
+  // Stages are declared in dependency order, so walking them in order guarantees
+  // every dependency has either been submitted, or finished on this thread.
+  for (size_t i = 0; i < m_stages.size(); ++i) {
+    Stage& stage = m_stages[i];
+    if (!stage._enable) {
+      m_timings[i]._startMs = m_timings[i]._endMs = m_timings[i]._totalMs = 0.0;
+      continue;
+    }
+
+    dependencies.clear();
+    for (task_stage_id_t dependency : stage._dependencies) {
+      if (!m_counters[dependency].IsDone()) {
+        dependencies.push_back(&m_counters[dependency]);
+      }
+    }
+
+    task_stage_id_t id = static_cast<task_stage_id_t>(i);
+    if (stage._flags & TASK_STAGE_FLAG_MAIN_THREAD) {
+      for (JobCounter* counter : dependencies) {
+        pool.WaitForCounter(counter);
+      }
+      runStage(id, frameStart);
+    } else {
+      pool.AddTask([this, id, frameStart] () -> void { runStage(id, frameStart); },
+                   &m_counters[i],
+                   dependencies.data(),
+                   static_cast<U32>(dependencies.size()));
+    }
+  }
+
+  for (size_t i = 0; i < m_stages.size(); ++i) {
+    pool.WaitForCounter(&m_counters[i]);
+  }
+
+  m_frameMs = (Time::currentTime() - frameStart) * 1000.0;
+}
+} // Recluse
@@ -10,7 +10,19 @@ namespace Recluse {
 
 
 thread_id_t Thread::currentId = 0;
-std::atomic_uint32_t a_BusyThreadCount = 0;
+
+// Pool thread index of the calling thread, -1 if not owned by a pool.
+thread_local I32          tThreadIndex = -1;
+thread_local ThreadPool*  tThreadPool = nullptr;
+
+
+struct ThreadJob {
+  thr_work_func_t           Work;
+  JobCounter*               Counter;
+  // Counters this job must wait on, checked in order.
+  std::vector<JobCounter*>  Dependencies;
+  size_t                    NextDependency;
+};
 
 
 void Thread::run(thread_func_t entry, thread_id_t id)
@@ -20,91 +32,399 @@ void Thread::run(thread_func_t entry, thread_id_t id)
 }
 
 
+ThreadPool::WorkQueue::WorkQueue()
+  : m_Top(0)
+  , m_Bottom(0)
+{
+  for (U32 i = 0; i < kMaxJobsPerQueue; ++i) {
+    m_Jobs[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+
+B32 ThreadPool::WorkQueue::Push(ThreadJob* job)
+{
+  I64 b = m_Bottom.load(std::memory_order_relaxed);
+  I64 t = m_Top.load(std::memory_order_acquire);
+  if ((b - t) >= static_cast<I64>(kMaxJobsPerQueue)) {
+    return false;
+  }
+  m_Jobs[b & (kMaxJobsPerQueue - 1)].store(job, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  m_Bottom.store(b + 1, std::memory_order_relaxed);
+  return true;
+}
+
+
+ThreadJob* ThreadPool::WorkQueue::Pop()
+{
+  I64 b = m_Bottom.load(std::memory_order_relaxed) - 1;
+  m_Bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  I64 t = m_Top.load(std::memory_order_relaxed);
+
+  if (t > b) {
+    // Queue was empty, restore.
+    m_Bottom.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  ThreadJob* job = m_Jobs[b & (kMaxJobsPerQueue - 1)].load(std::memory_order_relaxed);
+  if (t == b) {
+    // Last job in the queue, race any thieves for it.
+    if (!m_Top.compare_exchange_strong(t, t + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+    m_Bottom.store(b + 1, std::memory_order_relaxed);
+  }
+  return job;
+}
+
+
+ThreadJob* ThreadPool::WorkQueue::Steal()
+{
+  I64 t = m_Top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  I64 b = m_Bottom.load(std::memory_order_acquire);
+  if (t >= b) {
+    return nullptr;
+  }
+
+  ThreadJob* job = m_Jobs[t & (kMaxJobsPerQueue - 1)].load(std::memory_order_relaxed);
+  if (!m_Top.compare_exchange_strong(t, t + 1,
+                                     std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+    // Lost the race to another thief, or the owner.
+    return nullptr;
+  }
+  return job;
+}
+
+
+ThreadPool::ThreadPool(U32 InitThreadCount)
+  : m_Queues(nullptr)
+  , m_QueueCount(0)
+  , m_QueuedJobCount(0)
+  , m_CurrentTaskCount(0)
+  , m_SleepingThreadCount(0)
+  , m_SignalStop(true)
+{
+  if (InitThreadCount == 0) {
+    U32 hw = std::thread::hardware_concurrency();
+    InitThreadCount = (hw > 1) ? hw - 1 : 1;
+  }
+  m_ThreadWorkers.resize(InitThreadCount);
+  // One queue per worker, plus one for the thread that runs the pool.
+  m_QueueCount = InitThreadCount + 1;
+  m_Queues = new WorkQueue[m_QueueCount];
+}
+
+
+ThreadPool::~ThreadPool()
+{
+  StopAll();
+  delete[] m_Queues;
+  m_Queues = nullptr;
+}
+
+
+I32 ThreadPool::GetCurrentThreadIndex()
+{
+  return tThreadIndex;
+}
+
+
 void ThreadPool::RunAll()
 {
+  if (!m_SignalStop) return;
   m_SignalStop = false;
+
+  // The calling thread owns the last queue.
+  tThreadIndex = static_cast<I32>(m_QueueCount - 1);
+  tThreadPool = this;
+
   for (size_t i = 0; i < m_ThreadWorkers.size(); ++i) {
-    m_ThreadWorkers[i].run([&] (thread_id_t id) -> void {
+    m_ThreadWorkers[i].run([this] (thread_id_t id) -> void {
       R_DEBUG(rNotify, "Thread " + std::to_string(id) + " starting...\n");
-      while (!m_SignalStop) {
-        {
-          std::unique_lock<std::mutex> grd(m_JobMutex);
-          if (!m_ThreadJobs.empty()) {
-            ThreadJob job = m_ThreadJobs.front();
-            job.CurrThreadId = id;
-            job.Result = ThrResultInProgress;
-
-            {
-              m_ThreadJobs.pop();    
-            }
-
-            grd.unlock();
-
-            {
-              std::unique_lock<std::mutex> grd(m_ProgressMutex);
-              m_ProgressJobs.push_back(job);
-              a_BusyThreadCount++;
-            }
-
-            if (job.Work) { job.Work(); }
-
-            {
-              std::unique_lock<std::mutex> grd(m_ProgressMutex);
-              for (auto it = m_ProgressJobs.begin(); it != m_ProgressJobs.end(); ++it) {
-                if (it->CurrThreadId == id) {
-                  m_ProgressJobs.erase(it);
-                  --a_BusyThreadCount;
-                  break;
-                }
-              }   
-            }
-          }
-        }
-      }
+      WorkerLoop(static_cast<I32>(id));
     }, static_cast<thread_id_t>(i));
   }
 }
 
 
-void ThreadPool::WaitAll()
+void ThreadPool::WorkerLoop(I32 idx)
 {
-  // Spin lock to acquire the lock. This will cause the main thread to wait for threads to 
-  // finish their work, before moving forward.
-  while (true) {
-    // Check for any busy threads.
-    R_DEBUG(rVerbose, "Spinlock syncing...\n");
-    if (!a_BusyThreadCount) { 
-      break;
+  tThreadIndex = idx;
+  tThreadPool = this;
+
+  while (!m_SignalStop) {
+    ThreadJob* job = FindJob(idx);
+    if (job) {
+      Execute(job);
+      continue;
     }
+
+    Park([this] () -> B32 {
+      return m_QueuedJobCount.load() > 0 || m_SignalStop.load();
+    });
+  }
+}
+
+
+void ThreadPool::Park(const std::function<B32()>& Wake)
+{
+  m_SleepingThreadCount.fetch_add(1);
+  {
+    std::unique_lock<std::mutex> lck(m_ParkMutex);
+    m_ParkCond.wait(lck, Wake);
+  }
+  m_SleepingThreadCount.fetch_sub(1);
+}
+
+
+void ThreadPool::WakeAll()
+{
+  {
+    std::lock_guard<std::mutex> lck(m_ParkMutex);
+  }
+  m_ParkCond.notify_all();
+}
+
+
+ThreadJob* ThreadPool::FindJob(I32 idx)
+{
+  ThreadJob* job = nullptr;
+  if (idx >= 0 && tThreadPool == this) {
+    job = m_Queues[idx].Pop();
+  }
+
+  if (!job) {
+    // Steal from neighbors, starting with the next queue over.
+    U32 start = (idx >= 0) ? static_cast<U32>(idx) + 1 : 0;
+    for (U32 i = 0; i < m_QueueCount && !job; ++i) {
+      U32 victim = (start + i) % m_QueueCount;
+      if (static_cast<I32>(victim) == idx) continue;
+      job = m_Queues[victim].Steal();
+    }
+  }
+
+  if (!job) {
+    std::lock_guard<std::mutex> lck(m_SharedMutex);
+    if (!m_SharedJobs.empty()) {
+      job = m_SharedJobs.front();
+      m_SharedJobs.pop();
+    }
+  }
+
+  if (job) {
+    m_QueuedJobCount.fetch_sub(1);
+  }
+  return job;
+}
+
+
+B32 ThreadPool::RunPendingJob()
+{
+  I32 idx = (tThreadPool == this) ? tThreadIndex : -1;
+  ThreadJob* job = FindJob(idx);
+  if (!job) return false;
+  Execute(job);
+  return true;
+}
+
+
+void ThreadPool::Schedule(ThreadJob* job)
+{
+  B32 pushed = false;
+  if (tThreadPool == this && tThreadIndex >= 0) {
+    pushed = m_Queues[tThreadIndex].Push(job);
+  }
+
+  if (!pushed) {
+    std::lock_guard<std::mutex> lck(m_SharedMutex);
+    m_SharedJobs.push(job);
+  }
+
+  m_QueuedJobCount.fetch_add(1);
+  if (m_SleepingThreadCount.load() > 0) {
+    {
+      std::lock_guard<std::mutex> lck(m_ParkMutex);
+    }
+    m_ParkCond.notify_one();
+  }
+}
+
+
+void ThreadPool::Execute(ThreadJob* job)
+{
+  if (job->Work) { job->Work(); }
+
+  if (job->Counter) {
+    SignalCounter(job->Counter);
+  }
+
+  delete job;
+
+  if (m_CurrentTaskCount.fetch_sub(1) == 1) {
+    WakeAll();
+  }
+}
+
+
+void ThreadPool::SignalCounter(JobCounter* counter)
+{
+  std::vector<ThreadJob*> released;
+  B32 done = false;
+  {
+    std::lock_guard<std::mutex> lck(counter->m_WaitMutex);
+    if (counter->m_Count.fetch_sub(1) == 1) {
+      done = true;
+      released.swap(counter->m_Waiting);
+    }
+  }
+
+  // Counter must not be touched beyond this point, the waiting thread may
+  // have already released it. Released jobs may still be waiting on other counters.
+  for (ThreadJob* job : released) {
+    Submit(job);
+  }
+
+  if (done) {
+    WakeAll();
+  }
+}
+
+
+void ThreadPool::Submit(ThreadJob* job)
+{
+  while (job->NextDependency < job->Dependencies.size()) {
+    JobCounter* dependency = job->Dependencies[job->NextDependency++];
+    std::lock_guard<std::mutex> lck(dependency->m_WaitMutex);
+    if (dependency->m_Count.load() > 0) {
+      dependency->m_Waiting.push_back(job);
+      return;
+    }
+  }
+
+  Schedule(job);
+}
+
+
+void ThreadPool::AddTask(thr_work_func_t func, JobCounter* counter, JobCounter* dependency)
+{
+  AddTask(func, counter, &dependency, dependency ? 1 : 0);
+}
+
+
+void ThreadPool::AddTask(thr_work_func_t func, JobCounter* counter, 
+                         JobCounter* const* dependencies, U32 dependencyCount)
+{
+  ThreadJob* job = new ThreadJob();
+  job->Work = func;
+  job->Counter = counter;
+  job->NextDependency = 0;
+  if (dependencyCount > 0) {
+    job->Dependencies.assign(dependencies, dependencies + dependencyCount);
+  }
+
+  if (counter) {
+    counter->m_Count.fetch_add(1);
+  }
+  m_CurrentTaskCount.fetch_add(1);
+
+  Submit(job);
+}
+
+
+void ThreadPool::ParallelFor(U32 count, U32 batchSize, thr_range_func_t func,
+                             JobCounter* counter, JobCounter* dependency)
+{
+  if (count == 0) return;
+  if (batchSize == 0) {
+    batchSize = (count + m_QueueCount - 1) / m_QueueCount;
+  }
+
+  for (U32 start = 0; start < count; start += batchSize) {
+    U32 end = (start + batchSize) < count ? (start + batchSize) : count;
+    AddTask([func, start, end] () -> void { func(start, end); }, counter, dependency);
+  }
+}
+
+
+void ThreadPool::WaitAll()
+{
+  // Help out with any pending work. Sleep if there is nothing we can take on, as
+  // remaining jobs are either running on other threads, or held back by dependencies.
+  while (m_CurrentTaskCount.load() > 0) {
+    if (RunPendingJob()) continue;
+    Park([this] () -> B32 {
+      return m_CurrentTaskCount.load() == 0 || m_QueuedJobCount.load() > 0;
+    });
   }
   R_DEBUG(rVerbose, "Thread sync complete.\n");
 }
 
 
-void ThreadPool::AddTask(thr_work_func_t func)
+void ThreadPool::WaitForCounter(JobCounter* counter)
+{
+  R_ASSERT(counter, "Null counter passed to WaitForCounter!\n");
+  while (!counter->IsDone()) {
+    if (RunPendingJob()) continue;
+    Park([this, counter] () -> B32 {
+      return counter->IsDone() || m_QueuedJobCount.load() > 0;
+    });
+  }
+
+  // Make sure the signaling thread is done with the counter before handing it back.
+  std::lock_guard<std::mutex> lck(counter->m_WaitMutex);
+}
+
+
+void ThreadPool::BeginExternalWork(JobCounter* counter)
 {
-  ThreadJob job;
-  job.CurrThreadId = 0;
-  job.Result = ThrResultIncomplete;
-  job.Work = func;
+  R_ASSERT(counter, "Null counter passed to BeginExternalWork!\n");
+  counter->m_Count.fetch_add(1);
+}
+
 
-  m_ThreadJobs.push(job);
+void ThreadPool::EndExternalWork(JobCounter* counter)
+{
+  R_ASSERT(counter, "Null counter passed to EndExternalWork!\n");
+  SignalCounter(counter);
+}
+
+
+B8 ThreadPool::AllDone() const
+{
+  return m_CurrentTaskCount.load() == 0;
 }
 
 
 void ThreadPool::StopAll()
 {
+  if (m_SignalStop) return;
   m_SignalStop = true;
+  WakeAll();
   for (size_t i = 0; i < m_ThreadWorkers.size(); ++i) {
-    m_ThreadWorkers[i].Join();
+    if (m_ThreadWorkers[i].Joinable()) {
+      m_ThreadWorkers[i].Join();
+    }
   }
+  ClearTasks();
+  tThreadIndex = -1;
+  tThreadPool = nullptr;
 }
 
 
 void ThreadPool::ClearTasks()
 {
-  while (!m_ThreadJobs.empty()) {
-    m_ThreadJobs.pop();
+  // Discarded jobs are treated as complete, so that no one is left waiting on them.
+  ThreadJob* job = nullptr;
+  while ((job = FindJob(-1)) != nullptr) {
+    job->Work = nullptr;
+    Execute(job);
   }
 }
-} // Recluse
\ No newline at end of file
+} // Recluse
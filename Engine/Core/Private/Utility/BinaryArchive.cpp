@@ -0,0 +1,370 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Utility/BinaryArchive.hpp"
+#include "Utility/Compression.hpp"
+#include "Logging/Log.hpp"
+#include "Exception.hpp"
+
+#include <cstring>
+#include <new>
+
+
+namespace Recluse {
+
+
+enum ArchiveChunkFlags {
+  ARCHIVE_CHUNK_COMPRESSED = (1 << 0)
+};
+
+
+struct ArchiveHeader {
+  U32   _magic;
+  U16   _version;
+  U16   _flags;
+  U32   _chunkCount;
+  U32   _reserved;
+  U64   _chunkTableOffset;
+};
+
+
+static size_t AlignUp(size_t value, size_t align)
+{
+  return (value + (align - 1)) & ~(align - 1);
+}
+
+
+BinaryArchive::BinaryArchive()
+  : m_mode(ARCHIVE_MODE_READ)
+  , m_failed(false)
+  , m_pFile(nullptr)
+  , m_chunkOpen(false)
+  , m_fileOffset(0)
+  , m_pChunk(nullptr)
+  , m_chunkSize(0)
+  , m_cursor(0)
+{
+  m_Opened = false;
+}
+
+
+BinaryArchive::~BinaryArchive()
+{
+  if (Opened()) close();
+}
+
+
+void BinaryArchive::reset()
+{
+  m_failed = false;
+  m_chunks.clear();
+  m_chunkData.clear();
+  m_chunkOpen = false;
+  m_fileOffset = 0;
+  m_decompressed.clear();
+  m_pChunk = nullptr;
+  m_chunkSize = 0;
+  m_cursor = 0;
+}
+
+
+B8 BinaryArchive::Open(const std::string Filename)
+{
+  return Open(Filename, ARCHIVE_MODE_READ);
+}
+
+
+B8 BinaryArchive::Open(const std::string& filename, ArchiveMode mode)
+{
+  if (Opened()) close();
+  reset();
+  m_mode = mode;
+
+  if (mode == ARCHIVE_MODE_WRITE) {
+    m_pFile = fopen(filename.c_str(), "wb");
+    if (!m_pFile) {
+      R_DEBUG(rError, "Failed to open archive for writing: " + filename + "\n");
+      return false;
+    }
+    // Header is rewritten on close, once the chunk table is known.
+    ArchiveHeader header = { };
+    fwrite(&header, sizeof(header), 1, m_pFile);
+    m_fileOffset = sizeof(header);
+  } else {
+    if (!m_mappedFile.open(filename)) {
+      R_DEBUG(rError, "Failed to open archive for reading: " + filename + "\n");
+      return false;
+    }
+    if (!readChunkTable()) {
+      R_DEBUG(rError, "Archive is malformed: " + filename + "\n");
+      m_mappedFile.close();
+      return false;
+    }
+  }
+  return IArchive::Open(filename);
+}
+
+
+B8 BinaryArchive::close()
+{
+  if (!Opened()) return false;
+
+  B32 success = !m_failed;
+  if (m_mode == ARCHIVE_MODE_WRITE) {
+    if (m_chunkOpen) endChunk();
+
+    ArchiveHeader header = { };
+    header._magic = kMagic;
+    header._version = kFormatVersion;
+    header._chunkCount = static_cast<U32>(m_chunks.size());
+    header._chunkTableOffset = m_fileOffset;
+    if (!m_chunks.empty()) {
+      fwrite(m_chunks.data(), sizeof(ChunkEntry), m_chunks.size(), m_pFile);
+    }
+    fseek(m_pFile, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, m_pFile);
+    success = success && !ferror(m_pFile);
+    fclose(m_pFile);
+    m_pFile = nullptr;
+  } else {
+    m_mappedFile.close();
+  }
+
+  reset();
+  IArchive::close();
+  return success;
+}
+
+
+B32 BinaryArchive::readChunkTable()
+{
+  const U8* data = m_mappedFile.data();
+  size_t size = m_mappedFile.size();
+  if (size < sizeof(ArchiveHeader)) return false;
+
+  ArchiveHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (header._magic != kMagic || header._version > kFormatVersion) return false;
+  if (header._chunkTableOffset > size) return false;
+  if (header._chunkCount > (size - header._chunkTableOffset) / sizeof(ChunkEntry)) return false;
+
+  m_chunks.resize(header._chunkCount);
+  if (header._chunkCount > 0) {
+    memcpy(m_chunks.data(), data + header._chunkTableOffset, sizeof(ChunkEntry) * header._chunkCount);
+  }
+  for (const ChunkEntry& chunk : m_chunks) {
+    if (chunk._offset > size || chunk._storedSize > (size - chunk._offset)) return false;
+    if (!(chunk._flags & ARCHIVE_CHUNK_COMPRESSED) && chunk._storedSize != chunk._size) return false;
+    // Compressed sizes are trusted only as far as the stored bytes can decompress to.
+    if (chunk._size > DecompressBlockBound(static_cast<size_t>(chunk._storedSize))) return false;
+  }
+  m_decompressed.resize(m_chunks.size());
+  return true;
+}
+
+
+void BinaryArchive::beginChunk(U32 id, U32 version, B32 compress)
+{
+  R_ASSERT(m_mode == ARCHIVE_MODE_WRITE, "Archive is not open for writing.\n");
+  if (m_chunkOpen) endChunk();
+  m_currentChunk = { };
+  m_currentChunk._id = id;
+  m_currentChunk._version = version;
+  m_currentChunk._flags = compress ? ARCHIVE_CHUNK_COMPRESSED : 0;
+  m_chunkData.clear();
+  m_chunkOpen = true;
+}
+
+
+void BinaryArchive::endChunk()
+{
+  if (!m_chunkOpen || !m_pFile) return;
+  m_chunkOpen = false;
+
+  // Chunks start aligned, so arrays aligned within a chunk are aligned in the mapped file.
+  static const U8 kPadding[kDataAlignment] = { };
+  size_t padding = AlignUp(static_cast<size_t>(m_fileOffset), kDataAlignment) - static_cast<size_t>(m_fileOffset);
+  fwrite(kPadding, 1, padding, m_pFile);
+  m_fileOffset += padding;
+
+  const U8* stored = m_chunkData.data();
+  size_t storedSize = m_chunkData.size();
+  std::vector<U8> compressed;
+  if (m_currentChunk._flags & ARCHIVE_CHUNK_COMPRESSED) {
+    compressed.resize(CompressBlockBound(m_chunkData.size()));
+    size_t compressedSize = CompressBlock(m_chunkData.data(), m_chunkData.size(),
+      compressed.data(), compressed.size());
+    if (compressedSize > 0 && compressedSize < m_chunkData.size()) {
+      stored = compressed.data();
+      storedSize = compressedSize;
+    } else {
+      m_currentChunk._flags &= ~ARCHIVE_CHUNK_COMPRESSED;
+    }
+  }
+
+  m_currentChunk._offset = m_fileOffset;
+  m_currentChunk._storedSize = storedSize;
+  m_currentChunk._size = m_chunkData.size();
+  if (storedSize > 0 && fwrite(stored, 1, storedSize, m_pFile) != storedSize) {
+    m_failed = true;
+  }
+  m_fileOffset += storedSize;
+  m_chunks.push_back(m_currentChunk);
+  m_chunkData.clear();
+}
+
+
+void BinaryArchive::writeBytes(const void* data, size_t sz)
+{
+  if (m_mode != ARCHIVE_MODE_WRITE) {
+    R_ASSERT(false, "Archive is not open for writing.\n");
+    m_failed = true;
+    return;
+  }
+  if (!m_chunkOpen) beginChunk(kDefaultChunk);
+  const U8* bytes = static_cast<const U8*>(data);
+  m_chunkData.insert(m_chunkData.end(), bytes, bytes + sz);
+}
+
+
+void BinaryArchive::writeArrayHeader(size_t count, size_t align)
+{
+  writeValue(static_cast<U64>(count));
+  if (!m_chunkOpen) return;
+  size_t alignment = align > kDataAlignment ? align : kDataAlignment;
+  m_chunkData.resize(AlignUp(m_chunkData.size(), alignment), 0);
+}
+
+
+B32 BinaryArchive::hasChunk(U32 id) const
+{
+  for (const ChunkEntry& chunk : m_chunks) {
+    if (chunk._id == id) return true;
+  }
+  return false;
+}
+
+
+B32 BinaryArchive::openChunk(U32 id, U32* pVersion)
+{
+  if (m_mode != ARCHIVE_MODE_READ || !Opened()) return false;
+  for (size_t i = 0; i < m_chunks.size(); ++i) {
+    const ChunkEntry& chunk = m_chunks[i];
+    if (chunk._id != id) continue;
+
+    const U8* data = m_mappedFile.data() + chunk._offset;
+    if (chunk._flags & ARCHIVE_CHUNK_COMPRESSED) {
+      if (!m_decompressed[i]) {
+        std::unique_ptr<U8[]> buffer(new (std::nothrow) U8[static_cast<size_t>(chunk._size)]);
+        if (!buffer) {
+          R_DEBUG(rError, "Out of memory decompressing archive chunk.\n");
+          m_failed = true;
+          return false;
+        }
+        if (!DecompressBlock(data, static_cast<size_t>(chunk._storedSize), buffer.get(), static_cast<size_t>(chunk._size))) {
+          R_DEBUG(rError, "Failed to decompress archive chunk.\n");
+          m_failed = true;
+          return false;
+        }
+        m_decompressed[i] = std::move(buffer);
+      }
+      data = m_decompressed[i].get();
+    }
+
+    m_pChunk = data;
+    m_chunkSize = static_cast<size_t>(chunk._size);
+    m_cursor = 0;
+    if (pVersion) *pVersion = chunk._version;
+    return true;
+  }
+  return false;
+}
+
+
+const U8* BinaryArchive::readView(size_t sz)
+{
+  if (!m_pChunk && !openChunk(kDefaultChunk)) {
+    m_failed = true;
+    return nullptr;
+  }
+  if (sz > remaining()) {
+    m_failed = true;
+    return nullptr;
+  }
+  const U8* view = m_pChunk + m_cursor;
+  m_cursor += sz;
+  return view;
+}
+
+
+B32 BinaryArchive::readBytes(void* data, size_t sz)
+{
+  const U8* view = readView(sz);
+  if (!view) {
+    memset(data, 0, sz);
+    return false;
+  }
+  memcpy(data, view, sz);
+  return true;
+}
+
+
+size_t BinaryArchive::readArrayHeader(size_t align)
+{
+  U64 count = 0;
+  readValue(count);
+  if (!m_pChunk) return 0;
+  size_t alignment = align > kDataAlignment ? align : kDataAlignment;
+  size_t aligned = AlignUp(m_cursor, alignment);
+  if (aligned > m_chunkSize) {
+    m_failed = true;
+    return 0;
+  }
+  m_cursor = aligned;
+  return static_cast<size_t>(count);
+}
+
+
+IArchive& BinaryArchive::operator<<(U8 Val) { writeValue(Val); return (*this); }
+IArchive& BinaryArchive::operator<<(I8 Val) { writeValue(Val); return (*this); }
+IArchive& BinaryArchive::operator<<(U16 Val) { writeValue(Val); return (*this); }
+IArchive& BinaryArchive::operator<<(I16 Val) { writeValue(Val); return (*this); }
+IArchive& BinaryArchive::operator<<(U32 Val) { writeValue(Val); return (*this); }
+IArchive& BinaryArchive::operator<<(I32 Val) { writeValue(Val); return (*this); }
+IArchive& BinaryArchive::operator<<(U64 Val) { writeValue(Val); return (*this); }
+IArchive& BinaryArchive::operator<<(I64 Val) { writeValue(Val); return (*this); }
+IArchive& BinaryArchive::operator<<(R32 Val) { writeValue(Val); return (*this); }
+IArchive& BinaryArchive::operator<<(R64 Val) { writeValue(Val); return (*this); }
+
+
+IArchive& BinaryArchive::operator<<(std::string Val)
+{
+  writeValue(static_cast<U32>(Val.size()));
+  writeBytes(Val.data(), Val.size());
+  return (*this);
+}
+
+
+IArchive& BinaryArchive::operator>>(U8& Val) { readValue(Val); return (*this); }
+IArchive& BinaryArchive::operator>>(I8& Val) { readValue(Val); return (*this); }
+IArchive& BinaryArchive::operator>>(U16& Val) { readValue(Val); return (*this); }
+IArchive& BinaryArchive::operator>>(I16& Val) { readValue(Val); return (*this); }
+IArchive& BinaryArchive::operator>>(U32& Val) { readValue(Val); return (*this); }
+IArchive& BinaryArchive::operator>>(I32& Val) { readValue(Val); return (*this); }
+IArchive& BinaryArchive::operator>>(U64& Val) { readValue(Val); return (*this); }
+IArchive& BinaryArchive::operator>>(I64& Val) { readValue(Val); return (*this); }
+IArchive& BinaryArchive::operator>>(R32& Val) { readValue(Val); return (*this); }
+IArchive& BinaryArchive::operator>>(R64& Val) { readValue(Val); return (*this); }
+
+
+IArchive& BinaryArchive::operator>>(std::string& Val)
+{
+  U32 len = 0;
+  readValue(len);
+  const U8* view = readView(len);
+  if (view) {
+    Val.assign(reinterpret_cast<const char*>(view), len);
+  } else {
+    Val.clear();
+  }
+  return (*this);
+}
+} // Recluse
@@ -0,0 +1,191 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Utility/Compression.hpp"
+
+#include <cstring>
+#include <vector>
+
+
+namespace Recluse {
+
+
+static const U32    kMinMatch = 4;
+// The last match must start at least this many bytes from the end of the input.
+static const size_t kMatchFindLimit = 12;
+// The last bytes of the input are always literals.
+static const size_t kLastLiterals = 5;
+static const size_t kMaxOffset = 65535;
+static const U32    kHashLog = 14;
+
+
+static inline U32 Read32(const U8* p)
+{
+  U32 v;
+  memcpy(&v, p, sizeof(U32));
+  return v;
+}
+
+
+static inline U32 HashSequence(U32 sequence)
+{
+  return (sequence * 2654435761u) >> (32 - kHashLog);
+}
+
+
+// Write a length that overflowed its token nibble.
+static inline U8* WriteLength(U8* op, U8* opEnd, size_t len)
+{
+  while (len >= 255) {
+    if (op >= opEnd) return nullptr;
+    *op++ = 255;
+    len -= 255;
+  }
+  if (op >= opEnd) return nullptr;
+  *op++ = static_cast<U8>(len);
+  return op;
+}
+
+
+// Emit one sequence of literals, followed by a match if matchLen is not zero.
+static U8* WriteSequence(U8* op, U8* opEnd, const U8* literals, size_t literalLen,
+  size_t offset, size_t matchLen)
+{
+  if (op >= opEnd) return nullptr;
+  U8* token = op++;
+  *token = static_cast<U8>((literalLen >= 15 ? 15 : literalLen) << 4);
+  if (literalLen >= 15) {
+    op = WriteLength(op, opEnd, literalLen - 15);
+    if (!op) return nullptr;
+  }
+  if (static_cast<size_t>(opEnd - op) < literalLen) return nullptr;
+  if (literalLen > 0) memcpy(op, literals, literalLen);
+  op += literalLen;
+
+  if (matchLen == 0) return op;
+
+  if ((opEnd - op) < 2) return nullptr;
+  *op++ = static_cast<U8>(offset & 0xff);
+  *op++ = static_cast<U8>(offset >> 8);
+  size_t len = matchLen - kMinMatch;
+  *token |= static_cast<U8>(len >= 15 ? 15 : len);
+  if (len >= 15) {
+    op = WriteLength(op, opEnd, len - 15);
+  }
+  return op;
+}
+
+
+size_t CompressBlockBound(size_t srcSize)
+{
+  return srcSize + (srcSize / 255) + 16;
+}
+
+
+size_t DecompressBlockBound(size_t srcSize)
+{
+  const size_t kMaxRatio = 255;
+  if (srcSize > ~static_cast<size_t>(0) / kMaxRatio) return ~static_cast<size_t>(0);
+  return srcSize * kMaxRatio;
+}
+
+
+size_t CompressBlock(const void* src, size_t srcSize, void* dst, size_t dstCapacity)
+{
+  const U8* input = static_cast<const U8*>(src);
+  U8* op = static_cast<U8*>(dst);
+  U8* opEnd = op + dstCapacity;
+  const U8* anchor = input;
+
+  if (srcSize > kMatchFindLimit) {
+    // Positions are stored off by one, so zero means empty.
+    std::vector<U32> table(size_t(1) << kHashLog, 0);
+    const U8* ip = input;
+    const U8* matchFindEnd = input + srcSize - kMatchFindLimit;
+    const U8* matchEnd = input + srcSize - kLastLiterals;
+
+    while (ip < matchFindEnd) {
+      U32 sequence = Read32(ip);
+      U32 h = HashSequence(sequence);
+      U32 candidate = table[h];
+      table[h] = static_cast<U32>(ip - input) + 1;
+
+      if (candidate == 0) { ip++; continue; }
+      const U8* ref = input + (candidate - 1);
+      if (static_cast<size_t>(ip - ref) > kMaxOffset || Read32(ref) != sequence) { ip++; continue; }
+
+      // Extend backwards over literals, then forwards.
+      while (ip > anchor && ref > input && ip[-1] == ref[-1]) { ip--; ref--; }
+      size_t matchLen = kMinMatch;
+      while (ip + matchLen < matchEnd && ip[matchLen] == ref[matchLen]) matchLen++;
+
+      op = WriteSequence(op, opEnd, anchor, static_cast<size_t>(ip - anchor),
+        static_cast<size_t>(ip - ref), matchLen);
+      if (!op) return 0;
+      ip += matchLen;
+      anchor = ip;
+    }
+  }
+
+  op = WriteSequence(op, opEnd, anchor, static_cast<size_t>((input + srcSize) - anchor), 0, 0);
+  if (!op) return 0;
+  return static_cast<size_t>(op - static_cast<U8*>(dst));
+}
+
+
+B32 DecompressBlock(const void* src, size_t srcSize, void* dst, size_t dstSize)
+{
+  const U8* ip = static_cast<const U8*>(src);
+  const U8* ipEnd = ip + srcSize;
+  U8* op = static_cast<U8*>(dst);
+  U8* opStart = op;
+  U8* opEnd = op + dstSize;
+
+  while (ip < ipEnd) {
+    U8 token = *ip++;
+
+    size_t literalLen = token >> 4;
+    if (literalLen == 15) {
+      U8 b;
+      do {
+        if (ip >= ipEnd) return false;
+        b = *ip++;
+        literalLen += b;
+      } while (b == 255);
+    }
+    if (static_cast<size_t>(ipEnd - ip) < literalLen) return false;
+    if (static_cast<size_t>(opEnd - op) < literalLen) return false;
+    if (literalLen > 0) memcpy(op, ip, literalLen);
+    ip += literalLen;
+    op += literalLen;
+
+    // Last sequence has no match.
+    if (ip == ipEnd) break;
+
+    if ((ipEnd - ip) < 2) return false;
+    size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - opStart)) return false;
+
+    size_t matchLen = token & 0xf;
+    if (matchLen == 15) {
+      U8 b;
+      do {
+        if (ip >= ipEnd) return false;
+        b = *ip++;
+        matchLen += b;
+      } while (b == 255);
+    }
+    matchLen += kMinMatch;
+    if (static_cast<size_t>(opEnd - op) < matchLen) return false;
+
+    // Matches may overlap the bytes being written.
+    const U8* ref = op - offset;
+    if (offset >= matchLen) {
+      memcpy(op, ref, matchLen);
+      op += matchLen;
+    } else {
+      for (size_t i = 0; i < matchLen; ++i) *op++ = *ref++;
+    }
+  }
+  return op == opEnd;
+}
+} // Recluse
@@ -38,4 +38,31 @@ B8 Cpu::IsAmd()
 {
   return CheckVendorString("AuthenticAMD");
 }
+
+
+B8 Cpu::HasSSE41()
+{
+  int b[4];
+  __cpuid(b, 1);
+  return (b[2] & (1 << 19)) != 0;
+}
+
+
+B8 Cpu::HasAVX2()
+{
+  int b[4];
+  __cpuid(b, 0);
+  if (b[0] < 7) return false;
+
+  __cpuid(b, 1);
+  B8 fma = (b[2] & (1 << 12)) != 0;
+  B8 osxsave = (b[2] & (1 << 27)) != 0;
+  B8 avx = (b[2] & (1 << 28)) != 0;
+  if (!fma || !osxsave || !avx) return false;
+  // Os must save xmm and ymm state on context switches.
+  if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+  __cpuidex(b, 7, 0);
+  return (b[1] & (1 << 5)) != 0;
+}
 } // Recluse
\ No newline at end of file
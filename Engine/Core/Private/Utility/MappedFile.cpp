@@ -0,0 +1,132 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Utility/MappedFile.hpp"
+#include "Logging/Log.hpp"
+#include "Exception.hpp"
+
+#if defined(_WIN32)
+ #define WIN32_LEAN_AND_MEAN
+ #include <Windows.h>
+#else
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+
+namespace Recluse {
+
+
+MappedFile::MappedFile()
+  : m_pData(nullptr)
+  , m_size(0)
+  , m_opened(false)
+#if defined(_WIN32)
+  , m_hFile(nullptr)
+  , m_hMapping(nullptr)
+#else
+  , m_fd(-1)
+#endif
+{
+}
+
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+
+#if defined(_WIN32)
+B32 MappedFile::open(const std::string& path)
+{
+  close();
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    R_DEBUG(rWarning, "Failed to open file for mapping: " + path + "\n");
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  m_hFile = file;
+  m_size = static_cast<size_t>(size.QuadPart);
+  m_opened = true;
+  // Empty files can not be mapped.
+  if (m_size == 0) return true;
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    close();
+    return false;
+  }
+  m_hMapping = mapping;
+  m_pData = static_cast<const U8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!m_pData) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+
+void MappedFile::close()
+{
+  if (m_pData) UnmapViewOfFile(m_pData);
+  if (m_hMapping) CloseHandle(static_cast<HANDLE>(m_hMapping));
+  if (m_hFile) CloseHandle(static_cast<HANDLE>(m_hFile));
+  m_pData = nullptr;
+  m_hMapping = nullptr;
+  m_hFile = nullptr;
+  m_size = 0;
+  m_opened = false;
+}
+#else
+B32 MappedFile::open(const std::string& path)
+{
+  close();
+  I32 fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    R_DEBUG(rWarning, "Failed to open file for mapping: " + path + "\n");
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  m_fd = fd;
+  m_size = static_cast<size_t>(st.st_size);
+  m_opened = true;
+  // Empty files can not be mapped.
+  if (m_size == 0) return true;
+
+  void* ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (ptr == MAP_FAILED) {
+    close();
+    return false;
+  }
+  madvise(ptr, m_size, MADV_SEQUENTIAL);
+  m_pData = static_cast<const U8*>(ptr);
+  return true;
+}
+
+
+void MappedFile::close()
+{
+  if (m_pData) munmap(const_cast<U8*>(m_pData), m_size);
+  if (m_fd >= 0) ::close(m_fd);
+  m_pData = nullptr;
+  m_fd = -1;
+  m_size = 0;
+  m_opened = false;
+}
+#endif
+} // Recluse
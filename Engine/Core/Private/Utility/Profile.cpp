@@ -5,47 +5,470 @@
 
 #include "Exception.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
-#include <mutex>
+
+#if defined(_MSC_VER)
+ #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+ #define R_PROFILE_USE_TSC 1
+#else
+ #define R_PROFILE_USE_TSC 0
+#endif
 
 namespace Recluse {
 
-// Profile data stored by profile. getData is overwritten when tags are re entered.
-// Determined by profile type.
-std::unordered_map<ProfileTypes, 
-  std::unordered_map<std::string, ProfileData > > kProfileDataMap;
-std::thread     kProfileThreadHandle;
-std::mutex      kProfileMapMutex;
 
+// Events recorded by a single thread. Only the owning thread writes, and publishes each event
+// by bumping _head. Readers copy events behind _head, and throw away any that were
+// overwritten while copying.
+struct ProfileThreadBuffer {
+  ProfileEvent            _events[Profiler::kMaxEventsPerThread];
+  std::atomic<U64>        _head;
+  U32                     _threadId;
+  U16                     _depth;
+  std::mutex              _nameMutex;
+  std::string             _name;
+};
+
+
+static U64 ReadClockNanoseconds()
+{
+  return static_cast<U64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
+static U64 ReadTicks()
+{
+#if R_PROFILE_USE_TSC
+  return static_cast<U64>(__rdtsc());
+#else
+  return ReadClockNanoseconds();
+#endif
+}
+
+
+// Reference points for converting ticks to time. The tick rate is measured against the
+// steady clock over the whole run, instead of spinning to calibrate on start up.
+static const U64                  kBaseTicks = ReadTicks();
+static const U64                  kBaseNs = ReadClockNanoseconds();
+
+static std::atomic<B32>           kProfilerEnabled(true);
+static std::atomic<ProfileThreadBuffer*> kThreadBuffers[Profiler::kMaxThreads];
+static std::atomic<U32>           kThreadBufferCount(0);
+thread_local ProfileThreadBuffer* tThreadBuffer = nullptr;
+thread_local B32                  tThreadBufferFailed = false;
+
+static std::mutex                         kTagMutex;
+static std::unordered_map<std::string, U32> kTagIds;
+static std::vector<std::string>           kTagNames;
+
+static std::mutex                 kFrameMutex;
+static ProfileFrame               kFrames[Profiler::kMaxFrameHistory];
+static U64                        kFrameCount = 0;
+static U64                        kFrameStart = kBaseTicks;
+
+// Storage for GetProfileData().
+static std::mutex                 kSummaryMutex;
+static ProfileData                kSummary;
+
+
+static ProfileThreadBuffer* GetThreadBuffer()
+{
+  if (tThreadBuffer || tThreadBufferFailed) return tThreadBuffer;
+
+  U32 idx = kThreadBufferCount.fetch_add(1);
+  if (idx >= Profiler::kMaxThreads) {
+    R_DEBUG(rWarning, "Profiler: Too many threads, events of this thread are dropped.\n");
+    tThreadBufferFailed = true;
+    return nullptr;
+  }
+
+  // Buffers are kept until the application exits, so events of finished threads can still be
+  // exported.
+  ProfileThreadBuffer* buffer = new ProfileThreadBuffer();
+  buffer->_head.store(0, std::memory_order_relaxed);
+  buffer->_threadId = idx;
+  buffer->_depth = 0;
+  I32 poolIdx = ThreadPool::GetCurrentThreadIndex();
+  buffer->_name = (poolIdx >= 0) ? "Worker " + std::to_string(poolIdx) : "Thread " + std::to_string(idx);
+  kThreadBuffers[idx].store(buffer, std::memory_order_release);
+  tThreadBuffer = buffer;
+  return buffer;
+}
+
+
+static void PushEvent(ProfileThreadBuffer* buffer, const ProfileEvent& evt)
+{
+  U64 head = buffer->_head.load(std::memory_order_relaxed);
+  buffer->_events[head & (Profiler::kMaxEventsPerThread - 1)] = evt;
+  buffer->_head.store(head + 1, std::memory_order_release);
+}
+
+
+// Copy events recorded by the buffer, oldest first.
+static void CopyEvents(ProfileThreadBuffer* buffer, std::vector<ProfileEvent>& out)
+{
+  const U64 capacity = Profiler::kMaxEventsPerThread;
+  U64 head = buffer->_head.load(std::memory_order_acquire);
+  U64 first = (head > capacity) ? head - capacity : 0;
+  size_t offset = out.size();
+  for (U64 i = first; i < head; ++i) {
+    out.push_back(buffer->_events[i & (capacity - 1)]);
+  }
+
+  // Drop events the owning thread overwrote while they were being copied, along with the slot 
+  // it may be writing at newHead, which holds the oldest event still in the buffer.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  U64 newHead = buffer->_head.load(std::memory_order_relaxed);
+  U64 newFirst = (newHead + 1 > capacity) ? newHead + 1 - capacity : 0;
+  if (newFirst > first) {
+    size_t overwritten = static_cast<size_t>(newFirst - first);
+    if (overwritten > (out.size() - offset)) overwritten = out.size() - offset;
+    out.erase(out.begin() + offset, out.begin() + offset + overwritten);
+  }
+}
+
+
+static R64 NanosecondsPerTick()
+{
+#if R_PROFILE_USE_TSC
+  U64 ticks = ReadTicks() - kBaseTicks;
+  U64 ns = ReadClockNanoseconds() - kBaseNs;
+  if (ticks == 0 || ns == 0) return 1.0;
+  return static_cast<R64>(ns) / static_cast<R64>(ticks);
+#else
+  return 1.0;
+#endif
+}
+
+
+static R64 ToNanoseconds(U64 ticks, R64 nsPerTick)
+{
+  I64 delta = static_cast<I64>(ticks - kBaseTicks);
+  return static_cast<R64>(delta) * nsPerTick;
+}
+
+
+static void WriteEscaped(FILE* file, const std::string& str)
+{
+  for (char c : str) {
+    switch (c) {
+      case '"': fputs("\\\"", file); break;
+      case '\\': fputs("\\\\", file); break;
+      case '\n': fputs("\\n", file); break;
+      case '\t': fputs("\\t", file); break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          fprintf(file, "\\u%04x", c);
+        } else {
+          fputc(c, file);
+        }
+    }
+  }
+}
+
+
+static const char* GetTypeName(U8 type)
+{
+  switch (type) {
+    case PROFILE_TYPES_NORMAL: return "Normal";
+    case PROFILE_TYPES_DEBUG: return "Debug";
+    case PROFILE_TYPES_ENGINE: return "Engine";
+    case PROFILE_TYPES_RENDERER: return "Renderer";
+    case PROFILE_TYPES_PHYSICS: return "Physics";
+    case PROFILE_TYPES_AUDIO: return "Audio";
+    case PROFILE_TYPES_GAME: return "Game";
+    case PROFILE_TYPES_FILESYSTEM: return "Filesystem";
+    case PROFILE_TYPES_UI: return "UI";
+    default: return "None";
+  }
+}
+
+
+U32 Profiler::InternTag(const std::string& tag)
+{
+  std::lock_guard<std::mutex> lck(kTagMutex);
+  auto it = kTagIds.find(tag);
+  if (it != kTagIds.end()) return it->second;
+  U32 id = static_cast<U32>(kTagNames.size());
+  kTagNames.push_back(tag);
+  kTagIds[tag] = id;
+  return id;
+}
+
+
+std::string Profiler::GetTagName(U32 tagId)
+{
+  std::lock_guard<std::mutex> lck(kTagMutex);
+  if (tagId >= kTagNames.size()) return "";
+  return kTagNames[tagId];
+}
+
+
+U64 Profiler::Now()
+{
+  return ReadTicks();
+}
 
 
-void Profiler::StoreTimed(ProfileData& obj, const std::string& tag)
+R64 Profiler::TicksToNanoseconds(U64 ticks)
 {
-  std::lock_guard<std::mutex> lck(kProfileMapMutex);
-  kProfileDataMap[obj._type][tag] = std::move(obj);
+  return ToNanoseconds(ticks, NanosecondsPerTick());
 }
 
 
-ProfileData* GetProfileData(ProfileTypes type, const std::string& tag)
+void Profiler::SetEnabled(B32 enable)
 {
-  ProfileData* profile = nullptr;
-  auto it = kProfileDataMap.find(type);
-  if (it == kProfileDataMap.end()) return profile;
-  auto it2 = it->second.find(tag);
-  if (it2 == it->second.end()) return profile;
-  profile = &it2->second;
-  return profile;
+  kProfilerEnabled.store(enable, std::memory_order_relaxed);
+}
+
+
+B32 Profiler::IsEnabled()
+{
+  return kProfilerEnabled.load(std::memory_order_relaxed);
+}
+
+
+void Profiler::SetThreadName(const std::string& name)
+{
+  ProfileThreadBuffer* buffer = GetThreadBuffer();
+  if (!buffer) return;
+  std::lock_guard<std::mutex> lck(buffer->_nameMutex);
+  buffer->_name = name;
+}
+
+
+void Profiler::BeginScope()
+{
+  ProfileThreadBuffer* buffer = GetThreadBuffer();
+  if (buffer) buffer->_depth++;
+}
+
+
+void Profiler::EndScope(ProfileTypes type, U32 tagId, U64 start)
+{
+  U64 end = ReadTicks();
+  ProfileThreadBuffer* buffer = GetThreadBuffer();
+  if (!buffer) return;
+  buffer->_depth--;
+  ProfileEvent evt;
+  evt._start = start;
+  evt._end = end;
+  evt._tagId = tagId;
+  evt._type = static_cast<U8>(type);
+  evt._kind = PROFILE_EVENT_SCOPE;
+  evt._depth = buffer->_depth;
+  PushEvent(buffer, evt);
+}
+
+
+void Profiler::RecordCounter(ProfileTypes type, U32 tagId, R64 value)
+{
+  ProfileThreadBuffer* buffer = GetThreadBuffer();
+  if (!buffer) return;
+  ProfileEvent evt;
+  evt._start = ReadTicks();
+  evt._value = value;
+  evt._tagId = tagId;
+  evt._type = static_cast<U8>(type);
+  evt._kind = PROFILE_EVENT_COUNTER;
+  evt._depth = buffer->_depth;
+  PushEvent(buffer, evt);
+}
+
+
+void Profiler::EndFrame()
+{
+  U64 now = ReadTicks();
+  std::lock_guard<std::mutex> lck(kFrameMutex);
+  ProfileFrame& frame = kFrames[kFrameCount % kMaxFrameHistory];
+  frame._index = kFrameCount;
+  frame._start = kFrameStart;
+  frame._end = now;
+  kFrameStart = now;
+  kFrameCount++;
+}
+
+
+U32 Profiler::GetFrameHistory(ProfileFrame* pOut, U32 maxCount)
+{
+  std::lock_guard<std::mutex> lck(kFrameMutex);
+  U64 count = kFrameCount < kMaxFrameHistory ? kFrameCount : kMaxFrameHistory;
+  if (count > maxCount) count = maxCount;
+  for (U64 i = 0; i < count; ++i) {
+    pOut[i] = kFrames[(kFrameCount - count + i) % kMaxFrameHistory];
+  }
+  return static_cast<U32>(count);
+}
+
+
+B32 Profiler::ExportChromeTrace(const std::string& path, U32 frameCount)
+{
+  std::vector<ProfileFrame> frames(kMaxFrameHistory);
+  frames.resize(GetFrameHistory(frames.data(), kMaxFrameHistory));
+  U64 minTicks = 0;
+  if (frameCount > 0 && !frames.empty()) {
+    size_t first = (frameCount < frames.size()) ? frames.size() - frameCount : 0;
+    frames.erase(frames.begin(), frames.begin() + first);
+    minTicks = frames.front()._start;
+  }
+
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file) {
+    R_DEBUG(rError, "Profiler: Failed to open trace file for writing.\n");
+    return false;
+  }
+
+  std::vector<std::string> tags;
+  {
+    std::lock_guard<std::mutex> lck(kTagMutex);
+    tags = kTagNames;
+  }
+
+  R64 nsPerTick = NanosecondsPerTick();
+  const U32 pid = 1;
+  // Frames are shown on their own track, after all threads.
+  const U32 frameTid = kMaxThreads;
+  B32 first = true;
+  auto separator = [&] () -> void {
+    fputs(first ? "\n" : ",\n", file);
+    first = false;
+  };
+
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+
+  U32 threadCount = kThreadBufferCount.load(std::memory_order_acquire);
+  if (threadCount > kMaxThreads) threadCount = kMaxThreads;
+  std::vector<ProfileEvent> events;
+  for (U32 t = 0; t < threadCount; ++t) {
+    ProfileThreadBuffer* buffer = kThreadBuffers[t].load(std::memory_order_acquire);
+    if (!buffer) continue;
+
+    std::string name;
+    {
+      std::lock_guard<std::mutex> lck(buffer->_nameMutex);
+      name = buffer->_name;
+    }
+    separator();
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"", pid, t);
+    WriteEscaped(file, name);
+    fputs("\"}}", file);
+
+    events.clear();
+    CopyEvents(buffer, events);
+    for (const ProfileEvent& evt : events) {
+      if (evt._start < minTicks) continue;
+      const std::string& tag = (evt._tagId < tags.size()) ? tags[evt._tagId] : std::string();
+      R64 ts = ToNanoseconds(evt._start, nsPerTick) / 1000.0;
+      separator();
+      if (evt._kind == PROFILE_EVENT_COUNTER) {
+        fputs("{\"name\":\"", file);
+        WriteEscaped(file, tag);
+        fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u,\"args\":{\"value\":%.6g}}",
+          GetTypeName(evt._type), ts, pid, t, evt._value);
+      } else {
+        R64 dur = static_cast<R64>(evt._end - evt._start) * nsPerTick / 1000.0;
+        fputs("{\"name\":\"", file);
+        WriteEscaped(file, tag);
+        fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u}",
+          GetTypeName(evt._type), ts, dur, pid, t);
+      }
+    }
+  }
+
+  separator();
+  fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"Frames\"}}", pid, frameTid);
+  for (const ProfileFrame& frame : frames) {
+    R64 ts = ToNanoseconds(frame._start, nsPerTick) / 1000.0;
+    R64 dur = static_cast<R64>(frame._end - frame._start) * nsPerTick / 1000.0;
+    separator();
+    fprintf(file, "{\"name\":\"Frame %llu\",\"cat\":\"Frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u}",
+      static_cast<unsigned long long>(frame._index), ts, dur, pid, frameTid);
+  }
+
+  fputs("\n]}\n", file);
+  B32 success = !ferror(file);
+  fclose(file);
+  return success;
+}
+
+
+// Collect the latest sample of each scope of a type, keyed by tag id.
+static void CollectLatest(ProfileTypes type, U32 tagId, std::unordered_map<U32, ProfileEvent>& latest)
+{
+  U32 threadCount = kThreadBufferCount.load(std::memory_order_acquire);
+  if (threadCount > Profiler::kMaxThreads) threadCount = Profiler::kMaxThreads;
+  std::vector<ProfileEvent> events;
+  for (U32 t = 0; t < threadCount; ++t) {
+    ProfileThreadBuffer* buffer = kThreadBuffers[t].load(std::memory_order_acquire);
+    if (!buffer) continue;
+    events.clear();
+    CopyEvents(buffer, events);
+    for (const ProfileEvent& evt : events) {
+      if (evt._kind != PROFILE_EVENT_SCOPE || evt._type != type) continue;
+      if (tagId != Profiler::kInvalidTag && evt._tagId != tagId) continue;
+      auto it = latest.find(evt._tagId);
+      if (it == latest.end() || it->second._end < evt._end) {
+        latest[evt._tagId] = evt;
+      }
+    }
+  }
+}
+
+
+static ProfileData ToProfileData(const ProfileEvent& evt, const std::string& tag, R64 nsPerTick)
+{
+  ProfileData data;
+  data._tag = tag;
+  data._type = static_cast<ProfileTypes>(evt._type);
+  data._start = static_cast<R32>(ToNanoseconds(evt._start, nsPerTick) * 1e-9);
+  data._end = static_cast<R32>(ToNanoseconds(evt._end, nsPerTick) * 1e-9);
+  data._total = static_cast<R32>(static_cast<R64>(evt._end - evt._start) * nsPerTick * 1e-9);
+  return data;
+}
+
+
+ProfileData* Profiler::GetProfileData(ProfileTypes type, const std::string& tag)
+{
+  U32 tagId = kInvalidTag;
+  {
+    std::lock_guard<std::mutex> lck(kTagMutex);
+    auto it = kTagIds.find(tag);
+    if (it == kTagIds.end()) return nullptr;
+    tagId = it->second;
+  }
+
+  std::unordered_map<U32, ProfileEvent> latest;
+  CollectLatest(type, tagId, latest);
+  if (latest.empty()) return nullptr;
+
+  std::lock_guard<std::mutex> lck(kSummaryMutex);
+  kSummary = ToProfileData(latest.begin()->second, tag, NanosecondsPerTick());
+  return &kSummary;
 }
 
 
 std::vector<ProfileData> Profiler::GetAll(ProfileTypes type)
 {
+  std::unordered_map<U32, ProfileEvent> latest;
+  CollectLatest(type, kInvalidTag, latest);
+
   std::vector<ProfileData> data;
-  auto& map = kProfileDataMap[type];
-  for (auto d : map) {
-    data.push_back(d.second);
+  data.reserve(latest.size());
+  R64 nsPerTick = NanosecondsPerTick();
+  for (auto& it : latest) {
+    data.push_back(ToProfileData(it.second, GetTagName(it.first), nsPerTick));
   }
   return data;
 }
-} // Recluse
\ No newline at end of file
+} // Recluse
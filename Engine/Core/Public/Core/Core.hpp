@@ -6,6 +6,7 @@
 
 #include "Core/Thread/Threading.hpp"
 #include "Core/Thread/CoreThread.hpp"
+#include "Core/Memory/FrameAllocator.hpp"
 
 #include "Core/Utility/Module.hpp"
 #include "Core/Utility/Time.hpp"
@@ -22,15 +23,21 @@ namespace Recluse {
 
 // Ensures the core itself is initialized.
 class Core : public EngineModule<Core> {
+  // Per frame memory of the frame allocator, and number of frames buffered.
+  static const size_t kFrameAllocatorSize = 16 * 1024 * 1024;
+  static const U32    kFrameAllocatorBufferCount = 2;
 public:
+  // Pool is sized to the hardware thread count.
   Core() 
-    : m_Pool(2) { }
+    : m_Pool()
+    , m_pFrameMemory(nullptr) { }
 
 
   void onStartUp() override;
   void onShutDown() override;
 
   ThreadPool&     ThrPool() { return m_Pool; }
+  FrameAllocator& FrameAlloc() { return m_FrameAllocator; }
 
   // Syncronize threads.
   // TODO():
@@ -38,6 +45,8 @@ public:
 
 private:
   ThreadPool      m_Pool;
+  FrameAllocator  m_FrameAllocator;
+  void*           m_pFrameMemory;
 };
 
 
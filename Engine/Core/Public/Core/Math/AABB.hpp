@@ -19,11 +19,16 @@ struct AABB {
 
   B32       overlaps(const AABB& other) const;
 
+  // Checks if the other bounding box lies entirely within this one.
   B32       contains(const AABB& other) const;
   
   // Checks if a point is inside this bounding box.
   B32       inside(const Vector3& p) const;
 
+  // Bounds of this box once transformed by the matrix, rotation included. Centroid is computed,
+  // surface area is left zero.
+  AABB      transform(const Matrix4& mat) const;
+
   // Minimum lower bound of the bounding box.
   Vector3     min;
 
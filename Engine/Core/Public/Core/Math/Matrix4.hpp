@@ -68,6 +68,16 @@ struct Matrix4 {
               row4.x, row4.y, row4.z, row4.w)
   { }
 
+  // Batch multiply, out[i] = lhs[i] * rhs[i]. Output may alias either input.
+  static void             multiplyBatch(Matrix4* out, const Matrix4* lhs, const Matrix4* rhs, size_t count);
+
+  // Batch multiply by one matrix, out[i] = lhs[i] * rhs. Output may alias the input.
+  static void             multiplyBatch(Matrix4* out, const Matrix4* lhs, const Matrix4& rhs, size_t count);
+
+  // Batch transform of points, out[i] = (points[i], 1) * mat, with no perspective divide.
+  // Output may alias the input.
+  static void             transformPoints(Vector3* out, const Vector3* points, const Matrix4& mat, size_t count);
+
   // Retrieve the Perspective matrix, which is in left hand coordinates.
   static Matrix4          perspective(R32 fovy, R32 aspect, R32 zNear, R32 zFar);
 
@@ -23,6 +23,14 @@ struct Quaternion {
 
   static Quaternion angleAxis(const R32 radians, const Vector3& axis);
   static Quaternion slerp(const Quaternion& q0, const Quaternion& q1, const R32 t);
+  // Batch slerp of quaternion pairs with a shared t, which must be within [0, 1]. Inputs 
+  // must be normalized. Output may alias either input.
+  static void       slerpBatch(Quaternion* out, const Quaternion* q0, const Quaternion* q1, const R32 t, size_t count);
+  // Normalized lerp, along the shortest path. Cheaper than slerp, and close to it for the small 
+  // angles between poses being blended.
+  static Quaternion nlerp(const Quaternion& q0, const Quaternion& q1, const R32 t);
+  // Batch nlerp, with a t per pair. Output may alias either input.
+  static void       nlerpBatch(Quaternion* out, const Quaternion* q0, const Quaternion* q1, const R32* t, size_t count);
   static Quaternion eulerAnglesToQuaternion(const Vector3& euler);
   static Quaternion matrix4ToQuaternion(const Matrix4& rot);  
   static Quaternion lookRotation(const Vector3&dir, const Vector3& up);
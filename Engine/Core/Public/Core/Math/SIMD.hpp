@@ -0,0 +1,32 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+
+
+namespace Recluse {
+
+
+// Instruction sets used by the batch math routines (Matrix4::multiplyBatch, 
+// Matrix4::transformPoints, Quaternion::slerpBatch, Quaternion::nlerpBatch). SSE4.1 is compiled 
+// in with the SIMD build option, and AVX2 is selected at runtime when the cpu and os support it.
+enum SIMDInstructionSet {
+  SIMD_SCALAR,
+  SIMD_SSE4_1,
+  SIMD_AVX2
+};
+
+
+// Best instruction set supported by both the build and the running cpu.
+SIMDInstructionSet    getSupportedSIMDInstructionSet();
+
+// Instruction set currently used by the batch math routines. Defaults to the best supported.
+SIMDInstructionSet    getSIMDInstructionSet();
+
+// Override the instruction set used by the batch math routines, clamped to what is supported. 
+// Mainly useful for testing, and benchmarking. Must not be called while batch routines are running
+// on other threads. Returns the instruction set actually selected.
+SIMDInstructionSet    setSIMDInstructionSet(SIMDInstructionSet set);
+
+const TChar*          getSIMDInstructionSetName(SIMDInstructionSet set);
+} // Recluse
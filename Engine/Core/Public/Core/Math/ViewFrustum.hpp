@@ -48,6 +48,14 @@ struct ViewFrustum {
   Result          intersect(const AABB& aabb) const;
 
   // Check if AABB object is inside this frustum.
-  B32          insideFrustum(const AABB& aabb) { return false; }
+  B32          insideFrustum(const AABB& aabb) { return intersect(aabb) == Result_Inside; }
+
+  // Batch cull of boxes against up to 32 frustums at once. Boxes are given as centers and half 
+  // extents, in structure of arrays. Bit i of outMasks[n] is set when box n is not outside of 
+  // frustums[i]. Uses the instruction set selected in SIMD.hpp.
+  static void     cullBatch(const ViewFrustum* const* frustums, U32 frustumCount,
+                            const R32* centerX, const R32* centerY, const R32* centerZ,
+                            const R32* extentX, const R32* extentY, const R32* extentZ,
+                            U32* outMasks, size_t count);
 };
 } // Recluse
\ No newline at end of file
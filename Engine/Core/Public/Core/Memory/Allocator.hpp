@@ -14,7 +14,10 @@ public:
     : m_Memory(memory)
     , m_Size(size)
     , m_Used(0)
+    , m_PeakUsed(0)
     , m_NumAllocations(0) { }
+
+  virtual ~Allocator() { }
   
   virtual void* allocate(size_t size, size_t align) { return nullptr; }
   virtual void  Deallocate(void* ptr) { }
@@ -33,10 +36,37 @@ public:
   size_t        TotalSize() const { return m_Size; }
   size_t        UsedMem() const { return m_Used; }
 
+  // High water mark of used memory.
+  size_t        PeakUsedMem() const { return m_PeakUsed; }
+
+  // Memory available for allocations, and the largest single block of it.
+  virtual size_t FreeMem() const { return m_Size - m_Used; }
+  virtual size_t LargestFreeBlock() const { return FreeMem(); }
+
+  // Fragmentation of free memory. 0 when all free memory is one contiguous block,
+  // approaching 1 as free memory is scattered into small blocks.
+  R32           Fragmentation() const {
+    size_t freeMem = FreeMem();
+    if (freeMem == 0) return 0.0f;
+    return 1.0f - static_cast<R32>(LargestFreeBlock()) / static_cast<R32>(freeMem);
+  }
+
 protected:
+  void          TrackAllocation(size_t sz) {
+    m_Used += sz;
+    m_NumAllocations += 1;
+    if (m_Used > m_PeakUsed) m_PeakUsed = m_Used;
+  }
+
+  void          TrackDeallocation(size_t sz) {
+    m_Used -= sz;
+    m_NumAllocations -= 1;
+  }
+
   void*         m_Memory;
   size_t        m_Size;
   size_t        m_Used;
+  size_t        m_PeakUsed;
   size_t        m_NumAllocations;
 };
 } // Recluse
\ No newline at end of file
@@ -0,0 +1,88 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Allocator.hpp"
+#include "StackAllocator.hpp"
+#include "Core/Types.hpp"
+
+#include <mutex>
+
+
+namespace Recluse {
+
+
+// Multi buffered linear allocator for transient, per frame, data. Each frame allocates
+// from its own StackAllocator, and swap() moves on to the next one, releasing everything
+// allocated there N frames ago in O(1). This keeps data written during a frame valid while
+// the next frame is being built.
+//
+// Allocation is thread safe. ThreadPool threads carve chunks out of the frame stack into
+// their own sub arenas, and bump allocate from those without locking. Other threads, and
+// allocations too large for a chunk, go through a lock on the frame stack.
+class FrameAllocator : public Allocator {
+public:
+  static const U32    kMaxFrameBuffers = 3;
+  // Max number of pool threads that are given sub arenas.
+  static const U32    kMaxThreadArenas = 64;
+  // Size of each chunk handed to a thread sub arena.
+  static const size_t kThreadArenaChunkSize = 64 * 1024;
+
+  FrameAllocator();
+
+  // Memory must be at least sizePerFrame * bufferCount bytes.
+  void            Initialize(size_t sizePerFrame, U32 bufferCount, void* mem);
+  void            CleanUp();
+
+  void*           allocate(size_t sz, size_t align) override;
+
+  // Frame memory is released all at once on swap().
+  void            Deallocate(void* ptr) override { }
+
+  // Move on to the next frame buffer, releasing its memory. Must not be called while
+  // other threads are allocating from this allocator.
+  void            swap();
+
+  // Markers and rewind on the current frame stack. Must only be used by a single thread,
+  // for scoped scratch memory.
+  StackAllocator::Marker GetMarker();
+  void            FreeToMarker(StackAllocator::Marker marker);
+
+  // Whether the pointer lies in memory owned by this allocator.
+  B32             Owns(const void* ptr) const;
+
+  B32             IsInitialized() const { return m_BufferCount > 0; }
+  U32             GetBufferCount() const { return m_BufferCount; }
+  U32             GetCurrentBufferIndex() const { return m_CurrentBuffer; }
+  U64             GetFrameCount() const { return m_FrameCount; }
+
+  // Used memory of the current frame stack.
+  size_t          CurrentFrameUsedMem() const { return m_Stacks[m_CurrentBuffer].UsedMem(); }
+
+  template<typename T>
+  T*              allocateArray(size_t count) {
+    return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+  }
+
+private:
+  struct ThreadArena {
+    StackAllocator  _stack;
+    // Frame the arena chunk was carved out on. Stale arenas are refilled on first use.
+    U64             _frame;
+    // Padding to keep arenas of different threads off the same cache line.
+    U8              _pad[64];
+  };
+
+  void*           allocateShared(size_t sz, size_t align);
+
+  StackAllocator  m_Stacks[kMaxFrameBuffers];
+  ThreadArena     m_Arenas[kMaxThreadArenas];
+  std::mutex      m_Mutex;
+  U32             m_BufferCount;
+  U32             m_CurrentBuffer;
+  U64             m_FrameCount;
+};
+
+
+// Global frame allocator, owned by the Core.
+FrameAllocator& gFrameAllocator();
+} // Recluse
@@ -10,7 +10,9 @@ namespace Recluse {
 
 // Linked list style memory allocator. This is a usefull allocator
 // for handling dynamic data, without dealing with context switches and
-// slow times from std malloc and new.
+// slow times from std malloc and new. Free blocks are kept in address order,
+// and are coalesced with their neighbors on deallocation. Allocation is first fit, 
+// so cost grows with the number of free blocks, see TLSFAllocator for constant time.
 class FreeListAllocator : public Allocator {
 
   FreeListAllocator(const FreeListAllocator&) = delete;
@@ -25,6 +27,10 @@ public:
   void* allocate(size_t Size, size_t Align) override;
   void Deallocate(void* Ptr) override;
 
+  // Walks the free list.
+  size_t LargestFreeBlock() const override;
+  size_t FreeBlockCount() const;
+
 private:
   struct AllocHeader {
     size_t      Adjust;
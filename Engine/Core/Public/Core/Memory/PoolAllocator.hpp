@@ -0,0 +1,58 @@
+// Copyright (c) 2017 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Allocator.hpp"
+#include "Core/Types.hpp"
+
+
+namespace Recluse {
+
+
+// Fixed size block allocator. Memory is split into equally sized blocks, and free blocks
+// are threaded into an intrusive free list, giving O(1) allocation and deallocation with no
+// fragmentation. Freed blocks are reused first, which keeps recently touched memory hot.
+// Not thread safe.
+class PoolAllocator : public Allocator {
+
+  PoolAllocator(const PoolAllocator&) = delete;
+  PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+public:
+  // Blocks are at least pointer sized, and aligned to blockAlign.
+  PoolAllocator(size_t blockSz, size_t blockAlign, size_t sz, void* mem);
+
+  // Size must fit in a block, and align must be no greater than the block alignment.
+  void*         allocate(size_t sz, size_t align) override;
+  void          Deallocate(void* ptr) override;
+
+  size_t        FreeMem() const override { return m_FreeBlockCount * m_BlockSize; }
+  size_t        LargestFreeBlock() const override { return m_FreeBlockCount ? m_BlockSize : 0; }
+
+  size_t        BlockSize() const { return m_BlockSize; }
+  size_t        BlockCount() const { return m_BlockCount; }
+  size_t        FreeBlockCount() const { return m_FreeBlockCount; }
+  B32           IsFull() const { return m_FreeBlockCount == 0; }
+
+  B32           Owns(const void* ptr) const {
+    return (ptr >= m_pBlocks) && (ptr < (m_pBlocks + m_BlockCount * m_BlockSize));
+  }
+
+  // Blocks are laid out contiguously, and can be addressed by index.
+  size_t        BlockIndex(const void* ptr) const { 
+    return (static_cast<const U8*>(ptr) - m_pBlocks) / m_BlockSize; 
+  }
+  void*         BlockAt(size_t idx) { return m_pBlocks + idx * m_BlockSize; }
+
+private:
+  struct FreeBlock {
+    FreeBlock*  Next;
+  };
+
+  U8*           m_pBlocks;
+  FreeBlock*    m_pFreeList;
+  size_t        m_BlockSize;
+  size_t        m_BlockAlign;
+  size_t        m_BlockCount;
+  size_t        m_FreeBlockCount;
+};
+} // Recluse
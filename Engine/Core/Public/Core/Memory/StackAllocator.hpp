@@ -7,13 +7,44 @@
 namespace Recluse {
 
 
+// Linear, bump pointer, allocator. Allocations are handed out from the top of the stack, and 
+// are never freed individually. Instead, memory is released by rewinding the stack back to a 
+// previously captured marker, or resetting it entirely, which are both O(1). 
+// Not thread safe, see FrameAllocator for use across threads.
 class StackAllocator : public Allocator {
 public:
+  // Offset from the bottom of the stack.
+  typedef size_t Marker;
+
+  StackAllocator()
+    : Allocator(0, nullptr)
+    , m_Top(0) { }
+
   StackAllocator(size_t sz, void* rawMemBlock)
-    : Allocator(sz, rawMemBlock) { }
+    : Allocator(sz, rawMemBlock)
+    , m_Top(0) { }
+
+  void*         allocate(size_t sz, size_t align) override;
+
+  // Individual allocations can not be freed, rewind with FreeToMarker() instead.
+  void          Deallocate(void* ptr) override { }
+
+  Marker        GetMarker() const { return m_Top; }
+
+  // Rewind the stack, releasing all allocations made after the marker was taken.
+  void          FreeToMarker(Marker marker);
+
+  // Release all allocations.
+  void          Reset() { FreeToMarker(0); }
+
+  // Hand a new memory block to the stack. All previous allocations are released.
+  void          Initialize(size_t sz, void* rawMemBlock);
+
+  B32           Owns(const void* ptr) const {
+    return (ptr >= m_Memory) && (ptr < (static_cast<const U8*>(m_Memory) + m_Size));
+  }
 
-  
 private:
-  
+  Marker        m_Top;
 };
-} // Recluse 
\ No newline at end of file
+} // Recluse 
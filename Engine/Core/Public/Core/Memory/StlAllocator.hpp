@@ -0,0 +1,103 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Allocator.hpp"
+#include "FrameAllocator.hpp"
+#include "Core/Types.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+
+namespace Recluse {
+
+
+// STL compatible adapter for any engine Allocator. The allocator must outlive
+// every container using it.
+template<typename T>
+class StlAllocator {
+public:
+  typedef T value_type;
+
+  explicit StlAllocator(Allocator* pAllocator) noexcept
+    : m_pAllocator(pAllocator) { }
+
+  template<typename U>
+  StlAllocator(const StlAllocator<U>& other) noexcept
+    : m_pAllocator(other.getAllocator()) { }
+
+  T* allocate(size_t n) {
+    void* ptr = m_pAllocator->allocate(sizeof(T) * n, alignof(T));
+    if (!ptr) throw std::bad_alloc();
+    return static_cast<T*>(ptr);
+  }
+
+  void deallocate(T* ptr, size_t n) noexcept { m_pAllocator->Deallocate(ptr); }
+
+  Allocator* getAllocator() const { return m_pAllocator; }
+
+  template<typename U>
+  bool operator==(const StlAllocator<U>& other) const { return m_pAllocator == other.getAllocator(); }
+  template<typename U>
+  bool operator!=(const StlAllocator<U>& other) const { return m_pAllocator != other.getAllocator(); }
+
+private:
+  Allocator* m_pAllocator;
+};
+
+
+// STL compatible adapter for the global frame allocator. Containers using this allocator must be
+// discarded before the frame memory is recycled. Falls back to the heap when the frame allocator
+// is not available, or out of memory, so containers may be safely constructed at any time.
+//
+// Every block is preceded by a header recording where it came from, so that only heap fallback
+// blocks are ever freed, whatever state the frame allocator is in by then.
+template<typename T>
+class FrameStlAllocator {
+public:
+  typedef T value_type;
+
+  FrameStlAllocator() noexcept { }
+
+  template<typename U>
+  FrameStlAllocator(const FrameStlAllocator<U>&) noexcept { }
+
+  T* allocate(size_t n) {
+    size_t sz = sizeof(T) * n;
+    U8* pBlock = static_cast<U8*>(gFrameAllocator().allocate(kHeaderSize + sz, kHeaderSize));
+    void* pHeapBase = nullptr;
+    if (!pBlock) {
+      // malloc makes no promise past fundamental alignment, so align by hand.
+      pHeapBase = std::malloc(sz + 2 * kHeaderSize);
+      if (!pHeapBase) throw std::bad_alloc();
+      size_t addr = reinterpret_cast<size_t>(pHeapBase);
+      pBlock = reinterpret_cast<U8*>((addr + kHeaderSize - 1) & ~(kHeaderSize - 1));
+    }
+    U8* ptr = pBlock + kHeaderSize;
+    *reinterpret_cast<void**>(ptr - sizeof(void*)) = pHeapBase;
+    return reinterpret_cast<T*>(ptr);
+  }
+
+  void deallocate(T* ptr, size_t n) noexcept {
+    if (!ptr) return;
+    void* pHeapBase = *reinterpret_cast<void**>(reinterpret_cast<U8*>(ptr) - sizeof(void*));
+    if (pHeapBase) std::free(pHeapBase);
+  }
+
+  template<typename U>
+  bool operator==(const FrameStlAllocator<U>&) const { return true; }
+  template<typename U>
+  bool operator!=(const FrameStlAllocator<U>&) const { return false; }
+
+private:
+  // Header in front of each block, a multiple of the alignment of T, holding the base of the 
+  // heap allocation, or null for frame memory.
+  static const size_t kHeaderSize = (alignof(T) > 16) ? alignof(T) : 16;
+};
+
+
+// Vector allocating from the frame allocator.
+template<typename T>
+using FrameVector = std::vector<T, FrameStlAllocator<T> >;
+} // Recluse
@@ -0,0 +1,80 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Allocator.hpp"
+#include "Core/Types.hpp"
+
+
+namespace Recluse {
+
+
+// Two Level Segregated Fit allocator. Free blocks are binned by a first level index
+// (power of two size class), and a second level index (linear subdivision of that class).
+// Bitmaps of non empty bins give allocation and deallocation constant time, which makes this
+// allocator suitable for hot runtime allocations that would otherwise go to malloc.
+// Based on the paper by M. Masmano, I. Ripoll, A. Crespo, and J. Real.
+class TLSFAllocator : public Allocator {
+
+  TLSFAllocator(const TLSFAllocator&) = delete;
+  TLSFAllocator& operator=(const TLSFAllocator&) = delete;
+
+public:
+  // Memory handed to the allocator must be no larger than 4 GB.
+  TLSFAllocator(size_t Sz, void* Mem);
+
+  ~TLSFAllocator();
+
+  void* allocate(size_t Size, size_t Align) override;
+  void Deallocate(void* Ptr) override;
+
+  size_t FreeMem() const override { return m_FreeMem; }
+  size_t LargestFreeBlock() const override;
+  size_t FreeBlockCount() const { return m_FreeBlockCount; }
+
+  // Minimum alignment, and granularity, of all allocations.
+  static const size_t kAlignSizeLog2  = 4;
+  static const size_t kAlignSize      = (1 << kAlignSizeLog2);
+  static const size_t kSlIndexCountLog2 = 5;
+  static const size_t kSlIndexCount   = (1 << kSlIndexCountLog2);
+  static const size_t kFlIndexMax     = 32;
+  static const size_t kFlIndexShift   = (kSlIndexCountLog2 + kAlignSizeLog2);
+  static const size_t kFlIndexCount   = (kFlIndexMax - kFlIndexShift + 1);
+  static const size_t kSmallBlockSize = (1 << kFlIndexShift);
+
+private:
+  struct BlockHeader {
+    // Previous block in physical memory.
+    BlockHeader*  PrevPhys;
+    // Size of the block payload, lowest bit is the free flag.
+    size_t        Sz;
+    // Free list links, only valid while the block is free, as these overlap the payload.
+    BlockHeader*  NextFree;
+    BlockHeader*  PrevFree;
+  };
+
+  static const size_t kBlockOverhead  = sizeof(BlockHeader*) + sizeof(size_t);
+  static const size_t kBlockSizeMin   = sizeof(BlockHeader) - kBlockOverhead;
+
+  static size_t       BlockSize(const BlockHeader* Block) { return Block->Sz & ~size_t(1); }
+  static B32          IsFree(const BlockHeader* Block) { return (Block->Sz & 1) != 0; }
+  static void*        ToPtr(BlockHeader* Block) { return (U8* )Block + kBlockOverhead; }
+  static BlockHeader* FromPtr(void* Ptr) { return (BlockHeader* )((U8* )Ptr - kBlockOverhead); }
+  static BlockHeader* NextPhys(BlockHeader* Block) { return (BlockHeader* )((U8* )ToPtr(Block) + BlockSize(Block)); }
+
+  void                MappingInsert(size_t Sz, U32* Fl, U32* Sl) const;
+  void                MappingSearch(size_t Sz, U32* Fl, U32* Sl) const;
+  BlockHeader*        SearchSuitableBlock(U32* Fl, U32* Sl);
+  void                InsertFreeBlock(BlockHeader* Block);
+  void                RemoveFreeBlock(BlockHeader* Block);
+  BlockHeader*        Split(BlockHeader* Block, size_t Sz);
+  BlockHeader*        MergePrev(BlockHeader* Block);
+  BlockHeader*        MergeNext(BlockHeader* Block);
+  void                SetSize(BlockHeader* Block, size_t Sz, B32 Free);
+
+  U32                 m_FlBitmap;
+  U32                 m_SlBitmap[kFlIndexCount];
+  BlockHeader*        m_Blocks[kFlIndexCount][kSlIndexCount];
+  size_t              m_FreeMem;
+  size_t              m_FreeBlockCount;
+};
+} // Recluse
@@ -0,0 +1,93 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Threading.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+
+namespace Recluse {
+
+
+typedef U32 task_stage_id_t;
+
+
+enum TaskStageFlagBits {
+  TASK_STAGE_FLAG_NONE          = 0,
+  // Stage must run on the thread calling TaskGraph::execute(), ex. window and gpu submission.
+  TASK_STAGE_FLAG_MAIN_THREAD   = (1 << 0)
+};
+
+typedef U32 TaskStageFlags;
+
+
+// Timing readout of a stage for the last executed frame, in milliseconds relative to the
+// start of the frame.
+struct TaskStageTiming {
+  std::string   _name;
+  R64           _startMs;
+  R64           _endMs;
+  R64           _totalMs;
+  // Pool thread index the stage ran on, -1 if ran outside of the pool.
+  I32           _threadIdx;
+};
+
+
+// Declarative graph of named stages that make up a frame. Stages are declared in
+// execution order, and may only depend on stages declared before them. Independent
+// stages are overlapped across the ThreadPool workers, while stages flagged to run on
+// the main thread are run inline, once their dependencies are finished.
+class TaskGraph {
+public:
+  static const task_stage_id_t kInvalidStage = 0xffffffff;
+
+  TaskGraph()
+    : m_frameMs(0.0) { }
+
+  // Add a stage to the graph, returns the id of the stage to be used for dependencies.
+  task_stage_id_t addStage(const std::string& name,
+                           thr_work_func_t work,
+                           const std::vector<task_stage_id_t>& dependencies = { },
+                           TaskStageFlags flags = TASK_STAGE_FLAG_NONE);
+
+  // Disabled stages are skipped, and count as finished for any stage depending on them.
+  void            setStageEnable(task_stage_id_t id, B32 enable);
+
+  task_stage_id_t findStage(const std::string& name) const;
+
+  // Run all stages of the graph, returns once every stage has finished.
+  void            execute(ThreadPool& pool);
+
+  void            clear();
+
+  size_t          getStageCount() const { return m_stages.size(); }
+
+  // Timings of each stage from the last call to execute().
+  const std::vector<TaskStageTiming>& getStageTimings() const { return m_timings; }
+
+  // Total wall time of the last call to execute(), in milliseconds.
+  R64             getFrameTimeMs() const { return m_frameMs; }
+
+private:
+  struct Stage {
+    std::string                   _name;
+    thr_work_func_t               _work;
+    std::vector<task_stage_id_t>  _dependencies;
+    TaskStageFlags                _flags;
+    B32                           _enable;
+    // Interned profiler tag of the stage name.
+    U32                           _profileTag;
+  };
+
+  void            runStage(task_stage_id_t id, R64 frameStart);
+
+  std::vector<Stage>              m_stages;
+  std::vector<TaskStageTiming>    m_timings;
+  // Counter per stage, tracking its completion during execute().
+  std::unique_ptr<JobCounter[]>   m_counters;
+  R64                             m_frameMs;
+};
+} // Recluse
@@ -4,6 +4,8 @@
 #include "Core/Types.hpp"
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <queue>
 #include <vector>
 #include <list>
@@ -15,6 +17,7 @@ namespace Recluse {
 
 
 class ThreadPool;
+struct ThreadJob;
 
 enum ThreadResult {
   ThrResultInProgress,
@@ -27,6 +30,8 @@ typedef U64 thread_id_t;
 typedef U32 error_t;
 typedef std::function<void()> thr_work_func_t;
 typedef std::function<void(thread_id_t)> thread_func_t;
+// Ranged work function, called with [start, end) of the partition to work on.
+typedef std::function<void(U32, U32)> thr_range_func_t;
 
 class Thread {
   // Id 0 is not a valid id.
@@ -38,6 +43,7 @@ public:
 
   void                            Join() { mThread.join(); }
   void                            Detach() { mThread.detach(); }
+  B32                             Joinable() const { return mThread.joinable(); }
   thread_id_t                     getId() { return m_Id; }
 
 private:
@@ -46,42 +52,133 @@ private:
 };
 
 
+// Job counter, used to track a group of jobs submitted to the ThreadPool. Each
+// job submitted with a counter increments it, and decrements it once the work is
+// done. Other jobs may be set to depend on the counter, which holds them back
+// until the counter reaches zero. Counters must outlive the jobs tracking them.
+class JobCounter {
+public:
+  JobCounter()
+    : m_Count(0) { }
+
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator=(const JobCounter&) = delete;
+
+  B32                   IsDone() const { return m_Count.load(std::memory_order_acquire) == 0; }
+  I32                   Value() const { return m_Count.load(std::memory_order_acquire); }
+
+private:
+  std::atomic<I32>        m_Count;
+  // Jobs waiting on this counter to reach zero.
+  std::mutex              m_WaitMutex;
+  std::vector<ThreadJob*> m_Waiting;
+
+  friend class ThreadPool;
+};
+
+
 // ThreadPool object, used for engine modules in need of assistance, for quicker task completion.
+// Each worker owns a lock free work stealing deque. Jobs pushed by a worker go onto its own
+// deque, and idle workers steal from the top of their neighbors' deques before parking on a
+// condition variable. Threads outside of the pool push into a shared injection queue, except for
+// the thread that called RunAll(), which is given a deque of its own since it is expected to
+// fan out the majority of engine work.
 class ThreadPool {
-
 public:
-  ThreadPool(U32 InitThreadCount = 2) 
-    : m_CurrentTaskCount(0)
-    , m_ThreadWorkers(InitThreadCount)
-    , m_BusyThreadCount(0)
-    , m_SignalStop(true) { }
+  // Max number of jobs a worker deque may hold before spilling into the shared queue.
+  static const U32      kMaxJobsPerQueue = 4096;
+
+  // Passing 0 will size the pool to the number of hardware threads, minus the calling thread.
+  ThreadPool(U32 InitThreadCount = 0);
+  ~ThreadPool();
 
   void                  RunAll();
-  void                  AddTask(thr_work_func_t WorkFunc);
+
+  // Submit work to the pool. The optional counter is incremented on submission, and
+  // decremented once the work finishes. If a dependency counter is given, the work will
+  // not be scheduled until that counter reaches zero.
+  void                  AddTask(thr_work_func_t WorkFunc,
+                                JobCounter* Counter = nullptr,
+                                JobCounter* Dependency = nullptr);
+
+  // Submit work that is held back until all of the given dependency counters reach zero.
+  void                  AddTask(thr_work_func_t WorkFunc,
+                                JobCounter* Counter,
+                                JobCounter* const* Dependencies,
+                                U32 DependencyCount);
+
+  // Split [0, Count) into partitions of at most BatchSize, and submit each as a job.
+  void                  ParallelFor(U32 Count,
+                                    U32 BatchSize,
+                                    thr_range_func_t WorkFunc,
+                                    JobCounter* Counter,
+                                    JobCounter* Dependency = nullptr);
+
   void                  ClearTasks();
-  void                  StopAll();  
+  void                  StopAll();
 
   B8                    AllDone() const;
 
+  // Wait for all submitted jobs to finish. The calling thread works on pending jobs
+  // while it waits, and sleeps if there is nothing left for it to do.
   void                  WaitAll();
 
-private:
+  // Wait for the counter to reach zero. Like WaitAll(), the calling thread helps out.
+  void                  WaitForCounter(JobCounter* Counter);
 
-  struct ThreadJob {
-    thread_id_t         CurrThreadId;
-    thr_work_func_t     Work;
-    ThreadResult        Result;
+  // Hold a counter for work done outside of the pool, such as file I/O. Jobs depending on the
+  // counter, and threads waiting on it, are held back until the matching EndExternalWork().
+  void                  BeginExternalWork(JobCounter* Counter);
+  void                  EndExternalWork(JobCounter* Counter);
+
+  U32                   GetWorkerCount() const { return static_cast<U32>(m_ThreadWorkers.size()); }
+
+  // Returns the index of the pool thread calling this function, or -1 if the calling
+  // thread is not part of the pool. The thread that called RunAll() is the last index.
+  static I32            GetCurrentThreadIndex();
+
+private:
+  // Chase-Lev work stealing deque. Owner pushes and pops from the bottom, thieves
+  // steal from the top.
+  class WorkQueue {
+  public:
+    WorkQueue();
+
+    B32                 Push(ThreadJob* Job);
+    ThreadJob*          Pop();
+    ThreadJob*          Steal();
+
+  private:
+    // Padded to keep owner and thieves from sharing a cache line.
+    std::atomic<I64>              m_Top;
+    U8                            m_Pad0[64 - sizeof(I64)];
+    std::atomic<I64>              m_Bottom;
+    U8                            m_Pad1[64 - sizeof(I64)];
+    std::atomic<ThreadJob*>       m_Jobs[kMaxJobsPerQueue];
   };
 
+  void                  Submit(ThreadJob* Job);
+  void                  Schedule(ThreadJob* Job);
+  void                  Execute(ThreadJob* Job);
+  ThreadJob*            FindJob(I32 ThreadIdx);
+  B32                   RunPendingJob();
+  void                  WorkerLoop(I32 ThreadIdx);
+  void                  SignalCounter(JobCounter* Counter);
+  void                  WakeAll();
+  void                  Park(const std::function<B32()>& Wake);
 
   std::vector<Thread>     m_ThreadWorkers;
-  std::queue<ThreadJob>   m_ThreadJobs;
-  std::list<ThreadJob>    m_ProgressJobs;
-  std::mutex              m_JobMutex;
-  std::mutex              m_ProgressMutex;
-  std::condition_variable m_Cond;
-  U32                     m_CurrentTaskCount;
-  U32                     m_BusyThreadCount;
-  U32                     m_SignalStop;
+  WorkQueue*              m_Queues;
+  U32                     m_QueueCount;
+  // Queue for threads that do not own a deque, as well as overflow.
+  std::queue<ThreadJob*>  m_SharedJobs;
+  std::mutex              m_SharedMutex;
+  // Parking for idle workers, and for threads waiting on counters.
+  std::mutex              m_ParkMutex;
+  std::condition_variable m_ParkCond;
+  std::atomic<U32>        m_QueuedJobCount;
+  std::atomic<U32>        m_CurrentTaskCount;
+  std::atomic<U32>        m_SleepingThreadCount;
+  std::atomic<U32>        m_SignalStop;
 };
-} // Recluse
\ No newline at end of file
+} // Recluse
@@ -36,4 +36,9 @@ typedef U64               UUID64;
  #define DEBUG_OP(param)
 #endif
 
-#define __USE_INTEL_INTRINSICS__ 0
\ No newline at end of file
+// SSE4.1 math intrinsics, enabled by the SIMD build option on x86-64 targets.
+#if defined(RECLUSE_SIMD) && (defined(_M_X64) || defined(__x86_64__))
+ #define __USE_INTEL_INTRINSICS__ 1
+#else
+ #define __USE_INTEL_INTRINSICS__ 0
+#endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "Core/Types.hpp"
+#include <cstring>
 #include <fstream>
 
 
@@ -33,6 +34,10 @@ public:
   virtual IArchive& operator<<(I64 Val) = 0;
   virtual IArchive& operator<<(std::string Str) = 0;
 
+  // Floating point values are stored by their bits, unless the archive knows better.
+  virtual IArchive& operator<<(R32 Val) { U32 Bits; memcpy(&Bits, &Val, sizeof(Bits)); return operator<<(Bits); }
+  virtual IArchive& operator<<(R64 Val) { U64 Bits; memcpy(&Bits, &Val, sizeof(Bits)); return operator<<(Bits); }
+
   virtual IArchive& operator>>(U8& Val) = 0;
   virtual IArchive& operator>>(I8& Val) = 0;
   virtual IArchive& operator>>(U16& Val) = 0;
@@ -43,6 +48,9 @@ public:
   virtual IArchive& operator>>(I64& Val) = 0;
   virtual IArchive& operator>>(std::string& Val) = 0;
 
+  virtual IArchive& operator>>(R32& Val) { U32 Bits = 0; operator>>(Bits); memcpy(&Val, &Bits, sizeof(Val)); return (*this); }
+  virtual IArchive& operator>>(R64& Val) { U64 Bits = 0; operator>>(Bits); memcpy(&Val, &Bits, sizeof(Val)); return (*this); }
+
   B8                Opened() const { return m_Opened; }
   std::string       getName() const { return m_Name; }
 
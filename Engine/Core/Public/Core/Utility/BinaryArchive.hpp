@@ -0,0 +1,192 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Archive.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace Recluse {
+
+
+// Four character code, identifying a chunk in a binary archive.
+#define R_CHUNK_ID(a, b, c, d) (static_cast<U32>(a) | (static_cast<U32>(b) << 8) \
+  | (static_cast<U32>(c) << 16) | (static_cast<U32>(d) << 24))
+
+
+enum ArchiveMode {
+  ARCHIVE_MODE_READ,
+  ARCHIVE_MODE_WRITE
+};
+
+
+// Zero copy view of an array read from a BinaryArchive.
+template<typename T>
+struct ArchiveSpan {
+  const T*  _data;
+  size_t    _count;
+
+  const T*  begin() const { return _data; }
+  const T*  end() const { return _data + _count; }
+  size_t    size() const { return _count; }
+  B32       empty() const { return _count == 0; }
+  const T&  operator[](size_t i) const { return _data[i]; }
+};
+
+
+// Chunked, versioned, binary archive. Data is grouped into chunks, each tagged with an id and
+// a version of its own, so that readers may skip, or upgrade, chunks they do not know about.
+// Chunks may be compressed.
+//
+// Arrays of plain data are written in bulk, aligned in the file, so reading them back is a
+// pointer into the memory mapped file. Views of compressed chunks point into their decompressed
+// copy instead. Either way, views stay valid until the archive is closed.
+//
+// Values are stored little endian. Reads past the end of a chunk, or of a malformed archive,
+// return zeroes and flag the archive as failed.
+class BinaryArchive : public IArchive {
+public:
+  static const U32    kMagic = R_CHUNK_ID('R', 'B', 'A', 'R');
+  static const U16    kFormatVersion = 1;
+  // Chunk used by the stream operators when no chunk was begun, or opened.
+  static const U32    kDefaultChunk = R_CHUNK_ID('D', 'A', 'T', 'A');
+  // Alignment of chunks, and arrays, in the archive.
+  static const size_t kDataAlignment = 16;
+
+  BinaryArchive();
+  ~BinaryArchive();
+
+  // Open for reading.
+  B8                  Open(const std::string Filename) override;
+  B8                  Open(const std::string& filename, ArchiveMode mode);
+  B8                  close() override;
+
+  ArchiveMode         getMode() const { return m_mode; }
+  B32                 failed() const { return m_failed; }
+
+  // Writing. Chunks can not be nested. Compressed chunks are stored uncompressed if
+  // compression does not pay off.
+  void                beginChunk(U32 id, U32 version = 0, B32 compress = false);
+  void                endChunk();
+  void                writeBytes(const void* data, size_t sz);
+
+  template<typename T>
+  void                writeSpan(const T* data, size_t count) {
+    static_assert(std::is_trivially_copyable<T>::value, "Spans must be plain data.");
+    writeArrayHeader(count, alignof(T));
+    writeBytes(data, sizeof(T) * count);
+  }
+
+  template<typename T>
+  void                writeSpan(const std::vector<T>& data) { writeSpan(data.data(), data.size()); }
+
+  // Reading.
+  size_t              getChunkCount() const { return m_chunks.size(); }
+  U32                 getChunkId(size_t idx) const { return m_chunks[idx]._id; }
+  B32                 hasChunk(U32 id) const;
+
+  // Seek to the start of a chunk. Returns false if the archive has no such chunk.
+  B32                 openChunk(U32 id, U32* pVersion = nullptr);
+
+  B32                 readBytes(void* data, size_t sz);
+
+  // Zero copy read of sz bytes. Returns null if there are not enough bytes left in the chunk.
+  const U8*           readView(size_t sz);
+
+  template<typename T>
+  ArchiveSpan<T>      readSpan() {
+    static_assert(std::is_trivially_copyable<T>::value, "Spans must be plain data.");
+    ArchiveSpan<T> span = { nullptr, 0 };
+    size_t count = readArrayHeader(alignof(T));
+    if (count > (remaining() / sizeof(T))) {
+      m_failed = true;
+      return span;
+    }
+    span._data = reinterpret_cast<const T*>(readView(sizeof(T) * count));
+    span._count = span._data ? count : 0;
+    return span;
+  }
+
+  template<typename T>
+  B32                 readSpan(std::vector<T>& out) {
+    ArchiveSpan<T> span = readSpan<T>();
+    out.assign(span.begin(), span.end());
+    return !m_failed;
+  }
+
+  IArchive&           operator<<(U8 Val) override;
+  IArchive&           operator<<(I8 Val) override;
+  IArchive&           operator<<(U16 Val) override;
+  IArchive&           operator<<(I16 Val) override;
+  IArchive&           operator<<(U32 Val) override;
+  IArchive&           operator<<(I32 Val) override;
+  IArchive&           operator<<(U64 Val) override;
+  IArchive&           operator<<(I64 Val) override;
+  IArchive&           operator<<(R32 Val) override;
+  IArchive&           operator<<(R64 Val) override;
+  IArchive&           operator<<(std::string Val) override;
+
+  IArchive&           operator>>(U8& Val) override;
+  IArchive&           operator>>(I8& Val) override;
+  IArchive&           operator>>(U16& Val) override;
+  IArchive&           operator>>(I16& Val) override;
+  IArchive&           operator>>(U32& Val) override;
+  IArchive&           operator>>(I32& Val) override;
+  IArchive&           operator>>(U64& Val) override;
+  IArchive&           operator>>(I64& Val) override;
+  IArchive&           operator>>(R32& Val) override;
+  IArchive&           operator>>(R64& Val) override;
+  IArchive&           operator>>(std::string& Val) override;
+
+private:
+  struct ChunkEntry {
+    U32               _id;
+    U32               _version;
+    U32               _flags;
+    U32               _reserved;
+    // Offset of the chunk data from the start of the file.
+    U64               _offset;
+    // Size of the chunk data in the file.
+    U64               _storedSize;
+    // Size of the chunk data once decompressed.
+    U64               _size;
+  };
+
+  template<typename T>
+  void                writeValue(T val) { writeBytes(&val, sizeof(T)); }
+
+  template<typename T>
+  void                readValue(T& val) { if (!readBytes(&val, sizeof(T))) val = T(); }
+
+  void                writeArrayHeader(size_t count, size_t align);
+  size_t              readArrayHeader(size_t align);
+  size_t              remaining() const { return m_chunkSize - m_cursor; }
+  B32                 readChunkTable();
+  void                reset();
+
+  ArchiveMode         m_mode;
+  B32                 m_failed;
+  std::vector<ChunkEntry> m_chunks;
+
+  // Writing.
+  FILE*               m_pFile;
+  std::vector<U8>     m_chunkData;
+  ChunkEntry          m_currentChunk;
+  B32                 m_chunkOpen;
+  U64                 m_fileOffset;
+
+  // Reading.
+  MappedFile          m_mappedFile;
+  // Decompressed copies of compressed chunks, kept for the views handed out.
+  std::vector<std::unique_ptr<U8[]> > m_decompressed;
+  const U8*           m_pChunk;
+  size_t              m_chunkSize;
+  size_t              m_cursor;
+};
+} // Recluse
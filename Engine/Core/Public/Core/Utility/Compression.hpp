@@ -0,0 +1,26 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+
+
+namespace Recluse {
+
+
+// Fast block compression, using the LZ4 block format. Meant for archive chunks and 
+// cooked assets, where decompression speed matters much more than ratio.
+
+// Worst case size of compressing srcSize bytes.
+size_t CompressBlockBound(size_t srcSize);
+
+// Largest size srcSize compressed bytes can decompress to. Every byte of a block yields at most
+// 255 bytes, through match length extensions, so sizes past this are malformed.
+size_t DecompressBlockBound(size_t srcSize);
+
+// Compress src into dst. Returns the compressed size, or 0 if dst is too small.
+size_t CompressBlock(const void* src, size_t srcSize, void* dst, size_t dstCapacity);
+
+// Decompress src into dst, which must be exactly the uncompressed size. Returns false
+// on malformed input, never reading or writing out of bounds.
+B32 DecompressBlock(const void* src, size_t srcSize, void* dst, size_t dstSize);
+} // Recluse
@@ -13,6 +13,10 @@ public:
   static B8   IsIntel();
   static B8   IsAmd();
 
+  // Instruction set support. AVX2 also requires FMA, and os support for saving ymm registers.
+  static B8   HasSSE41();
+  static B8   HasAVX2();
+
   // Count number of flipped bits with SWAR.
   static I32 BitsFlippedCount(I32 v);
 
@@ -0,0 +1,40 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+
+#include <string>
+
+
+namespace Recluse {
+
+
+// Read only, memory mapped, view of a whole file. Pages are brought in by the OS on first
+// touch, so opening is cheap no matter the size of the file.
+class MappedFile {
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  B32           open(const std::string& path);
+  void          close();
+
+  B32           isOpen() const { return m_opened; }
+  const U8*     data() const { return m_pData; }
+  size_t        size() const { return m_size; }
+
+private:
+  const U8*     m_pData;
+  size_t        m_size;
+  B32           m_opened;
+#if defined(_WIN32)
+  void*         m_hFile;
+  void*         m_hMapping;
+#else
+  I32           m_fd;
+#endif
+};
+} // Recluse
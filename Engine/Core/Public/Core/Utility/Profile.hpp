@@ -6,11 +6,14 @@
 #include "Core/Types.hpp"
 #include "Time.hpp"
 
+#include <string>
+#include <vector>
+
 
 #define R_ENABLE_PROFILE_FLAG  1
 
 
-namespace Recluse { 
+namespace Recluse {
 
 
 enum ProfileTypes {
@@ -27,60 +30,152 @@ enum ProfileTypes {
 };
 
 
+enum ProfileEventKind {
+  PROFILE_EVENT_SCOPE,
+  PROFILE_EVENT_COUNTER
+};
+
+
+// Latest sample of a profiled scope.
 struct ProfileData {
   std::string   _tag;
   ProfileTypes  _type;
-  // start time in milliseconds.
+  // start time in seconds, since the profiler started.
   R32           _start;
-  // end time in milliseconds.
+  // end time in seconds, since the profiler started.
   R32           _end;
-  // total elapsed time between start and end.
+  // total elapsed time between start and end, in seconds.
   R32           _total;
 };
 
 
-// Profile data handler.
+// Fixed size event, as recorded into the per thread buffers. Times are in profiler ticks.
+struct ProfileEvent {
+  U64           _start;
+  union {
+    // End of a scope.
+    U64         _end;
+    // Value of a counter.
+    R64         _value;
+  };
+  U32           _tagId;
+  U8            _type;
+  U8            _kind;
+  // Nesting depth of a scope on its thread.
+  U16           _depth;
+};
+
+
+// Frame boundaries, in profiler ticks.
+struct ProfileFrame {
+  U64           _index;
+  U64           _start;
+  U64           _end;
+};
+
+
+// Profile data handler. Each thread records events into its own ring buffer, so recording
+// never locks, or allocates, after the first event on a thread. Buffers keep the last
+// kMaxEventsPerThread events, which makes it cheap enough to always leave profiling on, and
+// dump a trace of the last few seconds when a hitch is noticed.
 class Profiler {
 public:
-  static void StoreTimed(ProfileData& obj, const std::string& tag);
+  static const U32 kMaxEventsPerThread = 32768;
+  static const U32 kMaxThreads = 64;
+  static const U32 kMaxFrameHistory = 256;
+  static const U32 kInvalidTag = 0xffffffff;
+
+  // Get the id of a tag, registering it if needed. Ids are stable for the lifetime of the
+  // application. This locks, so ids should be cached by the caller, as the macros below do.
+  static U32 InternTag(const std::string& tag);
+  static std::string GetTagName(U32 tagId);
+
+  // Current time in profiler ticks. On x86 this reads the time stamp counter.
+  static U64 Now();
+
+  // Convert ticks to nanoseconds since the profiler started.
+  static R64 TicksToNanoseconds(U64 ticks);
+
+  static void SetEnabled(B32 enable);
+  static B32 IsEnabled();
+
+  // Name the calling thread in exported traces.
+  static void SetThreadName(const std::string& name);
+
+  // Record a scope, opened with BeginScope(), on the calling thread.
+  static void BeginScope();
+  static void EndScope(ProfileTypes type, U32 tagId, U64 start);
+
+  // Record the value of a counter, shown as a graph in the trace viewer.
+  static void RecordCounter(ProfileTypes type, U32 tagId, R64 value);
+
+  // Mark the end of the current frame, and the start of the next one.
+  static void EndFrame();
+
+  // Copy the most recent frames, oldest first. Returns the number copied.
+  static U32 GetFrameHistory(ProfileFrame* pOut, U32 maxCount);
+
+  // Write events of the last frameCount frames, or all buffered events if 0, into a Chrome
+  // trace_event JSON file. Open with chrome://tracing, or Perfetto.
+  static B32 ExportChromeTrace(const std::string& path, U32 frameCount = 0);
+
+  // Latest sample of a scope. Returned data is valid until the next call to GetProfileData().
   static ProfileData* GetProfileData(ProfileTypes type, const std::string& tag);
 
+  // Latest sample of each scope of the given type.
   static std::vector<ProfileData> GetAll(ProfileTypes type);
 };
 
 
 class ProfileObject {
 public:
-  ProfileObject(ProfileTypes type = PROFILE_TYPES_NORMAL, const std::string& tag = "")
-    : m_time(static_cast<R32>(Time::currentTime()))
+  ProfileObject(ProfileTypes type, U32 tagId)
+    : m_start(0)
+    , m_tagId(tagId)
     , m_type(type)
-    , m_tag(tag) { }
+    , m_active(Profiler::IsEnabled())
+  {
+    if (m_active) {
+      Profiler::BeginScope();
+      m_start = Profiler::Now();
+    }
+  }
+
+  ProfileObject(ProfileTypes type = PROFILE_TYPES_NORMAL, const std::string& tag = "")
+    : ProfileObject(type, Profiler::InternTag(tag)) { }
 
   ~ProfileObject()
   {
-    R32 _end = static_cast<R32>(Time::currentTime());
-    ProfileData data;
-    data._start = m_time;
-    data._end = _end;
-    data._total = _end - m_time;
-    data._type = m_type;
-    data._tag = m_tag;
-    Profiler::StoreTimed(data, m_tag);
+    if (m_active) {
+      Profiler::EndScope(m_type, m_tagId, m_start);
+    }
   }
 
 private:
-  //
-  ProfileTypes  m_type;
+  // start time, in profiler ticks.
+  U64           m_start;
 
-  // start time on the global clock.
-  R32           m_time;
+  // interned tag.
+  U32           m_tagId;
 
-  // tag used for meta data.
-  std::string   m_tag;
+  ProfileTypes  m_type;
+
+  // Whether profiling was enabled when the scope was opened.
+  B32           m_active;
 };
 
+#define R_PROFILE_CONCAT_IMPL(a, b) a ## b
+#define R_PROFILE_CONCAT(a, b) R_PROFILE_CONCAT_IMPL(a, b)
+
 #if R_ENABLE_PROFILE_FLAG >= 1
-  #define R_TIMED_PROFILE(type, tag) ProfileObject __profile__obj(type, tag)
+  // Tags are interned once per call site, so they must not change between calls.
+  #define R_TIMED_PROFILE(type, tag) \
+    static const U32 R_PROFILE_CONCAT(__profile__tag, __LINE__) = Profiler::InternTag(tag); \
+    ProfileObject R_PROFILE_CONCAT(__profile__obj, __LINE__)(type, R_PROFILE_CONCAT(__profile__tag, __LINE__))
+  #define R_PROFILE_COUNTER(type, tag, value) { \
+    static const U32 __profile__counter = Profiler::InternTag(tag); \
+    if (Profiler::IsEnabled()) Profiler::RecordCounter(type, __profile__counter, static_cast<R64>(value)); \
+  }
   #define R_TIMED_PROFILE_RENDERER() R_TIMED_PROFILE(PROFILE_TYPES_RENDERER, __FUNCTION__)
   #define R_TIMED_PROFILE_PHYSICS() R_TIMED_PROFILE(PROFILE_TYPES_PHYSICS, __FUNCTION__)
   #define R_TIMED_PROFILE_AUDIO() R_TIMED_PROFILE(PROFILE_TYPES_AUDIO, __FUNCTION__)
@@ -92,16 +187,17 @@ private:
   #define R_GET_TIMED_AUDIO_FUNCTOR(tag) Profiler::GetProfileData(PROFILE_TYPES_AUDIO, tag)
   #define R_GET_TIMED_UI_FUNCTOR(tag) Profiler::GetProfileData(PROFILE_TYPES_UI, tag)
 #else
-  #define R_TIMED_PROFILE(type, tag) 
-  #define R_TIMED_PROFILE_RENDERER() 
-  #define R_TIMED_PROFILE_PHYSICS() 
-  #define R_TIMED_PROFILE_AUDIO() 
-  #define R_TIMED_PROFILE_UI() 
-  #define R_TIMED_PROFILE_GAME() 
-  #define R_GET_TIMED_FUNCTOR(type, tag) 
-  #define R_GET_TIMED_RENDERER_FUNCTOR(tag) 
-  #define R_GET_TIMED_PHYSICS_FUNCTOR(tag) 
-  #define R_GET_TIMED_AUDIO_FUNCTOR(tag) 
-  #define R_GET_TIMED_UI_FUNCTOR(tag) 
+  #define R_TIMED_PROFILE(type, tag)
+  #define R_PROFILE_COUNTER(type, tag, value)
+  #define R_TIMED_PROFILE_RENDERER()
+  #define R_TIMED_PROFILE_PHYSICS()
+  #define R_TIMED_PROFILE_AUDIO()
+  #define R_TIMED_PROFILE_UI()
+  #define R_TIMED_PROFILE_GAME()
+  #define R_GET_TIMED_FUNCTOR(type, tag)
+  #define R_GET_TIMED_RENDERER_FUNCTOR(tag)
+  #define R_GET_TIMED_PHYSICS_FUNCTOR(tag)
+  #define R_GET_TIMED_AUDIO_FUNCTOR(tag)
+  #define R_GET_TIMED_UI_FUNCTOR(tag)
 #endif
-} // Recluse
\ No newline at end of file
+} // Recluse
@@ -0,0 +1,227 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "AsyncIO.hpp"
+#include "FilesystemPlatform.hpp"
+
+#include "Core/Thread/Threading.hpp"
+#include "Core/Logging/Log.hpp"
+#include "Core/Exception.hpp"
+
+
+namespace Recluse {
+
+
+void BlockingIOBackend::read(AsyncIORead* reads, U32 count)
+{
+  for (U32 i = 0; i < count; ++i) {
+    FileHandle handle;
+    reads[i]._success = (PlatformReadFile(reads[i]._path, &handle) == FilesystemResult_Success);
+    reads[i]._buffer = handle.Buf;
+    reads[i]._size = reads[i]._success ? handle.Sz : 0;
+    handle.Buf = nullptr;
+  }
+}
+
+
+AsyncIOQueue::AsyncIOQueue()
+  : m_pPool(nullptr)
+  , m_pBackend(nullptr)
+  , m_running(false)
+  , m_nextId(1)
+{
+}
+
+
+AsyncIOQueue::~AsyncIOQueue()
+{
+  shutDown();
+}
+
+
+void AsyncIOQueue::startUp(ThreadPool* pPool)
+{
+  if (m_running) return;
+  m_pPool = pPool;
+  m_pBackend = CreateAsyncIOBackend(kMaxBatchSize);
+  m_running = true;
+  m_thread = std::thread([this] () -> void { threadLoop(); });
+  R_DEBUG(rNotify, std::string("Async I/O started with backend: ") + m_pBackend->getName() + "\n");
+}
+
+
+void AsyncIOQueue::shutDown()
+{
+  {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    if (!m_running) return;
+    m_running = false;
+  }
+  m_workCond.notify_all();
+  if (m_thread.joinable()) m_thread.join();
+
+  // Nothing will service what is left.
+  std::unique_lock<std::mutex> lck(m_mutex);
+  for (U32 p = 0; p < AsyncIOPriority_Count; ++p) {
+    while (!m_queues[p].empty()) {
+      Request request = std::move(m_queues[p].front());
+      m_queues[p].pop_front();
+      lck.unlock();
+      complete(request, AsyncIOStatus_Canceled);
+      lck.lock();
+    }
+  }
+  lck.unlock();
+
+  delete m_pBackend;
+  m_pBackend = nullptr;
+  m_pPool = nullptr;
+}
+
+
+async_io_id_t AsyncIOQueue::submit(const std::string& path, AsyncFileHandle* pHandle, AsyncIOPriority priority,
+                                   async_io_callback_t onComplete, JobCounter* pCounter)
+{
+  R_ASSERT(pHandle, "Null handle passed for async read!\n");
+  if (priority >= AsyncIOPriority_Count) priority = AsyncIOPriority_Critical;
+
+  Request request;
+  request._path = path;
+  request._pHandle = pHandle;
+  request._onComplete = onComplete;
+  request._pCounter = pCounter;
+  if (pCounter && m_pPool) m_pPool->BeginExternalWork(pCounter);
+
+  std::unique_lock<std::mutex> lck(m_mutex);
+  request._id = m_nextId++;
+  pHandle->Id = request._id;
+  pHandle->Status.store(AsyncIOStatus_Pending, std::memory_order_release);
+  if (!m_running) {
+    lck.unlock();
+    async_io_id_t id = request._id;
+    service(&request, 1);
+    return id;
+  }
+  m_queues[priority].push_back(std::move(request));
+  lck.unlock();
+  m_workCond.notify_one();
+  return pHandle->Id;
+}
+
+
+B32 AsyncIOQueue::cancel(async_io_id_t id)
+{
+  std::unique_lock<std::mutex> lck(m_mutex);
+  for (U32 p = 0; p < AsyncIOPriority_Count; ++p) {
+    std::deque<Request>& queue = m_queues[p];
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+      if (it->_id != id) continue;
+      Request request = std::move(*it);
+      queue.erase(it);
+      lck.unlock();
+      complete(request, AsyncIOStatus_Canceled);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+void AsyncIOQueue::wait(AsyncFileHandle* pHandle)
+{
+  std::unique_lock<std::mutex> lck(m_mutex);
+  m_doneCond.wait(lck, [pHandle] () -> bool {
+    return pHandle->Status.load(std::memory_order_acquire) != AsyncIOStatus_Pending
+      && pHandle->Status.load(std::memory_order_acquire) != AsyncIOStatus_Reading;
+  });
+}
+
+
+size_t AsyncIOQueue::getPendingCount()
+{
+  std::lock_guard<std::mutex> lck(m_mutex);
+  size_t count = 0;
+  for (U32 p = 0; p < AsyncIOPriority_Count; ++p) count += m_queues[p].size();
+  return count;
+}
+
+
+void AsyncIOQueue::threadLoop()
+{
+  std::vector<Request> batch;
+  batch.reserve(kMaxBatchSize);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lck(m_mutex);
+      m_workCond.wait(lck, [this] () -> bool {
+        if (!m_running) return true;
+        for (U32 p = 0; p < AsyncIOPriority_Count; ++p) {
+          if (!m_queues[p].empty()) return true;
+        }
+        return false;
+      });
+      if (!m_running) return;
+
+      // Highest priority first, in submission order within a priority.
+      for (I32 p = AsyncIOPriority_Count - 1; p >= 0 && batch.size() < kMaxBatchSize; --p) {
+        std::deque<Request>& queue = m_queues[p];
+        while (!queue.empty() && batch.size() < kMaxBatchSize) {
+          batch.push_back(std::move(queue.front()));
+          queue.pop_front();
+        }
+      }
+      for (Request& request : batch) {
+        request._pHandle->Status.store(AsyncIOStatus_Reading, std::memory_order_release);
+      }
+    }
+
+    service(batch.data(), static_cast<U32>(batch.size()));
+    batch.clear();
+  }
+}
+
+
+void AsyncIOQueue::service(Request* requests, U32 count)
+{
+  AsyncIORead reads[kMaxBatchSize];
+  BlockingIOBackend blocking;
+  AsyncIOBackend* backend = m_pBackend ? m_pBackend : &blocking;
+  for (U32 i = 0; i < count; ++i) {
+    reads[i]._path = requests[i]._path.c_str();
+    reads[i]._buffer = nullptr;
+    reads[i]._size = 0;
+    reads[i]._success = false;
+  }
+  backend->read(reads, count);
+
+  for (U32 i = 0; i < count; ++i) {
+    AsyncFileHandle* handle = requests[i]._pHandle;
+    delete[] handle->Buf;
+    handle->Buf = reads[i]._buffer;
+    handle->Sz = reads[i]._success ? reads[i]._size : FileHandle::kNoFile;
+    complete(requests[i], reads[i]._success ? AsyncIOStatus_Complete : AsyncIOStatus_Failed);
+  }
+}
+
+
+void AsyncIOQueue::complete(Request& request, AsyncIOStatus status)
+{
+  AsyncFileHandle* handle = request._pHandle;
+  {
+    // Status is published under the lock, so waiters can not miss the notify.
+    std::lock_guard<std::mutex> lck(m_mutex);
+    handle->Status.store(status, std::memory_order_release);
+  }
+  m_doneCond.notify_all();
+
+  if (status != AsyncIOStatus_Canceled && request._onComplete) {
+    if (m_pPool) {
+      async_io_callback_t onComplete = std::move(request._onComplete);
+      m_pPool->AddTask([onComplete, handle] () -> void { onComplete(handle); }, request._pCounter);
+    } else {
+      request._onComplete(handle);
+    }
+  }
+
+  // Callback job, if any, holds the counter from here on.
+  if (request._pCounter && m_pPool) m_pPool->EndExternalWork(request._pCounter);
+}
+} // Recluse
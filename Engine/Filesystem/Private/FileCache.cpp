@@ -0,0 +1,51 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "FileCache.hpp"
+
+
+namespace Recluse {
+
+
+std::shared_ptr<MappedFile> FileCache::map(const std::string& path)
+{
+  std::lock_guard<std::mutex> lck(m_mutex);
+  auto it = m_files.find(path);
+  if (it != m_files.end()) {
+    std::shared_ptr<MappedFile> file = it->second.lock();
+    if (file) return file;
+  }
+
+  std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+  if (!file->open(path)) {
+    if (it != m_files.end()) m_files.erase(it);
+    return nullptr;
+  }
+
+  // Sweep out mappings that are gone, every time the cache doubles.
+  if (it == m_files.end() && !m_files.empty() && (m_files.size() & (m_files.size() - 1)) == 0) {
+    for (auto entry = m_files.begin(); entry != m_files.end(); ) {
+      if (entry->second.expired()) entry = m_files.erase(entry);
+      else ++entry;
+    }
+  }
+  m_files[path] = file;
+  return file;
+}
+
+
+void FileCache::clear()
+{
+  std::lock_guard<std::mutex> lck(m_mutex);
+  m_files.clear();
+}
+
+
+size_t FileCache::getMappedCount()
+{
+  std::lock_guard<std::mutex> lck(m_mutex);
+  size_t count = 0;
+  for (auto& entry : m_files) {
+    if (!entry.second.expired()) count++;
+  }
+  return count;
+}
+} // Recluse
@@ -1,8 +1,8 @@
 // Copyright (c) 2017 Recluse Project. All rights reserved.
 #include "Filesystem.hpp"
+#include "FilesystemPlatform.hpp"
 
 #include "Core/Core.hpp"
-#include "Core/Win32/Win32Configs.hpp"
 #include "Core/Exception.hpp"
 
 #include <algorithm>
@@ -23,16 +23,15 @@ void Filesystem::onStartUp()
     return;
   }
 
-  char buffer[MAX_PATH];
-  GetModuleFileName(NULL, buffer, MAX_PATH);
-  std::string::size_type pos = std::string(buffer).find_last_of("\\/");
-  m_CurrentDirectoryPath = std::string(buffer).substr(0, pos);
-  std::replace(m_CurrentDirectoryPath.begin(), m_CurrentDirectoryPath.end(), '\\', '/');  
+  m_CurrentDirectoryPath = PlatformExecutableDirectory();
+  m_AsyncQueue.startUp(&gCore().ThrPool());
 }
 
 
 void Filesystem::onShutDown()
 {
+  m_AsyncQueue.shutDown();
+  m_FileCache.clear();
 }
 
 
@@ -44,47 +43,51 @@ const TChar* Filesystem::CurrentAppDirectory()
 
 FilesystemResult Filesystem::ReadFrom(const TChar* filepath, FileHandle* buf)
 {
-  HANDLE fileH = CreateFile(filepath, 
-                            GENERIC_READ, 
-                            0, 
-                            NULL, 
-                            OPEN_EXISTING, 
-                            FILE_ATTRIBUTE_NORMAL, 
-                            NULL);
-  if (fileH == INVALID_HANDLE_VALUE) {
-    return FilesystemResult_NotFound;
-  }
-  DWORD sz = GetFileSize(fileH, NULL);
-  DWORD bytesRead;
-  buf->Buf = new TChar[sz + 1];
-  buf->Sz = sz;
-  ReadFile(fileH, buf->Buf, sz, &bytesRead, NULL);
-  CloseHandle(fileH);
-  buf->Buf[sz] = '\0';
-  return FilesystemResult_Success;
+  return PlatformReadFile(filepath, buf);
 }
 
 
 FilesystemResult Filesystem::WriteTo(const TChar* filepath, TChar* in, U32 sz)
 {
-  HANDLE fileH = CreateFile(filepath, 
-                            GENERIC_WRITE, 
-                            0, 
-                            NULL, 
-                            OPEN_ALWAYS,  
-                            FILE_ATTRIBUTE_NORMAL, 
-                            NULL);
-  if (fileH == INVALID_HANDLE_VALUE) {
-    return FilesystemResult_Failed;
-  }
+  return PlatformWriteFile(filepath, in, sz);
+}
 
-  DWORD numBytesWritten = 0;
-  BOOL written = WriteFile(fileH, in, sz, &numBytesWritten, 0);
 
-  if (!written) {
-    return FilesystemResult_Failed;
-  }
+FilesystemResult Filesystem::MapFile(const TChar* filepath, FileView* view)
+{
+  view->m_pFile = m_FileCache.map(filepath);
+  if (view->m_pFile) return FilesystemResult_Success;
+  return PlatformFileExists(filepath) ? FilesystemResult_Failed : FilesystemResult_NotFound;
+}
+
+
+async_io_id_t Filesystem::AsyncReadFile(const TChar* filepath, AsyncFileHandle* buf, AsyncIOPriority priority,
+                                        async_io_callback_t onComplete, JobCounter* counter)
+{
+  return m_AsyncQueue.submit(filepath, buf, priority, onComplete, counter);
+}
+
+
+B32 Filesystem::CancelAsyncRead(async_io_id_t id)
+{
+  return m_AsyncQueue.cancel(id);
+}
+
+
+void Filesystem::WaitAsyncRead(AsyncFileHandle* buf)
+{
+  m_AsyncQueue.wait(buf);
+}
 
-  return FilesystemResult_Success;
+
+B8 Filesystem::FileExists(TChar* Filepath)
+{
+  return PlatformFileExists(Filepath) ? true : false;
+}
+
+
+B8 Filesystem::DirectoryExists(TChar* DirectoryPath)
+{
+  return PlatformDirectoryExists(DirectoryPath) ? true : false;
 }
-} // Recluse
\ No newline at end of file
+} // Recluse
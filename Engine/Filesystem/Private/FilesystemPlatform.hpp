@@ -0,0 +1,51 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Filesystem.hpp"
+
+#include <string>
+
+namespace Recluse {
+
+
+// Platform specific parts of the Filesystem, implemented for each OS.
+
+std::string       PlatformExecutableDirectory();
+FilesystemResult  PlatformReadFile(const TChar* filepath, FileHandle* out);
+FilesystemResult  PlatformWriteFile(const TChar* filepath, const TChar* in, U64 sz);
+B32               PlatformFileExists(const TChar* filepath);
+B32               PlatformDirectoryExists(const TChar* path);
+
+
+// Whole file read, as handed to an AsyncIOBackend.
+struct AsyncIORead {
+  const TChar*      _path;
+  // Out. Null terminated, allocated with new[].
+  TChar*            _buffer;
+  U64               _size;
+  B32               _success;
+};
+
+
+// Services batches of reads for the AsyncIOQueue, on its I/O thread.
+class AsyncIOBackend {
+public:
+  virtual ~AsyncIOBackend() { }
+
+  virtual void      read(AsyncIORead* reads, U32 count) = 0;
+  virtual const TChar* getName() const = 0;
+};
+
+
+// Reads one file after the other, with PlatformReadFile().
+class BlockingIOBackend : public AsyncIOBackend {
+public:
+  void              read(AsyncIORead* reads, U32 count) override;
+  const TChar*      getName() const override { return "Blocking"; }
+};
+
+
+// Best backend available on this system.
+AsyncIOBackend*   CreateAsyncIOBackend(U32 maxBatchSize);
+} // Recluse
@@ -0,0 +1,400 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "../FilesystemPlatform.hpp"
+
+#if !defined(_WIN32)
+#include "Core/Logging/Log.hpp"
+#include "Core/Exception.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+ #if __has_include(<linux/io_uring.h>)
+  #include <linux/io_uring.h>
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  // Plain reads are supported by every kernel with fast poll (5.7).
+  #if defined(IORING_FEAT_FAST_POLL) && defined(__NR_io_uring_setup)
+   #define R_HAS_IO_URING 1
+  #endif
+ #endif
+#endif
+
+#if !defined(R_HAS_IO_URING)
+ #define R_HAS_IO_URING 0
+#endif
+
+namespace Recluse {
+
+
+std::string PlatformExecutableDirectory()
+{
+  char buffer[PATH_MAX];
+  ssize_t len = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+  if (len <= 0) {
+    if (!getcwd(buffer, sizeof(buffer))) return ".";
+    return buffer;
+  }
+  buffer[len] = '\0';
+  std::string path(buffer);
+  std::string::size_type pos = path.find_last_of('/');
+  return (pos == std::string::npos) ? path : path.substr(0, pos);
+}
+
+
+FilesystemResult PlatformReadFile(const TChar* filepath, FileHandle* buf)
+{
+  I32 fd = open(filepath, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return (errno == ENOENT) ? FilesystemResult_NotFound : FilesystemResult_Failed;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return FilesystemResult_Failed;
+  }
+
+  U64 sz = static_cast<U64>(st.st_size);
+  TChar* data = new TChar[sz + 1];
+  U64 total = 0;
+  while (total < sz) {
+    ssize_t bytesRead = pread(fd, data + total, sz - total, static_cast<off_t>(total));
+    if (bytesRead < 0 && errno == EINTR) continue;
+    if (bytesRead <= 0) {
+      delete[] data;
+      close(fd);
+      return FilesystemResult_Failed;
+    }
+    total += static_cast<U64>(bytesRead);
+  }
+  close(fd);
+  data[sz] = '\0';
+  delete[] buf->Buf;
+  buf->Buf = data;
+  buf->Sz = sz;
+  return FilesystemResult_Success;
+}
+
+
+FilesystemResult PlatformWriteFile(const TChar* filepath, const TChar* in, U64 sz)
+{
+  I32 fd = open(filepath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return FilesystemResult_Failed;
+  }
+
+  U64 total = 0;
+  while (total < sz) {
+    ssize_t written = write(fd, in + total, sz - total);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) {
+      close(fd);
+      return FilesystemResult_Failed;
+    }
+    total += static_cast<U64>(written);
+  }
+  return (close(fd) == 0) ? FilesystemResult_Success : FilesystemResult_Failed;
+}
+
+
+B32 PlatformFileExists(const TChar* filepath)
+{
+  struct stat st;
+  return (stat(filepath, &st) == 0) && S_ISREG(st.st_mode);
+}
+
+
+B32 PlatformDirectoryExists(const TChar* path)
+{
+  struct stat st;
+  return (stat(path, &st) == 0) && S_ISDIR(st.st_mode);
+}
+
+
+#if R_HAS_IO_URING
+// io_uring backend, set up through raw system calls. All reads of a batch are handed to the
+// kernel together, and large files are split in pieces, so the device queue is kept full.
+class IoUringBackend : public AsyncIOBackend {
+public:
+  // Largest single read handed to the kernel.
+  static const U32 kMaxReadSize = 8 * 1024 * 1024;
+
+  IoUringBackend()
+    : m_ringFd(-1)
+    , m_pSqRing(nullptr)
+    , m_pCqRing(nullptr)
+    , m_pSqes(nullptr)
+    , m_sqRingSize(0)
+    , m_cqRingSize(0)
+    , m_sqesSize(0)
+    , m_broken(false) { }
+
+  ~IoUringBackend()
+  {
+    if (m_pSqes) munmap(m_pSqes, m_sqesSize);
+    if (m_pCqRing && m_pCqRing != m_pSqRing) munmap(m_pCqRing, m_cqRingSize);
+    if (m_pSqRing) munmap(m_pSqRing, m_sqRingSize);
+    if (m_ringFd >= 0) close(m_ringFd);
+  }
+
+  B32 initialize(U32 entries)
+  {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ringFd = static_cast<I32>(syscall(__NR_io_uring_setup, entries, &params));
+    if (m_ringFd < 0) return false;
+    if (!(params.features & IORING_FEAT_FAST_POLL)) return false;
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(U32);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    B32 singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+      if (m_cqRingSize > m_sqRingSize) m_sqRingSize = m_cqRingSize;
+      m_cqRingSize = m_sqRingSize;
+    }
+
+    void* sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      m_ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) return false;
+    m_pSqRing = static_cast<U8*>(sqRing);
+
+    if (singleMap) {
+      m_pCqRing = m_pSqRing;
+    } else {
+      void* cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        m_ringFd, IORING_OFF_CQ_RING);
+      if (cqRing == MAP_FAILED) return false;
+      m_pCqRing = static_cast<U8*>(cqRing);
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      m_ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    m_pSqes = static_cast<struct io_uring_sqe*>(sqes);
+
+    m_sqHead = reinterpret_cast<U32*>(m_pSqRing + params.sq_off.head);
+    m_sqTail = reinterpret_cast<U32*>(m_pSqRing + params.sq_off.tail);
+    m_sqMask = *reinterpret_cast<U32*>(m_pSqRing + params.sq_off.ring_mask);
+    m_sqEntries = *reinterpret_cast<U32*>(m_pSqRing + params.sq_off.ring_entries);
+    m_sqArray = reinterpret_cast<U32*>(m_pSqRing + params.sq_off.array);
+    m_cqHead = reinterpret_cast<U32*>(m_pCqRing + params.cq_off.head);
+    m_cqTail = reinterpret_cast<U32*>(m_pCqRing + params.cq_off.tail);
+    m_cqMask = *reinterpret_cast<U32*>(m_pCqRing + params.cq_off.ring_mask);
+    m_cqEntries = *reinterpret_cast<U32*>(m_pCqRing + params.cq_off.ring_entries);
+    m_cqes = reinterpret_cast<struct io_uring_cqe*>(m_pCqRing + params.cq_off.cqes);
+    return true;
+  }
+
+  const TChar* getName() const override { return "io_uring"; }
+
+  void read(AsyncIORead* reads, U32 count) override
+  {
+    if (m_broken) {
+      m_fallback.read(reads, count);
+      return;
+    }
+
+    struct FileState {
+      I32   _fd;
+      U64   _size;
+      U64   _done;
+      // Next offset to hand to the kernel.
+      U64   _next;
+      U32   _inFlight;
+      B32   _failed;
+    };
+    struct Segment {
+      U32   _file;
+      U64   _offset;
+      U32   _size;
+    };
+
+    std::vector<FileState> files(count);
+    std::vector<Segment> segments;
+    // Pieces to hand to the kernel again, after short, or interrupted, reads.
+    std::vector<U32> retries;
+
+    for (U32 i = 0; i < count; ++i) {
+      FileState& file = files[i];
+      file._fd = open(reads[i]._path, O_RDONLY | O_CLOEXEC);
+      file._size = 0;
+      file._done = 0;
+      file._next = 0;
+      file._inFlight = 0;
+      file._failed = (file._fd < 0);
+      struct stat st;
+      if (!file._failed && fstat(file._fd, &st) != 0) file._failed = true;
+      if (!file._failed) {
+        file._size = static_cast<U64>(st.st_size);
+        reads[i]._buffer = new TChar[file._size + 1];
+      }
+    }
+
+    U32 inFlight = 0;
+    B32 ringFailed = false;
+    for (;;) {
+      // Queue up as many pieces as the ring takes, and no more than the completion queue holds,
+      // so that completions are never dropped.
+      U32 tail = *m_sqTail;
+      U32 head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+      while (!ringFailed && (tail - head) < m_sqEntries && inFlight < m_cqEntries) {
+        U32 segmentIdx = 0xffffffff;
+        if (!retries.empty()) {
+          segmentIdx = retries.back();
+          retries.pop_back();
+        } else {
+          for (U32 i = 0; i < count; ++i) {
+            FileState& file = files[i];
+            if (file._failed || file._next >= file._size) continue;
+            U64 remaining = file._size - file._next;
+            Segment segment = { i, file._next, static_cast<U32>(remaining > kMaxReadSize ? kMaxReadSize : remaining) };
+            file._next += segment._size;
+            segmentIdx = static_cast<U32>(segments.size());
+            segments.push_back(segment);
+            break;
+          }
+        }
+        if (segmentIdx == 0xffffffff) break;
+
+        const Segment& segment = segments[segmentIdx];
+        FileState& file = files[segment._file];
+        struct io_uring_sqe* sqe = &m_pSqes[tail & m_sqMask];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = file._fd;
+        sqe->addr = reinterpret_cast<U64>(reads[segment._file]._buffer + segment._offset);
+        sqe->len = segment._size;
+        sqe->off = segment._offset;
+        sqe->user_data = segmentIdx;
+        m_sqArray[tail & m_sqMask] = tail & m_sqMask;
+        tail++;
+        __atomic_store_n(m_sqTail, tail, __ATOMIC_RELEASE);
+        file._inFlight++;
+        inFlight++;
+      }
+
+      // Retries are queued first, so nothing in flight means everything is done. Failed batches
+      // still wait for every read handed to the kernel, so none complete into the next batch.
+      if (inFlight == 0) break;
+
+      // Submit whatever the kernel has not picked up yet, or wait for a completion.
+      U32 sqHead = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+      U32 toSubmit = tail - sqHead;
+      I32 ret = enter(toSubmit, toSubmit ? 0 : 1);
+      if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        if (ringFailed) {
+          // Completions can not be waited on anymore. The ring, and the buffers the kernel may 
+          // still write, are given up for good.
+          R_DEBUG(rError, "io_uring can not be waited on, falling back to blocking reads.\n");
+          m_broken = true;
+          break;
+        }
+        R_DEBUG(rError, "io_uring_enter failed, aborting batch.\n");
+        ringFailed = true;
+        // Take back the pieces the kernel never picked up.
+        for (U32 i = sqHead; i != tail; ++i) {
+          const Segment& segment = segments[static_cast<U32>(m_pSqes[i & m_sqMask].user_data)];
+          files[segment._file]._inFlight--;
+          inFlight--;
+        }
+        __atomic_store_n(m_sqTail, sqHead, __ATOMIC_RELEASE);
+      }
+
+      U32 cqHead = *m_cqHead;
+      U32 cqTail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+      while (cqHead != cqTail) {
+        const struct io_uring_cqe& cqe = m_cqes[cqHead & m_cqMask];
+        U32 segmentIdx = static_cast<U32>(cqe.user_data);
+        Segment& segment = segments[segmentIdx];
+        FileState& file = files[segment._file];
+        file._inFlight--;
+        inFlight--;
+        if (ringFailed) {
+          // Drained only.
+        } else if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+          retries.push_back(segmentIdx);
+        } else if (cqe.res <= 0) {
+          // Errors, or the file shrank under us.
+          file._failed = true;
+        } else {
+          U32 bytesRead = static_cast<U32>(cqe.res);
+          file._done += bytesRead;
+          if (bytesRead < segment._size) {
+            segment._offset += bytesRead;
+            segment._size -= bytesRead;
+            retries.push_back(segmentIdx);
+          }
+        }
+        cqHead++;
+      }
+      __atomic_store_n(m_cqHead, cqHead, __ATOMIC_RELEASE);
+    }
+
+    for (U32 i = 0; i < count; ++i) {
+      FileState& file = files[i];
+      if (file._fd >= 0) close(file._fd);
+      B32 success = !ringFailed && !file._failed && file._done == file._size;
+      if (success) {
+        reads[i]._buffer[file._size] = '\0';
+        reads[i]._size = file._size;
+        reads[i]._success = true;
+      } else {
+        // Buffers still targeted by reads in the kernel can not be freed.
+        if (file._inFlight == 0) delete[] reads[i]._buffer;
+        reads[i]._buffer = nullptr;
+        reads[i]._size = 0;
+        reads[i]._success = false;
+      }
+    }
+  }
+
+private:
+  I32 enter(U32 toSubmit, U32 minComplete)
+  {
+    return static_cast<I32>(syscall(__NR_io_uring_enter, m_ringFd, toSubmit, minComplete,
+      minComplete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+  }
+
+  I32                   m_ringFd;
+  U8*                   m_pSqRing;
+  U8*                   m_pCqRing;
+  struct io_uring_sqe*  m_pSqes;
+  size_t                m_sqRingSize;
+  size_t                m_cqRingSize;
+  size_t                m_sqesSize;
+  U32*                  m_sqHead;
+  U32*                  m_sqTail;
+  U32                   m_sqMask;
+  U32                   m_sqEntries;
+  U32*                  m_sqArray;
+  U32*                  m_cqHead;
+  U32*                  m_cqTail;
+  U32                   m_cqMask;
+  U32                   m_cqEntries;
+  struct io_uring_cqe*  m_cqes;
+  // Set once the ring can no longer be used, after which reads block instead.
+  B32                   m_broken;
+  BlockingIOBackend     m_fallback;
+};
+#endif
+
+
+AsyncIOBackend* CreateAsyncIOBackend(U32 maxBatchSize)
+{
+#if R_HAS_IO_URING
+  IoUringBackend* backend = new IoUringBackend();
+  if (backend->initialize(maxBatchSize)) return backend;
+  // Kernel too old, or io_uring disabled.
+  delete backend;
+#endif
+  return new BlockingIOBackend();
+}
+} // Recluse
+#endif
@@ -0,0 +1,115 @@
+// Copyright (c) 2017 Recluse Project. All rights reserved.
+#include "../FilesystemPlatform.hpp"
+
+#if defined(_WIN32)
+#include "Core/Win32/Win32Configs.hpp"
+
+#include <algorithm>
+
+namespace Recluse {
+
+
+std::string PlatformExecutableDirectory()
+{
+  char buffer[MAX_PATH];
+  GetModuleFileName(NULL, buffer, MAX_PATH);
+  std::string::size_type pos = std::string(buffer).find_last_of("\\/");
+  std::string path = std::string(buffer).substr(0, pos);
+  std::replace(path.begin(), path.end(), '\\', '/');
+  return path;
+}
+
+
+FilesystemResult PlatformReadFile(const TChar* filepath, FileHandle* buf)
+{
+  HANDLE fileH = CreateFile(filepath, 
+                            GENERIC_READ, 
+                            FILE_SHARE_READ, 
+                            NULL, 
+                            OPEN_EXISTING, 
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 
+                            NULL);
+  if (fileH == INVALID_HANDLE_VALUE) {
+    return FilesystemResult_NotFound;
+  }
+  LARGE_INTEGER sz;
+  if (!GetFileSizeEx(fileH, &sz)) {
+    CloseHandle(fileH);
+    return FilesystemResult_Failed;
+  }
+  TChar* data = new TChar[static_cast<size_t>(sz.QuadPart) + 1];
+
+  // ReadFile takes at most 4 GB at a time.
+  U64 total = 0;
+  while (total < static_cast<U64>(sz.QuadPart)) {
+    U64 remaining = static_cast<U64>(sz.QuadPart) - total;
+    DWORD toRead = remaining > 0x40000000ull ? 0x40000000u : static_cast<DWORD>(remaining);
+    DWORD bytesRead = 0;
+    if (!ReadFile(fileH, data + total, toRead, &bytesRead, NULL) || bytesRead == 0) {
+      delete[] data;
+      CloseHandle(fileH);
+      return FilesystemResult_Failed;
+    }
+    total += bytesRead;
+  }
+  CloseHandle(fileH);
+  data[total] = '\0';
+  delete[] buf->Buf;
+  buf->Buf = data;
+  buf->Sz = total;
+  return FilesystemResult_Success;
+}
+
+
+FilesystemResult PlatformWriteFile(const TChar* filepath, const TChar* in, U64 sz)
+{
+  HANDLE fileH = CreateFile(filepath, 
+                            GENERIC_WRITE, 
+                            0, 
+                            NULL, 
+                            CREATE_ALWAYS,  
+                            FILE_ATTRIBUTE_NORMAL, 
+                            NULL);
+  if (fileH == INVALID_HANDLE_VALUE) {
+    return FilesystemResult_Failed;
+  }
+
+  U64 total = 0;
+  while (total < sz) {
+    U64 remaining = sz - total;
+    DWORD toWrite = remaining > 0x40000000ull ? 0x40000000u : static_cast<DWORD>(remaining);
+    DWORD numBytesWritten = 0;
+    if (!WriteFile(fileH, in + total, toWrite, &numBytesWritten, 0)) {
+      CloseHandle(fileH);
+      return FilesystemResult_Failed;
+    }
+    total += numBytesWritten;
+  }
+
+  CloseHandle(fileH);
+  return FilesystemResult_Success;
+}
+
+
+B32 PlatformFileExists(const TChar* filepath)
+{
+  DWORD attributes = GetFileAttributes(filepath);
+  return (attributes != INVALID_FILE_ATTRIBUTES) && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+
+B32 PlatformDirectoryExists(const TChar* path)
+{
+  DWORD attributes = GetFileAttributes(path);
+  return (attributes != INVALID_FILE_ATTRIBUTES) && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+
+AsyncIOBackend* CreateAsyncIOBackend(U32 maxBatchSize)
+{
+  // Reads are serviced off the game thread either way, so blocking reads on the I/O thread
+  // are as good as overlapped I/O for whole file loads.
+  return new BlockingIOBackend();
+}
+} // Recluse
+#endif
@@ -0,0 +1,110 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "File.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Recluse {
+
+
+class ThreadPool;
+class JobCounter;
+class AsyncIOBackend;
+struct AsyncFileHandle;
+
+
+typedef U64 async_io_id_t;
+typedef std::function<void(AsyncFileHandle*)> async_io_callback_t;
+
+
+enum AsyncIOPriority {
+  AsyncIOPriority_Low,
+  AsyncIOPriority_Normal,
+  AsyncIOPriority_High,
+  // Needed this frame, such as data the game thread is blocked on.
+  AsyncIOPriority_Critical,
+  AsyncIOPriority_Count
+};
+
+
+enum AsyncIOStatus {
+  AsyncIOStatus_None,
+  AsyncIOStatus_Pending,
+  AsyncIOStatus_Reading,
+  AsyncIOStatus_Complete,
+  AsyncIOStatus_Failed,
+  AsyncIOStatus_Canceled
+};
+
+
+struct AsyncFileHandle : public FileHandle {
+  AsyncFileHandle()
+    : Status(AsyncIOStatus_None)
+    , Id(0) { }
+
+  // Check if the file is finished reading. If not,
+  // Buf and Sz are not readable!
+  B8                  Finished() const { return Status.load(std::memory_order_acquire) >= AsyncIOStatus_Complete; }
+  B8                  Succeeded() const { return Status.load(std::memory_order_acquire) == AsyncIOStatus_Complete; }
+
+  std::atomic<U32>    Status;
+  async_io_id_t       Id;
+};
+
+
+// Queue of asynchronous file reads, serviced in priority order by a dedicated I/O thread, which
+// hands batches of reads to the OS at once. Completion callbacks are run as ThreadPool jobs.
+class AsyncIOQueue {
+public:
+  // Max number of reads handed to the OS at once.
+  static const U32    kMaxBatchSize = 32;
+
+  AsyncIOQueue();
+  ~AsyncIOQueue();
+
+  // Reads submitted while the queue is not started are serviced on the calling thread.
+  void                startUp(ThreadPool* pPool);
+  void                shutDown();
+
+  async_io_id_t       submit(const std::string& path, AsyncFileHandle* pHandle, AsyncIOPriority priority,
+                             async_io_callback_t onComplete, JobCounter* pCounter);
+
+  // Cancel a read that has not been handed to the OS yet. Canceled reads do not run their callback.
+  B32                 cancel(async_io_id_t id);
+
+  void                wait(AsyncFileHandle* pHandle);
+
+  size_t              getPendingCount();
+
+private:
+  struct Request {
+    async_io_id_t         _id;
+    std::string           _path;
+    AsyncFileHandle*      _pHandle;
+    async_io_callback_t   _onComplete;
+    JobCounter*           _pCounter;
+  };
+
+  void                threadLoop();
+  void                service(Request* requests, U32 count);
+  void                complete(Request& request, AsyncIOStatus status);
+
+  std::deque<Request>     m_queues[AsyncIOPriority_Count];
+  std::mutex              m_mutex;
+  std::condition_variable m_workCond;
+  std::condition_variable m_doneCond;
+  std::thread             m_thread;
+  ThreadPool*             m_pPool;
+  AsyncIOBackend*         m_pBackend;
+  B32                     m_running;
+  async_io_id_t           m_nextId;
+};
+} // Recluse
@@ -2,6 +2,44 @@
 #pragma once
 
 #include "Core/Types.hpp"
+#include "Core/Utility/MappedFile.hpp"
+
+#include <memory>
 
 namespace Recluse {
-} // Recluse
\ No newline at end of file
+
+
+// File read into memory. Buf is null terminated, and owned by the handle.
+struct FileHandle {
+  U64   Sz;
+  TChar*   Buf;
+
+  static const U64 kNoFile = 0xffffffffffffffff;
+
+  FileHandle()
+    : Sz(kNoFile)
+    , Buf(nullptr) { }
+
+  virtual ~FileHandle()
+  {
+    delete[] Buf;
+    Buf = nullptr;
+  }
+};
+
+
+// Read only view of a memory mapped file. Copies share the same mapping, which is unmapped
+// once the last view of it is released.
+class FileView {
+public:
+  const U8*     data() const { return m_pFile ? m_pFile->data() : nullptr; }
+  size_t        size() const { return m_pFile ? m_pFile->size() : 0; }
+  B32           isValid() const { return m_pFile != nullptr; }
+  void          release() { m_pFile.reset(); }
+
+private:
+  std::shared_ptr<MappedFile> m_pFile;
+
+  friend class Filesystem;
+};
+} // Recluse
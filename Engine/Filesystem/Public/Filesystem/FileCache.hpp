@@ -0,0 +1,33 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Utility/MappedFile.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Recluse {
+
+
+// Cache of memory mapped files, so that mapping a file that is already mapped hands out the
+// same mapping. The cache does not keep files mapped on its own, mappings go away along with
+// their last user.
+class FileCache {
+public:
+  // Get the mapping of a file, mapping it if needed. Returns null if the file can not be mapped.
+  std::shared_ptr<MappedFile> map(const std::string& path);
+
+  // Forget all mappings. Mappings still in use stay valid.
+  void                        clear();
+
+  // Number of files currently mapped.
+  size_t                      getMappedCount();
+
+private:
+  std::mutex                                                  m_mutex;
+  std::unordered_map<std::string, std::weak_ptr<MappedFile> > m_files;
+};
+} // Recluse
@@ -1,5 +1,5 @@
 // Copyright (c) 2017 Recluse Project. All rights reserved.
-#pragma once 
+#pragma once
 
 #include "Core/Types.hpp"
 #include "Core/Utility/Module.hpp"
@@ -7,33 +7,12 @@
 
 #include "Game/Scene/Scene.hpp"
 
-
-namespace Recluse {
-
-
-struct FileHandle {
-  U64   Sz;
-  TChar*   Buf;
-
-  static const U64 kNoFile = 0xffffffffffffffff; 
-  
-  FileHandle()
-    : Sz(kNoFile)
-    , Buf(nullptr) { }
-
-  virtual ~FileHandle()
-  {
-    if (Sz != kNoFile) { delete Buf; }
-    Buf = nullptr;
-  }
-};
+#include "File.hpp"
+#include "FileCache.hpp"
+#include "AsyncIO.hpp"
 
 
-struct AsyncFileHandle : public FileHandle {
-    // Check if the file is finished reading. If not, 
-    // Buf and Sz are not readable!
-    B8    Finished;
-};
+namespace Recluse {
 
 
 enum FilesystemResult {
@@ -60,7 +39,24 @@ public:
   void                      AppendSearchPath(TChar* path);
   FilesystemResult          ReadFrom(const TChar* filepath, FileHandle* Buf);
   FilesystemResult          WriteTo(const TChar* filepath, TChar* in, U32 sz);
-  void                      AsyncReadFile(AsyncFileHandle* Buf);
+
+  // Map a file for reading, without copying it. Views of the same file share one mapping.
+  FilesystemResult          MapFile(const TChar* filepath, FileView* view);
+
+  // Queue a read of a whole file, serviced by the I/O thread. The handle must stay alive
+  // until the read finishes, or is canceled. If given, the counter is held until the read,
+  // and the completion callback, are done, so jobs may depend on it. The callback runs on
+  // the ThreadPool.
+  async_io_id_t             AsyncReadFile(const TChar* filepath, AsyncFileHandle* Buf,
+                                          AsyncIOPriority priority = AsyncIOPriority_Normal,
+                                          async_io_callback_t onComplete = nullptr,
+                                          JobCounter* counter = nullptr);
+
+  // Cancel a queued read. Reads already handed to the OS can not be canceled.
+  B32                       CancelAsyncRead(async_io_id_t id);
+
+  // Block until the read is done, or canceled.
+  void                      WaitAsyncRead(AsyncFileHandle* Buf);
 
   // Current application directory of the executable.
   const TChar*              CurrentAppDirectory();
@@ -70,7 +66,7 @@ public:
   TChar*                    GetApplicationSourcePath();
   TChar*                    SetApplicationSourcePath(const TChar* SrcPath);
   std::vector<std::string>  DirectoryContents(std::string& Path);
-  std::vector<std::string>  SearchPaths() { return m_SearchPath; }  
+  std::vector<std::string>  SearchPaths() { return m_SearchPath; }
 
   // Load a scene from a file.
   B8                        LoadScene(Scene* output, std::string filepath);
@@ -79,8 +75,10 @@ private:
   std::string               m_CurrentDirectoryPath;
   std::string               m_AppSourcePath;
   std::vector<std::string>  m_SearchPath;
+  FileCache                 m_FileCache;
+  AsyncIOQueue              m_AsyncQueue;
 };
 
 
 Filesystem& gFilesystem();
-} // Recluse
\ No newline at end of file
+} // Recluse
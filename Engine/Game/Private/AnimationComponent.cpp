@@ -4,10 +4,17 @@
 
 #include "AnimationComponent.hpp"
 #include "GameObject.hpp"
+#include "MeshComponent.hpp"
+#include "Camera.hpp"
+#include "Engine.hpp"
+#include "Scene/AssetManager.hpp"
 #include "Core/Exception.hpp"
 #include "Core/Logging/Log.hpp"
 #include "Core/Utility/Time.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace Recluse {
 
 
@@ -32,6 +39,7 @@ void AnimationComponent::onInitialize(GameObject* owner)
 void AnimationComponent::addClip(AnimClip* clip, const std::string& name)
 {
   m_clips[name] = clip;
+  m_clipHandles[name] = gResourceRegistry().acquire<AnimClip>(clip);
 }
 
 
@@ -40,35 +48,170 @@ void AnimationComponent::playback(const std::string& name,  R32 rate, R32 atTime
   auto it = m_clips.find(name);
   if (it == m_clips.end()) return;
   m_currClip = it->second;
+  m_blends.clear();
+  m_targetWeight = 1.0f;
+  m_fadeRate = 0.0f;
   m_handle->_currState._tau = 0;
-  m_handle->_currState._next = 0;
+  m_handle->_currState._cursor.reset();
   m_handle->_currState._fCurrLocalTime = atTime * m_currClip->_fDuration;
   m_handle->_currState._fPlaybackRate = rate;
+  m_handle->_currState._fWeight = 1.0f;
+}
+
+
+// Move a weight toward its target, by rate per second.
+static R32 FadeWeight(R32 weight, R32 target, R32 rate, R32 dt)
+{
+  R32 step = rate * dt;
+  if (weight < target) return (target - weight > step) ? weight + step : target;
+  return (weight - target > step) ? weight - step : target;
 }
 
 
 void AnimationComponent::update()
 {
-  if ( m_currClip ) {
-    AnimClip* clip = m_currClip;
+  R32 dt = static_cast<R32>(Time::deltaTime);
+  m_handle->_currState._fWeight = FadeWeight(m_handle->_currState._fWeight, m_targetWeight, m_fadeRate, dt);
+  for (auto it = m_blends.begin(); it != m_blends.end(); ) {
+    BlendState& blend = it->second;
+    blend._state._fWeight = FadeWeight(blend._state._fWeight, blend._targetWeight, blend._fadeRate, dt);
+    if (blend._state._fWeight <= 0.0f && blend._targetWeight <= 0.0f) {
+      it = m_blends.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Once the clip played back has faded out, the heaviest clip blending in takes its place, 
+  // keeping its clock and fade, so finished crossfades go back to sampling a single clip.
+  if (m_handle->_currState._fWeight <= 0.0f && m_targetWeight <= 0.0f && !m_blends.empty()) {
+    auto promoted = m_blends.begin();
+    for (auto it = m_blends.begin(); it != m_blends.end(); ++it) {
+      if (it->second._state._fWeight > promoted->second._state._fWeight) promoted = it;
+    }
+    m_currClip = promoted->second._pClip;
+    m_handle->_currState = promoted->second._state;
+    m_targetWeight = promoted->second._targetWeight;
+    m_fadeRate = promoted->second._fadeRate;
+    m_blends.erase(promoted);
+  }
+
+  if (m_blends.empty()) {
+    if (!m_currClip) return;
     AnimJobSubmitInfo submit = {};
     submit._type = ANIM_JOB_TYPE_SAMPLE;
-    submit._pBaseClip = clip;
+    submit._pBaseClip = m_currClip;
     submit._output = m_handle;
     gAnimation().submitJob(submit);
+    return;
+  }
+
+  // Clips blending in are sampled alongside the one played back, in local space.
+  AnimJobSubmitInfo submit = {};
+  submit._type = ANIM_JOB_TYPE_BLEND;
+  submit._pBaseClip = m_currClip;
+  submit._output = m_handle;
+  submit._layers.reserve(m_blends.size());
+  for (auto& it : m_blends) {
+    AnimBlendLayer layer;
+    layer._pClip = it.second._pClip;
+    layer._pState = &it.second._state;
+    layer._weight = it.second._state._fWeight;
+    submit._layers.push_back(layer);
   }
+  gAnimation().submitJob(submit);
 }
 
 
 void AnimationComponent::blendPlayback(const std::string& name, R32 targetWeight, R32 fadeLen)
 {
-  AnimJobSubmitInfo info{}; 
+  auto it = m_clips.find(name);
+  if (it == m_clips.end()) return;
+  AnimClip* clip = it->second;
+  R32 weight = 0.0f;
+
+  if (clip == m_currClip) {
+    weight = m_handle->_currState._fWeight;
+    m_targetWeight = targetWeight;
+    m_fadeRate = (fadeLen > 0.0f) ? fabsf(targetWeight - weight) / fadeLen : 0.0f;
+    if (fadeLen <= 0.0f) m_handle->_currState._fWeight = targetWeight;
+    return;
+  }
+
+  auto blendIt = m_blends.find(name);
+  if (blendIt == m_blends.end()) {
+    // Clips blending in start from the top, at the rate of the one played back.
+    BlendState& blend = m_blends[name];
+    blend._pClip = clip;
+    blend._state._bEnabled = true;
+    blend._state._bLooping = true;
+    blend._state._fCurrLocalTime = 0.0f;
+    blend._state._fPlaybackRate = m_handle->_currState._fPlaybackRate;
+    blend._state._fWeight = 0.0f;
+    blend._state._tau = 0.0f;
+    blendIt = m_blends.find(name);
+  }
+
+  BlendState& blend = blendIt->second;
+  weight = blend._state._fWeight;
+  blend._targetWeight = targetWeight;
+  blend._fadeRate = (fadeLen > 0.0f) ? fabsf(targetWeight - weight) / fadeLen : 0.0f;
+  if (fadeLen <= 0.0f) blend._state._fWeight = targetWeight;
+}
+
+
+void AnimationComponent::UpdateLods()
+{
+  Camera* pMain = Camera::getMain();
+  B32 culling = (gEngine().getViewFrustumCount() > 0);
+  R32 tanHalfFov = 0.0f;
+  Vector3 eye;
+  if (pMain && pMain->currentProject() == Camera::PERSPECTIVE) {
+    tanHalfFov = tanf(pMain->getFoV() * 0.5f);
+    eye = pMain->getTransform()->_position;
+  }
+
+  for (size_t i = 0; i < _kAnimationComponents.size(); ++i) {
+    AnimationComponent* pComp = _kAnimationComponents[i];
+    AnimHandle* pHandle = pComp->m_handle;
+    MeshComponent* pMesh = pComp->m_pMesh;
+    if (!pHandle) continue;
+    pHandle->_visible = true;
+    pHandle->_screenSize = 1.0f;
+    if (!pMesh || !pMesh->enabled()) continue;
+
+    // Cull bits are set for the frustums a mesh is seen in.
+    if (culling && pMesh->AllowCulling() && pMesh->HasCullSlot()) {
+      pHandle->_visible = (pMesh->GetFrustumCullMap() != 0);
+    }
+
+    // Bounding sphere height, over the height of the view at its distance.
+    if (tanHalfFov <= 0.0f) continue;
+    const AABB& aabb = pMesh->GetWorldAABB();
+    R32 radius = (aabb.max - aabb.min).length() * 0.5f;
+    R32 dist = (aabb.centroid - eye).length();
+    if (dist <= radius) continue;
+    pHandle->_screenSize = std::min(radius / (dist * tanHalfFov), 1.0f);
+  }
+}
+
+
+B32 AnimationComponent::isPlayingBack(const std::string& name)
+{
+  auto it = m_clips.find(name);
+  if (it == m_clips.end()) return false;
+  if (it->second == m_currClip) return true;
+  auto blendIt = m_blends.find(name);
+  return (blendIt != m_blends.end()) && (blendIt->second._state._fWeight > 0.0f);
 }
 
 
 void AnimationComponent::setPlaybackRate(R32 rate)
 {
   m_handle->_currState._fPlaybackRate = rate;
+  for (auto& it : m_blends) {
+    it.second._state._fPlaybackRate = rate;
+  }
 }
 
 
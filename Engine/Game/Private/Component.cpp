@@ -5,6 +5,7 @@
 
 #include "Core/Logging/Log.hpp"
 #include "Core/Exception.hpp"
+#include "Core/Utility/Archive.hpp"
 
 
 namespace Recluse {
@@ -38,13 +39,64 @@ void Transform::update()
     m_localToWorldMatrix = localToWorldMatrix;
   }
 
+  updateAxes();
+  m_worldToLocalMatrix = m_localToWorldMatrix.inverse();
+}
+
+
+void Transform::updateAxes()
+{
   // Update local coordinates.
   Vector3 u = Vector3(_rotation.x, _rotation.y, _rotation.z);
   R32 s = _rotation.w;
   m_front = u * (u.dot(Vector3::FRONT) * 2.0f)  + (Vector3::FRONT * (s*s - u.dot(u))) + ((u ^ Vector3::FRONT) * s * 2.0f);
   m_right = u * (u.dot(Vector3::RIGHT) * 2.0f)  + (Vector3::RIGHT * (s*s - u.dot(u))) + ((u ^ Vector3::RIGHT) * s * 2.0f);
   m_up =    u * (u.dot(Vector3::UP) * 2.0f)     + (Vector3::UP * (s*s - u.dot(u)))    + ((u ^ Vector3::UP) * s * 2.0f);
+}
 
-  m_worldToLocalMatrix = m_localToWorldMatrix.inverse();
+
+static void SerializeVector3(IArchive& archive, const Vector3& v)
+{
+  archive << v.x << v.y << v.z;
+}
+
+
+static void DeserializeVector3(IArchive& archive, Vector3& v)
+{
+  archive >> v.x >> v.y >> v.z;
+}
+
+
+static void SerializeQuaternion(IArchive& archive, const Quaternion& q)
+{
+  archive << q.x << q.y << q.z << q.w;
+}
+
+
+static void DeserializeQuaternion(IArchive& archive, Quaternion& q)
+{
+  archive >> q.x >> q.y >> q.z >> q.w;
+}
+
+
+void Transform::serialize(IArchive& archive)
+{
+  SerializeVector3(archive, _localPosition);
+  SerializeQuaternion(archive, _localRotation);
+  SerializeVector3(archive, _localScale);
+  SerializeVector3(archive, _position);
+  SerializeQuaternion(archive, _rotation);
+  SerializeVector3(archive, _scale);
+}
+
+
+void Transform::deserialize(IArchive& archive)
+{
+  DeserializeVector3(archive, _localPosition);
+  DeserializeQuaternion(archive, _localRotation);
+  DeserializeVector3(archive, _localScale);
+  DeserializeVector3(archive, _position);
+  DeserializeQuaternion(archive, _rotation);
+  DeserializeVector3(archive, _scale);
 }
-} // Recluse
\ No newline at end of file
+} // Recluse
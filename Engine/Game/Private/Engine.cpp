@@ -8,6 +8,7 @@
 #include "AudioComponent.hpp"
 
 #include "Scene/Scene.hpp"
+#include "Scene/WorldPartition.hpp"
 #include "Core/Thread/CoreThread.hpp"
 #include "Core/Logging/Log.hpp"
 #include "Core/Exception.hpp"
@@ -24,12 +25,6 @@
 namespace Recluse {
 
 
-void UpdateTransform(Engine* engine, GameObject* object, size_t currNum)
-{ 
-  object->getTransform()->update();
-}
-
-
 void KeyCallback(Window* window, I32 key, I32 scanCode, I32 action, I32 mods)
 {
   switch ( ( KeyAction )action )
@@ -105,6 +100,7 @@ Engine& gEngine()
 
 Engine::Engine()
   : m_pPushedScene(nullptr)
+  , m_pWorldPartition(nullptr)
   , m_gameMouseX(0.0)
   , m_gameMouseY(0.0)
   , m_sceneObjectCount(0)
@@ -115,7 +111,6 @@ Engine::Engine()
   , m_physicsAccum(0.0)
   , m_engineMode(EngineMode_Game)
 {
-  m_workers.resize(4);
   for (size_t i = 0; i < kMaxViewFrustums; ++i) {
     m_frustums[i] = nullptr;
   }
@@ -142,6 +137,7 @@ void Engine::startUp(std::string appName, const UserConfigParams* userParams, co
   // NOTE(): Always start up the core first, before starting anything else up.
   gCore().startUp();
   gCore().ThrPool().RunAll();
+  Profiler::SetThreadName("Main");
   gFilesystem().startUp();
 
   Window::setKeyboardCallback(KeyCallback);
@@ -177,6 +173,8 @@ void Engine::startUp(std::string appName, const UserConfigParams* userParams, co
   gAudio().startUp();
 #endif
   gUI().startUp();
+
+  buildFrameGraph();
 }
 
 
@@ -242,52 +240,122 @@ void Engine::update()
     stop();
     return;
   }
-  // render out the scene.
-  R64 dt = Time::deltaTime;
-  R64 tick = Time::fixTime;
-  //m_physicsAccum += Time::deltaTime;
 
+  // Recycle transient memory of the frame built N frames ago.
+  gCore().FrameAlloc().swap();
+
+  // Palettes built last frame are read by this frame's stages, while the Animation stage builds
+  // the next ones.
+  gAnimation().swapBuffers();
+  AnimationComponent::UpdateLods();
+
+  m_frameGraph.execute(gCore().ThrPool());
+  Profiler::EndFrame();
+}
+
+
+void Engine::buildFrameGraph()
+{
+  m_frameGraph.clear();
 
   // Update using next frame input.
-  gUI().updateState(dt);
+  task_stage_id_t input = m_frameGraph.addStage("Input", [] () -> void {
+    gUI().updateState(Time::deltaTime);
+  }, { }, TASK_STAGE_FLAG_MAIN_THREAD);
 
-  AnimationComponent::updateComponents();
-  gAnimation().updateState(dt);
-  
-  traverseScene(UpdateTransform);
-  updateSunLight();
+  // Streamed objects are added, and removed, before any components are updated.
+  task_stage_id_t streaming = m_frameGraph.addStage("Streaming", [this] () -> void {
+    Camera* pMain = Camera::getMain();
+    if (!m_pWorldPartition || !pMain) return;
+    m_pWorldPartition->update(pMain->getTransform()->_position);
+  }, { input }, TASK_STAGE_FLAG_MAIN_THREAD);
+
+  task_stage_id_t animation = m_frameGraph.addStage("Animation", [] () -> void {
+    AnimationComponent::updateComponents();
+    gAnimation().updateState(Time::deltaTime);
+    const AnimFrameStats& stats = gAnimation().getFrameStats();
+    R_PROFILE_COUNTER(PROFILE_TYPES_GAME, "AnimSampled", stats._sampled);
+    R_PROFILE_COUNTER(PROFILE_TYPES_GAME, "AnimInterpolated", stats._interpolated);
+    R_PROFILE_COUNTER(PROFILE_TYPES_GAME, "AnimCulled", stats._culled);
+  }, { input, streaming });
+
+  task_stage_id_t transforms = m_frameGraph.addStage("Transforms", [this] () -> void {
+    if (m_transformHierarchy.needsRebuild(m_pPushedScene)) {
+      m_transformHierarchy.build(m_pPushedScene);
+    }
+    m_transformHierarchy.update(&gCore().ThrPool());
+    m_sceneObjectCount = static_cast<U32>(m_transformHierarchy.getNodeCount());
+  }, { input, streaming });
 
-  m_workers[0] = std::thread([&] () -> void {
+  task_stage_id_t physics = m_frameGraph.addStage("Physics", [] () -> void {
+    //m_physicsAccum += Time::deltaTime;
     //while (m_physicsAccum >= tick) {
     PhysicsComponent::UpdateFromPreviousGameLogic();
-    gPhysics().updateState(dt, tick);
-    PhysicsComponent::updateComponents();
+    gPhysics().updateState(Time::deltaTime, Time::fixTime);
+    PhysicsComponent::parallelUpdateComponents(&gCore().ThrPool());
       //m_physicsAccum -= tick;
     //}
+  }, { transforms });
 
+  task_stage_id_t audio = m_frameGraph.addStage("Audio", [] () -> void {
 #if !defined FORCE_AUDIO_OFF
     AudioComponent::updateComponents();
-    gAudio().updateState(dt);
+    gAudio().updateState(Time::deltaTime);
 #endif
-  });
+  }, { physics });
 
-  m_workers[1] = std::thread([&]() -> void {
-    PointLightComponent::updateComponents();
+  task_stage_id_t lights = m_frameGraph.addStage("Lights", [this] () -> void {
+    updateSunLight();
+    PointLightComponent::parallelUpdateComponents(&gCore().ThrPool());
+    PointLightComponent::SubmitLights();
     SpotLightComponent::updateComponents();
-  });
+  }, { transforms });
 
-  m_workers[2] = std::thread([&]() -> void {
-    MeshComponent::updateComponents();
+  task_stage_id_t mesh = m_frameGraph.addStage("Mesh", [this] () -> void {
+    MeshComponent::parallelUpdateComponents(&gCore().ThrPool());
+    MeshComponent::UpdateVisibilityProxies();
+    cullMeshes();
     AbstractRendererComponent::updateComponents();
+    R_PROFILE_COUNTER(PROFILE_TYPES_GAME, "OccludedPrimitives", m_occlusionCuller.getCulledPrimitiveCount());
     //SkinnedRendererComponent::updateComponents();
-  });
+  }, { transforms });
 
-  ParticleSystemComponent::updateComponents();
+  task_stage_id_t particles = m_frameGraph.addStage("Particles", [] () -> void {
+    ParticleSystemComponent::updateComponents();
+  }, { transforms });
 
-  m_workers[0].join();
-  m_workers[1].join();
-  m_workers[2].join();
+  m_frameGraph.addStage("RenderSubmit", [this] () -> void {
+    renderSubmit();
+  }, { animation, physics, audio, lights, mesh, particles }, TASK_STAGE_FLAG_MAIN_THREAD);
+}
+
+
+void Engine::cullMeshes()
+{
+  R_TIMED_PROFILE_GAME();
+
+  Camera* pMain = Camera::getMain();
+  if (pMain) {
+    m_occlusionCuller.render(pMain->getView() * pMain->getProjection(), &gCore().ThrPool());
+  }
 
+  if (m_currFrustumCount == 0) return;
+
+  // Write masks back to the meshes from the same jobs that computed them.
+  m_frustumCuller.cull(m_frustums, static_cast<U32>(m_currFrustumCount), &gCore().ThrPool(), 
+    [this] (U32 start, U32 end) -> void {
+      for (U32 i = start; i < end; ++i) {
+        MeshComponent* pMesh = static_cast<MeshComponent*>(m_frustumCuller.getUserData(i));
+        if (!pMesh) continue;
+        pMesh->ClearFrustumCullBits();
+        pMesh->SetFrustumCull(m_frustumCuller.getMask(i));
+      }
+    });
+}
+
+
+void Engine::renderSubmit()
+{
   {
     Camera* pMain = Camera::getMain();
     if (pMain) {
@@ -374,6 +442,7 @@ void Engine::pushScene(Scene* scene)
 {
   R_ASSERT(scene, "Attempting to push a null scene!");
   m_pPushedScene = scene;
+  m_transformHierarchy.clear();
 }
 
 
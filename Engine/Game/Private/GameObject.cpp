@@ -1,6 +1,7 @@
 // Copyright (c) 2017 Recluse Project. All rights reserved.
 #include "GameObject.hpp"
 #include "Core/Exception.hpp"
+#include "Core/Utility/Archive.hpp"
 
 #include "GameObjectManager.hpp"
 
@@ -8,10 +9,12 @@ namespace Recluse {
 
 
 game_uuid_t GameObject::sGameObjectCount = 1;
+U32 GameObject::sHierarchyVersion = 0;
 
 
 GameObject::GameObject()
   : m_pParent(nullptr)
+  , m_pScene(nullptr)
   , m_id(std::hash<game_uuid_t>()(sGameObjectCount++))
   , m_name("Default Name")
   , m_bStarted(false)
@@ -22,6 +25,8 @@ GameObject::GameObject()
 
 GameObject::~GameObject()
 {
+  // Objects outside of any scene graph do not affect it.
+  if (m_pParent || m_pScene) markHierarchyChanged();
   m_transform.cleanUp();
 }
 
@@ -29,11 +34,13 @@ GameObject::~GameObject()
 GameObject::GameObject(GameObject&& obj)
   : m_id(obj.m_id)
   , m_pParent(obj.m_pParent)
+  , m_pScene(obj.m_pScene)
   , m_children(std::move(obj.m_children))
   , m_name(std::move(obj.m_name))
 {
   obj.m_id = 0;
   obj.m_pParent = nullptr;
+  obj.m_pScene = nullptr;
   obj.m_children.clear();
   obj.m_name.clear();
 }
@@ -43,24 +50,30 @@ GameObject& GameObject::operator=(GameObject&& obj)
 {
   m_id = obj.m_id;
   m_pParent = obj.m_pParent;
+  m_pScene = obj.m_pScene;
   m_name = std::move(obj.m_name);
   m_children = std::move(obj.m_children);
 
   obj.m_id = 0;
   obj.m_pParent = nullptr;
+  obj.m_pScene = nullptr;
   obj.m_children.clear();
+  obj.m_name.clear();
   return (*this);
 }
 
 
 void GameObject::serialize(IArchive& archive)
 {
+  archive << m_name << m_tag;
+  m_transform.serialize(archive);
 }
 
 
 void GameObject::deserialize(IArchive& archive)
 {
-
+  archive >> m_name >> m_tag;
+  m_transform.deserialize(archive);
 }
 
 
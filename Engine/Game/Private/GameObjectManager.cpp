@@ -1,14 +1,157 @@
 // Copyright (c) 2017 Recluse Project. All rights reserved.
 #include "GameObjectManager.hpp"
+#include "Core/Exception.hpp"
+
+#include <new>
+#include <cstdlib>
 
 
 namespace Recluse {
 
 U64 GameObjectManager::gGameObjectNumber = 0;
 
+
+GameObjectManager::GameObjectManager()
+  : m_liveCount(0)
+{
+}
+
+
+GameObjectManager::~GameObjectManager()
+{
+  release();
+}
+
+
+GameObjectManager::Chunk* GameObjectManager::addChunk()
+{
+  // Over allocate, so that the pool can align its first block.
+  size_t sz = sizeof(GameObject) * kObjectsPerChunk + alignof(GameObject);
+  void* mem = malloc(sz);
+  if (!mem) return nullptr;
+
+  Chunk* chunk = new Chunk(mem, sz);
+  R_ASSERT(chunk->_pool.BlockCount() >= kObjectsPerChunk, "Game object chunk is too small.\n");
+  for (U32 i = 0; i < kObjectsPerChunk; ++i) {
+    chunk->_generations[i] = 1;
+    chunk->_alive[i] = false;
+  }
+  m_freeChunks.push_back(static_cast<U32>(m_chunks.size()));
+  m_chunks.push_back(chunk);
+  return chunk;
+}
+
+
+GameObject* GameObjectManager::allocate()
+{
+  if (m_freeChunks.empty() && !addChunk()) {
+    R_DEBUG(rError, "Failed to allocate game object chunk!\n");
+    return nullptr;
+  }
+
+  U32 chunkIdx = m_freeChunks.back();
+  Chunk* chunk = m_chunks[chunkIdx];
+  void* mem = chunk->_pool.allocate(sizeof(GameObject), alignof(GameObject));
+  R_ASSERT(mem, "Chunk in free list has no free slots.\n");
+  if (chunk->_pool.IsFull()) {
+    chunk->_inFreeList = false;
+    m_freeChunks.pop_back();
+  }
+
+  U32 slot = static_cast<U32>(chunk->_pool.BlockIndex(mem));
+  GameObject* obj = new (mem) GameObject();
+  obj->m_id = std::hash<game_uuid_t>()(gGameObjectNumber++);
+  obj->m_handle = GameObjectHandle(chunkIdx * kObjectsPerChunk + slot, chunk->_generations[slot]);
+  chunk->_alive[slot] = true;
+  chunk->_liveCount += 1;
+  m_liveCount += 1;
+  return obj;
+}
+
+
+void GameObjectManager::destroy(U32 chunkIdx, U32 slot)
+{
+  Chunk* chunk = m_chunks[chunkIdx];
+  GameObject* obj = static_cast<GameObject*>(chunk->_pool.BlockAt(slot));
+  obj->~GameObject();
+  chunk->_pool.Deallocate(obj);
+
+  // Stale handles will no longer match. Skip 0, which never names a live object.
+  chunk->_generations[slot] += 1;
+  if (chunk->_generations[slot] == 0) chunk->_generations[slot] = 1;
+  chunk->_alive[slot] = false;
+  chunk->_liveCount -= 1;
+  m_liveCount -= 1;
+
+  if (!chunk->_inFreeList) {
+    chunk->_inFreeList = true;
+    m_freeChunks.push_back(chunkIdx);
+  }
+}
+
+
+void GameObjectManager::Deallocate(GameObject* object)
+{
+  if (!object) return;
+  GameObjectHandle handle = object->getHandle();
+  R_ASSERT(isValid(handle), "Game object was not allocated by this manager, or already destroyed!\n");
+  if (!isValid(handle)) return;
+  destroy(handle._index / kObjectsPerChunk, handle._index % kObjectsPerChunk);
+}
+
+
+void GameObjectManager::Deallocate(GameObjectHandle handle)
+{
+  if (!isValid(handle)) return;
+  destroy(handle._index / kObjectsPerChunk, handle._index % kObjectsPerChunk);
+}
+
+
+B32 GameObjectManager::isValid(GameObjectHandle handle) const
+{
+  if (handle.isNull()) return false;
+  U32 chunkIdx = handle._index / kObjectsPerChunk;
+  U32 slot = handle._index % kObjectsPerChunk;
+  if (chunkIdx >= m_chunks.size()) return false;
+  const Chunk* chunk = m_chunks[chunkIdx];
+  return chunk->_alive[slot] && chunk->_generations[slot] == handle._generation;
+}
+
+
+GameObject* GameObjectManager::get(GameObjectHandle handle)
+{
+  if (!isValid(handle)) return nullptr;
+  Chunk* chunk = m_chunks[handle._index / kObjectsPerChunk];
+  return static_cast<GameObject*>(chunk->_pool.BlockAt(handle._index % kObjectsPerChunk));
+}
+
+
+void GameObjectManager::clear()
+{
+  for (U32 c = 0; c < m_chunks.size(); ++c) {
+    Chunk* chunk = m_chunks[c];
+    for (U32 i = 0; i < kObjectsPerChunk && chunk->_liveCount; ++i) {
+      if (chunk->_alive[i]) destroy(c, i);
+    }
+  }
+}
+
+
+void GameObjectManager::release()
+{
+  clear();
+  for (Chunk* chunk : m_chunks) {
+    free(chunk->_pMemory);
+    delete chunk;
+  }
+  m_chunks.clear();
+  m_freeChunks.clear();
+}
+
+
 GameObjectManager& gGameObjectManager()
 {
   static GameObjectManager mnger;
   return mnger;
 }
-} // Recluse
\ No newline at end of file
+} // Recluse
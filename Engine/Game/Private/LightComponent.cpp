@@ -61,16 +61,7 @@ void PointLightComponent::update()
   Vector3 rel = transform->_rotation * m_offset;
   m_nativeLight._Position = transform->_position + rel;
 
-  gRenderer().pushPointLight(m_nativeLight);
-
   if (isDebugging()) {
-    MeshRenderCmd cmd;
-    cmd._config = CMD_RENDERABLE_BIT;
-    cmd._pMeshDesc = m_descriptor;
-    cmd._pMeshData = kPointLightMesh->getMeshData();
-    cmd._pPrimitives = kPointLightMesh->getPrimitiveData();
-    cmd._primitiveCount = kPointLightMesh->getPrimitiveCount();
-
     ObjectBuffer* buffer = m_descriptor->getObjectData();
     buffer->_model = Matrix4(
       Vector4(1.0f, 0.0f, 0.0f, 0.0f),
@@ -87,7 +78,26 @@ void PointLightComponent::update()
     N[3][3] = 1.0f;
     buffer->_normalMatrix = N.inverse().transpose();
     m_descriptor->pushUpdate(MESH_BUFFER_UPDATE_BIT);
-    gRenderer().pushMeshRender(cmd);
+  }
+}
+
+
+void PointLightComponent::SubmitLights()
+{
+  for (size_t i = 0; i < _kPointLightComponents.size(); ++i) {
+    PointLightComponent* pLight = _kPointLightComponents[i];
+    if (!pLight->enabled()) continue;
+    gRenderer().pushPointLight(pLight->m_nativeLight);
+
+    if (pLight->isDebugging()) {
+      MeshRenderCmd cmd;
+      cmd._config = CMD_RENDERABLE_BIT;
+      cmd._pMeshDesc = pLight->m_descriptor;
+      cmd._pMeshData = kPointLightMesh->getMeshData();
+      cmd._pPrimitives = kPointLightMesh->getPrimitiveData();
+      cmd._primitiveCount = kPointLightMesh->getPrimitiveCount();
+      gRenderer().pushMeshRender(cmd);
+    }
   }
 }
 
@@ -3,6 +3,7 @@
 #include "GameObject.hpp"
 #include "Engine.hpp"
 #include "Camera.hpp"
+#include "Rendering/RendererResourcesCache.hpp"
 
 #include "Renderer/MeshData.hpp"
 #include "Renderer/Renderer.hpp"
@@ -19,6 +20,10 @@ MeshComponent::MeshComponent()
   : m_allowCulling(true)
   , m_frustumCull(0)
   , m_pMeshRef(nullptr)
+  , m_visibilityProxy(Octree::kInvalidProxy)
+  , m_cullSlot(FrustumCuller::kInvalidSlot)
+  , m_pOccluder(nullptr)
+  , m_occluderId(OcclusionCuller::kInvalidOccluder)
 {
 }
 
@@ -30,42 +35,101 @@ void MeshComponent::onInitialize(GameObject* owner)
 
 void MeshComponent::onCleanUp()
 {
+  RemoveVisibilityProxy();
+  RemoveOccluder();
   UNREGISTER_COMPONENT(MeshComponent);
 }
 
 
+void MeshComponent::SetMeshRef(Mesh* pData)
+{
+  m_pMeshRef = pData;
+  m_meshHandle = MeshCache::acquire(pData);
+}
+
+
 void MeshComponent::update()
 {
   R_TIMED_PROFILE_GAME();
 
+  // Only write into slots already held by this mesh, so that meshes may update in parallel.
+  Matrix4 localToWorld = getOwner()->getTransform()->getLocalToWorldMatrix();
+  if (m_occluderId != OcclusionCuller::kInvalidOccluder) {
+    gEngine().getOcclusionCuller().setOccluderTransform(m_occluderId, localToWorld);
+  }
+
   if (!m_pMeshRef) return;
-  UpdateFrustumCullBits();
+  m_worldAABB = m_pMeshRef->getAABB().transform(localToWorld);
+  if (m_cullSlot != FrustumCuller::kInvalidSlot) {
+    gEngine().getFrustumCuller().setBounds(m_cullSlot, m_worldAABB);
+  }
 }
 
 
-void MeshComponent::UpdateFrustumCullBits()
+void MeshComponent::UpdateVisibilityProxies()
 {
-  if (!AllowCulling()) return;
-
-  size_t viewFrustumCount = gEngine().getViewFrustumCount();
-  if (viewFrustumCount == 0) return;
+  R_TIMED_PROFILE_GAME();
 
-  ViewFrustum** viewFrustums = gEngine().getViewFrustums();
-  AABB aabb = m_pMeshRef->getAABB();
-  Transform* transform = getOwner()->getTransform();
+  for (size_t i = 0; i < _kMeshComponents.size(); ++i) {
+    MeshComponent* pMesh = _kMeshComponents[i];
+    if (!pMesh->enabled()) continue;
+    pMesh->UpdateOccluder();
+    if (!pMesh->m_pMeshRef) continue;
+    pMesh->UpdateVisibilityProxy();
+  }
+}
 
-  aabb.max = (aabb.max * transform->_scale) + transform->_position;
-  aabb.min = (aabb.min * transform->_scale) + transform->_position;
-  aabb.computeCentroid();
 
-  ClearFrustumCullBits();
+void MeshComponent::UpdateVisibilityProxy()
+{
+  if (!AllowCulling()) {
+    RemoveVisibilityProxy();
+    return;
+  }
 
-  for (size_t i = 0; i < viewFrustumCount; ++i) {
-    ViewFrustum* viewFrustum = viewFrustums[i];
-    ViewFrustum::Result intersects = viewFrustum->intersect(aabb);
-    if (intersects != ViewFrustum::Result_Outside) {
-      m_frustumCull = m_frustumCull | (1 << i);
-    }
+  Octree& tree = gEngine().getVisibilityTree();
+  if (m_visibilityProxy == Octree::kInvalidProxy) {
+    FrustumCuller& culler = gEngine().getFrustumCuller();
+    m_visibilityProxy = tree.insert(m_worldAABB, this);
+    m_cullSlot = culler.add(this);
+    culler.setBounds(m_cullSlot, m_worldAABB);
+  } else {
+    tree.move(m_visibilityProxy, m_worldAABB);
   }
 }
-} // Recluse
\ No newline at end of file
+
+
+void MeshComponent::RemoveVisibilityProxy()
+{
+  if (m_visibilityProxy == Octree::kInvalidProxy) return;
+  gEngine().getVisibilityTree().remove(m_visibilityProxy);
+  gEngine().getFrustumCuller().remove(m_cullSlot);
+  m_visibilityProxy = Octree::kInvalidProxy;
+  m_cullSlot = FrustumCuller::kInvalidSlot;
+}
+
+
+void MeshComponent::SetOccluder(const OccluderMesh* pOccluder)
+{
+  if (m_pOccluder == pOccluder) return;
+  RemoveOccluder();
+  m_pOccluder = pOccluder;
+}
+
+
+void MeshComponent::UpdateOccluder()
+{
+  if (!m_pOccluder || m_occluderId != OcclusionCuller::kInvalidOccluder) return;
+  OcclusionCuller& culler = gEngine().getOcclusionCuller();
+  m_occluderId = culler.addOccluder(m_pOccluder);
+  culler.setOccluderTransform(m_occluderId, getOwner()->getTransform()->getLocalToWorldMatrix());
+}
+
+
+void MeshComponent::RemoveOccluder()
+{
+  if (m_occluderId == OcclusionCuller::kInvalidOccluder) return;
+  gEngine().getOcclusionCuller().removeOccluder(m_occluderId);
+  m_occluderId = OcclusionCuller::kInvalidOccluder;
+}
+} // Recluse
@@ -113,8 +113,8 @@ void PhysicsComponent::applyImpulse(const Vector3& impulse, const Vector3& relPo
 
 void PhysicsComponent::UpdateFromPreviousGameLogic()
 {
-  for (auto& component : _kPhysicsComponents) {
-    component.second->updateFromGameObject();
+  for (size_t i = 0; i < _kPhysicsComponents.size(); ++i) {
+    _kPhysicsComponents[i]->updateFromGameObject();
   }
 }
 
@@ -5,6 +5,8 @@
 #include "AnimationComponent.hpp"
 #include "GameObject.hpp"
 #include "Camera.hpp"
+#include "Engine.hpp"
+#include "Rendering/RendererResourcesCache.hpp"
 
 #include "Renderer/MaterialDescriptor.hpp"
 #include "Renderer/MeshDescriptor.hpp"
@@ -14,17 +16,36 @@
 #include "Core/Utility/Profile.hpp"
 #include "Core/Exception.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace Recluse {
 
 
 DEFINE_COMPONENT_MAP(AbstractRendererComponent);
 
 
+// Flag the command as occluded if the mesh is hidden behind occluders, counting its primitives
+// as culled.
+static void testOcclusion(const Mesh* pMesh, const Matrix4& model, MeshRenderCmd& cmd)
+{
+  OcclusionCuller& culler = gEngine().getOcclusionCuller();
+  if (!culler.isEnabled()) return;
+  if (culler.testAABB(pMesh->getAABB().transform(model))) return;
+  cmd._config |= CMD_OCCLUDED_BIT;
+  culler.addCulledPrimitives(cmd._primitiveCount);
+}
+
+
 AbstractRendererComponent::AbstractRendererComponent()
   : m_configs(CMD_RENDERABLE_BIT | CMD_SHADOWS_BIT)
   , m_debugConfigs(0)
   , m_bDirty(true)
   , m_currLod(Mesh::kMeshLodZero)
+  , m_lodBias(0.0f)
+  , m_lodPixelError(1.0f)
+  , m_lodPixelsPerUnit(0.0f)
   , m_allowAutoLod(false)
   , m_morphIndex0(kNoMorphIndex)
   , m_morphIndex1(kNoMorphIndex)
@@ -44,6 +65,7 @@ RendererComponent::RendererComponent(const RendererComponent& m)
   : m_meshDescriptor(m.m_meshDescriptor)
 {
   m_meshes = m.m_meshes;
+  m_meshHandles = m.m_meshHandles;
 }
 
 
@@ -52,6 +74,7 @@ RendererComponent::RendererComponent(RendererComponent&& m)
 {
   m.m_meshDescriptor = nullptr;
   m_meshes = std::move(m.m_meshes);
+  m_meshHandles = std::move(m.m_meshHandles);
 }
 
 
@@ -59,6 +82,7 @@ RendererComponent& RendererComponent::operator=(RendererComponent&& obj)
 {
   m_meshDescriptor = obj.m_meshDescriptor;
   m_meshes = std::move(obj.m_meshes);
+  m_meshHandles = std::move(obj.m_meshHandles);
 
   obj.m_meshDescriptor = nullptr;
   return (*this);
@@ -69,10 +93,24 @@ RendererComponent& RendererComponent::operator=(const RendererComponent& obj)
 {
   m_meshDescriptor = obj.m_meshDescriptor;
   m_meshes = obj.m_meshes;
+  m_meshHandles = obj.m_meshHandles;
   return (*this);
 }
 
 
+void AbstractRendererComponent::addMesh(Mesh* mesh, U32 idx)
+{
+  ResourceHandle<Mesh> handle = MeshCache::acquire(mesh);
+  if (idx == Mesh::kMeshUnknownValue) {
+    m_meshes.push_back(mesh);
+    m_meshHandles.push_back(std::move(handle));
+  } else {
+    m_meshes[idx] = mesh;
+    m_meshHandles[idx] = std::move(handle);
+  }
+}
+
+
 void AbstractRendererComponent::enableShadow(B32 enable)
 {
   if (enable) { m_configs |= CMD_SHADOWS_BIT; }
@@ -171,9 +209,10 @@ void RendererComponent::update()
     // Push mesh data to renderer.
     Mesh* pMesh = m_meshes[i];
     MeshData* data = pMesh->getMeshData();
+    U32 lod = getMeshLod(pMesh, m_lodBias);
     cmd._pMeshData = data;
-    cmd._pPrimitives = pMesh->getPrimitiveData();
-    cmd._primitiveCount = pMesh->getPrimitiveCount();
+    cmd._pPrimitives = pMesh->getPrimitiveData(lod);
+    cmd._primitiveCount = pMesh->getPrimitiveCount(lod);
 
     R_ASSERT(cmd._pMeshData, "Mesh data was nullptr!");
     if (m_meshes[i]->getMorphTargetCount() > 0) {
@@ -181,14 +220,15 @@ void RendererComponent::update()
       cmd._pMorph1 = m_meshes[i]->getMorphTarget(1);
     }
 
+    testOcclusion(pMesh, model, cmd);
     gRenderer().pushMeshRender(cmd);
   }
 
   if ( m_pAnimHandle ) {
     const R32* weights = nullptr;
     U32 weightSz = 0;
-    weights = m_pAnimHandle->_finalMorphs.data();
-    weightSz = static_cast<U32>(m_pAnimHandle->_finalMorphs.size());
+    weights = m_pAnimHandle->getMorphs().data();
+    weightSz = static_cast<U32>(m_pAnimHandle->getMorphs().size());
     if (weightSz > 0) {
       renderData->_w0 = weights[0];
       renderData->_w1 = weights[1];
@@ -235,7 +275,7 @@ void SkinnedRendererComponent::update()
   const Matrix4* palette = nullptr;
   U32 paletteSz = 0;
   if (m_pAnimHandle) {
-    palette = m_pAnimHandle->_finalPalette;
+    palette = m_pAnimHandle->getPalette();
     paletteSz = m_pAnimHandle->_paletteSz;
   }
   // Update descriptor joints.
@@ -298,31 +338,45 @@ SkinnedRendererComponent::SkinnedRendererComponent()
 
 void AbstractRendererComponent::updateLod(Transform* meshTransform)
 {
+  m_currLod = m_lodBias;
   if (!allowAutoLod()) return;
   Camera* currCamera = Camera::getMain();
-  if (!currCamera) return;
+  if (!currCamera) {
+    // Nothing tells how large the mesh shows on screen, so keep it at full detail.
+    m_lodPixelsPerUnit = std::numeric_limits<R32>::max();
+    return;
+  }
   Transform* camTransform = currCamera->getTransform();
   Vector3 camPos = camTransform->_position;
   Vector3 meshPos = meshTransform->_position;
 
-  // Length of vector between mesh and camera.
+  // Length of vector between mesh and camera, and how many pixels one unit of the mesh covers
+  // from there. Levels of detail are then chosen by how far their error shows on screen.
   R32 len = (meshPos - camPos).length();
-  m_currLod = 0;
-  if (len > 10.0f) {
-    m_currLod = 1;
-  }
-  if (len > 15.0f) {
-    m_currLod = 2;  
-  }
-  if (len > 20.0f) {
-    m_currLod = 3;
-  }
-  if (len > 25.0f) {
-    m_currLod = 4;
+  Vector3 scale = meshTransform->_scale;
+  R32 maxScale = std::max(fabsf(scale.x), std::max(fabsf(scale.y), fabsf(scale.z)));
+  R32 halfHeight = len * tanf(currCamera->getFoV() * 0.5f);
+  m_lodPixelsPerUnit = halfHeight > 0.0f
+    ? maxScale * static_cast<R32>(gRenderer().getRenderHeight()) * 0.5f / halfHeight
+    : std::numeric_limits<R32>::max();
+  if (!m_meshes.empty() && m_meshes[0]->getLodCount() > 1) {
+    m_currLod += static_cast<R32>(m_meshes[0]->selectLod(m_lodPixelsPerUnit, m_lodPixelError));
   }
 }
 
 
+U32 AbstractRendererComponent::getMeshLod(const Mesh* pMesh, R32 bias) const
+{
+  U32 lodCount = pMesh->getLodCount();
+  if (lodCount <= 1) return Mesh::kMeshLodZero;
+  // The bias moves the level picked, as far as the mesh has them.
+  R32 lod = bias;
+  if (allowAutoLod()) lod += static_cast<R32>(pMesh->selectLod(m_lodPixelsPerUnit, m_lodPixelError));
+  U32 level = lod > 0.0f ? static_cast<U32>(lod) : 0;
+  return std::min(level, lodCount - 1);
+}
+
+
 void BatchRendererComponent::onInitialize(GameObject* owner)
 {
   //
@@ -366,6 +420,7 @@ void BatchRendererComponent::clearMeshes()
 void BatchRendererComponent::update()
 {
   Transform* transform = getTransform();
+  updateLod(transform);
 
   // Each mesh corresponds to each mesh descriptor.
   for (U32 i = 0; i < m_perMeshDescriptors.size(); ++i) {
@@ -385,8 +440,9 @@ void BatchRendererComponent::update()
     meshCmd._config = m_configs;
     meshCmd._debugConfig = m_debugConfigs;
     meshCmd._instances = 1;
-    meshCmd._primitiveCount = m_meshes[i]->getPrimitiveCount();
-    meshCmd._pPrimitives = m_meshes[i]->getPrimitiveData();
+    U32 lod = getMeshLod(m_meshes[i], mn._lodBias);
+    meshCmd._primitiveCount = m_meshes[i]->getPrimitiveCount(lod);
+    meshCmd._pPrimitives = m_meshes[i]->getPrimitiveData(lod);
 
     R_ASSERT(meshCmd._pMeshData, "Mesh data was nullptr!");
     if (m_meshes[i]->getMorphTargetCount() > 0) {
@@ -397,13 +453,13 @@ void BatchRendererComponent::update()
     if (m_pAnimHandle) {
       const R32* weights = nullptr;
       U32 weightSz = 0;
-      weights = m_pAnimHandle->_finalMorphs.data();
-      weightSz = static_cast<U32>(m_pAnimHandle->_finalMorphs.size());
+      weights = m_pAnimHandle->getMorphs().data();
+      weightSz = static_cast<U32>(m_pAnimHandle->getMorphs().size());
       if (weightSz > 0) {
         pBuffer->_w0 = weights[0];
         pBuffer->_w1 = weights[1];
       }
-      localMatrix = m_pAnimHandle->_finalPalette[i];
+      localMatrix = m_pAnimHandle->getPalette()[i];
     }
 
     Matrix4 model = localMatrix * parentModel;
@@ -417,6 +473,7 @@ void BatchRendererComponent::update()
       pBuffer->_normalMatrix = N.inverse().transpose();
     }
     pMeshDescriptor->pushUpdate(MESH_BUFFER_UPDATE_BIT);
+    testOcclusion(m_meshes[i], model, meshCmd);
     gRenderer().pushMeshRender(meshCmd);
   }
 }
@@ -437,6 +494,7 @@ void BatchRendererComponent::onCleanUp()
 
 void BatchRendererComponent::setLodBias(R32 bias, U32 meshIdx)
 {
+  m_perMeshDescriptors[meshIdx]._lodBias = bias;
   m_perMeshDescriptors[meshIdx]._pMeshDescriptor->getObjectData()->_lod = 
     gRenderer().getCurrentGraphicsConfigs()._Lod + bias;
 }
@@ -444,7 +502,6 @@ void BatchRendererComponent::setLodBias(R32 bias, U32 meshIdx)
 
 R32 BatchRendererComponent::getLodBias(U32 meshIdx) const 
 {
-  return gRenderer().getCurrentGraphicsConfigs()._Lod - 
-         m_perMeshDescriptors[meshIdx]._pMeshDescriptor->getObjectData()->_lod;
+  return m_perMeshDescriptors[meshIdx]._lodBias;
 }
 } // Recluse
\ No newline at end of file
@@ -10,8 +10,16 @@
 namespace Recluse {
 
 
-std::unordered_map<tcache_t, Texture2D*> TextureCache::sCache;
-std::unordered_map<UUID64, TextureSampler*> SamplerCache::sCache;
+void ResourceTraits<Texture2D>::destroy(Texture2D* pTexture)
+{
+  gRenderer().freeTexture2D(pTexture);
+}
+
+
+void ResourceTraits<TextureSampler>::destroy(TextureSampler* pSampler)
+{
+  gRenderer().freeTextureSampler(pSampler);
+}
 
 
 TextureCache::TextureCache()
@@ -25,89 +33,53 @@ TextureCache::~TextureCache()
 
 
 
-TextureCache::CacheResult TextureCache::cache(Texture2D* texture, std::string& name)
+TextureCache::CacheResult TextureCache::cache(Texture2D* texture, const std::string& name, U64 bytes)
 {
   if (!texture) return Cache_Null_Pointer;
-  tcache_t t = texture->UUID();
+  AssetId id = texture->UUID();
   if (!name.empty()) {
-    t = std::hash<std::string>()(name);
+    id = gResourceRegistry().intern(name);
   }
-  auto it = sCache.find(t);
-  if (it != sCache.end()) {
+  if (!gResourceRegistry().add(id, texture, bytes)) {
     return Cache_Map_Exists;
   }
-
-  sCache[t] = texture;
   return Cache_Success;
 }
 
 #if 1
 TextureCache::CacheResult TextureCache::get(std::string texname, Texture2D** out)
 {
-  tcache_t v = std::hash<std::string>()(texname);
-  auto it = sCache.find(v);
-  if (it == sCache.end()) {
+  Texture2D* pTexture = gResourceRegistry().find<Texture2D>(hashAssetName(texname));
+  if (!pTexture) {
     return Cache_Not_Found;
   }
 
-  *out = it->second;
+  *out = pTexture;
   return Cache_Success;
 }
 
 
 TextureCache::CacheResult TextureCache::UnCache(std::string texname, Texture2D** out)
 {
-  tcache_t v = std::hash<std::string>()(texname);
-  auto it = sCache.find(v);
-  if (it == sCache.end()) {
+  Texture2D* pTexture = gResourceRegistry().detach<Texture2D>(hashAssetName(texname));
+  if (!pTexture) {
     return Cache_Not_Found;
   }
 
-  *out = it->second;
-  sCache.erase(v);
+  *out = pTexture;
   return Cache_Success;
 }
 #endif
 
 void TextureCache::cleanUpAll()
 {
-  for (auto& it : sCache) {
-    switch (it.second->TexType()) {
-      case TextureBase::TEXTURE_2D:
-      {
-        gRenderer().freeTexture2D(reinterpret_cast<Texture2D*>(it.second));
-      } break;
-      case TextureBase::TEXTURE_1D:
-      {
-        gRenderer().freeTexture1D(reinterpret_cast<Texture1D*>(it.second));
-      } break;
-      case TextureBase::TEXTURE_CUBE:
-      {
-        gRenderer().freeTextureCube(reinterpret_cast<TextureCube*>(it.second));
-      } break;
-      case TextureBase::TEXTURE_2D_ARRAY:
-      {
-        gRenderer().freeTexture2DArray(reinterpret_cast<Texture2DArray*>(it.second));
-      } break;
-      default:
-      {
-        Log(rError) << "Unknown texture type in cache. Can not clean up!\n";
-      } break;
-    }
-  }
-
-  sCache.clear();
+  gResourceRegistry().clear(RESOURCE_TEXTURE);
 }
 
 
 void SamplerCache::cache(TextureSampler* pSampler)
 {
-  auto& it = sCache.find(pSampler->UUID());
-  if (it != sCache.end()) {
-    return;
-  }
-
-  sCache[pSampler->UUID()] = pSampler;
+  gResourceRegistry().add(pSampler->UUID(), pSampler);
 }
 
 #if 0
@@ -132,9 +104,6 @@ void SamplerCache::UnCache(std::string& name, TextureSampler** out)
 
 void SamplerCache::cleanUpAll()
 {
-  for (auto& sampler : sCache) {
-    gRenderer().freeTextureSampler(sampler.second);
-  }
-  sCache.clear();
+  gResourceRegistry().clear(RESOURCE_SAMPLER);
 }
 } // Recluse
\ No newline at end of file
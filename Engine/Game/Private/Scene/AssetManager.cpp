@@ -5,5 +5,4 @@
 namespace Recluse {
 
 
-std::unordered_map<std::string, AnimClip*> AnimAssetManager::kClips;
 } // Recluse
\ No newline at end of file
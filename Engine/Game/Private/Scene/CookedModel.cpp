@@ -0,0 +1,422 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Scene/CookedModel.hpp"
+#include "ModelImport.hpp"
+
+#include "Core/Exception.hpp"
+
+#include <cstring>
+
+
+namespace Recluse {
+
+
+static_assert(sizeof(Matrix4) == sizeof(R32) * 16, "Cooked joints copy matrices as 16 floats.");
+
+
+static U64 AlignCooked(U64 offset)
+{
+  return (offset + kCookedBlockAlignment - 1) & ~static_cast<U64>(kCookedBlockAlignment - 1);
+}
+
+
+// Range check that does not overflow on bad data.
+static B32 InRange(U64 first, U64 count, U64 total)
+{
+  return first <= total && count <= total - first;
+}
+
+
+std::string CookedModelView::getString(const CookedString& str) const
+{
+  U64 size = getByteSize(COOKED_BLOCK_STRINGS);
+  if (!InRange(str._offset, str._length, size)) return std::string();
+  const TChar* chars = reinterpret_cast<const TChar*>(getBytes(COOKED_BLOCK_STRINGS));
+  return std::string(chars + str._offset, str._length);
+}
+
+
+B32 CookedModelView::open(const U8* pData, size_t size)
+{
+  m_pData = nullptr;
+  m_size = 0;
+  if (!pData || size < sizeof(CookedModelHeader)) return false;
+
+  const CookedModelHeader& header = *reinterpret_cast<const CookedModelHeader*>(pData);
+  if (header._magic != kCookedModelMagic || header._version != kCookedModelVersion) return false;
+  if (header._staticVertexSize != sizeof(StaticVertex)
+    || header._skinnedVertexSize != sizeof(SkinnedVertex)) {
+    return false;
+  }
+  if (header._size > size) return false;
+
+  for (U32 i = 0; i < COOKED_BLOCK_COUNT; ++i) {
+    const CookedBlock& block = header._blocks[i];
+    if ((block._offset % kCookedBlockAlignment) != 0) return false;
+    if (!InRange(block._offset, block._size, header._size)) return false;
+  }
+
+  m_pData = pData;
+  m_size = static_cast<size_t>(header._size);
+  if (!validate()) {
+    m_pData = nullptr;
+    m_size = 0;
+    return false;
+  }
+  return true;
+}
+
+
+B32 CookedModelView::validate() const
+{
+  U32 samplerCount = getCount<CookedSampler>(COOKED_BLOCK_SAMPLERS);
+  U32 textureCount = getCount<CookedTexture>(COOKED_BLOCK_TEXTURES);
+  U32 materialCount = getCount<CookedMaterial>(COOKED_BLOCK_MATERIALS);
+  U32 primitiveCount = getCount<CookedPrimitive>(COOKED_BLOCK_PRIMITIVES);
+  U32 morphTargetCount = getCount<CookedMorphTarget>(COOKED_BLOCK_MORPH_TARGETS);
+  U32 skeletonCount = getCount<CookedSkeleton>(COOKED_BLOCK_SKELETONS);
+  U32 trackCount = getCount<CookedTrack>(COOKED_BLOCK_TRACKS);
+
+  const CookedTexture* textures = getBlock<CookedTexture>(COOKED_BLOCK_TEXTURES);
+  for (U32 i = 0; i < textureCount; ++i) {
+    if (textures[i]._width == 0 || textures[i]._height == 0) return false;
+    if (textures[i]._texelSize != static_cast<U64>(textures[i]._width) * textures[i]._height * 4) return false;
+    if (!InRange(textures[i]._texelOffset, textures[i]._texelSize, getByteSize(COOKED_BLOCK_TEXELS))) return false;
+  }
+
+  const CookedMaterial* materials = getBlock<CookedMaterial>(COOKED_BLOCK_MATERIALS);
+  for (U32 i = 0; i < materialCount; ++i) {
+    for (U32 slot = 0; slot < COOKED_MATERIAL_TEXTURE_COUNT; ++slot) {
+      I32 texture = materials[i]._textures[slot];
+      I32 sampler = materials[i]._samplers[slot];
+      if (texture != kCookedNone && (texture < 0 || static_cast<U32>(texture) >= textureCount)) return false;
+      if (sampler != kCookedNone && (sampler < 0 || static_cast<U32>(sampler) >= samplerCount)) return false;
+    }
+  }
+
+  // Nodes without a mesh hold ~0.
+  U32 meshCount = getCount<CookedMesh>(COOKED_BLOCK_MESHES);
+  const CookedNode* nodes = getBlock<CookedNode>(COOKED_BLOCK_NODES);
+  for (U32 i = 0, count = getCount<CookedNode>(COOKED_BLOCK_NODES); i < count; ++i) {
+    if (nodes[i]._meshId != static_cast<U32>(kCookedNone) && nodes[i]._meshId >= meshCount) return false;
+  }
+
+  const U32* indices = getBlock<U32>(COOKED_BLOCK_INDICES);
+  const U32* meshletVertices = getBlock<U32>(COOKED_BLOCK_MESHLET_VERTICES);
+  const CookedMesh* meshes = getBlock<CookedMesh>(COOKED_BLOCK_MESHES);
+  const CookedPrimitive* primitives = getBlock<CookedPrimitive>(COOKED_BLOCK_PRIMITIVES);
+  const CookedMorphTarget* morphTargets = getBlock<CookedMorphTarget>(COOKED_BLOCK_MORPH_TARGETS);
+  const CookedMeshlet* meshlets = getBlock<CookedMeshlet>(COOKED_BLOCK_MESHLETS);
+  const CookedLod* lods = getBlock<CookedLod>(COOKED_BLOCK_LODS);
+  for (U32 i = 0; i < meshCount; ++i) {
+    const CookedMesh& mesh = meshes[i];
+    U64 vertexSize = (mesh._flags & COOKED_MESH_SKINNED_BIT) ? sizeof(SkinnedVertex) : sizeof(StaticVertex);
+    if (!InRange(mesh._vertexOffset, vertexSize * mesh._vertexCount, getByteSize(COOKED_BLOCK_VERTICES))) return false;
+    if (!InRange(mesh._firstIndex, static_cast<U64>(mesh._indexCount) + mesh._lodIndexCount,
+                 getCount<U32>(COOKED_BLOCK_INDICES))) return false;
+    if (!InRange(mesh._firstLod, mesh._lodCount, getCount<CookedLod>(COOKED_BLOCK_LODS))) return false;
+    if (!InRange(mesh._firstPrimitive, mesh._primitiveCount, primitiveCount)) return false;
+    if (!InRange(mesh._firstMorphTarget, mesh._morphTargetCount, morphTargetCount)) return false;
+    if (!InRange(mesh._firstMeshlet, mesh._meshletCount, getCount<CookedMeshlet>(COOKED_BLOCK_MESHLETS))) return false;
+    if (!InRange(mesh._firstMeshletVertex, mesh._meshletVertexCount, getCount<U32>(COOKED_BLOCK_MESHLET_VERTICES))) return false;
+    if (!InRange(mesh._firstMeshletTriangle, mesh._meshletTriangleCount, getByteSize(COOKED_BLOCK_MESHLET_TRIANGLES))) return false;
+    if (mesh._skeleton != kCookedNone && (mesh._skeleton < 0 || static_cast<U32>(mesh._skeleton) >= skeletonCount)) return false;
+    for (U64 idx = 0, indexCount = static_cast<U64>(mesh._indexCount) + mesh._lodIndexCount; idx < indexCount; ++idx) {
+      if (indices[mesh._firstIndex + idx] >= mesh._vertexCount) return false;
+    }
+    for (U32 v = 0; v < mesh._meshletVertexCount; ++v) {
+      if (meshletVertices[mesh._firstMeshletVertex + v] >= mesh._vertexCount) return false;
+    }
+    for (U32 p = 0; p < mesh._primitiveCount; ++p) {
+      const CookedPrimitive& primitive = primitives[mesh._firstPrimitive + p];
+      if (!InRange(primitive._firstIndex, primitive._indexCount, mesh._indexCount)) return false;
+      if (primitive._material != kCookedNone
+        && (primitive._material < 0 || static_cast<U32>(primitive._material) >= materialCount)) return false;
+      if (!InRange(primitive._firstMeshlet, primitive._meshletCount, mesh._meshletCount)) return false;
+    }
+    for (U32 l = 0; l < mesh._lodCount; ++l) {
+      const CookedLod& lod = lods[mesh._firstLod + l];
+      if (!InRange(lod._firstPrimitive, lod._primitiveCount, primitiveCount)) return false;
+      for (U32 p = 0; p < lod._primitiveCount; ++p) {
+        const CookedPrimitive& primitive = primitives[lod._firstPrimitive + p];
+        if (primitive._firstIndex < mesh._indexCount) return false;
+        if (!InRange(primitive._firstIndex, primitive._indexCount,
+                     static_cast<U64>(mesh._indexCount) + mesh._lodIndexCount)) return false;
+        if (primitive._material != kCookedNone
+          && (primitive._material < 0 || static_cast<U32>(primitive._material) >= materialCount)) return false;
+      }
+    }
+    for (U32 m = 0; m < mesh._meshletCount; ++m) {
+      const CookedMeshlet& meshlet = meshlets[mesh._firstMeshlet + m];
+      if (!InRange(meshlet._vertexOffset, meshlet._vertexCount, mesh._meshletVertexCount)) return false;
+      if (!InRange(meshlet._triangleOffset, static_cast<U64>(meshlet._triangleCount) * 3, mesh._meshletTriangleCount)) return false;
+    }
+    for (U32 m = 0; m < mesh._morphTargetCount; ++m) {
+      const CookedMorphTarget& target = morphTargets[mesh._firstMorphTarget + m];
+      // Morph targets move every vertex of their mesh, and are uploaded at the size they claim.
+      if (target._vertexCount != mesh._vertexCount) return false;
+      if (!InRange(target._firstVertex, target._vertexCount, getCount<MorphVertex>(COOKED_BLOCK_MORPH_VERTICES))) return false;
+    }
+  }
+
+  // Joints come in a byte each, with kNoParentId marking the roots.
+  const CookedSkeleton* skeletons = getBlock<CookedSkeleton>(COOKED_BLOCK_SKELETONS);
+  const CookedJoint* joints = getBlock<CookedJoint>(COOKED_BLOCK_JOINTS);
+  for (U32 i = 0; i < skeletonCount; ++i) {
+    const CookedSkeleton& skeleton = skeletons[i];
+    if (!InRange(skeleton._firstJoint, skeleton._jointCount, getCount<CookedJoint>(COOKED_BLOCK_JOINTS))) return false;
+    if (skeleton._jointCount > Joint::kNoParentId || skeleton._rootInJoints > 1) return false;
+    for (U32 j = 0; j < skeleton._jointCount; ++j) {
+      U32 parent = joints[skeleton._firstJoint + j]._parent;
+      if (parent != Joint::kNoParentId && parent >= skeleton._jointCount) return false;
+    }
+  }
+
+  U32 keyCount = getCount<R32>(COOKED_BLOCK_KEY_TIMES);
+  U32 valueCount = getCount<U16>(COOKED_BLOCK_KEY_VALUES);
+  U32 weightCount = getCount<R32>(COOKED_BLOCK_MORPH_WEIGHTS);
+
+  const CookedClip* clips = getBlock<CookedClip>(COOKED_BLOCK_CLIPS);
+  for (U32 i = 0, count = getCount<CookedClip>(COOKED_BLOCK_CLIPS); i < count; ++i) {
+    const CookedChannel& morphs = clips[i]._morphs;
+    if (!InRange(clips[i]._firstTrack, clips[i]._trackCount, trackCount)) return false;
+    if (!InRange(morphs._firstKey, morphs._keyCount, keyCount)) return false;
+    if (!InRange(morphs._firstValue, static_cast<U64>(morphs._keyCount) * clips[i]._morphTargetCount, weightCount)) return false;
+  }
+
+  const CookedTrack* tracks = getBlock<CookedTrack>(COOKED_BLOCK_TRACKS);
+  for (U32 i = 0; i < trackCount; ++i) {
+    for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+      const CookedChannel& channel = tracks[i]._channels[c];
+      U32 fullWidth = (c == ANIM_CHANNEL_ROTATION) ? kAnimFullRotationWidth : kAnimFullRangeWidth;
+      if (channel._keyWidth != kAnimKeyWidth && channel._keyWidth != fullWidth) return false;
+      if (!InRange(channel._firstKey, channel._keyCount, keyCount)) return false;
+      if (!InRange(channel._firstValue, static_cast<U64>(channel._keyCount) * channel._keyWidth, valueCount)) return false;
+    }
+  }
+  return true;
+}
+
+
+namespace ModelLoader {
+
+
+// Builds each block of a cooked model separately, then lays them out one after another.
+class CookedModelWriter {
+public:
+  // Append records to a block, returning the index of the first.
+  template<typename T>
+  U32 push(CookedBlockType type, const T* data, size_t count) {
+    std::vector<U8>& block = m_blocks[type];
+    U32 index = static_cast<U32>(block.size() / sizeof(T));
+    const U8* bytes = reinterpret_cast<const U8*>(data);
+    block.insert(block.end(), bytes, bytes + sizeof(T) * count);
+    return index;
+  }
+
+  // Append bytes to a block, starting on the block alignment. Returns the byte offset.
+  U64 pushAligned(CookedBlockType type, const void* data, size_t size) {
+    std::vector<U8>& block = m_blocks[type];
+    block.resize(static_cast<size_t>(AlignCooked(block.size())), 0);
+    U64 offset = block.size();
+    const U8* bytes = reinterpret_cast<const U8*>(data);
+    block.insert(block.end(), bytes, bytes + size);
+    return offset;
+  }
+
+  CookedString string(const std::string& str) {
+    CookedString cooked;
+    cooked._offset = push(COOKED_BLOCK_STRINGS, str.data(), str.size());
+    cooked._length = static_cast<U32>(str.size());
+    return cooked;
+  }
+
+  void finish(U32 resultBits, std::vector<U8>* pOut) {
+    CookedModelHeader header = { };
+    header._magic = kCookedModelMagic;
+    header._version = kCookedModelVersion;
+    header._resultBits = resultBits;
+    header._staticVertexSize = sizeof(StaticVertex);
+    header._skinnedVertexSize = sizeof(SkinnedVertex);
+
+    U64 offset = AlignCooked(sizeof(CookedModelHeader));
+    for (U32 i = 0; i < COOKED_BLOCK_COUNT; ++i) {
+      header._blocks[i]._offset = offset;
+      header._blocks[i]._size = m_blocks[i].size();
+      offset = AlignCooked(offset + m_blocks[i].size());
+    }
+    header._size = offset;
+
+    pOut->assign(static_cast<size_t>(offset), 0);
+    memcpy(pOut->data(), &header, sizeof(CookedModelHeader));
+    for (U32 i = 0; i < COOKED_BLOCK_COUNT; ++i) {
+      if (m_blocks[i].empty()) continue;
+      memcpy(pOut->data() + header._blocks[i]._offset, m_blocks[i].data(), m_blocks[i].size());
+    }
+  }
+
+private:
+  std::vector<U8>     m_blocks[COOKED_BLOCK_COUNT];
+};
+
+
+static void CopyMatrix(R32* dst, const Matrix4& src)
+{
+  memcpy(dst, src.Data, sizeof(R32) * 16);
+}
+
+
+static void CopyVector(R32* dst, const Vector3& src)
+{
+  dst[0] = src.x; dst[1] = src.y; dst[2] = src.z;
+}
+
+
+void CookModel(const ImportedModel& model, std::vector<U8>* pOut)
+{
+  CookedModelWriter writer;
+
+  for (auto& it : model._nodeHierarchy) {
+    CookedNode node;
+    node._id = it.first;
+    node._parentId = it.second._parentId;
+    node._nodeConfig = it.second._nodeConfig;
+    node._meshId = it.second._meshId;
+    writer.push(COOKED_BLOCK_NODES, &node, 1);
+  }
+
+  writer.push(COOKED_BLOCK_SAMPLERS, model._samplers.data(), model._samplers.size());
+
+  for (const ImportedTexture& texture : model._textures) {
+    CookedTexture cooked;
+    cooked._name = writer.string(texture._name);
+    cooked._width = texture._width;
+    cooked._height = texture._height;
+    cooked._texelOffset = writer.pushAligned(COOKED_BLOCK_TEXELS, texture._texels.data(), texture._texels.size());
+    cooked._texelSize = texture._texels.size();
+    writer.push(COOKED_BLOCK_TEXTURES, &cooked, 1);
+  }
+
+  for (const ImportedMaterial& material : model._materials) {
+    CookedMaterial cooked = material._desc;
+    cooked._name = writer.string(material._name);
+    writer.push(COOKED_BLOCK_MATERIALS, &cooked, 1);
+  }
+
+  for (const Skeleton& skeleton : model._skeletons) {
+    CookedSkeleton cooked;
+    cooked._name = writer.string(skeleton._name);
+    cooked._rootInJoints = skeleton._rootInJoints;
+    CopyMatrix(cooked._rootInvTransform, skeleton._rootInvTransform);
+    cooked._firstJoint = writer.push<CookedJoint>(COOKED_BLOCK_JOINTS, nullptr, 0);
+    cooked._jointCount = static_cast<U32>(skeleton._joints.size());
+    for (const Joint& joint : skeleton._joints) {
+      CookedJoint cookedJoint;
+      cookedJoint._name = writer.string(joint._name);
+      CopyMatrix(cookedJoint._invBindPose, joint._invBindPose);
+      cookedJoint._parent = joint._iParent;
+      cookedJoint._id = joint._id;
+      writer.push(COOKED_BLOCK_JOINTS, &cookedJoint, 1);
+    }
+    writer.push(COOKED_BLOCK_SKELETONS, &cooked, 1);
+  }
+
+  for (const ImportedMesh& mesh : model._meshes) {
+    CookedMesh cooked;
+    cooked._name = writer.string(mesh._name);
+    cooked._flags = mesh._skinned ? COOKED_MESH_SKINNED_BIT : 0;
+    cooked._skeleton = mesh._skeleton;
+    if (mesh._skinned) {
+      cooked._vertexOffset = writer.pushAligned(COOKED_BLOCK_VERTICES, mesh._skinnedVertices.data(),
+                                                sizeof(SkinnedVertex) * mesh._skinnedVertices.size());
+      cooked._vertexCount = static_cast<U32>(mesh._skinnedVertices.size());
+    } else {
+      cooked._vertexOffset = writer.pushAligned(COOKED_BLOCK_VERTICES, mesh._staticVertices.data(),
+                                                sizeof(StaticVertex) * mesh._staticVertices.size());
+      cooked._vertexCount = static_cast<U32>(mesh._staticVertices.size());
+    }
+    cooked._firstIndex = writer.push(COOKED_BLOCK_INDICES, mesh._indices.data(), mesh._indices.size());
+    cooked._indexCount = static_cast<U32>(mesh._indices.size());
+    cooked._firstPrimitive = writer.push(COOKED_BLOCK_PRIMITIVES, mesh._primitives.data(), mesh._primitives.size());
+    cooked._primitiveCount = static_cast<U32>(mesh._primitives.size());
+
+    // Levels of detail append their indices right after the mesh's.
+    cooked._lodIndexCount = 0;
+    cooked._firstLod = writer.push<CookedLod>(COOKED_BLOCK_LODS, nullptr, 0);
+    cooked._lodCount = static_cast<U32>(mesh._lods.size());
+    for (const ImportedLod& lod : mesh._lods) {
+      U32 base = cooked._indexCount + cooked._lodIndexCount;
+      writer.push(COOKED_BLOCK_INDICES, lod._indices.data(), lod._indices.size());
+      cooked._lodIndexCount += static_cast<U32>(lod._indices.size());
+
+      CookedLod cookedLod;
+      cookedLod._firstPrimitive = writer.push<CookedPrimitive>(COOKED_BLOCK_PRIMITIVES, nullptr, 0);
+      cookedLod._primitiveCount = static_cast<U32>(lod._primitives.size());
+      cookedLod._error = lod._error;
+      for (CookedPrimitive primitive : lod._primitives) {
+        primitive._firstIndex += base;
+        writer.push(COOKED_BLOCK_PRIMITIVES, &primitive, 1);
+      }
+      writer.push(COOKED_BLOCK_LODS, &cookedLod, 1);
+    }
+    cooked._firstMorphTarget = writer.push<CookedMorphTarget>(COOKED_BLOCK_MORPH_TARGETS, nullptr, 0);
+    cooked._morphTargetCount = static_cast<U32>(mesh._morphTargets.size());
+    for (const std::vector<MorphVertex>& target : mesh._morphTargets) {
+      CookedMorphTarget cookedTarget;
+      cookedTarget._firstVertex = writer.push(COOKED_BLOCK_MORPH_VERTICES, target.data(), target.size());
+      cookedTarget._vertexCount = static_cast<U32>(target.size());
+      writer.push(COOKED_BLOCK_MORPH_TARGETS, &cookedTarget, 1);
+    }
+    cooked._firstMeshlet = writer.push(COOKED_BLOCK_MESHLETS, mesh._meshlets.data(), mesh._meshlets.size());
+    cooked._meshletCount = static_cast<U32>(mesh._meshlets.size());
+    cooked._firstMeshletVertex = writer.push(COOKED_BLOCK_MESHLET_VERTICES, mesh._meshletVertices.data(),
+                                             mesh._meshletVertices.size());
+    cooked._meshletVertexCount = static_cast<U32>(mesh._meshletVertices.size());
+    cooked._firstMeshletTriangle = writer.push(COOKED_BLOCK_MESHLET_TRIANGLES, mesh._meshletTriangles.data(),
+                                               mesh._meshletTriangles.size());
+    cooked._meshletTriangleCount = static_cast<U32>(mesh._meshletTriangles.size());
+    CopyVector(cooked._min, mesh._min);
+    CopyVector(cooked._max, mesh._max);
+    writer.push(COOKED_BLOCK_MESHES, &cooked, 1);
+  }
+
+  for (const AnimClip& clip : model._animations) {
+    CookedClip cooked;
+    cooked._name = writer.string(clip._name);
+    cooked._duration = clip._fDuration;
+    cooked._fps = clip._fFps;
+    cooked._looping = clip._bLooping;
+    cooked._firstTrack = writer.push<CookedTrack>(COOKED_BLOCK_TRACKS, nullptr, 0);
+    cooked._trackCount = static_cast<U32>(clip._tracks.size());
+    cooked._morphTargetCount = clip._morphTargetCount;
+    cooked._morphs = CookedChannel{ };
+    cooked._morphs._keyCount = static_cast<U32>(clip._morphTimes.size());
+    cooked._morphs._firstKey = writer.push(COOKED_BLOCK_KEY_TIMES, clip._morphTimes.data(), clip._morphTimes.size());
+    cooked._morphs._firstValue = writer.push(COOKED_BLOCK_MORPH_WEIGHTS, clip._morphWeights.data(), clip._morphWeights.size());
+
+    // Keys are cooked as quantized, and load without converting.
+    for (const AnimTrack& track : clip._tracks) {
+      CookedTrack cookedTrack;
+      cookedTrack._nodeId = track._nodeId;
+      for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+        const AnimChannel& channel = track._channels[c];
+        CookedChannel& cookedChannel = cookedTrack._channels[c];
+        cookedChannel._keyCount = channel._keyCount;
+        cookedChannel._firstKey = writer.push(COOKED_BLOCK_KEY_TIMES, clip._keyTimes[c].data() + channel._firstKey,
+                                              channel._keyCount);
+        cookedChannel._firstValue = writer.push(COOKED_BLOCK_KEY_VALUES, clip._keys[c].data() + channel._firstValue,
+                                                channel._keyCount * channel._keyWidth);
+        cookedChannel._keyWidth = channel._keyWidth;
+        for (U32 i = 0; i < 3; ++i) {
+          cookedChannel._rangeMin[i] = channel._rangeMin[i];
+          cookedChannel._rangeExtent[i] = channel._rangeExtent[i];
+        }
+      }
+      writer.push(COOKED_BLOCK_TRACKS, &cookedTrack, 1);
+    }
+    writer.push(COOKED_BLOCK_CLIPS, &cooked, 1);
+  }
+
+  writer.finish(model._result, pOut);
+}
+} // ModelLoader
+} // Recluse
@@ -0,0 +1,964 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Scene/MeshOptimizer.hpp"
+
+#include "Core/Math/Vector3.hpp"
+#include "Core/Exception.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace Recluse {
+namespace MeshOptimizer {
+
+
+// Cache size Forsyth's scoring assumes. Larger than the measured cache, since scores only
+// need to favor recently used vertices.
+static const U32 kScoringCacheSize = 32;
+
+
+static const R32* GetPosition(const void* positions, size_t stride, U32 vertex)
+{
+  return reinterpret_cast<const R32*>(reinterpret_cast<const U8*>(positions) + stride * vertex);
+}
+
+
+static Vector3 GetVector(const void* positions, size_t stride, U32 vertex)
+{
+  const R32* p = GetPosition(positions, stride, vertex);
+  return Vector3(p[0], p[1], p[2]);
+}
+
+
+// FIFO cache, where a vertex stays cached until cacheSize newer vertices were loaded.
+class CacheSimulator {
+public:
+  CacheSimulator(size_t vertexCount, U32 cacheSize)
+    : m_timestamps(vertexCount, 0)
+    , m_time(cacheSize + 1)
+    , m_cacheSize(cacheSize) { }
+
+  U32 touch(U32 vertex) {
+    if (m_time - m_timestamps[vertex] > m_cacheSize) {
+      m_timestamps[vertex] = m_time++;
+      return 1;
+    }
+    return 0;
+  }
+
+  U32 triangle(const U32* tri) { return touch(tri[0]) + touch(tri[1]) + touch(tri[2]); }
+
+  void reset() { m_time += m_cacheSize + 1; }
+
+private:
+  std::vector<U32>  m_timestamps;
+  U32               m_time;
+  U32               m_cacheSize;
+};
+
+
+CacheStats analyzeVertexCache(const U32* indices, size_t indexCount, size_t vertexCount, U32 cacheSize)
+{
+  CacheStats stats = { 0.0f, 0.0f };
+  size_t triCount = indexCount / 3;
+  if (triCount == 0) return stats;
+
+  CacheSimulator cache(vertexCount, cacheSize);
+  std::vector<U8> used(vertexCount, 0);
+  size_t misses = 0;
+  size_t usedCount = 0;
+  for (size_t i = 0; i < triCount * 3; ++i) {
+    misses += cache.touch(indices[i]);
+    if (!used[indices[i]]) {
+      used[indices[i]] = 1;
+      usedCount++;
+    }
+  }
+  stats._acmr = static_cast<R32>(misses) / static_cast<R32>(triCount);
+  stats._atvr = static_cast<R32>(misses) / static_cast<R32>(usedCount);
+  return stats;
+}
+
+
+static U64 HashVertex(const VertexStream* streams, U32 streamCount, U32 vertex)
+{
+  // FNV-1a over every stream.
+  U64 hash = 14695981039346656037ull;
+  for (U32 s = 0; s < streamCount; ++s) {
+    const U8* bytes = reinterpret_cast<const U8*>(streams[s]._data) + streams[s]._stride * vertex;
+    for (size_t b = 0; b < streams[s]._stride; ++b) {
+      hash = (hash ^ bytes[b]) * 1099511628211ull;
+    }
+  }
+  return hash;
+}
+
+
+static B32 EqualVertex(const VertexStream* streams, U32 streamCount, U32 a, U32 b)
+{
+  for (U32 s = 0; s < streamCount; ++s) {
+    const U8* data = reinterpret_cast<const U8*>(streams[s]._data);
+    if (memcmp(data + streams[s]._stride * a, data + streams[s]._stride * b, streams[s]._stride) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+size_t generateVertexRemap(U32* remap, const U32* indices, size_t indexCount,
+                           size_t vertexCount, const VertexStream* streams, U32 streamCount)
+{
+  for (size_t i = 0; i < vertexCount; ++i) {
+    remap[i] = kUnusedVertex;
+  }
+
+  // Open addressing table of unique vertices, at most half full.
+  size_t tableSize = 1;
+  while (tableSize < vertexCount * 2) tableSize <<= 1;
+  std::vector<U32> table(tableSize, kUnusedVertex);
+
+  U32 next = 0;
+  for (size_t i = 0; i < indexCount; ++i) {
+    U32 vertex = indices[i];
+    if (remap[vertex] != kUnusedVertex) continue;
+
+    size_t slot = static_cast<size_t>(HashVertex(streams, streamCount, vertex)) & (tableSize - 1);
+    while (table[slot] != kUnusedVertex && !EqualVertex(streams, streamCount, table[slot], vertex)) {
+      slot = (slot + 1) & (tableSize - 1);
+    }
+
+    if (table[slot] == kUnusedVertex) {
+      table[slot] = vertex;
+      remap[vertex] = next++;
+    } else {
+      remap[vertex] = remap[table[slot]];
+    }
+  }
+  return next;
+}
+
+
+void remapIndices(U32* dst, const U32* indices, size_t indexCount, const U32* remap)
+{
+  for (size_t i = 0; i < indexCount; ++i) {
+    R_ASSERT(remap[indices[i]] != kUnusedVertex, "Index refers to a vertex that was removed.");
+    dst[i] = remap[indices[i]];
+  }
+}
+
+
+void remapVertices(void* dst, const void* vertices, size_t vertexCount, size_t stride, const U32* remap)
+{
+  U8* out = reinterpret_cast<U8*>(dst);
+  const U8* in = reinterpret_cast<const U8*>(vertices);
+  for (size_t i = 0; i < vertexCount; ++i) {
+    if (remap[i] == kUnusedVertex) continue;
+    memcpy(out + stride * remap[i], in + stride * i, stride);
+  }
+}
+
+
+static R32 VertexScore(I32 cachePosition, U32 remaining)
+{
+  // No triangles left to draw with this vertex.
+  if (remaining == 0) return -1.0f;
+
+  R32 score = 0.0f;
+  if (cachePosition >= 0) {
+    if (cachePosition < 3) {
+      // Used by the last triangle. Slightly lower, so we do not just repeat it.
+      score = 0.75f;
+    } else {
+      R32 scaler = 1.0f - static_cast<R32>(cachePosition - 3) / static_cast<R32>(kScoringCacheSize - 3);
+      score = powf(scaler, 1.5f);
+    }
+  }
+  // Favor vertices with few triangles left, to finish them off.
+  score += 2.0f * powf(static_cast<R32>(remaining), -0.5f);
+  return score;
+}
+
+
+void optimizeVertexCache(U32* dst, const U32* indices, size_t indexCount, size_t vertexCount)
+{
+  size_t triCount = indexCount / 3;
+  if (triCount == 0) return;
+
+  // dst may alias indices.
+  std::vector<U32> input(indices, indices + triCount * 3);
+
+  // Triangles using each vertex.
+  std::vector<U32> remaining(vertexCount, 0);
+  std::vector<U32> offsets(vertexCount + 1, 0);
+  for (size_t i = 0; i < input.size(); ++i) remaining[input[i]]++;
+  for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+  std::vector<U32> adjacency(input.size());
+  {
+    std::vector<U32> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < input.size(); ++i) {
+      adjacency[cursor[input[i]]++] = static_cast<U32>(i / 3);
+    }
+  }
+
+  std::vector<I32> cachePosition(vertexCount, -1);
+  std::vector<R32> vertexScores(vertexCount);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    vertexScores[v] = VertexScore(-1, remaining[v]);
+  }
+
+  std::vector<R32> triangleScores(triCount);
+  for (size_t t = 0; t < triCount; ++t) {
+    triangleScores[t] = vertexScores[input[t * 3 + 0]] + vertexScores[input[t * 3 + 1]] + vertexScores[input[t * 3 + 2]];
+  }
+
+  std::vector<U8> emitted(triCount, 0);
+  U32 cache[kScoringCacheSize + 3];
+  U32 cacheCount = 0;
+  size_t scanCursor = 0;
+  I64 best = -1;
+
+  for (size_t out = 0; out < triCount; ++out) {
+    if (best < 0) {
+      // Nothing in the cache has triangles left, start from the next unused one.
+      while (emitted[scanCursor]) ++scanCursor;
+      best = static_cast<I64>(scanCursor);
+    }
+
+    U32 tri = static_cast<U32>(best);
+    emitted[tri] = 1;
+    const U32* v = &input[tri * 3];
+    dst[out * 3 + 0] = v[0];
+    dst[out * 3 + 1] = v[1];
+    dst[out * 3 + 2] = v[2];
+
+    for (U32 k = 0; k < 3; ++k) {
+      U32* list = &adjacency[offsets[v[k]]];
+      U32& count = remaining[v[k]];
+      for (U32 j = 0; j < count; ++j) {
+        if (list[j] == tri) {
+          list[j] = list[count - 1];
+          count--;
+          break;
+        }
+      }
+    }
+
+    // The triangle's vertices move to the front of the cache.
+    U32 newCache[kScoringCacheSize + 3];
+    U32 newCount = 0;
+    for (U32 k = 0; k < 3; ++k) {
+      if (std::find(newCache, newCache + newCount, v[k]) == newCache + newCount) newCache[newCount++] = v[k];
+    }
+    for (U32 i = 0; i < cacheCount; ++i) {
+      if (cache[i] != v[0] && cache[i] != v[1] && cache[i] != v[2]) newCache[newCount++] = cache[i];
+    }
+
+    for (U32 i = 0; i < newCount; ++i) {
+      U32 vertex = newCache[i];
+      cachePosition[vertex] = i < kScoringCacheSize ? static_cast<I32>(i) : -1;
+      vertexScores[vertex] = VertexScore(cachePosition[vertex], remaining[vertex]);
+    }
+
+    cacheCount = newCount < kScoringCacheSize ? newCount : kScoringCacheSize;
+    memcpy(cache, newCache, sizeof(U32) * cacheCount);
+
+    // Only triangles of vertices that were, or still are, in the cache changed score.
+    best = -1;
+    R32 bestScore = -1.0f;
+    for (U32 i = 0; i < newCount; ++i) {
+      U32 vertex = newCache[i];
+      const U32* list = &adjacency[offsets[vertex]];
+      for (U32 j = 0; j < remaining[vertex]; ++j) {
+        U32 t = list[j];
+        const U32* tv = &input[t * 3];
+        R32 score = vertexScores[tv[0]] + vertexScores[tv[1]] + vertexScores[tv[2]];
+        triangleScores[t] = score;
+        if (score > bestScore) {
+          bestScore = score;
+          best = t;
+        }
+      }
+    }
+  }
+}
+
+
+// Times overdraw ordering tightens its clusters before keeping the cache order.
+static const U32 kOverdrawAttempts = 4;
+
+
+// Split triangles, in cache order, into clusters that each stay within threshold of the cache
+// efficiency of the run they were split from. Clusters hold their first triangle, ending with
+// triCount.
+static void BuildOverdrawClusters(std::vector<U32>& clusters, const U32* indices, size_t triCount,
+                                  size_t vertexCount, R32 threshold)
+{
+  // Hard boundaries, where the cache order starts over anyway.
+  CacheSimulator cache(vertexCount, kCacheSize);
+  std::vector<U32> hard;
+  for (size_t t = 0; t < triCount; ++t) {
+    if (cache.triangle(&indices[t * 3]) == 3 || t == 0) {
+      hard.push_back(static_cast<U32>(t));
+    }
+  }
+  hard.push_back(static_cast<U32>(triCount));
+
+  // Soft boundaries, splitting further as long as each cluster stays within threshold of the
+  // cache efficiency of its hard cluster.
+  clusters.clear();
+  for (size_t h = 0; h + 1 < hard.size(); ++h) {
+    U32 start = hard[h];
+    U32 end = hard[h + 1];
+
+    cache.reset();
+    U32 clusterMisses = 0;
+    for (U32 t = start; t < end; ++t) {
+      clusterMisses += cache.triangle(&indices[t * 3]);
+    }
+    R32 clusterThreshold = threshold * static_cast<R32>(clusterMisses) / static_cast<R32>(end - start);
+
+    cache.reset();
+    clusters.push_back(start);
+    U32 runMisses = 0;
+    U32 runTriangles = 0;
+    for (U32 t = start; t < end; ++t) {
+      runMisses += cache.triangle(&indices[t * 3]);
+      runTriangles++;
+      if (t + 1 < end && static_cast<R32>(runMisses) / static_cast<R32>(runTriangles) <= clusterThreshold) {
+        clusters.push_back(t + 1);
+        cache.reset();
+        runMisses = 0;
+        runTriangles = 0;
+      }
+    }
+  }
+  clusters.push_back(static_cast<U32>(triCount));
+}
+
+
+void optimizeOverdraw(U32* dst, const U32* indices, size_t indexCount,
+                      const void* positions, size_t positionStride, size_t vertexCount,
+                      R32 threshold)
+{
+  size_t triCount = indexCount / 3;
+  if (triCount == 0) return;
+
+  // Area weighted centroid, and normal, of every triangle.
+  std::vector<Vector3> centroids(triCount);
+  std::vector<Vector3> normals(triCount);
+  Vector3 meshCentroid(0.0f, 0.0f, 0.0f);
+  R32 meshArea = 0.0f;
+  for (size_t t = 0; t < triCount; ++t) {
+    Vector3 p0 = GetVector(positions, positionStride, indices[t * 3 + 0]);
+    Vector3 p1 = GetVector(positions, positionStride, indices[t * 3 + 1]);
+    Vector3 p2 = GetVector(positions, positionStride, indices[t * 3 + 2]);
+    normals[t] = (p1 - p0).cross(p2 - p0);
+    centroids[t] = (p0 + p1 + p2) * (1.0f / 3.0f);
+    R32 area = normals[t].length();
+    meshCentroid = meshCentroid + centroids[t] * area;
+    meshArea += area;
+  }
+  meshCentroid = meshArea > 0.0f ? meshCentroid * (1.0f / meshArea) : Vector3(0.0f, 0.0f, 0.0f);
+
+  // Winding may be mirrored on import, so figure out which way normals point on the whole.
+  R32 orientation = 0.0f;
+  for (size_t t = 0; t < triCount; ++t) {
+    orientation += (centroids[t] - meshCentroid).dot(normals[t]);
+  }
+  R32 facing = orientation < 0.0f ? -1.0f : 1.0f;
+
+  // Clusters drawn apart lose the vertices they shared across their boundaries, which can cost
+  // more than threshold. Splitting is then tightened, and the cache order kept if that fails.
+  R32 maxAcmr = analyzeVertexCache(indices, triCount * 3, vertexCount)._acmr * threshold;
+  R32 splitThreshold = threshold;
+  std::vector<U32> clusters;
+  for (U32 attempt = 0; attempt < kOverdrawAttempts; ++attempt) {
+    BuildOverdrawClusters(clusters, indices, triCount, vertexCount, splitThreshold);
+    splitThreshold = 1.0f + (splitThreshold - 1.0f) * 0.5f;
+
+    size_t clusterCount = clusters.size() - 1;
+    std::vector<R32> keys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+      Vector3 centroid(0.0f, 0.0f, 0.0f);
+      Vector3 normal(0.0f, 0.0f, 0.0f);
+      R32 area = 0.0f;
+      for (U32 t = clusters[c]; t < clusters[c + 1]; ++t) {
+        R32 triArea = normals[t].length();
+        centroid = centroid + centroids[t] * triArea;
+        normal = normal + normals[t];
+        area += triArea;
+      }
+      R32 normalLength = normal.length();
+      if (area <= 0.0f || normalLength <= 0.0f) {
+        keys[c] = 0.0f;
+        continue;
+      }
+      centroid = centroid * (1.0f / area);
+      keys[c] = facing * (centroid - meshCentroid).dot(normal * (1.0f / normalLength));
+    }
+
+    // Outer facing clusters first.
+    std::vector<U32> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) order[c] = static_cast<U32>(c);
+    std::stable_sort(order.begin(), order.end(), [&] (U32 a, U32 b) -> bool { return keys[a] > keys[b]; });
+
+    size_t out = 0;
+    for (size_t c = 0; c < clusterCount; ++c) {
+      U32 cluster = order[c];
+      for (U32 t = clusters[cluster]; t < clusters[cluster + 1]; ++t) {
+        dst[out++] = indices[t * 3 + 0];
+        dst[out++] = indices[t * 3 + 1];
+        dst[out++] = indices[t * 3 + 2];
+      }
+    }
+    if (analyzeVertexCache(dst, triCount * 3, vertexCount)._acmr <= maxAcmr) return;
+  }
+  memcpy(dst, indices, sizeof(U32) * triCount * 3);
+}
+
+
+size_t optimizeVertexFetchRemap(U32* remap, const U32* indices, size_t indexCount, size_t vertexCount)
+{
+  for (size_t i = 0; i < vertexCount; ++i) {
+    remap[i] = kUnusedVertex;
+  }
+
+  U32 next = 0;
+  for (size_t i = 0; i < indexCount; ++i) {
+    if (remap[indices[i]] == kUnusedVertex) {
+      remap[indices[i]] = next++;
+    }
+  }
+  return next;
+}
+
+
+size_t buildMeshlets(std::vector<Meshlet>& meshlets,
+                     std::vector<U32>& meshletVertices,
+                     std::vector<U8>& meshletTriangles,
+                     const U32* indices, size_t indexCount, size_t vertexCount,
+                     U32 maxVertices, U32 maxTriangles)
+{
+  R_ASSERT(maxVertices >= 3 && maxVertices <= 255, "Meshlet vertices must fit in a byte.");
+  R_ASSERT(maxTriangles >= 1, "Meshlets need at least one triangle.");
+
+  const U8 kNotInMeshlet = 0xff;
+  std::vector<U8> local(vertexCount, kNotInMeshlet);
+  size_t first = meshlets.size();
+
+  Meshlet meshlet = { static_cast<U32>(meshletVertices.size()), static_cast<U32>(meshletTriangles.size()), 0, 0 };
+  auto finish = [&] () -> void {
+    for (U32 i = 0; i < meshlet._vertexCount; ++i) {
+      local[meshletVertices[meshlet._vertexOffset + i]] = kNotInMeshlet;
+    }
+    meshlets.push_back(meshlet);
+    meshlet._vertexOffset = static_cast<U32>(meshletVertices.size());
+    meshlet._triangleOffset = static_cast<U32>(meshletTriangles.size());
+    meshlet._vertexCount = 0;
+    meshlet._triangleCount = 0;
+  };
+
+  for (size_t t = 0; t < indexCount / 3; ++t) {
+    const U32* tri = &indices[t * 3];
+    U32 added = (local[tri[0]] == kNotInMeshlet ? 1 : 0)
+              + (local[tri[1]] == kNotInMeshlet && tri[1] != tri[0] ? 1 : 0)
+              + (local[tri[2]] == kNotInMeshlet && tri[2] != tri[0] && tri[2] != tri[1] ? 1 : 0);
+
+    if (meshlet._vertexCount + added > maxVertices || meshlet._triangleCount + 1 > maxTriangles) {
+      finish();
+    }
+
+    for (U32 k = 0; k < 3; ++k) {
+      if (local[tri[k]] == kNotInMeshlet) {
+        local[tri[k]] = static_cast<U8>(meshlet._vertexCount++);
+        meshletVertices.push_back(tri[k]);
+      }
+      meshletTriangles.push_back(local[tri[k]]);
+    }
+    meshlet._triangleCount++;
+  }
+
+  if (meshlet._triangleCount > 0) {
+    finish();
+  }
+  return meshlets.size() - first;
+}
+
+
+MeshletBounds computeMeshletBounds(const Meshlet& meshlet,
+                                   const U32* meshletVertices,
+                                   const U8* meshletTriangles,
+                                   const void* positions, size_t positionStride)
+{
+  MeshletBounds bounds;
+  memset(&bounds, 0, sizeof(MeshletBounds));
+  if (meshlet._vertexCount == 0) return bounds;
+
+  const U32* vertices = meshletVertices + meshlet._vertexOffset;
+  const U8* triangles = meshletTriangles + meshlet._triangleOffset;
+
+  Vector3 minimum = GetVector(positions, positionStride, vertices[0]);
+  Vector3 maximum = minimum;
+  for (U32 i = 1; i < meshlet._vertexCount; ++i) {
+    Vector3 p = GetVector(positions, positionStride, vertices[i]);
+    minimum = Vector3::minimum(minimum, p);
+    maximum = Vector3::maximum(maximum, p);
+  }
+  Vector3 center = (minimum + maximum) * 0.5f;
+  R32 radius = 0.0f;
+  for (U32 i = 0; i < meshlet._vertexCount; ++i) {
+    R32 distance = (GetVector(positions, positionStride, vertices[i]) - center).length();
+    radius = distance > radius ? distance : radius;
+  }
+
+  // Average of the unit normals, and the widest angle any of them makes with it.
+  std::vector<Vector3> normals;
+  normals.reserve(meshlet._triangleCount);
+  Vector3 axis(0.0f, 0.0f, 0.0f);
+  for (U32 t = 0; t < meshlet._triangleCount; ++t) {
+    Vector3 p0 = GetVector(positions, positionStride, vertices[triangles[t * 3 + 0]]);
+    Vector3 p1 = GetVector(positions, positionStride, vertices[triangles[t * 3 + 1]]);
+    Vector3 p2 = GetVector(positions, positionStride, vertices[triangles[t * 3 + 2]]);
+    Vector3 n = (p1 - p0).cross(p2 - p0);
+    R32 length = n.length();
+    if (length <= 0.0f) continue;
+    n = n * (1.0f / length);
+    normals.push_back(n);
+    axis = axis + n;
+  }
+
+  bounds._center[0] = center.x; bounds._center[1] = center.y; bounds._center[2] = center.z;
+  bounds._radius = radius;
+  // A cutoff of 1 never culls.
+  bounds._coneCutoff = 1.0f;
+
+  R32 axisLength = axis.length();
+  if (axisLength <= 0.0f) return bounds;
+  axis = axis * (1.0f / axisLength);
+  bounds._coneAxis[0] = axis.x; bounds._coneAxis[1] = axis.y; bounds._coneAxis[2] = axis.z;
+
+  R32 minDot = 1.0f;
+  for (const Vector3& n : normals) {
+    R32 d = n.dot(axis);
+    minDot = d < minDot ? d : minDot;
+  }
+
+  // Normals spread too wide for the cone to ever cull.
+  if (minDot <= 0.1f) return bounds;
+  bounds._coneCutoff = sqrtf(1.0f - minDot * minDot);
+  return bounds;
+}
+
+
+// Vertex kinds, for simplification. Only manifold vertices may collapse along any edge.
+enum SimplifyVertexKind {
+  SIMPLIFY_MANIFOLD,
+  SIMPLIFY_BORDER,
+  SIMPLIFY_SEAM,
+  SIMPLIFY_LOCKED
+};
+
+
+// Weight of the planes that keep borders, and seams, from drifting off their edges.
+static const R32 kBoundaryWeight = 10.0f;
+
+// Marks a vertex with more than one open edge going out, or coming in.
+static const U32 kManyEdges = 0xfffffffe;
+
+
+// Sum of squared distances to a set of weighted planes.
+struct Quadric {
+  R32 _a00, _a11, _a22;
+  R32 _a01, _a02, _a12;
+  R32 _b0, _b1, _b2;
+  R32 _c;
+  R32 _weight;
+};
+
+
+static void AddPlane(Quadric& q, const Vector3& n, R32 d, R32 weight)
+{
+  q._a00 += weight * n.x * n.x;
+  q._a11 += weight * n.y * n.y;
+  q._a22 += weight * n.z * n.z;
+  q._a01 += weight * n.x * n.y;
+  q._a02 += weight * n.x * n.z;
+  q._a12 += weight * n.y * n.z;
+  q._b0 += weight * n.x * d;
+  q._b1 += weight * n.y * d;
+  q._b2 += weight * n.z * d;
+  q._c += weight * d * d;
+  q._weight += weight;
+}
+
+
+static void AddQuadric(Quadric& q, const Quadric& other)
+{
+  q._a00 += other._a00; q._a11 += other._a11; q._a22 += other._a22;
+  q._a01 += other._a01; q._a02 += other._a02; q._a12 += other._a12;
+  q._b0 += other._b0; q._b1 += other._b1; q._b2 += other._b2;
+  q._c += other._c;
+  q._weight += other._weight;
+}
+
+
+// Squared distance, averaged over the weight of the planes.
+static R32 QuadricError(const Quadric& q, const Vector3& p)
+{
+  R32 rx = q._a00 * p.x + q._a01 * p.y + q._a02 * p.z + q._b0;
+  R32 ry = q._a01 * p.x + q._a11 * p.y + q._a12 * p.z + q._b1;
+  R32 rz = q._a02 * p.x + q._a12 * p.y + q._a22 * p.z + q._b2;
+  R32 error = p.x * rx + p.y * ry + p.z * rz + q._b0 * p.x + q._b1 * p.y + q._b2 * p.z + q._c;
+  return q._weight > 0.0f ? fabsf(error) / q._weight : 0.0f;
+}
+
+
+// Directed edges, or incident triangles, of every vertex, packed one vertex after another.
+struct Adjacency {
+  std::vector<U32>  _offsets;
+  std::vector<U32>  _data;
+};
+
+
+static void BuildAdjacency(Adjacency& adjacency, const U32* indices, size_t indexCount,
+                           size_t vertexCount, B32 edges)
+{
+  adjacency._offsets.assign(vertexCount + 1, 0);
+  for (size_t i = 0; i < indexCount; ++i) {
+    adjacency._offsets[indices[i] + 1]++;
+  }
+  for (size_t v = 0; v < vertexCount; ++v) {
+    adjacency._offsets[v + 1] += adjacency._offsets[v];
+  }
+
+  std::vector<U32> fill(adjacency._offsets.begin(), adjacency._offsets.end() - 1);
+  adjacency._data.resize(indexCount);
+  for (size_t i = 0; i < indexCount; ++i) {
+    size_t next = (i % 3) == 2 ? i - 2 : i + 1;
+    adjacency._data[fill[indices[i]]++] = edges ? indices[next] : static_cast<U32>(i / 3);
+  }
+}
+
+
+static B32 HasEdge(const Adjacency& edges, U32 a, U32 b)
+{
+  for (U32 e = edges._offsets[a]; e < edges._offsets[a + 1]; ++e) {
+    if (edges._data[e] == b) return true;
+  }
+  return false;
+}
+
+
+// Edge between any copies of the two positions.
+static B32 HasPositionEdge(const Adjacency& edges, const U32* wedges, const U32* positionRemap, U32 a, U32 b)
+{
+  U32 w = a;
+  do {
+    for (U32 e = edges._offsets[w]; e < edges._offsets[w + 1]; ++e) {
+      if (positionRemap[edges._data[e]] == positionRemap[b]) return true;
+    }
+    w = wedges[w];
+  } while (w != a);
+  return false;
+}
+
+
+// A border vertex has one open edge going out, and one coming in. A seam vertex has two copies,
+// each with one open edge going out and in, that the other copy closes.
+static void ClassifyVertices(std::vector<U8>& kinds, std::vector<U32>& openOut, std::vector<U32>& openIn,
+                             const Adjacency& edges, const U32* wedges, const U32* positionRemap,
+                             const std::vector<U8>& used)
+{
+  size_t vertexCount = used.size();
+  openOut.assign(vertexCount, kUnusedVertex);
+  openIn.assign(vertexCount, kUnusedVertex);
+  for (U32 v = 0; v < vertexCount; ++v) {
+    for (U32 e = edges._offsets[v]; e < edges._offsets[v + 1]; ++e) {
+      U32 t = edges._data[e];
+      if (HasEdge(edges, t, v)) continue;
+      openOut[v] = openOut[v] == kUnusedVertex ? t : kManyEdges;
+      openIn[t] = openIn[t] == kUnusedVertex ? v : kManyEdges;
+    }
+  }
+
+  auto singleOpen = [&] (U32 v) -> B32 { return openOut[v] < kManyEdges && openIn[v] < kManyEdges; };
+
+  kinds.assign(vertexCount, SIMPLIFY_LOCKED);
+  for (U32 v = 0; v < vertexCount; ++v) {
+    if (!used[v]) continue;
+    U32 w = wedges[v];
+    if (w == v) {
+      if (openOut[v] == kUnusedVertex && openIn[v] == kUnusedVertex) {
+        kinds[v] = SIMPLIFY_MANIFOLD;
+      } else if (singleOpen(v)) {
+        kinds[v] = SIMPLIFY_BORDER;
+      }
+    } else if (wedges[w] == v) {
+      B32 seam = true;
+      U32 copies[2] = { v, w };
+      for (U32 c : copies) {
+        seam = seam && singleOpen(c)
+          && HasPositionEdge(edges, wedges, positionRemap, openOut[c], c)
+          && HasPositionEdge(edges, wedges, positionRemap, c, openIn[c]);
+      }
+      if (seam) kinds[v] = SIMPLIFY_SEAM;
+    }
+  }
+}
+
+
+static B32 HasTriangleFlips(const Adjacency& triangles, const U32* indices, const U32* positionRemap,
+                            const std::vector<Vector3>& points, U32 v, U32 t)
+{
+  const Vector3& target = points[t];
+  for (U32 e = triangles._offsets[v]; e < triangles._offsets[v + 1]; ++e) {
+    const U32* tri = &indices[triangles._data[e] * 3];
+    // Triangles on the collapsing edge go away.
+    if (positionRemap[tri[0]] == positionRemap[t] || positionRemap[tri[1]] == positionRemap[t]
+      || positionRemap[tri[2]] == positionRemap[t]) continue;
+
+    Vector3 p[3] = { points[tri[0]], points[tri[1]], points[tri[2]] };
+    Vector3 before = (p[1] - p[0]).cross(p[2] - p[0]);
+    for (U32 k = 0; k < 3; ++k) {
+      if (tri[k] == v) p[k] = target;
+    }
+    Vector3 after = (p[1] - p[0]).cross(p[2] - p[0]);
+    if (before.dot(after) <= 0.0f) return true;
+  }
+  return false;
+}
+
+
+struct Collapse {
+  U32   _v;
+  U32   _t;
+  R32   _cost;
+  R32   _error;
+};
+
+
+size_t simplify(U32* dst, const U32* indices, size_t indexCount,
+                const void* positions, size_t positionStride, size_t vertexCount,
+                size_t targetIndexCount, R32 targetError, R32* pResultError,
+                const void* attributes, size_t attributeStride,
+                const R32* attributeWeights, U32 attributeCount)
+{
+  indexCount = (indexCount / 3) * 3;
+  if (dst != indices) memmove(dst, indices, sizeof(U32) * indexCount);
+  if (pResultError) *pResultError = 0.0f;
+  if (indexCount <= targetIndexCount || vertexCount == 0) return indexCount;
+
+  // Work in a unit cube, so that errors do not depend on the scale of the mesh.
+  std::vector<U8> used(vertexCount, 0);
+  for (size_t i = 0; i < indexCount; ++i) used[dst[i]] = 1;
+  Vector3 minimum = GetVector(positions, positionStride, dst[0]);
+  Vector3 maximum = minimum;
+  for (U32 v = 0; v < vertexCount; ++v) {
+    if (!used[v]) continue;
+    minimum = Vector3::minimum(minimum, GetVector(positions, positionStride, v));
+    maximum = Vector3::maximum(maximum, GetVector(positions, positionStride, v));
+  }
+  Vector3 extent = maximum - minimum;
+  R32 scale = std::max(extent.x, std::max(extent.y, extent.z));
+  if (scale <= 0.0f) scale = 1.0f;
+  std::vector<Vector3> points(vertexCount);
+  for (U32 v = 0; v < vertexCount; ++v) {
+    if (used[v]) points[v] = (GetVector(positions, positionStride, v) - minimum) * (1.0f / scale);
+  }
+
+  // Copies of a vertex, that only differ in attributes, share the first copy's position id.
+  std::vector<U32> positionRemap(vertexCount, kUnusedVertex);
+  {
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2) tableSize <<= 1;
+    std::vector<U32> table(tableSize, kUnusedVertex);
+    for (U32 v = 0; v < vertexCount; ++v) {
+      if (!used[v]) continue;
+      const R32* p = GetPosition(positions, positionStride, v);
+      U64 hash = 14695981039346656037ull;
+      const U8* bytes = reinterpret_cast<const U8*>(p);
+      for (U32 b = 0; b < sizeof(R32) * 3; ++b) hash = (hash ^ bytes[b]) * 1099511628211ull;
+      size_t slot = static_cast<size_t>(hash) & (tableSize - 1);
+      while (table[slot] != kUnusedVertex
+        && memcmp(GetPosition(positions, positionStride, table[slot]), p, sizeof(R32) * 3) != 0) {
+        slot = (slot + 1) & (tableSize - 1);
+      }
+      if (table[slot] == kUnusedVertex) table[slot] = v;
+      positionRemap[v] = table[slot];
+    }
+  }
+
+  auto attributeError = [&] (U32 a, U32 b) -> R32 {
+    if (!attributes) return 0.0f;
+    const R32* pa = GetPosition(attributes, attributeStride, a);
+    const R32* pb = GetPosition(attributes, attributeStride, b);
+    R32 error = 0.0f;
+    for (U32 k = 0; k < attributeCount; ++k) {
+      error += attributeWeights[k] * (pa[k] - pb[k]) * (pa[k] - pb[k]);
+    }
+    return error;
+  };
+
+  std::vector<U32> wedges(vertexCount);
+  std::vector<U32> lastWedge(vertexCount);
+  std::vector<U8> kinds;
+  std::vector<U32> openOut;
+  std::vector<U32> openIn;
+  Adjacency edges;
+  Adjacency triangles;
+
+  // Quadrics start out as the planes of every triangle around a position, weighted by area, and
+  // planes through the open edges of borders and seams.
+  std::vector<Quadric> quadrics(vertexCount);
+  memset(quadrics.data(), 0, sizeof(Quadric) * vertexCount);
+
+  std::vector<U32> remap(vertexCount);
+  for (U32 v = 0; v < vertexCount; ++v) remap[v] = v;
+  std::vector<U8> locked(vertexCount);
+  std::vector<Collapse> best(vertexCount);
+  std::vector<Collapse> collapses;
+  R32 maxError = 0.0f;
+  R32 errorLimit = (targetError / scale) * (targetError / scale);
+  B32 firstPass = true;
+
+  while (indexCount > targetIndexCount) {
+    // Copies of every position, as a ring, only counting vertices still in use.
+    std::fill(used.begin(), used.end(), 0);
+    for (size_t i = 0; i < indexCount; ++i) used[dst[i]] = 1;
+    std::fill(lastWedge.begin(), lastWedge.end(), kUnusedVertex);
+    for (U32 v = 0; v < vertexCount; ++v) {
+      wedges[v] = v;
+      if (!used[v]) continue;
+      U32 id = positionRemap[v];
+      if (lastWedge[id] != kUnusedVertex) {
+        wedges[v] = wedges[lastWedge[id]];
+        wedges[lastWedge[id]] = v;
+      }
+      lastWedge[id] = v;
+    }
+
+    BuildAdjacency(edges, dst, indexCount, vertexCount, true);
+    BuildAdjacency(triangles, dst, indexCount, vertexCount, false);
+    ClassifyVertices(kinds, openOut, openIn, edges, wedges.data(), positionRemap.data(), used);
+
+    if (firstPass) {
+      for (size_t i = 0; i < indexCount; i += 3) {
+        const U32* tri = &dst[i];
+        Vector3 n = (points[tri[1]] - points[tri[0]]).cross(points[tri[2]] - points[tri[0]]);
+        R32 area = n.length();
+        if (area <= 0.0f) continue;
+        n = n * (1.0f / area);
+        for (U32 k = 0; k < 3; ++k) {
+          AddPlane(quadrics[positionRemap[tri[k]]], n, -n.dot(points[tri[k]]), area);
+        }
+
+        for (U32 k = 0; k < 3; ++k) {
+          U32 a = tri[k];
+          U32 b = tri[(k + 1) % 3];
+          if (kinds[a] != SIMPLIFY_BORDER && kinds[a] != SIMPLIFY_SEAM) continue;
+          if (HasEdge(edges, b, a)) continue;
+          Vector3 edge = points[b] - points[a];
+          R32 length = edge.length();
+          if (length <= 0.0f) continue;
+          Vector3 side = edge.cross(n) * (1.0f / length);
+          R32 weight = length * length * kBoundaryWeight;
+          AddPlane(quadrics[positionRemap[a]], side, -side.dot(points[a]), weight);
+          AddPlane(quadrics[positionRemap[b]], side, -side.dot(points[a]), weight);
+        }
+      }
+      firstPass = false;
+    }
+
+    // Cheapest collapse out of every vertex.
+    for (U32 v = 0; v < vertexCount; ++v) {
+      best[v]._v = kUnusedVertex;
+      best[v]._cost = 0.0f;
+    }
+    auto consider = [&] (U32 v, U32 t) -> void {
+      if (positionRemap[v] == positionRemap[t]) return;
+      B32 alongOpenEdge = openOut[v] == t || openIn[v] == t;
+      U32 kind = kinds[v];
+      if (kind == SIMPLIFY_LOCKED) return;
+      if (kind == SIMPLIFY_BORDER && (kinds[t] != SIMPLIFY_BORDER || !alongOpenEdge)) return;
+      R32 attributeCost = attributeError(v, t);
+      if (kind == SIMPLIFY_SEAM) {
+        if (kinds[t] != SIMPLIFY_SEAM || !alongOpenEdge) return;
+        U32 v2 = wedges[v];
+        U32 t2 = wedges[t];
+        if (openOut[v2] != t2 && openIn[v2] != t2) return;
+        attributeCost += attributeError(v2, t2);
+      }
+      R32 error = QuadricError(quadrics[positionRemap[v]], points[t]);
+      R32 cost = error + attributeCost;
+      if (best[v]._v == kUnusedVertex || cost < best[v]._cost) {
+        best[v] = { v, t, cost, error };
+      }
+    };
+    for (size_t i = 0; i < indexCount; i += 3) {
+      for (U32 k = 0; k < 3; ++k) {
+        consider(dst[i + k], dst[i + (k + 1) % 3]);
+        consider(dst[i + (k + 1) % 3], dst[i + k]);
+      }
+    }
+
+    collapses.clear();
+    for (U32 v = 0; v < vertexCount; ++v) {
+      if (best[v]._v != kUnusedVertex && best[v]._error <= errorLimit) collapses.push_back(best[v]);
+    }
+    std::sort(collapses.begin(), collapses.end(),
+              [] (const Collapse& a, const Collapse& b) -> bool { return a._cost < b._cost; });
+
+    // Each position takes part in at most one collapse a pass, cheapest first.
+    std::fill(locked.begin(), locked.end(), 0);
+    size_t goal = (indexCount - targetIndexCount) / 3;
+    size_t removed = 0;
+    std::vector<U32> moved;
+    for (const Collapse& collapse : collapses) {
+      if (removed >= goal) break;
+      U32 v = collapse._v;
+      U32 t = collapse._t;
+      if (locked[positionRemap[v]] || locked[positionRemap[t]]) continue;
+
+      B32 seam = kinds[v] == SIMPLIFY_SEAM;
+      U32 v2 = wedges[v];
+      U32 t2 = wedges[t];
+      if (HasTriangleFlips(triangles, dst, positionRemap.data(), points, v, t)) continue;
+      if (seam && HasTriangleFlips(triangles, dst, positionRemap.data(), points, v2, t2)) continue;
+
+      remap[v] = t;
+      moved.push_back(v);
+      if (seam) {
+        remap[v2] = t2;
+        moved.push_back(v2);
+      }
+      AddQuadric(quadrics[positionRemap[t]], quadrics[positionRemap[v]]);
+      locked[positionRemap[v]] = 1;
+      locked[positionRemap[t]] = 1;
+      maxError = std::max(maxError, collapse._error);
+      removed += kinds[v] == SIMPLIFY_BORDER ? 1 : 2;
+    }
+    if (moved.empty()) break;
+
+    // Drop the triangles that collapsed away.
+    size_t write = 0;
+    for (size_t i = 0; i < indexCount; i += 3) {
+      U32 a = remap[dst[i + 0]];
+      U32 b = remap[dst[i + 1]];
+      U32 c = remap[dst[i + 2]];
+      if (positionRemap[a] == positionRemap[b] || positionRemap[b] == positionRemap[c]
+        || positionRemap[a] == positionRemap[c]) continue;
+      dst[write++] = a;
+      dst[write++] = b;
+      dst[write++] = c;
+    }
+    indexCount = write;
+    for (U32 v : moved) remap[v] = v;
+  }
+
+  if (pResultError) *pResultError = sqrtf(maxError) * scale;
+  return indexCount;
+}
+} // MeshOptimizer
+} // Recluse
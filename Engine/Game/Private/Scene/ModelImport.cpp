@@ -0,0 +1,210 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "ModelImport.hpp"
+
+#include "Core/Thread/Threading.hpp"
+#include "Core/Logging/Log.hpp"
+#include "Core/Exception.hpp"
+
+#include <algorithm>
+
+
+namespace Recluse {
+namespace ModelLoader {
+
+
+// Each level of detail, from level 1 on, simplifies the full mesh until it reaches its share of
+// the triangles, or until the surface would move further than its share of the mesh's size.
+// Meshes hold up to 5 levels, including the full mesh.
+struct LodTarget {
+  R32 _triangleRatio;
+  R32 _relativeError;
+};
+
+static const LodTarget kLodTargets[] = {
+  { 0.5f, 0.01f },
+  { 0.25f, 0.02f },
+  { 0.125f, 0.04f },
+  { 0.0625f, 0.08f }
+};
+
+// Levels that barely simplify further are left out.
+static const R32 kLodMinReduction = 0.9f;
+
+// Normal, with its padding, and first texture coordinates, as laid out in both vertex types.
+static const R32 kLodAttributeWeights[6] = { 0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 1.0f };
+
+
+template<typename Vertex>
+static void RemapMesh(ImportedMesh& mesh, std::vector<Vertex>& vertices, const U32* remap, size_t uniqueCount)
+{
+  MeshOptimizer::remapIndices(mesh._indices.data(), mesh._indices.data(), mesh._indices.size(), remap);
+
+  std::vector<Vertex> remapped(uniqueCount);
+  MeshOptimizer::remapVertices(remapped.data(), vertices.data(), vertices.size(), sizeof(Vertex), remap);
+  vertices.swap(remapped);
+
+  for (std::vector<MorphVertex>& target : mesh._morphTargets) {
+    std::vector<MorphVertex> remappedTarget(uniqueCount);
+    MeshOptimizer::remapVertices(remappedTarget.data(), target.data(), target.size(), sizeof(MorphVertex), remap);
+    target.swap(remappedTarget);
+  }
+}
+
+
+template<typename Vertex>
+static void BuildMeshlets(ImportedMesh& mesh, const std::vector<Vertex>& vertices)
+{
+  std::vector<MeshOptimizer::Meshlet> meshlets;
+  for (CookedPrimitive& primitive : mesh._primitives) {
+    meshlets.clear();
+    MeshOptimizer::buildMeshlets(meshlets, mesh._meshletVertices, mesh._meshletTriangles,
+                                 &mesh._indices[primitive._firstIndex], primitive._indexCount, vertices.size());
+
+    primitive._firstMeshlet = static_cast<U32>(mesh._meshlets.size());
+    primitive._meshletCount = static_cast<U32>(meshlets.size());
+    for (const MeshOptimizer::Meshlet& meshlet : meshlets) {
+      MeshOptimizer::MeshletBounds bounds = MeshOptimizer::computeMeshletBounds(meshlet,
+        mesh._meshletVertices.data(), mesh._meshletTriangles.data(), vertices.data(), sizeof(Vertex));
+      CookedMeshlet cooked;
+      cooked._vertexOffset = meshlet._vertexOffset;
+      cooked._triangleOffset = meshlet._triangleOffset;
+      cooked._vertexCount = meshlet._vertexCount;
+      cooked._triangleCount = meshlet._triangleCount;
+      for (U32 i = 0; i < 3; ++i) {
+        cooked._center[i] = bounds._center[i];
+        cooked._coneAxis[i] = bounds._coneAxis[i];
+      }
+      cooked._radius = bounds._radius;
+      cooked._coneCutoff = bounds._coneCutoff;
+      mesh._meshlets.push_back(cooked);
+    }
+  }
+}
+
+
+template<typename Vertex>
+static void GenerateLods(ImportedMesh& mesh, const std::vector<Vertex>& vertices, ImportOptionBits options)
+{
+  Vector3 extent = mesh._max - mesh._min;
+  R32 size = std::max(extent.x, std::max(extent.y, extent.z));
+  size_t previousCount = mesh._indices.size();
+
+  for (const LodTarget& target : kLodTargets) {
+    ImportedLod lod;
+    lod._error = 0.0f;
+    for (const CookedPrimitive& primitive : mesh._primitives) {
+      size_t first = lod._indices.size();
+      lod._indices.resize(first + primitive._indexCount);
+      size_t targetCount = static_cast<size_t>(primitive._indexCount * target._triangleRatio) / 3 * 3;
+      R32 error = 0.0f;
+      size_t count = MeshOptimizer::simplify(&lod._indices[first], &mesh._indices[primitive._firstIndex],
+                                             primitive._indexCount, vertices.data(), sizeof(Vertex),
+                                             vertices.size(), targetCount, target._relativeError * size,
+                                             &error, &vertices[0].normal.x, sizeof(Vertex),
+                                             kLodAttributeWeights, 6);
+      lod._indices.resize(first + count);
+      if (options & Import_OptimizeMeshes) {
+        MeshOptimizer::optimizeVertexCache(&lod._indices[first], &lod._indices[first], count, vertices.size());
+      }
+
+      // Relative to the level's own indices, until cooked.
+      CookedPrimitive lodPrimitive = primitive;
+      lodPrimitive._firstIndex = static_cast<U32>(first);
+      lodPrimitive._indexCount = static_cast<U32>(count);
+      lodPrimitive._firstMeshlet = 0;
+      lodPrimitive._meshletCount = 0;
+      lod._primitives.push_back(lodPrimitive);
+      lod._error = std::max(lod._error, error);
+    }
+
+    if (lod._indices.empty() || lod._indices.size() > previousCount * kLodMinReduction) break;
+    previousCount = lod._indices.size();
+    mesh._lods.push_back(std::move(lod));
+  }
+}
+
+
+template<typename Vertex>
+static void OptimizeMesh(ImportedMesh& mesh, std::vector<Vertex>& vertices, ImportOptionBits options)
+{
+  std::vector<U32>& indices = mesh._indices;
+  if (indices.empty() || vertices.empty()) return;
+
+  mesh._cacheBefore = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+  mesh._cacheAfter = mesh._cacheBefore;
+
+  if (options & Import_OptimizeMeshes) {
+    // Morph targets are remapped along with the vertices, so they must line up with them.
+    B32 remapVertices = true;
+    for (const std::vector<MorphVertex>& target : mesh._morphTargets) {
+      if (target.size() != vertices.size()) remapVertices = false;
+    }
+
+    std::vector<U32> remap(vertices.size());
+    if (remapVertices) {
+      std::vector<MeshOptimizer::VertexStream> streams;
+      streams.push_back({ vertices.data(), sizeof(Vertex) });
+      for (const std::vector<MorphVertex>& target : mesh._morphTargets) {
+        streams.push_back({ target.data(), sizeof(MorphVertex) });
+      }
+      size_t unique = MeshOptimizer::generateVertexRemap(remap.data(), indices.data(), indices.size(),
+                                                         vertices.size(), streams.data(),
+                                                         static_cast<U32>(streams.size()));
+      RemapMesh(mesh, vertices, remap.data(), unique);
+    }
+
+    // Triangles only move within their primitive, since primitives draw separately.
+    std::vector<U32> reordered;
+    for (const CookedPrimitive& primitive : mesh._primitives) {
+      U32* primIndices = &indices[primitive._firstIndex];
+      size_t count = (primitive._indexCount / 3) * 3;
+      MeshOptimizer::optimizeVertexCache(primIndices, primIndices, count, vertices.size());
+      reordered.resize(count);
+      MeshOptimizer::optimizeOverdraw(reordered.data(), primIndices, count,
+                                      vertices.data(), sizeof(Vertex), vertices.size());
+      std::copy(reordered.begin(), reordered.end(), primIndices);
+    }
+
+    if (remapVertices) {
+      size_t used = MeshOptimizer::optimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), vertices.size());
+      RemapMesh(mesh, vertices, remap.data(), used);
+    }
+
+    mesh._cacheAfter = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+  }
+
+  if (options & Import_BuildMeshlets) {
+    BuildMeshlets(mesh, vertices);
+  }
+
+  if (options & Import_GenerateLods) {
+    GenerateLods(mesh, vertices, options);
+  }
+}
+
+
+void OptimizeMeshes(ImportedModel* pModel, ImportOptionBits options, ThreadPool* pPool)
+{
+  JobCounter counter;
+  pPool->ParallelFor(static_cast<U32>(pModel->_meshes.size()), 1, [&] (U32 start, U32 end) -> void {
+    for (U32 i = start; i < end; ++i) {
+      ImportedMesh& mesh = pModel->_meshes[i];
+      if (mesh._skinned) {
+        OptimizeMesh(mesh, mesh._skinnedVertices, options);
+      } else {
+        OptimizeMesh(mesh, mesh._staticVertices, options);
+      }
+    }
+  }, &counter);
+  pPool->WaitForCounter(&counter);
+
+  for (const ImportedMesh& mesh : pModel->_meshes) {
+    R_DEBUG(rNotify, pModel->_name + " mesh " + mesh._name
+      + ": ACMR " + std::to_string(mesh._cacheBefore._acmr) + " -> " + std::to_string(mesh._cacheAfter._acmr)
+      + ", ATVR " + std::to_string(mesh._cacheBefore._atvr) + " -> " + std::to_string(mesh._cacheAfter._atvr)
+      + ", " + std::to_string(mesh._meshlets.size()) + " meshlets, "
+      + std::to_string(mesh._lods.size()) + " lods.\n");
+  }
+}
+} // ModelLoader
+} // Recluse
@@ -0,0 +1,120 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Math/Vector3.hpp"
+#include "Scene/ModelLoader.hpp"
+#include "Scene/CookedModel.hpp"
+#include "Scene/MeshOptimizer.hpp"
+
+#include "Animation/Skeleton.hpp"
+#include "Animation/Clip.hpp"
+#include "Renderer/Vertex.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace Recluse {
+
+class ThreadPool;
+
+namespace ModelLoader {
+
+
+// Model data read from a source file, before any gpu resources are made for it. Importers fill
+// this in, and it is then cooked, either into a file, or into memory to be loaded right away.
+struct ImportedTexture {
+  std::string                           _name;
+  U32                                   _width;
+  U32                                   _height;
+  std::vector<U8>                       _texels;
+};
+
+
+struct ImportedMaterial {
+  std::string                           _name;
+  CookedMaterial                        _desc;
+};
+
+
+// Lower level of detail of a mesh, sharing the mesh's vertices.
+struct ImportedLod {
+  std::vector<U32>                      _indices;
+  std::vector<CookedPrimitive>          _primitives;
+  R32                                   _error;
+};
+
+
+struct ImportedMesh {
+  std::string                           _name;
+  B32                                   _skinned;
+  I32                                   _skeleton;
+  std::vector<StaticVertex>             _staticVertices;
+  std::vector<SkinnedVertex>            _skinnedVertices;
+  std::vector<U32>                      _indices;
+  std::vector<CookedPrimitive>          _primitives;
+  std::vector<std::vector<MorphVertex> > _morphTargets;
+  std::vector<CookedMeshlet>            _meshlets;
+  std::vector<U32>                      _meshletVertices;
+  std::vector<U8>                       _meshletTriangles;
+  std::vector<ImportedLod>              _lods;
+  Vector3                               _min;
+  Vector3                               _max;
+  // Vertex cache efficiency in source order, and after optimizing.
+  MeshOptimizer::CacheStats             _cacheBefore;
+  MeshOptimizer::CacheStats             _cacheAfter;
+};
+
+
+// Time spent in each stage of an import, in milliseconds.
+struct ImportTimings {
+  R32                                   _parse;
+  R32                                   _images;
+  R32                                   _nodes;
+  R32                                   _meshes;
+  R32                                   _optimize;
+  R32                                   _animations;
+};
+
+
+struct ImportedModel {
+  std::string                           _name;
+  ModelResultBits                       _result;
+  ImportTimings                         _timings;
+  std::map<NodeId, NodeInfo>            _nodeHierarchy;
+  std::vector<CookedSampler>            _samplers;
+  std::vector<ImportedTexture>          _textures;
+  std::vector<ImportedMaterial>         _materials;
+  std::vector<ImportedMesh>             _meshes;
+  std::vector<Skeleton>                 _skeletons;
+  std::vector<AnimClip>                 _animations;
+};
+
+
+// Optimize imported meshes, as jobs on the given pool.
+void OptimizeMeshes(ImportedModel* pModel, ImportOptionBits options, ThreadPool* pPool);
+
+// Pack an imported model into the cooked format.
+void CookModel(const ImportedModel& model, std::vector<U8>* pOut);
+
+namespace GLTF {
+
+// Read a gltf, or glb, file. Does not touch the renderer. Images are decoded, and meshes and
+// animations converted, as jobs on the given pool.
+ModelResultBits import(const std::string& path, ImportedModel* pModel, ThreadPool* pPool,
+                       ImportOptionBits options = kDefaultImportOptions);
+} // GLTF
+
+namespace Cooked {
+
+// Load a cooked model file, by mapping it into memory.
+ModelResultBits load(const std::string& path);
+
+// Create the model's gpu resources, and cache them along with the model, under the given name.
+// Its parts are cached under ids scoped by the path it was loaded from.
+ModelResultBits create(const std::string& name, const std::string& path, const CookedModelView& view);
+} // Cooked
+} // ModelLoader
+} // Recluse
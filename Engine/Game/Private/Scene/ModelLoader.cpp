@@ -1,9 +1,14 @@
 // Copyright (c) 2018 Recluse Project. All rights reserved.
 #include "Scene/ModelLoader.hpp"
 #include "ModelLoaderGLTF.hpp"
+#include "ModelImport.hpp"
 
+#include "Core/Core.hpp"
 #include "Core/Logging/Log.hpp"
 #include "Core/Exception.hpp"
+#include "Filesystem/Filesystem.hpp"
+
+#include <cstring>
 
 #if INCLUDE_FBX
 #include "ModelLoaderFBX.hpp"
@@ -13,6 +18,7 @@ namespace Recluse {
 
 static const U32 kMaxFbxExtensions = 1;
 static const U32 kMaxGLTFExtensions = 2;
+static const U32 kMaxCookedExtensions = 1;
 
 const char* allowed_fbx_extensions[kMaxFbxExtensions] = {
   "fbx"
@@ -25,10 +31,16 @@ const char* allowed_gltf_extensions[kMaxGLTFExtensions] = {
 };
 
 
+const char* allowed_cooked_extensions[kMaxCookedExtensions] = {
+  "rmdl"
+};
+
+
 enum FileType {
   FILETYPE_UNKNOWN = -1,
   FILETYPE_FBX,
-  FILETYPE_GLTF
+  FILETYPE_GLTF,
+  FILETYPE_COOKED
 };
 
 
@@ -37,14 +49,24 @@ namespace ModelLoader {
 
 std::string GetFilenameExt(const std::string& path)
 {
-  size_t cutoff = path.find_last_of('/');
-  if (cutoff != std::string::npos) {
-    size_t removeExtId = path.find_last_of('.') + 1;
-    if (removeExtId != std::string::npos) {
-      std::string ext = path.substr(removeExtId, path.size());
-      return ext;
+  size_t cutoff = path.find_last_of("/\\");
+  size_t removeExtId = path.find_last_of('.');
+  if (removeExtId == std::string::npos
+    || (cutoff != std::string::npos && removeExtId < cutoff)) {
+    return std::string();
+  }
+  return path.substr(removeExtId + 1, path.size());
+}
+
+
+static B32 HasExtension(const std::string& ext, const char** extensions, U32 count)
+{
+  for (U32 i = 0; i < count; ++i) {
+    if (strcmp(extensions[i], ext.c_str()) == 0) {
+      return true;
     }
   }
+  return false;
 }
 
 
@@ -53,7 +75,12 @@ ModelResultBits load(const std::string filename)
   FileType type = FILETYPE_UNKNOWN;
   std::string ext = GetFilenameExt(filename);
 
-  for (U32 i = 0; i < kMaxGLTFExtensions; ++i) {
+  if (HasExtension(ext, allowed_cooked_extensions, kMaxCookedExtensions)) {
+    type = FILETYPE_COOKED;
+    R_DEBUG(rNotify, "mapping cooked model file.\n");
+  }
+
+  for (U32 i = 0; type == FILETYPE_UNKNOWN && i < kMaxGLTFExtensions; ++i) {
     if (strcmp(allowed_gltf_extensions[i], ext.c_str()) == 0) {
       type = FILETYPE_GLTF;
       R_DEBUG(rNotify, "parsing GLTF file.\n");
@@ -81,11 +108,47 @@ ModelResultBits load(const std::string filename)
       result = FBX::load(filename);
       break;
 #endif
+    case FILETYPE_COOKED:
+      result = Cooked::load(filename);
+      break;
     case FILETYPE_GLTF:
     default:
       result = GLTF::load(filename);
   }
   return result;
 }
+
+
+ModelResultBits cook(const std::string source, const std::string destination, ImportOptionBits options)
+{
+  std::string ext = GetFilenameExt(source);
+  if (HasExtension(ext, allowed_fbx_extensions, kMaxFbxExtensions)) {
+    R_DEBUG(rWarning, "Cooking fbx files is not supported yet, convert " + source + " to gltf first.\n");
+    return Model_Fail;
+  }
+
+  if (!HasExtension(ext, allowed_gltf_extensions, kMaxGLTFExtensions)) {
+    R_DEBUG(rError, "Unknown model format for " + source + ".\n");
+    return Model_Fail | Model_Unknown;
+  }
+
+  ImportedModel model;
+  ModelResultBits result = GLTF::import(source, &model, &gCore().ThrPool(), options);
+  if (result & Model_Fail) {
+    return result;
+  }
+
+  std::vector<U8> cooked;
+  CookModel(model, &cooked);
+
+  FilesystemResult written = gFilesystem().WriteTo(destination.c_str(),
+                                                   reinterpret_cast<TChar*>(cooked.data()),
+                                                   static_cast<U32>(cooked.size()));
+  if (written != FilesystemResult_Success) {
+    R_DEBUG(rError, "Failed to write cooked model " + destination + ".\n");
+    return Model_Fail;
+  }
+  return result;
+}
 } // ModelLoader
 } // Recluse
\ No newline at end of file
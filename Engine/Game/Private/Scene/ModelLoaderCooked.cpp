@@ -0,0 +1,476 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "ModelImport.hpp"
+#include "Core/Logging/Log.hpp"
+#include "Core/Utility/Image.hpp"
+#include "Core/Exception.hpp"
+#include "Core/Utility/Profile.hpp"
+
+#include "Filesystem/Filesystem.hpp"
+
+#include "Game/Rendering/RendererResourcesCache.hpp"
+#include "Rendering/TextureCache.hpp"
+#include "Animation/Skeleton.hpp"
+#include "Animation/Clip.hpp"
+#include "Game/Scene/AssetManager.hpp"
+
+#include "Renderer/Vertex.hpp"
+#include "Renderer/MeshData.hpp"
+#include "Renderer/Mesh.hpp"
+#include "Renderer/Material.hpp"
+#include "Renderer/Renderer.hpp"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace Recluse {
+namespace ModelLoader {
+namespace Cooked {
+
+
+// Parts are named after the path of the model they come from, and their index in it, so that
+// parts of different models, or of one model, that share a name never collide.
+static std::string PartName(const std::string& path, const char* kind, U32 index, const std::string& name)
+{
+  return path + "/" + kind + "/" + std::to_string(index) + "/" + name;
+}
+
+
+// Parts of a model registered so far, all of them held by the model.
+struct ModelParts {
+  AssetId               _modelId;
+  std::vector<AssetId>  _ids;
+  // Ids of the parts that others depend on, by their index in the model.
+  std::vector<AssetId>  _samplers;
+  std::vector<AssetId>  _textures;
+  std::vector<AssetId>  _materials;
+};
+
+
+// Register a part of the model, held by the model from the start, so that parts added later
+// can not evict it. A part whose id is taken is destroyed, rather than leaked, and the model
+// fails to load.
+template<typename T>
+static B32 AddPart(AssetId id, T* pPart, U64 bytes, ModelParts& parts)
+{
+  if (!gResourceRegistry().add(id, pPart, bytes, parts._modelId)) {
+    R_DEBUG(rError, "Asset " + gResourceRegistry().getName(id) + " is already loaded.\n");
+    ResourceTraits<T>::destroy(pPart);
+    return false;
+  }
+  parts._ids.push_back(id);
+  return true;
+}
+
+
+static B32 CreateSamplers(const CookedModelView& view, Model* engineModel, ModelParts& parts)
+{
+  const CookedSampler* samplers = view.getBlock<CookedSampler>(COOKED_BLOCK_SAMPLERS);
+  U32 count = view.getCount<CookedSampler>(COOKED_BLOCK_SAMPLERS);
+  for (U32 i = 0; i < count; ++i) {
+    const CookedSampler& sampler = samplers[i];
+    SamplerInfo samplerInfo = { };
+    samplerInfo._addrU = static_cast<SamplerAddressMode>(sampler._addrU);
+    samplerInfo._addrV = static_cast<SamplerAddressMode>(sampler._addrV);
+    samplerInfo._addrW = static_cast<SamplerAddressMode>(sampler._addrW);
+    samplerInfo._minFilter = static_cast<SamplerFilterMode>(sampler._minFilter);
+    samplerInfo._maxFilter = static_cast<SamplerFilterMode>(sampler._maxFilter);
+    samplerInfo._mipmapMode = static_cast<SamplerMipMapMode>(sampler._mipmapMode);
+    samplerInfo._borderColor = static_cast<SamplerBorderColor>(sampler._borderColor);
+    samplerInfo._enableAnisotropy = sampler._enableAnisotropy;
+    samplerInfo._maxAniso = sampler._maxAniso;
+    samplerInfo._maxLod = sampler._maxLod;
+    samplerInfo._minLod = sampler._minLod;
+    samplerInfo._unnnormalizedCoordinates = sampler._unnormalizedCoordinates;
+    TextureSampler* pSampler = gRenderer().createTextureSampler(samplerInfo);
+    if (!AddPart<TextureSampler>(pSampler->UUID(), pSampler, 0, parts)) return false;
+    parts._samplers.push_back(pSampler->UUID());
+    engineModel->samplers.push_back(pSampler);
+  }
+  return true;
+}
+
+
+static B32 CreateTextures(const CookedModelView& view, const std::string& path, Model* engineModel,
+                          ModelParts& parts)
+{
+  const CookedTexture* textures = view.getBlock<CookedTexture>(COOKED_BLOCK_TEXTURES);
+  const U8* texels = view.getBytes(COOKED_BLOCK_TEXELS);
+  U32 count = view.getCount<CookedTexture>(COOKED_BLOCK_TEXTURES);
+  for (U32 i = 0; i < count; ++i) {
+    const CookedTexture& texture = textures[i];
+    Texture2D* pTex = gRenderer().createTexture2D();
+    pTex->initialize(RFORMAT_R8G8B8A8_UNORM, texture._width, texture._height, true);
+
+    // Texels are uploaded straight from the cooked data, the image does not own them.
+    Image img;
+    img._data = const_cast<U8*>(texels + texture._texelOffset);
+    img._memorySize = static_cast<size_t>(texture._texelSize);
+    pTex->update(img);
+    img._data = nullptr;
+
+    pTex->_Name = engineModel->name + "_tex_" + view.getString(texture._name);
+    AssetId id = gResourceRegistry().intern(PartName(path, "tex", i, view.getString(texture._name)));
+    if (!AddPart<Texture2D>(id, pTex, texture._texelSize, parts)) return false;
+    parts._textures.push_back(id);
+    engineModel->textures.push_back(pTex);
+  }
+  return true;
+}
+
+
+static B32 CreateMaterials(const CookedModelView& view, const std::string& path, Model* engineModel,
+                           ModelParts& parts)
+{
+  const CookedMaterial* materials = view.getBlock<CookedMaterial>(COOKED_BLOCK_MATERIALS);
+  U32 count = view.getCount<CookedMaterial>(COOKED_BLOCK_MATERIALS);
+  for (U32 i = 0; i < count; ++i) {
+    const CookedMaterial& mat = materials[i];
+    Material* engineMat = new Material();
+    engineMat->initialize(&gRenderer());
+    engineMat->setMetallicFactor(mat._metallic);
+    engineMat->setRoughnessFactor(mat._roughness);
+
+    auto texture = [&] (CookedMaterialTexture slot) -> Texture2D* { return engineModel->textures[mat._textures[slot]]; };
+    auto sampler = [&] (CookedMaterialTexture slot) -> TextureSampler* { return engineModel->samplers[mat._samplers[slot]]; };
+
+    if (mat._textures[COOKED_MATERIAL_ALBEDO] != kCookedNone) {
+      engineMat->setAlbedo(texture(COOKED_MATERIAL_ALBEDO));
+      if (mat._samplers[COOKED_MATERIAL_ALBEDO] != kCookedNone) engineMat->setAlbedoSampler(sampler(COOKED_MATERIAL_ALBEDO));
+      engineMat->enableAlbedo(true);
+    }
+
+    if (mat._textures[COOKED_MATERIAL_NORMAL] != kCookedNone) {
+      engineMat->setNormal(texture(COOKED_MATERIAL_NORMAL));
+      if (mat._samplers[COOKED_MATERIAL_NORMAL] != kCookedNone) engineMat->setNormalSampler(sampler(COOKED_MATERIAL_NORMAL));
+      engineMat->enableNormal(true);
+    }
+
+    if (mat._textures[COOKED_MATERIAL_ROUGH_METAL] != kCookedNone) {
+      engineMat->setRoughnessMetallic(texture(COOKED_MATERIAL_ROUGH_METAL));
+      if (mat._samplers[COOKED_MATERIAL_ROUGH_METAL] != kCookedNone) engineMat->setRoughMetalSampler(sampler(COOKED_MATERIAL_ROUGH_METAL));
+      engineMat->enableRoughness(true);
+      engineMat->enableMetallic(true);
+    }
+
+    if (mat._textures[COOKED_MATERIAL_AO] != kCookedNone) {
+      engineMat->setAo(texture(COOKED_MATERIAL_AO));
+      if (mat._samplers[COOKED_MATERIAL_AO] != kCookedNone) engineMat->setAoSampler(sampler(COOKED_MATERIAL_AO));
+      engineMat->enableAo(true);
+    }
+
+    if (mat._textures[COOKED_MATERIAL_EMISSIVE] != kCookedNone) {
+      engineMat->setEmissive(texture(COOKED_MATERIAL_EMISSIVE));
+      if (mat._samplers[COOKED_MATERIAL_EMISSIVE] != kCookedNone) engineMat->setEmissiveSampler(sampler(COOKED_MATERIAL_EMISSIVE));
+      engineMat->enableEmissive(true);
+    }
+
+    if (mat._flags & COOKED_MATERIAL_BASE_COLOR_BIT) {
+      engineMat->setBaseColor(Vector4(mat._baseColor[0], mat._baseColor[1], mat._baseColor[2], mat._baseColor[3]));
+    }
+
+    if (mat._flags & COOKED_MATERIAL_TRANSPARENT_BIT) {
+      engineMat->setTransparent(true);
+    }
+
+    if (mat._flags & COOKED_MATERIAL_OPACITY_BIT) {
+      engineMat->setOpacity(mat._opacity);
+    }
+
+    AssetId id = gResourceRegistry().intern(PartName(path, "mat", i, view.getString(mat._name)));
+    if (!AddPart<Material>(id, engineMat, 0, parts)) return false;
+    parts._materials.push_back(id);
+    engineModel->materials.push_back(engineMat);
+
+    // The material keeps its textures resident, so that whoever holds it can draw with it.
+    for (U32 slot = 0; slot < COOKED_MATERIAL_TEXTURE_COUNT; ++slot) {
+      if (mat._textures[slot] != kCookedNone) gResourceRegistry().addDependency(id, parts._textures[mat._textures[slot]]);
+      if (mat._samplers[slot] != kCookedNone) gResourceRegistry().addDependency(id, parts._samplers[mat._samplers[slot]]);
+    }
+  }
+  return true;
+}
+
+
+static void CreateSkeletons(const CookedModelView& view, Model* engineModel, std::vector<skeleton_uuid_t>& skeletonIds)
+{
+  const CookedSkeleton* skeletons = view.getBlock<CookedSkeleton>(COOKED_BLOCK_SKELETONS);
+  const CookedJoint* joints = view.getBlock<CookedJoint>(COOKED_BLOCK_JOINTS);
+  U32 count = view.getCount<CookedSkeleton>(COOKED_BLOCK_SKELETONS);
+  skeletonIds.resize(count);
+  for (U32 i = 0; i < count; ++i) {
+    const CookedSkeleton& cooked = skeletons[i];
+    Skeleton skeleton;
+    skeleton._name = view.getString(cooked._name);
+    skeleton._rootInJoints = cooked._rootInJoints;
+    skeleton._rootInvTransform = Matrix4(cooked._rootInvTransform);
+    skeleton._joints.resize(cooked._jointCount);
+    for (U32 j = 0; j < cooked._jointCount; ++j) {
+      const CookedJoint& joint = joints[cooked._firstJoint + j];
+      skeleton._joints[j]._invBindPose = Matrix4(joint._invBindPose);
+      skeleton._joints[j]._name = view.getString(joint._name);
+      skeleton._joints[j]._iParent = static_cast<U8>(joint._parent);
+      skeleton._joints[j]._id = static_cast<U8>(joint._id);
+    }
+
+    Skeleton::pushSkeleton(skeleton);
+    engineModel->skeletons.push_back(Skeleton::getSkeleton(skeleton._uuid));
+    skeletonIds[i] = skeleton._uuid;
+  }
+}
+
+
+static B32 CreateMeshes(const CookedModelView& view, const std::string& path, Model* engineModel,
+                        const std::vector<skeleton_uuid_t>& skeletonIds, ModelParts& parts)
+{
+  const CookedMesh* meshes = view.getBlock<CookedMesh>(COOKED_BLOCK_MESHES);
+  const CookedPrimitive* primitives = view.getBlock<CookedPrimitive>(COOKED_BLOCK_PRIMITIVES);
+  const CookedLod* lods = view.getBlock<CookedLod>(COOKED_BLOCK_LODS);
+  const CookedMorphTarget* morphTargets = view.getBlock<CookedMorphTarget>(COOKED_BLOCK_MORPH_TARGETS);
+  const U8* vertices = view.getBytes(COOKED_BLOCK_VERTICES);
+  const MorphVertex* morphVertices = view.getBlock<MorphVertex>(COOKED_BLOCK_MORPH_VERTICES);
+  const U32* indices = view.getBlock<U32>(COOKED_BLOCK_INDICES);
+  U32 count = view.getCount<CookedMesh>(COOKED_BLOCK_MESHES);
+  for (U32 i = 0; i < count; ++i) {
+    const CookedMesh& mesh = meshes[i];
+    B32 skinned = (mesh._flags & COOKED_MESH_SKINNED_BIT);
+    Mesh* pMesh = new Mesh();
+
+    // Vertex, and index, data is handed to the renderer right out of the cooked data. The
+    // renderer only reads from it, while copying into its buffers. Every level of detail
+    // shares the one index buffer.
+    pMesh->initialize(&gRenderer(), mesh._vertexCount, const_cast<U8*>(vertices + mesh._vertexOffset),
+                      skinned ? Mesh::SKINNED : Mesh::STATIC, mesh._indexCount + mesh._lodIndexCount,
+                      const_cast<U32*>(indices + mesh._firstIndex));
+    pMesh->setMin(Vector3(mesh._min[0], mesh._min[1], mesh._min[2]));
+    pMesh->setMax(Vector3(mesh._max[0], mesh._max[1], mesh._max[2]));
+    pMesh->updateAABB();
+
+    U64 vertexSize = skinned ? view.getHeader()._skinnedVertexSize : view.getHeader()._staticVertexSize;
+    U64 bytes = mesh._vertexCount * vertexSize + (mesh._indexCount + mesh._lodIndexCount) * sizeof(U32);
+    for (U32 m = 0; m < mesh._morphTargetCount; ++m) {
+      bytes += morphTargets[mesh._firstMorphTarget + m]._vertexCount * sizeof(MorphVertex);
+    }
+    AssetId id = gResourceRegistry().intern(PartName(path, "mesh", i, view.getString(mesh._name)));
+    if (!AddPart<Mesh>(id, pMesh, bytes, parts)) return false;
+    engineModel->meshes.push_back(pMesh);
+
+    // The mesh keeps the materials it draws with resident, so that holding the mesh is enough.
+    std::vector<I32> meshMaterials;
+    auto pushPrimitives = [&] (U32 first, U32 count, U32 lod) -> void {
+      for (U32 p = 0; p < count; ++p) {
+        const CookedPrimitive& cooked = primitives[first + p];
+        if (cooked._material != kCookedNone
+          && std::find(meshMaterials.begin(), meshMaterials.end(), cooked._material) == meshMaterials.end()) {
+          meshMaterials.push_back(cooked._material);
+          gResourceRegistry().addDependency(id, parts._materials[cooked._material]);
+        }
+        Primitive primData;
+        primData._pMat = cooked._material != kCookedNone ? engineModel->materials[cooked._material] : nullptr;
+        primData._firstIndex = cooked._firstIndex;
+        primData._indexCount = cooked._indexCount;
+        primData._localConfigs = cooked._configs;
+        primData._aabb.min = Vector3(cooked._min[0], cooked._min[1], cooked._min[2]);
+        primData._aabb.max = Vector3(cooked._max[0], cooked._max[1], cooked._max[2]);
+        primData._aabb.computeCentroid();
+        pMesh->pushPrimitive(primData, lod);
+      }
+    };
+
+    pushPrimitives(mesh._firstPrimitive, mesh._primitiveCount, Mesh::kMeshLodZero);
+    U32 lodCount = std::min(mesh._lodCount, Mesh::kMaxMeshLodWidth - 1);
+    for (U32 l = 0; l < lodCount; ++l) {
+      const CookedLod& lod = lods[mesh._firstLod + l];
+      pushPrimitives(lod._firstPrimitive, lod._primitiveCount, l + 1);
+      pMesh->setLodError(l + 1, lod._error);
+    }
+    pMesh->sortPrimitives(Mesh::TRANSPARENCY_LAST);
+
+    if (mesh._morphTargetCount) {
+      pMesh->allocateMorphTargetBuffer(mesh._morphTargetCount);
+      for (U32 m = 0; m < mesh._morphTargetCount; ++m) {
+        const CookedMorphTarget& target = morphTargets[mesh._firstMorphTarget + m];
+        pMesh->initializeMorphTarget(&gRenderer(), m, target._vertexCount,
+          const_cast<MorphVertex*>(morphVertices + target._firstVertex), sizeof(MorphVertex));
+      }
+    }
+
+    if (skinned && mesh._skeleton != kCookedNone) {
+      pMesh->setSkeletonReference(skeletonIds[mesh._skeleton]);
+    }
+  }
+  return true;
+}
+
+
+// Skeleton whose joints most of the clip's tracks animate, or null for clips that only move
+// plain nodes.
+static Skeleton* FindClipSkeleton(const AnimClip& clip, const Model* engineModel)
+{
+  Skeleton* pBest = nullptr;
+  U32 bestCount = 0;
+  for (Skeleton* pSkeleton : engineModel->skeletons) {
+    U32 count = 0;
+    for (const AnimTrack& track : clip._tracks) {
+      for (const Joint& joint : pSkeleton->_joints) {
+        if (joint._id == static_cast<U8>(track._nodeId)) { ++count; break; }
+      }
+    }
+    if (count > bestCount) {
+      pBest = pSkeleton;
+      bestCount = count;
+    }
+  }
+  return pBest;
+}
+
+
+static B32 CreateAnimations(const CookedModelView& view, const std::string& path, Model* engineModel,
+                            ModelParts& parts)
+{
+  const CookedClip* clips = view.getBlock<CookedClip>(COOKED_BLOCK_CLIPS);
+  const CookedTrack* tracks = view.getBlock<CookedTrack>(COOKED_BLOCK_TRACKS);
+  const R32* times = view.getBlock<R32>(COOKED_BLOCK_KEY_TIMES);
+  const U16* values = view.getBlock<U16>(COOKED_BLOCK_KEY_VALUES);
+  const R32* weights = view.getBlock<R32>(COOKED_BLOCK_MORPH_WEIGHTS);
+  U32 count = view.getCount<CookedClip>(COOKED_BLOCK_CLIPS);
+  for (U32 i = 0; i < count; ++i) {
+    const CookedClip& cooked = clips[i];
+    AnimClip* clip = new AnimClip();
+    clip->_name = view.getString(cooked._name);
+    clip->_fDuration = cooked._duration;
+    clip->_fFps = cooked._fps;
+    clip->_bLooping = cooked._looping;
+
+    U32 keyCounts[ANIM_CHANNEL_COUNT] = { 0, 0, 0 };
+    U32 valueCounts[ANIM_CHANNEL_COUNT] = { 0, 0, 0 };
+    for (U32 t = 0; t < cooked._trackCount; ++t) {
+      for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+        const CookedChannel& channel = tracks[cooked._firstTrack + t]._channels[c];
+        keyCounts[c] += channel._keyCount;
+        valueCounts[c] += channel._keyCount * channel._keyWidth;
+      }
+    }
+    for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+      clip->_keyTimes[c].reserve(keyCounts[c]);
+      clip->_keys[c].reserve(valueCounts[c]);
+    }
+
+    // Keys stay quantized, the sampler decodes them as it goes.
+    clip->_tracks.resize(cooked._trackCount);
+    for (U32 t = 0; t < cooked._trackCount; ++t) {
+      const CookedTrack& cookedTrack = tracks[cooked._firstTrack + t];
+      AnimTrack& track = clip->_tracks[t];
+      track._nodeId = cookedTrack._nodeId;
+      track._joint = cookedTrack._nodeId;
+      for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+        const CookedChannel& channel = cookedTrack._channels[c];
+        std::vector<R32>& keyTimes = clip->_keyTimes[c];
+        track._channels[c]._firstKey = static_cast<U32>(keyTimes.size());
+        track._channels[c]._keyCount = channel._keyCount;
+        track._channels[c]._firstValue = static_cast<U32>(clip->_keys[c].size());
+        track._channels[c]._keyWidth = channel._keyWidth;
+        for (U32 j = 0; j < 3; ++j) {
+          track._channels[c]._rangeMin[j] = channel._rangeMin[j];
+          track._channels[c]._rangeExtent[j] = channel._rangeExtent[j];
+        }
+        keyTimes.insert(keyTimes.end(), times + channel._firstKey, times + channel._firstKey + channel._keyCount);
+        const U16* v = values + channel._firstValue;
+        clip->_keys[c].insert(clip->_keys[c].end(), v, v + channel._keyCount * channel._keyWidth);
+      }
+    }
+
+    clip->_morphTargetCount = cooked._morphTargetCount;
+    clip->_morphTimes.assign(times + cooked._morphs._firstKey, times + cooked._morphs._firstKey + cooked._morphs._keyCount);
+    clip->_morphWeights.assign(weights + cooked._morphs._firstValue,
+                               weights + cooked._morphs._firstValue + cooked._morphs._keyCount * cooked._morphTargetCount);
+
+    // Tracks map to their joints now, rather than every time the clip is sampled.
+    clip->bindSkeleton(FindClipSkeleton(*clip, engineModel));
+
+    U64 bytes = clip->_tracks.size() * sizeof(AnimTrack) + clip->getKeyByteSize();
+    AssetId id = gResourceRegistry().intern(PartName(path, "anim", i, clip->_name));
+    if (!AddPart<AnimClip>(id, clip, bytes, parts)) return false;
+    engineModel->animations.push_back(clip);
+  }
+  return true;
+}
+
+
+ModelResultBits create(const std::string& name, const std::string& path, const CookedModelView& view)
+{
+  // Registering into the caches, and creating gpu resources, stays on the calling thread.
+  R_TIMED_PROFILE(PROFILE_TYPES_GAME, "Cooked::create");
+  Model* model = new Model();
+  model->name = name;
+
+  const CookedNode* nodes = view.getBlock<CookedNode>(COOKED_BLOCK_NODES);
+  U32 nodeCount = view.getCount<CookedNode>(COOKED_BLOCK_NODES);
+  for (U32 i = 0; i < nodeCount; ++i) {
+    NodeInfo& info = model->nodeHierarchy[nodes[i]._id];
+    info._parentId = nodes[i]._parentId;
+    info._nodeConfig = nodes[i]._nodeConfig;
+    info._meshId = nodes[i]._meshId;
+  }
+
+  // The model is registered first, and keeps everything it is built from resident until the
+  // model itself goes. It is held while loading, so that other loads can not evict it.
+  ModelParts parts;
+  parts._modelId = gResourceRegistry().intern(name);
+  if (!gResourceRegistry().add(parts._modelId, model)) {
+    R_DEBUG(rError, "A model named " + name + " is already loaded, " + path + " is not loaded.\n");
+    delete model;
+    return Model_Fail | Model_Cached;
+  }
+  ResourceHandle<Model> hold = gResourceRegistry().acquire<Model>(parts._modelId);
+
+  std::vector<skeleton_uuid_t> skeletonIds;
+  B32 created = CreateSamplers(view, model, parts)
+             && CreateTextures(view, path, model, parts)
+             && CreateMaterials(view, path, model, parts);
+  if (created) {
+    CreateSkeletons(view, model, skeletonIds);
+    created = CreateMeshes(view, path, model, skeletonIds, parts)
+           && CreateAnimations(view, path, model, parts);
+  }
+
+  if (!created) {
+    // The model lets go of its parts as it goes, and they follow it, newest first.
+    hold.release();
+    gResourceRegistry().destroy(parts._modelId);
+    for (auto it = parts._ids.rbegin(); it != parts._ids.rend(); ++it) {
+      gResourceRegistry().destroy(*it);
+    }
+    // Skeletons live outside the registry, in the skeleton table.
+    for (skeleton_uuid_t id : skeletonIds) {
+      Skeleton::removeSkeleton(id);
+    }
+    return Model_Fail;
+  }
+  return view.getHeader()._resultBits | Model_Cached | Model_Success;
+}
+
+
+ModelResultBits load(const std::string& path)
+{
+  FileView file;
+  if (gFilesystem().MapFile(path.c_str(), &file) != FilesystemResult_Success) {
+    R_DEBUG(rError, "Failed to map cooked model " + path + ".\n");
+    return Model_Fail;
+  }
+
+  CookedModelView view;
+  if (!view.open(file.data(), file.size())) {
+    R_DEBUG(rError, path + " is not a cooked model, or was cooked by a different build.\n");
+    return Model_Fail;
+  }
+
+  size_t cutoff = path.find_last_of("/\\");
+  size_t start = cutoff == std::string::npos ? 0 : cutoff + 1;
+  size_t ext = path.find_last_of('.');
+  std::string name = path.substr(start, (ext == std::string::npos || ext < start) ? std::string::npos : ext - start);
+  return create(name, path, view);
+}
+} // Cooked
+} // ModelLoader
+} // Recluse
@@ -1,22 +1,23 @@
 // Copyright (c) 2018 Recluse Project. All rights reserved.
 #include "ModelLoaderGLTF.hpp"
+#include "ModelImport.hpp"
+#include "Core/Core.hpp"
 #include "Core/Logging/Log.hpp"
-#include "Core/Utility/Image.hpp"
 #include "Core/Exception.hpp"
+#include "Core/Utility/Profile.hpp"
+#include "Core/Utility/stb_image.hpp"
 
-#include "Game/Rendering/RendererResourcesCache.hpp"
-#include "Rendering/TextureCache.hpp"
 #include "Animation/Skeleton.hpp"
 #include "Animation/Clip.hpp"
-#include "Game/Scene/AssetManager.hpp"
+#include "Animation/ClipCompressor.hpp"
 
 #include "Renderer/Vertex.hpp"
-#include "Renderer/MeshData.hpp"
 #include "Renderer/Mesh.hpp"
-#include "Renderer/Material.hpp"
-#include "Renderer/Renderer.hpp"
+#include "Renderer/RenderCmd.hpp"
+#include "Renderer/TextureType.hpp"
 
 #include "tiny_gltf.hpp"
+#include <atomic>
 #include <queue>
 #include <vector>
 #include <stack>
@@ -100,61 +101,99 @@ namespace Recluse {
 namespace ModelLoader {
 namespace GLTF {
 
-void GeneratePrimitive(Primitive& handle, Material* mat, U32 firstIndex, U32 indexCount)
+static void GeneratePrimitive(CookedPrimitive& handle, I32 material, U32 firstIndex, U32 indexCount)
 {
-  handle._pMat = mat;
+  handle._material = material;
   handle._firstIndex = firstIndex;
   handle._indexCount = indexCount;
-  handle._localConfigs = 0;
+  handle._configs = 0;
+  handle._firstMeshlet = 0;
+  handle._meshletCount = 0;
 }
 
 
-static ModelResultBits LoadTextures(tinygltf::Model* gltfModel, Model* engineModel)
+static void StoreBounds(CookedPrimitive& handle, const Vector3& min, const Vector3& max)
 {
-  for (tinygltf::Image& image : gltfModel->images) {
-    Texture2D* pTex = gRenderer().createTexture2D();
-    pTex->initialize(RFORMAT_R8G8B8A8_UNORM, static_cast<U32>(image.width),
-                  static_cast<U32>(image.height), true);
-    Image img;
-
-    U8* pImgBuffer = nullptr;
-    B8  bHeapAlloc = false;
-    if (image.component == 3) {
-      // From Sacha Willem's pbr gltf 2.0 work.
-      // https://github.com/SaschaWillems/Vulkan-glTF-PBR/blob/master/base/VulkanglTFModel.hpp
-      img._memorySize = image.width * image.height * 4;
-      pImgBuffer = new U8[img._memorySize];
-      U8* rgba = pImgBuffer;
-      U8* rgb = image.image.data();
-      for (size_t i = 0; i < image.width * image.height; ++i) {
-        for (size_t j = 0; j < 3; ++j) {
-          rgba[j] = rgb[j];
-        }
-        rgba[3] = 0xff; // For opaque
-        rgba += 4;
-        rgb += 3;
-      } 
-      bHeapAlloc = true;
-    } else {
-      pImgBuffer = image.image.data();
-      img._memorySize = image.image.size();
-    }
-  
-    img._data = pImgBuffer;
+  handle._min[0] = min.x; handle._min[1] = min.y; handle._min[2] = min.z;
+  handle._max[0] = max.x; handle._max[1] = max.y; handle._max[2] = max.z;
+}
 
-    pTex->update(img);
-    
-    if (bHeapAlloc) { delete pImgBuffer; }
 
-    pTex->_Name = engineModel->name + "_tex_";
-    if (image.uri.empty()) {
-      pTex->_Name += image.name;
-    } else {
-      pTex->_Name += image.uri;
-    }
+// Image loader given to tinygltf. Only keeps the encoded bytes, so that images can be decoded
+// in parallel once the whole file is parsed.
+static bool DeferImageDecode(tinygltf::Image* image, std::string* err, int reqWidth, int reqHeight,
+                             const unsigned char* bytes, int size, void* userData)
+{
+  image->width = reqWidth;
+  image->height = reqHeight;
+  image->component = 0;
+  image->image.assign(bytes, bytes + size);
+  return true;
+}
+
 
-    TextureCache::cache(pTex);
-    engineModel->textures.push_back(pTex);
+// Returns false if the image could not be decoded, or has no texels.
+static B32 ImportTexture(tinygltf::Image& image, ImportedTexture& texture)
+{
+  if (image.uri.empty()) {
+    texture._name = image.name;
+  } else {
+    texture._name = image.uri;
+  }
+
+  if (image.component != 0 || image.image.empty()) {
+    // Already decoded, or was never found.
+    texture._width = static_cast<U32>(image.width);
+    texture._height = static_cast<U32>(image.height);
+    texture._texels = std::move(image.image);
+    return texture._width > 0 && texture._height > 0
+      && texture._texels.size() == static_cast<size_t>(texture._width) * texture._height * 4;
+  }
+
+  // Decode straight into RGBA.
+  I32 width = 0, height = 0, comp = 0;
+  U8* data = stbi_load_from_memory(image.image.data(), static_cast<I32>(image.image.size()),
+                                   &width, &height, &comp, 4);
+  std::vector<U8>().swap(image.image);
+  if (!data) {
+    R_DEBUG(rWarning, "Failed to decode image " + texture._name + ".\n");
+    texture._width = 0;
+    texture._height = 0;
+    return false;
+  }
+  texture._width = static_cast<U32>(width);
+  texture._height = static_cast<U32>(height);
+  texture._texels.assign(data, data + static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+  stbi_image_free(data);
+  return width > 0 && height > 0;
+}
+
+
+// Images that fail to import are left out, and materials using them fall back to the default
+// textures. Fills in the index each image ends up at, or kCookedNone.
+static ModelResultBits ImportTextures(tinygltf::Model* gltfModel, ImportedModel* engineModel, ThreadPool* pPool,
+                                      std::vector<I32>& textureIndices)
+{
+  U32 imageCount = static_cast<U32>(gltfModel->images.size());
+  std::vector<ImportedTexture> textures(imageCount);
+  std::vector<U8> imported(imageCount, 0);
+  JobCounter counter;
+  pPool->ParallelFor(imageCount, 1, [&] (U32 start, U32 end) -> void {
+    for (U32 i = start; i < end; ++i) {
+      imported[i] = ImportTexture(gltfModel->images[i], textures[i]) ? 1 : 0;
+    }
+  }, &counter);
+  pPool->WaitForCounter(&counter);
+
+  textureIndices.assign(imageCount, kCookedNone);
+  engineModel->_textures.clear();
+  for (U32 i = 0; i < imageCount; ++i) {
+    if (!imported[i]) {
+      R_DEBUG(rWarning, "Leaving out texture " + textures[i]._name + ", using defaults instead.\n");
+      continue;
+    }
+    textureIndices[i] = static_cast<I32>(engineModel->_textures.size());
+    engineModel->_textures.push_back(std::move(textures[i]));
   }
 
   if ( gltfModel->textures.empty() ) {
@@ -175,7 +214,7 @@ static SamplerAddressMode GetSamplerAddressMode(I32 wrap)
 }
 
 
-static void InitSamplerFilterMode(SamplerInfo& info, I32 minFilter, I32 magFilter)
+static void InitSamplerFilterMode(CookedSampler& info, I32 minFilter, I32 magFilter)
 {
   switch (minFilter) {
     case TINYGLTF_TEXTURE_FILTER_NEAREST:
@@ -223,10 +262,10 @@ static void InitSamplerFilterMode(SamplerInfo& info, I32 minFilter, I32 magFilte
 }
 
 
-static ModelResultBits LoadSamplers(tinygltf::Model* gltfModel, Model* engineModel)
+static ModelResultBits ImportSamplers(tinygltf::Model* gltfModel, ImportedModel* engineModel)
 {
   for (auto& sampler : gltfModel->samplers) {
-    SamplerInfo samplerInfo = { };
+    CookedSampler samplerInfo = { };
     samplerInfo._addrU = GetSamplerAddressMode(sampler.wrapS);
     samplerInfo._addrV = GetSamplerAddressMode(sampler.wrapT);
     samplerInfo._addrW = GetSamplerAddressMode(sampler.wrapR);
@@ -236,100 +275,100 @@ static ModelResultBits LoadSamplers(tinygltf::Model* gltfModel, Model* engineMod
     samplerInfo._maxAniso = 16.0f;
     samplerInfo._maxLod = 32.0f;
     samplerInfo._minLod = 0.0f;
-    samplerInfo._unnnormalizedCoordinates = false;
-    TextureSampler* pSampler = gRenderer().createTextureSampler(samplerInfo);
-    SamplerCache::cache(pSampler);
-    engineModel->samplers.push_back(pSampler);
+    samplerInfo._unnormalizedCoordinates = false;
+    engineModel->_samplers.push_back(samplerInfo);
   }
   return Model_None;
 }
 
 
-static ModelResultBits LoadMaterials(tinygltf::Model* gltfModel, Model* engineModel)
+static void ImportMaterialTexture(tinygltf::Model* gltfModel, tinygltf::Parameter& parameter,
+                                  const std::vector<I32>& textureIndices, CookedMaterial& desc, 
+                                  CookedMaterialTexture slot)
+{
+  // Texture indices are taken as image indices, as the engine keeps one texture per image.
+  I32 index = parameter.TextureIndex();
+  if (index < 0 || static_cast<size_t>(index) >= textureIndices.size()) return;
+  if (textureIndices[index] == kCookedNone) return;
+  desc._textures[slot] = textureIndices[index];
+  tinygltf::Texture& texture = gltfModel->textures[index];
+  if (texture.sampler != -1) desc._samplers[slot] = texture.sampler;
+}
+
+
+static ModelResultBits ImportMaterials(tinygltf::Model* gltfModel, ImportedModel* engineModel,
+                                       const std::vector<I32>& textureIndices)
 {
   U32 count = 0;
   for (tinygltf::Material& mat : gltfModel->materials) {
-    Material* engineMat = new Material();
-    engineMat->initialize(&gRenderer());
-    engineMat->setMetallicFactor(1.0f);
-    engineMat->setRoughnessFactor(1.0f);
-    if (mat.values.find("baseColorTexture") != mat.values.end()) { 
-      tinygltf::Texture& texture = gltfModel->textures[mat.values["baseColorTexture"].TextureIndex()]; 
-      engineMat->setAlbedo(engineModel->textures[mat.values["baseColorTexture"].TextureIndex()]);
-      if (texture.sampler != -1) engineMat->setAlbedoSampler(engineModel->samplers[texture.sampler]);
-      engineMat->enableAlbedo(true);
+    ImportedMaterial engineMat;
+    CookedMaterial& desc = engineMat._desc;
+    desc = { };
+    for (U32 i = 0; i < COOKED_MATERIAL_TEXTURE_COUNT; ++i) {
+      desc._textures[i] = kCookedNone;
+      desc._samplers[i] = kCookedNone;
+    }
+    desc._metallic = 1.0f;
+    desc._roughness = 1.0f;
+    if (mat.values.find("baseColorTexture") != mat.values.end()) {
+      ImportMaterialTexture(gltfModel, mat.values["baseColorTexture"], textureIndices, desc, COOKED_MATERIAL_ALBEDO);
     }
 
     if (mat.additionalValues.find("normalTexture") != mat.additionalValues.end()) {
-      engineMat->setNormal(engineModel->textures[mat.additionalValues["normalTexture"].TextureIndex()]);
-      tinygltf::Texture& texture = gltfModel->textures[mat.additionalValues["normalTexture"].TextureIndex()];
-      if (texture.sampler != -1) engineMat->setNormalSampler(engineModel->samplers[texture.sampler]);
-      engineMat->enableNormal(true);
+      ImportMaterialTexture(gltfModel, mat.additionalValues["normalTexture"], textureIndices, desc, COOKED_MATERIAL_NORMAL);
     }
 
-    if (mat.values.find("metallicRoughnessTexture") != mat.values.end()) {   
-      engineMat->setRoughnessMetallic(engineModel->textures[mat.values["metallicRoughnessTexture"].TextureIndex()]);
-      tinygltf::Texture& texture = gltfModel->textures[mat.values["metallicRoughnessTexture"].TextureIndex()]; 
-      if (texture.sampler != -1) engineMat->setRoughMetalSampler(engineModel->samplers[texture.sampler]);
-      engineMat->enableRoughness(true);
-      engineMat->enableMetallic(true);
+    if (mat.values.find("metallicRoughnessTexture") != mat.values.end()) {
+      ImportMaterialTexture(gltfModel, mat.values["metallicRoughnessTexture"], textureIndices, desc, COOKED_MATERIAL_ROUGH_METAL);
     }
 
     if (mat.additionalValues.find("occlusionTexture") != mat.additionalValues.end()) {
-      engineMat->setAo(engineModel->textures[mat.additionalValues["occlusionTexture"].TextureIndex()]);
-      tinygltf::Texture& texture = gltfModel->textures[mat.additionalValues["occlusionTexture"].TextureIndex()];
-      if (texture.sampler != -1) engineMat->setAoSampler(engineModel->samplers[texture.sampler]);
-      engineMat->enableAo(true);
+      ImportMaterialTexture(gltfModel, mat.additionalValues["occlusionTexture"], textureIndices, desc, COOKED_MATERIAL_AO);
     }
 
     if (mat.values.find("roughnessFactor") != mat.values.end()) {
-      engineMat->setRoughnessFactor(static_cast<R32>(mat.values["roughnessFactor"].Factor()));
-    } 
+      desc._roughness = static_cast<R32>(mat.values["roughnessFactor"].Factor());
+    }
 
     if (mat.values.find("metallicFactor") != mat.values.end()) {
-      engineMat->setMetallicFactor(static_cast<R32>(mat.values["metallicFactor"].Factor()));
+      desc._metallic = static_cast<R32>(mat.values["metallicFactor"].Factor());
     }
 
     if (mat.additionalValues.find("emissiveTexture") != mat.additionalValues.end()) {
-      engineMat->setEmissive(engineModel->textures[mat.additionalValues["emissiveTexture"].TextureIndex()]);
-      tinygltf::Texture& texture = gltfModel->textures[mat.additionalValues["emissiveTexture"].TextureIndex()];
-      if (texture.sampler != -1) engineMat->setEmissiveSampler(engineModel->samplers[texture.sampler]);
-      engineMat->enableEmissive(true);
+      ImportMaterialTexture(gltfModel, mat.additionalValues["emissiveTexture"], textureIndices, desc, COOKED_MATERIAL_EMISSIVE);
     }
 
     if (mat.values.find("baseColorFactor") != mat.values.end()) {
-      tinygltf::ColorValue& value = mat.values["baseColorFactor"].ColorFactor();
-      engineMat->setBaseColor(Vector4(static_cast<R32>(value[0]), 
-                                      static_cast<R32>(value[1]), 
-                                      static_cast<R32>(value[2]), 
-                                      static_cast<R32>(value[3])));
+      tinygltf::ColorValue value = mat.values["baseColorFactor"].ColorFactor();
+      for (U32 i = 0; i < 4; ++i) {
+        desc._baseColor[i] = static_cast<R32>(value[i]);
+      }
+      desc._flags |= COOKED_MATERIAL_BASE_COLOR_BIT;
     }
 
     if (mat.additionalValues.find("alphaMode") != mat.additionalValues.end()) {
       tinygltf::Parameter parameter = mat.additionalValues["alphaMode"];
       if (parameter.string_value == "BLEND") {
-        engineMat->setTransparent(true);
+        desc._flags |= COOKED_MATERIAL_TRANSPARENT_BIT;
       }
       if (parameter.string_value == "MASK") {
-        engineMat->setTransparent(true);
+        desc._flags |= COOKED_MATERIAL_TRANSPARENT_BIT;
       }
     }
 
     if (mat.additionalValues.find("alphaCutoff") != mat.additionalValues.end()) {
-      R32 factor = static_cast<R32>(mat.additionalValues["alphaCutoff"].Factor());
-      engineMat->setOpacity(factor);
+      desc._opacity = static_cast<R32>(mat.additionalValues["alphaCutoff"].Factor());
+      desc._flags |= COOKED_MATERIAL_OPACITY_BIT;
     }
 
-    std::string name = engineModel->name + "_mat_";
     // Some materials may not have a name, so will need to give them a unique name.
     if (mat.name.empty()) {
-      name += std::to_string(count++);
+      engineMat._name = std::to_string(count++);
     } else {
-      name += mat.name;
+      engineMat._name = mat.name;
     }
-  
-    MaterialCache::cache(name, engineMat);
-    engineModel->materials.push_back(engineMat);
+
+    engineModel->_materials.push_back(std::move(engineMat));
   }
 
   if ( gltfModel->materials.empty() ) {
@@ -339,552 +378,401 @@ static ModelResultBits LoadMaterials(tinygltf::Model* gltfModel, Model* engineMo
 }
 
 
-static ModelResultBits LoadAnimations(tinygltf::Model* gltfModel, Model* engineModel)
+static void ImportAnimation(const tinygltf::Model* gltfModel, size_t animationIdx, ClipCompressor::RawClip* clip)
 {
-  if (gltfModel->animations.empty()) return Model_None;
-  
-  for (size_t i = 0; i < gltfModel->animations.size(); ++i) {
-    const tinygltf::Animation& animation = gltfModel->animations[i];
-    AnimClip* clip = new AnimClip();
-    clip->_name = animation.name;
-    if (animation.name.empty()) {
-      clip->_name = "Animation_" + std::to_string(engineModel->animations.size() + 1);
+  const tinygltf::Animation& animation = gltfModel->animations[animationIdx];
+  clip->_name = animation.name;
+  if (animation.name.empty()) {
+    clip->_name = "Animation_" + std::to_string(animationIdx + 1);
+  }
+  clip->_duration = 0.0f;
+  clip->_morphTargetCount = 0;
+
+  // One track per animated node, in the order the channels first reach each node. Channels keep
+  // their own key times, as glTF samplers do.
+  std::map<I32, U32> tracks;
+  for (const tinygltf::AnimationChannel& channel : animation.channels) {
+    I32 node = channel.target_node;
+    const tinygltf::AnimationSampler& sampler = animation.samplers[channel.sampler];
+
+    const tinygltf::Accessor& inputAccessor = gltfModel->accessors[sampler.input];
+    const tinygltf::BufferView& inputBufView = gltfModel->bufferViews[inputAccessor.bufferView];
+    const R32* inputValues = reinterpret_cast<const R32*>(&gltfModel->buffers[inputBufView.buffer].data[inputAccessor.byteOffset + inputBufView.byteOffset]);
+
+    const tinygltf::Accessor& outputAccessor = gltfModel->accessors[sampler.output];
+    const tinygltf::BufferView& outputBufView = gltfModel->bufferViews[outputAccessor.bufferView];
+    const R32* outputValues = reinterpret_cast<const R32*>(&gltfModel->buffers[outputBufView.buffer].data[outputAccessor.byteOffset + outputBufView.byteOffset]);
+
+    size_t keyCount = inputAccessor.count;
+    if (keyCount == 0) continue;
+    clip->_duration = std::max(clip->_duration, inputValues[keyCount - 1]);
+
+    if (channel.target_path == SAMPLE_WEIGHTS_STRING) {
+      R_ASSERT(gltfModel->nodes[node].mesh != -1, "No target mesh.");
+      // Weights of every morph target, for each key.
+      if (!clip->_morphTimes.empty()) continue;
+      clip->_morphTargetCount = static_cast<U32>(outputAccessor.count / keyCount);
+      clip->_morphTimes.assign(inputValues, inputValues + keyCount);
+      clip->_morphWeights.assign(outputValues, outputValues + keyCount * clip->_morphTargetCount);
+      continue;
     }
 
-    I32 prevTarget = -1;
-    size_t jointIndex = -1;
-    // channels follow the same pattern as its corresponding skeleton joint hierarchy.
-    for (const tinygltf::AnimationChannel& channel : animation.channels) {
-      I32 node = channel.target_node;
-      if (node != prevTarget) { 
-        prevTarget = node;
-        ++jointIndex;
-      }
-      tinygltf::Node& tnode = gltfModel->nodes[node];
-
-      const tinygltf::AnimationSampler& sampler = animation.samplers[channel.sampler];
-      
-      const tinygltf::Accessor& inputAccessor = gltfModel->accessors[sampler.input];
-      const tinygltf::BufferView& inputBufView = gltfModel->bufferViews[inputAccessor.bufferView];
-      const R32* inputValues = reinterpret_cast<const R32*>(&gltfModel->buffers[inputBufView.buffer].data[inputAccessor.byteOffset + inputBufView.byteOffset]);
-      // Read input data.
-      // TODO():
-    
-      const tinygltf::Accessor& outputAccessor = gltfModel->accessors[sampler.output];
-      const tinygltf::BufferView& outputBufView = gltfModel->bufferViews[outputAccessor.bufferView];
-      const R32* outputValues = reinterpret_cast<const R32*>(&gltfModel->buffers[outputBufView.buffer].data[outputAccessor.byteOffset + outputBufView.byteOffset]);
-      // Read output data.
-      // TODO():
-      if (clip->_aAnimPoseSamples.size() < inputAccessor.count) {
-        std::map<R32, AnimPose> poses;
-        for (auto& pose : clip->_aAnimPoseSamples) {
-          poses[pose._time] = std::move(pose);
-        } 
-        clip->_aAnimPoseSamples.resize(inputAccessor.count); 
-        for (size_t inputId = 0; inputId < inputAccessor.count; ++inputId) {
-            R32 kt = inputValues[inputId];
-            if (poses.find(kt) == poses.end()) {
-              clip->_aAnimPoseSamples[inputId]._time = kt;
-            } else {
-              clip->_aAnimPoseSamples[inputId] = poses[kt];
-            }
-        }
-      }
+    AnimChannelType type;
+    if (channel.target_path == SAMPLE_TRANSLATION_STRING) {
+      type = ANIM_CHANNEL_TRANSLATION;
+    } else if (channel.target_path == SAMPLE_ROTATION_STRING) {
+      type = ANIM_CHANNEL_ROTATION;
+    } else if (channel.target_path == SAMPLE_SCALE_STRING) {
+      type = ANIM_CHANNEL_SCALE;
+    } else {
+      continue;
+    }
 
-      if (channel.target_path == SAMPLE_TRANSLATION_STRING) {
-        for (size_t outputId = 0; outputId < outputAccessor.count; ++outputId) {
-          AnimPose& pose = clip->_aAnimPoseSamples[outputId];
-          if (jointIndex >= pose._aLocalPoses.size()) {
-            pose._aGlobalPoses.resize(jointIndex + 1);
-            pose._aLocalPoses.resize(jointIndex + 1);
-          }
-          pose._aLocalPoses[jointIndex]._trans = Vector3(outputValues[outputId * 3 + 0],
-                                                         outputValues[outputId * 3 + 1],
-                                                         outputValues[outputId * 3 + 2]);
-          pose._aLocalPoses[jointIndex]._id = node;
-        }
-      }
-      if (channel.target_path == SAMPLE_ROTATION_STRING) {
-        for (size_t outputId = 0; outputId < outputAccessor.count; ++outputId) {
-          AnimPose& pose = clip->_aAnimPoseSamples[outputId];
-          if (jointIndex >= pose._aLocalPoses.size()) {
-            pose._aLocalPoses.resize(jointIndex + 1);
-            pose._aGlobalPoses.resize(jointIndex + 1);
-          }
-          pose._aLocalPoses[jointIndex]._rot = Quaternion(outputValues[outputId * 4 + 0],
-                                                          outputValues[outputId * 4 + 1],
-                                                          outputValues[outputId * 4 + 2],
-                                                          outputValues[outputId * 4 + 3]);
-          pose._aLocalPoses[jointIndex]._id = node;
-        }
-      }
-      if (channel.target_path == SAMPLE_SCALE_STRING) {
-        for (size_t outputId = 0; outputId < outputAccessor.count; ++outputId) {
-          AnimPose& pose = clip->_aAnimPoseSamples[outputId];
-          if (jointIndex >= pose._aLocalPoses.size()) {
-            pose._aLocalPoses.resize(jointIndex + 1);
-            pose._aGlobalPoses.resize(jointIndex + 1);
-          }
-          pose._aLocalPoses[jointIndex]._scale = Vector3(outputValues[outputId * 3 + 0],
-                                                         outputValues[outputId * 3 + 1],
-                                                         outputValues[outputId * 3 + 2]);
-          pose._aLocalPoses[jointIndex]._id = node;
-        }
-      }
-      if (channel.target_path == SAMPLE_WEIGHTS_STRING) {
-        tinygltf::Mesh& tmesh = gltfModel->meshes[tnode.mesh];
-        R_ASSERT(tnode.mesh != -1, "No target mesh.");
-        size_t offset = tmesh.weights.size();
-        size_t v = 0;
-        for (size_t outputId = offset; outputId < outputAccessor.count; outputId += offset) {
-          AnimPose& pose = clip->_aAnimPoseSamples[v];
-
-          if (jointIndex >= pose._aLocalPoses.size()) {
-            pose._aLocalPoses.resize(jointIndex + 1);
-            pose._aGlobalPoses.resize(jointIndex + 1);
-          }
-          
-          if (pose._morphs.size() < offset) {
-            pose._morphs.resize(offset);
-          }
-        
-          for (size_t n = 0; n < offset; ++n) {
-            R32 weight = outputValues[outputId + n];
-            // TODO(): Figure out how many morph targets in the animated mesh, in order to 
-            // determine how to read this!
-            pose._morphs[n] = weight;
-          }
-          ++v;
-        }
+    auto it = tracks.find(node);
+    if (it == tracks.end()) {
+      ClipCompressor::RawTrack track;
+      track._nodeId = static_cast<U32>(node);
+      track._parent = ClipCompressor::kNoParentTrack;
+      it = tracks.insert(std::make_pair(node, static_cast<U32>(clip->_tracks.size()))).first;
+      clip->_tracks.push_back(std::move(track));
+    }
+
+    ClipCompressor::RawTrack& track = clip->_tracks[it->second];
+    if (!track._times[type].empty()) continue;
+    track._times[type].assign(inputValues, inputValues + keyCount);
+
+    for (size_t k = 0; k < keyCount; ++k) {
+      switch (type) {
+        case ANIM_CHANNEL_TRANSLATION:
+          track._translations.push_back(Vector3(outputValues[k * 3 + 0], outputValues[k * 3 + 1], outputValues[k * 3 + 2]));
+          break;
+        case ANIM_CHANNEL_ROTATION:
+          track._rotations.push_back(Quaternion(&outputValues[k * 4]));
+          break;
+        case ANIM_CHANNEL_SCALE:
+          track._scales.push_back(Vector3(outputValues[k * 3 + 0], outputValues[k * 3 + 1], outputValues[k * 3 + 2]));
+          break;
+        default: break;
       }
     }
+  }
 
-    clip->_fDuration = clip->_aAnimPoseSamples[clip->_aAnimPoseSamples.size() - 1]._time;
-    clip->_bLooping = true;
-    clip->_fFps = 60.0f;
-    // TODO(): Need to figure out how to target the skeleton for this clip.
-    engineModel->animations.push_back(clip);
-    AnimAssetManager::cache(clip->_name, clip);
+  // Error is measured down the hierarchy, through the nearest animated ancestor of each node.
+  std::unordered_map<I32, I32> parents;
+  for (size_t i = 0; i < gltfModel->nodes.size(); ++i) {
+    for (I32 child : gltfModel->nodes[i].children) {
+      parents[child] = static_cast<I32>(i);
+    }
+  }
+  for (auto& it : tracks) {
+    auto parent = parents.find(it.first);
+    for (size_t depth = 0; parent != parents.end() && depth < gltfModel->nodes.size(); ++depth) {
+      auto track = tracks.find(parent->second);
+      if (track != tracks.end()) {
+        clip->_tracks[it.second]._parent = track->second;
+        break;
+      }
+      parent = parents.find(parent->second);
+    }
   }
 
-  return Model_Animated;
+  clip->_looping = true;
+  clip->_fps = 60.0f;
 }
 
 
-static void FlipStaticTrianglesInArray(std::vector<StaticVertex>& vertices)
+static ModelResultBits ImportAnimations(const tinygltf::Model* gltfModel, ImportedModel* engineModel,
+                                        ImportOptionBits options, ThreadPool* pPool)
 {
-  for (size_t i = 0, count = vertices.size(); i < count - 2; i += 3)
-    std::swap(vertices[i], vertices[i + 2]);
+  if (gltfModel->animations.empty()) return Model_None;
+
+  ClipCompressor::Settings settings = ClipCompressor::kDefaultSettings;
+  settings._reduceKeys = (options & Import_ReduceAnimationKeys) != 0;
+
+  // Clips only read the parsed model, so each one is its own job, compression and all.
+  engineModel->_animations.resize(gltfModel->animations.size());
+  std::vector<ClipCompressor::Stats> stats(gltfModel->animations.size());
+  JobCounter counter;
+  pPool->ParallelFor(static_cast<U32>(gltfModel->animations.size()), 1, [&] (U32 start, U32 end) -> void {
+    for (U32 i = start; i < end; ++i) {
+      ClipCompressor::RawClip raw;
+      ImportAnimation(gltfModel, i, &raw);
+      stats[i] = ClipCompressor::compress(raw, &engineModel->_animations[i], settings);
+    }
+  }, &counter);
+  pPool->WaitForCounter(&counter);
+
+  for (size_t i = 0; i < stats.size(); ++i) {
+    R_DEBUG(rNotify, engineModel->_name + " clip " + engineModel->_animations[i]._name
+      + ": keys " + std::to_string(stats[i]._rawKeys) + " -> " + std::to_string(stats[i]._keptKeys)
+      + ", bytes " + std::to_string(stats[i]._rawBytes) + " -> " + std::to_string(stats[i]._compressedBytes)
+      + " (" + std::to_string(stats[i]._ratio) + "x), max error " + std::to_string(stats[i]._maxBoneError)
+      + " bone, " + std::to_string(stats[i]._maxObjectError) + " object.\n");
+  }
+  return Model_Animated;
 }
 
 
-static Mesh* LoadMesh(const tinygltf::Node& node,
-                      U32 nodeIdx, 
-                      const tinygltf::Model& model, 
-                      Model* engineModel, 
-                      Matrix4& localMatrix)
+static void ImportSkinning(StaticVertex& vertex, size_t value, const R32* bufferWeights,
+                           const U8* bufferJoints, I32 jointType)
 {
-  Mesh* pMesh = nullptr;
-  if (node.mesh > -1) {
-    const tinygltf::Mesh& mesh = model.meshes[node.mesh];
-    engineModel->nodeHierarchy[nodeIdx]._meshId = node.mesh;
-    std::vector<Primitive> primitives;
-    // Mesh Should hold the fully buffer data. Primitives specify start and index count, that
-    // defines some submesh in the full mesh object.
-    pMesh = new Mesh();
-    
-    std::vector<std::vector<MorphVertex> > morphVertices;
-    std::vector<StaticVertex> vertices;
-    std::vector<U32>          indices;
-    Vector3                   min, max;
-    CmdConfigBits             globalConfig = 0;
-
-    if (!mesh.weights.empty()) {
-      globalConfig |= CMD_MORPH_BIT;
-      morphVertices.resize(mesh.weights.size());
-    }
+}
 
-    for (size_t i = 0; i < mesh.primitives.size(); ++i) {
-      const tinygltf::Primitive& primitive = mesh.primitives[i];
-      Primitive primData;
-      U32   vertexStart = static_cast<U32>(vertices.size());
-      U32   indexStart = static_cast<U32>(indices.size());
-      U32   indexCount = 0;
-      if (primitive.indices < 0) continue;
-      R_ASSERT(primitive.attributes.find("POSITION") != primitive.attributes.end(), "No position values within mesh!");
 
+static void ImportSkinning(SkinnedVertex& vertex, size_t value, const R32* bufferWeights,
+                           const U8* bufferJoints, I32 jointType)
+{
+  null_bones(vertex);
+  if (bufferWeights && bufferJoints) {
+    vertex.boneWeights = Vector4(&bufferWeights[value * 4]);
+    switch (jointType) {
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
       {
-        const R32* bufferPositions = nullptr;
-        const R32* bufferNormals = nullptr;
-        const R32* bufferTexCoords = nullptr;
-
-        const tinygltf::Accessor& positionAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
-        const tinygltf::BufferView& bufViewPos = model.bufferViews[positionAccessor.bufferView];
-        bufferPositions =
-          reinterpret_cast<const R32*>(&model.buffers[bufViewPos.buffer].data[positionAccessor.byteOffset + bufViewPos.byteOffset]);
-
-        if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-          const tinygltf::Accessor& normalAccessor = model.accessors[primitive.attributes.find("NORMAL")->second];
-          const tinygltf::BufferView& bufViewNorm = model.bufferViews[normalAccessor.bufferView];
-          bufferNormals =
-            reinterpret_cast<const R32*>(&model.buffers[bufViewNorm.buffer].data[normalAccessor.byteOffset + bufViewNorm.byteOffset]);
-          
-        }
-
-        if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-          const tinygltf::Accessor& texcoordAccessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
-          const tinygltf::BufferView& bufViewTexCoord0 = model.bufferViews[texcoordAccessor.bufferView];
-          bufferTexCoords =
-            reinterpret_cast<const R32*>(&model.buffers[bufViewTexCoord0.buffer].data[texcoordAccessor.byteOffset + bufViewTexCoord0.byteOffset]);
-        }
-
-        for (size_t value = 0; value < positionAccessor.count; ++value) {
-          StaticVertex vertex;
-          Vector3 p(&bufferPositions[value * 3]);
-          vertex.position = Vector4(p, 1.0f) * localMatrix;
-          vertex.position.w = 1.0f;
-          vertex.normal = Vector4((Vector3(&bufferNormals[value * 3]) * Matrix3(localMatrix)).normalize(), 0.0f);
-          vertex.texcoord0 = bufferTexCoords ? Vector2(&bufferTexCoords[value * 2]) : Vector2(0.0f, 0.0f);
-          vertex.texcoord0.y = vertex.texcoord0.y > 1.0f ? vertex.texcoord0.y - 1.0f : vertex.texcoord0.y;
-          vertex.texcoord1 = Vector2();
-          //vertex.position.y *= -1.0f;
-          //vertex.normal.y *= -1.0f;
-          vertices.push_back(vertex);
-          min = Vector3::minimum(min, p);
-          max = Vector3::maximum(max, p);
-          primData._aabb.min = Vector3::minimum(primData._aabb.min, p);
-          primData._aabb.max = Vector3::maximum(primData._aabb.max, p);
-        }
-      }
-
-      // Indices.
+        vertex.boneIds[0] = (I32)((U16*)bufferJoints)[value * 4 + 0];
+        vertex.boneIds[1] = (I32)((U16*)bufferJoints)[value * 4 + 1];
+        vertex.boneIds[2] = (I32)((U16*)bufferJoints)[value * 4 + 2];
+        vertex.boneIds[3] = (I32)((U16*)bufferJoints)[value * 4 + 3];
+      } break;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      default:
       {
-        const tinygltf::Accessor& indAccessor = model.accessors[primitive.indices];
-        const tinygltf::BufferView& iBufView = model.bufferViews[indAccessor.bufferView];
-        const tinygltf::Buffer& iBuf = model.buffers[iBufView.buffer];
-        indexCount = static_cast<U32>(indAccessor.count);
-
-        // TODO(): In progress. 
-        switch (indAccessor.componentType) {
-        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
-        {
-          const U32* buf = (const U32*)&iBuf.data[indAccessor.byteOffset + iBufView.byteOffset];
-          for (size_t index = 0; index < indAccessor.count; ++index) {
-            indices.push_back(buf[index] + vertexStart);
-          }
-        } break;
-        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
-        {
-          const U16* buf = (const U16*)&iBuf.data[indAccessor.byteOffset + iBufView.byteOffset];
-          for (size_t index = 0; index < indAccessor.count; ++index) {
-            indices.push_back(((U32)buf[index]) + vertexStart);
-          }
-        } break;
-        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
-        {
-          const U8* buf = (const U8*)&iBuf.data[indAccessor.byteOffset + iBufView.byteOffset];
-          for (size_t index = 0; index < indAccessor.count; ++index) {
-            indices.push_back(((U32)buf[index]) + vertexStart);
-          }
-        } break;
-        };
-      }
+        vertex.boneIds[0] = (I32)bufferJoints[value * 4 + 0];
+        vertex.boneIds[1] = (I32)bufferJoints[value * 4 + 1];
+        vertex.boneIds[2] = (I32)bufferJoints[value * 4 + 2];
+        vertex.boneIds[3] = (I32)bufferJoints[value * 4 + 3];
+      }break;
+    }
+  }
+}
 
-      // Check for each for morph target. For each target, we push to their corresponding maps.
-      if (!primitive.targets.empty()) {
-        for (size_t mi = 0; mi < primitive.targets.size(); ++mi) {
-          std::map<std::string, int>& target = 
-            const_cast<std::map<std::string, int>&>(primitive.targets[mi]);
-          const R32*  morphPositions = nullptr;
-          const R32* morphNormals = nullptr;
-          const R32* morphTexCoords = nullptr;            
-  
-          const tinygltf::Accessor& morphPositionAccessor = model.accessors[target["POSITION"]];
-          const tinygltf::BufferView& morphPositionView = model.bufferViews[morphPositionAccessor.bufferView];
-          morphPositions = reinterpret_cast<const R32*>(&model.buffers[morphPositionView.buffer].data[morphPositionView.byteOffset + morphPositionAccessor.byteOffset]);
-         
-          if (target.find("NORMAL") != target.end()) {
-            const tinygltf::Accessor& morphNormalAccessor = model.accessors[target["NORMAL"]];
-            const tinygltf::BufferView& morphNormalView = model.bufferViews[morphNormalAccessor.bufferView];
-            morphNormals = reinterpret_cast<const R32*>(&model.buffers[morphNormalView.buffer].data[morphNormalAccessor.byteOffset + morphNormalView.byteOffset]);
-          }
-        
-          if (target.find("TEXCOORD_0") != target.end()) {
-            const tinygltf::Accessor& morphTexCoordAccessor = model.accessors[target["TEXCOORD_0"]];
-            const tinygltf::BufferView& morphTexCoordView = model.bufferViews[morphTexCoordAccessor.bufferView];
-            morphTexCoords = reinterpret_cast<const R32*>(&model.buffers[morphTexCoordView.buffer].data[morphTexCoordAccessor.byteOffset + morphTexCoordView.byteOffset]);
-          }
 
-          for (size_t i = 0; i < morphPositionAccessor.count; ++i) {
-            MorphVertex vertex;
-            Vector3 p(&morphPositions[i * 3]);
-            vertex.position = Vector4(p, 1.0f) * localMatrix;
-            vertex.normal = Vector4(Vector3(&morphNormals[i * 3]) * Matrix3(localMatrix), 0.0f);
-            vertex.texcoord0 = morphTexCoords ? Vector2(&morphTexCoords[i * 2]) : Vector2(0.0f, 0.0f);
-            vertex.texcoord0.y = vertex.texcoord0.y > 1.0f ? vertex.texcoord0.y - 1.0f : vertex.texcoord0.y;
-            morphVertices[mi].push_back(vertex);
-          }
-        }
-      }
+template<typename Vertex>
+static void ImportPrimitives(const tinygltf::Mesh& mesh,
+                             const tinygltf::Model& model,
+                             const ImportedModel* engineModel,
+                             const Matrix4& localMatrix,
+                             CmdConfigBits globalConfig,
+                             ImportedMesh& engineMesh,
+                             std::vector<Vertex>& vertices)
+{
+  std::vector<U32>& indices = engineMesh._indices;
+  Vector3& min = engineMesh._min;
+  Vector3& max = engineMesh._max;
 
-      GeneratePrimitive(primData, engineModel->materials[primitive.material], indexStart, indexCount);
+  if (!mesh.weights.empty()) {
+    engineMesh._morphTargets.resize(mesh.weights.size());
+  }
 
-      primData._aabb.computeCentroid();;
+  for (size_t i = 0; i < mesh.primitives.size(); ++i) {
+    const tinygltf::Primitive& primitive = mesh.primitives[i];
+    CookedPrimitive primData;
+    Vector3 primMin, primMax;
+    U32   vertexStart = static_cast<U32>(vertices.size());
+    U32   indexStart = static_cast<U32>(indices.size());
+    U32   indexCount = 0;
+    if (primitive.indices < 0) continue;
+    R_ASSERT(primitive.attributes.find("POSITION") != primitive.attributes.end(), "No position values within mesh!");
 
-      primData._localConfigs |= globalConfig;
-      if (engineModel->materials[primitive.material]->getNative()->isTransparent()) {
-        primData._localConfigs |= CMD_TRANSPARENT_BIT;  
+    {
+      const R32* bufferPositions = nullptr;
+      const R32* bufferNormals = nullptr;
+      const R32* bufferTexCoords = nullptr;
+      const R32* bufferWeights = nullptr;
+      const U8* bufferJoints = nullptr;
+      I32 jointType = -1;
+
+      const tinygltf::Accessor& positionAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
+      const tinygltf::BufferView& bufViewPos = model.bufferViews[positionAccessor.bufferView];
+      bufferPositions =
+        reinterpret_cast<const R32*>(&model.buffers[bufViewPos.buffer].data[positionAccessor.byteOffset + bufViewPos.byteOffset]);
+
+      if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
+        const tinygltf::Accessor& normalAccessor = model.accessors[primitive.attributes.find("NORMAL")->second];
+        const tinygltf::BufferView& bufViewNorm = model.bufferViews[normalAccessor.bufferView];
+        bufferNormals =
+          reinterpret_cast<const R32*>(&model.buffers[bufViewNorm.buffer].data[normalAccessor.byteOffset + bufViewNorm.byteOffset]);
       }
-      primitives.push_back(primData);
-    }
-
-    pMesh->initialize(&gRenderer(), vertices.size(), vertices.data(), Mesh::STATIC, indices.size(), indices.data());
-    pMesh->setMin(min);
-    pMesh->setMax(max);
-    pMesh->updateAABB();
-    std::string name = engineModel->name + "_mesh_" + mesh.name;
-    MeshCache::cache(name, pMesh);
-    engineModel->meshes.push_back(pMesh);
-    for (auto& prim : primitives) {
-      pMesh->pushPrimitive(prim);
-    }
-    pMesh->sortPrimitives(Mesh::TRANSPARENCY_LAST);
 
+      if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
+        const tinygltf::Accessor& texcoordAccessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
+        const tinygltf::BufferView& bufViewTexCoord0 = model.bufferViews[texcoordAccessor.bufferView];
+        bufferTexCoords =
+          reinterpret_cast<const R32*>(&model.buffers[bufViewTexCoord0.buffer].data[texcoordAccessor.byteOffset + bufViewTexCoord0.byteOffset]);
+      }
 
-    if (!morphVertices.empty()) {
-      pMesh->allocateMorphTargetBuffer(morphVertices.size());
-      for ( size_t i = 0; i < morphVertices.size(); ++i ) {
-        auto& verts = morphVertices[i];
-        pMesh->initializeMorphTarget(&gRenderer(), i, verts.size(), verts.data(), sizeof(MorphVertex)); 
-      } 
-    }
-  }
-  return pMesh;
-}
+      if (primitive.attributes.find("JOINTS_0") != primitive.attributes.end()) {
+        const tinygltf::Accessor& jointAccessor = model.accessors[primitive.attributes.find("JOINTS_0")->second];
+        const tinygltf::BufferView& bufferViewJoints = model.bufferViews[jointAccessor.bufferView];
+        bufferJoints =
+          reinterpret_cast<const U8*>(&model.buffers[bufferViewJoints.buffer].data[jointAccessor.byteOffset + bufferViewJoints.byteOffset]);
+        jointType = jointAccessor.componentType;
+      }
 
+      if (primitive.attributes.find("WEIGHTS_0") != primitive.attributes.end()) {
+        const tinygltf::Accessor& weightAccessor = model.accessors[primitive.attributes.find("WEIGHTS_0")->second];
+        const tinygltf::BufferView& bufferViewWeight = model.bufferViews[weightAccessor.bufferView];
+        bufferWeights =
+          reinterpret_cast<const R32*>(&model.buffers[bufferViewWeight.buffer].data[weightAccessor.byteOffset + bufferViewWeight.byteOffset]);
+      }
 
-static Mesh* LoadSkinnedMesh(const tinygltf::Node& node, const tinygltf::Model& model, Model* engineModel, Matrix4& localMatrix)
-{
-  Mesh* pMesh = nullptr;
-  if (node.mesh > -1) {
-    const tinygltf::Mesh& mesh = model.meshes[node.mesh];
-    std::vector<Primitive> primitives;
-    // Mesh Should hold the fully buffer data. Primitives specify start and index count, that
-    // defines some submesh in the full mesh object.
-    pMesh = new Mesh();
-
-    std::vector<std::vector<MorphVertex> > morphVertices;
-    std::vector<SkinnedVertex> vertices; 
-    std::vector<U32>          indices;
-    Vector3                   min, max;
-    CmdConfigBits             globalConfig = CMD_SKINNED_BIT;
-
-    if (!mesh.weights.empty()) {
-      globalConfig |= CMD_MORPH_BIT;
-      morphVertices.resize(mesh.weights.size());
+      for (size_t value = 0; value < positionAccessor.count; ++value) {
+        Vertex vertex;
+        Vector3 p(&bufferPositions[value * 3]);
+        vertex.position = Vector4(p, 1.0f) * localMatrix;
+        vertex.position.w = 1.0f;
+        if (bufferNormals) {
+          vertex.normal = Vector4((Vector3(&bufferNormals[value * 3]) * Matrix3(localMatrix)).normalize(), 0.0f);
+        }
+        vertex.texcoord0 = bufferTexCoords ? Vector2(&bufferTexCoords[value * 2]) : Vector2(0.0f, 0.0f);
+        vertex.texcoord0.y = vertex.texcoord0.y > 1.0f ? vertex.texcoord0.y - 1.0f : vertex.texcoord0.y;
+        vertex.texcoord1 = Vector2();
+        ImportSkinning(vertex, value, bufferWeights, bufferJoints, jointType);
+        //vertex.position.y *= -1.0f;
+        //vertex.normal.y *= -1.0f;
+        vertices.push_back(vertex);
+        min = Vector3::minimum(min, p);
+        max = Vector3::maximum(max, p);
+        primMin = Vector3::minimum(primMin, p);
+        primMax = Vector3::maximum(primMax, p);
+      }
     }
 
-    for (size_t i = 0; i < mesh.primitives.size(); ++i) {
-      const tinygltf::Primitive& primitive = mesh.primitives[i];
-      U32   vertexStart = static_cast<U32>(vertices.size());
-      U32   indexStart = static_cast<U32>(indices.size());
-      U32   indexCount = 0;
-      Primitive primData;
-      if (primitive.indices < 0) continue;
-      R_ASSERT(primitive.attributes.find("POSITION") != primitive.attributes.end(), "No position values within mesh!");
-      
+    // Indices.
+    {
+      const tinygltf::Accessor& indAccessor = model.accessors[primitive.indices];
+      const tinygltf::BufferView& iBufView = model.bufferViews[indAccessor.bufferView];
+      const tinygltf::Buffer& iBuf = model.buffers[iBufView.buffer];
+      indexCount = static_cast<U32>(indAccessor.count);
+
+      // TODO(): In progress.
+      switch (indAccessor.componentType) {
+      case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
       {
-        const R32* bufferPositions = nullptr;
-        const R32* bufferNormals = nullptr;
-        const R32* bufferTexCoords = nullptr;
-        const R32* bufferWeights = nullptr; 
-        const U8* bufferJoints = nullptr;
-        I32 jointType = -1;
-
-        const tinygltf::Accessor& positionAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
-        const tinygltf::BufferView& bufViewPos = model.bufferViews[positionAccessor.bufferView];
-        bufferPositions =
-          reinterpret_cast<const R32*>(&model.buffers[bufViewPos.buffer].data[positionAccessor.byteOffset + bufViewPos.byteOffset]);
-        const std::vector<double>& dmin = positionAccessor.minValues;
-        const std::vector<double>& dmax = positionAccessor.maxValues;
-
-        if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-          const tinygltf::Accessor& normalAccessor = model.accessors[primitive.attributes.find("NORMAL")->second];
-          const tinygltf::BufferView& bufViewNorm = model.bufferViews[normalAccessor.bufferView];
-          bufferNormals =
-            reinterpret_cast<const R32*>(&model.buffers[bufViewNorm.buffer].data[normalAccessor.byteOffset + bufViewNorm.byteOffset]);
+        const U32* buf = (const U32*)&iBuf.data[indAccessor.byteOffset + iBufView.byteOffset];
+        for (size_t index = 0; index < indAccessor.count; ++index) {
+          indices.push_back(buf[index] + vertexStart);
         }
-
-        if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-          const tinygltf::Accessor& texcoordAccessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
-          const tinygltf::BufferView& bufViewTexCoord0 = model.bufferViews[texcoordAccessor.bufferView];
-          bufferTexCoords =
-            reinterpret_cast<const R32*>(&model.buffers[bufViewTexCoord0.buffer].data[texcoordAccessor.byteOffset + bufViewTexCoord0.byteOffset]);
+      } break;
+      case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+      {
+        const U16* buf = (const U16*)&iBuf.data[indAccessor.byteOffset + iBufView.byteOffset];
+        for (size_t index = 0; index < indAccessor.count; ++index) {
+          indices.push_back(((U32)buf[index]) + vertexStart);
         }
-
-        if (primitive.attributes.find("JOINTS_0") != primitive.attributes.end()) {
-          const tinygltf::Accessor& jointAccessor = model.accessors[primitive.attributes.find("JOINTS_0")->second];
-          const tinygltf::BufferView& bufferViewJoints = model.bufferViews[jointAccessor.bufferView];
-          bufferJoints = 
-            reinterpret_cast<const U8*>(&model.buffers[bufferViewJoints.buffer].data[jointAccessor.byteOffset + bufferViewJoints.byteOffset]);
-          jointType = jointAccessor.componentType;
+      } break;
+      case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
+      {
+        const U8* buf = (const U8*)&iBuf.data[indAccessor.byteOffset + iBufView.byteOffset];
+        for (size_t index = 0; index < indAccessor.count; ++index) {
+          indices.push_back(((U32)buf[index]) + vertexStart);
         }
+      } break;
+      };
+    }
 
-        if (primitive.attributes.find("WEIGHTS_0") != primitive.attributes.end()) {
-          const tinygltf::Accessor& weightAccessor = model.accessors[primitive.attributes.find("WEIGHTS_0")->second];
-          const tinygltf::BufferView& bufferViewWeight = model.bufferViews[weightAccessor.bufferView];
-          bufferWeights =
-            reinterpret_cast<const R32*>(&model.buffers[bufferViewWeight.buffer].data[weightAccessor.byteOffset + bufferViewWeight.byteOffset]);
+    // Check for each for morph target. For each target, we push to their corresponding maps.
+    if (!primitive.targets.empty()) {
+      for (size_t mi = 0; mi < primitive.targets.size(); ++mi) {
+        std::map<std::string, int>& target =
+          const_cast<std::map<std::string, int>&>(primitive.targets[mi]);
+        const R32*  morphPositions = nullptr;
+        const R32* morphNormals = nullptr;
+        const R32* morphTexCoords = nullptr;
+
+        const tinygltf::Accessor& morphPositionAccessor = model.accessors[target["POSITION"]];
+        const tinygltf::BufferView& morphPositionView = model.bufferViews[morphPositionAccessor.bufferView];
+        morphPositions = reinterpret_cast<const R32*>(&model.buffers[morphPositionView.buffer].data[morphPositionView.byteOffset + morphPositionAccessor.byteOffset]);
+
+        if (target.find("NORMAL") != target.end()) {
+          const tinygltf::Accessor& morphNormalAccessor = model.accessors[target["NORMAL"]];
+          const tinygltf::BufferView& morphNormalView = model.bufferViews[morphNormalAccessor.bufferView];
+          morphNormals = reinterpret_cast<const R32*>(&model.buffers[morphNormalView.buffer].data[morphNormalAccessor.byteOffset + morphNormalView.byteOffset]);
         }
 
-        for (size_t value = 0; value < positionAccessor.count; ++value) {
-          SkinnedVertex vertex;
-          null_bones(vertex);
-          Vector3 p(&bufferPositions[value * 3]);
-          vertex.position = Vector4(p, 1.0f) * localMatrix;
-          vertex.position.w = 1.0f;
-          vertex.normal = Vector4((Vector3(&bufferNormals[value * 3]) * Matrix3(localMatrix)).normalize(), 0.0f);
-          vertex.texcoord0 = bufferTexCoords ? Vector2(&bufferTexCoords[value * 2]) : Vector2(0.0f, 0.0f);
-          vertex.texcoord0.y = vertex.texcoord0.y > 1.0f ? vertex.texcoord0.y - 1.0f : vertex.texcoord0.y;
-          vertex.texcoord1 = Vector2();
-          if (bufferWeights && bufferJoints) {
-            vertex.boneWeights = Vector4(&bufferWeights[value * 4]);
-            switch (jointType) {
-              case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-              {
-                vertex.boneIds[0] = (I32)((U16*)bufferJoints)[value * 4 + 0];
-                vertex.boneIds[1] = (I32)((U16*)bufferJoints)[value * 4 + 1];
-                vertex.boneIds[2] = (I32)((U16*)bufferJoints)[value * 4 + 2];
-                vertex.boneIds[3] = (I32)((U16*)bufferJoints)[value * 4 + 3];
-              } break;
-              case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-              default: 
-              {
-                vertex.boneIds[0] = (I32)bufferJoints[value * 4 + 0];
-                vertex.boneIds[1] = (I32)bufferJoints[value * 4 + 1];
-                vertex.boneIds[2] = (I32)bufferJoints[value * 4 + 2];
-                vertex.boneIds[3] = (I32)bufferJoints[value * 4 + 3];
-              }break;
-            }
-          }
-          //vertex.position.y *= -1.0f;
-          //vertex.normal.y *= -1.0f;
-          vertices.push_back(vertex);
-          min = Vector3::minimum(min, p);
-          max = Vector3::maximum(max, p);
-          primData._aabb.min = Vector3::minimum(primData._aabb.min, p);
-          primData._aabb.max = Vector3::maximum(primData._aabb.max, p);
+        if (target.find("TEXCOORD_0") != target.end()) {
+          const tinygltf::Accessor& morphTexCoordAccessor = model.accessors[target["TEXCOORD_0"]];
+          const tinygltf::BufferView& morphTexCoordView = model.bufferViews[morphTexCoordAccessor.bufferView];
+          morphTexCoords = reinterpret_cast<const R32*>(&model.buffers[morphTexCoordView.buffer].data[morphTexCoordAccessor.byteOffset + morphTexCoordView.byteOffset]);
         }
-      }
 
-      // Indices.
-      {
-        const tinygltf::Accessor& indAccessor = model.accessors[primitive.indices];
-        const tinygltf::BufferView& iBufView = model.bufferViews[indAccessor.bufferView];
-        const tinygltf::Buffer& iBuf = model.buffers[iBufView.buffer];
-        indexCount = static_cast<U32>(indAccessor.count);
-
-        // TODO(): In progress. 
-        switch (indAccessor.componentType) {
-        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
-        {
-          const U32* buf = (const U32*)&iBuf.data[indAccessor.byteOffset + iBufView.byteOffset];
-          for (size_t index = 0; index < indAccessor.count; ++index) {
-            indices.push_back(buf[index] + vertexStart);
-          }
-        } break;
-        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
-        {
-          const U16* buf = (const U16*)&iBuf.data[indAccessor.byteOffset + iBufView.byteOffset];
-          for (size_t index = 0; index < indAccessor.count; ++index) {
-            indices.push_back(((U32)buf[index]) + vertexStart);
-          }
-        } break;
-        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
-        {
-          const U8* buf = (const U8*)&iBuf.data[indAccessor.byteOffset + iBufView.byteOffset];
-          for (size_t index = 0; index < indAccessor.count; ++index) {
-            indices.push_back(((U32)buf[index]) + vertexStart);
-          }
-        } break;
-        };
-      }
-
-      // Check for each for morph target. For each target, we push to their corresponding maps.
-      if (!primitive.targets.empty()) {
-        for (size_t mi = 0; mi < primitive.targets.size(); ++mi) {
-          std::map<std::string, int>& target =
-            const_cast<std::map<std::string, int>&>(primitive.targets[mi]);
-          const R32*  morphPositions = nullptr;
-          const R32* morphNormals = nullptr;
-          const R32* morphTexCoords = nullptr;
-
-          const tinygltf::Accessor& morphPositionAccessor = model.accessors[target["POSITION"]];
-          const tinygltf::BufferView& morphPositionView = model.bufferViews[morphPositionAccessor.bufferView];
-          morphPositions = reinterpret_cast<const R32*>(&model.buffers[morphPositionView.buffer].data[morphPositionView.byteOffset + morphPositionAccessor.byteOffset]);
-
-          if (target.find("NORMAL") != target.end()) {
-            const tinygltf::Accessor& morphNormalAccessor = model.accessors[target["NORMAL"]];
-            const tinygltf::BufferView& morphNormalView = model.bufferViews[morphNormalAccessor.bufferView];
-            morphNormals = reinterpret_cast<const R32*>(&model.buffers[morphNormalView.buffer].data[morphNormalAccessor.byteOffset + morphNormalView.byteOffset]);
-          }
-
-          if (target.find("TEXCOORD_0") != target.end()) {
-            const tinygltf::Accessor& morphTexCoordAccessor = model.accessors[target["TEXCOORD_0"]];
-            const tinygltf::BufferView& morphTexCoordView = model.bufferViews[morphTexCoordAccessor.bufferView];
-            morphTexCoords = reinterpret_cast<const R32*>(&model.buffers[morphTexCoordView.buffer].data[morphTexCoordAccessor.byteOffset + morphTexCoordView.byteOffset]);
-          }
+        if (mi >= engineMesh._morphTargets.size()) {
+          engineMesh._morphTargets.resize(mi + 1);
+        }
 
-          for (size_t i = 0; i < morphPositionAccessor.count; ++i) {
-            MorphVertex vertex;
-            Vector3 p(&morphPositions[i * 3]);
-            vertex.position = Vector4(p, 1.0f) * localMatrix;
+        for (size_t i = 0; i < morphPositionAccessor.count; ++i) {
+          MorphVertex vertex;
+          Vector3 p(&morphPositions[i * 3]);
+          vertex.position = Vector4(p, 1.0f) * localMatrix;
+          if (morphNormals) {
             vertex.normal = Vector4(Vector3(&morphNormals[i * 3]) * Matrix3(localMatrix), 0.0f);
-            vertex.texcoord0 = morphTexCoords ? Vector2(&morphTexCoords[i * 2]) : Vector2(0.0f, 0.0f);
-            vertex.texcoord0.y = vertex.texcoord0.y > 1.0f ? vertex.texcoord0.y - 1.0f : vertex.texcoord0.y;
-            morphVertices[mi].push_back(vertex);
           }
+          vertex.texcoord0 = morphTexCoords ? Vector2(&morphTexCoords[i * 2]) : Vector2(0.0f, 0.0f);
+          vertex.texcoord0.y = vertex.texcoord0.y > 1.0f ? vertex.texcoord0.y - 1.0f : vertex.texcoord0.y;
+          engineMesh._morphTargets[mi].push_back(vertex);
         }
       }
+    }
 
-      GeneratePrimitive(primData, engineModel->materials[primitive.material], indexStart, indexCount);
-
-      primData._aabb.computeCentroid();
+    GeneratePrimitive(primData, primitive.material, indexStart, indexCount);
+    StoreBounds(primData, primMin, primMax);
 
-      primData._localConfigs |= globalConfig;
-      if (engineModel->materials[primitive.material]->getNative()->isTransparent()) {
-        primData._localConfigs |= CMD_TRANSPARENT_BIT;  
-      }
-      // TODO():
-      //    Still need to add start and index count.
-      primitives.push_back(primData);
+    primData._configs |= globalConfig;
+    if (primitive.material >= 0
+      && (engineModel->_materials[primitive.material]._desc._flags & COOKED_MATERIAL_TRANSPARENT_BIT)) {
+      primData._configs |= CMD_TRANSPARENT_BIT;
     }
+    engineMesh._primitives.push_back(primData);
+  }
+}
 
-    for (size_t i = 0; i < mesh.targets.size(); ++i) {
-      auto target = mesh.targets[i];
-    }
 
-    pMesh->initialize(&gRenderer(), vertices.size(), vertices.data(), Mesh::SKINNED, indices.size(), indices.data());
-    pMesh->setMin(min);
-    pMesh->setMax(max);
-    pMesh->updateAABB();
-    MeshCache::cache(mesh.name, pMesh);
-    engineModel->meshes.push_back(pMesh);
-    for (auto& primData : primitives) {
-      pMesh->pushPrimitive(primData);
-    }
-    pMesh->sortPrimitives(Mesh::TRANSPARENCY_LAST);
+// Mesh found while walking the node hierarchy, converted later on along with the others.
+struct MeshImportJob {
+  I32         _mesh;
+  I32         _skeleton;
+  B32         _skinned;
+  Matrix4     _transform;
+};
 
-    if (!morphVertices.empty()) {
-      pMesh->allocateMorphTargetBuffer(morphVertices.size());
-      for (size_t i = 0; i < morphVertices.size(); ++i) {
-        auto& verts = morphVertices[i];
-        pMesh->initializeMorphTarget(&gRenderer(), i, verts.size(), verts.data(), sizeof(MorphVertex));
-      }
-    }
+
+static void ImportMesh(const MeshImportJob& job,
+                       const tinygltf::Model& model,
+                       const ImportedModel* engineModel,
+                       ImportedMesh& engineMesh)
+{
+  const tinygltf::Mesh& mesh = model.meshes[job._mesh];
+  // Mesh Should hold the fully buffer data. Primitives specify start and index count, that
+  // defines some submesh in the full mesh object.
+  engineMesh._name = mesh.name;
+  engineMesh._skinned = job._skinned;
+  engineMesh._skeleton = job._skeleton;
+
+  CmdConfigBits globalConfig = job._skinned ? CMD_SKINNED_BIT : 0;
+  if (!mesh.weights.empty()) {
+    globalConfig |= CMD_MORPH_BIT;
+  }
+  if (job._skinned) {
+    ImportPrimitives(mesh, model, engineModel, job._transform, globalConfig, engineMesh, engineMesh._skinnedVertices);
+  } else {
+    ImportPrimitives(mesh, model, engineModel, job._transform, globalConfig, engineMesh, engineMesh._staticVertices);
   }
+}
+
 
-  return pMesh;
+static void ImportMeshes(const std::vector<MeshImportJob>& jobs,
+                         const tinygltf::Model& model,
+                         ImportedModel* engineModel,
+                         ThreadPool* pPool)
+{
+  // Meshes only read the parsed model and materials, and write into their own slot.
+  engineModel->_meshes.resize(jobs.size());
+  JobCounter counter;
+  pPool->ParallelFor(static_cast<U32>(jobs.size()), 1, [&] (U32 start, U32 end) -> void {
+    for (U32 i = start; i < end; ++i) {
+      ImportMesh(jobs[i], model, engineModel, engineModel->_meshes[i]);
+    }
+  }, &counter);
+  pPool->WaitForCounter(&counter);
 }
 
 
@@ -941,11 +829,11 @@ static NodeTransform CalculateGlobalTransform(const tinygltf::Node& node, Matrix
   return transform;
 }
 
-static skeleton_uuid_t LoadSkin(const tinygltf::Node& node, const tinygltf::Model& model, Model* engineModel, const Matrix4& parentMatrix)
+static I32 ImportSkin(const tinygltf::Node& node, const tinygltf::Model& model, ImportedModel* engineModel, const Matrix4& parentMatrix)
 {
   // TODO(): JointPoses are in the wrong order as invBinding matrices, need to sort them in the
   // order of joint array in GLTF file!!
-  if (node.skin == -1) return Skeleton::kNoSkeletonId;
+  if (node.skin == -1) return kCookedNone;
 
   Skeleton skeleton;
   tinygltf::Skin skin = model.skins[node.skin];
@@ -962,8 +850,8 @@ static skeleton_uuid_t LoadSkin(const tinygltf::Node& node, const tinygltf::Mode
   const tinygltf::Accessor& accessor = model.accessors[skin.inverseBindMatrices];
   const tinygltf::BufferView& bufView = model.bufferViews[accessor.bufferView];
   const tinygltf::Buffer& buf = model.buffers[bufView.buffer];
-  
-  const R32* bindMatrices = reinterpret_cast<const R32*>(&buf.data[bufView.byteOffset + accessor.byteOffset]);  
+
+  const R32* bindMatrices = reinterpret_cast<const R32*>(&buf.data[bufView.byteOffset + accessor.byteOffset]);
 
   for (size_t i = 0; i < accessor.count; ++i) {
     Matrix4 invBindMat(&bindMatrices[i * 16]);
@@ -980,13 +868,13 @@ static skeleton_uuid_t LoadSkin(const tinygltf::Node& node, const tinygltf::Mode
   std::map<I32, NodeTag> nodeMap;
   if (skin.skeleton != -1) {
     const tinygltf::Node& root = model.nodes[skin.skeleton];
-    NodeTransform rootTransform = CalculateGlobalTransform(root, 
+    NodeTransform rootTransform = CalculateGlobalTransform(root,
       Matrix4::scale(Matrix4(), Vector3(-1.0f, 1.0f, 1.0f)));
     skeleton._rootInvTransform = rootTransform._globalMatrix.inverse();
     NodeTag tag{ 0xff, Matrix4() };
     nodeMap[skin.skeleton] = tag;
     for (size_t i = 0; i < root.children.size(); ++i) {
-      NodeTag tag = { (rootInJoints ? static_cast<U8>(0) : static_cast<U8>(0xff)), 
+      NodeTag tag = { (rootInJoints ? static_cast<U8>(0) : static_cast<U8>(0xff)),
         rootTransform._globalMatrix };
       nodeMap[root.children[i]] = tag;
     }
@@ -1002,7 +890,7 @@ static skeleton_uuid_t LoadSkin(const tinygltf::Node& node, const tinygltf::Mode
     auto it = nodeMap.find(skinJointIdx);
     if (it != nodeMap.end()) {
       NodeTag& tag = it->second;
-      localTransform = CalculateGlobalTransform(node, tag._parentTransform);    
+      localTransform = CalculateGlobalTransform(node, tag._parentTransform);
       joint._iParent = tag._parent;
     }
 
@@ -1012,49 +900,54 @@ static skeleton_uuid_t LoadSkin(const tinygltf::Node& node, const tinygltf::Mode
       nodeMap[node.children[child]] = tag;
     }
   }
-  
-  Skeleton::pushSkeleton(skeleton);
-  
-  engineModel->skeletons.push_back(Skeleton::getSkeleton(skeleton._uuid));
-  return skeleton._uuid;
+
+  engineModel->_skeletons.push_back(skeleton);
+  return static_cast<I32>(engineModel->_skeletons.size() - 1);
 }
 
 
-static void LoadNode(const U32 nodeId, 
-                     const tinygltf::Node& node, 
-                     const tinygltf::Model& model, 
-                     Model* engineModel, 
-                     const Matrix4& parentMatrix, 
-                     const R32 scale)
+static void ImportNode(const U32 nodeId,
+                       const tinygltf::Node& node,
+                       const tinygltf::Model& model,
+                       ImportedModel* engineModel,
+                       std::vector<MeshImportJob>* pMeshJobs,
+                       const Matrix4& parentMatrix,
+                       const R32 scale)
 {
   NodeTransform transform = CalculateGlobalTransform(node, parentMatrix);
-  //engineModel->nodeHierarchy[nodeId] = {};
   if (!node.children.empty()) {
     for (size_t i = 0; i < node.children.size(); ++i) {
-      engineModel->nodeHierarchy[node.children[i]]._parentId = nodeId;
-      engineModel->nodeHierarchy[node.children[i]]._meshId = Mesh::kMeshUnknownValue;
-      LoadNode(node.children[i], 
-               model.nodes[node.children[i]], 
-               model, 
-               engineModel, 
-               transform._globalMatrix, 
-               scale);
+      engineModel->_nodeHierarchy[node.children[i]]._parentId = nodeId;
+      engineModel->_nodeHierarchy[node.children[i]]._meshId = Mesh::kMeshUnknownValue;
+      ImportNode(node.children[i],
+                 model.nodes[node.children[i]],
+                 model,
+                 engineModel,
+                 pMeshJobs,
+                 transform._globalMatrix,
+                 scale);
     }
   }
 
+  MeshImportJob job;
+  job._mesh = node.mesh;
+  job._skeleton = kCookedNone;
+  job._skinned = false;
+  job._transform = transform._globalMatrix;
+
+  // Meshes are named by their index in the imported model, the order their jobs are pushed in.
   if (node.skin != -1) {
-    engineModel->nodeHierarchy[nodeId]._nodeConfig |= Model_Skinned;
-    skeleton_uuid_t skeleId = LoadSkin(node, model, engineModel, transform._globalMatrix);
-    Mesh* pMesh = LoadSkinnedMesh(node, model, engineModel, transform._globalMatrix);
-    pMesh->setSkeletonReference(skeleId);
-  } else {
-    if (LoadMesh(node, 
-                 nodeId, 
-                 model, 
-                 engineModel, 
-                 transform._globalMatrix)) {
-      engineModel->nodeHierarchy[nodeId]._nodeConfig |= Model_Mesh;
+    engineModel->_nodeHierarchy[nodeId]._nodeConfig |= Model_Skinned;
+    engineModel->_nodeHierarchy[nodeId]._meshId = Mesh::kMeshUnknownValue;
+    job._skeleton = ImportSkin(node, model, engineModel, transform._globalMatrix);
+    job._skinned = true;
+    if (node.mesh >= 0) {
+      pMeshJobs->push_back(job);
     }
+  } else if (node.mesh >= 0) {
+    engineModel->_nodeHierarchy[nodeId]._meshId = static_cast<U32>(pMeshJobs->size());
+    engineModel->_nodeHierarchy[nodeId]._nodeConfig |= Model_Mesh;
+    pMeshJobs->push_back(job);
   }
 }
 
@@ -1078,19 +971,32 @@ void GetFilenameAndType(const std::string& path, std::string& filenameOut, U32&
 }
 
 
-ModelResultBits load(const std::string path)
+// Milliseconds between two profiler tick counts.
+static R32 ElapsedMs(U64 start, U64 end)
 {
+  return static_cast<R32>((Profiler::TicksToNanoseconds(end) - Profiler::TicksToNanoseconds(start)) * 0.000001);
+}
+
+
+ModelResultBits import(const std::string& path, ImportedModel* pModel, ThreadPool* pPool,
+                       ImportOptionBits options)
+{
+  R_TIMED_PROFILE(PROFILE_TYPES_GAME, "GLTF::import");
   ModelResultBits result = 0;
-  Model*           model = nullptr;
-  static U64 copy = 0;
+  static std::atomic<U64> copy(0);
   tinygltf::Model gltfModel;
   tinygltf::TinyGLTF loader;
-  std::string err;  
+  std::string err;
   std::string modelName = "Unknown" + std::to_string(copy++);
   U32 type = 0;
   GetFilenameAndType(path, modelName, type);
 
-  bool success = type == 1 ? loader.LoadBinaryFromFile(&gltfModel, &err, path) 
+  ImportTimings& timings = pModel->_timings;
+  U64 start = Profiler::Now();
+
+  // Images are only read here, and decoded later on in parallel.
+  loader.SetImageLoader(DeferImageDecode, nullptr);
+  bool success = type == 1 ? loader.LoadBinaryFromFile(&gltfModel, &err, path)
     : loader.LoadASCIIFromFile(&gltfModel, &err, path);
 
   if (!err.empty()) {
@@ -1102,28 +1008,68 @@ ModelResultBits load(const std::string path)
     return Model_Fail;
   }
 
-  // Successful loading from tinygltf.
-  model = new Model();
-  model->name = std::move(modelName);
+  pModel->_name = std::move(modelName);
+  U64 parsed = Profiler::Now();
+  timings._parse = ElapsedMs(start, parsed);
 
-  result |= LoadSamplers(&gltfModel, model);
-  result |= LoadTextures(&gltfModel, model);
-  result |= LoadMaterials(&gltfModel, model);
+  std::vector<I32> textureIndices;
+  result |= ImportTextures(&gltfModel, pModel, pPool, textureIndices);
+  U64 decoded = Profiler::Now();
+  timings._images = ElapsedMs(parsed, decoded);
 
+  result |= ImportSamplers(&gltfModel, pModel);
+  result |= ImportMaterials(&gltfModel, pModel, textureIndices);
+
+  // Walking the nodes is cheap, and gathers the meshes to convert.
+  std::vector<MeshImportJob> meshJobs;
   tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene];
   for (size_t i = 0; i < scene.nodes.size(); ++i) {
     tinygltf::Node& node = gltfModel.nodes[scene.nodes[i]];
     Matrix4 mat = Matrix4::scale(Matrix4::identity(), Vector3(-1.0f, 1.0f, 1.0f));
-    LoadNode(scene.nodes[i], node, gltfModel, model, mat, 1.0);
+    ImportNode(scene.nodes[i], node, gltfModel, pModel, &meshJobs, mat, 1.0);
   }
+  U64 walked = Profiler::Now();
+  timings._nodes = ElapsedMs(decoded, walked);
+
+  ImportMeshes(meshJobs, gltfModel, pModel, pPool);
+  U64 converted = Profiler::Now();
+  timings._meshes = ElapsedMs(walked, converted);
 
-  result |= LoadAnimations(&gltfModel, model);
+  OptimizeMeshes(pModel, options, pPool);
+  U64 optimized = Profiler::Now();
+  timings._optimize = ElapsedMs(converted, optimized);
 
-  ModelCache::cache(model->name, model);
-  result |= Model_Cached;
+  result |= ImportAnimations(&gltfModel, pModel, options, pPool);
+  timings._animations = ElapsedMs(optimized, Profiler::Now());
 
-  result |= Model_Success;
-  return result;
+  R_DEBUG(rNotify, "Imported " + pModel->_name + ": parse " + std::to_string(timings._parse)
+    + " ms, images " + std::to_string(timings._images)
+    + " ms, nodes " + std::to_string(timings._nodes)
+    + " ms, meshes " + std::to_string(timings._meshes)
+    + " ms, optimize " + std::to_string(timings._optimize)
+    + " ms, animations " + std::to_string(timings._animations) + " ms.\n");
+
+  pModel->_result = result;
+  return result | Model_Success;
+}
+
+
+ModelResultBits load(const std::string path)
+{
+  ImportedModel model;
+  ModelResultBits result = import(path, &model, &gCore().ThrPool());
+  if (result & Model_Fail) return result;
+
+  // Loading straight from a gltf goes through the same path as cooked files, only cooked in
+  // memory instead.
+  std::vector<U8> cooked;
+  CookModel(model, &cooked);
+
+  CookedModelView view;
+  if (!view.open(cooked.data(), cooked.size())) {
+    return Model_Fail;
+  }
+  return Cooked::create(model._name, path, view);
 }
 } // GLTF
 } // ModelLoader
@@ -0,0 +1,331 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Scene/ResourceRegistry.hpp"
+
+#include "Core/Exception.hpp"
+#include "Core/Logging/Log.hpp"
+
+
+namespace Recluse {
+
+
+AssetId hashAssetName(const std::string& name)
+{
+  // FNV-1a.
+  U64 hash = 14695981039346656037ull;
+  for (char c : name) {
+    hash ^= static_cast<U8>(c);
+    hash *= 1099511628211ull;
+  }
+  return (hash == kNoAssetId) ? 1 : hash;
+}
+
+
+ResourceRegistry& gResourceRegistry()
+{
+  static ResourceRegistry registry;
+  return registry;
+}
+
+
+ResourceRegistry::ResourceRegistry()
+{
+  for (U32 i = 0; i < RESOURCE_CATEGORY_COUNT; ++i) {
+    m_lruHead[i] = kNoSlot;
+    m_lruTail[i] = kNoSlot;
+    m_stats[i] = { };
+    m_stats[i]._budget = kUnlimitedBudget;
+  }
+}
+
+
+ResourceRegistry::~ResourceRegistry()
+{
+  // Resources still registered are left alone, their renderer is likely gone by now. Owners
+  // clear the registry on shut down instead.
+}
+
+
+AssetId ResourceRegistry::intern(const std::string& name)
+{
+  AssetId id = hashAssetName(name);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_names.find(id);
+  if (it == m_names.end()) {
+    m_names[id] = name;
+  } else {
+    R_ASSERT(it->second == name, "Two asset names hash to the same id.");
+  }
+  return id;
+}
+
+
+std::string ResourceRegistry::getName(AssetId id) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_names.find(id);
+  if (it == m_names.end()) return std::to_string(id);
+  return it->second;
+}
+
+
+B32 ResourceRegistry::destroy(AssetId id)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_slots.find(id);
+  if (it == m_slots.end() || m_entries[it->second]._refCount > 0) return false;
+  removeLocked(it->second, true);
+  return true;
+}
+
+
+B32 ResourceRegistry::addDependency(AssetId owner, AssetId dependency)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto ownerIt = m_slots.find(owner);
+  auto depIt = m_slots.find(dependency);
+  if (ownerIt == m_slots.end() || depIt == m_slots.end() || owner == dependency) return false;
+
+  dependLocked(ownerIt->second, depIt->second);
+  return true;
+}
+
+
+B32 ResourceRegistry::contains(AssetId id) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_slots.find(id) != m_slots.end();
+}
+
+
+U32 ResourceRegistry::getRefCount(AssetId id) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_slots.find(id);
+  if (it == m_slots.end()) return 0;
+  return m_entries[it->second]._refCount;
+}
+
+
+void ResourceRegistry::setBudget(ResourceCategory category, U64 bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats[category]._budget = bytes;
+  evictLocked(category, 0);
+}
+
+
+void ResourceRegistry::trim(ResourceCategory category)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  evictLocked(category, 0);
+}
+
+
+void ResourceRegistry::clear(ResourceCategory category)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (U32 slot = 0; slot < static_cast<U32>(m_entries.size()); ++slot) {
+    Entry& entry = m_entries[slot];
+    if (entry._pResource && entry._category == category) {
+      removeLocked(slot, true);
+    }
+  }
+}
+
+
+void ResourceRegistry::clearAll()
+{
+  for (U32 i = 0; i < RESOURCE_CATEGORY_COUNT; ++i) {
+    clear(static_cast<ResourceCategory>(i));
+  }
+}
+
+
+ResourceStats ResourceRegistry::getStats(ResourceCategory category) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats[category];
+}
+
+
+U32 ResourceRegistry::insertLocked(AssetId id, void* pResource, U32 category, U64 bytes, DestroyFunc destroy)
+{
+  // Callers check that neither the id, nor the resource, is registered yet.
+  U32 slot;
+  if (m_freeSlots.empty()) {
+    slot = static_cast<U32>(m_entries.size());
+    m_entries.emplace_back();
+    m_entries[slot]._generation = 0;
+  } else {
+    slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  }
+
+  Entry& entry = m_entries[slot];
+  entry._id = id;
+  entry._pResource = pResource;
+  entry._destroy = destroy;
+  entry._bytes = bytes;
+  entry._category = category;
+  entry._refCount = 0;
+  entry._dependencies.clear();
+  m_slots[id] = slot;
+  m_addresses[pResource] = slot;
+
+  ResourceStats& stats = m_stats[category];
+  stats._bytes += bytes;
+  stats._resident += 1;
+  linkLocked(slot);
+  return slot;
+}
+
+
+U32 ResourceRegistry::lookupLocked(AssetId id, U32 category)
+{
+  ResourceStats& stats = m_stats[category];
+  auto it = m_slots.find(id);
+  if (it == m_slots.end()) {
+    stats._misses += 1;
+    return kNoSlot;
+  }
+  if (m_entries[it->second]._category != category) {
+    R_DEBUG(rWarning, "Asset " + std::to_string(id) + " was looked up as the wrong type of resource.\n");
+    stats._misses += 1;
+    return kNoSlot;
+  }
+  stats._hits += 1;
+  return it->second;
+}
+
+
+void ResourceRegistry::removeLocked(U32 slot, B32 destroyResource)
+{
+  Entry& entry = m_entries[slot];
+  ResourceStats& stats = m_stats[entry._category];
+  if (entry._refCount == 0) {
+    unlinkLocked(slot);
+  } else {
+    stats._referenced -= 1;
+  }
+  stats._bytes -= entry._bytes;
+  stats._resident -= 1;
+  m_slots.erase(entry._id);
+  m_addresses.erase(entry._pResource);
+
+  void* pResource = entry._pResource;
+  DestroyFunc destroy = entry._destroy;
+  std::vector<SlotRef> dependencies;
+  dependencies.swap(entry._dependencies);
+
+  // Outstanding handles, and dependents, see the new generation and leave the slot alone.
+  entry._pResource = nullptr;
+  entry._refCount = 0;
+  entry._generation += 1;
+  m_freeSlots.push_back(slot);
+
+  if (destroyResource) destroy(pResource);
+
+  for (const SlotRef& dependency : dependencies) {
+    if (m_entries[dependency._slot]._generation == dependency._generation) {
+      releaseLocked(dependency._slot);
+    }
+  }
+}
+
+
+void ResourceRegistry::dependLocked(U32 ownerSlot, U32 dependencySlot)
+{
+  retainLocked(dependencySlot);
+  m_entries[ownerSlot]._dependencies.push_back({ dependencySlot, m_entries[dependencySlot]._generation });
+}
+
+
+void ResourceRegistry::evictLocked(U32 category, U64 incoming)
+{
+  ResourceStats& stats = m_stats[category];
+  while (m_lruHead[category] != kNoSlot && stats._bytes + incoming > stats._budget) {
+    U32 slot = m_lruHead[category];
+    R_DEBUG(rVerbose, "Evicting asset " + std::to_string(m_entries[slot]._id) + ".\n");
+    removeLocked(slot, true);
+    stats._evictions += 1;
+  }
+}
+
+
+void ResourceRegistry::retainLocked(U32 slot)
+{
+  Entry& entry = m_entries[slot];
+  if (entry._refCount++ == 0) {
+    unlinkLocked(slot);
+    m_stats[entry._category]._referenced += 1;
+  }
+}
+
+
+void ResourceRegistry::releaseLocked(U32 slot)
+{
+  Entry& entry = m_entries[slot];
+  R_ASSERT(entry._refCount > 0, "Released a resource nobody references.");
+  if (--entry._refCount == 0) {
+    linkLocked(slot);
+    m_stats[entry._category]._referenced -= 1;
+  }
+}
+
+
+void ResourceRegistry::touchLocked(U32 slot)
+{
+  if (m_entries[slot]._refCount == 0) {
+    unlinkLocked(slot);
+    linkLocked(slot);
+  }
+}
+
+
+void ResourceRegistry::linkLocked(U32 slot)
+{
+  Entry& entry = m_entries[slot];
+  U32 category = entry._category;
+  entry._prev = m_lruTail[category];
+  entry._next = kNoSlot;
+  if (m_lruTail[category] != kNoSlot) {
+    m_entries[m_lruTail[category]]._next = slot;
+  } else {
+    m_lruHead[category] = slot;
+  }
+  m_lruTail[category] = slot;
+}
+
+
+void ResourceRegistry::unlinkLocked(U32 slot)
+{
+  Entry& entry = m_entries[slot];
+  U32 category = entry._category;
+  if (entry._prev != kNoSlot) {
+    m_entries[entry._prev]._next = entry._next;
+  } else {
+    m_lruHead[category] = entry._next;
+  }
+  if (entry._next != kNoSlot) {
+    m_entries[entry._next]._prev = entry._prev;
+  } else {
+    m_lruTail[category] = entry._prev;
+  }
+  entry._prev = kNoSlot;
+  entry._next = kNoSlot;
+}
+
+
+void ResourceRegistry::retain(U32 slot, U32 generation)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_entries[slot]._generation == generation) retainLocked(slot);
+}
+
+
+void ResourceRegistry::drop(U32 slot, U32 generation)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_entries[slot]._generation == generation) releaseLocked(slot);
+}
+} // Recluse
@@ -1,6 +1,8 @@
 // Copyright (c) 2017-2018 Recluse Project. All rights reserved.
 #include "Scene/Scene.hpp"
 
+#include <algorithm>
+
 namespace Recluse {
 
 
@@ -18,5 +20,17 @@ void SceneNode::addChild(GameObject* child)
 {
   child->setSceneOwner(m_pScene);
   m_GameObjects.push_back(child);
+  GameObject::markHierarchyChanged();
+}
+
+
+void SceneNode::removeChild(GameObject* child)
+{
+  auto it = std::find(m_GameObjects.begin(), m_GameObjects.end(), child);
+  if (it == m_GameObjects.end()) return;
+  *it = m_GameObjects.back();
+  m_GameObjects.pop_back();
+  child->setSceneOwner(nullptr);
+  GameObject::markHierarchyChanged();
 }
 } // Recluse
\ No newline at end of file
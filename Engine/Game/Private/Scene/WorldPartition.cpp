@@ -0,0 +1,403 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Scene/WorldPartition.hpp"
+#include "Scene/Scene.hpp"
+#include "GameObject.hpp"
+
+#include "Filesystem/Filesystem.hpp"
+
+#include "Core/Exception.hpp"
+#include "Core/Logging/Log.hpp"
+#include "Core/Utility/Profile.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace Recluse {
+
+
+const world_cell_id_t WorldPartition::kInvalidCell;
+const U32 WorldPartition::kDefaultObjectsPerUpdate;
+
+
+WorldPartition::WorldPartition(R32 cellSize, R32 loadRadius, R32 unloadRadius)
+  : m_pScene(nullptr)
+  , m_memoryBudget(0)
+  , m_residentBytes(0)
+  , m_cellSize(cellSize)
+  , m_loadRadius(0.0f)
+  , m_unloadRadius(0.0f)
+  , m_objectsPerUpdate(kDefaultObjectsPerUpdate)
+{
+  R_ASSERT(cellSize > 0.0f, "World cells must have a size.\n");
+  m_stats = { };
+  setRadii(loadRadius, unloadRadius);
+}
+
+
+WorldPartition::~WorldPartition()
+{
+  unloadAll();
+}
+
+
+void WorldPartition::setRadii(R32 loadRadius, R32 unloadRadius)
+{
+  R_ASSERT(unloadRadius >= loadRadius, "Unload radius must not be less than the load radius.\n");
+  m_loadRadius = loadRadius;
+  m_unloadRadius = unloadRadius;
+}
+
+
+void WorldPartition::registerObjectType(const std::string& type, world_object_create_t create,
+                                        world_object_destroy_t destroy)
+{
+  R_ASSERT(create && destroy, "World object types require both a factory, and a destroyer.\n");
+  ObjectType& objectType = m_objectTypes[type];
+  objectType._create = create;
+  objectType._destroy = destroy;
+}
+
+
+world_cell_id_t WorldPartition::addCell(const WorldCellDesc& desc)
+{
+  U64 key = cellKey(desc._x, desc._z);
+  if (m_cellLookup.find(key) != m_cellLookup.end()) {
+    R_DEBUG(rWarning, "World cell already exists at " + std::to_string(desc._x) + ", "
+      + std::to_string(desc._z) + ".\n");
+    return kInvalidCell;
+  }
+
+  world_cell_id_t id = static_cast<world_cell_id_t>(m_cells.size());
+  std::unique_ptr<Cell> cell(new Cell());
+  cell->_desc = desc;
+  cell->_state = WORLD_CELL_UNLOADED;
+  cell->_nextObject = 0;
+  cell->_reservedBytes = 0;
+  cell->_lastBytes = 0;
+  cell->_distance = 0.0f;
+  m_cells.push_back(std::move(cell));
+  m_cellLookup[key] = id;
+  return id;
+}
+
+
+world_cell_id_t WorldPartition::findCell(I32 x, I32 z) const
+{
+  auto it = m_cellLookup.find(cellKey(x, z));
+  if (it == m_cellLookup.end()) return kInvalidCell;
+  return it->second;
+}
+
+
+world_cell_id_t WorldPartition::getCellAt(const Vector3& position) const
+{
+  I32 x = static_cast<I32>(std::floor(position.x / m_cellSize));
+  I32 z = static_cast<I32>(std::floor(position.z / m_cellSize));
+  return findCell(x, z);
+}
+
+
+R32 WorldPartition::distanceTo(const Cell& cell, const Vector3& position) const
+{
+  R32 minX = static_cast<R32>(cell._desc._x) * m_cellSize;
+  R32 minZ = static_cast<R32>(cell._desc._z) * m_cellSize;
+  R32 dx = std::max(std::max(minX - position.x, position.x - (minX + m_cellSize)), 0.0f);
+  R32 dz = std::max(std::max(minZ - position.z, position.z - (minZ + m_cellSize)), 0.0f);
+  return std::sqrt(dx * dx + dz * dz);
+}
+
+
+void WorldPartition::update(const Vector3& viewPosition)
+{
+  R_TIMED_PROFILE_GAME();
+
+  m_stats._objectsCreated = 0;
+  m_stats._objectsDestroyed = 0;
+
+  // Request cells coming into range, and release cells out of range. Cells in between are left
+  // as they are.
+  m_order.clear();
+  B32 measuring = false;
+  for (size_t i = 0; i < m_cells.size(); ++i) {
+    Cell& cell = *m_cells[i];
+    cell._distance = distanceTo(cell, viewPosition);
+    if (cell._state == WORLD_CELL_LOADING && cell._desc._memoryBudget == 0 && cell._reservedBytes == 0) {
+      measuring = true;
+    }
+    switch (cell._state) {
+      case WORLD_CELL_UNLOADED:
+      {
+        if (cell._distance <= m_loadRadius) m_order.push_back(static_cast<world_cell_id_t>(i));
+      } break;
+      case WORLD_CELL_LOADING:
+      case WORLD_CELL_FINALIZING:
+      case WORLD_CELL_LOADED:
+      {
+        if (cell._distance > m_unloadRadius) beginUnload(cell);
+      } break;
+      case WORLD_CELL_FAILED:
+      {
+        if (cell._distance > m_unloadRadius) cell._state = WORLD_CELL_UNLOADED;
+      } break;
+      default: break;
+    }
+  }
+
+  // Nearest cells first, skipping those that do not fit in the budget. Cells of unknown size 
+  // read one at a time, into free memory.
+  std::sort(m_order.begin(), m_order.end(), [this] (world_cell_id_t a, world_cell_id_t b) -> bool {
+    return m_cells[a]->_distance < m_cells[b]->_distance;
+  });
+  for (world_cell_id_t id : m_order) {
+    Cell& cell = *m_cells[id];
+    U64 bytes = cell._desc._memoryBudget != 0 ? cell._desc._memoryBudget : cell._lastBytes;
+    if (m_memoryBudget != 0) {
+      if (bytes == 0) {
+        if (measuring || m_residentBytes >= m_memoryBudget) continue;
+        measuring = true;
+      } else if (m_residentBytes + bytes > m_memoryBudget) {
+        continue;
+      }
+    }
+    beginLoad(cell);
+  }
+
+  // Unloading goes first, as it frees memory for the cells waiting on it.
+  U32 budget = m_objectsPerUpdate;
+  m_order.clear();
+  for (size_t i = 0; i < m_cells.size(); ++i) {
+    Cell& cell = *m_cells[i];
+    if (cell._state == WORLD_CELL_LOADING) {
+      pollLoad(cell);
+    } else if (cell._state == WORLD_CELL_UNLOADING) {
+      budget -= unload(cell, budget);
+    }
+    if (cell._state == WORLD_CELL_FINALIZING) {
+      m_order.push_back(static_cast<world_cell_id_t>(i));
+    }
+  }
+
+  std::sort(m_order.begin(), m_order.end(), [this] (world_cell_id_t a, world_cell_id_t b) -> bool {
+    return m_cells[a]->_distance < m_cells[b]->_distance;
+  });
+  for (world_cell_id_t id : m_order) {
+    if (budget == 0) break;
+    budget -= finalize(*m_cells[id], budget);
+  }
+
+  updateStats();
+}
+
+
+void WorldPartition::unloadAll()
+{
+  for (size_t i = 0; i < m_cells.size(); ++i) {
+    Cell& cell = *m_cells[i];
+    if (cell._state == WORLD_CELL_UNLOADED) continue;
+    if (cell._state == WORLD_CELL_FAILED) {
+      cell._state = WORLD_CELL_UNLOADED;
+      continue;
+    }
+    beginUnload(cell);
+    for (size_t f = 0; f < cell._requests.size(); ++f) {
+      gFilesystem().WaitAsyncRead(&cell._files[f]);
+    }
+    unload(cell, 0xFFFFFFFF);
+  }
+  m_stats._objectsCreated = 0;
+  m_stats._objectsDestroyed = 0;
+  updateStats();
+}
+
+
+void WorldPartition::beginLoad(Cell& cell)
+{
+  size_t count = cell._desc._assets.size();
+  cell._files.reset(count ? new AsyncFileHandle[count] : nullptr);
+  cell._requests.resize(count);
+  cell._objects.clear();
+  cell._objectTypes.clear();
+  cell._nextObject = 0;
+  cell._reservedBytes = cell._desc._memoryBudget != 0 ? cell._desc._memoryBudget : cell._lastBytes;
+  m_residentBytes += cell._reservedBytes;
+  cell._state = WORLD_CELL_LOADING;
+
+  // The cell holding the view is needed most.
+  AsyncIOPriority priority = cell._distance <= 0.0f ? AsyncIOPriority_High : AsyncIOPriority_Normal;
+  for (size_t i = 0; i < count; ++i) {
+    cell._requests[i] = gFilesystem().AsyncReadFile(cell._desc._assets[i].c_str(), &cell._files[i], priority);
+  }
+}
+
+
+B32 WorldPartition::filesFinished(const Cell& cell) const
+{
+  for (size_t i = 0; i < cell._requests.size(); ++i) {
+    if (!cell._files[i].Finished()) return false;
+  }
+  return true;
+}
+
+
+void WorldPartition::pollLoad(Cell& cell)
+{
+  if (!filesFinished(cell)) return;
+
+  B32 succeeded = true;
+  U64 bytes = 0;
+  for (size_t i = 0; i < cell._requests.size(); ++i) {
+    if (!cell._files[i].Succeeded()) {
+      R_DEBUG(rWarning, "World cell failed to read " + cell._desc._assets[i] + ".\n");
+      succeeded = false;
+      continue;
+    }
+    bytes += cell._files[i].Sz;
+  }
+
+  if (succeeded && cell._desc._memoryBudget != 0 && bytes > cell._desc._memoryBudget) {
+    R_DEBUG(rWarning, "World cell " + std::to_string(cell._desc._x) + ", " + std::to_string(cell._desc._z)
+      + " is over its memory budget, with " + std::to_string(bytes) + " bytes.\n");
+    succeeded = false;
+  }
+
+  if (!succeeded) {
+    releaseCell(cell);
+    cell._state = WORLD_CELL_FAILED;
+    return;
+  }
+
+  // Cells without a budget of their own reserve what they actually hold, if it fits. Those that
+  // never can fail, others wait for memory to be freed.
+  if (cell._desc._memoryBudget == 0) {
+    cell._lastBytes = bytes;
+    if (m_memoryBudget != 0 && m_residentBytes - cell._reservedBytes + bytes > m_memoryBudget) {
+      releaseCell(cell);
+      if (bytes > m_memoryBudget) {
+        R_DEBUG(rWarning, "World cell " + std::to_string(cell._desc._x) + ", " + std::to_string(cell._desc._z)
+          + " is over the memory budget, with " + std::to_string(bytes) + " bytes.\n");
+        cell._state = WORLD_CELL_FAILED;
+      } else {
+        cell._state = WORLD_CELL_UNLOADED;
+      }
+      return;
+    }
+    m_residentBytes -= cell._reservedBytes;
+    m_residentBytes += bytes;
+    cell._reservedBytes = bytes;
+  }
+  cell._state = WORLD_CELL_FINALIZING;
+}
+
+
+void WorldPartition::beginUnload(Cell& cell)
+{
+  if (cell._state == WORLD_CELL_LOADING) {
+    for (size_t i = 0; i < cell._requests.size(); ++i) {
+      gFilesystem().CancelAsyncRead(cell._requests[i]);
+    }
+  }
+  cell._state = WORLD_CELL_UNLOADING;
+}
+
+
+void WorldPartition::releaseCell(Cell& cell)
+{
+  cell._files.reset();
+  cell._requests.clear();
+  cell._nextObject = 0;
+  m_residentBytes -= cell._reservedBytes;
+  cell._reservedBytes = 0;
+}
+
+
+U32 WorldPartition::finalize(Cell& cell, U32 budget)
+{
+  const std::vector<WorldObjectDesc>& objects = cell._desc._objects;
+  U32 created = 0;
+  while (cell._nextObject < objects.size() && created < budget) {
+    const WorldObjectDesc& desc = objects[cell._nextObject++];
+    auto it = m_objectTypes.find(desc._type);
+    if (it == m_objectTypes.end()) {
+      R_DEBUG(rWarning, "No world object type registered as " + desc._type + ".\n");
+      continue;
+    }
+
+    const AsyncFileHandle* pAsset = nullptr;
+    if (desc._asset >= 0 && desc._asset < static_cast<I32>(cell._desc._assets.size())) {
+      pAsset = &cell._files[desc._asset];
+    }
+
+    GameObject* pObject = it->second._create(desc, pAsset);
+    ++created;
+    if (!pObject) continue;
+
+    Transform* transform = pObject->getTransform();
+    transform->_position = transform->_localPosition = desc._position;
+    transform->_rotation = transform->_localRotation = desc._rotation;
+    transform->_scale = transform->_localScale = desc._scale;
+    if (!desc._name.empty()) pObject->setName(desc._name);
+    if (m_pScene) m_pScene->getRoot()->addChild(pObject);
+    pObject->start();
+
+    cell._objects.push_back(pObject);
+    cell._objectTypes.push_back(&it->second);
+  }
+
+  m_stats._objectsCreated += created;
+  if (cell._nextObject >= objects.size()) {
+    cell._state = WORLD_CELL_LOADED;
+  }
+  return created;
+}
+
+
+U32 WorldPartition::unload(Cell& cell, U32 budget)
+{
+  // Canceled reads that already started must finish before their buffers are released.
+  if (!filesFinished(cell)) return 0;
+
+  U32 destroyed = 0;
+  while (!cell._objects.empty() && destroyed < budget) {
+    GameObject* pObject = cell._objects.back();
+    const ObjectType* pType = cell._objectTypes.back();
+    cell._objects.pop_back();
+    cell._objectTypes.pop_back();
+
+    if (m_pScene) m_pScene->getRoot()->removeChild(pObject);
+    pObject->cleanUp();
+    pType->_destroy(pObject);
+    ++destroyed;
+  }
+
+  m_stats._objectsDestroyed += destroyed;
+  if (cell._objects.empty()) {
+    releaseCell(cell);
+    cell._state = WORLD_CELL_UNLOADED;
+  }
+  return destroyed;
+}
+
+
+void WorldPartition::updateStats()
+{
+  m_stats._loadingCells = 0;
+  m_stats._finalizingCells = 0;
+  m_stats._loadedCells = 0;
+  m_stats._unloadingCells = 0;
+  m_stats._objectCount = 0;
+  for (size_t i = 0; i < m_cells.size(); ++i) {
+    const Cell& cell = *m_cells[i];
+    switch (cell._state) {
+      case WORLD_CELL_LOADING: m_stats._loadingCells++; break;
+      case WORLD_CELL_FINALIZING: m_stats._finalizingCells++; break;
+      case WORLD_CELL_LOADED: m_stats._loadedCells++; break;
+      case WORLD_CELL_UNLOADING: m_stats._unloadingCells++; break;
+      default: break;
+    }
+    m_stats._objectCount += static_cast<U32>(cell._objects.size());
+  }
+  m_stats._residentBytes = m_residentBytes;
+  m_stats._memoryBudget = m_memoryBudget;
+}
+} // Recluse
@@ -0,0 +1,194 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TransformHierarchy.hpp"
+#include "GameObject.hpp"
+#include "Component.hpp"
+#include "Scene/Scene.hpp"
+
+#include "Core/Thread/Threading.hpp"
+#include "Core/Exception.hpp"
+
+#include <atomic>
+
+
+namespace Recluse {
+
+
+// Below this many nodes, updating on the calling thread beats scheduling jobs.
+static const size_t kParallelNodeThreshold = 2048;
+
+// Node flags.
+static const U8 kNodeUpdated = (1 << 0);
+static const U8 kNodeForceUpdate = (1 << 1);
+
+
+TransformHierarchy::TransformHierarchy()
+  : m_pScene(nullptr)
+  , m_version(0)
+  , m_lastUpdatedCount(0)
+{
+}
+
+
+void TransformHierarchy::clear()
+{
+  m_transforms.clear();
+  m_parents.clear();
+  m_subtreeEnds.clear();
+  m_roots.clear();
+  m_localPositions.clear();
+  m_localRotations.clear();
+  m_localScales.clear();
+  m_worldRotations.clear();
+  m_localMatrices.clear();
+  m_worldMatrices.clear();
+  m_dirty.clear();
+  m_pScene = nullptr;
+  m_lastUpdatedCount = 0;
+}
+
+
+B32 TransformHierarchy::needsRebuild(Scene* pScene) const
+{
+  return (pScene != m_pScene) || (GameObject::hierarchyVersion() != m_version);
+}
+
+
+void TransformHierarchy::build(Scene* pScene)
+{
+  clear();
+  m_pScene = pScene;
+  m_version = GameObject::hierarchyVersion();
+  if (!pScene) return;
+
+  // Depth first, pre order, walk of the scene graph. Each stack entry is an object, and the
+  // index of its parent node.
+  struct Entry {
+    GameObject* _pObject;
+    I32         _parent;
+  };
+  std::vector<Entry> stack;
+  std::vector<U32> open;
+  SceneNode* root = pScene->getRoot();
+  for (size_t i = root->getChildrenCount(); i > 0; --i) {
+    stack.push_back({ root->getChild(i - 1), kNoParent });
+  }
+
+  while (!stack.empty()) {
+    Entry entry = stack.back();
+    stack.pop_back();
+
+    // Close subtrees that this node is not a part of.
+    while (!open.empty() && static_cast<I32>(open.back()) != entry._parent) {
+      m_subtreeEnds[open.back()] = static_cast<U32>(m_transforms.size());
+      open.pop_back();
+    }
+
+    U32 idx = static_cast<U32>(m_transforms.size());
+    if (entry._parent == kNoParent) m_roots.push_back(idx);
+    m_transforms.push_back(entry._pObject->getTransform());
+    m_parents.push_back(entry._parent);
+    m_subtreeEnds.push_back(idx + 1);
+    open.push_back(idx);
+
+    // Push in reverse, so children are laid out in order.
+    for (size_t i = entry._pObject->getChildrenCount(); i > 0; --i) {
+      stack.push_back({ entry._pObject->getChild(i - 1), static_cast<I32>(idx) });
+    }
+  }
+  while (!open.empty()) {
+    m_subtreeEnds[open.back()] = static_cast<U32>(m_transforms.size());
+    open.pop_back();
+  }
+
+  size_t count = m_transforms.size();
+  m_localPositions.resize(count);
+  m_localRotations.resize(count);
+  m_localScales.resize(count);
+  m_worldRotations.resize(count);
+  m_localMatrices.resize(count);
+  m_worldMatrices.resize(count);
+  // Everything is computed on the first update.
+  m_dirty.assign(count, kNodeForceUpdate);
+}
+
+
+B32 TransformHierarchy::gather(U32 idx)
+{
+  Transform* transform = m_transforms[idx];
+  B32 root = (m_parents[idx] == kNoParent);
+  const Vector3& position = root ? transform->_position : transform->_localPosition;
+  const Quaternion& rotation = root ? transform->_rotation : transform->_localRotation;
+  const Vector3& scale = root ? transform->_scale : transform->_localScale;
+  if (position == m_localPositions[idx] && rotation == m_localRotations[idx] && scale == m_localScales[idx]) {
+    return false;
+  }
+  m_localPositions[idx] = position;
+  m_localRotations[idx] = rotation;
+  m_localScales[idx] = scale;
+  return true;
+}
+
+
+size_t TransformHierarchy::updateSubtree(U32 root)
+{
+  size_t updated = 0;
+  U32 end = m_subtreeEnds[root];
+  for (U32 i = root; i < end; ++i) {
+    I32 parent = m_parents[i];
+    // Parents are visited first, so their flags are already those of this update.
+    B32 dirty = gather(i) || (m_dirty[i] & kNodeForceUpdate) 
+      || (parent != kNoParent && (m_dirty[parent] & kNodeUpdated));
+    m_dirty[i] = dirty ? kNodeUpdated : 0;
+    if (!dirty) continue;
+
+    // Same composition as Transform::update().
+    Matrix4 T = Matrix4::translate(Matrix4::identity(), m_localPositions[i]);
+    Matrix4 R = m_localRotations[i].toMatrix4();
+    Matrix4 S = Matrix4::scale(Matrix4::identity(), m_localScales[i]);
+    m_localMatrices[i] = S * R * T;
+
+    Transform* transform = m_transforms[i];
+    if (parent == kNoParent) {
+      m_worldMatrices[i] = m_localMatrices[i];
+      m_worldRotations[i] = m_localRotations[i];
+    } else {
+      m_worldMatrices[i] = m_localMatrices[i] * m_worldMatrices[parent];
+      m_worldRotations[i] = m_localRotations[i] * m_worldRotations[parent];
+      transform->_position = Vector3(m_worldMatrices[i][3][0], m_worldMatrices[i][3][1], m_worldMatrices[i][3][2]);
+      transform->_rotation = m_worldRotations[i];
+    }
+
+    transform->m_localToWorldMatrix = m_worldMatrices[i];
+    transform->m_worldToLocalMatrix = m_worldMatrices[i].inverse();
+    transform->updateAxes();
+    updated++;
+  }
+  return updated;
+}
+
+
+void TransformHierarchy::update(ThreadPool* pPool)
+{
+  size_t nodeCount = m_transforms.size();
+  if (!pPool || nodeCount < kParallelNodeThreshold || m_roots.size() < 2) {
+    size_t updated = 0;
+    for (U32 root : m_roots) {
+      updated += updateSubtree(root);
+    }
+    m_lastUpdatedCount = updated;
+    return;
+  }
+
+  std::atomic<size_t> updated(0);
+  JobCounter counter;
+  pPool->ParallelFor(static_cast<U32>(m_roots.size()), 64, [&] (U32 start, U32 end) -> void {
+    size_t count = 0;
+    for (U32 i = start; i < end; ++i) {
+      count += updateSubtree(m_roots[i]);
+    }
+    updated.fetch_add(count);
+  }, &counter);
+  pPool->WaitForCounter(&counter);
+  m_lastUpdatedCount = updated.load();
+}
+} // Recluse
@@ -0,0 +1,107 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Visibility/FrustumCuller.hpp"
+
+#include "Core/Exception.hpp"
+#include "Core/Utility/Profile.hpp"
+
+
+namespace Recluse {
+
+
+const cull_slot_t FrustumCuller::kInvalidSlot;
+const U32 FrustumCuller::kBatchSize;
+
+
+// Freed slots are parked far outside of any frustum.
+static const R32 kFreedSlotPosition = 1e30f;
+
+
+FrustumCuller::FrustumCuller()
+{
+}
+
+
+cull_slot_t FrustumCuller::add(void* pUserData)
+{
+  R_ASSERT(pUserData, "Culled objects require user data.\n");
+  cull_slot_t slot;
+  if (!m_freeSlots.empty()) {
+    slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  } else {
+    slot = static_cast<cull_slot_t>(m_userData.size());
+    m_centerX.push_back(0.0f);
+    m_centerY.push_back(0.0f);
+    m_centerZ.push_back(0.0f);
+    m_extentX.push_back(0.0f);
+    m_extentY.push_back(0.0f);
+    m_extentZ.push_back(0.0f);
+    m_masks.push_back(0);
+    m_userData.push_back(nullptr);
+  }
+  m_userData[slot] = pUserData;
+  m_masks[slot] = 0;
+  return slot;
+}
+
+
+void FrustumCuller::remove(cull_slot_t slot)
+{
+  R_ASSERT(slot < m_userData.size() && m_userData[slot], "Invalid cull slot.\n");
+  m_userData[slot] = nullptr;
+  m_centerX[slot] = m_centerY[slot] = m_centerZ[slot] = kFreedSlotPosition;
+  m_extentX[slot] = m_extentY[slot] = m_extentZ[slot] = 0.0f;
+  m_masks[slot] = 0;
+  m_freeSlots.push_back(slot);
+}
+
+
+void FrustumCuller::clear()
+{
+  m_centerX.clear();
+  m_centerY.clear();
+  m_centerZ.clear();
+  m_extentX.clear();
+  m_extentY.clear();
+  m_extentZ.clear();
+  m_masks.clear();
+  m_userData.clear();
+  m_freeSlots.clear();
+}
+
+
+void FrustumCuller::setBounds(cull_slot_t slot, const AABB& aabb)
+{
+  m_centerX[slot] = (aabb.min.x + aabb.max.x) * 0.5f;
+  m_centerY[slot] = (aabb.min.y + aabb.max.y) * 0.5f;
+  m_centerZ[slot] = (aabb.min.z + aabb.max.z) * 0.5f;
+  m_extentX[slot] = (aabb.max.x - aabb.min.x) * 0.5f;
+  m_extentY[slot] = (aabb.max.y - aabb.min.y) * 0.5f;
+  m_extentZ[slot] = (aabb.max.z - aabb.min.z) * 0.5f;
+}
+
+
+void FrustumCuller::cull(const ViewFrustum* const* frustums, U32 frustumCount, ThreadPool* pPool,
+                         thr_range_func_t onCulled)
+{
+  R_TIMED_PROFILE_GAME();
+
+  U32 count = static_cast<U32>(m_userData.size());
+  auto cullRange = [&] (U32 start, U32 end) -> void {
+    ViewFrustum::cullBatch(frustums, frustumCount,
+      m_centerX.data() + start, m_centerY.data() + start, m_centerZ.data() + start,
+      m_extentX.data() + start, m_extentY.data() + start, m_extentZ.data() + start,
+      m_masks.data() + start, end - start);
+    if (onCulled) onCulled(start, end);
+  };
+
+  if (!pPool || count <= kBatchSize) {
+    cullRange(0, count);
+    return;
+  }
+
+  JobCounter counter;
+  pPool->ParallelFor(count, kBatchSize, cullRange, &counter);
+  pPool->WaitForCounter(&counter);
+}
+} // Recluse
@@ -0,0 +1,359 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Visibility/OcclusionCuller.hpp"
+
+#include "Core/Exception.hpp"
+#include "Core/Math/SIMD.hpp"
+#include "Core/Thread/Threading.hpp"
+#include "Core/Utility/Profile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if __USE_INTEL_INTRINSICS__
+#define FAST_INTRINSICS
+#include <smmintrin.h>
+#endif
+
+
+namespace Recluse {
+
+
+const occluder_id_t OcclusionCuller::kInvalidOccluder;
+const U32 OcclusionCuller::kTileSize;
+const U32 OcclusionCuller::kDefaultWidth;
+const U32 OcclusionCuller::kDefaultHeight;
+
+
+// Clip w below which vertices are treated as crossing the near plane.
+static const R32 kMinClipW = 1e-4f;
+
+// Triangles reaching further than this off screen, in pixels, are skipped, keeping edge functions
+// well within float precision.
+static const R32 kGuardBand = 16384.0f;
+
+
+struct ClipVertex {
+  R32 x, y, w;
+};
+
+
+static ClipVertex toClip(const Matrix4& m, R32 x, R32 y, R32 z)
+{
+  ClipVertex v;
+  v.x = x * m.get(0, 0) + y * m.get(1, 0) + z * m.get(2, 0) + m.get(3, 0);
+  v.y = x * m.get(0, 1) + y * m.get(1, 1) + z * m.get(2, 1) + m.get(3, 1);
+  v.w = x * m.get(0, 3) + y * m.get(1, 3) + z * m.get(2, 3) + m.get(3, 3);
+  return v;
+}
+
+
+OcclusionCuller::OcclusionCuller(U32 width, U32 height)
+  : m_culledPrimitives(0)
+  , m_rasterizedTriangles(0)
+  , m_width(0)
+  , m_height(0)
+  , m_tilesX(0)
+  , m_tilesY(0)
+  , m_enabled(true)
+  , m_rendered(false)
+{
+  resize(width, height);
+}
+
+
+void OcclusionCuller::resize(U32 width, U32 height)
+{
+  R_ASSERT(width > 0 && height > 0, "Occlusion depth buffer must not be empty.\n");
+  m_tilesX = (width + kTileSize - 1) / kTileSize;
+  m_tilesY = (height + kTileSize - 1) / kTileSize;
+  m_width = m_tilesX * kTileSize;
+  m_height = m_tilesY * kTileSize;
+  m_depth.assign(m_width * m_height, 0.0f);
+  m_tileDepth.assign(m_tilesX * m_tilesY, 0.0f);
+  m_rendered = false;
+}
+
+
+occluder_id_t OcclusionCuller::addOccluder(const OccluderMesh* pMesh)
+{
+  R_ASSERT(pMesh, "Occluders require a mesh.\n");
+  R_ASSERT(pMesh->_indices.size() % 3 == 0, "Occluder meshes must be triangle lists.\n");
+  occluder_id_t id;
+  if (!m_freeOccluders.empty()) {
+    id = m_freeOccluders.back();
+    m_freeOccluders.pop_back();
+  } else {
+    id = static_cast<occluder_id_t>(m_occluders.size());
+    m_occluders.push_back(Occluder());
+  }
+  m_occluders[id]._pMesh = pMesh;
+  m_occluders[id]._localToWorld = Matrix4::identity();
+  return id;
+}
+
+
+void OcclusionCuller::removeOccluder(occluder_id_t id)
+{
+  R_ASSERT(id < m_occluders.size() && m_occluders[id]._pMesh, "Invalid occluder.\n");
+  m_occluders[id]._pMesh = nullptr;
+  m_freeOccluders.push_back(id);
+}
+
+
+void OcclusionCuller::setOccluderTransform(occluder_id_t id, const Matrix4& localToWorld)
+{
+  R_ASSERT(id < m_occluders.size() && m_occluders[id]._pMesh, "Invalid occluder.\n");
+  m_occluders[id]._localToWorld = localToWorld;
+}
+
+
+void OcclusionCuller::setupTriangles(const Matrix4& viewProjection)
+{
+  const R32 halfWidth = static_cast<R32>(m_width) * 0.5f;
+  const R32 halfHeight = static_cast<R32>(m_height) * 0.5f;
+  const R32 maxX = static_cast<R32>(m_width - 1);
+  const R32 maxY = static_cast<R32>(m_height - 1);
+
+  m_triangles.clear();
+  std::vector<ClipVertex> clip;
+  for (size_t i = 0; i < m_occluders.size(); ++i) {
+    const Occluder& occluder = m_occluders[i];
+    if (!occluder._pMesh) continue;
+    const std::vector<Vector3>& positions = occluder._pMesh->_positions;
+    const std::vector<U32>& indices = occluder._pMesh->_indices;
+
+    Matrix4 localToClip = occluder._localToWorld * viewProjection;
+    clip.resize(positions.size());
+    for (size_t v = 0; v < positions.size(); ++v) {
+      ClipVertex c = toClip(localToClip, positions[v].x, positions[v].y, positions[v].z);
+      // Projections flip y, so rows run top down as in the framebuffer. Vertices behind the near
+      // plane are flagged by a negative w.
+      if (c.w >= kMinClipW) {
+        R32 iw = 1.0f / c.w;
+        c.x = (c.x * iw + 1.0f) * halfWidth;
+        c.y = (c.y * iw + 1.0f) * halfHeight;
+        c.w = iw;
+      } else {
+        c.w = -1.0f;
+      }
+      clip[v] = c;
+    }
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+      ClipVertex v0 = clip[indices[t]];
+      ClipVertex v1 = clip[indices[t + 1]];
+      ClipVertex v2 = clip[indices[t + 2]];
+      if (v0.w < 0.0f || v1.w < 0.0f || v2.w < 0.0f) continue;
+
+      R32 area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+      if (std::fabs(area) < 1e-6f) continue;
+      // Both faces occlude, wind every triangle the same way.
+      if (area < 0.0f) {
+        std::swap(v1, v2);
+        area = -area;
+      }
+
+      R32 x0 = std::min(v0.x, std::min(v1.x, v2.x));
+      R32 x1 = std::max(v0.x, std::max(v1.x, v2.x));
+      R32 y0 = std::min(v0.y, std::min(v1.y, v2.y));
+      R32 y1 = std::max(v0.y, std::max(v1.y, v2.y));
+      if (x1 < 0.0f || y1 < 0.0f || x0 > maxX + 1.0f || y0 > maxY + 1.0f) continue;
+      if (x0 < -kGuardBand || y0 < -kGuardBand || x1 > kGuardBand || y1 > kGuardBand) continue;
+
+      ScreenTriangle tri;
+      tri._minX = static_cast<I32>(std::max(0.0f, std::floor(x0)));
+      tri._minY = static_cast<I32>(std::max(0.0f, std::floor(y0)));
+      tri._maxX = static_cast<I32>(std::min(maxX, std::ceil(x1)));
+      tri._maxY = static_cast<I32>(std::min(maxY, std::ceil(y1)));
+
+      // Edge function of edge (a, b) is positive on the side of the opposing vertex.
+      const ClipVertex* verts[3] = { &v0, &v1, &v2 };
+      R32* edges[3] = { tri._edgeA, tri._edgeB, tri._edgeC };
+      for (U32 e = 0; e < 3; ++e) {
+        const ClipVertex& a = *verts[e];
+        const ClipVertex& b = *verts[(e + 1) % 3];
+        edges[0][e] = a.y - b.y;
+        edges[1][e] = b.x - a.x;
+        edges[2][e] = (b.y - a.y) * a.x - (b.x - a.x) * a.y;
+      }
+
+      // Barycentric weight of each vertex is the edge function opposing it, over the area.
+      R32 invArea = 1.0f / area;
+      R32 w0 = v0.w * invArea;
+      R32 w1 = v1.w * invArea;
+      R32 w2 = v2.w * invArea;
+      tri._depthA = tri._edgeA[1] * w0 + tri._edgeA[2] * w1 + tri._edgeA[0] * w2;
+      tri._depthB = tri._edgeB[1] * w0 + tri._edgeB[2] * w1 + tri._edgeB[0] * w2;
+      tri._depthC = tri._edgeC[1] * w0 + tri._edgeC[2] * w1 + tri._edgeC[0] * w2;
+      m_triangles.push_back(tri);
+    }
+  }
+  m_rasterizedTriangles = static_cast<U32>(m_triangles.size());
+}
+
+
+void OcclusionCuller::rasterizeTileRow(U32 tileRow)
+{
+  const I32 rowStart = static_cast<I32>(tileRow * kTileSize);
+  const I32 rowEnd = rowStart + static_cast<I32>(kTileSize) - 1;
+  std::fill(m_depth.begin() + rowStart * m_width, m_depth.begin() + (rowEnd + 1) * m_width, 0.0f);
+
+#if defined FAST_INTRINSICS
+  const B32 useSIMD = getSIMDInstructionSet() >= SIMD_SSE4_1;
+#endif
+
+  for (size_t t = 0; t < m_triangles.size(); ++t) {
+    const ScreenTriangle& tri = m_triangles[t];
+    I32 y0 = std::max(tri._minY, rowStart);
+    I32 y1 = std::min(tri._maxY, rowEnd);
+    if (y0 > y1) continue;
+    // Spans start on groups of four pixels, which never run past the row as widths are whole tiles.
+    I32 x0 = tri._minX & ~3;
+    I32 x1 = tri._maxX;
+
+    for (I32 y = y0; y <= y1; ++y) {
+      R32 py = static_cast<R32>(y) + 0.5f;
+      R32* row = m_depth.data() + y * m_width;
+      R32 e0 = tri._edgeB[0] * py + tri._edgeC[0];
+      R32 e1 = tri._edgeB[1] * py + tri._edgeC[1];
+      R32 e2 = tri._edgeB[2] * py + tri._edgeC[2];
+      R32 d = tri._depthB * py + tri._depthC;
+
+#if defined FAST_INTRINSICS
+      if (useSIMD) {
+        const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        const __m128 zero = _mm_setzero_ps();
+        for (I32 x = x0; x <= x1; x += 4) {
+          __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<R32>(x)), offsets);
+          __m128 f0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri._edgeA[0]), px), _mm_set1_ps(e0));
+          __m128 f1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri._edgeA[1]), px), _mm_set1_ps(e1));
+          __m128 f2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri._edgeA[2]), px), _mm_set1_ps(e2));
+          __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(f0, zero), _mm_cmpge_ps(f1, zero)),
+                                     _mm_cmpge_ps(f2, zero));
+          if (_mm_movemask_ps(inside) == 0) continue;
+          __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri._depthA), px), _mm_set1_ps(d));
+          __m128 current = _mm_loadu_ps(row + x);
+          _mm_storeu_ps(row + x, _mm_blendv_ps(current, _mm_max_ps(current, depth), inside));
+        }
+        continue;
+      }
+#endif
+
+      for (I32 x = x0; x <= x1; ++x) {
+        R32 px = static_cast<R32>(x) + 0.5f;
+        if (tri._edgeA[0] * px + e0 < 0.0f) continue;
+        if (tri._edgeA[1] * px + e1 < 0.0f) continue;
+        if (tri._edgeA[2] * px + e2 < 0.0f) continue;
+        R32 depth = tri._depthA * px + d;
+        if (depth > row[x]) row[x] = depth;
+      }
+    }
+  }
+
+  // Reduce the row into tiles, each keeping the farthest depth of its pixels.
+  for (U32 tx = 0; tx < m_tilesX; ++tx) {
+    R32 farthest = m_depth[rowStart * m_width + tx * kTileSize];
+    for (U32 y = 0; y < kTileSize; ++y) {
+      const R32* row = m_depth.data() + (rowStart + y) * m_width + tx * kTileSize;
+      for (U32 x = 0; x < kTileSize; ++x) {
+        farthest = std::min(farthest, row[x]);
+      }
+    }
+    m_tileDepth[tileRow * m_tilesX + tx] = farthest;
+  }
+}
+
+
+void OcclusionCuller::render(const Matrix4& viewProjection, ThreadPool* pPool)
+{
+  R_TIMED_PROFILE_GAME();
+
+  m_culledPrimitives.store(0, std::memory_order_relaxed);
+  m_viewProjection = viewProjection;
+  m_rendered = m_enabled;
+  if (!m_enabled) return;
+
+  setupTriangles(viewProjection);
+
+  if (!pPool) {
+    for (U32 row = 0; row < m_tilesY; ++row) {
+      rasterizeTileRow(row);
+    }
+    return;
+  }
+
+  JobCounter counter;
+  pPool->ParallelFor(m_tilesY, 1, [&] (U32 start, U32 end) -> void {
+    for (U32 row = start; row < end; ++row) {
+      rasterizeTileRow(row);
+    }
+  }, &counter);
+  pPool->WaitForCounter(&counter);
+}
+
+
+B32 OcclusionCuller::testAABB(const AABB& aabb) const
+{
+  if (!m_rendered) return true;
+
+  R32 minX = kGuardBand, minY = kGuardBand;
+  R32 maxX = -kGuardBand, maxY = -kGuardBand;
+  R32 nearest = 0.0f;
+  for (U32 i = 0; i < 8; ++i) {
+    ClipVertex c = toClip(m_viewProjection,
+      (i & 1) ? aabb.max.x : aabb.min.x,
+      (i & 2) ? aabb.max.y : aabb.min.y,
+      (i & 4) ? aabb.max.z : aabb.min.z);
+    if (c.w < kMinClipW) return true;
+    R32 iw = 1.0f / c.w;
+    R32 x = (c.x * iw + 1.0f) * static_cast<R32>(m_width) * 0.5f;
+    R32 y = (c.y * iw + 1.0f) * static_cast<R32>(m_height) * 0.5f;
+    minX = std::min(minX, x);
+    maxX = std::max(maxX, x);
+    minY = std::min(minY, y);
+    maxY = std::max(maxY, y);
+    nearest = std::max(nearest, iw);
+  }
+
+  // Off screen boxes are left to frustum culling.
+  if (maxX < 0.0f || maxY < 0.0f) return true;
+  if (minX >= static_cast<R32>(m_width) || minY >= static_cast<R32>(m_height)) return true;
+
+  I32 tx0 = static_cast<I32>(std::max(minX, 0.0f)) / static_cast<I32>(kTileSize);
+  I32 ty0 = static_cast<I32>(std::max(minY, 0.0f)) / static_cast<I32>(kTileSize);
+  I32 tx1 = std::min(static_cast<I32>(maxX) / static_cast<I32>(kTileSize), static_cast<I32>(m_tilesX) - 1);
+  I32 ty1 = std::min(static_cast<I32>(maxY) / static_cast<I32>(kTileSize), static_cast<I32>(m_tilesY) - 1);
+
+  for (I32 ty = ty0; ty <= ty1; ++ty) {
+    const R32* tiles = m_tileDepth.data() + ty * m_tilesX;
+    for (I32 tx = tx0; tx <= tx1; ++tx) {
+      if (tiles[tx] <= nearest) return true;
+    }
+  }
+  return false;
+}
+
+
+B32 OcclusionCuller::dumpDepthBuffer(const std::string& path) const
+{
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file) return false;
+
+  R32 nearest = 0.0f;
+  for (size_t i = 0; i < m_depth.size(); ++i) {
+    nearest = std::max(nearest, m_depth[i]);
+  }
+  R32 scale = nearest > 0.0f ? 255.0f / nearest : 0.0f;
+
+  std::vector<U8> pixels(m_depth.size());
+  for (size_t i = 0; i < m_depth.size(); ++i) {
+    pixels[i] = static_cast<U8>(m_depth[i] * scale + 0.5f);
+  }
+
+  fprintf(file, "P5\n%u %u\n255\n", m_width, m_height);
+  size_t written = fwrite(pixels.data(), 1, pixels.size(), file);
+  fclose(file);
+  return written == pixels.size();
+}
+} // Recluse
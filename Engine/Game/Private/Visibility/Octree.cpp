@@ -0,0 +1,386 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Visibility/Octree.hpp"
+
+#include "Core/Exception.hpp"
+#include "Core/Logging/Log.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace Recluse {
+
+
+const octree_proxy_t Octree::kInvalidProxy;
+const U32 Octree::kMaxDepth;
+const U32 Octree::kNoNode;
+
+
+// Largest number of nodes pushed while traversing, 7 siblings left per level, and the last 8 children.
+static const U32 kMaxTraversalStack = Octree::kMaxDepth * 7 + 8;
+
+
+struct RayVolume {
+  Vector3 _origin;
+  Vector3 _invDirection;
+  R32     _maxDistance;
+};
+
+
+static ViewFrustum::Result TestFrustum(const void* pVolume, const AABB& aabb)
+{
+  return static_cast<const ViewFrustum*>(pVolume)->intersect(aabb);
+}
+
+
+static ViewFrustum::Result TestSphere(const void* pVolume, const AABB& aabb)
+{
+  const Sphere& sphere = *static_cast<const Sphere*>(pVolume);
+  const Vector3& c = sphere.center;
+  R32 nearest = 0.0f;
+  R32 farthest = 0.0f;
+  for (U32 i = 0; i < 3; ++i) {
+    R32 v = (&c.x)[i];
+    R32 lo = (&aabb.min.x)[i];
+    R32 hi = (&aabb.max.x)[i];
+    R32 dn = v < lo ? lo - v : (v > hi ? v - hi : 0.0f);
+    R32 df = std::max(std::abs(v - lo), std::abs(hi - v));
+    nearest += dn * dn;
+    farthest += df * df;
+  }
+  R32 r2 = sphere.radius * sphere.radius;
+  if (nearest > r2) return ViewFrustum::Result_Outside;
+  if (farthest <= r2) return ViewFrustum::Result_Inside;
+  return ViewFrustum::Result_Intersect;
+}
+
+
+static ViewFrustum::Result TestAABB(const void* pVolume, const AABB& aabb)
+{
+  const AABB& volume = *static_cast<const AABB*>(pVolume);
+  if (!volume.overlaps(aabb)) return ViewFrustum::Result_Outside;
+  if (volume.contains(aabb)) return ViewFrustum::Result_Inside;
+  return ViewFrustum::Result_Intersect;
+}
+
+
+// Slab test. A ray is never inside of a box, so this returns either outside, or intersect.
+static ViewFrustum::Result TestRay(const void* pVolume, const AABB& aabb)
+{
+  const RayVolume& ray = *static_cast<const RayVolume*>(pVolume);
+  R32 tMin = 0.0f;
+  R32 tMax = ray._maxDistance;
+  for (U32 i = 0; i < 3; ++i) {
+    R32 o = (&ray._origin.x)[i];
+    R32 inv = (&ray._invDirection.x)[i];
+    R32 t0 = ((&aabb.min.x)[i] - o) * inv;
+    R32 t1 = ((&aabb.max.x)[i] - o) * inv;
+    if (t0 > t1) std::swap(t0, t1);
+    tMin = std::max(tMin, t0);
+    tMax = std::min(tMax, t1);
+    if (tMin > tMax) return ViewFrustum::Result_Outside;
+  }
+  return ViewFrustum::Result_Intersect;
+}
+
+
+static B32 InsideNode(const Vector3& p, const Vector3& center, R32 halfSize)
+{
+  return std::abs(p.x - center.x) <= halfSize
+      && std::abs(p.y - center.y) <= halfSize
+      && std::abs(p.z - center.z) <= halfSize;
+}
+
+
+static Vector3 GetCenter(const AABB& aabb)
+{
+  return (aabb.min + aabb.max) * 0.5f;
+}
+
+
+static R32 GetExtent(const AABB& aabb)
+{
+  Vector3 e = (aabb.max - aabb.min) * 0.5f;
+  return std::max(e.x, std::max(e.y, e.z));
+}
+
+
+Octree::Octree(const Vector3& center, R32 halfSize, U32 maxDepth)
+  : m_freeProxy(kInvalidProxy)
+  , m_proxyCount(0)
+  , m_maxDepth(0)
+{
+  reset(center, halfSize, maxDepth);
+}
+
+
+void Octree::reset(const Vector3& center, R32 halfSize, U32 maxDepth)
+{
+  R_ASSERT(m_proxyCount == 0, "Octree must be empty to reset its bounds.\n");
+  m_nodes.clear();
+  m_freeNodes.clear();
+  m_maxDepth = std::min(maxDepth, kMaxDepth);
+
+  Node root;
+  root._center = center;
+  root._halfSize = halfSize;
+  root._parent = kNoNode;
+  std::fill(root._children, root._children + 8, kNoNode);
+  root._firstProxy = kInvalidProxy;
+  root._subtreeCount = 0;
+  root._depth = 0;
+  m_nodes.push_back(root);
+}
+
+
+void Octree::clear()
+{
+  Vector3 center = m_nodes[0]._center;
+  R32 halfSize = m_nodes[0]._halfSize;
+  m_proxies.clear();
+  m_freeProxy = kInvalidProxy;
+  m_proxyCount = 0;
+  reset(center, halfSize, m_maxDepth);
+}
+
+
+AABB Octree::getLooseBounds(U32 node) const
+{
+  const Node& n = m_nodes[node];
+  // Loose bounds are twice the size of the node.
+  Vector3 extent = Vector3(n._halfSize, n._halfSize, n._halfSize) * 2.0f;
+  AABB aabb;
+  aabb.min = n._center - extent;
+  aabb.max = n._center + extent;
+  return aabb;
+}
+
+
+U32 Octree::allocateNode(U32 parent, U32 octant)
+{
+  Node child;
+  R32 halfSize = m_nodes[parent]._halfSize * 0.5f;
+  child._center = m_nodes[parent]._center + Vector3(
+    (octant & 1) ? halfSize : -halfSize,
+    (octant & 2) ? halfSize : -halfSize,
+    (octant & 4) ? halfSize : -halfSize);
+  child._halfSize = halfSize;
+  child._parent = parent;
+  std::fill(child._children, child._children + 8, kNoNode);
+  child._firstProxy = kInvalidProxy;
+  child._subtreeCount = 0;
+  child._depth = m_nodes[parent]._depth + 1;
+
+  U32 idx;
+  if (!m_freeNodes.empty()) {
+    idx = m_freeNodes.back();
+    m_freeNodes.pop_back();
+    m_nodes[idx] = child;
+  } else {
+    idx = static_cast<U32>(m_nodes.size());
+    m_nodes.push_back(child);
+  }
+  m_nodes[parent]._children[octant] = idx;
+  return idx;
+}
+
+
+U32 Octree::findNode(const AABB& aabb)
+{
+  Vector3 center = GetCenter(aabb);
+  R32 extent = GetExtent(aabb);
+
+  U32 node = 0;
+  // Proxies centered outside of the world stay in the root.
+  if (!InsideNode(center, m_nodes[0]._center, m_nodes[0]._halfSize)) return node;
+
+  while (m_nodes[node]._depth < m_maxDepth) {
+    const Node& n = m_nodes[node];
+    // The child holding the center contains the proxy in its loose bounds,
+    // as long as the proxy is no bigger than the child.
+    if (extent > n._halfSize * 0.5f) break;
+    U32 octant = (center.x >= n._center.x ? 1 : 0)
+               | (center.y >= n._center.y ? 2 : 0)
+               | (center.z >= n._center.z ? 4 : 0);
+    U32 child = n._children[octant];
+    if (child == kNoNode) child = allocateNode(node, octant);
+    node = child;
+  }
+  return node;
+}
+
+
+void Octree::link(octree_proxy_t proxy, U32 node)
+{
+  Proxy& p = m_proxies[proxy];
+  Node& n = m_nodes[node];
+  p._node = node;
+  p._prev = kInvalidProxy;
+  p._next = n._firstProxy;
+  if (n._firstProxy != kInvalidProxy) m_proxies[n._firstProxy]._prev = proxy;
+  n._firstProxy = proxy;
+
+  for (U32 i = node; i != kNoNode; i = m_nodes[i]._parent) {
+    m_nodes[i]._subtreeCount++;
+  }
+}
+
+
+void Octree::unlink(octree_proxy_t proxy)
+{
+  Proxy& p = m_proxies[proxy];
+  if (p._prev != kInvalidProxy) m_proxies[p._prev]._next = p._next;
+  else m_nodes[p._node]._firstProxy = p._next;
+  if (p._next != kInvalidProxy) m_proxies[p._next]._prev = p._prev;
+
+  // Free nodes left with empty subtrees, so traversals never visit them. The root is kept.
+  U32 node = p._node;
+  while (node != kNoNode) {
+    Node& n = m_nodes[node];
+    U32 parent = n._parent;
+    if (--n._subtreeCount == 0 && parent != kNoNode) {
+      U32* children = m_nodes[parent]._children;
+      std::replace(children, children + 8, node, kNoNode);
+      m_freeNodes.push_back(node);
+    }
+    node = parent;
+  }
+  p._node = kNoNode;
+}
+
+
+octree_proxy_t Octree::insert(const AABB& aabb, void* pUserData)
+{
+  octree_proxy_t proxy;
+  if (m_freeProxy != kInvalidProxy) {
+    proxy = m_freeProxy;
+    m_freeProxy = m_proxies[proxy]._next;
+  } else {
+    proxy = static_cast<octree_proxy_t>(m_proxies.size());
+    m_proxies.push_back(Proxy());
+  }
+  Proxy& p = m_proxies[proxy];
+  p._aabb = aabb;
+  p._pUserData = pUserData;
+  link(proxy, findNode(aabb));
+  m_proxyCount++;
+  return proxy;
+}
+
+
+void Octree::move(octree_proxy_t proxy, const AABB& aabb)
+{
+  R_ASSERT(proxy < m_proxies.size() && m_proxies[proxy]._node != kNoNode, "Invalid octree proxy.\n");
+  Proxy& p = m_proxies[proxy];
+  p._aabb = aabb;
+
+  // Stay in place if the proxy would be placed in the same node again.
+  const Node& n = m_nodes[p._node];
+  Vector3 center = GetCenter(aabb);
+  R32 extent = GetExtent(aabb);
+  B32 deepest = (n._depth >= m_maxDepth) || (extent > n._halfSize * 0.5f);
+  B32 same;
+  if (p._node == 0) {
+    same = deepest || !InsideNode(center, n._center, n._halfSize);
+  } else {
+    same = deepest && (extent <= n._halfSize) && InsideNode(center, n._center, n._halfSize);
+  }
+  if (same) return;
+
+  unlink(proxy);
+  link(proxy, findNode(aabb));
+}
+
+
+void Octree::remove(octree_proxy_t proxy)
+{
+  R_ASSERT(proxy < m_proxies.size() && m_proxies[proxy]._node != kNoNode, "Invalid octree proxy.\n");
+  unlink(proxy);
+  Proxy& p = m_proxies[proxy];
+  p._pUserData = nullptr;
+  p._next = m_freeProxy;
+  m_freeProxy = proxy;
+  m_proxyCount--;
+}
+
+
+void Octree::addSubtree(U32 node, std::vector<octree_proxy_t>& results) const
+{
+  U32 stack[kMaxTraversalStack];
+  U32 top = 0;
+  stack[top++] = node;
+  while (top > 0) {
+    const Node& n = m_nodes[stack[--top]];
+    for (octree_proxy_t i = n._firstProxy; i != kInvalidProxy; i = m_proxies[i]._next) {
+      results.push_back(i);
+    }
+    for (U32 c = 0; c < 8; ++c) {
+      if (n._children[c] != kNoNode) stack[top++] = n._children[c];
+    }
+  }
+}
+
+
+void Octree::query(volume_test_t test, const void* pVolume, std::vector<octree_proxy_t>& results) const
+{
+  U32 stack[kMaxTraversalStack];
+  U32 top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    U32 node = stack[--top];
+    const Node& n = m_nodes[node];
+    if (n._subtreeCount == 0) continue;
+
+    // The root also holds proxies outside of the world bounds, so it can not be rejected.
+    if (node != 0) {
+      ViewFrustum::Result result = test(pVolume, getLooseBounds(node));
+      if (result == ViewFrustum::Result_Outside) continue;
+      if (result == ViewFrustum::Result_Inside) {
+        addSubtree(node, results);
+        continue;
+      }
+    }
+
+    for (octree_proxy_t i = n._firstProxy; i != kInvalidProxy; i = m_proxies[i]._next) {
+      if (test(pVolume, m_proxies[i]._aabb) != ViewFrustum::Result_Outside) {
+        results.push_back(i);
+      }
+    }
+    for (U32 c = 0; c < 8; ++c) {
+      if (n._children[c] != kNoNode) stack[top++] = n._children[c];
+    }
+  }
+}
+
+
+void Octree::queryFrustum(const ViewFrustum& frustum, std::vector<octree_proxy_t>& results) const
+{
+  query(TestFrustum, &frustum, results);
+}
+
+
+void Octree::querySphere(const Sphere& sphere, std::vector<octree_proxy_t>& results) const
+{
+  query(TestSphere, &sphere, results);
+}
+
+
+void Octree::queryAABB(const AABB& aabb, std::vector<octree_proxy_t>& results) const
+{
+  query(TestAABB, &aabb, results);
+}
+
+
+void Octree::queryRay(const Ray& ray, R32 maxDistance, std::vector<octree_proxy_t>& results) const
+{
+  RayVolume volume;
+  volume._origin = ray.Origin;
+  volume._maxDistance = maxDistance;
+  for (U32 i = 0; i < 3; ++i) {
+    R32 d = (&ray.Direction.x)[i];
+    // Large, but finite, so that an origin lying on a slab does not produce NaN.
+    (&volume._invDirection.x)[i] = std::abs(d) > 1e-20f ? 1.0f / d : (d < 0.0f ? -1e30f : 1e30f);
+  }
+  query(TestRay, &volume, results);
+}
+} // Recluse
@@ -7,12 +7,14 @@
 
 #include "Core/Types.hpp"
 #include "Component.hpp"
+#include "Scene/ResourceRegistry.hpp"
 
 #include <map>
 
 
 namespace Recluse {
 
+class MeshComponent;
 
 // Component responsible for handling animation playback, blending, and 
 // updating of game component features fom the animation engine.
@@ -23,17 +25,25 @@ public:
   AnimationComponent()
     : m_handle(nullptr)
     , m_currClip(nullptr) 
+    , m_pMesh(nullptr)
+    , m_targetWeight(1.0f)
+    , m_fadeRate(0.0f)
   {
   } 
 
-  // Add an animation clip to the component to playback in the future.
+  // Add an animation clip to the component to playback in the future. Clips from the resource
+  // registry are held, and so stay resident, for as long as the component has them.
   void addClip(AnimClip* clip, const std::string& name);
 
-  // Blend an animation to target weight over time in seconds.
+  // Blend an animation to target weight over time in seconds. Clips blend with the one played 
+  // back, and each other, by weight, so crossfading fades one in while fading the other out.
+  // Clips fading out to 0 are dropped, and once the clip played back has, the heaviest clip 
+  // blending in is played back in its place.
   void blendPlayback(const std::string& name, R32 targetWeight = 1.0f, R32 fadeLen = 0.3f);
   
   // getSignal to play back an animation clip with given name.
   // May also optionally specify at what time to play the animation [0,1] as the normalized time.
+  // Stops any clip blending in.
   void playback(const std::string& name, R32 rate = 1.0f, R32 atTime = 0.0f);
   
   // Check if component is playing back a clip.
@@ -64,9 +74,33 @@ public:
   // Get the current playback rate.
   R32                       getPlaybackRate() const;
 
+  // Mesh whose bounds, and cull bits, choose how often this animation updates. Without one, 
+  // the animation is always updated at full rate.
+  void                      setMeshComponent(MeshComponent* pMesh) { m_pMesh = pMesh; }
+
+  // Tell the animation engine how visible, and how large on screen, every animation is. Reads
+  // the cull bits and bounds meshes were left with last frame, so run it serially, before the 
+  // frame's Mesh and Animation stages start.
+  static void               UpdateLods();
+
 private:
+  // Clip blending in, or out, with the one played back. 
+  struct BlendState {
+    AnimClip*                         _pClip;
+    AnimClipState                     _state;
+    R32                               _targetWeight;
+    R32                               _fadeRate;      // weight per second.
+  };
+
   std::map<std::string, AnimClip*>    m_clips;
+  std::map<std::string, ResourceHandle<AnimClip> > m_clipHandles;
+  // Blend jobs point at these states, map nodes stay put as others come and go.
+  std::map<std::string, BlendState>   m_blends;
   AnimHandle*                         m_handle;
   AnimClip*                           m_currClip;
+  MeshComponent*                      m_pMesh;
+  // Weight the clip played back fades to.
+  R32                                 m_targetWeight;
+  R32                                 m_fadeRate;
 };
 } // Recluse
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "Core/Math/Vector3.hpp"
 #include "Core/Math/Quaternion.hpp"
 #include "Core/Memory/SmartPointer.hpp"
+#include "ComponentRegistry.hpp"
 #include <algorithm>
 #include <unordered_map>
 
@@ -18,41 +19,51 @@ namespace Recluse {
 typedef U64 component_t;
 class Transform;
 
-#define RCOMPONENT(cls) protected: static std::unordered_map<UUID64, cls*> _k ## cls ## s; \
+// Declares the registry of a component type, along with its updates. Components register with
+// REGISTER_COMPONENT, usually on initialize, and must unregister with UNREGISTER_COMPONENT on 
+// clean up.
+//
+// parallelUpdateComponents() splits the registry across the pool, so it may only be used by 
+// component types whose update() touches nothing but the component, and its own game object.
+// Work on shared state must be left to a serial pass, run after.
+#define RCOMPONENT(cls) protected: static ComponentRegistry<cls> _k ## cls ## s; \
     friend class GameObject; \
     static UUID64 kUID; \
     static component_t getUUID() { return std::hash<TChar*>()( #cls ); } \
     static const TChar* getName() { return #cls; } \
     static UUID64 generateUID() { UUID64 uid = kUID++; return uid; } \
     public: static void updateComponents() { \
-              for (auto& it : _k##cls##s) { \
-                cls* comp = it.second; \
+              for (size_t i = 0; i < _k##cls##s.size(); ++i) { \
+                cls* comp = _k##cls##s[i]; \
                 if (!comp->enabled()) continue; \
                 comp->update(); \
               } \
             } \
+            static void parallelUpdateComponents(ThreadPool* pPool, U32 batchSize = kComponentBatchSize) { \
+              _k##cls##s.parallelForEach(pPool, batchSize, [] (cls* comp) -> void { \
+                if (!comp->enabled()) return; \
+                comp->update(); \
+              }); \
+            } \
+            static size_t getComponentCount() { return _k##cls##s.size(); } \
     private:
 
 #define REGISTER_COMPONENT(cls, pComp) { \
-          m_componentUID = generateUID(); \
-          auto it = _k##cls##s.find(m_componentUID); \
-          if (it == _k##cls##s.end()) { \
-            _k##cls##s[m_componentUID] = pComp; \
+          if (m_componentHandle == kInvalidComponentHandle) { \
+            m_componentUID = generateUID(); \
+            m_componentHandle = _k##cls##s.add(pComp); \
           } \
        }
 
 #define UNREGISTER_COMPONENT(cls) { \
-          if (getOwner()) { \
-            UUID64 uuid = getUID(); \
-            auto it = _k##cls##s.find(uuid); \
-            if (it != _k##cls##s.end()) { \
-              _k##cls##s.erase(it); \
-            } \
+          if (m_componentHandle != kInvalidComponentHandle) { \
+            _k##cls##s.remove(m_componentHandle); \
+            m_componentHandle = kInvalidComponentHandle; \
           } \
         }
 
 
-#define DEFINE_COMPONENT_MAP(cls) std::unordered_map<UUID64, cls*> cls::_k##cls##s; \
+#define DEFINE_COMPONENT_MAP(cls) ComponentRegistry<cls> cls::_k##cls##s; \
                                   UUID64 cls::kUID = 0; 
                                 
     
@@ -79,7 +90,8 @@ public:
 
 protected:
   Component()
-    : m_pGameObjectOwner(nullptr)
+    : m_componentHandle(kInvalidComponentHandle)
+    , m_pGameObjectOwner(nullptr)
     , m_bEnabled(true) { }
 
   template<typename T>
@@ -127,6 +139,9 @@ protected:
 
   UUID64        m_componentUID; 
 
+  // Handle into the registry of the component type, while registered.
+  component_handle_t m_componentHandle;
+
 private:
   GameObject*   m_pGameObjectOwner;
   // Is component enabled? If so, the managers responsible for updating it will 
@@ -210,21 +225,27 @@ public:
   // Rotation of the transform in world space.
   Quaternion    _rotation;
 
-  void          serialize(IArchive& archive) override { }
-  void          deserialize(IArchive& archive) override { }
+  void          serialize(IArchive& archive) override;
+  void          deserialize(IArchive& archive) override;
 
   Matrix4       getLocalToWorldMatrix() const { return m_localToWorldMatrix; }
   Matrix4       getWorldToLocalMatrix() const { return m_worldToLocalMatrix; }
 
-  // Update transform that will be used by renderer. Called during scene graph traversal.
+  // Update transform that will be used by renderer. The engine updates all scene transforms
+  // through the TransformHierarchy instead, so this is only needed for objects outside of 
+  // the scene.
   void          update() override;
 
 protected:
+  // Recompute front, up, and right axes from the world rotation.
+  void          updateAxes();
 
   Matrix4       m_localToWorldMatrix;
   Matrix4       m_worldToLocalMatrix;
   Vector3       m_front;
   Vector3       m_up;
   Vector3       m_right;
+
+  friend class TransformHierarchy;
 };
 } // Recluse
\ No newline at end of file
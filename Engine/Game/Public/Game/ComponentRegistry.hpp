@@ -0,0 +1,104 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Exception.hpp"
+#include "Core/Thread/Threading.hpp"
+
+#include <vector>
+
+
+namespace Recluse {
+
+
+typedef U32 component_handle_t;
+
+
+const component_handle_t kInvalidComponentHandle = 0xFFFFFFFF;
+
+// Number of components updated per job, when updating in parallel.
+const U32 kComponentBatchSize = 128;
+
+
+// Sparse set of the registered components of one type. Components are packed into a dense
+// array, so updates walk contiguous memory instead of hash buckets. Each component is given a
+// stable handle, mapped to its place in the dense array through a sparse table, and removed by
+// moving the last component into its place. Freed handles are reused.
+//
+// Order of components is not kept. Components must not be added, or removed, while iterating
+// in parallel.
+template<typename T>
+class ComponentRegistry {
+public:
+  ComponentRegistry()
+    : m_freeHandle(kInvalidComponentHandle) { }
+
+  component_handle_t add(T* pComponent) {
+    component_handle_t handle;
+    if (m_freeHandle != kInvalidComponentHandle) {
+      handle = m_freeHandle;
+      m_freeHandle = m_sparse[handle];
+    } else {
+      handle = static_cast<component_handle_t>(m_sparse.size());
+      m_sparse.push_back(0);
+    }
+    m_sparse[handle] = static_cast<U32>(m_dense.size());
+    m_dense.push_back(pComponent);
+    m_denseHandles.push_back(handle);
+    return handle;
+  }
+
+  void remove(component_handle_t handle) {
+    R_ASSERT(contains(handle), "Invalid component handle.\n");
+    U32 index = m_sparse[handle];
+    U32 last = static_cast<U32>(m_dense.size() - 1);
+    if (index != last) {
+      m_dense[index] = m_dense[last];
+      m_denseHandles[index] = m_denseHandles[last];
+      m_sparse[m_denseHandles[index]] = index;
+    }
+    m_dense.pop_back();
+    m_denseHandles.pop_back();
+    m_sparse[handle] = m_freeHandle;
+    m_freeHandle = handle;
+  }
+
+  B32 contains(component_handle_t handle) const {
+    if (handle >= m_sparse.size()) return false;
+    U32 index = m_sparse[handle];
+    return index < m_dense.size() && m_denseHandles[index] == handle;
+  }
+
+  T* get(component_handle_t handle) const { return m_dense[m_sparse[handle]]; }
+
+  size_t size() const { return m_dense.size(); }
+  B32 empty() const { return m_dense.empty(); }
+
+  // Components by their place in the dense array, which changes as components are removed.
+  T* operator[](size_t index) const { return m_dense[index]; }
+
+  // Call func on each component, split into batches across the pool. Runs on the calling thread
+  // if no pool is given, or there are too few components to split.
+  template<typename Func>
+  void parallelForEach(ThreadPool* pPool, U32 batchSize, Func func) const {
+    U32 count = static_cast<U32>(m_dense.size());
+    if (!pPool || count <= batchSize) {
+      for (U32 i = 0; i < count; ++i) func(m_dense[i]);
+      return;
+    }
+
+    JobCounter counter;
+    pPool->ParallelFor(count, batchSize, [&] (U32 start, U32 end) -> void {
+      for (U32 i = start; i < end; ++i) func(m_dense[i]);
+    }, &counter);
+    pPool->WaitForCounter(&counter);
+  }
+
+private:
+  std::vector<T*>                 m_dense;
+  std::vector<component_handle_t> m_denseHandles;
+  // Dense index of each handle. Free handles hold the next free handle instead.
+  std::vector<U32>                m_sparse;
+  component_handle_t              m_freeHandle;
+};
+} // Recluse
@@ -3,6 +3,7 @@
 
 #include "Core/Types.hpp"
 #include "Core/Core.hpp"
+#include "Core/Thread/TaskGraph.hpp"
 #include "Core/Math/Common.hpp"
 #include "Core/Utility/Vector.hpp"
 #include "Core/Math/Matrix4.hpp"
@@ -16,6 +17,10 @@
 #include "Camera.hpp"
 #include "GameObject.hpp"
 #include "Component.hpp"
+#include "TransformHierarchy.hpp"
+#include "Visibility/Octree.hpp"
+#include "Visibility/FrustumCuller.hpp"
+#include "Visibility/OcclusionCuller.hpp"
 #include "LightComponent.hpp"
 #include "PointLightComponent.hpp"
 #include "AIComponent.hpp"
@@ -50,6 +55,7 @@ namespace Recluse {
 
 // Scene graph to push into the engine.
 class Scene;
+class WorldPartition;
 
 typedef void (*ControlInputCallback)();
 
@@ -143,6 +149,11 @@ public:
 
   Scene*                        getScene() { return m_pPushedScene; } 
 
+  // Stream cells of the world partition around the main camera, each frame, before any game 
+  // objects are updated. Pass nullptr to stop streaming. The partition is not owned by the engine.
+  void                          setWorldPartition(WorldPartition* pPartition) { m_pWorldPartition = pPartition; }
+  WorldPartition*               getWorldPartition() { return m_pWorldPartition; }
+
   R64                           GameMousePosX() const { return m_gameMouseX; }
   R64                           GameMousePosY() const { return m_gameMouseY; }
   void                          SetGameMouseX(R64 x) { m_gameMouseX = x; }
@@ -171,6 +182,16 @@ public:
   
   static size_t                 getMaxViewFrustumCount() { return kMaxViewFrustums; }
 
+  // Spatial index of mesh bounds, for gameplay queries. Safe to query after the "Mesh" stage 
+  // of the frame graph.
+  Octree&                       getVisibilityTree() { return m_visibilityTree; }
+
+  // Mesh bounds culled against every view frustum, each frame.
+  FrustumCuller&                getFrustumCuller() { return m_frustumCuller; }
+
+  // Occluders rasterized from the main camera, each frame, before render commands are pushed.
+  OcclusionCuller&              getOcclusionCuller() { return m_occlusionCuller; }
+
   void                          setEngineMode(EngineMode newMode) { m_engineMode = newMode; }
 
   EngineMode                    getEngineMode() const { return m_engineMode; }
@@ -189,6 +210,10 @@ public:
   const UserConfigParams& getGlobalUserConfigs() const { return m_globalUserConfigParams; }
   void setGlobalUserConfigs(const UserConfigParams& params) { m_globalUserConfigParams = params; }
 
+  // Frame graph of stages run each update. Stage timings of the last frame can be read from here.
+  TaskGraph&                    getFrameGraph() { return m_frameGraph; }
+  const std::vector<TaskStageTiming>& getFrameStageTimings() const { return m_frameGraph.getStageTimings(); }
+
   void readGraphicsConfig( GraphicsConfigParams& params );
   void readUserConfigs( UserConfigParams& config );
   void saveEngineConfig( GraphicsConfigParams& config );
@@ -199,8 +224,12 @@ private:
   void                          stop();
   void                          traverseScene(GameObjectActionCallback callback);
   void                          updateSunLight();
+  void                          buildFrameGraph();
+  void                          renderSubmit();
+  void                          cullMeshes();
 
   Scene*                        m_pPushedScene;
+  WorldPartition*               m_pWorldPartition;
   ControlInputCallback          m_pControlInputFunc;
   R64                           m_gameMouseX;
   R64                           m_gameMouseY;
@@ -212,7 +241,11 @@ private:
   B32                           m_stopping : 1;
   B32                           m_multiThreading : 1;
   B32                           m_bSignalLoadScene;
-  std::vector<std::thread>      m_workers;
+  TaskGraph                     m_frameGraph;
+  TransformHierarchy            m_transformHierarchy;
+  Octree                        m_visibilityTree;
+  FrustumCuller                 m_frustumCuller;
+  OcclusionCuller               m_occlusionCuller;
   ViewFrustum*                  m_frustums[kMaxViewFrustums];
   I32                           m_currFrustumCount;
   EngineMode                    m_engineMode;
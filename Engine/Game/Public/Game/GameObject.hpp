@@ -24,6 +24,26 @@ struct Collision;
 class Scene;
 
 
+// Generational handle to a GameObject allocated by the GameObjectManager. The index locates 
+// the object's slot in the manager, and the generation is bumped every time that slot is freed, 
+// so handles to destroyed objects go stale instead of dangling, even once the slot is reused.
+struct GameObjectHandle {
+  static const U32 kInvalidIndex = 0xffffffff;
+
+  U32 _index;
+  U32 _generation;
+
+  GameObjectHandle(U32 index = kInvalidIndex, U32 generation = 0)
+    : _index(index), _generation(generation) { }
+
+  B32 isNull() const { return _index == kInvalidIndex; }
+  U64 toU64() const { return (static_cast<U64>(_generation) << 32) | _index; }
+
+  bool operator==(const GameObjectHandle& o) const { return _index == o._index && _generation == o._generation; }
+  bool operator!=(const GameObjectHandle& o) const { return !(*this == o); }
+};
+
+
 // Always define this macro when inheriting GameObject (or any child objects that have
 // GameObject as it's hierarchial parent.
 #define R_GAME_OBJECT(cls)  \
@@ -40,10 +60,14 @@ class GameObject : public ISerializable {
   GameObject& operator=(const GameObject&) = delete;
 
   static U64 sGameObjectCount;
+  static U32 sHierarchyVersion;
 
 public:
 
   static U64 numGameObjectsCreated() { return sGameObjectCount; }
+  // Bumped whenever a parent child relationship in any scene graph changes.
+  static U32 hierarchyVersion() { return sHierarchyVersion; }
+  static void markHierarchyChanged() { sHierarchyVersion++; }
   static game_uuid_t globalId() { return hash_bytes("GameObject", strlen("GameObject")); }
 
   GameObject();
@@ -53,7 +77,7 @@ public:
 
   virtual void                        serialize(IArchive& archive) override;
   virtual void                        deserialize(IArchive& archive) override;
-  void                                setParent(GameObject* parent) { m_pParent = parent; }
+  void                                setParent(GameObject* parent) { m_pParent = parent; markHierarchyChanged(); }
   void                                setName(std::string name) { m_name = name; }
   void                                setTag(std::string tag) { m_tag = tag; }
 
@@ -92,6 +116,8 @@ public:
   std::string                         getName() const { return m_name; }
   std::string                         getTag() const { return m_tag; }
   game_uuid_t                         getId() const { return m_id; }
+  // Handle of this object, null if not allocated by the GameObjectManager.
+  GameObjectHandle                    getHandle() const { return m_handle; }
   size_t                              getChildrenCount() const { return m_children.size(); }
 
   Scene*                              getSceneOwner() { return m_pScene; }
@@ -126,6 +152,7 @@ private:
   Scene*                              m_pScene;
   Transform                           m_transform;
   game_uuid_t                         m_id;
+  GameObjectHandle                    m_handle;
   B32                                 m_bStarted;
 
   // Dispatch an event for collision. For Rigid Body use.
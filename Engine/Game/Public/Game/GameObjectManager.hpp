@@ -8,40 +8,85 @@
 
 #include "GameObject.hpp"
 #include <algorithm>
-#include <list>
 
 namespace Recluse {
 
 
-// TODO(): This will require a pool allocator instead of a list!
+// Game object storage. Objects live in fixed size chunks, each backed by a PoolAllocator, so
+// creating and destroying objects is O(1), never touches the heap once chunks are warmed up, 
+// and keeps live objects packed together in memory. Objects are referred to by generational 
+// GameObjectHandles, which can be checked for validity, instead of raw pointers that can dangle.
+// Not thread safe.
 class GameObjectManager {
   static U64            gGameObjectNumber;
 public:
-  GameObjectManager() { }
+  // Number of objects held by each chunk.
+  static const U32      kObjectsPerChunk = 256;
 
-  GameObject* allocate() {
-    m_GameObjects.push_back(std::move(GameObject()));
-    m_GameObjects.back().m_id = 
-      std::hash<game_uuid_t>()(gGameObjectNumber++);
-    return &m_GameObjects.back();
-  }
+  GameObjectManager();
+  ~GameObjectManager();
 
-  void      Deallocate(GameObject* object) {
-    // TODO():
-  }
+  // Create a new game object. Returns null if out of memory.
+  GameObject*           allocate();
 
-  size_t    NumOccupied() const { return m_GameObjects.size(); }
+  // Destroy the game object, invalidating all handles to it.
+  void                  Deallocate(GameObject* object);
+  void                  Deallocate(GameObjectHandle handle);
 
+  // Resolve a handle, returns null if the object has been destroyed.
+  GameObject*           get(GameObjectHandle handle);
+  B32                   isValid(GameObjectHandle handle) const;
 
-  void        clear() {
-    m_GameObjects.clear();
+  size_t                NumOccupied() const { return m_liveCount; }
+  size_t                Capacity() const { return m_chunks.size() * kObjectsPerChunk; }
+  size_t                NumChunks() const { return m_chunks.size(); }
+
+  // Iterate over all live objects, in memory order. Objects must not be created, or 
+  // destroyed, from within the callback.
+  template<typename Func>
+  void                  forEach(Func func) {
+    for (Chunk* chunk : m_chunks) {
+      if (!chunk->_liveCount) continue;
+      for (U32 i = 0; i < kObjectsPerChunk; ++i) {
+        if (chunk->_alive[i]) {
+          func(static_cast<GameObject*>(chunk->_pool.BlockAt(i)));
+        }
+      }
+    }
   }
 
+  // Destroy all game objects. Chunk memory is kept for reuse.
+  void                  clear();
+
+  // Destroy all game objects, and release chunk memory.
+  void                  release();
+
 private:
-  // TODO(): Replace with custom pool memory allocator.
-  std::list<GameObject>   m_GameObjects;
+  struct Chunk {
+    Chunk(void* mem, size_t sz)
+      : _pool(sizeof(GameObject), alignof(GameObject), sz, mem)
+      , _pMemory(mem)
+      , _liveCount(0)
+      , _inFreeList(true) { }
+
+    PoolAllocator       _pool;
+    void*               _pMemory;
+    U32                 _generations[kObjectsPerChunk];
+    B8                  _alive[kObjectsPerChunk];
+    U32                 _liveCount;
+    // Whether the chunk is in the list of chunks with free slots.
+    B32                 _inFreeList;
+  };
+
+  Chunk*                addChunk();
+  void                  destroy(U32 chunkIdx, U32 slot);
+
+  std::vector<Chunk*>   m_chunks;
+  // Chunks with at least one free slot, most recently freed last.
+  std::vector<U32>      m_freeChunks;
+  size_t                m_liveCount;
 };
 
 
 GameObjectManager& gGameObjectManager();
-} // Recluse
\ No newline at end of file
+} // Recluse
@@ -5,6 +5,10 @@
 #include "Game/Component.hpp"
 #include "Core/Math/AABB.hpp"
 #include "Renderer/Mesh.hpp"
+#include "Game/Visibility/Octree.hpp"
+#include "Game/Visibility/FrustumCuller.hpp"
+#include "Game/Visibility/OcclusionCuller.hpp"
+#include "Game/Scene/ResourceRegistry.hpp"
 
 #include "Animation/Skeleton.hpp"
 
@@ -21,13 +25,21 @@ protected:
 public:
   MeshComponent();
 
-  void            SetMeshRef(Mesh* pData) { m_pMeshRef = pData; }
+  // Meshes from the resource registry are held, and so stay resident, for as long as they are
+  // referenced here.
+  void            SetMeshRef(Mesh* pData);
   
   Mesh*           MeshRef() { return m_pMeshRef; }
 
-  // updates this mesh component instance frustum bit cull.
+  // updates this mesh component instance world bounds, and writes them into the frustum culler.
+  // Safe to run in parallel with other meshes. Frustum cull bits are then set by the engine, 
+  // once every mesh is updated.
   void            update() override;
 
+  // Register new meshes, and occluders, with the engine, and move every mesh in the visibility 
+  // tree. Serial pass, run after all meshes are updated.
+  static void     UpdateVisibilityProxies();
+
   void            EnableCulling(B32 enable) { m_allowCulling = enable; }
 
   inline B32      AllowCulling() const { return m_allowCulling; }
@@ -45,11 +57,32 @@ public:
   // Clear and reset all frustum bits to 0.
   void            ClearFrustumCullBits() { m_frustumCull &= 0; }
 
+  // Whether the engine frustum culls this mesh, and so sets its cull bits.
+  B32             HasCullSlot() const { return m_cullSlot != FrustumCuller::kInvalidSlot; }
+
+  // World bounds of the mesh, rotation included, as of the last update.
+  const AABB&     GetWorldAABB() const { return m_worldAABB; }
+
+  // Have this mesh hide others behind it, using the given low polygon stand in, which must lie
+  // within the mesh. Pass nullptr to stop occluding. The occluder mesh must outlive its use here.
+  void            SetOccluder(const OccluderMesh* pOccluder);
+
+  const OccluderMesh* GetOccluder() const { return m_pOccluder; }
+
 private:
 
-  void            UpdateFrustumCullBits();
+  void            UpdateVisibilityProxy();
+  void            RemoveVisibilityProxy();
+  void            UpdateOccluder();
+  void            RemoveOccluder();
 
   Mesh*           m_pMeshRef;
+  ResourceHandle<Mesh> m_meshHandle;
+  const OccluderMesh* m_pOccluder;
+  occluder_id_t   m_occluderId;
+  AABB            m_worldAABB;
+  octree_proxy_t  m_visibilityProxy;
+  cull_slot_t     m_cullSlot;
   B32             m_frustumCull;
   B32             m_allowCulling;
 
@@ -24,6 +24,10 @@ public:
     : LightComponent(LightComponent::POINT_LIGHT)
     , m_descriptor(nullptr) { }
 
+  // Push every enabled point light, and its debug mesh, to the renderer. Serial pass, run after 
+  // all point lights are updated, as update() only computes the light, and may run in parallel.
+  static void   SubmitLights();
+
   void  onInitialize(GameObject* owner) override;
   void  onCleanUp() override;
   void  update() override;
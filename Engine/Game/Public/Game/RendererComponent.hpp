@@ -7,6 +7,7 @@
 #include "Renderer/MaterialDescriptor.hpp"
 #include "Renderer/Mesh.hpp"
 #include "Renderer/MeshData.hpp"
+#include "Scene/ResourceRegistry.hpp"
 #include <unordered_map>
 
 
@@ -57,18 +58,23 @@ public:
 
   void signalClean() { m_bDirty = false; }
   
-  virtual void addMesh(Mesh* mesh, U32 idx = Mesh::kMeshUnknownValue) { 
-    if (idx == Mesh::kMeshUnknownValue) m_meshes.push_back(mesh);
-    else m_meshes[idx] = mesh; 
-  }
+  // Meshes from the resource registry are held, and so stay resident, for as long as they are
+  // drawn here.
+  virtual void addMesh(Mesh* mesh, U32 idx = Mesh::kMeshUnknownValue);
   
-  virtual void clearMeshes() { m_meshes.clear(); }
+  virtual void clearMeshes() { m_meshes.clear(); m_meshHandles.clear(); }
   Mesh* getMesh(size_t idx) { return m_meshes[idx]; }
   U32 getMeshCount() const { return static_cast<U32>(m_meshes.size()); }
   inline B32 allowAutoLod() const { return m_allowAutoLod; }
   void enableAutoLod(B32 enable) { m_allowAutoLod = enable; }
 
+  // Automatic level of detail picks the lowest detail whose error stays within this many pixels
+  // on screen.
+  void setLodPixelError(R32 pixels) { m_lodPixelError = pixels; }
+  R32 getLodPixelError() const { return m_lodPixelError; }
 
+
+  // Level of detail picked last update, bias included.
   R32 getCurrentLod() const { return m_currLod; }
   U32 getMorphIndex0() const { return m_morphIndex0; }
   U32 getMorphIndex1() const { return m_morphIndex1; }
@@ -79,10 +85,11 @@ public:
   virtual void setAnimationHandler(AnimHandle* anim) { m_pAnimHandle = anim; }
   virtual AnimHandle* getAnimHandle() { return m_pAnimHandle; }
 
-  virtual void setLodBias(R32 bias, U32 meshIdx = 0) { (void)(meshIdx); m_currLod = bias; }
-  virtual R32 getLodBias(U32 meshIdx = 0) const { (void)meshIdx; return m_currLod; }
+  // Levels of detail added to the one picked, automatically or not.
+  virtual void setLodBias(R32 bias, U32 meshIdx = 0) { (void)(meshIdx); m_lodBias = bias; }
+  virtual R32 getLodBias(U32 meshIdx = 0) const { (void)meshIdx; return m_lodBias; }
 
-  virtual void resize(U32 sz) { m_meshes.resize(sz); };
+  virtual void resize(U32 sz) { m_meshes.resize(sz); m_meshHandles.resize(sz); };
 
 protected:
 
@@ -91,13 +98,18 @@ protected:
   virtual void update() override { }
   void triggerDirty() { m_bDirty = true; }
   void updateLod(Transform* meshTransform);
+  U32 getMeshLod(const Mesh* pMesh, R32 bias) const;
 
   std::vector<Mesh*> m_meshes;
+  std::vector<ResourceHandle<Mesh> > m_meshHandles;
   B32 m_bDirty;
   U32 m_configs;
   B32 m_debugConfigs;
   B32 m_allowAutoLod;
   R32 m_currLod;
+  R32 m_lodBias;
+  R32 m_lodPixelError;
+  R32 m_lodPixelsPerUnit; // Size of one unit of the mesh on screen, at its current distance.
   I32 m_morphIndex0; // Morph index for binding.
   I32 m_morphIndex1; // Morph index for binding.
   AnimHandle* m_pAnimHandle;
@@ -179,6 +191,7 @@ protected:
   struct MeshNode {
     MeshDescriptor* _pMeshDescriptor;
     U32 parentId;
+    R32 _lodBias;
   };
   std::vector<MeshNode> m_perMeshDescriptors;
 };
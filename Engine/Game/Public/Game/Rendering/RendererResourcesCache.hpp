@@ -11,151 +11,95 @@
 #include "Renderer/Renderer.hpp"
 
 #include "Scene/ModelLoader.hpp"
+#include "Scene/ResourceRegistry.hpp"
 
 #include <unordered_map>
 
 namespace Recluse {
 
 
-class MeshCache {
-public:
-  static void       cleanUpAll() {
-    // TODO(): Automate cleaning up all materials within this cache.
-    for (auto& it : m_Cache) {
-      Mesh* mesh = it.second;
-      mesh->cleanUp(&gRenderer());
-      delete mesh;
-    }
-    m_Cache.clear();
-  }
-
-  static B32         cache(std::string name, Mesh* mesh) {
-    if (m_Cache.find(name) != m_Cache.end()) {
-      return false;
-    }
-    m_Cache[name] = mesh;
-    return true;
-  }
-
-  static B32         UnCache(std::string name, Mesh** out) {
-    auto it = m_Cache.find(name);
-    if (it != m_Cache.end()) {
-      Mesh* pMesh = it->second;
-      *out = pMesh;
-      m_Cache.erase(it);
-      return true;
-    }
+template<>
+struct ResourceTraits<Mesh> {
+  static const ResourceCategory kCategory = RESOURCE_MESH;
+  static void destroy(Mesh* pMesh) { pMesh->cleanUp(&gRenderer()); delete pMesh; }
+};
 
-    return false;
-  }
 
-  static B32         get(std::string name, Mesh** out) {
-    auto it = m_Cache.find(name);
-    if (it != m_Cache.end()) {
-      *out = it->second;
-      return true;
-    }
+template<>
+struct ResourceTraits<Material> {
+  static const ResourceCategory kCategory = RESOURCE_MATERIAL;
+  static void destroy(Material* pMaterial) { pMaterial->cleanUp(&gRenderer()); delete pMaterial; }
+};
 
-    return false;
-  }
 
-private:
-  static std::unordered_map<std::string, Mesh*> m_Cache;
+template<>
+struct ResourceTraits<ModelLoader::Model> {
+  static const ResourceCategory kCategory = RESOURCE_MODEL;
+  static void destroy(ModelLoader::Model* pModel) { delete pModel; }
 };
 
 
-class MaterialCache {
+// Access to resources of one type in the resource registry, by name or by asset id. Names are
+// hashed into ids on every call, code that looks resources up often should keep the id, as
+// returned by hashAssetName(), and pass that instead.
+template<typename T>
+class ResourceCache {
 public:
   static void       cleanUpAll() {
-    // TODO(): Automate cleaning up all materials within this cache.
-    for (auto& it : m_Cache) {
-      Material* material = it.second;
-      material->cleanUp(&gRenderer());
-      delete material;
-    }
-    m_Cache.clear();
+    gResourceRegistry().clear(ResourceTraits<T>::kCategory);
   }
 
-  static B32         cache(std::string name, Material* mat) {
-    if (m_Cache.find(name) != m_Cache.end()) {
-      return false;
-    }
-    m_Cache[name] = mat;
-    return true;
+  // Bytes is what the resource costs against its category's budget.
+  static B32         cache(std::string name, T* resource, U64 bytes = 0) {
+    return cache(gResourceRegistry().intern(name), resource, bytes);
   }
 
-  static B32         UnCache(std::string name, Material** out) {
-    auto it = m_Cache.find(name);
-    if (it != m_Cache.end()) {
-      Material* pMat = it->second;
-      *out = pMat;
-      m_Cache.erase(it);
-     return true;
-    }
-
-    return false;
+  static B32         cache(AssetId id, T* resource, U64 bytes = 0) {
+    return gResourceRegistry().add(id, resource, bytes);
   }
 
-  static B32         get(std::string name, Material** out) {
-    auto it = m_Cache.find(name);
-    if (it != m_Cache.end()) {
-      *out = it->second;
-      return true;
-    }
-
-    return false;
+  static B32         UnCache(std::string name, T** out) {
+    return UnCache(hashAssetName(name), out);
   }
 
-private:
-  static std::unordered_map<std::string, Material*> m_Cache;
-};
-
+  static B32         UnCache(AssetId id, T** out) {
+    T* pResource = gResourceRegistry().detach<T>(id);
+    if (!pResource) return false;
+    *out = pResource;
+    return true;
+  }
 
-class ModelCache {
-public:
-  static void       cleanUpAll() {
-    // TODO(): Automate cleaning up all materials within this cache.
-    for (auto& it : m_Cache) {
-      ModelLoader::Model* model = it.second;
-      delete model;
-    }
-    m_Cache.clear();
+  static B32         get(std::string name, T** out) {
+    return get(hashAssetName(name), out);
   }
 
-  static B32         cache(std::string name, ModelLoader::Model* model) {
-    if (m_Cache.find(name) != m_Cache.end()) {
-      return false;
-    }
-    m_Cache[name] = model;
+  static B32         get(AssetId id, T** out) {
+    T* pResource = gResourceRegistry().find<T>(id);
+    if (!pResource) return false;
+    *out = pResource;
     return true;
   }
 
-  static B32         UnCache(std::string name, ModelLoader::Model** out) {
-    auto it = m_Cache.find(name);
-    if (it != m_Cache.end()) {
-      ModelLoader::Model* pMod = it->second;
-      *out = pMod;
-      m_Cache.erase(it);
-      return true;
-    }
-
-    return false;
+  // Keep the resource from being evicted, for as long as the handle lives.
+  static ResourceHandle<T> acquire(std::string name) {
+    return acquire(hashAssetName(name));
   }
 
-  static B32         get(std::string name, ModelLoader::Model** out) {
-    auto it = m_Cache.find(name);
-    if (it != m_Cache.end()) {
-      *out = it->second;
-      return true;
-    }
+  static ResourceHandle<T> acquire(AssetId id) {
+    return gResourceRegistry().acquire<T>(id);
+  }
 
-    return false;
+  static ResourceHandle<T> acquire(const T* resource) {
+    return gResourceRegistry().acquire<T>(resource);
   }
-private:
-  static std::unordered_map<std::string, ModelLoader::Model* > m_Cache;
 };
 
 
+typedef ResourceCache<Mesh>                 MeshCache;
+typedef ResourceCache<Material>             MaterialCache;
+typedef ResourceCache<ModelLoader::Model>   ModelCache;
+
+
 class ResourceManager {
 public:
   
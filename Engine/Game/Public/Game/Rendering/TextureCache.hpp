@@ -5,15 +5,27 @@
 #include "Core/Serialize.hpp"
 
 #include "Renderer/TextureType.hpp"
-#include <unordered_map>
+#include "Scene/ResourceRegistry.hpp"
 
 namespace Recluse {
 
 
-typedef size_t   tcache_t;
+template<>
+struct ResourceTraits<Texture2D> {
+  static const ResourceCategory kCategory = RESOURCE_TEXTURE;
+  static void destroy(Texture2D* pTexture);
+};
+
+
+template<>
+struct ResourceTraits<TextureSampler> {
+  static const ResourceCategory kCategory = RESOURCE_SAMPLER;
+  static void destroy(TextureSampler* pSampler);
+};
 
 
-// Texture cache, to store textures created by renderer.
+// Texture cache, to store textures created by renderer. Textures live in the resource registry,
+// by the hash of their name, or by their UUID when cached without one.
 class TextureCache {
   TextureCache();
   ~TextureCache();
@@ -26,8 +38,9 @@ public:
     Cache_Not_Found = -4
   };
 
-  // Cache the texture2D into this data structure.
-  static CacheResult                cache(Texture2D* texture, std::string& name = std::string());
+  // Cache the texture2D into this data structure. Bytes is what the texture costs against the
+  // texture budget.
+  static CacheResult                cache(Texture2D* texture, const std::string& name = std::string(), U64 bytes = 0);
 
 #if 1
   // Get the specified texture 2d from cache.
@@ -41,24 +54,19 @@ public:
   static void                       cleanUpAll();
 
   // Get the number of textures in cache.
-  static size_t                     CacheCount() { return sCache.size(); }
-
-private:
-  static std::unordered_map<tcache_t, Texture2D*>  sCache;
+  static size_t                     CacheCount() { return gResourceRegistry().getStats(RESOURCE_TEXTURE)._resident; }
 };
 
 
 class SamplerCache {
 public:
+  // Samplers live in the resource registry by their UUID.
   static void cache(TextureSampler* pSampler);
 #if 0
   static void get(std::string& name, TextureSampler** out);
   static void UnCache(std::string& name, TextureSampler** out);
 #endif
   static void           cleanUpAll();
-  static size_t         CacheCount() { return sCache.size(); }
-
-private:
-  static std::unordered_map<UUID64, TextureSampler*> sCache;
+  static size_t         CacheCount() { return gResourceRegistry().getStats(RESOURCE_SAMPLER)._resident; }
 };
 } // Recluse
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "Animation/Skeleton.hpp"
 
 #include "Core/Types.hpp"
+#include "Core/Exception.hpp"
 
 #include "Game/Rendering/RendererResourcesCache.hpp"
 
@@ -14,52 +15,58 @@
 namespace Recluse {
 
 
+template<>
+struct ResourceTraits<AnimClip> {
+  static const ResourceCategory kCategory = RESOURCE_ANIM_CLIP;
+  static void destroy(AnimClip* pClip) { delete pClip; }
+};
+
+
 class AnimAssetManager {
 public:
   static void          cleanUpAll() {
-    for (auto& clip : kClips) {
-      delete clip.second;
-    }
-    kClips.clear();
+    gResourceRegistry().clear(RESOURCE_ANIM_CLIP);
   }
   
-  static void           cache(std::string name, AnimClip* clip) {
-    if (!clip) return;
-    kClips[name] = clip;
+  // Replaces a different clip of the same name, unless that one is still referenced. Caching
+  // a clip that is already cached under the name does nothing. The clip stays with the caller
+  // if it could not be cached.
+  static B32            cache(std::string name, AnimClip* clip, U64 bytes = 0) {
+    if (!clip) return false;
+    AssetId id = gResourceRegistry().intern(name);
+    AnimClip* pCached = gResourceRegistry().find<AnimClip>(id);
+    if (pCached == clip) return true;
+    if (pCached) gResourceRegistry().destroy(id);
+    if (!gResourceRegistry().add(id, clip, bytes)) {
+      R_DEBUG(rWarning, "Animation clip " + name + " is in use, and could not be replaced.\n");
+      return false;
+    }
+    return true;
   }
 
   static AnimClip*           uncache(std::string name) {
-    AnimClip* clip = nullptr;
-    auto it = kClips.find(name);
-    if (it != kClips.end()) {
-      clip = it->second;
-      kClips.erase(it);
-    }
-    return clip;
+    return uncache(hashAssetName(name));
+  }
+
+  static AnimClip*           uncache(AssetId id) {
+    return gResourceRegistry().detach<AnimClip>(id);
   }
 
   static AnimClip*      get(std::string name) {
-    AnimClip* clip = nullptr;
-    auto it = kClips.find(name);
-    if (it != kClips.end()) {
-      clip = it->second;
-    }
-    return clip;
+    return get(hashAssetName(name));
+  }
+
+  static AnimClip*      get(AssetId id) {
+    return gResourceRegistry().find<AnimClip>(id);
   }
-private:
-  static std::unordered_map<std::string, AnimClip*> kClips;
 };
 
 
 class AssetManager {
 public:
+  // Models go first, since they hold on to the meshes, materials and textures they use.
   static void cleanUpAssets() {
-    ModelCache::cleanUpAll();
-    AnimAssetManager::cleanUpAll();
-    MaterialCache::cleanUpAll();
-    MeshCache::cleanUpAll();
-    TextureCache::cleanUpAll();
-    SamplerCache::cleanUpAll();
+    gResourceRegistry().clearAll();
   }
 };
 } // Recluse
\ No newline at end of file
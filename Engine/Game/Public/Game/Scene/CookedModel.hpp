@@ -0,0 +1,307 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+
+#include "Animation/Clip.hpp"
+#include "Renderer/Vertex.hpp"
+
+#include <string>
+
+
+namespace Recluse {
+
+
+// Cooked model format. Models are converted offline into a single binary file, made of blocks
+// of fixed size records, so the runtime can memory map the file and hand vertex, index,
+// texel and pose data to the engine as is, instead of parsing it element by element.
+//
+// Records refer to each other by index, and to names through the string block. Vertex blocks
+// hold engine structures directly, so the header records their sizes, and files cooked by a
+// build with a different layout are refused.
+
+const U32 kCookedModelMagic = 0x4C444D52; // RMDL
+const U32 kCookedModelVersion = 7;
+
+// Alignment of every block, and of each mesh's vertices within the vertex block.
+const U32 kCookedBlockAlignment = 64;
+
+const I32 kCookedNone = -1;
+
+
+enum CookedBlockType {
+  COOKED_BLOCK_STRINGS,
+  COOKED_BLOCK_NODES,
+  COOKED_BLOCK_SAMPLERS,
+  COOKED_BLOCK_TEXTURES,
+  COOKED_BLOCK_TEXELS,
+  COOKED_BLOCK_MATERIALS,
+  COOKED_BLOCK_MESHES,
+  COOKED_BLOCK_PRIMITIVES,
+  COOKED_BLOCK_MORPH_TARGETS,
+  COOKED_BLOCK_VERTICES,
+  COOKED_BLOCK_MORPH_VERTICES,
+  COOKED_BLOCK_INDICES,
+  COOKED_BLOCK_SKELETONS,
+  COOKED_BLOCK_JOINTS,
+  COOKED_BLOCK_CLIPS,
+  COOKED_BLOCK_TRACKS,
+  COOKED_BLOCK_KEY_TIMES,
+  COOKED_BLOCK_KEY_VALUES,
+  COOKED_BLOCK_MORPH_WEIGHTS,
+  COOKED_BLOCK_MESHLETS,
+  COOKED_BLOCK_MESHLET_VERTICES,
+  COOKED_BLOCK_MESHLET_TRIANGLES,
+  COOKED_BLOCK_LODS,
+  COOKED_BLOCK_COUNT
+};
+
+
+struct CookedBlock {
+  // Byte offset from the start of the file, and size in bytes.
+  U64                 _offset;
+  U64                 _size;
+};
+
+
+struct CookedModelHeader {
+  U32                 _magic;
+  U32                 _version;
+  // ModelResultBits found while importing the source.
+  U32                 _resultBits;
+  U32                 _staticVertexSize;
+  U32                 _skinnedVertexSize;
+  U64                 _size;
+  CookedBlock         _blocks[COOKED_BLOCK_COUNT];
+};
+
+
+struct CookedString {
+  U32                 _offset;
+  U32                 _length;
+};
+
+
+struct CookedNode {
+  U32                 _id;
+  U32                 _parentId;
+  U32                 _nodeConfig;
+  U32                 _meshId;
+};
+
+
+struct CookedSampler {
+  U32                 _addrU;
+  U32                 _addrV;
+  U32                 _addrW;
+  U32                 _minFilter;
+  U32                 _maxFilter;
+  U32                 _mipmapMode;
+  U32                 _borderColor;
+  U32                 _enableAnisotropy;
+  R32                 _maxAniso;
+  R32                 _minLod;
+  R32                 _maxLod;
+  U32                 _unnormalizedCoordinates;
+};
+
+
+// RGBA8 texels, in the texel block.
+struct CookedTexture {
+  CookedString        _name;
+  U32                 _width;
+  U32                 _height;
+  U64                 _texelOffset;
+  U64                 _texelSize;
+};
+
+
+enum CookedMaterialTexture {
+  COOKED_MATERIAL_ALBEDO,
+  COOKED_MATERIAL_NORMAL,
+  COOKED_MATERIAL_ROUGH_METAL,
+  COOKED_MATERIAL_AO,
+  COOKED_MATERIAL_EMISSIVE,
+  COOKED_MATERIAL_TEXTURE_COUNT
+};
+
+
+enum CookedMaterialFlags {
+  COOKED_MATERIAL_BASE_COLOR_BIT = (1 << 0),
+  COOKED_MATERIAL_TRANSPARENT_BIT = (1 << 1),
+  COOKED_MATERIAL_OPACITY_BIT = (1 << 2)
+};
+
+
+struct CookedMaterial {
+  CookedString        _name;
+  U32                 _flags;
+  R32                 _baseColor[4];
+  R32                 _roughness;
+  R32                 _metallic;
+  R32                 _opacity;
+  // Texture, and sampler, of each slot, or kCookedNone.
+  I32                 _textures[COOKED_MATERIAL_TEXTURE_COUNT];
+  I32                 _samplers[COOKED_MATERIAL_TEXTURE_COUNT];
+};
+
+
+enum CookedMeshFlags {
+  COOKED_MESH_SKINNED_BIT = (1 << 0)
+};
+
+
+// Vertices are StaticVertex, or SkinnedVertex for skinned meshes. Indices are relative to the
+// first vertex of the mesh. Indices of the lower levels of detail follow right after the
+// mesh's own indices, so the whole chain uploads as one index buffer.
+struct CookedMesh {
+  CookedString        _name;
+  U32                 _flags;
+  I32                 _skeleton;
+  U64                 _vertexOffset;
+  U32                 _vertexCount;
+  U32                 _firstIndex;
+  U32                 _indexCount;
+  U32                 _firstPrimitive;
+  U32                 _primitiveCount;
+  U32                 _firstMorphTarget;
+  U32                 _morphTargetCount;
+  // Meshlets are only built when asked for, otherwise these are empty. Triangles count bytes.
+  U32                 _firstMeshlet;
+  U32                 _meshletCount;
+  U32                 _firstMeshletVertex;
+  U32                 _meshletVertexCount;
+  U32                 _firstMeshletTriangle;
+  U32                 _meshletTriangleCount;
+  U32                 _lodIndexCount;
+  U32                 _firstLod;
+  U32                 _lodCount;
+  R32                 _min[3];
+  R32                 _max[3];
+};
+
+
+// Index range relative to the first index of its mesh, and meshlet range relative to the
+// first meshlet of its mesh.
+struct CookedPrimitive {
+  U32                 _firstIndex;
+  U32                 _indexCount;
+  I32                 _material;
+  U32                 _configs;
+  U32                 _firstMeshlet;
+  U32                 _meshletCount;
+  R32                 _min[3];
+  R32                 _max[3];
+};
+
+
+// Meshlet vertices are U32 mesh vertex indices, and triangles 3 bytes indexing into the
+// meshlet's vertices. Offsets are relative to the first meshlet vertex, and triangle byte, of
+// the mesh. See MeshOptimizer::MeshletBounds for the cone test.
+struct CookedMeshlet {
+  U32                 _vertexOffset;
+  U32                 _triangleOffset;
+  U32                 _vertexCount;
+  U32                 _triangleCount;
+  R32                 _center[3];
+  R32                 _radius;
+  R32                 _coneAxis[3];
+  R32                 _coneCutoff;
+};
+
+
+// A lower level of detail of a mesh, starting from level 1. Its primitives index past the
+// mesh's own indices. Error is how far, in mesh units, the simplified surface may be from the
+// original, for choosing a level by its size on screen.
+struct CookedLod {
+  U32                 _firstPrimitive;
+  U32                 _primitiveCount;
+  R32                 _error;
+};
+
+
+struct CookedMorphTarget {
+  U32                 _firstVertex;
+  U32                 _vertexCount;
+};
+
+
+struct CookedSkeleton {
+  CookedString        _name;
+  U32                 _firstJoint;
+  U32                 _jointCount;
+  U32                 _rootInJoints;
+  R32                 _rootInvTransform[16];
+};
+
+
+struct CookedJoint {
+  CookedString        _name;
+  R32                 _invBindPose[16];
+  U32                 _parent;
+  U32                 _id;
+};
+
+
+// Keys of a channel. Times index the key time block. Values index the key value block, in
+// U16s, _keyWidth per key, as AnimChannel holds them along with the range they were quantized
+// into. Morph weights index the morph weight block instead, in R32s, one per target.
+struct CookedChannel {
+  U32                 _firstKey;
+  U32                 _keyCount;
+  U32                 _firstValue;
+  U32                 _keyWidth;
+  R32                 _rangeMin[3];
+  R32                 _rangeExtent[3];
+};
+
+
+// Keys of one animated node, per AnimChannelType.
+struct CookedTrack {
+  U32                 _nodeId;
+  CookedChannel       _channels[ANIM_CHANNEL_COUNT];
+};
+
+
+struct CookedClip {
+  CookedString        _name;
+  R32                 _duration;
+  R32                 _fps;
+  U32                 _looping;
+  U32                 _firstTrack;
+  U32                 _trackCount;
+  U32                 _morphTargetCount;
+  CookedChannel       _morphs;
+};
+
+
+// Read only view of a cooked model in memory, usually a mapped file. The view does not own
+// the data.
+class CookedModelView {
+public:
+  CookedModelView()
+    : m_pData(nullptr), m_size(0) { }
+
+  // Check the header, and that every block and record range lies within the data. Returns
+  // false for data that is not a cooked model, or was cooked with a different layout.
+  B32                       open(const U8* pData, size_t size);
+
+  const CookedModelHeader&  getHeader() const { return *reinterpret_cast<const CookedModelHeader*>(m_pData); }
+  const U8*                 getBytes(CookedBlockType type) const { return m_pData + getHeader()._blocks[type]._offset; }
+  U64                       getByteSize(CookedBlockType type) const { return getHeader()._blocks[type]._size; }
+
+  template<typename T>
+  const T*                  getBlock(CookedBlockType type) const { return reinterpret_cast<const T*>(getBytes(type)); }
+
+  template<typename T>
+  U32                       getCount(CookedBlockType type) const { return static_cast<U32>(getByteSize(type) / sizeof(T)); }
+
+  std::string               getString(const CookedString& str) const;
+
+private:
+  B32                       validate() const;
+
+  const U8*                 m_pData;
+  size_t                    m_size;
+};
+} // Recluse
@@ -0,0 +1,121 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+
+#include <vector>
+
+
+namespace Recluse {
+namespace MeshOptimizer {
+
+
+// Size of the post transform vertex cache, as simulated when measuring.
+const U32 kCacheSize = 16;
+
+// Meshlet limits, sized for mesh shading and cluster culling.
+const U32 kMaxMeshletVertices = 64;
+const U32 kMaxMeshletTriangles = 124;
+
+// Overdraw ordering may give up this much of the vertex cache efficiency.
+const R32 kOverdrawThreshold = 1.05f;
+
+
+// Vertex data, with the given stride in bytes. Meshes may split vertices across several
+// streams, such as morph targets, that must all be remapped together.
+struct VertexStream {
+  const void*   _data;
+  size_t        _stride;
+};
+
+
+// ACMR is the average number of cache misses per triangle, from 0.5, at best, to 3. ATVR is
+// the number of cache misses per vertex, where 1 means every vertex is transformed once.
+struct CacheStats {
+  R32           _acmr;
+  R32           _atvr;
+};
+
+
+// Offsets into the meshlet vertex, and triangle, arrays. Triangles are 3 bytes each, indexing
+// into the meshlet's vertices.
+struct Meshlet {
+  U32           _vertexOffset;
+  U32           _triangleOffset;
+  U32           _vertexCount;
+  U32           _triangleCount;
+};
+
+
+// Bounding sphere, and normal cone, of a meshlet. A meshlet faces away from a camera at
+// position p, and can be culled, when
+//   dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius
+struct MeshletBounds {
+  R32           _center[3];
+  R32           _radius;
+  R32           _coneAxis[3];
+  R32           _coneCutoff;
+};
+
+
+// Simulate a FIFO cache over the index buffer.
+CacheStats      analyzeVertexCache(const U32* indices, size_t indexCount, size_t vertexCount,
+                                   U32 cacheSize = kCacheSize);
+
+// Build a remap table that merges vertices that are identical in every stream. Vertices are
+// numbered in order of first use, and unused vertices are mapped to kUnusedVertex. Returns
+// the number of unique vertices.
+const U32 kUnusedVertex = 0xffffffff;
+size_t          generateVertexRemap(U32* remap, const U32* indices, size_t indexCount,
+                                    size_t vertexCount, const VertexStream* streams, U32 streamCount);
+
+// Apply a remap table. Indices may be remapped in place, vertices may not.
+void            remapIndices(U32* dst, const U32* indices, size_t indexCount, const U32* remap);
+void            remapVertices(void* dst, const void* vertices, size_t vertexCount, size_t stride,
+                              const U32* remap);
+
+// Reorder triangles for the post transform cache, using Forsyth's linear speed algorithm.
+// dst may alias indices.
+void            optimizeVertexCache(U32* dst, const U32* indices, size_t indexCount, size_t vertexCount);
+
+// Reorder clusters of triangles, from a cache optimized index buffer, so that outer facing
+// clusters draw first. ACMR grows by at most threshold, if no ordering keeps within it the
+// cache order is kept. Positions are 3 floats, at the start of every stride bytes. dst may not
+// alias indices.
+void            optimizeOverdraw(U32* dst, const U32* indices, size_t indexCount,
+                                 const void* positions, size_t positionStride, size_t vertexCount,
+                                 R32 threshold = kOverdrawThreshold);
+
+// Build a remap table that orders vertices by first use, for fetch locality. Returns the
+// number of vertices used.
+size_t          optimizeVertexFetchRemap(U32* remap, const U32* indices, size_t indexCount,
+                                         size_t vertexCount);
+
+// Split triangles, in order, into meshlets. Returns the number of meshlets appended.
+size_t          buildMeshlets(std::vector<Meshlet>& meshlets,
+                              std::vector<U32>& meshletVertices,
+                              std::vector<U8>& meshletTriangles,
+                              const U32* indices, size_t indexCount, size_t vertexCount,
+                              U32 maxVertices = kMaxMeshletVertices,
+                              U32 maxTriangles = kMaxMeshletTriangles);
+
+// Simplify triangles, by collapsing edges in order of quadric error, down to targetIndexCount
+// indices, or until no collapse stays within targetError, in position units. Vertices never
+// move, so the result indexes the same vertices. Open borders only collapse along the border,
+// and seams, where copies of a position differ in attributes, only along the seam. Attributes
+// are attributeCount floats at the start of every attributeStride bytes, weighted so that
+// collapses across them cost more. Returns the index count, and the error of the result in
+// pResultError. dst may alias indices.
+size_t          simplify(U32* dst, const U32* indices, size_t indexCount,
+                         const void* positions, size_t positionStride, size_t vertexCount,
+                         size_t targetIndexCount, R32 targetError, R32* pResultError = nullptr,
+                         const void* attributes = nullptr, size_t attributeStride = 0,
+                         const R32* attributeWeights = nullptr, U32 attributeCount = 0);
+
+// Bounds of a meshlet. Normals follow counter clockwise winding.
+MeshletBounds   computeMeshletBounds(const Meshlet& meshlet,
+                                     const U32* meshletVertices,
+                                     const U8* meshletTriangles,
+                                     const void* positions, size_t positionStride);
+} // MeshOptimizer
+} // Recluse
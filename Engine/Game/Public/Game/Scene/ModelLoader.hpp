@@ -35,8 +35,26 @@ enum ModelResult {
 };
 
 
+// Processing done on imported meshes, before they are cooked.
+enum ImportOption {
+  Import_None = 0,
+  // Merge duplicate vertices, and reorder for the vertex cache, overdraw and vertex fetch.
+  Import_OptimizeMeshes = (1 << 0),
+  // Split primitives into meshlets, with bounding spheres and normal cones.
+  Import_BuildMeshlets = (1 << 1),
+  // Simplify meshes into a chain of lower levels of detail.
+  Import_GenerateLods = (1 << 2),
+  // Remove animation keys that interpolation rebuilds, within the clip compressor's error
+  // bounds. Keys are quantized either way.
+  Import_ReduceAnimationKeys = (1 << 3)
+};
+
+
 using ModelResultBits = U32;
 using ModelConfigBits = U32;
+using ImportOptionBits = U32;
+
+const ImportOptionBits kDefaultImportOptions = Import_OptimizeMeshes | Import_GenerateLods | Import_ReduceAnimationKeys;
 using NodeId = U32;
 using NodeChildren = std::vector<NodeId>;
 
@@ -66,7 +84,13 @@ struct Model {
 // This will also store the model data in ModelCache, under the name of the file.
 // ex. path/to/Apple.gltf 
 // name = Apple
+// Cooked models, with the .rmdl extension, are mapped into memory instead of parsed.
 ModelResultBits load(const std::string filename);
+
+// Convert a source model into the cooked format, see Scene/CookedModel.hpp, and write it to
+// destination. Does not create any gpu resources, so it may be run offline by tools.
+ModelResultBits cook(const std::string source, const std::string destination,
+                     ImportOptionBits options = kDefaultImportOptions);
 ModelResultBits freeModel(Model** model);
  
 // Create a new model from an existing one, with it's own resources.
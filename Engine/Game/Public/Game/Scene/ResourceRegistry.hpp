@@ -0,0 +1,301 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace Recluse {
+
+
+// Asset names are hashed into 64 bit ids once, so that lookups only ever compare ids.
+typedef U64 AssetId;
+
+const AssetId kNoAssetId = 0;
+
+// Hash a name into its asset id. Does not intern the name.
+AssetId hashAssetName(const std::string& name);
+
+
+// Categories are destroyed in this order when the registry is cleared, so that models go
+// before the meshes and materials they use, and materials before their textures.
+enum ResourceCategory {
+  RESOURCE_MODEL,
+  RESOURCE_ANIM_CLIP,
+  RESOURCE_MATERIAL,
+  RESOURCE_MESH,
+  RESOURCE_TEXTURE,
+  RESOURCE_SAMPLER,
+  RESOURCE_CATEGORY_COUNT
+};
+
+
+// How the registry keeps a type of resource. Specialize for every type stored in it, with
+//   static const ResourceCategory kCategory;
+//   static void destroy(T* pResource);
+template<typename T>
+struct ResourceTraits;
+
+
+struct ResourceStats {
+  // Bytes of every resident resource, and the budget they are trimmed down to.
+  U64                 _bytes;
+  U64                 _budget;
+  U32                 _resident;
+  // Resources held by at least one handle, that are never evicted.
+  U32                 _referenced;
+  U64                 _hits;
+  U64                 _misses;
+  U64                 _evictions;
+};
+
+
+class ResourceRegistry;
+
+
+// Counted reference to a registered resource. A resource is only evicted once no handle, or
+// other resource depending on it, holds it.
+template<typename T>
+class ResourceHandle {
+public:
+  ResourceHandle()
+    : m_pRegistry(nullptr), m_pResource(nullptr), m_id(kNoAssetId), m_slot(0), m_generation(0) { }
+
+  ResourceHandle(const ResourceHandle& other)
+    : m_pRegistry(other.m_pRegistry), m_pResource(other.m_pResource), m_id(other.m_id)
+    , m_slot(other.m_slot), m_generation(other.m_generation) {
+    retain();
+  }
+
+  ResourceHandle(ResourceHandle&& other)
+    : m_pRegistry(other.m_pRegistry), m_pResource(other.m_pResource), m_id(other.m_id)
+    , m_slot(other.m_slot), m_generation(other.m_generation) {
+    other.m_pRegistry = nullptr;
+    other.m_pResource = nullptr;
+    other.m_id = kNoAssetId;
+  }
+
+  ~ResourceHandle() { release(); }
+
+  ResourceHandle& operator=(ResourceHandle other) {
+    std::swap(m_pRegistry, other.m_pRegistry);
+    std::swap(m_pResource, other.m_pResource);
+    std::swap(m_id, other.m_id);
+    std::swap(m_slot, other.m_slot);
+    std::swap(m_generation, other.m_generation);
+    return *this;
+  }
+
+  void                release();
+
+  T*                  get() const { return m_pResource; }
+  T*                  operator->() const { return m_pResource; }
+  explicit operator   bool() const { return m_pResource != nullptr; }
+  AssetId             getId() const { return m_id; }
+
+private:
+  friend class ResourceRegistry;
+
+  ResourceHandle(ResourceRegistry* pRegistry, T* pResource, AssetId id, U32 slot, U32 generation)
+    : m_pRegistry(pRegistry), m_pResource(pResource), m_id(id), m_slot(slot), m_generation(generation) { }
+
+  // Defined below the registry, which is incomplete here.
+  void                retain();
+
+  ResourceRegistry*   m_pRegistry;
+  T*                  m_pResource;
+  AssetId             m_id;
+  U32                 m_slot;
+  U32                 m_generation;
+};
+
+
+// Registry of every loaded resource, by asset id. Resources nobody references stay resident,
+// so that loading them again is free, until their category goes over its byte budget. They are
+// then evicted, least recently used first. Safe to use from any thread, although resources are
+// destroyed on whichever thread caused the eviction.
+class ResourceRegistry {
+public:
+  static const U64 kUnlimitedBudget = ~0ull;
+
+  ResourceRegistry();
+  ~ResourceRegistry();
+
+  // Hash a name into its id, and remember the name for debugging.
+  AssetId             intern(const std::string& name);
+  std::string         getName(AssetId id) const;
+
+  // Register a resource, unreferenced, or held by owner from the start, as by addDependency(),
+  // so that it can not be evicted in between. Evicts older resources first, if the category
+  // would go over budget. Fails, without evicting anything, if the id, or the resource, is
+  // already registered, or the owner is not.
+  template<typename T>
+  B32                 add(AssetId id, T* pResource, U64 bytes = 0, AssetId owner = kNoAssetId) {
+    if (!pResource) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_slots.find(id) != m_slots.end() || m_addresses.find(pResource) != m_addresses.end()) return false;
+    U32 ownerSlot = kNoSlot;
+    if (owner != kNoAssetId) {
+      auto it = m_slots.find(owner);
+      if (it == m_slots.end()) return false;
+      ownerSlot = it->second;
+      // Pinned, so that making room can not evict the owner.
+      retainLocked(ownerSlot);
+    }
+    evictLocked(ResourceTraits<T>::kCategory, bytes);
+    U32 slot = insertLocked(id, pResource, ResourceTraits<T>::kCategory, bytes, &destroyResource<T>);
+    if (ownerSlot != kNoSlot) {
+      dependLocked(ownerSlot, slot);
+      releaseLocked(ownerSlot);
+    }
+    return true;
+  }
+
+  // Reference a resource. The handle is empty if the resource is not registered.
+  template<typename T>
+  ResourceHandle<T>   acquire(AssetId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return handleLocked<T>(lookupLocked(id, ResourceTraits<T>::kCategory));
+  }
+
+  // Reference a resource by its address, for holders that are handed the resource rather than
+  // its id. The handle is empty if the resource is not registered.
+  template<typename T>
+  ResourceHandle<T>   acquire(const T* pResource) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_addresses.find(pResource);
+    AssetId id = (it == m_addresses.end()) ? kNoAssetId : m_entries[it->second]._id;
+    return handleLocked<T>(lookupLocked(id, ResourceTraits<T>::kCategory));
+  }
+
+  // Look up a resource without referencing it, marking it as recently used.
+  template<typename T>
+  T*                  find(AssetId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    U32 slot = lookupLocked(id, ResourceTraits<T>::kCategory);
+    if (slot == kNoSlot) return nullptr;
+    touchLocked(slot);
+    return static_cast<T*>(m_entries[slot]._pResource);
+  }
+
+  // Take an unreferenced resource out of the registry, without destroying it.
+  template<typename T>
+  T*                  detach(AssetId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    U32 slot = lookupLocked(id, ResourceTraits<T>::kCategory);
+    if (slot == kNoSlot || m_entries[slot]._refCount > 0) return nullptr;
+    T* pResource = static_cast<T*>(m_entries[slot]._pResource);
+    removeLocked(slot, false);
+    return pResource;
+  }
+
+  // Destroy an unreferenced resource now.
+  B32                 destroy(AssetId id);
+
+  // Keep dependency resident for as long as owner is. Both must be registered.
+  B32                 addDependency(AssetId owner, AssetId dependency);
+
+  B32                 contains(AssetId id) const;
+  U32                 getRefCount(AssetId id) const;
+
+  // Budgets apply to unreferenced resources only, referenced ones stay no matter the cost. Code
+  // that keeps a resource's address around must hold a handle to it, or it may be evicted.
+  void                setBudget(ResourceCategory category, U64 bytes);
+
+  // Evict unreferenced resources, least recently used first, until the category is in budget.
+  void                trim(ResourceCategory category);
+
+  // Destroy every resource in a category, or every category, referenced or not. Handles left
+  // over become stale, and releasing them does nothing.
+  void                clear(ResourceCategory category);
+  void                clearAll();
+
+  ResourceStats       getStats(ResourceCategory category) const;
+
+private:
+  template<typename T> friend class ResourceHandle;
+
+  typedef void (*DestroyFunc)(void*);
+  static const U32 kNoSlot = 0xffffffff;
+
+  template<typename T>
+  static void         destroyResource(void* pResource) { ResourceTraits<T>::destroy(static_cast<T*>(pResource)); }
+
+  template<typename T>
+  ResourceHandle<T>   handleLocked(U32 slot) {
+    if (slot == kNoSlot) return ResourceHandle<T>();
+    retainLocked(slot);
+    Entry& entry = m_entries[slot];
+    return ResourceHandle<T>(this, static_cast<T*>(entry._pResource), entry._id, slot, entry._generation);
+  }
+
+  struct SlotRef {
+    U32               _slot;
+    U32               _generation;
+  };
+
+  struct Entry {
+    AssetId           _id;
+    void*             _pResource;
+    DestroyFunc       _destroy;
+    U64               _bytes;
+    U32               _category;
+    U32               _refCount;
+    U32               _generation;
+    // Least recently used list of unreferenced resources, per category.
+    U32               _prev;
+    U32               _next;
+    std::vector<SlotRef> _dependencies;
+  };
+
+  U32                 insertLocked(AssetId id, void* pResource, U32 category, U64 bytes, DestroyFunc destroy);
+  U32                 lookupLocked(AssetId id, U32 category);
+  void                removeLocked(U32 slot, B32 destroyResource);
+  void                dependLocked(U32 ownerSlot, U32 dependencySlot);
+  void                evictLocked(U32 category, U64 incoming);
+  void                retainLocked(U32 slot);
+  void                releaseLocked(U32 slot);
+  void                touchLocked(U32 slot);
+  void                linkLocked(U32 slot);
+  void                unlinkLocked(U32 slot);
+
+  // Handles reference, and release, resources through these.
+  void                retain(U32 slot, U32 generation);
+  void                drop(U32 slot, U32 generation);
+
+  std::unordered_map<AssetId, U32>          m_slots;
+  std::unordered_map<const void*, U32>      m_addresses;
+  std::unordered_map<AssetId, std::string>  m_names;
+  std::vector<Entry>                        m_entries;
+  std::vector<U32>                          m_freeSlots;
+  U32                                       m_lruHead[RESOURCE_CATEGORY_COUNT];
+  U32                                       m_lruTail[RESOURCE_CATEGORY_COUNT];
+  ResourceStats                             m_stats[RESOURCE_CATEGORY_COUNT];
+  mutable std::mutex                        m_mutex;
+};
+
+
+template<typename T>
+inline void ResourceHandle<T>::retain()
+{
+  if (m_pRegistry) m_pRegistry->retain(m_slot, m_generation);
+}
+
+
+template<typename T>
+inline void ResourceHandle<T>::release()
+{
+  if (m_pRegistry) m_pRegistry->drop(m_slot, m_generation);
+  m_pRegistry = nullptr;
+  m_pResource = nullptr;
+  m_id = kNoAssetId;
+}
+
+
+// Registry every engine cache keeps its resources in.
+ResourceRegistry& gResourceRegistry();
+} // Recluse
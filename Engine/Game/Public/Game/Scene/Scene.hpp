@@ -31,6 +31,10 @@ public:
   // Adds a child game object to the scene graph root.
   void                      addChild(GameObject* child);
 
+  // Removes a child game object from the scene graph root. Order of the remaining children is
+  // not kept.
+  void                      removeChild(GameObject* child);
+
   size_t                    getChildrenCount() const { return m_GameObjects.size(); }
 
   GameObject*               getChild(size_t idx) { return m_GameObjects[idx]; }
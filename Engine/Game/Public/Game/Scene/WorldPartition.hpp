@@ -0,0 +1,201 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Math/Quaternion.hpp"
+#include "Core/Math/Vector3.hpp"
+
+#include "Filesystem/AsyncIO.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace Recluse {
+
+
+class GameObject;
+class Scene;
+
+
+typedef U32 world_cell_id_t;
+
+
+// Game object placed in a world cell. Objects are created by the factory registered under their
+// type, and placed with the given transform.
+struct WorldObjectDesc {
+  std::string         _type;
+  std::string         _name;
+  Vector3             _position;
+  Quaternion          _rotation;
+  Vector3             _scale;
+  // Index of the cell asset handed to the factory, or -1 for none.
+  I32                 _asset;
+
+  WorldObjectDesc()
+    : _rotation(Quaternion::identity())
+    , _scale(1.0f, 1.0f, 1.0f)
+    , _asset(-1) { }
+};
+
+
+// Cell of the world grid, at cell coordinates x and z, along with the files read before any of
+// its objects are created.
+struct WorldCellDesc {
+  I32                           _x;
+  I32                           _z;
+  std::vector<std::string>      _assets;
+  std::vector<WorldObjectDesc>  _objects;
+  // Max bytes of assets this cell may hold. Cells over budget fail to load. 0 for no limit.
+  U64                           _memoryBudget;
+
+  WorldCellDesc()
+    : _x(0), _z(0), _memoryBudget(0) { }
+};
+
+
+enum WorldCellState {
+  WORLD_CELL_UNLOADED,
+  // Assets are being read.
+  WORLD_CELL_LOADING,
+  // Assets are read, objects are being added to the scene, a few each frame.
+  WORLD_CELL_FINALIZING,
+  WORLD_CELL_LOADED,
+  // Objects are being removed from the scene, a few each frame.
+  WORLD_CELL_UNLOADING,
+  // Assets could not be read, or are over budget. Retried once the view leaves the cell.
+  WORLD_CELL_FAILED
+};
+
+
+struct WorldPartitionStats {
+  U32                 _loadingCells;
+  U32                 _finalizingCells;
+  U32                 _loadedCells;
+  U32                 _unloadingCells;
+  U32                 _objectCount;
+  // Objects created, and destroyed, in the last update.
+  U32                 _objectsCreated;
+  U32                 _objectsDestroyed;
+  // Bytes reserved by cells that are not unloaded, and of the budget.
+  U64                 _residentBytes;
+  U64                 _memoryBudget;
+};
+
+
+// Creates the game object described, given the cell asset it asked for, or nullptr if none. The
+// asset is held until the cell unloads. Return nullptr to skip the object.
+typedef std::function<GameObject*(const WorldObjectDesc& desc, const AsyncFileHandle* pAsset)> world_object_create_t;
+
+// Destroys a game object created by the matching factory. The object is already removed from
+// the scene, and cleaned up.
+typedef std::function<void(GameObject* pObject)> world_object_destroy_t;
+
+
+// World partition, streams a scene in as a grid of cells on the xz plane. Cells within the load
+// radius of the view are read asynchronously, nearest first, and cells beyond the unload radius
+// are released. The unload radius being larger gives hysteresis, so views moving along a cell
+// border do not keep streaming it in and out.
+//
+// Objects are created, added to the scene, and removed, on the calling thread in update(). Only
+// a limited number are handled each update, so that streaming is spread across frames instead of
+// spiking. Must be updated before the frame graph runs any component updates.
+//
+// Cells loading are held to a memory budget. Each cell reserves its own budget, or the size of
+// its assets if it has none, and cells are not streamed in past the global budget. Cells without
+// a budget are counted at the size their assets last had. Until that is known, one at a time 
+// streams in, while there is memory free, and it is dropped again if it turns out not to fit.
+class WorldPartition {
+public:
+  static const world_cell_id_t  kInvalidCell = 0xFFFFFFFF;
+  static const U32              kDefaultObjectsPerUpdate = 32;
+
+  WorldPartition(R32 cellSize = 64.0f, R32 loadRadius = 128.0f, R32 unloadRadius = 160.0f);
+  ~WorldPartition();
+
+  // Scene that cell objects are added to.
+  void                  setScene(Scene* pScene) { m_pScene = pScene; }
+  Scene*                getScene() const { return m_pScene; }
+
+  // Distances are from the view to the nearest point of a cell. unloadRadius must not be less
+  // than loadRadius.
+  void                  setRadii(R32 loadRadius, R32 unloadRadius);
+
+  // Max bytes reserved by cells at once. 0 for no limit.
+  void                  setMemoryBudget(U64 bytes) { m_memoryBudget = bytes; }
+
+  // Max objects created, or destroyed, in one update.
+  void                  setObjectsPerUpdate(U32 count) { m_objectsPerUpdate = count; }
+
+  void                  registerObjectType(const std::string& type, world_object_create_t create,
+                                           world_object_destroy_t destroy);
+
+  // Cells must be added before the first update. Returns kInvalidCell if a cell already exists
+  // at the same coordinates.
+  world_cell_id_t       addCell(const WorldCellDesc& desc);
+
+  // Stream cells around the view position.
+  void                  update(const Vector3& viewPosition);
+
+  // Unload every cell right away, blocking on any reads in flight.
+  void                  unloadAll();
+
+  world_cell_id_t       findCell(I32 x, I32 z) const;
+  world_cell_id_t       getCellAt(const Vector3& position) const;
+  WorldCellState        getCellState(world_cell_id_t cell) const { return m_cells[cell]->_state; }
+  const WorldCellDesc&  getCellDesc(world_cell_id_t cell) const { return m_cells[cell]->_desc; }
+  const std::vector<GameObject*>& getCellObjects(world_cell_id_t cell) const { return m_cells[cell]->_objects; }
+  size_t                getCellCount() const { return m_cells.size(); }
+
+  const WorldPartitionStats& getStats() const { return m_stats; }
+
+private:
+  struct ObjectType {
+    world_object_create_t   _create;
+    world_object_destroy_t  _destroy;
+  };
+
+  struct Cell {
+    WorldCellDesc                       _desc;
+    WorldCellState                      _state;
+    std::unique_ptr<AsyncFileHandle[]>  _files;
+    std::vector<async_io_id_t>          _requests;
+    std::vector<GameObject*>            _objects;
+    std::vector<const ObjectType*>      _objectTypes;
+    // Objects of the description created so far.
+    U32                                 _nextObject;
+    U64                                 _reservedBytes;
+    // Bytes the assets held when last read, 0 if never read.
+    U64                                 _lastBytes;
+    R32                                 _distance;
+  };
+
+  R32                   distanceTo(const Cell& cell, const Vector3& position) const;
+  void                  beginLoad(Cell& cell);
+  void                  pollLoad(Cell& cell);
+  void                  beginUnload(Cell& cell);
+  void                  releaseCell(Cell& cell);
+  B32                   filesFinished(const Cell& cell) const;
+  U32                   finalize(Cell& cell, U32 budget);
+  U32                   unload(Cell& cell, U32 budget);
+  void                  updateStats();
+
+  static U64            cellKey(I32 x, I32 z) { return (static_cast<U64>(static_cast<U32>(x)) << 32) | static_cast<U32>(z); }
+
+  std::vector<std::unique_ptr<Cell>>            m_cells;
+  std::unordered_map<U64, world_cell_id_t>      m_cellLookup;
+  std::unordered_map<std::string, ObjectType>   m_objectTypes;
+  std::vector<world_cell_id_t>                  m_order;
+  Scene*                                        m_pScene;
+  WorldPartitionStats                           m_stats;
+  U64                                           m_memoryBudget;
+  U64                                           m_residentBytes;
+  R32                                           m_cellSize;
+  R32                                           m_loadRadius;
+  R32                                           m_unloadRadius;
+  U32                                           m_objectsPerUpdate;
+};
+} // Recluse
@@ -0,0 +1,84 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Math/Vector3.hpp"
+#include "Core/Math/Quaternion.hpp"
+#include "Core/Math/Matrix4.hpp"
+
+#include <vector>
+
+
+namespace Recluse {
+
+
+class Scene;
+class Transform;
+class ThreadPool;
+
+
+// Flattened transform hierarchy of a scene. Transforms are laid out in structure of arrays, 
+// in depth first order, so that every parent comes before its children, and every subtree is 
+// one contiguous range. Updating is then a linear pass per subtree, instead of a pointer chase 
+// through the scene graph, and subtrees of different roots are updated in parallel.
+//
+// Game code keeps editing the Transform components directly. Each update compares the authored
+// values (world TRS for root objects, local TRS for children) against the cached ones, and only 
+// recomputes matrices for transforms that changed, along with their descendants.
+class TransformHierarchy {
+public:
+  static const I32    kNoParent = -1;
+
+  TransformHierarchy();
+
+  // Flatten the scene graph. Must be called again when the scene graph changes, see needsRebuild().
+  void                build(Scene* pScene);
+
+  // Whether the scene, or the structure of any scene graph, changed since the last build.
+  B32                 needsRebuild(Scene* pScene) const;
+
+  // Update dirty transforms, and write results back to their Transform components. Subtrees
+  // are spread across the pool if given.
+  void                update(ThreadPool* pPool);
+
+  void                clear();
+
+  size_t              getNodeCount() const { return m_transforms.size(); }
+  size_t              getRootCount() const { return m_roots.size(); }
+
+  // Number of transforms recomputed by the last update.
+  size_t              getLastUpdatedCount() const { return m_lastUpdatedCount; }
+
+  // Node arrays, in hierarchy order.
+  const I32*          getParents() const { return m_parents.data(); }
+  const Matrix4*      getWorldMatrices() const { return m_worldMatrices.data(); }
+  Transform* const*   getTransforms() const { return m_transforms.data(); }
+
+private:
+  // Update the subtree starting at a root node. Returns number of nodes recomputed.
+  size_t              updateSubtree(U32 root);
+
+  // Copy authored values from the transform component. Returns true if they changed.
+  B32                 gather(U32 idx);
+
+  std::vector<Transform*>   m_transforms;
+  std::vector<I32>          m_parents;
+  std::vector<U32>          m_subtreeEnds;
+  std::vector<U32>          m_roots;
+
+  // Authored transform values. Local for children, and world for roots.
+  std::vector<Vector3>      m_localPositions;
+  std::vector<Quaternion>   m_localRotations;
+  std::vector<Vector3>      m_localScales;
+
+  // Derived values.
+  std::vector<Quaternion>   m_worldRotations;
+  std::vector<Matrix4>      m_localMatrices;
+  std::vector<Matrix4>      m_worldMatrices;
+  std::vector<U8>           m_dirty;
+
+  Scene*                    m_pScene;
+  U32                       m_version;
+  size_t                    m_lastUpdatedCount;
+};
+} // Recluse
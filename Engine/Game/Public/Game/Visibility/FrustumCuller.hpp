@@ -0,0 +1,61 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Math/AABB.hpp"
+#include "Core/Math/ViewFrustum.hpp"
+#include "Core/Thread/Threading.hpp"
+
+#include <vector>
+
+
+namespace Recluse {
+
+
+typedef U32 cull_slot_t;
+
+
+// World bounds of cullable objects, kept as centers and half extents in structure of arrays,
+// and tested against every view frustum in one pass with ViewFrustum::cullBatch. Objects take
+// a slot, and write their bounds into it whenever they move. Freed slots are reused, and
+// always come out culled.
+class FrustumCuller {
+public:
+  static const cull_slot_t  kInvalidSlot = 0xFFFFFFFF;
+  // Number of boxes tested per job.
+  static const U32          kBatchSize = 4096;
+
+  FrustumCuller();
+
+  cull_slot_t         add(void* pUserData);
+  void                remove(cull_slot_t slot);
+  void                clear();
+
+  void                setBounds(cull_slot_t slot, const AABB& aabb);
+
+  // Test all slots against the frustums, spread across the pool if given. If given, onCulled is
+  // called from the same job with each range of slots, once their masks are written.
+  void                cull(const ViewFrustum* const* frustums, U32 frustumCount, ThreadPool* pPool,
+                           thr_range_func_t onCulled = nullptr);
+
+  // Frustum bit mask of each slot, as of the last cull. Bit i is set when seen by frustum i.
+  U32                 getMask(cull_slot_t slot) const { return m_masks[slot]; }
+  const U32*          getMasks() const { return m_masks.data(); }
+  void*               getUserData(cull_slot_t slot) const { return m_userData[slot]; }
+
+  // Number of slots, including freed ones. Iterate up to this, skipping slots with no user data.
+  size_t              getSlotCount() const { return m_userData.size(); }
+  size_t              getCount() const { return m_userData.size() - m_freeSlots.size(); }
+
+private:
+  std::vector<R32>          m_centerX;
+  std::vector<R32>          m_centerY;
+  std::vector<R32>          m_centerZ;
+  std::vector<R32>          m_extentX;
+  std::vector<R32>          m_extentY;
+  std::vector<R32>          m_extentZ;
+  std::vector<U32>          m_masks;
+  std::vector<void*>        m_userData;
+  std::vector<cull_slot_t>  m_freeSlots;
+};
+} // Recluse
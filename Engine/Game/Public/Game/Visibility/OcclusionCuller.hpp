@@ -0,0 +1,123 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Math/AABB.hpp"
+#include "Core/Math/Matrix4.hpp"
+#include "Core/Math/Vector3.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+
+namespace Recluse {
+
+
+class ThreadPool;
+
+
+typedef U32 occluder_id_t;
+
+
+// Low polygon geometry standing in for a mesh when occluding others, in the mesh's local space.
+// Occluders must lie within the mesh they stand in for, or else objects behind them may be culled
+// while actually visible.
+struct OccluderMesh {
+  std::vector<Vector3>  _positions;
+  std::vector<U32>      _indices;
+};
+
+
+// Software occlusion culler. Designated occluders are rasterized on the cpu, at low resolution,
+// into a depth buffer, which is then reduced into a hierarchical depth buffer of tiles, each
+// holding the farthest depth of its pixels. Bounding boxes of occludees are then tested against
+// the tiles they cover, before their render commands are emitted.
+//
+// Depth is stored as inverse clip w, which interpolates linearly in screen space, whatever the
+// projection. Larger is nearer, and zero is empty. Rows of tiles are rasterized as separate jobs,
+// four pixels at a time with SSE when available.
+//
+// Occluder triangles crossing the near plane are skipped, and occludees crossing it are always
+// visible, so results stay conservative without clipping.
+class OcclusionCuller {
+public:
+  static const occluder_id_t  kInvalidOccluder = 0xFFFFFFFF;
+  // Width, and height, of depth tiles in pixels.
+  static const U32            kTileSize = 8;
+  static const U32            kDefaultWidth = 320;
+  static const U32            kDefaultHeight = 192;
+
+  OcclusionCuller(U32 width = kDefaultWidth, U32 height = kDefaultHeight);
+
+  // Resolution is rounded up to whole tiles.
+  void                resize(U32 width, U32 height);
+
+  occluder_id_t       addOccluder(const OccluderMesh* pMesh);
+  void                removeOccluder(occluder_id_t id);
+  void                setOccluderTransform(occluder_id_t id, const Matrix4& localToWorld);
+
+  // Rasterize all occluders as seen through the view projection, spread across the pool if given.
+  // Resets the culled primitive count of the frame.
+  void                render(const Matrix4& viewProjection, ThreadPool* pPool);
+
+  // Test a world space box against the last render. Returns false only if the box is hidden
+  // behind occluders. Thread safe.
+  B32                 testAABB(const AABB& aabb) const;
+
+  // Culled primitives are counted by whoever skips them, from any thread.
+  void                addCulledPrimitives(U32 count) { m_culledPrimitives.fetch_add(count, std::memory_order_relaxed); }
+  U32                 getCulledPrimitiveCount() const { return m_culledPrimitives.load(std::memory_order_relaxed); }
+  U32                 getRasterizedTriangleCount() const { return m_rasterizedTriangles; }
+
+  void                setEnabled(B32 enable) { m_enabled = enable; }
+  B32                 isEnabled() const { return m_enabled; }
+
+  U32                 getWidth() const { return m_width; }
+  U32                 getHeight() const { return m_height; }
+  const R32*          getDepthBuffer() const { return m_depth.data(); }
+  const R32*          getTileDepthBuffer() const { return m_tileDepth.data(); }
+
+  // Write the depth buffer as an 8 bit greyscale PGM image, nearer being brighter.
+  B32                 dumpDepthBuffer(const std::string& path) const;
+
+private:
+  struct Occluder {
+    const OccluderMesh* _pMesh;
+    Matrix4             _localToWorld;
+  };
+
+  // Screen space triangle setup. Edge e is _edgeA[e] * x + _edgeB[e] * y + _edgeC[e], positive
+  // inside, and inverse w is the plane _depthA * x + _depthB * y + _depthC. Bounds are in pixels.
+  struct ScreenTriangle {
+    R32                 _edgeA[3];
+    R32                 _edgeB[3];
+    R32                 _edgeC[3];
+    R32                 _depthA;
+    R32                 _depthB;
+    R32                 _depthC;
+    I32                 _minX;
+    I32                 _minY;
+    I32                 _maxX;
+    I32                 _maxY;
+  };
+
+  void                setupTriangles(const Matrix4& viewProjection);
+  void                rasterizeTileRow(U32 tileRow);
+
+  std::vector<Occluder>       m_occluders;
+  std::vector<occluder_id_t>  m_freeOccluders;
+  std::vector<ScreenTriangle> m_triangles;
+  std::vector<R32>            m_depth;
+  std::vector<R32>            m_tileDepth;
+  Matrix4                     m_viewProjection;
+  std::atomic<U32>            m_culledPrimitives;
+  U32                         m_rasterizedTriangles;
+  U32                         m_width;
+  U32                         m_height;
+  U32                         m_tilesX;
+  U32                         m_tilesY;
+  B32                         m_enabled;
+  B32                         m_rendered;
+};
+} // Recluse
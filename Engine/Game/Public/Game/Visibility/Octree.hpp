@@ -0,0 +1,107 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Math/AABB.hpp"
+#include "Core/Math/Ray.hpp"
+#include "Core/Math/Sphere.hpp"
+#include "Core/Math/ViewFrustum.hpp"
+
+#include <vector>
+
+
+namespace Recluse {
+
+
+typedef U32 octree_proxy_t;
+
+
+// Loose octree, used as the dynamic spatial index of the scene, for culling and gameplay
+// queries. Objects are inserted as proxies, holding their world bounds and a user pointer.
+// A proxy lives in the deepest node whose loose bounds (twice the size of the node) contain it,
+// which is found from the proxy center and size alone, so inserting and moving are O(depth),
+// and most moves do not change nodes at all.
+//
+// Nodes are created as proxies are inserted, and freed once their subtree is empty. Proxies
+// outside of the world bounds are kept in the root, and are still found by queries.
+//
+// Queries append proxy ids to the results given, and reject whole subtrees at once. Subtrees
+// fully inside a query volume are added without testing each proxy. Not thread safe, queries
+// may run in parallel with each other, but not with inserts, moves, or removes.
+class Octree {
+public:
+  static const octree_proxy_t kInvalidProxy = 0xFFFFFFFF;
+  static const U32            kMaxDepth = 12;
+
+  Octree(const Vector3& center = Vector3(), R32 halfSize = 2048.0f, U32 maxDepth = 8);
+
+  // Reset world bounds of the tree. Tree must be empty.
+  void                reset(const Vector3& center, R32 halfSize, U32 maxDepth);
+
+  // Remove all proxies. Ids held onto are no longer valid.
+  void                clear();
+
+  octree_proxy_t      insert(const AABB& aabb, void* pUserData);
+
+  // Update the bounds of a proxy, moving it to another node only if it has to.
+  void                move(octree_proxy_t proxy, const AABB& aabb);
+  void                remove(octree_proxy_t proxy);
+
+  const AABB&         getAABB(octree_proxy_t proxy) const { return m_proxies[proxy]._aabb; }
+  void*               getUserData(octree_proxy_t proxy) const { return m_proxies[proxy]._pUserData; }
+
+  size_t              getProxyCount() const { return m_proxyCount; }
+  size_t              getNodeCount() const { return m_nodes.size() - m_freeNodes.size(); }
+
+  // Proxies possibly visible in the frustum.
+  void                queryFrustum(const ViewFrustum& frustum, std::vector<octree_proxy_t>& results) const;
+  void                querySphere(const Sphere& sphere, std::vector<octree_proxy_t>& results) const;
+  void                queryAABB(const AABB& aabb, std::vector<octree_proxy_t>& results) const;
+
+  // Proxies hit by the ray, within maxDistance units of direction from the origin.
+  void                queryRay(const Ray& ray, R32 maxDistance, std::vector<octree_proxy_t>& results) const;
+
+private:
+  static const U32    kNoNode = 0xFFFFFFFF;
+
+  struct Node {
+    Vector3           _center;
+    R32               _halfSize;
+    U32               _parent;
+    U32               _children[8];
+    // Proxies stored in this node.
+    octree_proxy_t    _firstProxy;
+    // Proxies stored in this node, and all of its descendants.
+    U32               _subtreeCount;
+    U32               _depth;
+  };
+
+  struct Proxy {
+    AABB              _aabb;
+    void*             _pUserData;
+    U32               _node;
+    // Links to proxies of the same node. _next links free proxies.
+    octree_proxy_t    _prev;
+    octree_proxy_t    _next;
+  };
+
+  // Tests a query volume against a box. Returns one of ViewFrustum::Result.
+  typedef ViewFrustum::Result (*volume_test_t)(const void* pVolume, const AABB& aabb);
+
+  void                query(volume_test_t test, const void* pVolume, std::vector<octree_proxy_t>& results) const;
+  void                addSubtree(U32 node, std::vector<octree_proxy_t>& results) const;
+
+  U32                 findNode(const AABB& aabb);
+  U32                 allocateNode(U32 parent, U32 octant);
+  void                link(octree_proxy_t proxy, U32 node);
+  void                unlink(octree_proxy_t proxy);
+  AABB                getLooseBounds(U32 node) const;
+
+  std::vector<Node>           m_nodes;
+  std::vector<U32>            m_freeNodes;
+  std::vector<Proxy>          m_proxies;
+  octree_proxy_t              m_freeProxy;
+  size_t                      m_proxyCount;
+  U32                         m_maxDepth;
+};
+} // Recluse
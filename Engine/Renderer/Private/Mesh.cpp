@@ -35,48 +35,72 @@ void Mesh::cleanUp(Renderer* pRenderer)
 
 void Mesh::sortPrimitives(Mesh::SortType type)
 {
-  switch (type) {
-    case SortType::TRANSPARENCY_LAST:
-    {
-      std::vector<Primitive> transparencies;
-      std::vector<Primitive> opaques;
-      for ( Primitive& primitive : m_primitives ) { 
-        if ( primitive._pMat->getNative()->isTransparent() ) {
-          transparencies.push_back(primitive);
-        } else {
-          opaques.push_back(primitive);
+  for (std::vector<Primitive>& primitives : m_primitives) {
+    switch (type) {
+      case SortType::TRANSPARENCY_LAST:
+      {
+        std::vector<Primitive> transparencies;
+        std::vector<Primitive> opaques;
+        for ( Primitive& primitive : primitives ) { 
+          if ( primitive._pMat->getNative()->isTransparent() ) {
+            transparencies.push_back(primitive);
+          } else {
+            opaques.push_back(primitive);
+          }
+        }
+        size_t idx = 0;
+        for ( Primitive& primitive : opaques ) {
+          primitives[idx++] = primitive;
+        }
+        for ( Primitive& primitive : transparencies ) {
+          primitives[idx++] = primitive;
+        }
+      } break;
+      case SortType::TRANSPARENCY_FIRST:
+      {
+        std::vector<Primitive> transparencies;
+        std::vector<Primitive> opaques;
+        for (Primitive& primitive : primitives) {
+          if (primitive._pMat->getNative()->isTransparent()) {
+            transparencies.push_back(primitive);
+          }
+          else {
+            opaques.push_back(primitive);
+          }
         }
-      }
-      size_t idx = 0;
-      for ( Primitive& primitive : opaques ) {
-        m_primitives[idx++] = primitive;
-      }
-      for ( Primitive& primitive : transparencies ) {
-        m_primitives[idx++] = primitive;
-      }
-    } break;
-    case SortType::TRANSPARENCY_FIRST:
-    {
-      std::vector<Primitive> transparencies;
-      std::vector<Primitive> opaques;
-      for (Primitive& primitive : m_primitives) {
-        if (primitive._pMat->getNative()->isTransparent()) {
-          transparencies.push_back(primitive);
+        size_t idx = 0;
+        for (Primitive& primitive : transparencies) {
+          primitives[idx++] = primitive;
         }
-        else {
-          opaques.push_back(primitive);
+        for (Primitive& primitive : opaques) {
+          primitives[idx++] = primitive;
         }
-      }
-      size_t idx = 0;
-      for (Primitive& primitive : transparencies) {
-        m_primitives[idx++] = primitive;
-      }
-      for (Primitive& primitive : opaques) {
-        m_primitives[idx++] = primitive;
-      }
-    } break;
-    default: break;
+      } break;
+      default: break;
+    }
+  }
+}
+
+
+U32 Mesh::getLodCount() const
+{
+  U32 count = 0;
+  while (count < kMaxMeshLodWidth && !m_primitives[count].empty()) {
+    count++;
+  }
+  return count;
+}
+
+
+U32 Mesh::selectLod(R32 pixelsPerUnit, R32 maxPixelError) const
+{
+  U32 lod = kMeshLodZero;
+  U32 lodCount = getLodCount();
+  for (U32 i = 1; i < lodCount; ++i) {
+    if (m_lodErrors[i] * pixelsPerUnit > maxPixelError) break;
+    lod = i;
   }
+  return lod;
 }
 
 
@@ -564,6 +564,15 @@ B32 Renderer::initialize(Window* window, const GraphicsConfigParams* params)
     
   }
 
+  // Command lists are rebuilt every frame, so source them from frame memory.
+  m_cmdDeferredList.setAllocator(&gCore().FrameAlloc());
+  m_forwardCmdList.setAllocator(&gCore().FrameAlloc());
+  m_staticCmdList.setAllocator(&gCore().FrameAlloc());
+  m_dynamicCmdList.setAllocator(&gCore().FrameAlloc());
+  m_meshDescriptors.setAllocator(&gCore().FrameAlloc());
+  m_jointDescriptors.setAllocator(&gCore().FrameAlloc());
+  m_materialDescriptors.setAllocator(&gCore().FrameAlloc());
+
   setUpRenderTextures(true);
   setUpFrameBuffers();
   setUpDescriptorSetLayouts();
@@ -4856,6 +4865,9 @@ void Renderer::pushMeshRender(MeshRenderCmd& cmd)
     primCmd._instances = 1;
     primCmd._debugConfig = cmd._debugConfig;
 
+    // Occluded meshes are only needed for shadows.
+    if ((primCmd._config & CMD_OCCLUDED_BIT) && !(primCmd._config & CMD_SHADOWS_BIT)) continue;
+
     if (primCmd._config & ~CMD_BASIC_RENDER_BIT) {
       R_ASSERT(prim._pMat, "No material descriptor added to this primitive. Need to set a material descriptor!");
       m_materialDescriptors.pushBack(prim._pMat->getNative());
@@ -4870,7 +4882,10 @@ void Renderer::pushMeshRender(MeshRenderCmd& cmd)
     m_meshDescriptors.pushBack(cmd._pMeshDesc);
 
     U32 config = primCmd._config;
-    if ((config & (CMD_TRANSPARENT_BIT | CMD_TRANSLUCENT_BIT | CMD_FORWARD_BIT | CMD_DEBUG_BIT))) {
+    if ((config & CMD_OCCLUDED_BIT)) {
+      // Not seen by the camera, skip the forward and deferred passes.
+    }
+    else if ((config & (CMD_TRANSPARENT_BIT | CMD_TRANSLUCENT_BIT | CMD_FORWARD_BIT | CMD_DEBUG_BIT))) {
       m_forwardCmdList.pushBack(primCmd);
     }
     else {
@@ -3,10 +3,14 @@
 
 #include "Core/Types.hpp"
 #include "Core/Utility/Vector.hpp"
+#include "Core/Memory/FrameAllocator.hpp"
+#include "Core/Exception.hpp"
 #include "RenderCmd.hpp"
 
 #include <functional>
 #include <algorithm>
+#include <type_traits>
+#include <cstring>
 
 
 namespace Recluse {
@@ -22,27 +26,73 @@ public:
   CmdList(size_t size = 1)
     : mCmdList(size)
     , mCompare(nullptr)
-    , m_currIdx(0) { } 
+    , m_currIdx(0)
+    , m_pAllocator(nullptr)
+    , m_pFrameCmds(nullptr)
+    , m_frameCapacity(0) { } 
 
   size_t                  Size() const { return m_currIdx; }
-  Cmd&                    operator[](size_t i) { return mCmdList[i]; }
-  Cmd&                    get(size_t i) { return mCmdList[i]; }
+  Cmd&                    operator[](size_t i) { return data()[i]; }
+  Cmd&                    get(size_t i) { return data()[i]; }
 
-  void                    resize(size_t newSize) { mCmdList.resize(newSize); }
+  void                    resize(size_t newSize) { if (m_pAllocator) { resizeFrame(newSize); } else { mCmdList.resize(newSize); } }
   void                    setSortFunc(CmdCompareFunc compare) { mCompare = compare; }
 
+  // Back this list with memory from the frame allocator, instead of the heap. Storage is 
+  // dropped on clear(), and reacquired from the current frame on the next push, sized to the 
+  // capacity of the previous frame, so lists never regrow once warmed up. Cmd must be 
+  // trivially copyable, and the list must be cleared every frame.
+  void                    setAllocator(FrameAllocator* pAllocator) {
+    static_assert(std::is_trivially_copyable<Cmd>::value, "Frame allocated command lists require trivially copyable commands.");
+    m_frameCapacity = mCmdList.size();
+    m_pAllocator = pAllocator;
+    mCmdList.clear();
+    mCmdList.shrink_to_fit();
+    clear();
+  }
+
   // Push back an object. Returns the index of the object stored in this structure.
-  size_t                  pushBack(Cmd cmd) { if (m_currIdx >= mCmdList.size()) { resize(mCmdList.size() << 1); } mCmdList[m_currIdx] = cmd; return m_currIdx++; }
-  void                    erase(U32 i) { mCmdList.erase(mRenderList.begin() + i); }
+  size_t                  pushBack(Cmd cmd) { if (m_currIdx >= capacity()) { growCapacity(); } data()[m_currIdx] = cmd; return m_currIdx++; }
+  void                    erase(U32 i) { mCmdList.erase(mCmdList.begin() + i); }
   // Sort using alg.
-  void                    sort() { if (mCompare && m_currIdx > 0) std::sort(mCmdList.begin(), mCmdList.begin() + (m_currIdx), mCompare); }
-  void                    clear() { m_currIdx = 0; }
+  void                    sort() { if (mCompare && m_currIdx > 0) std::sort(data(), data() + m_currIdx, mCompare); }
+  void                    clear() { m_currIdx = 0; m_pFrameCmds = nullptr; }
 
-  const Cmd*              getData() { return mCmdList.data(); }
+  const Cmd*              getData() { return data(); }
 private:
+  Cmd*                    data() { return m_pAllocator ? m_pFrameCmds : mCmdList.data(); }
+  size_t                  capacity() const { return m_pAllocator ? (m_pFrameCmds ? m_frameCapacity : 0) : mCmdList.size(); }
+
+  void                    growCapacity() {
+    size_t cap = capacity();
+    if (m_pAllocator && cap == 0) { cap = m_frameCapacity; }
+    else { cap = cap << 1; }
+    resize(cap > 0 ? cap : 1);
+  }
+
+  void                    resizeFrame(size_t newSize) {
+    if (newSize <= m_currIdx) return;
+    Cmd* pCmds = m_pAllocator->allocateArray<Cmd>(newSize);
+    if (!pCmds) {
+      // Out of frame memory, fall back to the heap for good.
+      mCmdList.resize(newSize);
+      if (m_pFrameCmds) memcpy(mCmdList.data(), m_pFrameCmds, sizeof(Cmd) * m_currIdx);
+      m_pAllocator = nullptr;
+      m_pFrameCmds = nullptr;
+      return;
+    }
+    // Previous storage is reclaimed with the rest of the frame.
+    if (m_pFrameCmds) memcpy(pCmds, m_pFrameCmds, sizeof(Cmd) * m_currIdx);
+    m_pFrameCmds = pCmds;
+    m_frameCapacity = newSize;
+  }
+
   std::vector<Cmd>        mCmdList;
   CmdCompareFunc         mCompare;
   B32                     mDirty;
   U32                    m_currIdx;
+  FrameAllocator*         m_pAllocator;
+  Cmd*                    m_pFrameCmds;
+  size_t                  m_frameCapacity;
 };
 } // Recluse
\ No newline at end of file
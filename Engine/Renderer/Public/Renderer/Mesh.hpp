@@ -51,6 +51,7 @@ public:
          , m_skeleId(Skeleton::kNoSkeletonId) 
          , m_pMeshData{nullptr}
          , m_lodBias(0.0)
+         , m_lodErrors{0.0f}
   {
   }
 
@@ -74,11 +75,23 @@ public:
   void setSkeletonReference(skeleton_uuid_t uuid) { m_skeleId = uuid; }
   skeleton_uuid_t getSkeletonReference() const { return m_skeleId; }
 
-  Primitive* getPrimitiveData() { return m_primitives.data(); }
-  U32 getPrimitiveCount() const { return static_cast<U32>(m_primitives.size()); }
-  Primitive* getPrimitive(U32 idx) { return &m_primitives[idx]; }
-  inline void clearPrimitives(U32 lod = kMeshLodZero) { m_primitives.clear(); }
-  inline void pushPrimitive(const Primitive& primitive) { m_primitives.push_back(primitive); }
+  // Every level of detail draws its own primitives, out of the same vertex and index buffers.
+  Primitive* getPrimitiveData(U32 lod = kMeshLodZero) { return m_primitives[lod].data(); }
+  U32 getPrimitiveCount(U32 lod = kMeshLodZero) const { return static_cast<U32>(m_primitives[lod].size()); }
+  Primitive* getPrimitive(U32 idx, U32 lod = kMeshLodZero) { return &m_primitives[lod][idx]; }
+  inline void clearPrimitives(U32 lod = kMeshLodZero) { m_primitives[lod].clear(); }
+  inline void pushPrimitive(const Primitive& primitive, U32 lod = kMeshLodZero) { m_primitives[lod].push_back(primitive); }
+
+  // Number of levels of detail with primitives, starting from level zero.
+  U32 getLodCount() const;
+
+  // Error of a level of detail, in mesh units, as recorded when it was simplified.
+  R32 getLodError(U32 lod) const { return m_lodErrors[lod]; }
+  void setLodError(U32 lod, R32 error) { m_lodErrors[lod] = error; }
+
+  // Lowest detail level whose error, projected onto the screen, stays within maxPixelError.
+  // pixelsPerUnit is the size on screen of one mesh unit, at the mesh's distance.
+  U32 selectLod(R32 pixelsPerUnit, R32 maxPixelError) const;
 
   void allocateMorphTargetBuffer(size_t newsize);
   MorphTarget* getMorphTarget(size_t idx) { return m_morphTargets[idx]; }
@@ -109,8 +122,8 @@ public:
   // The actual mesh data used to bound and render.
   MeshData* m_pMeshData;
 
-  // Primitives that correspond to this mesh.
-  std::vector<Primitive> m_primitives;
+  // Primitives that correspond to this mesh, for each level of detail.
+  std::vector<Primitive> m_primitives[kMaxMeshLodWidth];
 
   // Morph Targets that correspond to this mesh.
   std::vector<MorphTarget*> m_morphTargets;
@@ -125,5 +138,7 @@ public:
   AABB m_aabb;
 
   R32 m_lodBias;
+
+  R32 m_lodErrors[kMaxMeshLodWidth];
 };
 } // Recluse 
\ No newline at end of file
@@ -45,7 +45,8 @@ enum CmdConfig {
   CMD_BASIC_RENDER_BIT  = (1 << 15),  // Basic render bit, redirects rendering to simple pipeline, with no material.
   CMD_REFRACTION_BIT    = (1 << 16),  // Refraction bit. Mesh refracts.
   CMD_CUSTOM_SHADE_BIT  = (1 << 17),  // Mesh uses custom shader.
-  CMD_BILLBOARD_BIT     = (1 << 18)
+  CMD_BILLBOARD_BIT     = (1 << 18),
+  CMD_OCCLUDED_BIT      = (1 << 19)   // Mesh is hidden from the camera by occluders, only casts shadows.
 };
 
 
@@ -0,0 +1,548 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestAnimation.hpp"
+#include "../Tester.hpp"
+#include "Animation/Animation.hpp"
+#include "Animation/Clip.hpp"
+#include "Animation/ClipCompressor.hpp"
+
+#include <cmath>
+
+
+namespace Test {
+
+
+static B32 SamePose(const JointPose& a, const JointPose& b)
+{
+  return a._trans.x == b._trans.x && a._trans.y == b._trans.y && a._trans.z == b._trans.z
+    && a._rot.x == b._rot.x && a._rot.y == b._rot.y && a._rot.z == b._rot.z && a._rot.w == b._rot.w
+    && a._scale.x == b._scale.x && a._scale.y == b._scale.y && a._scale.z == b._scale.z;
+}
+
+
+B8 TestAnimationClip()
+{
+  Log() << "\n\nAnimation Clip\n\n";
+
+  // Node 5 moves along x, 10 units a second. Node 7 moves on its own keys, and turns a quarter
+  // around y over the clip. Neither one scales. Every key is kept, and translations range too
+  // far to quantize, so they keep full precision.
+  ClipCompressor::RawClip raw;
+  raw._duration = 3.0f;
+  raw._fps = 60.0f;
+  raw._looping = true;
+  raw._tracks.resize(2);
+  raw._tracks[0]._nodeId = 5;
+  raw._tracks[0]._parent = ClipCompressor::kNoParentTrack;
+  raw._tracks[1]._nodeId = 7;
+  raw._tracks[1]._parent = ClipCompressor::kNoParentTrack;
+
+  raw._tracks[0]._times[ANIM_CHANNEL_TRANSLATION] = { 0.0f, 1.0f, 2.0f, 3.0f };
+  for (U32 k = 0; k < 4; ++k) raw._tracks[0]._translations.push_back(Vector3(10.0f * k, 0.0f, 0.0f));
+  raw._tracks[0]._times[ANIM_CHANNEL_ROTATION] = { 0.0f };
+  raw._tracks[0]._rotations.push_back(Quaternion());
+
+  raw._tracks[1]._times[ANIM_CHANNEL_TRANSLATION] = { 0.0f, 0.5f, 3.0f };
+  raw._tracks[1]._translations.push_back(Vector3(0.0f, 0.0f, 0.0f));
+  raw._tracks[1]._translations.push_back(Vector3(0.0f, 5.0f, 0.0f));
+  raw._tracks[1]._translations.push_back(Vector3(0.0f, 5.0f, 25.0f));
+  raw._tracks[1]._times[ANIM_CHANNEL_ROTATION] = { 0.0f, 3.0f };
+  raw._tracks[1]._rotations.push_back(Quaternion());
+  raw._tracks[1]._rotations.push_back(Quaternion(0.0f, std::sin(0.25f * 3.14159265f), 0.0f, std::cos(0.25f * 3.14159265f)));
+
+  raw._morphTargetCount = 2;
+  raw._morphTimes = { 0.0f, 2.0f };
+  raw._morphWeights = { 0.0f, 1.0f, 1.0f, 0.0f };
+
+  ClipCompressor::Settings settings = ClipCompressor::kDefaultSettings;
+  settings._reduceKeys = false;
+  AnimClip clip;
+  ClipCompressor::compress(raw, &clip, settings);
+  TASSERT_E(clip._tracks.size(), 2);
+  TASSERT_E(clip._tracks[0]._channels[ANIM_CHANNEL_TRANSLATION]._keyCount, 4);
+  // Resting at identity the whole clip, the rotation needs no keys.
+  TASSERT_E(clip._tracks[0]._channels[ANIM_CHANNEL_ROTATION]._keyCount, 0);
+  TASSERT_E(clip._keys[ANIM_CHANNEL_TRANSLATION].size(), 7 * kAnimFullRangeWidth);
+  TASSERT_E(clip._keys[ANIM_CHANNEL_ROTATION].size(), 2 * kAnimKeyWidth);
+
+  // Without a skeleton, tracks write to the slots of their nodes.
+  clip.bindSkeleton(nullptr);
+  TASSERT_E(clip._tracks[0]._joint, 5);
+  TASSERT_E(clip._tracks[1]._joint, 7);
+
+  AnimCursor cursor;
+  clip.attachCursor(&cursor);
+  TASSERT_E(cursor._pClip, &clip);
+  TASSERT_E(cursor._keys.size(), 2 * ANIM_CHANNEL_COUNT + 1);
+
+  // Keys interpolate, clamp to the ends, and channels without keys stay at rest.
+  JointPose pose = clip.sampleTrack(0, 1.5f, &cursor);
+  TASSERT_L(std::fabs(pose._trans.x - 15.0f), 1e-3f);
+  TASSERT_E(pose._scale.x, 1.0f);
+  TASSERT_E(pose._scale.y, 1.0f);
+  TASSERT_E(pose._rot.w, 1.0f);
+  pose = clip.sampleTrack(0, -1.0f, &cursor);
+  TASSERT_E(pose._trans.x, 0.0f);
+  pose = clip.sampleTrack(0, 4.0f, &cursor);
+  TASSERT_E(pose._trans.x, 30.0f);
+  pose = clip.sampleTrack(1, 0.25f, &cursor);
+  TASSERT_L(std::fabs(pose._trans.y - 2.5f), 1e-3f);
+  pose = clip.sampleTrack(1, 3.0f, &cursor);
+  TASSERT_L(std::fabs(pose._rot.y - std::sin(0.25f * 3.14159265f)), 1e-4f);
+
+  R32 weights[2];
+  TASSERT_E(clip.sampleMorphs(weights, 1.0f, &cursor), true);
+  TASSERT_E(weights[0], 0.5f);
+  TASSERT_E(weights[1], 0.5f);
+
+  // Playing forward from a cursor, and seeking back past it, match sampling from scratch.
+  cursor.reset();
+  clip.attachCursor(&cursor);
+  for (U32 loop = 0; loop < 2; ++loop) {
+    for (U32 step = 0; step <= 300; ++step) {
+      R32 t = step * 0.01f;
+      for (U32 track = 0; track < 2; ++track) {
+        AnimCursor fresh;
+        clip.attachCursor(&fresh);
+        TASSERT_E(SamePose(clip.sampleTrack(track, t, &cursor), clip.sampleTrack(track, t, &fresh)), true);
+      }
+    }
+  }
+  // The cursor ends on the last keys of each channel.
+  TASSERT_E(cursor._keys[ANIM_CHANNEL_TRANSLATION], 3);
+  TASSERT_E(cursor._keys[ANIM_CHANNEL_COUNT + ANIM_CHANNEL_ROTATION], 1);
+
+  // Bound to a skeleton, tracks write to the slots of their joints, and tracks of nodes outside
+  // of it write nowhere.
+  Skeleton skeleton;
+  skeleton._joints.resize(2);
+  skeleton._joints[0]._id = 7;
+  skeleton._joints[1]._id = 5;
+  clip.bindSkeleton(&skeleton);
+  TASSERT_E(clip._tracks[0]._joint, 1);
+  TASSERT_E(clip._tracks[1]._joint, 0);
+  TASSERT_E(clip._skeletonId, skeleton._uuid);
+  TASSERT_E(clip._boundSkeletonId, skeleton._uuid);
+  skeleton._joints[0]._id = 9;
+  clip.bindSkeleton(&skeleton);
+  TASSERT_E(clip._tracks[1]._joint, AnimTrack::kUnboundJoint);
+
+  // Cursors of another clip start over.
+  AnimClip other;
+  other.attachCursor(&cursor);
+  TASSERT_E(cursor._pClip, &other);
+  TASSERT_E(cursor._keys.size(), 1);
+
+  return true;
+}
+
+
+static R32 RotationError(const Quaternion& a, const Quaternion& b)
+{
+  return 1.0f - std::fabs(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+}
+
+
+B8 TestClipCompressor()
+{
+  Log() << "\n\nClip Compressor\n\n";
+
+  // Smallest three rotations rebuild within a hair, whichever component is largest, and
+  // whatever its sign.
+  const Quaternion rotations[] = {
+    Quaternion(0.9f, 0.1f, -0.3f, 0.2f),
+    Quaternion(0.1f, -0.8f, 0.4f, 0.3f),
+    Quaternion(-0.2f, 0.3f, -0.9f, 0.1f),
+    Quaternion(0.3f, 0.2f, 0.1f, -0.9f),
+    Quaternion(0.5f, -0.5f, 0.5f, 0.5f),
+    Quaternion()
+  };
+  for (const Quaternion& rotation : rotations) {
+    Quaternion q = rotation.normalize();
+    U16 key[kAnimKeyWidth];
+    quantizeRotation(q, key);
+    TASSERT_L(RotationError(dequantizeRotation(key), q), 1e-6f);
+  }
+
+  AnimChannel range = { };
+  range._rangeMin[0] = -2.0f;
+  range._rangeExtent[0] = 4.0f;
+  range._rangeMin[1] = 3.0f;
+  U16 key[kAnimKeyWidth];
+  quantizeRange(Vector3(1.234f, 3.0f, 0.0f), range, key);
+  Vector3 v = dequantizeRange(key, range);
+  TASSERT_L(std::fabs(v.x - 1.234f), 4.0f / 65535.0f);
+  TASSERT_E(v.y, 3.0f);
+
+  // A chain of three joints, a unit apart, keyed at 60 frames a second. The root slides along
+  // x, and is turned a quarter around z the whole time. The middle joint swings around x, and
+  // the tip stays at rest.
+  ClipCompressor::RawClip raw;
+  raw._name = "Swing";
+  raw._duration = 1.0f;
+  raw._fps = 60.0f;
+  raw._looping = true;
+  raw._morphTargetCount = 0;
+  raw._tracks.resize(3);
+  const Quaternion quarter = Quaternion::angleAxis(0.5f * 3.14159265f, Vector3(0.0f, 0.0f, 1.0f));
+  for (U32 i = 0; i < 3; ++i) {
+    ClipCompressor::RawTrack& track = raw._tracks[i];
+    track._nodeId = i;
+    track._parent = (i == 0) ? ClipCompressor::kNoParentTrack : i - 1;
+    for (U32 k = 0; k <= 60; ++k) {
+      R32 t = k / 60.0f;
+      for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) track._times[c].push_back(t);
+      track._translations.push_back((i == 0) ? Vector3(t, 0.0f, 0.0f) : Vector3(0.0f, 1.0f, 0.0f));
+      if (i == 0) {
+        track._rotations.push_back(quarter);
+        track._scales.push_back(Vector3(1.0f, 1.0f, 1.0f));
+      } else if (i == 1) {
+        track._rotations.push_back(Quaternion::angleAxis(0.5f * std::sin(2.0f * 3.14159265f * t), Vector3(1.0f, 0.0f, 0.0f)));
+      } else {
+        track._rotations.push_back(Quaternion());
+      }
+    }
+  }
+
+  AnimClip clip;
+  ClipCompressor::Stats stats = ClipCompressor::compress(raw, &clip);
+  TASSERT_LE(stats._maxBoneError, ClipCompressor::kDefaultSettings._maxBoneError);
+  TASSERT_LE(stats._maxObjectError, ClipCompressor::kDefaultSettings._maxObjectError);
+  TASSERT_E(stats._rawKeys, 7 * 61);
+  TASSERT_L(stats._keptKeys, 61 + 4);
+  TASSERT_E(stats._defaultChannels, 2);
+  TASSERT_E(stats._constantChannels, 3);
+  TASSERT_G(stats._ratio, 4.0f);
+  TASSERT_E(stats._compressedBytes, clip.getKeyByteSize());
+
+  // Straight lines need their ends only, constant channels a single key, and resting ones none.
+  TASSERT_E(clip._tracks[0]._channels[ANIM_CHANNEL_TRANSLATION]._keyCount, 2);
+  TASSERT_E(clip._tracks[0]._channels[ANIM_CHANNEL_ROTATION]._keyCount, 1);
+  TASSERT_E(clip._tracks[0]._channels[ANIM_CHANNEL_SCALE]._keyCount, 0);
+  TASSERT_E(clip._tracks[1]._channels[ANIM_CHANNEL_TRANSLATION]._keyCount, 1);
+  TASSERT_E(clip._tracks[2]._channels[ANIM_CHANNEL_ROTATION]._keyCount, 0);
+
+  // In between source keys, the clip still follows the motion the keys were made from.
+  AnimCursor cursor;
+  clip.attachCursor(&cursor);
+  for (U32 step = 0; step < 100; ++step) {
+    R32 t = step * 0.01f + 0.005f;
+    JointPose root = clip.sampleTrack(0, t, &cursor);
+    TASSERT_L(std::fabs(root._trans.x - t), 1e-4f);
+    TASSERT_L(RotationError(root._rot, quarter), 1e-6f);
+    JointPose swing = clip.sampleTrack(1, t, &cursor);
+    Quaternion expected = Quaternion::angleAxis(0.5f * std::sin(2.0f * 3.14159265f * t), Vector3(1.0f, 0.0f, 0.0f));
+    TASSERT_L(RotationError(swing._rot, expected), 1e-4f);
+  }
+
+  // Measuring again agrees with the stats.
+  R32 boneError = 0.0f;
+  R32 objectError = 0.0f;
+  ClipCompressor::measureError(raw, clip, ClipCompressor::kDefaultSettings._shellDistance, &boneError, &objectError);
+  TASSERT_E(boneError, stats._maxBoneError);
+  TASSERT_E(objectError, stats._maxObjectError);
+
+  // Without reduction, every key of a moving channel stays.
+  ClipCompressor::Settings settings = ClipCompressor::kDefaultSettings;
+  settings._reduceKeys = false;
+  AnimClip full;
+  ClipCompressor::Stats fullStats = ClipCompressor::compress(raw, &full, settings);
+  TASSERT_E(full._tracks[1]._channels[ANIM_CHANNEL_ROTATION]._keyCount, 61);
+  TASSERT_G(fullStats._keptKeys, stats._keptKeys);
+  TASSERT_LE(fullStats._maxObjectError, settings._maxObjectError);
+
+  // Roots travelling far, with a wobble on the way, are too wide to quantize, and keep their 
+  // keys at full precision. Joints below them still quantize.
+  ClipCompressor::RawClip travel = raw;
+  for (U32 k = 0; k <= 60; ++k) {
+    R32 t = k / 60.0f;
+    travel._tracks[0]._translations[k] = Vector3(40.0f * t, 0.01f * std::sin(40.0f * t), 0.0f);
+  }
+  AnimClip traveled;
+  ClipCompressor::Stats travelStats = ClipCompressor::compress(travel, &traveled);
+  TASSERT_LE(travelStats._maxBoneError, ClipCompressor::kDefaultSettings._maxBoneError);
+  TASSERT_LE(travelStats._maxObjectError, ClipCompressor::kDefaultSettings._maxObjectError);
+  TASSERT_E(traveled._tracks[0]._channels[ANIM_CHANNEL_TRANSLATION]._keyWidth, kAnimFullRangeWidth);
+  TASSERT_E(traveled._tracks[1]._channels[ANIM_CHANNEL_ROTATION]._keyWidth, kAnimKeyWidth);
+  TASSERT_E(travelStats._compressedBytes, traveled.getKeyByteSize());
+
+  return true;
+}
+
+
+B8 TestAnimationJobs()
+{
+  Log() << "\n\nAnimation Jobs\n\n";
+
+  // Node 0 slides along x, a unit a second, played back at a different rate by each handle.
+  ClipCompressor::RawClip raw;
+  raw._duration = 10.0f;
+  raw._fps = 60.0f;
+  raw._looping = true;
+  raw._morphTargetCount = 0;
+  raw._tracks.resize(1);
+  raw._tracks[0]._nodeId = 0;
+  raw._tracks[0]._parent = ClipCompressor::kNoParentTrack;
+  raw._tracks[0]._times[ANIM_CHANNEL_TRANSLATION] = { 0.0f, 10.0f };
+  raw._tracks[0]._translations.push_back(Vector3(0.0f, 0.0f, 0.0f));
+  raw._tracks[0]._translations.push_back(Vector3(10.0f, 0.0f, 0.0f));
+  AnimClip clip;
+  ClipCompressor::compress(raw, &clip);
+  clip.bindSkeleton(nullptr);
+
+  // Enough handles to spread over several batches.
+  const U32 kHandleCount = 100;
+  std::vector<AnimHandle*> handles;
+  for (U32 i = 0; i < kHandleCount; ++i) {
+    AnimHandle* pHandle = gAnimation().createAnimHandle(UUID64(0xA000 + i));
+    TASSERT_NE(pHandle, nullptr);
+    pHandle->_currState._fPlaybackRate = 1.0f + (i % 4);
+    handles.push_back(pHandle);
+
+    AnimJobSubmitInfo info = { };
+    info._type = ANIM_JOB_TYPE_SAMPLE;
+    info._pBaseClip = &clip;
+    info._output = pHandle;
+    gAnimation().submitJob(info);
+  }
+
+  // Jobs write the back palettes, and the renderer still sees the rest pose.
+  gAnimation().updateState(1.0);
+  for (AnimHandle* pHandle : handles) {
+    TASSERT_E(pHandle->_backReady, true);
+    TASSERT_E(pHandle->getPalette()[0].Data[3][0], 0.0f);
+  }
+
+  // Once published, each handle shows its own pose.
+  gAnimation().swapBuffers();
+  for (AnimHandle* pHandle : handles) {
+    TASSERT_E(pHandle->_backReady, false);
+    TASSERT_L(std::fabs(pHandle->getPalette()[0].Data[3][0] - pHandle->_currState._fPlaybackRate), 1e-3f);
+  }
+
+  // Handles without a job this frame keep what they show.
+  gAnimation().updateState(1.0);
+  gAnimation().swapBuffers();
+  for (AnimHandle* pHandle : handles) {
+    TASSERT_L(std::fabs(pHandle->getPalette()[0].Data[3][0] - pHandle->_currState._fPlaybackRate), 1e-3f);
+    gAnimation().freeAnimHandle(pHandle);
+  }
+
+  return true;
+}
+
+B8 TestAnimationLod()
+{
+  Log() << "\n\nAnimation Lod\n\n";
+
+  // Node 0 slides along x, a unit a second, and morph target 0 follows it at a tenth the rate.
+  ClipCompressor::RawClip raw;
+  raw._duration = 10.0f;
+  raw._fps = 60.0f;
+  raw._looping = true;
+  raw._morphTargetCount = 1;
+  raw._morphTimes = { 0.0f, 10.0f };
+  raw._morphWeights = { 0.0f, 1.0f };
+  raw._tracks.resize(1);
+  raw._tracks[0]._nodeId = 0;
+  raw._tracks[0]._parent = ClipCompressor::kNoParentTrack;
+  raw._tracks[0]._times[ANIM_CHANNEL_TRANSLATION] = { 0.0f, 10.0f };
+  raw._tracks[0]._translations.push_back(Vector3(0.0f, 0.0f, 0.0f));
+  raw._tracks[0]._translations.push_back(Vector3(10.0f, 0.0f, 0.0f));
+  AnimClip clip;
+  ClipCompressor::compress(raw, &clip);
+  clip.bindSkeleton(nullptr);
+
+  // Large instances sample every frame, small ones every other frame, morphs included.
+  std::vector<AnimLodPolicy> saved(gAnimation().getLodPolicies(), 
+                                   gAnimation().getLodPolicies() + gAnimation().getLodCount());
+  AnimLodPolicy policies[2] = { { 0.5f, 1, 0, false }, { 0.0f, 2, 0, false } };
+  gAnimation().setLodPolicies(policies, 2);
+
+  AnimHandle* pNear = gAnimation().createAnimHandle(UUID64(0xC000));
+  AnimHandle* pFar = gAnimation().createAnimHandle(UUID64(0xC001));
+  AnimHandle* pHidden = gAnimation().createAnimHandle(UUID64(0xC002));
+  pFar->_screenSize = 0.1f;
+  pHidden->_visible = false;
+
+  // Expected x of the far handle shown each frame, a sample behind, morphs alike.
+  const R32 kFarX[4] = { 1.0f, 1.0f, 1.0f, 2.0f };
+  for (U32 frame = 0; frame < 4; ++frame) {
+    AnimHandle* handles[3] = { pNear, pFar, pHidden };
+    for (AnimHandle* pHandle : handles) {
+      AnimJobSubmitInfo info = { };
+      info._type = ANIM_JOB_TYPE_SAMPLE;
+      info._pBaseClip = &clip;
+      info._output = pHandle;
+      gAnimation().submitJob(info);
+    }
+    gAnimation().updateState(1.0);
+
+    // Every other frame of the far handle interpolates, and hidden ones are never sampled.
+    const AnimFrameStats& stats = gAnimation().getFrameStats();
+    B32 sampleFrame = (frame % 2) == 0;
+    TASSERT_E(stats._sampled, (sampleFrame ? 2u : 1u));
+    TASSERT_E(stats._interpolated, (sampleFrame ? 0u : 1u));
+    TASSERT_E(stats._culled, 1);
+    TASSERT_E(pFar->_lod, 1);
+    TASSERT_E(pHidden->_backReady, false);
+
+    gAnimation().swapBuffers();
+    TASSERT_L(std::fabs(pNear->getPalette()[0].Data[3][0] - (frame + 1.0f)), 1e-3f);
+    TASSERT_L(std::fabs(pFar->getPalette()[0].Data[3][0] - kFarX[frame]), 1e-3f);
+    TASSERT_E(pNear->getMorphs().size(), 1);
+    TASSERT_E(pFar->getMorphs().size(), 1);
+    TASSERT_L(std::fabs(pNear->getMorphs()[0] - (frame + 1.0f) * 0.1f), 1e-4f);
+    TASSERT_L(std::fabs(pFar->getMorphs()[0] - kFarX[frame] * 0.1f), 1e-4f);
+    TASSERT_E(pHidden->getPalette()[0].Data[3][0], 0.0f);
+
+    // Clocks keep time either way.
+    TASSERT_L(std::fabs(pFar->_currState._fCurrLocalTime - (frame + 1.0f)), 1e-4f);
+    TASSERT_L(std::fabs(pHidden->_currState._fCurrLocalTime - (frame + 1.0f)), 1e-4f);
+  }
+
+  // Coming into view samples right away.
+  pHidden->_visible = true;
+  AnimJobSubmitInfo info = { };
+  info._type = ANIM_JOB_TYPE_SAMPLE;
+  info._pBaseClip = &clip;
+  info._output = pHidden;
+  gAnimation().submitJob(info);
+  gAnimation().updateState(1.0);
+  gAnimation().swapBuffers();
+  TASSERT_E(gAnimation().getFrameStats()._sampled, 1);
+  TASSERT_L(std::fabs(pHidden->getPalette()[0].Data[3][0] - 5.0f), 1e-3f);
+
+  gAnimation().setLodPolicies(saved.data(), static_cast<U32>(saved.size()));
+  gAnimation().freeAnimHandle(pNear);
+  gAnimation().freeAnimHandle(pFar);
+  gAnimation().freeAnimHandle(pHidden);
+  return true;
+}
+
+// Clip holding node 0 at x, and node 1 turned by angle around y.
+static void MakeStillClip(ClipCompressor::RawClip* pRaw, R32 x, R32 angle)
+{
+  pRaw->_duration = 10.0f;
+  pRaw->_fps = 60.0f;
+  pRaw->_looping = true;
+  pRaw->_morphTargetCount = 0;
+  pRaw->_tracks.resize(2);
+  for (U32 i = 0; i < 2; ++i) {
+    pRaw->_tracks[i]._nodeId = i;
+    pRaw->_tracks[i]._parent = ClipCompressor::kNoParentTrack;
+  }
+  pRaw->_tracks[0]._times[ANIM_CHANNEL_TRANSLATION] = { 0.0f };
+  pRaw->_tracks[0]._translations.push_back(Vector3(x, 0.0f, 0.0f));
+  pRaw->_tracks[1]._times[ANIM_CHANNEL_ROTATION] = { 0.0f };
+  pRaw->_tracks[1]._rotations.push_back(Quaternion(0.0f, std::sin(0.5f * angle), 0.0f, std::cos(0.5f * angle)));
+}
+
+
+static AnimClipState MakeLayerState()
+{
+  AnimClipState state;
+  state._fCurrLocalTime = 0.0f;
+  state._fWeight = 1.0f;
+  state._fPlaybackRate = 1.0f;
+  state._bEnabled = true;
+  state._bLooping = true;
+  state._tau = 0.0f;
+  return state;
+}
+
+
+B8 TestAnimationBlend()
+{
+  Log() << "\n\nAnimation Blend\n\n";
+  const R32 kQuarter = 0.5f * 3.14159265f;
+
+  // Walking holds node 0 at 2, and node 1 straight. Waving holds node 0 at 4, and turns node 1
+  // a quarter around.
+  ClipCompressor::RawClip walkRaw, waveRaw;
+  MakeStillClip(&walkRaw, 2.0f, 0.0f);
+  MakeStillClip(&waveRaw, 4.0f, kQuarter);
+  AnimClip walk, wave, waveAdditive, still;
+  ClipCompressor::compress(walkRaw, &walk);
+  ClipCompressor::compress(waveRaw, &wave);
+  ClipCompressor::RawClip stillRaw = walkRaw;
+  ClipCompressor::makeAdditive(&stillRaw, walkRaw);
+  ClipCompressor::makeAdditive(&waveRaw, walkRaw);
+  ClipCompressor::compress(stillRaw, &still);
+  ClipCompressor::compress(waveRaw, &waveAdditive);
+
+  // A clip less itself differs nowhere, and costs no keys.
+  for (const AnimTrack& track : still._tracks) {
+    for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+      TASSERT_E(track._channels[c]._keyCount, 0);
+    }
+  }
+
+  AnimClipState layerStates[3] = { MakeLayerState(), MakeLayerState(), MakeLayerState() };
+  AnimHandle* pBlended = gAnimation().createAnimHandle(UUID64(0xB000));
+  AnimHandle* pLayered = gAnimation().createAnimHandle(UUID64(0xB001));
+  AnimHandle* pAdditive = gAnimation().createAnimHandle(UUID64(0xB002));
+
+  // An even blend, halfway between the two.
+  AnimJobSubmitInfo blend = { };
+  blend._type = ANIM_JOB_TYPE_BLEND;
+  blend._pBaseClip = &walk;
+  blend._output = pBlended;
+  AnimBlendLayer waveLayer;
+  waveLayer._pClip = &wave;
+  waveLayer._pState = &layerStates[0];
+  blend._layers.push_back(waveLayer);
+  gAnimation().submitJob(blend);
+
+  // Waving over walking, masked off node 0.
+  AnimJobSubmitInfo layered = { };
+  layered._type = ANIM_JOB_TYPE_LAYERED_BLEND;
+  layered._pBaseClip = &walk;
+  layered._output = pLayered;
+  AnimBlendLayer maskedLayer;
+  maskedLayer._pClip = &wave;
+  maskedLayer._pState = &layerStates[1];
+  maskedLayer._jointWeights[0] = 0.0f;
+  layered._layers.push_back(maskedLayer);
+  gAnimation().submitJob(layered);
+
+  // Half the difference waving makes, added over walking.
+  AnimJobSubmitInfo additive = { };
+  additive._type = ANIM_JOB_TYPE_LAYERED_BLEND;
+  additive._pBaseClip = &walk;
+  additive._output = pAdditive;
+  AnimBlendLayer additiveLayer;
+  additiveLayer._pClip = &waveAdditive;
+  additiveLayer._pState = &layerStates[2];
+  additiveLayer._weight = 0.5f;
+  additive._additiveLayers.push_back(additiveLayer);
+  gAnimation().submitJob(additive);
+
+  gAnimation().updateState(0.5);
+  gAnimation().swapBuffers();
+
+  // Layers keep clocks of their own.
+  TASSERT_L(std::fabs(layerStates[0]._fCurrLocalTime - 0.5f), 1e-5f);
+  TASSERT_L(std::fabs(pBlended->_currState._fCurrLocalTime - 0.5f), 1e-5f);
+
+  const R32 kHalfTurn = std::cos(0.5f * kQuarter);
+  TASSERT_L(std::fabs(pBlended->getPalette()[0].Data[3][0] - 3.0f), 1e-3f);
+  TASSERT_L(std::fabs(pBlended->getPalette()[1].Data[0][0] - kHalfTurn), 1e-3f);
+  TASSERT_L(std::fabs(pLayered->getPalette()[0].Data[3][0] - 2.0f), 1e-3f);
+  TASSERT_L(std::fabs(pLayered->getPalette()[1].Data[0][0]), 1e-3f);
+  TASSERT_L(std::fabs(pAdditive->getPalette()[0].Data[3][0] - 3.0f), 1e-3f);
+  TASSERT_L(std::fabs(pAdditive->getPalette()[1].Data[0][0] - kHalfTurn), 1e-3f);
+
+  // Weighting the base out leaves the layer alone.
+  pBlended->_currState._fWeight = 0.0f;
+  gAnimation().submitJob(blend);
+  gAnimation().updateState(0.5);
+  gAnimation().swapBuffers();
+  TASSERT_L(std::fabs(pBlended->getPalette()[0].Data[3][0] - 4.0f), 1e-3f);
+  TASSERT_L(std::fabs(pBlended->getPalette()[1].Data[0][0]), 1e-3f);
+
+  gAnimation().freeAnimHandle(pBlended);
+  gAnimation().freeAnimHandle(pLayered);
+  gAnimation().freeAnimHandle(pAdditive);
+  return true;
+}
+} // Test
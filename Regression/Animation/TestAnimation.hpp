@@ -0,0 +1,18 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Types.hpp"
+#include "Core/Logging/Log.hpp"
+
+
+using namespace Recluse;
+
+namespace Test {
+
+
+B8 TestAnimationClip();
+B8 TestClipCompressor();
+B8 TestAnimationJobs();
+B8 TestAnimationLod();
+B8 TestAnimationBlend();
+} // Test
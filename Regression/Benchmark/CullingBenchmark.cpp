@@ -0,0 +1,135 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+// Benchmark of batch frustum culling, ViewFrustum::cullBatch, at 10k, 100k, and 1M boxes against
+// a camera and three shadow cascade frustums. Every supported instruction set is measured, on one
+// thread and spread across the thread pool, and checked against ViewFrustum::intersect.
+#include "Core/Types.hpp"
+#include "Core/Logging/Log.hpp"
+#include "Core/Math/Matrix4.hpp"
+#include "Core/Math/ViewFrustum.hpp"
+#include "Core/Math/Common.hpp"
+#include "Core/Math/SIMD.hpp"
+#include "Core/Thread/Threading.hpp"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+
+#define BENCH_FRUSTUMS    4
+#define BENCH_BATCH_SIZE  4096
+#define BENCH_MIN_BOXES   (1 << 22)
+
+using namespace Recluse;
+
+
+struct BoxSoA {
+  std::vector<R32> cx, cy, cz, ex, ey, ez;
+};
+
+
+// Returns millions of boxes culled per second.
+static R64 Measure(size_t count, std::function<void()> func)
+{
+  // Warm up, and run enough iterations to cull a few million boxes.
+  func();
+  U32 iterations = static_cast<U32>(R_Max(static_cast<size_t>(1), BENCH_MIN_BOXES / count));
+  auto start = std::chrono::high_resolution_clock::now();
+  for (U32 i = 0; i < iterations; ++i) {
+    func();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  R64 seconds = std::chrono::duration<R64>(end - start).count();
+  return (static_cast<R64>(count) * iterations) / seconds / 1000000.0;
+}
+
+
+int main(int c, char* argv[])
+{
+  Log::displayToConsole(true);
+  ThreadPool pool;
+  pool.RunAll();
+
+  // Camera, and three shadow cascades covering increasing distances.
+  ViewFrustum frustums[BENCH_FRUSTUMS];
+  const ViewFrustum* frustumPtrs[BENCH_FRUSTUMS];
+  Matrix4 view = Matrix4::lookAt(Vector3(0.0f, 30.0f, -400.0f), Vector3(0.0f, 0.0f, 0.0f), Vector3::UP);
+  Matrix4 vp = view * Matrix4::perspective(Radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+  frustums[0].update(vp);
+  Matrix4 lightView = Matrix4::lookAt(Vector3(300.0f, 500.0f, -300.0f), Vector3(0.0f, 0.0f, 0.0f), Vector3::UP);
+  for (U32 i = 1; i < BENCH_FRUSTUMS; ++i) {
+    R32 size = 100.0f * static_cast<R32>(1 << (i * 2));
+    Matrix4 lvp = lightView * Matrix4::ortho(size, size, 0.1f, 2000.0f);
+    frustums[i].update(lvp);
+  }
+  for (U32 i = 0; i < BENCH_FRUSTUMS; ++i) frustumPtrs[i] = &frustums[i];
+
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<R32> position(-1500.0f, 1500.0f);
+  std::uniform_real_distribution<R32> extent(0.5f, 20.0f);
+
+  SIMDInstructionSet supported = getSupportedSIMDInstructionSet();
+  B32 passed = true;
+  Log() << std::setw(10) << "Boxes" << std::setw(10) << "Set" << std::setw(18) << "1 thread (M/s)"
+        << std::setw(18) << "Pool (M/s)" << std::setw(12) << "Visible" << std::setw(12) << "Mismatch" << "\n";
+
+  const size_t counts[] = { 10000, 100000, 1000000 };
+  for (size_t count : counts) {
+    BoxSoA boxes;
+    std::vector<AABB> aabbs(count);
+    for (size_t i = 0; i < count; ++i) {
+      Vector3 center(position(rng), position(rng) * 0.1f, position(rng));
+      Vector3 e(extent(rng), extent(rng), extent(rng));
+      aabbs[i].min = center - e;
+      aabbs[i].max = center + e;
+      boxes.cx.push_back(center.x); boxes.cy.push_back(center.y); boxes.cz.push_back(center.z);
+      boxes.ex.push_back(e.x); boxes.ey.push_back(e.y); boxes.ez.push_back(e.z);
+    }
+
+    // Reference masks, from testing one box against one frustum at a time.
+    std::vector<U32> reference(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+      for (U32 f = 0; f < BENCH_FRUSTUMS; ++f) {
+        if (frustums[f].intersect(aabbs[i]) != ViewFrustum::Result_Outside) reference[i] |= (1u << f);
+      }
+    }
+
+    std::vector<U32> masks(count);
+    auto cullRange = [&] (U32 start, U32 end) -> void {
+      ViewFrustum::cullBatch(frustumPtrs, BENCH_FRUSTUMS,
+        boxes.cx.data() + start, boxes.cy.data() + start, boxes.cz.data() + start,
+        boxes.ex.data() + start, boxes.ey.data() + start, boxes.ez.data() + start,
+        masks.data() + start, end - start);
+    };
+
+    for (I32 set = SIMD_SCALAR; set <= static_cast<I32>(supported); ++set) {
+      setSIMDInstructionSet(static_cast<SIMDInstructionSet>(set));
+      R64 singleRate = Measure(count, [&] () { cullRange(0, static_cast<U32>(count)); });
+      R64 poolRate = Measure(count, [&] () {
+        JobCounter counter;
+        pool.ParallelFor(static_cast<U32>(count), BENCH_BATCH_SIZE, cullRange, &counter);
+        pool.WaitForCounter(&counter);
+      });
+
+      size_t visible = 0;
+      size_t mismatches = 0;
+      for (size_t i = 0; i < count; ++i) {
+        if (masks[i] & 1) ++visible;
+        if (masks[i] != reference[i]) ++mismatches;
+      }
+      passed = passed && (mismatches == 0);
+
+      Log() << std::setw(10) << count
+            << std::setw(10) << getSIMDInstructionSetName(static_cast<SIMDInstructionSet>(set))
+            << std::setw(18) << singleRate << std::setw(18) << poolRate
+            << std::setw(12) << visible << std::setw(12) << mismatches << "\n";
+    }
+  }
+
+  pool.StopAll();
+  if (!passed) {
+    Log(rError) << "Batch cull results differ from ViewFrustum::intersect!\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+// Micro benchmark of the batch math routines, comparing throughput of every supported 
+// instruction set against the scalar path, and checking results stay within tolerance.
+#include "Core/Types.hpp"
+#include "Core/Logging/Log.hpp"
+#include "Core/Math/Matrix4.hpp"
+#include "Core/Math/Quaternion.hpp"
+#include "Core/Math/Vector3.hpp"
+#include "Core/Math/Common.hpp"
+#include "Core/Math/SIMD.hpp"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+
+#define BENCH_COUNT       4096
+#define BENCH_ITERATIONS  2000
+#define BENCH_TOLERANCE   0.0001f
+
+using namespace Recluse;
+
+
+// Returns millions of elements processed per second.
+static R64 Measure(std::function<void()> func)
+{
+  // Warm up.
+  func();
+  auto start = std::chrono::high_resolution_clock::now();
+  for (U32 i = 0; i < BENCH_ITERATIONS; ++i) {
+    func();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  R64 seconds = std::chrono::duration<R64>(end - start).count();
+  return (static_cast<R64>(BENCH_COUNT) * BENCH_ITERATIONS) / seconds / 1000000.0;
+}
+
+
+static R32 MaxError(const R32* a, const R32* b, size_t count)
+{
+  R32 err = 0.0f;
+  for (size_t i = 0; i < count; ++i) {
+    err = R_Max(err, fabsf(a[i] - b[i]) / R_Max(1.0f, fabsf(a[i])));
+  }
+  return err;
+}
+
+
+int main(int c, char* argv[])
+{
+  Log::displayToConsole(true);
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<R32> dist(-1.0f, 1.0f);
+  std::vector<Matrix4> lhs(BENCH_COUNT), rhs(BENCH_COUNT), mats(BENCH_COUNT), matsRef(BENCH_COUNT);
+  std::vector<Vector3> points(BENCH_COUNT), pointsOut(BENCH_COUNT), pointsRef(BENCH_COUNT);
+  std::vector<Quaternion> q0(BENCH_COUNT), q1(BENCH_COUNT), quats(BENCH_COUNT), quatsRef(BENCH_COUNT);
+  for (size_t i = 0; i < BENCH_COUNT; ++i) {
+    q0[i] = Quaternion::angleAxis(dist(rng) * 3.0f, Vector3(dist(rng), dist(rng) + 2.0f, dist(rng)).normalize());
+    q1[i] = Quaternion::angleAxis(dist(rng) * 3.0f, Vector3(dist(rng) + 2.0f, dist(rng), dist(rng)).normalize());
+    lhs[i] = q0[i].toMatrix4();
+    rhs[i] = q1[i].toMatrix4();
+    points[i] = Vector3(dist(rng), dist(rng), dist(rng)) * 50.0f;
+  }
+
+  SIMDInstructionSet supported = getSupportedSIMDInstructionSet();
+  setSIMDInstructionSet(SIMD_SCALAR);
+  Matrix4::multiplyBatch(matsRef.data(), lhs.data(), rhs.data(), BENCH_COUNT);
+  Matrix4::transformPoints(pointsRef.data(), points.data(), lhs[0], BENCH_COUNT);
+  Quaternion::slerpBatch(quatsRef.data(), q0.data(), q1.data(), 0.25f, BENCH_COUNT);
+
+  B32 passed = true;
+  Log() << std::setw(10) << "Set" << std::setw(18) << "Mat4 mul (M/s)" 
+        << std::setw(18) << "Points (M/s)" << std::setw(18) << "Slerp (M/s)" << std::setw(14) << "Max error" << "\n";
+  for (I32 set = SIMD_SCALAR; set <= static_cast<I32>(supported); ++set) {
+    setSIMDInstructionSet(static_cast<SIMDInstructionSet>(set));
+    R64 mulRate = Measure([&] () { Matrix4::multiplyBatch(mats.data(), lhs.data(), rhs.data(), BENCH_COUNT); });
+    R64 pointRate = Measure([&] () { Matrix4::transformPoints(pointsOut.data(), points.data(), lhs[0], BENCH_COUNT); });
+    R64 slerpRate = Measure([&] () { Quaternion::slerpBatch(quats.data(), q0.data(), q1.data(), 0.25f, BENCH_COUNT); });
+
+    R32 err = MaxError(matsRef[0].Data[0], mats[0].Data[0], BENCH_COUNT * 16);
+    err = R_Max(err, MaxError(&pointsRef[0].x, &pointsOut[0].x, BENCH_COUNT * 3));
+    err = R_Max(err, MaxError(&quatsRef[0].x, &quats[0].x, BENCH_COUNT * 4));
+    passed = passed && (err <= BENCH_TOLERANCE);
+
+    Log() << std::setw(10) << getSIMDInstructionSetName(static_cast<SIMDInstructionSet>(set))
+          << std::setw(18) << mulRate << std::setw(18) << pointRate << std::setw(18) << slerpRate
+          << std::setw(14) << err << "\n";
+  }
+
+  if (!passed) {
+    Log(rError) << "Batch math results out of tolerance!\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestGameObject.hpp"
+#include "../Tester.hpp"
+#include "Core/Core.hpp"
+#include "Game/ComponentRegistry.hpp"
+
+#include <atomic>
+#include <vector>
+
+
+namespace Test {
+
+
+struct TestEntry {
+  U32 _value;
+  U32 _updates;
+};
+
+
+B8 TestComponentRegistry()
+{
+  Log() << "\n\nComponent Registry\n\n";
+  const U32 kCount = 5000;
+  std::vector<TestEntry> entries(kCount);
+  std::vector<component_handle_t> handles(kCount);
+  ComponentRegistry<TestEntry> registry;
+
+  for (U32 i = 0; i < kCount; ++i) {
+    entries[i]._value = i;
+    entries[i]._updates = 0;
+    handles[i] = registry.add(&entries[i]);
+  }
+  TASSERT_E(registry.size(), kCount);
+
+  // Remove every third entry, handles of the rest must still find them.
+  for (U32 i = 0; i < kCount; i += 3) {
+    registry.remove(handles[i]);
+  }
+  TASSERT_E(registry.size(), kCount - (kCount + 2) / 3);
+  for (U32 i = 0; i < kCount; ++i) {
+    B32 removed = (i % 3) == 0;
+    TASSERT_E(registry.contains(handles[i]), !removed);
+    if (!removed) {
+      TASSERT_E(registry.get(handles[i])->_value, i);
+    }
+  }
+
+  // Freed handles are reused, and stay valid.
+  for (U32 i = 0; i < kCount; i += 3) {
+    handles[i] = registry.add(&entries[i]);
+  }
+  TASSERT_E(registry.size(), kCount);
+  for (U32 i = 0; i < kCount; ++i) {
+    TASSERT_E(registry.get(handles[i])->_value, i);
+  }
+
+  // Every entry is visited exactly once, from whichever thread.
+  std::atomic<U32> visited(0);
+  registry.parallelForEach(&gCore().ThrPool(), 64, [&] (TestEntry* pEntry) -> void {
+    pEntry->_updates++;
+    visited.fetch_add(1);
+  });
+  TASSERT_E(visited.load(), kCount);
+  for (U32 i = 0; i < kCount; ++i) {
+    TASSERT_E(entries[i]._updates, 1);
+  }
+
+  for (U32 i = 0; i < kCount; ++i) {
+    registry.remove(handles[i]);
+  }
+  TASSERT_E(registry.empty(), true);
+  return true;
+}
+} // Test
@@ -12,4 +12,12 @@ namespace Test {
 
 B8 TestGameObject();
 B8 TestGameObjectManager();
+B8 TestOctree();
+B8 TestOcclusionCuller();
+B8 TestComponentRegistry();
+B8 TestWorldPartition();
+B8 TestModelCooker();
+B8 TestMeshOptimizer();
+B8 TestResourceRegistry();
+B8 TestMeshLod();
 } // Recluse
\ No newline at end of file
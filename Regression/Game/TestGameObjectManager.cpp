@@ -0,0 +1,72 @@
+// Copyright (c) 2017 Recluse Project. All rights reserved.
+#include "TestGameObject.hpp"
+#include "../Tester.hpp"
+#include "Game/GameObject.hpp"
+#include "Game/GameObjectManager.hpp"
+
+#include <vector>
+#include <random>
+
+#define MANAGER_OBJECT_COUNT 20000
+#define MANAGER_CHURN_OPS 200000
+
+
+namespace Test {
+
+
+B8 TestGameObjectManager()
+{
+  Log() << "\n\nGame Object Manager\n\n";
+  GameObjectManager manager;
+  std::vector<GameObjectHandle> handles;
+
+  for (U32 i = 0; i < MANAGER_OBJECT_COUNT; ++i) {
+    GameObject* obj = manager.allocate();
+    TASSERT_NE(obj, nullptr);
+    TASSERT_E(manager.get(obj->getHandle()), obj);
+    handles.push_back(obj->getHandle());
+  }
+  TASSERT_E(manager.NumOccupied(), MANAGER_OBJECT_COUNT);
+  size_t chunkCount = manager.NumChunks();
+
+  // Destroyed objects leave stale handles behind, even once their slot is reused.
+  GameObjectHandle stale = handles[0];
+  manager.Deallocate(stale);
+  TASSERT_E(manager.isValid(stale), false);
+  TASSERT_E(manager.get(stale), nullptr);
+  GameObject* reused = manager.allocate();
+  TASSERT_E(reused->getHandle()._index, stale._index);
+  TASSERT_NE(reused->getHandle(), stale);
+  TASSERT_E(manager.get(stale), nullptr);
+  handles[0] = reused->getHandle();
+
+  // Spawn and despawn churn should be served by free slots, without new chunks.
+  std::mt19937 rng(1234);
+  for (U32 op = 0; op < MANAGER_CHURN_OPS; ++op) {
+    size_t idx = rng() % handles.size();
+    manager.Deallocate(handles[idx]);
+    handles[idx] = manager.allocate()->getHandle();
+  }
+  TASSERT_E(manager.NumChunks(), chunkCount);
+  TASSERT_E(manager.NumOccupied(), MANAGER_OBJECT_COUNT);
+
+  // Iteration visits every live object once, in slot order.
+  size_t visited = 0;
+  B8 ordered = true;
+  GameObject* prev = nullptr;
+  manager.forEach([&] (GameObject* obj) -> void {
+    if (!manager.isValid(obj->getHandle())) ordered = false;
+    if (prev && prev->getHandle()._index >= obj->getHandle()._index) ordered = false;
+    ++visited;
+    prev = obj;
+  });
+  TASSERT_E(visited, MANAGER_OBJECT_COUNT);
+  TASSERT_E(ordered, true);
+
+  manager.clear();
+  TASSERT_E(manager.NumOccupied(), 0);
+  TASSERT_E(manager.isValid(handles[0]), false);
+  TASSERT_E(manager.NumChunks(), chunkCount);
+  return true;
+}
+} // Test
@@ -0,0 +1,82 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestGameObject.hpp"
+#include "../Tester.hpp"
+#include "Game/Camera.hpp"
+#include "Game/RendererComponent.hpp"
+#include "Renderer/Mesh.hpp"
+
+
+namespace Test {
+
+
+// Exposes how renderer components pick the level of detail of their meshes.
+class LodRendererComponent : public AbstractRendererComponent {
+public:
+  using AbstractRendererComponent::updateLod;
+  using AbstractRendererComponent::getMeshLod;
+
+  void setPixelsPerUnit(R32 pixelsPerUnit) { m_lodPixelsPerUnit = pixelsPerUnit; }
+};
+
+
+// One primitive per level, each level with the given error, in mesh units.
+static void PushLods(Mesh& mesh, U32 lodCount, const R32* errors)
+{
+  Primitive primitive = { };
+  for (U32 lod = 0; lod < lodCount; ++lod) {
+    mesh.pushPrimitive(primitive, lod);
+    mesh.setLodError(lod, errors[lod]);
+  }
+}
+
+
+B8 TestMeshLod()
+{
+  Log() << "\n\nMesh Level of Detail\n\n";
+
+  const R32 errors[] = { 0.0f, 0.01f, 0.1f, 1.0f };
+  Mesh mesh;
+  PushLods(mesh, 4, errors);
+  TASSERT_E(mesh.getLodCount(), 4);
+
+  // The coarsest level whose error stays within the allowed pixels on screen is picked.
+  TASSERT_E(mesh.selectLod(1000.0f, 1.0f), 0);
+  TASSERT_E(mesh.selectLod(50.0f, 1.0f), 1);
+  TASSERT_E(mesh.selectLod(5.0f, 1.0f), 2);
+  TASSERT_E(mesh.selectLod(0.5f, 1.0f), 3);
+  TASSERT_E(mesh.selectLod(5.0f, 10.0f), 3);
+  TASSERT_E(mesh.selectLod(std::numeric_limits<R32>::max(), 1.0f), 0);
+
+  // Meshes with one level only ever draw that one.
+  Mesh single;
+  PushLods(single, 1, errors);
+  TASSERT_E(single.getLodCount(), 1);
+  TASSERT_E(single.selectLod(0.5f, 1.0f), 0);
+
+  // The bias moves the level picked, as far as the mesh has levels.
+  LodRendererComponent component;
+  TASSERT_E(component.getMeshLod(&mesh, 0.0f), 0);
+  TASSERT_E(component.getMeshLod(&mesh, 2.0f), 2);
+  TASSERT_E(component.getMeshLod(&mesh, 10.0f), 3);
+  TASSERT_E(component.getMeshLod(&mesh, -1.0f), 0);
+  TASSERT_E(component.getMeshLod(&single, 2.0f), 0);
+
+  component.enableAutoLod(true);
+  component.setPixelsPerUnit(50.0f);
+  TASSERT_E(component.getMeshLod(&mesh, 0.0f), 1);
+  TASSERT_E(component.getMeshLod(&mesh, 1.0f), 2);
+  TASSERT_E(component.getMeshLod(&mesh, 5.0f), 3);
+  TASSERT_E(component.getMeshLod(&mesh, -3.0f), 0);
+  TASSERT_E(component.getMeshLod(&single, 0.0f), 0);
+
+  // Without a main camera nothing tells how large meshes show, and they stay at full detail.
+  if (!Camera::getMain()) {
+    Transform transform;
+    component.updateLod(&transform);
+    TASSERT_E(component.getMeshLod(&mesh, 0.0f), 0);
+    TASSERT_E(component.getCurrentLod(), 0.0f);
+  }
+
+  return true;
+}
+} // Test
@@ -0,0 +1,368 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestGameObject.hpp"
+#include "../Tester.hpp"
+#include "Game/Scene/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+namespace Test {
+
+
+struct GridVertex {
+  R32 _position[3];
+  R32 _uv[2];
+};
+
+
+// Triangles of a grid, each with its own copy of its vertices, in a scrambled order.
+static void BuildScrambledGrid(U32 n, std::vector<GridVertex>& vertices, std::vector<U32>& indices)
+{
+  std::vector<U32> quads(n * n);
+  for (U32 i = 0; i < n * n; ++i) quads[i] = i;
+  U32 seed = 1234567u;
+  for (U32 i = n * n - 1; i > 0; --i) {
+    seed = seed * 1664525u + 1013904223u;
+    std::swap(quads[i], quads[(seed >> 8) % (i + 1)]);
+  }
+
+  for (U32 q : quads) {
+    U32 x = q % n;
+    U32 y = q / n;
+    U32 corners[2][3][2] = { { { x, y }, { x + 1, y }, { x + 1, y + 1 } },
+                             { { x, y }, { x + 1, y + 1 }, { x, y + 1 } } };
+    for (U32 t = 0; t < 2; ++t) {
+      for (U32 c = 0; c < 3; ++c) {
+        GridVertex v;
+        v._position[0] = static_cast<R32>(corners[t][c][0]);
+        v._position[1] = static_cast<R32>(corners[t][c][1]);
+        v._position[2] = 0.0f;
+        v._uv[0] = v._position[0] / n;
+        v._uv[1] = v._position[1] / n;
+        indices.push_back(static_cast<U32>(vertices.size()));
+        vertices.push_back(v);
+      }
+    }
+  }
+}
+
+
+// Indexed grid. With a seam, the columns right of the middle use their own copies of the
+// middle vertices, with different texture coordinates.
+static void BuildGrid(U32 n, B8 seam, std::vector<GridVertex>& vertices, std::vector<U32>& indices)
+{
+  U32 half = n / 2;
+  auto vertex = [&] (U32 x, U32 y, B8 right) -> U32 {
+    GridVertex v;
+    v._position[0] = static_cast<R32>(x);
+    v._position[1] = static_cast<R32>(y);
+    v._position[2] = 0.0f;
+    v._uv[0] = static_cast<R32>(x) / n + (right ? 1.0f : 0.0f);
+    v._uv[1] = static_cast<R32>(y) / n;
+    vertices.push_back(v);
+    return static_cast<U32>(vertices.size() - 1);
+  };
+
+  std::vector<U32> left((n + 1) * (n + 1));
+  std::vector<U32> right((n + 1) * (n + 1));
+  for (U32 y = 0; y <= n; ++y) {
+    for (U32 x = 0; x <= n; ++x) {
+      left[y * (n + 1) + x] = vertex(x, y, false);
+      right[y * (n + 1) + x] = (seam && x == half) ? vertex(x, y, true) : left[y * (n + 1) + x];
+    }
+  }
+
+  for (U32 y = 0; y < n; ++y) {
+    for (U32 x = 0; x < n; ++x) {
+      const std::vector<U32>& chart = (seam && x >= half) ? right : left;
+      U32 a = chart[y * (n + 1) + x];
+      U32 b = chart[y * (n + 1) + x + 1];
+      U32 c = chart[(y + 1) * (n + 1) + x + 1];
+      U32 d = chart[(y + 1) * (n + 1) + x];
+      U32 quad[6] = { a, b, c, a, c, d };
+      indices.insert(indices.end(), quad, quad + 6);
+    }
+  }
+}
+
+
+// Sphere of stacks by slices quads, its radius scattered by up to a third, with triangles in a 
+// scrambled order.
+static void BuildBumpySphere(U32 stacks, U32 slices, U32 seed, std::vector<GridVertex>& vertices, 
+                             std::vector<U32>& indices)
+{
+  const R32 kPi = 3.14159265f;
+  for (U32 i = 0; i <= stacks; ++i) {
+    for (U32 j = 0; j <= slices; ++j) {
+      seed = seed * 1664525u + 1013904223u;
+      R32 radius = 1.0f + (static_cast<R32>(seed >> 8) / 16777216.0f - 0.5f) * 0.6f;
+      R32 theta = kPi * i / stacks;
+      R32 phi = 2.0f * kPi * j / slices;
+      GridVertex v;
+      v._position[0] = radius * std::sin(theta) * std::cos(phi);
+      v._position[1] = radius * std::cos(theta);
+      v._position[2] = radius * std::sin(theta) * std::sin(phi);
+      v._uv[0] = static_cast<R32>(j) / slices;
+      v._uv[1] = static_cast<R32>(i) / stacks;
+      vertices.push_back(v);
+    }
+  }
+
+  for (U32 i = 0; i < stacks; ++i) {
+    for (U32 j = 0; j < slices; ++j) {
+      U32 a = i * (slices + 1) + j;
+      U32 c = a + slices + 1;
+      U32 quad[6] = { a, c, a + 1, a + 1, c, c + 1 };
+      indices.insert(indices.end(), quad, quad + 6);
+    }
+  }
+
+  for (size_t t = indices.size() / 3 - 1; t > 0; --t) {
+    seed = seed * 1664525u + 1013904223u;
+    size_t other = (seed >> 8) % (t + 1);
+    for (U32 k = 0; k < 3; ++k) std::swap(indices[t * 3 + k], indices[other * 3 + k]);
+  }
+}
+
+
+// Area facing +z, minus the area facing away.
+static R32 SignedArea(const std::vector<GridVertex>& vertices, const U32* indices, size_t indexCount)
+{
+  R32 area = 0.0f;
+  for (size_t i = 0; i < indexCount; i += 3) {
+    const R32* p0 = vertices[indices[i]]._position;
+    const R32* p1 = vertices[indices[i + 1]]._position;
+    const R32* p2 = vertices[indices[i + 2]]._position;
+    area += 0.5f * ((p1[0] - p0[0]) * (p2[1] - p0[1]) - (p1[1] - p0[1]) * (p2[0] - p0[0]));
+  }
+  return area;
+}
+
+
+// Triangles as sorted vertex triples, so that reordering, and rotating, triangles compares equal.
+static std::vector<U64> TriangleSet(const U32* indices, size_t indexCount)
+{
+  std::vector<U64> set;
+  for (size_t i = 0; i < indexCount; i += 3) {
+    U64 tri[3] = { indices[i], indices[i + 1], indices[i + 2] };
+    std::sort(tri, tri + 3);
+    set.push_back((tri[0] << 42) | (tri[1] << 21) | tri[2]);
+  }
+  std::sort(set.begin(), set.end());
+  return set;
+}
+
+
+// Winding must survive reordering, so check each triangle is a rotation of one in the source.
+static B8 SameWinding(const U32* a, const U32* b, size_t indexCount)
+{
+  std::vector<U64> source;
+  for (size_t i = 0; i < indexCount; i += 3) {
+    U64 smallest = std::min(a[i], std::min(a[i + 1], a[i + 2]));
+    U32 first = a[i] == smallest ? 0 : (a[i + 1] == smallest ? 1 : 2);
+    source.push_back((smallest << 42) | (static_cast<U64>(a[i + (first + 1) % 3]) << 21) | a[i + (first + 2) % 3]);
+  }
+  std::sort(source.begin(), source.end());
+  for (size_t i = 0; i < indexCount; i += 3) {
+    U64 smallest = std::min(b[i], std::min(b[i + 1], b[i + 2]));
+    U32 first = b[i] == smallest ? 0 : (b[i + 1] == smallest ? 1 : 2);
+    U64 key = (smallest << 42) | (static_cast<U64>(b[i + (first + 1) % 3]) << 21) | b[i + (first + 2) % 3];
+    if (!std::binary_search(source.begin(), source.end(), key)) return false;
+  }
+  return true;
+}
+
+
+static B8 TestSimplify()
+{
+  const U32 kGrid = 32;
+  const R32 kWeights[2] = { 1.0f, 1.0f };
+
+  // A flat grid simplifies down to its target without any error, or holes.
+  {
+    std::vector<GridVertex> vertices;
+    std::vector<U32> indices;
+    BuildGrid(kGrid, false, vertices, indices);
+    std::vector<U32> lod(indices.size());
+    R32 error = 1.0f;
+    size_t target = indices.size() / 4;
+    size_t count = MeshOptimizer::simplify(lod.data(), indices.data(), indices.size(),
+                                           vertices.data(), sizeof(GridVertex), vertices.size(),
+                                           target, 1.0f, &error);
+    TASSERT_LE(count, target);
+    TASSERT_NE(count, 0);
+    TASSERT_L(error, 0.001f);
+    TASSERT_L(std::fabs(SignedArea(vertices, lod.data(), count) - kGrid * kGrid), 0.01f);
+
+    // Corners of the grid are held by the border.
+    std::vector<U8> corners(vertices.size(), 0);
+    for (size_t i = 0; i < count; ++i) corners[lod[i]] = 1;
+    TASSERT_E(corners[0], 1);
+    TASSERT_E(corners[kGrid], 1);
+    TASSERT_E(corners[kGrid * (kGrid + 1)], 1);
+    TASSERT_E(corners[(kGrid + 1) * (kGrid + 1) - 1], 1);
+  }
+
+  // Curved surfaces report their error, and stay within the bound asked for.
+  {
+    std::vector<GridVertex> vertices;
+    std::vector<U32> indices;
+    BuildGrid(kGrid, false, vertices, indices);
+    for (GridVertex& v : vertices) {
+      v._position[2] = 2.0f * std::sin(v._position[0] * 0.3f) * std::cos(v._position[1] * 0.2f);
+    }
+    std::vector<U32> lod(indices.size());
+    R32 coarseError = 0.0f;
+    size_t coarse = MeshOptimizer::simplify(lod.data(), indices.data(), indices.size(),
+                                            vertices.data(), sizeof(GridVertex), vertices.size(),
+                                            indices.size() / 10, 100.0f, &coarseError);
+    TASSERT_LE(coarse, indices.size() / 10);
+    TASSERT_G(coarseError, 0.0f);
+
+    R32 boundedError = 0.0f;
+    const R32 kBound = coarseError * 0.25f;
+    size_t bounded = MeshOptimizer::simplify(lod.data(), indices.data(), indices.size(),
+                                             vertices.data(), sizeof(GridVertex), vertices.size(),
+                                             0, kBound, &boundedError);
+    TASSERT_LE(boundedError, kBound);
+    TASSERT_G(bounded, coarse);
+    TASSERT_L(bounded, indices.size());
+  }
+
+  // Both sides of a seam collapse together, so that it never opens up.
+  {
+    std::vector<GridVertex> vertices;
+    std::vector<U32> indices;
+    BuildGrid(kGrid, true, vertices, indices);
+    std::vector<U32> lod(indices.size());
+    size_t count = MeshOptimizer::simplify(lod.data(), indices.data(), indices.size(),
+                                           vertices.data(), sizeof(GridVertex), vertices.size(),
+                                           indices.size() / 4, 1.0f, nullptr,
+                                           vertices.data()->_uv, sizeof(GridVertex), kWeights, 2);
+    TASSERT_LE(count, indices.size() / 4);
+    TASSERT_L(std::fabs(SignedArea(vertices, lod.data(), count) - kGrid * kGrid), 0.01f);
+
+    std::vector<U8> leftSeam(kGrid + 1, 0);
+    std::vector<U8> rightSeam(kGrid + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+      const GridVertex& v = vertices[lod[i]];
+      if (v._position[0] != kGrid / 2) continue;
+      U32 y = static_cast<U32>(v._position[1]);
+      if (v._uv[0] >= 1.0f) rightSeam[y] = 1;
+      else leftSeam[y] = 1;
+    }
+    TASSERT_E((leftSeam == rightSeam), true);
+  }
+  return true;
+}
+
+
+B8 TestMeshOptimizer()
+{
+  Log() << "\n\nMesh Optimizer\n\n";
+
+  const U32 kGrid = 32;
+  std::vector<GridVertex> vertices;
+  std::vector<U32> indices;
+  BuildScrambledGrid(kGrid, vertices, indices);
+  TASSERT_E(indices.size(), kGrid * kGrid * 6);
+
+  // Duplicates merge into one vertex per grid point.
+  MeshOptimizer::VertexStream stream = { vertices.data(), sizeof(GridVertex) };
+  std::vector<U32> remap(vertices.size());
+  size_t unique = MeshOptimizer::generateVertexRemap(remap.data(), indices.data(), indices.size(),
+                                                     vertices.size(), &stream, 1);
+  TASSERT_E(unique, (kGrid + 1) * (kGrid + 1));
+
+  std::vector<GridVertex> merged(unique);
+  MeshOptimizer::remapVertices(merged.data(), vertices.data(), vertices.size(), sizeof(GridVertex), remap.data());
+  MeshOptimizer::remapIndices(indices.data(), indices.data(), indices.size(), remap.data());
+  vertices.swap(merged);
+  for (U32 i = 0; i < indices.size(); ++i) {
+    TASSERT_L(indices[i], unique);
+  }
+
+  // Cache order beats the scrambled order, and keeps every triangle.
+  const std::vector<U32> source = indices;
+  MeshOptimizer::CacheStats before = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), unique);
+  MeshOptimizer::optimizeVertexCache(indices.data(), indices.data(), indices.size(), unique);
+  MeshOptimizer::CacheStats after = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), unique);
+  Log() << "ACMR " << before._acmr << " -> " << after._acmr << ", ATVR " << before._atvr << " -> " << after._atvr << "\n";
+  TASSERT_L(after._acmr, before._acmr);
+  TASSERT_L(after._acmr, 1.0f);
+  TASSERT_GE(after._atvr, 1.0f);
+  TASSERT_E((TriangleSet(indices.data(), indices.size()) == TriangleSet(source.data(), source.size())), true);
+  TASSERT_E(SameWinding(source.data(), indices.data(), indices.size()), true);
+
+  // Overdraw ordering gives up little of the cache efficiency.
+  std::vector<U32> overdraw(indices.size());
+  MeshOptimizer::optimizeOverdraw(overdraw.data(), indices.data(), indices.size(),
+                                  vertices.data(), sizeof(GridVertex), unique);
+  MeshOptimizer::CacheStats sorted = MeshOptimizer::analyzeVertexCache(overdraw.data(), overdraw.size(), unique);
+  TASSERT_LE(sorted._acmr, after._acmr * MeshOptimizer::kOverdrawThreshold + 0.0001f);
+  TASSERT_E(SameWinding(source.data(), overdraw.data(), overdraw.size()), true);
+  indices.swap(overdraw);
+
+  // Closed shapes too, whose clusters share many vertices across their boundaries.
+  for (U32 s = 0; s < 16; ++s) {
+    std::vector<GridVertex> sphere;
+    std::vector<U32> sphereIndices;
+    BuildBumpySphere(6 + s * 2, 8 + s * 3, s, sphere, sphereIndices);
+    MeshOptimizer::optimizeVertexCache(sphereIndices.data(), sphereIndices.data(), sphereIndices.size(), sphere.size());
+    MeshOptimizer::CacheStats cached = MeshOptimizer::analyzeVertexCache(sphereIndices.data(), sphereIndices.size(), sphere.size());
+    std::vector<U32> sphereOverdraw(sphereIndices.size());
+    MeshOptimizer::optimizeOverdraw(sphereOverdraw.data(), sphereIndices.data(), sphereIndices.size(),
+                                    sphere.data(), sizeof(GridVertex), sphere.size());
+    MeshOptimizer::CacheStats reordered = MeshOptimizer::analyzeVertexCache(sphereOverdraw.data(), sphereOverdraw.size(), sphere.size());
+    TASSERT_LE(reordered._acmr, cached._acmr * MeshOptimizer::kOverdrawThreshold + 0.0001f);
+    TASSERT_E(SameWinding(sphereIndices.data(), sphereOverdraw.data(), sphereOverdraw.size()), true);
+  }
+
+  // Fetch order numbers vertices by first use.
+  U32 used = static_cast<U32>(MeshOptimizer::optimizeVertexFetchRemap(remap.data(), indices.data(),
+                                                                      indices.size(), unique));
+  TASSERT_E(used, unique);
+  MeshOptimizer::remapIndices(indices.data(), indices.data(), indices.size(), remap.data());
+  std::vector<GridVertex> fetched(unique);
+  MeshOptimizer::remapVertices(fetched.data(), vertices.data(), unique, sizeof(GridVertex), remap.data());
+  vertices.swap(fetched);
+  U32 next = 0;
+  for (U32 i = 0; i < indices.size(); ++i) {
+    TASSERT_LE(indices[i], next);
+    if (indices[i] == next) next++;
+  }
+
+  // Meshlets stay within their limits, and cover every triangle once.
+  std::vector<MeshOptimizer::Meshlet> meshlets;
+  std::vector<U32> meshletVertices;
+  std::vector<U8> meshletTriangles;
+  size_t meshletCount = MeshOptimizer::buildMeshlets(meshlets, meshletVertices, meshletTriangles,
+                                                     indices.data(), indices.size(), unique);
+  TASSERT_E(meshletCount, meshlets.size());
+  TASSERT_NE(meshletCount, 0);
+
+  std::vector<U32> rebuilt;
+  for (const MeshOptimizer::Meshlet& meshlet : meshlets) {
+    TASSERT_LE(meshlet._vertexCount, MeshOptimizer::kMaxMeshletVertices);
+    TASSERT_LE(meshlet._triangleCount, MeshOptimizer::kMaxMeshletTriangles);
+    TASSERT_NE(meshlet._triangleCount, 0);
+    for (U32 t = 0; t < meshlet._triangleCount * 3; ++t) {
+      U8 local = meshletTriangles[meshlet._triangleOffset + t];
+      TASSERT_L(local, meshlet._vertexCount);
+      rebuilt.push_back(meshletVertices[meshlet._vertexOffset + local]);
+    }
+
+    // A flat grid faces straight along z, so its cone is tight.
+    MeshOptimizer::MeshletBounds bounds = MeshOptimizer::computeMeshletBounds(meshlet,
+      meshletVertices.data(), meshletTriangles.data(), vertices.data(), sizeof(GridVertex));
+    TASSERT_G(bounds._radius, 0.0f);
+    TASSERT_L(std::fabs(std::fabs(bounds._coneAxis[2]) - 1.0f), 0.001f);
+    TASSERT_L(bounds._coneCutoff, 0.001f);
+  }
+  TASSERT_E(rebuilt.size(), indices.size());
+  TASSERT_E(std::equal(rebuilt.begin(), rebuilt.end(), indices.begin()), true);
+  return TestSimplify();
+}
+} // Test
@@ -0,0 +1,272 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestGameObject.hpp"
+#include "../Tester.hpp"
+#include "Filesystem/Filesystem.hpp"
+#include "Game/Scene/ModelLoader.hpp"
+#include "Game/Scene/CookedModel.hpp"
+#include "Game/Scene/MeshOptimizer.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+namespace Test {
+
+
+// Checks every mesh's index and primitive ranges against its own vertices.
+static B8 CheckCookedMeshes(const CookedModelView& view)
+{
+  const CookedMesh* meshes = view.getBlock<CookedMesh>(COOKED_BLOCK_MESHES);
+  const CookedPrimitive* primitives = view.getBlock<CookedPrimitive>(COOKED_BLOCK_PRIMITIVES);
+  const U32* indices = view.getBlock<U32>(COOKED_BLOCK_INDICES);
+  for (U32 i = 0; i < view.getCount<CookedMesh>(COOKED_BLOCK_MESHES); ++i) {
+    const CookedMesh& mesh = meshes[i];
+    TASSERT_NE(mesh._vertexCount, 0);
+    TASSERT_E(mesh._vertexOffset % kCookedBlockAlignment, 0);
+    for (U32 idx = 0; idx < mesh._indexCount; ++idx) {
+      TASSERT_L(indices[mesh._firstIndex + idx], mesh._vertexCount);
+    }
+    U32 primitiveIndices = 0;
+    for (U32 p = 0; p < mesh._primitiveCount; ++p) {
+      const CookedPrimitive& primitive = primitives[mesh._firstPrimitive + p];
+      TASSERT_LE(primitive._firstIndex + primitive._indexCount, mesh._indexCount);
+      primitiveIndices += primitive._indexCount;
+    }
+    TASSERT_E(primitiveIndices, mesh._indexCount);
+
+    // Every level of detail has fewer triangles than the one before it, over the same vertices.
+    const CookedLod* lods = view.getBlock<CookedLod>(COOKED_BLOCK_LODS);
+    U32 previousIndices = mesh._indexCount;
+    R32 previousError = 0.0f;
+    U32 lodIndices = 0;
+    for (U32 l = 0; l < mesh._lodCount; ++l) {
+      const CookedLod& lod = lods[mesh._firstLod + l];
+      U32 levelIndices = 0;
+      for (U32 p = 0; p < lod._primitiveCount; ++p) {
+        const CookedPrimitive& primitive = primitives[lod._firstPrimitive + p];
+        TASSERT_GE(primitive._firstIndex, mesh._indexCount);
+        for (U32 idx = 0; idx < primitive._indexCount; ++idx) {
+          TASSERT_L(indices[mesh._firstIndex + primitive._firstIndex + idx], mesh._vertexCount);
+        }
+        levelIndices += primitive._indexCount;
+      }
+      TASSERT_L(levelIndices, previousIndices);
+      TASSERT_GE(lod._error, previousError);
+      previousIndices = levelIndices;
+      previousError = lod._error;
+      lodIndices += levelIndices;
+    }
+    TASSERT_E(lodIndices, mesh._lodIndexCount);
+    for (U32 axis = 0; axis < 3; ++axis) {
+      TASSERT_LE(mesh._min[axis], mesh._max[axis]);
+    }
+  }
+  return true;
+}
+
+
+B8 TestModelCooker()
+{
+  Log() << "\n\nModel Cooker\n\n";
+
+  const std::string kSkinned = "RegressionRiggedSimple.rmdl";
+  const std::string kMorphed = "RegressionAnimatedMorphCube.rmdl";
+  const std::string kTextured = "RegressionDamagedHelmet.rmdl";
+  const std::string kTexturedAgain = "RegressionDamagedHelmet2.rmdl";
+  const std::string kMeshlets = "RegressionRiggedSimpleMeshlets.rmdl";
+
+  TASSERT_E((ModelLoader::cook("Assets/RiggedSimple.gltf", kSkinned) & ModelLoader::Model_Fail), 0);
+  TASSERT_E((ModelLoader::cook("Assets/AnimatedMorphCube.gltf", kMorphed) & ModelLoader::Model_Fail), 0);
+  TASSERT_NE((ModelLoader::cook("Assets/Missing.obj", "RegressionMissing.rmdl") & ModelLoader::Model_Fail), 0);
+
+  {
+    FileView file;
+    TASSERT_E(gFilesystem().MapFile(kSkinned.c_str(), &file), FilesystemResult_Success);
+
+    CookedModelView view;
+    TASSERT_E(view.open(file.data(), file.size()), true);
+    const CookedModelHeader& header = view.getHeader();
+    TASSERT_E(header._magic, kCookedModelMagic);
+    TASSERT_E(header._version, kCookedModelVersion);
+    TASSERT_E(header._size, file.size());
+    TASSERT_NE((header._resultBits & ModelLoader::Model_Animated), 0);
+    for (U32 i = 0; i < COOKED_BLOCK_COUNT; ++i) {
+      TASSERT_E(header._blocks[i]._offset % kCookedBlockAlignment, 0);
+    }
+
+    TASSERT_NE(view.getCount<CookedMesh>(COOKED_BLOCK_MESHES), 0);
+    TASSERT_E(view.getCount<CookedSkeleton>(COOKED_BLOCK_SKELETONS), 1);
+    TASSERT_NE(view.getCount<CookedClip>(COOKED_BLOCK_CLIPS), 0);
+    TASSERT_E(CheckCookedMeshes(view), true);
+
+    const CookedSkeleton& skeleton = view.getBlock<CookedSkeleton>(COOKED_BLOCK_SKELETONS)[0];
+    TASSERT_NE(skeleton._jointCount, 0);
+    const CookedMesh& mesh = view.getBlock<CookedMesh>(COOKED_BLOCK_MESHES)[0];
+    TASSERT_NE((mesh._flags & COOKED_MESH_SKINNED_BIT), 0);
+    TASSERT_E(mesh._skeleton, 0);
+
+    U32 skinnedNodes = 0;
+    const CookedNode* nodes = view.getBlock<CookedNode>(COOKED_BLOCK_NODES);
+    for (U32 i = 0; i < view.getCount<CookedNode>(COOKED_BLOCK_NODES); ++i) {
+      if (nodes[i]._nodeConfig & ModelLoader::Model_Skinned) skinnedNodes++;
+    }
+    TASSERT_E(skinnedNodes, 1);
+
+    // Every joint of the skeleton has a track of its own, with keys in order.
+    const CookedClip& clip = view.getBlock<CookedClip>(COOKED_BLOCK_CLIPS)[0];
+    const CookedTrack* tracks = view.getBlock<CookedTrack>(COOKED_BLOCK_TRACKS);
+    const CookedJoint* joints = view.getBlock<CookedJoint>(COOKED_BLOCK_JOINTS);
+    const R32* times = view.getBlock<R32>(COOKED_BLOCK_KEY_TIMES);
+    TASSERT_E(clip._trackCount, skeleton._jointCount);
+    TASSERT_G(clip._duration, 0.0f);
+    for (U32 i = 0; i < clip._trackCount; ++i) {
+      const CookedTrack& track = tracks[clip._firstTrack + i];
+      B32 found = false;
+      for (U32 j = 0; j < skeleton._jointCount; ++j) {
+        if (joints[skeleton._firstJoint + j]._id == track._nodeId) found = true;
+      }
+      TASSERT_E(found, true);
+      TASSERT_NE(track._channels[ANIM_CHANNEL_ROTATION]._keyCount, 0);
+      for (U32 c = 0; c < ANIM_CHANNEL_COUNT; ++c) {
+        const CookedChannel& channel = track._channels[c];
+        for (U32 k = 1; k < channel._keyCount; ++k) {
+          TASSERT_LE(times[channel._firstKey + k - 1], times[channel._firstKey + k]);
+        }
+        if (channel._keyCount) {
+          TASSERT_LE(times[channel._firstKey + channel._keyCount - 1], clip._duration);
+        }
+      }
+    }
+
+    // Names resolve through the string block.
+    TASSERT_E(view.getString(skeleton._name).compare("Armature"), 0);
+    CookedString bad = { 0xFFFFFFF0, 64 };
+    TASSERT_E(view.getString(bad).empty(), true);
+
+    // Damaged data is refused.
+    std::vector<U8> copy(file.data(), file.data() + file.size());
+    TASSERT_E(view.open(copy.data(), copy.size() - 1), false);
+    TASSERT_E(view.open(copy.data(), sizeof(CookedModelHeader) - 1), false);
+
+    reinterpret_cast<CookedModelHeader*>(copy.data())->_version = kCookedModelVersion + 1;
+    TASSERT_E(view.open(copy.data(), copy.size()), false);
+    reinterpret_cast<CookedModelHeader*>(copy.data())->_version = kCookedModelVersion;
+    TASSERT_E(view.open(copy.data(), copy.size()), true);
+
+    CookedMesh* pMeshes = reinterpret_cast<CookedMesh*>(copy.data() + header._blocks[COOKED_BLOCK_MESHES]._offset);
+    U32 indexCount = pMeshes[0]._indexCount;
+    pMeshes[0]._indexCount = 0xFFFFFFFF;
+    TASSERT_E(view.open(copy.data(), copy.size()), false);
+    pMeshes[0]._indexCount = indexCount;
+
+    // So are indices past the vertices, and joints parented outside their skeleton.
+    U32* pIndices = reinterpret_cast<U32*>(copy.data() + header._blocks[COOKED_BLOCK_INDICES]._offset);
+    U32 index = pIndices[pMeshes[0]._firstIndex];
+    pIndices[pMeshes[0]._firstIndex] = pMeshes[0]._vertexCount;
+    TASSERT_E(view.open(copy.data(), copy.size()), false);
+    pIndices[pMeshes[0]._firstIndex] = index;
+    TASSERT_E(view.open(copy.data(), copy.size()), true);
+
+    CookedJoint* pJoints = reinterpret_cast<CookedJoint*>(copy.data() + header._blocks[COOKED_BLOCK_JOINTS]._offset);
+    pJoints[0]._parent = skeleton._jointCount;
+    TASSERT_E(view.open(copy.data(), copy.size()), false);
+  }
+
+  {
+    FileView file;
+    TASSERT_E(gFilesystem().MapFile(kMorphed.c_str(), &file), FilesystemResult_Success);
+
+    CookedModelView view;
+    TASSERT_E(view.open(file.data(), file.size()), true);
+    TASSERT_E(view.getCount<CookedSkeleton>(COOKED_BLOCK_SKELETONS), 0);
+    TASSERT_E(CheckCookedMeshes(view), true);
+
+    const CookedMesh& mesh = view.getBlock<CookedMesh>(COOKED_BLOCK_MESHES)[0];
+    const CookedMorphTarget* targets = view.getBlock<CookedMorphTarget>(COOKED_BLOCK_MORPH_TARGETS);
+    TASSERT_E((mesh._flags & COOKED_MESH_SKINNED_BIT), 0);
+    TASSERT_NE(mesh._morphTargetCount, 0);
+    for (U32 i = 0; i < mesh._morphTargetCount; ++i) {
+      TASSERT_E(targets[mesh._firstMorphTarget + i]._vertexCount, mesh._vertexCount);
+    }
+
+    // Weight keys carry one weight per morph target.
+    TASSERT_NE(view.getCount<CookedClip>(COOKED_BLOCK_CLIPS), 0);
+    const CookedClip& clip = view.getBlock<CookedClip>(COOKED_BLOCK_CLIPS)[0];
+    TASSERT_E(clip._morphTargetCount, mesh._morphTargetCount);
+    TASSERT_NE(clip._morphs._keyCount, 0);
+
+    // Morph targets that do not cover their mesh are refused, even when they lie within the
+    // morph vertices.
+    std::vector<U8> copy(file.data(), file.data() + file.size());
+    CookedMorphTarget* pTargets = reinterpret_cast<CookedMorphTarget*>(
+      copy.data() + view.getHeader()._blocks[COOKED_BLOCK_MORPH_TARGETS]._offset);
+    pTargets[mesh._firstMorphTarget]._vertexCount -= 1;
+    TASSERT_E(view.open(copy.data(), copy.size()), false);
+    pTargets[mesh._firstMorphTarget]._vertexCount += 1;
+    TASSERT_E(view.open(copy.data(), copy.size()), true);
+  }
+
+  // Meshlets, when asked for, cover every index of their primitive.
+  TASSERT_E((ModelLoader::cook("Assets/RiggedSimple.gltf", kMeshlets,
+    ModelLoader::Import_OptimizeMeshes | ModelLoader::Import_BuildMeshlets) & ModelLoader::Model_Fail), 0);
+  {
+    FileView file;
+    TASSERT_E(gFilesystem().MapFile(kMeshlets.c_str(), &file), FilesystemResult_Success);
+
+    CookedModelView view;
+    TASSERT_E(view.open(file.data(), file.size()), true);
+    TASSERT_E(CheckCookedMeshes(view), true);
+
+    const CookedMesh& mesh = view.getBlock<CookedMesh>(COOKED_BLOCK_MESHES)[0];
+    const CookedPrimitive* primitives = view.getBlock<CookedPrimitive>(COOKED_BLOCK_PRIMITIVES);
+    const CookedMeshlet* meshlets = view.getBlock<CookedMeshlet>(COOKED_BLOCK_MESHLETS);
+    TASSERT_NE(mesh._meshletCount, 0);
+    for (U32 p = 0; p < mesh._primitiveCount; ++p) {
+      const CookedPrimitive& primitive = primitives[mesh._firstPrimitive + p];
+      U32 triangles = 0;
+      for (U32 m = 0; m < primitive._meshletCount; ++m) {
+        const CookedMeshlet& meshlet = meshlets[mesh._firstMeshlet + primitive._firstMeshlet + m];
+        TASSERT_LE(meshlet._vertexCount, MeshOptimizer::kMaxMeshletVertices);
+        TASSERT_LE(meshlet._triangleCount, MeshOptimizer::kMaxMeshletTriangles);
+        triangles += meshlet._triangleCount;
+      }
+      TASSERT_E(triangles * 3, primitive._indexCount);
+    }
+  }
+
+  // Images are decoded, and meshes converted, in parallel. Output must not depend on the order
+  // the jobs ran in.
+  TASSERT_E((ModelLoader::cook("Assets/DamagedHelmet/DamagedHelmet.gltf", kTextured) & ModelLoader::Model_Fail), 0);
+  TASSERT_E((ModelLoader::cook("Assets/DamagedHelmet/DamagedHelmet.gltf", kTexturedAgain) & ModelLoader::Model_Fail), 0);
+  {
+    FileView file;
+    FileView again;
+    TASSERT_E(gFilesystem().MapFile(kTextured.c_str(), &file), FilesystemResult_Success);
+    TASSERT_E(gFilesystem().MapFile(kTexturedAgain.c_str(), &again), FilesystemResult_Success);
+    TASSERT_E(file.size(), again.size());
+    TASSERT_E(memcmp(file.data(), again.data(), file.size()), 0);
+
+    CookedModelView view;
+    TASSERT_E(view.open(file.data(), file.size()), true);
+    TASSERT_E(CheckCookedMeshes(view), true);
+    TASSERT_NE(view.getBlock<CookedMesh>(COOKED_BLOCK_MESHES)[0]._lodCount, 0);
+
+    const CookedTexture* textures = view.getBlock<CookedTexture>(COOKED_BLOCK_TEXTURES);
+    TASSERT_E(view.getCount<CookedTexture>(COOKED_BLOCK_TEXTURES), 5);
+    for (U32 i = 0; i < view.getCount<CookedTexture>(COOKED_BLOCK_TEXTURES); ++i) {
+      TASSERT_NE(textures[i]._width, 0);
+      TASSERT_NE(textures[i]._height, 0);
+      TASSERT_E(textures[i]._texelSize, static_cast<U64>(textures[i]._width) * textures[i]._height * 4);
+    }
+  }
+
+  remove(kSkinned.c_str());
+  remove(kMorphed.c_str());
+  remove(kTextured.c_str());
+  remove(kTexturedAgain.c_str());
+  remove(kMeshlets.c_str());
+  return true;
+}
+} // Test
@@ -0,0 +1,109 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestGameObject.hpp"
+#include "../Tester.hpp"
+#include "Core/Math/Matrix4.hpp"
+#include "Core/Math/SIMD.hpp"
+#include "Game/Visibility/OcclusionCuller.hpp"
+
+#include <cstdio>
+#include <vector>
+
+
+namespace Test {
+
+
+static AABB MakeBox(const Vector3& center, const Vector3& extent)
+{
+  AABB aabb;
+  aabb.min = center - extent;
+  aabb.max = center + extent;
+  return aabb;
+}
+
+
+B8 TestOcclusionCuller()
+{
+  Log() << "\n\nOcclusion Culler\n\n";
+
+  // Wall of two triangles on the z = 0 plane, 10 units wide, facing the camera.
+  OccluderMesh wall;
+  wall._positions = {
+    Vector3(-5.0f, -5.0f, 0.0f), Vector3( 5.0f, -5.0f, 0.0f),
+    Vector3( 5.0f,  5.0f, 0.0f), Vector3(-5.0f,  5.0f, 0.0f)
+  };
+  wall._indices = { 0, 1, 2, 0, 2, 3 };
+
+  OcclusionCuller culler;
+  Matrix4 view = Matrix4::lookAt(Vector3(0.0f, 0.0f, -10.0f), Vector3(), Vector3(0.0f, 1.0f, 0.0f));
+  Matrix4 proj = Matrix4::perspective(Radians(60.0f),
+    static_cast<R32>(culler.getWidth()) / static_cast<R32>(culler.getHeight()), 0.1f, 1000.0f);
+  Matrix4 viewProjection = view * proj;
+
+  // Nothing rasterized yet, everything is visible.
+  culler.render(viewProjection, nullptr);
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(0.0f, 0.0f, 5.0f), Vector3(1.0f, 1.0f, 1.0f))), true);
+
+  occluder_id_t id = culler.addOccluder(&wall);
+  culler.render(viewProjection, nullptr);
+  TASSERT_E(culler.getRasterizedTriangleCount(), 2);
+
+  // Behind the wall.
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(0.0f, 0.0f, 5.0f), Vector3(1.0f, 1.0f, 1.0f))), false);
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(1.0f, -2.0f, 40.0f), Vector3(3.0f, 3.0f, 3.0f))), false);
+  // In front of the wall, straddling it, peeking past its edge, and beside it.
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(0.0f, 0.0f, -5.0f), Vector3(1.0f, 1.0f, 1.0f))), true);
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f))), true);
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(0.0f, 0.0f, 5.0f), Vector3(8.0f, 1.0f, 1.0f))), true);
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(9.0f, 0.0f, 5.0f), Vector3(1.0f, 1.0f, 1.0f))), true);
+  // Crossing the near plane.
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(0.0f, 0.0f, -10.0f), Vector3(1.0f, 1.0f, 1.0f))), true);
+
+  // Moving the wall aside uncovers the box.
+  culler.setOccluderTransform(id, Matrix4::translate(Matrix4::identity(), Vector3(12.0f, 0.0f, 0.0f)));
+  culler.render(viewProjection, nullptr);
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(0.0f, 0.0f, 5.0f), Vector3(1.0f, 1.0f, 1.0f))), true);
+  culler.setOccluderTransform(id, Matrix4::identity());
+
+  // Every instruction set must produce the same depth buffer.
+  SIMDInstructionSet supported = getSIMDInstructionSet();
+  setSIMDInstructionSet(SIMD_SCALAR);
+  culler.render(viewProjection, nullptr);
+  std::vector<R32> scalar(culler.getDepthBuffer(), culler.getDepthBuffer() + culler.getWidth() * culler.getHeight());
+  setSIMDInstructionSet(supported);
+  culler.render(viewProjection, nullptr);
+  U32 mismatches = 0;
+  U32 covered = 0;
+  for (size_t i = 0; i < scalar.size(); ++i) {
+    if (scalar[i] != culler.getDepthBuffer()[i]) ++mismatches;
+    if (scalar[i] > 0.0f) ++covered;
+  }
+  Log() << "covered " << covered << " pixels with " << getSIMDInstructionSetName(supported) << "\n";
+  TASSERT_E(mismatches, 0);
+  TASSERT_G(covered, 0);
+
+  // Culled primitives are counted by callers, and reset each render.
+  culler.addCulledPrimitives(3);
+  culler.addCulledPrimitives(2);
+  TASSERT_E(culler.getCulledPrimitiveCount(), 5);
+  culler.render(viewProjection, nullptr);
+  TASSERT_E(culler.getCulledPrimitiveCount(), 0);
+
+  const char* path = "OcclusionDepth.pgm";
+  TASSERT_E(culler.dumpDepthBuffer(path), true);
+  FILE* file = fopen(path, "rb");
+  TASSERT_E(file != nullptr, true);
+  if (file) {
+    U32 width = 0, height = 0, maxValue = 0;
+    TASSERT_E(fscanf(file, "P5 %u %u %u", &width, &height, &maxValue), 3);
+    TASSERT_E(width, culler.getWidth());
+    TASSERT_E(height, culler.getHeight());
+    fclose(file);
+    remove(path);
+  }
+
+  culler.removeOccluder(id);
+  culler.render(viewProjection, nullptr);
+  TASSERT_E(culler.testAABB(MakeBox(Vector3(0.0f, 0.0f, 5.0f), Vector3(1.0f, 1.0f, 1.0f))), true);
+  return true;
+}
+} // Test
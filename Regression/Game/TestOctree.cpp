@@ -0,0 +1,117 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestGameObject.hpp"
+#include "../Tester.hpp"
+#include "Core/Math/Matrix4.hpp"
+#include "Game/Visibility/Octree.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+
+namespace Test {
+
+
+static AABB RandomBox(std::mt19937& rng)
+{
+  std::uniform_real_distribution<R32> position(-600.0f, 600.0f);
+  std::uniform_real_distribution<R32> size(0.1f, 40.0f);
+  Vector3 center(position(rng), position(rng), position(rng));
+  // Few large proxies, and few outside of the world bounds.
+  R32 s = (rng() % 50 == 0) ? 300.0f : size(rng);
+  Vector3 extent(s, s * 0.5f, s * 0.75f);
+  AABB aabb;
+  aabb.min = center - extent;
+  aabb.max = center + extent;
+  return aabb;
+}
+
+
+B8 TestOctree()
+{
+  Log() << "\n\nOctree\n\n";
+  std::mt19937 rng(42);
+  Octree tree(Vector3(), 512.0f, 6);
+
+  const U32 kCount = 2000;
+  std::vector<AABB> boxes(kCount);
+  std::vector<octree_proxy_t> proxies(kCount, Octree::kInvalidProxy);
+  for (U32 i = 0; i < kCount; ++i) {
+    boxes[i] = RandomBox(rng);
+    proxies[i] = tree.insert(boxes[i], &boxes[i]);
+  }
+
+  // Move all, then remove every third proxy.
+  for (U32 i = 0; i < kCount; ++i) {
+    boxes[i] = RandomBox(rng);
+    tree.move(proxies[i], boxes[i]);
+  }
+  for (U32 i = 0; i < kCount; i += 3) {
+    tree.remove(proxies[i]);
+    proxies[i] = Octree::kInvalidProxy;
+  }
+  TASSERT_E(tree.getProxyCount(), kCount - (kCount + 2) / 3);
+
+  // Queries must find exactly what testing every proxy finds.
+  auto check = [&] (std::vector<octree_proxy_t>& found, std::vector<octree_proxy_t>& expected) -> B8 {
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    Log() << "found " << found.size() << " of " << tree.getProxyCount() << "\n";
+    return found == expected;
+  };
+
+  Matrix4 view = Matrix4::lookAt(Vector3(0.0f, 20.0f, -300.0f), Vector3(), Vector3::UP);
+  Matrix4 vp = view * Matrix4::perspective(Radians(60.0f), 1.5f, 0.1f, 800.0f);
+  ViewFrustum frustum;
+  frustum.update(vp);
+  Sphere sphere(Vector3(50.0f, 0.0f, 30.0f), 120.0f);
+  AABB box;
+  box.min = Vector3(-200.0f, -100.0f, -50.0f);
+  box.max = Vector3(100.0f, 300.0f, 250.0f);
+  Ray ray(Vector3(-700.0f, 3.0f, 5.0f), Vector3(1.0f, 0.0f, 0.05f));
+
+  std::vector<octree_proxy_t> found, expected;
+  tree.queryFrustum(frustum, found);
+  for (U32 i = 0; i < kCount; ++i) {
+    if (proxies[i] != Octree::kInvalidProxy && frustum.intersect(boxes[i]) != ViewFrustum::Result_Outside) {
+      expected.push_back(proxies[i]);
+    }
+  }
+  TASSERT_E(check(found, expected), true);
+
+  found.clear(); expected.clear();
+  tree.querySphere(sphere, found);
+  for (U32 i = 0; i < kCount; ++i) {
+    if (proxies[i] == Octree::kInvalidProxy) continue;
+    Vector3 p = Vector3::maximum(boxes[i].min, Vector3::minimum(sphere.center, boxes[i].max));
+    Vector3 d = p - sphere.center;
+    if (d.dot(d) <= sphere.radius * sphere.radius) expected.push_back(proxies[i]);
+  }
+  TASSERT_E(check(found, expected), true);
+
+  found.clear(); expected.clear();
+  tree.queryAABB(box, found);
+  for (U32 i = 0; i < kCount; ++i) {
+    if (proxies[i] != Octree::kInvalidProxy && box.overlaps(boxes[i])) expected.push_back(proxies[i]);
+  }
+  TASSERT_E(check(found, expected), true);
+
+  // A ray along x, through the middle of the world, only hits boxes spanning its y.
+  found.clear();
+  tree.queryRay(ray, 2000.0f, found);
+  TASSERT_G(found.size(), 0);
+  for (octree_proxy_t proxy : found) {
+    const AABB& aabb = tree.getAABB(proxy);
+    TASSERT_E((aabb.min.y <= 3.0f && aabb.max.y >= 3.0f), true);
+    TASSERT_E((tree.getUserData(proxy) != nullptr), true);
+  }
+
+  // Nodes are freed along with the last proxy in them.
+  for (U32 i = 0; i < kCount; ++i) {
+    if (proxies[i] != Octree::kInvalidProxy) tree.remove(proxies[i]);
+  }
+  TASSERT_E(tree.getProxyCount(), 0);
+  TASSERT_E(tree.getNodeCount(), 1);
+  return true;
+}
+} // Test
@@ -0,0 +1,219 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestGameObject.hpp"
+#include "../Tester.hpp"
+#include "Game/Scene/ResourceRegistry.hpp"
+
+
+namespace Test {
+
+
+struct TestResource {
+  static U32 destroyed;
+  U32 _value;
+};
+
+struct TestParent {
+  static U32 destroyed;
+};
+
+U32 TestResource::destroyed = 0;
+U32 TestParent::destroyed = 0;
+} // Test
+
+
+namespace Recluse {
+
+
+template<>
+struct ResourceTraits<Test::TestResource> {
+  static const ResourceCategory kCategory = RESOURCE_TEXTURE;
+  static void destroy(Test::TestResource* pResource) { Test::TestResource::destroyed += 1; delete pResource; }
+};
+
+
+template<>
+struct ResourceTraits<Test::TestParent> {
+  static const ResourceCategory kCategory = RESOURCE_MODEL;
+  static void destroy(Test::TestParent* pResource) { Test::TestParent::destroyed += 1; delete pResource; }
+};
+} // Recluse
+
+
+namespace Test {
+
+
+static TestResource* MakeResource(U32 value)
+{
+  TestResource* pResource = new TestResource();
+  pResource->_value = value;
+  return pResource;
+}
+
+
+B8 TestResourceRegistry()
+{
+  Log() << "\n\nResource Registry\n\n";
+  ResourceRegistry registry;
+
+  // Ids are stable hashes of the name.
+  AssetId a = registry.intern("a");
+  AssetId b = registry.intern("b");
+  AssetId c = registry.intern("c");
+  TASSERT_E(a, hashAssetName("a"));
+  TASSERT_NE(a, b);
+  TASSERT_NE(a, kNoAssetId);
+  TASSERT_E((registry.getName(b) == "b"), true);
+
+  TASSERT_E(registry.add(a, MakeResource(1), 100), true);
+  TASSERT_E(registry.add(b, MakeResource(2), 100), true);
+  TASSERT_E(registry.add(c, MakeResource(3), 100), true);
+  TestResource* pDuplicate = MakeResource(4);
+  TASSERT_E(registry.add(a, pDuplicate, 100), false);
+  delete pDuplicate;
+
+  ResourceStats stats = registry.getStats(RESOURCE_TEXTURE);
+  TASSERT_E(stats._bytes, 300);
+  TASSERT_E(stats._resident, 3);
+  TASSERT_E(stats._referenced, 0);
+  TASSERT_E(stats._budget, ResourceRegistry::kUnlimitedBudget);
+
+  // Lookups count as hits and misses, and the wrong type never matches.
+  TASSERT_E(registry.find<TestResource>(a)->_value, 1);
+  TASSERT_E(registry.find<TestResource>(registry.intern("missing")), nullptr);
+  TASSERT_E(registry.find<TestParent>(a), nullptr);
+  stats = registry.getStats(RESOURCE_TEXTURE);
+  TASSERT_E(stats._hits, 1);
+  TASSERT_E(stats._misses, 1);
+
+  // One resource is never registered twice, under another id.
+  TASSERT_E(registry.add(registry.intern("alias"), registry.find<TestResource>(a), 100), false);
+  TASSERT_E(registry.contains(registry.intern("alias")), false);
+
+  // Handles count references, copies and all.
+  {
+    ResourceHandle<TestResource> handle = registry.acquire<TestResource>(b);
+    TASSERT_E(static_cast<B32>(static_cast<bool>(handle)), true);
+    TASSERT_E(handle->_value, 2);
+    TASSERT_E(registry.getRefCount(b), 1);
+    ResourceHandle<TestResource> copy = handle;
+    TASSERT_E(registry.getRefCount(b), 2);
+    ResourceHandle<TestResource> moved = std::move(copy);
+    TASSERT_E(registry.getRefCount(b), 2);
+    TASSERT_E(copy.get(), nullptr);
+    TASSERT_E(registry.getStats(RESOURCE_TEXTURE)._referenced, 1);
+
+    // Holders handed only the resource reference it by its address.
+    ResourceHandle<TestResource> byAddress = registry.acquire<TestResource>(handle.get());
+    TASSERT_E(byAddress.getId(), b);
+    TASSERT_E(registry.getRefCount(b), 3);
+    byAddress.release();
+    TestResource unregistered;
+    TASSERT_E(static_cast<B32>(static_cast<bool>(registry.acquire<TestResource>(&unregistered))), false);
+
+    // Referenced resources are neither destroyed, nor detached, nor evicted.
+    TASSERT_E(registry.destroy(b), false);
+    TASSERT_E(registry.detach<TestResource>(b), nullptr);
+
+    // Over budget, the least recently used go first. a was looked up after c was added, so c
+    // goes before a.
+    registry.setBudget(RESOURCE_TEXTURE, 150);
+    TASSERT_E(registry.contains(c), false);
+    TASSERT_E(registry.contains(a), false);
+    TASSERT_E(registry.contains(b), true);
+    TASSERT_E(TestResource::destroyed, 2);
+    stats = registry.getStats(RESOURCE_TEXTURE);
+    TASSERT_E(stats._evictions, 2);
+    TASSERT_E(stats._bytes, 100);
+  }
+  TASSERT_E(registry.getRefCount(b), 0);
+  TASSERT_E(registry.contains(b), true);
+
+  // Adding makes room first, keeping the newest resource.
+  TASSERT_E(registry.add(a, MakeResource(5), 100), true);
+  TASSERT_E(registry.contains(b), false);
+  TASSERT_E(registry.contains(a), true);
+  TASSERT_E(TestResource::destroyed, 3);
+
+  // Adds that are refused make no room first. Adding a resource again, under a budget it would
+  // go over, neither evicts nor destroys it, and an unknown owner evicts nothing either.
+  TestResource* pRegistered = registry.find<TestResource>(a);
+  TASSERT_E(registry.add(a, pRegistered, 100), false);
+  TASSERT_E(registry.add(registry.intern("alias"), pRegistered, 100), false);
+  TestResource* pUnowned = MakeResource(13);
+  TASSERT_E(registry.add(b, pUnowned, 100, registry.intern("missing")), false);
+  delete pUnowned;
+  TASSERT_E(registry.contains(a), true);
+  TASSERT_E(registry.find<TestResource>(a)->_value, 5);
+  TASSERT_E(TestResource::destroyed, 3);
+  TASSERT_E(registry.getStats(RESOURCE_TEXTURE)._evictions, 3);
+
+  // Touching a resource moves it to the back of the line.
+  registry.setBudget(RESOURCE_TEXTURE, 250);
+  TASSERT_E(registry.add(b, MakeResource(6), 100), true);
+  registry.find<TestResource>(a);
+  TASSERT_E(registry.add(c, MakeResource(7), 100), true);
+  TASSERT_E(registry.contains(b), false);
+  TASSERT_E(registry.contains(a), true);
+  TASSERT_E(registry.contains(c), true);
+
+  // Dependencies stay resident for as long as their owner does, whatever the budget.
+  AssetId parent = registry.intern("parent");
+  TASSERT_E(registry.add(parent, new TestParent()), true);
+  TASSERT_E(registry.addDependency(parent, a), true);
+  TASSERT_E(registry.addDependency(parent, c), true);
+  TASSERT_E(registry.addDependency(parent, registry.intern("missing")), false);
+  registry.setBudget(RESOURCE_TEXTURE, 0);
+  TASSERT_E(registry.contains(a), true);
+  TASSERT_E(registry.contains(c), true);
+  TASSERT_E(registry.getRefCount(a), 1);
+
+  // Resources added for an owner are held from the start, and are never evicted before the
+  // owner gets to hold them.
+  AssetId part = registry.intern("part");
+  TASSERT_E(registry.add(part, MakeResource(11), 100, parent), true);
+  TASSERT_E(registry.getRefCount(part), 1);
+  TASSERT_E(registry.contains(part), true);
+  TestResource* pOrphan = MakeResource(12);
+  TASSERT_E(registry.add(b, pOrphan, 100, registry.intern("missing")), false);
+  TASSERT_E(registry.contains(b), false);
+  delete pOrphan;
+
+  // Once the owner goes, they are released, and go on the next trim.
+  TASSERT_E(registry.destroy(parent), true);
+  TASSERT_E(TestParent::destroyed, 1);
+  TASSERT_E(registry.getRefCount(a), 0);
+  TASSERT_E(registry.contains(a), true);
+  registry.trim(RESOURCE_TEXTURE);
+  TASSERT_E(registry.contains(a), false);
+  TASSERT_E(registry.contains(c), false);
+  TASSERT_E(registry.contains(part), false);
+  TASSERT_E(registry.getStats(RESOURCE_TEXTURE)._bytes, 0);
+
+  // Detached resources belong to the caller.
+  registry.setBudget(RESOURCE_TEXTURE, ResourceRegistry::kUnlimitedBudget);
+  U32 destroyed = TestResource::destroyed;
+  TASSERT_E(registry.add(a, MakeResource(8), 100), true);
+  TestResource* pDetached = registry.detach<TestResource>(a);
+  TASSERT_E(pDetached->_value, 8);
+  TASSERT_E(registry.contains(a), false);
+  TASSERT_E(TestResource::destroyed, destroyed);
+  delete pDetached;
+
+  // Clearing destroys referenced resources too, and leaves their handles stale but harmless.
+  TASSERT_E(registry.add(a, MakeResource(9), 100), true);
+  ResourceHandle<TestResource> stale = registry.acquire<TestResource>(a);
+  registry.clearAll();
+  TASSERT_E(registry.contains(a), false);
+  TASSERT_E(TestResource::destroyed, destroyed + 1);
+  TASSERT_E(registry.add(b, MakeResource(10), 100), true);
+  stale.release();
+  TASSERT_E(registry.getRefCount(b), 0);
+  stats = registry.getStats(RESOURCE_TEXTURE);
+  TASSERT_E(stats._resident, 1);
+  TASSERT_E(stats._referenced, 0);
+  registry.clearAll();
+  TASSERT_E(registry.getStats(RESOURCE_TEXTURE)._resident, 0);
+
+  return true;
+}
+} // Test
@@ -0,0 +1,202 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestGameObject.hpp"
+#include "../Tester.hpp"
+#include "Filesystem/Filesystem.hpp"
+#include "Game/GameObject.hpp"
+#include "Game/Scene/Scene.hpp"
+#include "Game/Scene/WorldPartition.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace Test {
+
+
+static const U32 kCellObjects = 5;
+static const U32 kCellBudget = 2000;
+static const U32 kObjectsPerUpdate = 4;
+static U32 StreamedPropsAlive = 0;
+
+
+class StreamedProp : public GameObject {
+public:
+  StreamedProp() { StreamedPropsAlive++; }
+  ~StreamedProp() { StreamedPropsAlive--; }
+};
+
+
+static std::string CellAssetPath(U32 cell)
+{
+  return "RegressionWorldCell" + std::to_string(cell) + ".bin";
+}
+
+
+// Run frames with the view at x, until streaming settles. Checks the per frame limits on the way.
+// Cells waiting on memory only start loading the update after it is freed, so streaming must be
+// idle for two updates in a row.
+static B8 StreamAt(WorldPartition& partition, Scene& scene, R32 x, U32 maxFrames = 5000)
+{
+  U32 idleFrames = 0;
+  for (U32 frame = 0; frame < maxFrames; ++frame) {
+    partition.update(Vector3(x, 0.0f, 5.0f));
+    const WorldPartitionStats& stats = partition.getStats();
+    TASSERT_LE(stats._objectsCreated + stats._objectsDestroyed, kObjectsPerUpdate);
+    TASSERT_LE(stats._residentBytes, stats._memoryBudget);
+    TASSERT_E(stats._objectCount, StreamedPropsAlive);
+    TASSERT_E(scene.getRoot()->getChildrenCount(), StreamedPropsAlive);
+    if (stats._loadingCells == 0 && stats._finalizingCells == 0 && stats._unloadingCells == 0) {
+      if (++idleFrames == 2) return true;
+    } else {
+      idleFrames = 0;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  Log() << "World partition did not settle.\n";
+  return false;
+}
+
+
+static B8 CellsLoaded(WorldPartition& partition, const std::vector<U32>& expected)
+{
+  for (U32 i = 0; i < partition.getCellCount(); ++i) {
+    B32 loaded = partition.getCellState(i) == WORLD_CELL_LOADED;
+    B32 wanted = std::find(expected.begin(), expected.end(), i) != expected.end();
+    if (loaded != wanted) {
+      Log() << "cell " << i << " loaded " << loaded << ", expected " << wanted << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+
+B8 TestWorldPartition()
+{
+  Log() << "\n\nWorld Partition\n\n";
+
+  // Row of 6 cells, 10 units wide along x. Cell 4 holds more than its budget allows.
+  const U32 kCells = 6;
+  for (U32 i = 0; i < kCells; ++i) {
+    std::vector<TChar> data(i == 4 ? 5000 : 1000, static_cast<TChar>(i));
+    TASSERT_E(gFilesystem().WriteTo(CellAssetPath(i).c_str(), data.data(), static_cast<U32>(data.size())),
+      FilesystemResult_Success);
+  }
+
+  Scene scene;
+  WorldPartition partition(10.0f, 10.0f, 15.0f);
+  partition.setScene(&scene);
+  partition.setObjectsPerUpdate(kObjectsPerUpdate);
+  // Room for three cells at once.
+  partition.setMemoryBudget(3 * kCellBudget);
+
+  U32 badAssets = 0;
+  partition.registerObjectType("Prop",
+    [&] (const WorldObjectDesc& desc, const AsyncFileHandle* pAsset) -> GameObject* {
+      if (!pAsset || !pAsset->Succeeded() || pAsset->Sz != 1000) badAssets++;
+      return new StreamedProp();
+    },
+    [] (GameObject* pObject) -> void { delete pObject; });
+
+  for (U32 i = 0; i < kCells; ++i) {
+    WorldCellDesc desc;
+    desc._x = static_cast<I32>(i);
+    desc._z = 0;
+    desc._memoryBudget = kCellBudget;
+    desc._assets.push_back(CellAssetPath(i));
+    for (U32 o = 0; o < kCellObjects; ++o) {
+      WorldObjectDesc object;
+      object._type = "Prop";
+      object._position = Vector3(static_cast<R32>(i) * 10.0f + static_cast<R32>(o), 0.0f, 5.0f);
+      object._asset = 0;
+      desc._objects.push_back(object);
+    }
+    TASSERT_E(partition.addCell(desc), i);
+  }
+  TASSERT_E(partition.addCell(partition.getCellDesc(0)), WorldPartition::kInvalidCell);
+  TASSERT_E(partition.getCellAt(Vector3(23.0f, 0.0f, 5.0f)), 2);
+
+  // Scripted view path along the row.
+  TASSERT_E(StreamAt(partition, scene, -100.0f), true);
+  TASSERT_E(CellsLoaded(partition, { }), true);
+
+  TASSERT_E(StreamAt(partition, scene, 5.0f), true);
+  TASSERT_E(CellsLoaded(partition, { 0, 1 }), true);
+  TASSERT_E(StreamedPropsAlive, 2 * kCellObjects);
+
+  // Cell 0 is past the load radius, but not the unload radius, so it stays. Cell 3 is wanted,
+  // but held back by the memory budget.
+  TASSERT_E(StreamAt(partition, scene, 23.0f), true);
+  TASSERT_E(CellsLoaded(partition, { 0, 1, 2 }), true);
+  TASSERT_E(partition.getCellState(3), WORLD_CELL_UNLOADED);
+
+  // Cell 0 leaves, making room for cell 3.
+  TASSERT_E(StreamAt(partition, scene, 26.0f), true);
+  TASSERT_E(CellsLoaded(partition, { 1, 2, 3 }), true);
+
+  // Coming back within the unload radius does not bring cell 0 back.
+  TASSERT_E(StreamAt(partition, scene, 23.0f), true);
+  TASSERT_E(CellsLoaded(partition, { 1, 2, 3 }), true);
+
+  // Cell 4 is over its own budget, and fails to load.
+  TASSERT_E(StreamAt(partition, scene, 45.0f), true);
+  TASSERT_E(CellsLoaded(partition, { 2, 3, 5 }), true);
+  TASSERT_E(partition.getCellState(4), WORLD_CELL_FAILED);
+  TASSERT_E(StreamedPropsAlive, 3 * kCellObjects);
+  TASSERT_E(badAssets, 0);
+
+  TASSERT_E(StreamAt(partition, scene, 1000.0f), true);
+  TASSERT_E(CellsLoaded(partition, { }), true);
+  TASSERT_E(partition.getCellState(4), WORLD_CELL_UNLOADED);
+  TASSERT_E(StreamedPropsAlive, 0);
+  TASSERT_E(partition.getStats()._residentBytes, 0);
+
+  // Unloading everything while cells are still streaming in.
+  partition.update(Vector3(5.0f, 0.0f, 5.0f));
+  partition.update(Vector3(5.0f, 0.0f, 5.0f));
+  partition.unloadAll();
+  TASSERT_E(CellsLoaded(partition, { }), true);
+  TASSERT_E(StreamedPropsAlive, 0);
+  TASSERT_E(scene.getRoot()->getChildrenCount(), 0);
+  TASSERT_E(partition.getStats()._residentBytes, 0);
+
+  // Cells without budgets of their own are held to the global one too, with room for two here.
+  // Their sizes are learned one cell at a time, so cell 2 is never read with the other two in.
+  {
+    WorldPartition unbudgeted(10.0f, 10.0f, 15.0f);
+    unbudgeted.setScene(&scene);
+    unbudgeted.setObjectsPerUpdate(kObjectsPerUpdate);
+    unbudgeted.setMemoryBudget(2500);
+    unbudgeted.registerObjectType("Prop",
+      [] (const WorldObjectDesc& desc, const AsyncFileHandle* pAsset) -> GameObject* { return new StreamedProp(); },
+      [] (GameObject* pObject) -> void { delete pObject; });
+    for (U32 i = 0; i < 3; ++i) {
+      WorldCellDesc desc = partition.getCellDesc(i);
+      desc._memoryBudget = 0;
+      TASSERT_E(unbudgeted.addCell(desc), i);
+    }
+
+    TASSERT_E(StreamAt(unbudgeted, scene, 12.0f), true);
+    TASSERT_E(CellsLoaded(unbudgeted, { 0, 1 }), true);
+    TASSERT_E(unbudgeted.getCellState(2), WORLD_CELL_UNLOADED);
+    TASSERT_E(unbudgeted.getStats()._residentBytes, 2000);
+
+    // Cell 0 leaves, and cell 2 streams in at the size it was read at.
+    TASSERT_E(StreamAt(unbudgeted, scene, 27.0f), true);
+    TASSERT_E(CellsLoaded(unbudgeted, { 1, 2 }), true);
+    TASSERT_E(unbudgeted.getStats()._residentBytes, 2000);
+
+    unbudgeted.unloadAll();
+    TASSERT_E(StreamedPropsAlive, 0);
+  }
+
+  for (U32 i = 0; i < kCells; ++i) {
+    remove(CellAssetPath(i).c_str());
+  }
+  return true;
+}
+} // Test
@@ -2,8 +2,11 @@
 #include "Core/Logging/Log.hpp"
 #include "Math/TestMath.hpp"
 #include "Game/TestGameObject.hpp"
+#include "Animation/TestAnimation.hpp"
 #include "Game/Engine.hpp"
 #include "Memory/TestMemory.hpp"
+#include "Thread/TestThreading.hpp"
+#include "Utility/TestUtility.hpp"
 
 #include "Tester.hpp"
 
@@ -17,8 +20,30 @@ U32 Tester::TestsPassed = 0;
 std::vector<Tester::TestFunc> test = {
   Test::BasicVectorMath,
   Test::BasicMatrixMath,
+  Test::BatchMath,
   Test::TestGameObject,
-  Test::TestAllocators
+  Test::TestGameObjectManager,
+  Test::TestOctree,
+  Test::TestOcclusionCuller,
+  Test::TestComponentRegistry,
+  Test::TestWorldPartition,
+  Test::TestModelCooker,
+  Test::TestMeshOptimizer,
+  Test::TestResourceRegistry,
+  Test::TestMeshLod,
+  Test::TestAnimationClip,
+  Test::TestClipCompressor,
+  Test::TestAnimationJobs,
+  Test::TestAnimationBlend,
+  Test::TestAnimationLod,
+  Test::TestAllocators,
+  Test::TestAllocatorStress,
+  Test::TestFrameAllocator,
+  Test::TestJobSystem,
+  Test::TestProfiler,
+  Test::TestCompression,
+  Test::TestBinaryArchive,
+  Test::TestAsyncIO
 };
 
 int main()
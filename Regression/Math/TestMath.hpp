@@ -12,4 +12,5 @@ B8 BasicVectorMath();
 B8 BasicMatrixMath();
 B8 BasicRayMath();
 B8 BasicQuaternionMath();
+B8 BatchMath();
 } // Test
\ No newline at end of file
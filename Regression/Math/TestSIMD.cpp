@@ -0,0 +1,138 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "TestMath.hpp"
+#include "../Tester.hpp"
+#include "Core/Math/Matrix4.hpp"
+#include "Core/Math/Quaternion.hpp"
+#include "Core/Math/Vector3.hpp"
+#include "Core/Math/Common.hpp"
+#include "Core/Math/SIMD.hpp"
+
+#include <vector>
+#include <random>
+#include <cmath>
+
+#define BATCH_COUNT 1027
+#define BATCH_TOLERANCE 0.0001f
+
+
+namespace Test {
+
+
+static R32 MaxError(const Matrix4* a, const Matrix4* b, size_t count)
+{
+  R32 err = 0.0f;
+  for (size_t i = 0; i < count; ++i) {
+    for (U32 r = 0; r < 4; ++r) {
+      for (U32 c = 0; c < 4; ++c) {
+        R32 d = fabsf(a[i].Data[r][c] - b[i].Data[r][c]) / R_Max(1.0f, fabsf(a[i].Data[r][c]));
+        err = R_Max(err, d);
+      }
+    }
+  }
+  return err;
+}
+
+
+static R32 MaxError(const Vector3* a, const Vector3* b, size_t count)
+{
+  R32 err = 0.0f;
+  for (size_t i = 0; i < count; ++i) {
+    err = R_Max(err, fabsf(a[i].x - b[i].x) / R_Max(1.0f, fabsf(a[i].x)));
+    err = R_Max(err, fabsf(a[i].y - b[i].y) / R_Max(1.0f, fabsf(a[i].y)));
+    err = R_Max(err, fabsf(a[i].z - b[i].z) / R_Max(1.0f, fabsf(a[i].z)));
+  }
+  return err;
+}
+
+
+static R32 MaxError(const Quaternion* a, const Quaternion* b, size_t count)
+{
+  R32 err = 0.0f;
+  for (size_t i = 0; i < count; ++i) {
+    // q and -q are the same rotation.
+    R32 dot = a[i].x * b[i].x + a[i].y * b[i].y + a[i].z * b[i].z + a[i].w * b[i].w;
+    Quaternion bi = dot < 0.0f ? -b[i] : b[i];
+    err = R_Max(err, fabsf(a[i].x - bi.x));
+    err = R_Max(err, fabsf(a[i].y - bi.y));
+    err = R_Max(err, fabsf(a[i].z - bi.z));
+    err = R_Max(err, fabsf(a[i].w - bi.w));
+  }
+  return err;
+}
+
+
+// Compares every supported SIMD path of the batch math routines against the scalar path.
+B8 BatchMath()
+{
+  Log() << "\n\nBatch Math\n\n";
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<R32> dist(-1.0f, 1.0f);
+
+  std::vector<Matrix4> lhs(BATCH_COUNT), rhs(BATCH_COUNT);
+  std::vector<Vector3> points(BATCH_COUNT);
+  std::vector<Quaternion> q0(BATCH_COUNT), q1(BATCH_COUNT);
+  std::vector<R32> weights(BATCH_COUNT);
+  for (size_t i = 0; i < BATCH_COUNT; ++i) {
+    Quaternion ra = Quaternion::angleAxis(dist(rng) * 3.0f, Vector3(dist(rng), dist(rng), dist(rng) + 2.0f).normalize());
+    Quaternion rb = Quaternion::angleAxis(dist(rng) * 3.0f, Vector3(dist(rng) + 2.0f, dist(rng), dist(rng)).normalize());
+    lhs[i] = Matrix4::scale(Matrix4::identity(), Vector3(1.5f, 2.0f, 0.5f)) * ra.toMatrix4();
+    lhs[i][3][0] = dist(rng) * 10.0f; lhs[i][3][1] = dist(rng) * 10.0f; lhs[i][3][2] = dist(rng) * 10.0f;
+    rhs[i] = rb.toMatrix4();
+    points[i] = Vector3(dist(rng), dist(rng), dist(rng)) * 100.0f;
+    q0[i] = ra;
+    q1[i] = (i & 1) ? rb : -rb;
+    weights[i] = (i % 11) * 0.1f;
+  }
+  // Nearly identical rotations take the lerp path of the scalar slerp.
+  q1[5] = q0[5];
+
+  SIMDInstructionSet supported = getSupportedSIMDInstructionSet();
+  Log() << "Supported: " << getSIMDInstructionSetName(supported) << "\n";
+
+  setSIMDInstructionSet(SIMD_SCALAR);
+  std::vector<Matrix4> mulRef(BATCH_COUNT), mulConstRef(BATCH_COUNT);
+  std::vector<Vector3> pointRef(BATCH_COUNT);
+  std::vector<Quaternion> slerpRef(BATCH_COUNT), nlerpRef(BATCH_COUNT);
+  Matrix4::multiplyBatch(mulRef.data(), lhs.data(), rhs.data(), BATCH_COUNT);
+  Matrix4::multiplyBatch(mulConstRef.data(), lhs.data(), rhs[0], BATCH_COUNT);
+  Matrix4::transformPoints(pointRef.data(), points.data(), lhs[0], BATCH_COUNT);
+  Quaternion::slerpBatch(slerpRef.data(), q0.data(), q1.data(), 0.3f, BATCH_COUNT);
+  Quaternion::nlerpBatch(nlerpRef.data(), q0.data(), q1.data(), weights.data(), BATCH_COUNT);
+
+  for (I32 set = SIMD_SCALAR; set <= static_cast<I32>(supported); ++set) {
+    setSIMDInstructionSet(static_cast<SIMDInstructionSet>(set));
+    std::vector<Matrix4> mul(BATCH_COUNT), mulConst(BATCH_COUNT);
+    std::vector<Vector3> point(BATCH_COUNT);
+    std::vector<Quaternion> slerp(BATCH_COUNT), nlerp(BATCH_COUNT);
+    Matrix4::multiplyBatch(mul.data(), lhs.data(), rhs.data(), BATCH_COUNT);
+    Matrix4::multiplyBatch(mulConst.data(), lhs.data(), rhs[0], BATCH_COUNT);
+    Matrix4::transformPoints(point.data(), points.data(), lhs[0], BATCH_COUNT);
+    Quaternion::slerpBatch(slerp.data(), q0.data(), q1.data(), 0.3f, BATCH_COUNT);
+    Quaternion::nlerpBatch(nlerp.data(), q0.data(), q1.data(), weights.data(), BATCH_COUNT);
+
+    Log() << getSIMDInstructionSetName(static_cast<SIMDInstructionSet>(set)) << "\n";
+    TASSERT_LE(MaxError(mulRef.data(), mul.data(), BATCH_COUNT), BATCH_TOLERANCE);
+    TASSERT_LE(MaxError(mulConstRef.data(), mulConst.data(), BATCH_COUNT), BATCH_TOLERANCE);
+    TASSERT_LE(MaxError(pointRef.data(), point.data(), BATCH_COUNT), BATCH_TOLERANCE);
+    TASSERT_LE(MaxError(slerpRef.data(), slerp.data(), BATCH_COUNT), BATCH_TOLERANCE);
+    TASSERT_LE(MaxError(nlerpRef.data(), nlerp.data(), BATCH_COUNT), BATCH_TOLERANCE);
+
+    // In place.
+    mul = lhs;
+    Matrix4::multiplyBatch(mul.data(), mul.data(), rhs.data(), BATCH_COUNT);
+    TASSERT_LE(MaxError(mulRef.data(), mul.data(), BATCH_COUNT), BATCH_TOLERANCE);
+    nlerp = q0;
+    Quaternion::nlerpBatch(nlerp.data(), nlerp.data(), q1.data(), weights.data(), BATCH_COUNT);
+    TASSERT_LE(MaxError(nlerpRef.data(), nlerp.data(), BATCH_COUNT), BATCH_TOLERANCE);
+  }
+  setSIMDInstructionSet(supported);
+
+  // Inverse round trip.
+  for (size_t i = 0; i < 64; ++i) {
+    Matrix4 id = lhs[i] * lhs[i].inverse();
+    Matrix4 ident = Matrix4::identity();
+    TASSERT_LE(MaxError(&id, &ident, 1), BATCH_TOLERANCE);
+  }
+  return true;
+}
+} // Test
@@ -4,13 +4,24 @@
 
 #include "Core/Memory/Allocator.hpp"
 #include "Core/Memory/FreeListAllocator.hpp"
+#include "Core/Memory/TLSFAllocator.hpp"
+#include "Core/Memory/FrameAllocator.hpp"
+#include "Core/Memory/StlAllocator.hpp"
+#include "Core/Core.hpp"
+#include "Core/Thread/Threading.hpp"
 
 #include "Game/Component.hpp"
 #include "Game/GameObject.hpp"
 
 #include <new>
+#include <vector>
+#include <cstring>
+#include <atomic>
 
 #define DATA_BLOCK_SZ sizeof(size_t) * 2048
+#define STRESS_HEAP_SZ (64 * 1024 * 1024)
+#define STRESS_SLOT_COUNT 2048
+#define FRAME_HEAP_SZ (1024 * 1024)
 
 namespace Test {
 
@@ -49,7 +60,170 @@ B8 TestAllocators()
   FreeListAlloc.Deallocate(obj);
   FreeListAlloc.Deallocate(d);
   FreeListAlloc.Deallocate(s);
+
+  // Everything returned, should be one block again.
+  TASSERT_E(FreeListAlloc.NumAllocs(), 0);
+  TASSERT_E(FreeListAlloc.UsedMem(), 0);
+  TASSERT_E(FreeListAlloc.FreeBlockCount(), 1);
   free(DataBlock);
   return true;
 }
+
+
+struct StressSlot {
+  U8*     _ptr;
+  size_t  _sz;
+  U8      _pattern;
+};
+
+
+// Random alloc/free stress on an allocator. Every live allocation is filled with a pattern 
+// that is verified on free, to catch overlapping blocks.
+static B8 StressAllocator(Allocator& allocator, const char* name, U32 opCount)
+{
+  U64 seed = 0x9E3779B97F4A7C15ull;
+  auto rng = [&seed] () -> U32 {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return static_cast<U32>(seed);
+  };
+
+  static const size_t kAligns[] = { 4, 8, 16, 32, 64, 128 };
+  std::vector<StressSlot> slots(STRESS_SLOT_COUNT);
+  for (StressSlot& slot : slots) { slot._ptr = nullptr; }
+
+  size_t initialLargest = allocator.LargestFreeBlock();
+  U32 failedAllocs = 0;
+  R32 maxFragmentation = 0.0f;
+
+  for (U32 op = 0; op < opCount; ++op) {
+    StressSlot& slot = slots[rng() % STRESS_SLOT_COUNT];
+    if (slot._ptr) {
+      for (size_t i = 0; i < slot._sz; ++i) {
+        if (slot._ptr[i] != slot._pattern) {
+          Log(rError) << name << ": allocation was overwritten!\n";
+          return false;
+        }
+      }
+      allocator.Deallocate(slot._ptr);
+      slot._ptr = nullptr;
+      continue;
+    }
+
+    // Mostly small allocations, with the occasional large one.
+    size_t sz = (rng() % 16 == 0) ? (rng() % (64 * 1024)) + 1 : (rng() % 512) + 1;
+    size_t align = kAligns[rng() % (sizeof(kAligns) / sizeof(kAligns[0]))];
+    U8* ptr = static_cast<U8*>(allocator.allocate(sz, align));
+    if (!ptr) {
+      ++failedAllocs;
+      continue;
+    }
+    TASSERT_E((reinterpret_cast<uintptr_t>(ptr) & (align - 1)), 0);
+    slot._ptr = ptr;
+    slot._sz = sz;
+    slot._pattern = static_cast<U8>(op);
+    memset(ptr, slot._pattern, sz);
+
+    if ((op & 0xffff) == 0) {
+      R32 fragmentation = allocator.Fragmentation();
+      if (fragmentation > maxFragmentation) maxFragmentation = fragmentation;
+    }
+  }
+
+  for (StressSlot& slot : slots) {
+    if (slot._ptr) {
+      allocator.Deallocate(slot._ptr);
+      slot._ptr = nullptr;
+    }
+  }
+
+  Log() << name << ": ops " << opCount 
+        << ", failed allocs " << failedAllocs
+        << ", peak used " << allocator.PeakUsedMem()
+        << ", max fragmentation " << maxFragmentation << "\n";
+
+  // All freed blocks should have been coalesced back into the initial heap.
+  TASSERT_E(allocator.NumAllocs(), 0);
+  TASSERT_E(allocator.UsedMem(), 0);
+  TASSERT_E(allocator.LargestFreeBlock(), initialLargest);
+  TASSERT_E(allocator.Fragmentation(), 0.0f);
+  return true;
+}
+
+
+B8 TestAllocatorStress()
+{
+  Log() << "\n\nAllocator Stress\n\n";
+  void* heap = malloc(STRESS_HEAP_SZ);
+  B8 passed = true;
+
+  {
+    TLSFAllocator tlsf(STRESS_HEAP_SZ, heap);
+    passed &= StressAllocator(tlsf, "TLSFAllocator", 4000000);
+  }
+
+  {
+    // First fit walks the free list, so keep this one shorter.
+    FreeListAllocator freeList(STRESS_HEAP_SZ, heap);
+    passed &= StressAllocator(freeList, "FreeListAllocator", 1000000);
+  }
+
+  free(heap);
+  return passed;
+}
+
+
+B8 TestFrameAllocator()
+{
+  Log() << "\n\nFrame Allocator\n\n";
+  void* heap = malloc(FRAME_HEAP_SZ * 2);
+  FrameAllocator frameAlloc;
+  frameAlloc.Initialize(FRAME_HEAP_SZ, 2, heap);
+  ThreadPool& pool = gCore().ThrPool();
+  B8 passed = true;
+
+  for (U32 frame = 0; frame < 64; ++frame) {
+    frameAlloc.swap();
+    TASSERT_E(frameAlloc.CurrentFrameUsedMem(), 0);
+
+    // Markers rewind scratch memory.
+    StackAllocator::Marker marker = frameAlloc.GetMarker();
+    void* scratch = frameAlloc.allocate(1024, 16);
+    TASSERT_NE(scratch, nullptr);
+    frameAlloc.FreeToMarker(marker);
+    TASSERT_E(frameAlloc.GetMarker(), marker);
+
+    // Pool threads allocate from their own sub arenas.
+    JobCounter counter;
+    std::atomic<U32> failed(0);
+    pool.ParallelFor(256, 4, [&] (U32 start, U32 end) -> void {
+      for (U32 i = start; i < end; ++i) {
+        U32* values = frameAlloc.allocateArray<U32>(64);
+        if (!values || !frameAlloc.Owns(values) || (reinterpret_cast<uintptr_t>(values) & 3)) {
+          failed.fetch_add(1);
+          continue;
+        }
+        for (U32 j = 0; j < 64; ++j) values[j] = i;
+        for (U32 j = 0; j < 64; ++j) if (values[j] != i) failed.fetch_add(1);
+      }
+    }, &counter);
+    pool.WaitForCounter(&counter);
+    TASSERT_E(failed.load(), 0);
+  }
+
+  frameAlloc.CleanUp();
+  TASSERT_E(frameAlloc.allocate(16, 16), nullptr);
+  free(heap);
+
+  // Frame vectors only free the blocks they took from the heap, whichever the global frame 
+  // allocator handed out.
+  {
+    FrameVector<U64> values(1000, 7);
+    values.resize(FRAME_HEAP_SZ, 9);
+    TASSERT_E(values[999], 7);
+    TASSERT_E(values[FRAME_HEAP_SZ - 1], 9);
+  }
+  return passed;
+}
 } // Test
\ No newline at end of file
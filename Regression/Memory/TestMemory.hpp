@@ -10,4 +10,6 @@ namespace Test {
 
 B8  TestMemory();
 B8  TestAllocators();
+B8  TestAllocatorStress();
+B8  TestFrameAllocator();
 } // Test
\ No newline at end of file
@@ -0,0 +1,108 @@
+// Copyright (c) 2017 Recluse Project. All rights reserved.
+#include "../Tester.hpp"
+#include "TestThreading.hpp"
+
+#include "Core/Core.hpp"
+#include "Core/Thread/Threading.hpp"
+#include "Core/Utility/Profile.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+#define JOB_ELEMENT_COUNT 100000
+
+namespace Test {
+
+
+B8 TestJobSystem()
+{
+  Log() << "\n\nJob System\n\n";
+  ThreadPool& pool = gCore().ThrPool();
+
+  std::atomic<U32> sum(0);
+  U32 seenBeforeDependents = 0;
+  JobCounter partitions;
+  JobCounter dependents;
+
+  pool.ParallelFor(JOB_ELEMENT_COUNT, 256, [&] (U32 start, U32 end) -> void {
+    for (U32 i = start; i < end; ++i) {
+      sum.fetch_add(1);
+    }
+  }, &partitions);
+
+  // Must not run until all partitions have finished, and may fan out more work itself.
+  pool.AddTask([&] () -> void {
+    seenBeforeDependents = sum.load();
+    for (U32 i = 0; i < 16; ++i) {
+      pool.AddTask([&] () -> void { sum.fetch_add(1); }, &dependents);
+    }
+  }, &dependents, &partitions);
+
+  pool.WaitForCounter(&dependents);
+  Log() << "sum: " << sum.load() << "\n";
+  TASSERT_E(seenBeforeDependents, JOB_ELEMENT_COUNT);
+  TASSERT_E(sum.load(), JOB_ELEMENT_COUNT + 16);
+
+  pool.WaitAll();
+  TASSERT_E(pool.AllDone(), true);
+  return true;
+}
+
+
+static void ProfiledWork(U32 depth)
+{
+  R_TIMED_PROFILE(PROFILE_TYPES_DEBUG, "ProfiledWork");
+  if (depth > 0) ProfiledWork(depth - 1);
+}
+
+
+B8 TestProfiler()
+{
+  Log() << "\n\nProfiler\n\n";
+  ThreadPool& pool = gCore().ThrPool();
+
+  // Tags are interned once.
+  U32 tag = Profiler::InternTag("ProfiledWork");
+  TASSERT_E(Profiler::InternTag("ProfiledWork"), tag);
+  TASSERT_E(Profiler::GetTagName(tag), std::string("ProfiledWork"));
+
+  ProfileFrame frames[2];
+  U32 frameCountBefore = Profiler::GetFrameHistory(frames, 2);
+
+  // Record from many threads at once, enough to wrap the ring buffers.
+  JobCounter counter;
+  pool.ParallelFor(Profiler::kMaxEventsPerThread, 64, [&] (U32 start, U32 end) -> void {
+    for (U32 i = start; i < end; ++i) {
+      ProfiledWork(1);
+    }
+    R_PROFILE_COUNTER(PROFILE_TYPES_DEBUG, "ProfiledBatch", end - start);
+  }, &counter);
+  pool.WaitForCounter(&counter);
+  Profiler::EndFrame();
+  Profiler::EndFrame();
+
+  U32 frameCount = Profiler::GetFrameHistory(frames, 2);
+  TASSERT_E(frameCount, 2);
+  TASSERT_LE(frames[0]._end, frames[1]._start);
+  TASSERT_G(frameCount, frameCountBefore);
+
+  ProfileData* data = Profiler::GetProfileData(PROFILE_TYPES_DEBUG, "ProfiledWork");
+  TASSERT_NE(data, nullptr);
+  TASSERT_GE(data->_total, 0.0f);
+  TASSERT_GE(data->_end, data->_start);
+  std::vector<ProfileData> all = Profiler::GetAll(PROFILE_TYPES_DEBUG);
+  TASSERT_E(all.size(), 1);
+
+  // Nothing is recorded while disabled.
+  Profiler::SetEnabled(false);
+  U32 disabledTag = Profiler::InternTag("DisabledWork");
+  { ProfileObject scope(PROFILE_TYPES_DEBUG, disabledTag); }
+  Profiler::SetEnabled(true);
+  TASSERT_E(Profiler::GetProfileData(PROFILE_TYPES_DEBUG, "DisabledWork"), nullptr);
+
+  const char* tracePath = "RegressionTrace.json";
+  TASSERT_E(Profiler::ExportChromeTrace(tracePath, 2), true);
+  std::remove(tracePath);
+  return true;
+}
+} // Test
@@ -0,0 +1,13 @@
+// Copyright (c) 2017 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Logging/Log.hpp"
+
+using namespace Recluse;
+
+namespace Test {
+
+
+B8  TestJobSystem();
+B8  TestProfiler();
+} // Test
@@ -0,0 +1,146 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "../Tester.hpp"
+#include "TestUtility.hpp"
+
+#include "Core/Utility/BinaryArchive.hpp"
+#include "Core/Utility/Compression.hpp"
+#include "Core/Math/Matrix4.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace Test {
+
+
+B8 TestCompression()
+{
+  Log() << "\n\nBlock Compression\n\n";
+  std::mt19937 rng(1234);
+
+  // Repetitive, random, and tiny inputs.
+  std::vector<std::vector<U8> > inputs(4);
+  for (U32 i = 0; i < 100000; ++i) inputs[0].push_back(static_cast<U8>((i / 7) % 13));
+  for (U32 i = 0; i < 4096; ++i) inputs[1].push_back(static_cast<U8>(rng()));
+  inputs[2] = { 1, 2, 3 };
+
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const std::vector<U8>& input = inputs[i];
+    std::vector<U8> compressed(CompressBlockBound(input.size()));
+    size_t compressedSize = CompressBlock(input.data(), input.size(), compressed.data(), compressed.size());
+    TASSERT_G(compressedSize, 0);
+    std::vector<U8> output(input.size());
+    TASSERT_E(DecompressBlock(compressed.data(), compressedSize, output.data(), output.size()), true);
+    TASSERT_E(output == input, true);
+    TASSERT_LE(input.size(), DecompressBlockBound(compressedSize));
+    Log() << input.size() << " bytes -> " << compressedSize << " bytes\n";
+  }
+  TASSERT_L(CompressBlock(inputs[0].data(), inputs[0].size(), nullptr, 0), 1);
+
+  // Corrupt data must be caught, not read, or written, out of bounds.
+  std::vector<U8> garbage(256);
+  for (U8& b : garbage) b = static_cast<U8>(rng());
+  std::vector<U8> output(1024);
+  TASSERT_E(DecompressBlock(garbage.data(), garbage.size(), output.data(), output.size()), false);
+  return true;
+}
+
+
+B8 TestBinaryArchive()
+{
+  Log() << "\n\nBinary Archive\n\n";
+  const char* path = "RegressionArchive.bin";
+  const U32 kMeshChunk = R_CHUNK_ID('M', 'E', 'S', 'H');
+  const U32 kPoseChunk = R_CHUNK_ID('P', 'O', 'S', 'E');
+
+  std::vector<Matrix4> poses(64);
+  for (size_t i = 0; i < poses.size(); ++i) {
+    poses[i] = Matrix4::translate(Matrix4::identity(), Vector3(R32(i), 1.0f, 2.0f));
+  }
+  std::vector<U32> indices(30000);
+  for (size_t i = 0; i < indices.size(); ++i) indices[i] = static_cast<U32>(i % 300);
+
+  {
+    BinaryArchive archive;
+    TASSERT_E(archive.Open(path, ARCHIVE_MODE_WRITE), true);
+    archive.beginChunk(kMeshChunk, 2, true);
+    archive << std::string("Cube") << R32(0.5f) << U8(7);
+    archive.writeSpan(indices);
+    archive.endChunk();
+    archive.beginChunk(kPoseChunk, 1);
+    archive.writeSpan(poses);
+    archive.endChunk();
+    TASSERT_E(archive.close(), true);
+  }
+
+  BinaryArchive archive;
+  TASSERT_E(archive.Open(path), true);
+  TASSERT_E(archive.getChunkCount(), 2);
+  TASSERT_E(archive.hasChunk(R_CHUNK_ID('N', 'O', 'P', 'E')), false);
+
+  // Chunks may be read in any order.
+  U32 version = 0;
+  TASSERT_E(archive.openChunk(kPoseChunk, &version), true);
+  TASSERT_E(version, 1);
+  ArchiveSpan<Matrix4> poseView = archive.readSpan<Matrix4>();
+  TASSERT_E(poseView.size(), poses.size());
+  TASSERT_E(reinterpret_cast<uintptr_t>(poseView._data) % BinaryArchive::kDataAlignment, 0);
+  TASSERT_E(memcmp(poseView._data, poses.data(), sizeof(Matrix4) * poses.size()), 0);
+
+  TASSERT_E(archive.openChunk(kMeshChunk, &version), true);
+  TASSERT_E(version, 2);
+  std::string name;
+  R32 scale = 0.0f;
+  U8 lod = 0;
+  archive >> name >> scale >> lod;
+  TASSERT_E(name, std::string("Cube"));
+  TASSERT_E(scale, 0.5f);
+  TASSERT_E(lod, 7);
+  std::vector<U32> readIndices;
+  TASSERT_E(archive.readSpan(readIndices), true);
+  TASSERT_E(readIndices == indices, true);
+
+  // Reading past the end of a chunk fails, without touching memory past it.
+  U32 pastEnd = 1;
+  archive >> pastEnd;
+  TASSERT_E(pastEnd, 0);
+  TASSERT_E(archive.failed(), true);
+  archive.close();
+
+  // Chunks claiming to decompress to more than their bytes can hold are refused, before 
+  // anything is allocated for them. The table entry of the mesh chunk starts with its id and 
+  // version, and holds its decompressed size 32 bytes in.
+  std::vector<U8> bytes;
+  {
+    FILE* pFile = fopen(path, "rb");
+    TASSERT_NE(pFile, nullptr);
+    fseek(pFile, 0, SEEK_END);
+    bytes.resize(static_cast<size_t>(ftell(pFile)));
+    fseek(pFile, 0, SEEK_SET);
+    TASSERT_E(fread(bytes.data(), 1, bytes.size(), pFile), bytes.size());
+    fclose(pFile);
+  }
+  const U32 entryStart[2] = { kMeshChunk, 2 };
+  size_t entry = bytes.size();
+  for (size_t i = bytes.size() - sizeof(entryStart); i-- > 0; ) {
+    if (memcmp(bytes.data() + i, entryStart, sizeof(entryStart)) == 0) {
+      entry = i;
+      break;
+    }
+  }
+  TASSERT_L(entry, bytes.size());
+  U64 hugeSize = 1ull << 40;
+  memcpy(bytes.data() + entry + 32, &hugeSize, sizeof(hugeSize));
+  {
+    FILE* pFile = fopen(path, "wb");
+    TASSERT_NE(pFile, nullptr);
+    fwrite(bytes.data(), 1, bytes.size(), pFile);
+    fclose(pFile);
+  }
+  TASSERT_E(archive.Open(path), false);
+
+  std::remove(path);
+  return true;
+}
+} // Test
@@ -0,0 +1,65 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "../Tester.hpp"
+#include "TestUtility.hpp"
+
+#include "Core/Core.hpp"
+#include "Filesystem/Filesystem.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace Test {
+
+
+B8 TestAsyncIO()
+{
+  Log() << "\n\nAsync File I/O\n\n";
+  const char* path = "RegressionAsyncIO.bin";
+  const char* missing = "RegressionAsyncIO.missing";
+
+  std::vector<TChar> data(3 * 1024 * 1024);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<TChar>(i * 31 + 7);
+  TASSERT_E(gFilesystem().WriteTo(path, data.data(), static_cast<U32>(data.size())), FilesystemResult_Success);
+
+  // Mix priorities, and missing files, all joined on one counter.
+  const U32 kReads = 24;
+  std::vector<AsyncFileHandle> handles(kReads);
+  std::atomic<U32> callbacks(0);
+  JobCounter counter;
+  for (U32 i = 0; i < kReads; ++i) {
+    gFilesystem().AsyncReadFile((i % 4) == 3 ? missing : path, &handles[i],
+      static_cast<AsyncIOPriority>(i % AsyncIOPriority_Count),
+      [&] (AsyncFileHandle*) { callbacks.fetch_add(1); }, &counter);
+  }
+  gCore().ThrPool().WaitForCounter(&counter);
+  TASSERT_E(callbacks.load(), kReads);
+
+  for (U32 i = 0; i < kReads; ++i) {
+    TASSERT_E(handles[i].Finished(), true);
+    if ((i % 4) == 3) {
+      TASSERT_E(handles[i].Status.load(), AsyncIOStatus_Failed);
+    } else {
+      TASSERT_E(handles[i].Succeeded(), true);
+      TASSERT_E(handles[i].Sz, data.size());
+      TASSERT_E(memcmp(handles[i].Buf, data.data(), data.size()), 0);
+    }
+  }
+
+  // Views of the same file share a mapping.
+  FileView view0, view1;
+  TASSERT_E(gFilesystem().MapFile(path, &view0), FilesystemResult_Success);
+  TASSERT_E(gFilesystem().MapFile(path, &view1), FilesystemResult_Success);
+  TASSERT_E(view0.data() == view1.data(), true);
+  TASSERT_E(view0.size(), data.size());
+  TASSERT_E(memcmp(view0.data(), data.data(), data.size()), 0);
+  FileView view2;
+  TASSERT_E(gFilesystem().MapFile(missing, &view2), FilesystemResult_NotFound);
+  view0.release();
+  view1.release();
+
+  std::remove(path);
+  return true;
+}
+} // Test
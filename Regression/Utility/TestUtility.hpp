@@ -0,0 +1,14 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#pragma once
+
+#include "Core/Logging/Log.hpp"
+
+using namespace Recluse;
+
+namespace Test {
+
+
+B8  TestCompression();
+B8  TestBinaryArchive();
+B8  TestAsyncIO();
+} // Test
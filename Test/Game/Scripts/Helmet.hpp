@@ -281,6 +281,7 @@ public:
 
     m_rendererComponent.addMesh(model->meshes[0]);
     m_rendererComponent.setAnimationHandler(m_animationComponent.getAnimHandle());
+    m_animationComponent.setMeshComponent(&m_meshComponent);
 
     Material* rusted = nullptr;
     MaterialCache::get("RustedSample", &rusted);
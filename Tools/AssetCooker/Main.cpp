@@ -0,0 +1,64 @@
+// Copyright (c) 2018 Recluse Project. All rights reserved.
+#include "Core/Types.hpp"
+#include "Core/Core.hpp"
+#include "Game/Scene/ModelLoader.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Recluse;
+
+// Offline model cooker. Converts a source model into the cooked .rmdl format, which the
+// engine maps straight into memory when loading.
+//
+// usage: AssetCooker [--meshlets] [--no-optimize] [--no-lods] [--keep-anim-keys] <source> [destination]
+int main(int c, char* argv[])
+{
+  ModelLoader::ImportOptionBits options = ModelLoader::kDefaultImportOptions;
+  std::vector<std::string> paths;
+  for (int i = 1; i < c; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--meshlets") {
+      options |= ModelLoader::Import_BuildMeshlets;
+    } else if (arg == "--no-optimize") {
+      options &= ~ModelLoader::Import_OptimizeMeshes;
+    } else if (arg == "--no-lods") {
+      options &= ~ModelLoader::Import_GenerateLods;
+    } else if (arg == "--keep-anim-keys") {
+      options &= ~ModelLoader::Import_ReduceAnimationKeys;
+    } else {
+      paths.push_back(arg);
+    }
+  }
+
+  if (paths.empty()) {
+    std::cout << "usage: AssetCooker [--meshlets] [--no-optimize] [--no-lods] [--keep-anim-keys] <source> [destination]\n";
+    return -1;
+  }
+
+  std::string source = paths[0];
+  std::string destination;
+  if (paths.size() > 1) {
+    destination = paths[1];
+  } else {
+    size_t cutoff = source.find_last_of("/\\");
+    size_t ext = source.find_last_of('.');
+    if (ext == std::string::npos || (cutoff != std::string::npos && ext < cutoff)) {
+      ext = source.size();
+    }
+    destination = source.substr(0, ext) + ".rmdl";
+  }
+
+  // Image decoding, and mesh conversion, run on the core thread pool.
+  gCore().ThrPool().RunAll();
+  ModelLoader::ModelResultBits result = ModelLoader::cook(source, destination, options);
+  gCore().ThrPool().StopAll();
+  if (result & ModelLoader::Model_Fail) {
+    std::cout << "Failed to cook " << source << "\n";
+    return -1;
+  }
+
+  std::cout << "Cooked " << source << " into " << destination << "\n";
+  return 0;
+}